@@ -20,6 +20,17 @@ UIKIT_EXTERN int const kAppBladePermissionError;
 UIKIT_EXTERN NSString* const kAppBladeCacheDirectory;
 
 
+// Encoding used when queuing and uploading crash reports.
+typedef enum {
+    // Decode and format reports as iOS crash log text on launch (the default).
+    AppBladeCrashReportFormatText = 0,
+    // Queue and upload the raw .plcrash protobuf; no decoding or formatting on launch.
+    AppBladeCrashReportFormatPLCrash,
+    // Deprecated alias of AppBladeCrashReportFormatPLCrash, kept for source compatibility. Every queued report is
+    // now uploaded in a gzip compressed batch, whatever its format.
+    AppBladeCrashReportFormatPLCrashCompressed __attribute__((deprecated("use AppBladeCrashReportFormatPLCrash"))) = AppBladeCrashReportFormatPLCrash
+} AppBladeCrashReportFormat;
+
 @class AppBlade;
 
 @protocol AppBladeDelegate <NSObject>
@@ -44,6 +55,10 @@ UIKIT_EXTERN NSString* const kAppBladeCacheDirectory;
 @property (nonatomic, retain) NSString* appBladeDeviceSecret;
 
 
+// How crash reports are queued and uploaded. Set before calling |-catchAndReportCrashes|.
+// Raw .plcrash reports may be converted to text with `plcrashutil convert --format=ios`.
+@property (nonatomic, assign) AppBladeCrashReportFormat crashReportFormat;
+
 // The AppBlade delegate receives messages regarding device authentication and other events.
 // See protocol declaration, above.
 @property (nonatomic, assign) id<AppBladeDelegate> delegate;
@@ -13,13 +13,16 @@
 #import "PLCrashReporter.h"
 #import "PLCrashReport.h"
 #import "AppBladeWebClient.h"
+#import "AppBladeUploadQueue.h"
+#import "AppBladeSessionLog.h"
+#import "AppBladeCustomParamsStore.h"
+#import "AppBladeFileHasher.h"
 #import "PLCrashReportTextFormatter.h"
 #import "FeedbackDialogue.h"
 #import "asl.h"
 #import <QuartzCore/QuartzCore.h>
 
 #import <CommonCrypto/CommonHMAC.h>
-#include "FileMD5Hash.h"
 #import <dlfcn.h>
 #import <mach-o/dyld.h>
 #import <TargetConditionals.h>
@@ -27,8 +30,6 @@
 #include <sys/sysctl.h>
 #import <mach-o/ldsyms.h>
 
-#include "FileMD5Hash.h"
-
 
 
 static NSString* const s_sdkVersion                     = @"0.5.1";
@@ -56,6 +57,12 @@ static NSString* const kAppBladeCustomFieldsFile        = @"AppBladeCustomFields
 static NSString* const kAppBladeDefaultHost             = @"https://appblade.com";
 
 static NSString* const kAppBladeSessionFile             = @"AppBladeSessions.txt";
+static NSString* const kAppBladeSessionJournalFile      = @"AppBladeSessions.journal";
+
+static NSString* const kAppBladeUploadQueueDirectory    = @"AppBladeUploadQueue";
+static NSString* const kAppBladeUploadKeyItems          = @"uploadItems";
+static const NSUInteger kAppBladeUploadBatchMaxItems    = 20;
+static const unsigned long long kAppBladeUploadBatchMaxBytes = 1024 * 1024;
 
 //Keychain Values
 static NSString* const kAppBladeKeychainTtlKey          = @"appBlade_ttl";
@@ -100,6 +107,12 @@ static NSString* const kAppBladeApiTokenResponseTimeToLiveKey       = @"ttl";
 @property (nonatomic, retain) NSOperationQueue* pendingRequests;
 @property (nonatomic, retain) NSOperationQueue* tokenRequests;
 
+@property (nonatomic, retain) AppBladeUploadQueue* uploadQueue;
+@property (nonatomic, retain) AppBladeSessionLog* sessionLog;
+@property (nonatomic, retain) AppBladeCustomParamsStore* customParamsStore;
+@property (nonatomic, retain) AppBladeWebClient* uploadClient; //the batch upload in flight, if any
+@property (nonatomic, assign) BOOL batchUnsupported; //the host has no batch endpoint, send items one at a time until the next launch
+
 - (void)raiseConfigurationExceptionWithMessage:(NSString *)message;
 
 - (void)validateProjectConfiguration;
@@ -116,10 +129,12 @@ static NSString* const kAppBladeApiTokenResponseTimeToLiveKey       = @"ttl";
 
 - (NSString*)randomString:(int)length;
 
-- (BOOL)hasPendingSessions;
 //hasPendingCrashReport in PLCrashReporter
 - (BOOL)hasPendingFeedbackReports;
 - (void)handleBackloggedFeedback;
+- (BOOL)enqueueFeedback:(NSDictionary *)feedback;
+
+- (void)drainUploadQueue;
 - (void)removeIntermediateFeedbackFiles:(NSString *)feedbackPath;
 
 -(NSMutableDictionary*) appBladeDeviceSecrets;
@@ -248,6 +263,9 @@ static BOOL is_encrypted () {
             ABErrorLog(@"AppBlade failed to remove the caches directory after receiving invalid credentials");
         }
     }
+    [[AppBlade sharedManager] setUploadQueue:nil]; //reopened from the fresh folder when next needed
+    [[AppBlade sharedManager] setSessionLog:nil];
+    [[AppBlade sharedManager] setCustomParamsStore:nil];
     [[AppBlade sharedManager] checkAndCreateAppBladeCacheDirectory]; //reinitialize the folder
 }
 
@@ -435,6 +453,56 @@ static BOOL is_encrypted () {
     [[self pendingRequests] setSuspended:NO];
 }
 
+#pragma mark Upload Queue
+
+-(AppBladeUploadQueue *) uploadQueue {
+    @synchronized (self){
+        if(!_uploadQueue){
+            NSString *directory = [[AppBlade cachesDirectoryPath] stringByAppendingPathComponent:kAppBladeUploadQueueDirectory];
+            _uploadQueue = [[AppBladeUploadQueue alloc] initWithDirectory:directory];
+        }
+        return _uploadQueue;
+    }
+}
+
+//Sends the oldest queued items in a single request; each successful batch sends the next, until the queue is empty.
+//Hosts without the batch endpoint are sent the oldest item alone, through its own endpoint.
+- (void)drainUploadQueue
+{
+    if(self.isAllDisabled){
+        ABDebugLog_internal(@"Can't drain upload queue, SDK disabled");
+        return;
+    }
+
+    @synchronized (self){
+        if(self.uploadClient != nil && !self.uploadClient.isCancelled){
+            ABDebugLog_internal(@"Batch upload already in progress");
+            return;
+        }
+
+        NSUInteger maxItems = self.batchUnsupported ? 1 : kAppBladeUploadBatchMaxItems;
+        NSArray *batch = [self.uploadQueue nextBatchWithMaxItems:maxItems maxBytes:kAppBladeUploadBatchMaxBytes];
+        if(batch.count == 0){
+            ABDebugLog_internal(@"Nothing to upload");
+            self.uploadClient = nil;
+            return;
+        }
+
+        ABDebugLog_internal(@"Uploading %d of %d queued items", batch.count, [self.uploadQueue count]);
+        AppBladeWebClient * client = [[AppBladeWebClient alloc] initWithDelegate:self];
+        client.userInfo = [NSDictionary dictionaryWithObjectsAndKeys:batch, kAppBladeUploadKeyItems, nil];
+        if(self.batchUnsupported){
+            [client uploadItem:[batch objectAtIndex:0] withParams:[self getCustomParams]];
+        }
+        else
+        {
+            [client uploadBatch:batch withParams:[self getCustomParams]];
+        }
+        self.uploadClient = client;
+        [self.pendingRequests addOperation:client];
+    }
+}
+
 
 #pragma mark API Token Calls
 
@@ -537,6 +605,9 @@ static BOOL is_encrypted () {
     
     [self checkForExistingCrashReports];
     
+    // Load the custom params now, so that reading them later, even after a crash, does no I/O
+    [self customParamsStore];
+    
     // Enable the Crash Reporter
     if (![crashReporter enableCrashReporterAndReturnError: &error])
         ABErrorLog(@"Warning: Could not enable crash reporter: %@", error);
@@ -554,6 +625,10 @@ static BOOL is_encrypted () {
     if ([crashReporter hasPendingCrashReport]){
         [self handleCrashReport];
     }
+    else
+    {
+        [self drainUploadQueue];
+    }
 }
 
 - (void)handleCrashReport
@@ -566,63 +641,48 @@ static BOOL is_encrypted () {
     PLCrashReporter *crashReporter = [PLCrashReporter sharedReporter];
     NSData *crashData;
     NSError *error;
-    NSString* reportString = nil;
-    NSString *queuedFilePath = nil;
-    // Try loading the crash report from the live file
-    crashData = [crashReporter loadPendingCrashReportDataAndReturnError: &error];
-    if (crashData != nil) {
-        PLCrashReport *report = [[PLCrashReport alloc] initWithData: crashData error: &error];
-        if (report != nil) {
-            reportString = [PLCrashReportTextFormatter stringValueForCrashReport:report withTextFormat: PLCrashReportTextFormatiOS];
-            //send pending crash report to a unique file name in the the queue
-            queuedFilePath = [crashReporter saveCrashReportInQueue:reportString]; //file will stay in the queue until it's sent
-            if(queuedFilePath == nil){
-                ABErrorLog(@"error saving crash report");
+    //hand each report in the crash reporter's store to the upload queue, oldest first
+    while ((crashData = [crashReporter loadPendingCrashReportDataAndReturnError: &error]) != nil) {
+        @autoreleasepool {
+            BOOL queued = NO;
+            if (self.crashReportFormat != AppBladeCrashReportFormatText) {
+                // Queue the raw report as-is; it is decoded and formatted server side
+                queued = [self.uploadQueue enqueueData:crashData type:AppBladeUploadItemCrashReport extension:@"plcrash"];
             }
             else
             {
-                ABDebugLog_internal(@"moved crash report to %@", queuedFilePath);
+                PLCrashReport *report = [[PLCrashReport alloc] initWithData: crashData error: &error];
+                if (report != nil) {
+                    NSString* reportString = [PLCrashReportTextFormatter stringValueForCrashReport:report withTextFormat: PLCrashReportTextFormatiOS];
+                    queued = [self.uploadQueue enqueueData:[reportString dataUsingEncoding:NSUTF8StringEncoding] type:AppBladeUploadItemCrashReport extension:@"txt"];
+                }
+                else
+                {
+                    ABErrorLog(@"Could not parse crash report: %@", error);
+                    queued = YES; //it never will be parsed, drop it
+                }
             }
+            if(!queued){
+                ABErrorLog(@"error adding crash report to the upload queue, leaving it for the next launch");
+                break;
+            }
+            [crashReporter purgePendingCrashReport]; //release the report's slot, we have it in the upload queue now
         }
-        else
-        {
-            ABErrorLog(@"Could not parse crash report");
-        }
-    }
-    else
-    {
-        ABErrorLog(@"Could not load a crash report from live file");
     }
-    [crashReporter purgePendingCrashReport]; //remove crash report from immediate file, we have it in the queue now
 
-    if(queuedFilePath == nil){
-        //we had no immediate crash, or an invalid save, grab any stored crash report
-        queuedFilePath = [crashReporter getNextCrashReportPath];
-        reportString = [NSString stringWithContentsOfFile:queuedFilePath encoding:NSUTF8StringEncoding error:&error];
-    }
-    
-    if(queuedFilePath != nil){
-        AppBladeWebClient * client = [[AppBladeWebClient alloc] initWithDelegate:self];
-        client.userInfo = [NSDictionary dictionaryWithObjectsAndKeys:queuedFilePath,  kAppBladeCrashReportKeyFilePath, nil];
-        [client reportCrash:reportString withParams:[self getCustomParams]];
-        [self.pendingRequests addOperation:client];
-    }
-    else
-    {
-        ABDebugLog_internal(@"No crashes to report");
+    //hand any reports staged by earlier versions to the upload queue
+    for (NSString *stagedFilePath in [crashReporter queuedCrashReportPaths]) {
+        if(![self.uploadQueue enqueueFileAtPath:stagedFilePath type:AppBladeUploadItemCrashReport]){
+            ABErrorLog(@"error moving crash report %@ to the upload queue", stagedFilePath);
+        }
     }
+
+    [self drainUploadQueue];
 }
 
 - (NSString*)hashFileOfPlist:(NSString *)filePath
 {
-    NSString* returnString = nil;
-    CFStringRef executableFileMD5Hash =
-    FileMD5HashCreateWithPath((__bridge CFStringRef)(filePath), FileHashDefaultChunkSizeForReadingData);
-    if (executableFileMD5Hash) {
-        returnString = (__bridge NSString *)(executableFileMD5Hash);
-         CFRelease(executableFileMD5Hash);
-    }
-    return returnString;
+    return [[AppBladeFileHasher sharedHasher] md5OfFileAtPath:filePath];
 }
 
 
@@ -781,6 +841,15 @@ static BOOL is_encrypted () {
         {
             ABErrorLog(@"ERROR sending crash %@, keeping crashes until they are sent", client.userInfo);
         }
+        else if(client.api == AppBladeWebClientAPI_Batch)
+        {
+            ABErrorLog(@"ERROR uploading batch %@, keeping items until they are sent", [client.userInfo objectForKey:kAppBladeUploadKeyItems]);
+            @synchronized (self){
+                if(self.uploadClient == client){
+                    self.uploadClient = nil;
+                }
+            }
+        }
         else if(client.api == AppBladeWebClientAPI_UpdateCheck)
         {
             ABErrorLog(@"ERROR getting updates from AppBlade %@", client.userInfo);
@@ -826,6 +895,7 @@ static BOOL is_encrypted () {
     if(deviceSecretTimeout != nil) {
         ABDebugLog_internal(@"Token confirmed. Business as usual.");
         [self resumeCurrentPendingRequests]; //continue requests that we could have had pending. they will be ignored if they fail with the old token.
+        [self drainUploadQueue]; //uploads kept after an auth failure go out with the confirmed token
     }
     else {
         ABDebugLog_internal(@"ERROR parsing token confirm response, keeping last valid token %@", self.appBladeDeviceSecret);
@@ -903,7 +973,6 @@ static BOOL is_encrypted () {
     BOOL success = (status == 201 || status == 200);
     if(success){ //we don't need to hold onto this crash.
         ABDebugLog_internal(@"Appblade: success sending crash report, response status code: %d", status);
-        [[PLCrashReporter sharedReporter] purgePendingCrashReport];
         NSString *pathOfCrashReport = [client.userInfo valueForKey:kAppBladeCrashReportKeyFilePath];
         [[NSFileManager defaultManager] removeItemAtPath:pathOfCrashReport error:nil];
         ABDebugLog_internal(@"Appblade: removed crash report, %@", pathOfCrashReport);
@@ -1014,6 +1083,52 @@ static BOOL is_encrypted () {
     }
 }
 
+- (void)appBladeWebClient:(AppBladeWebClient *)client uploadedBatch:(NSDictionary *)itemStatuses
+{
+    NSUInteger removedItems = 0;
+    @synchronized (self){
+        for (AppBladeUploadItem *item in [client.userInfo objectForKey:kAppBladeUploadKeyItems]) {
+            NSNumber *itemStatus = [itemStatuses objectForKey:[NSNumber numberWithUnsignedLongLong:item.identifier]];
+            int status = [itemStatus intValue];
+            if(status >= 200 && status < 300){
+                [self.uploadQueue acknowledgeItem:item];
+                removedItems++;
+            }
+            else if(status >= 400 && status < 500 && status != 408 && status != 429 &&
+                    status != kTokenRefreshStatusCode && status != kTokenInvalidStatusCode && status != 407){
+                //the server will never accept this item, don't let it block the queue. Auth failures are never the item's fault.
+                ABErrorLog(@"Appblade: upload of %@ rejected with status code %d, dropping it", item, status);
+                [self.uploadQueue acknowledgeItem:item];
+                removedItems++;
+            }
+            else
+            {
+                ABDebugLog_internal(@"Appblade: upload of %@ not accepted (status code %d), keeping it", item, status);
+            }
+        }
+        if(self.uploadClient == client){
+            self.uploadClient = nil;
+        }
+    }
+
+    ABDebugLog_internal(@"Appblade: batch upload removed %d items, %d remain queued", removedItems, [self.uploadQueue count]);
+    if(removedItems > 0){
+        [self drainUploadQueue];
+    }
+}
+
+- (void)appBladeWebClientBatchUnsupported:(AppBladeWebClient *)client
+{
+    ABDebugLog_internal(@"Appblade: no batch endpoint, uploading queued items one at a time");
+    @synchronized (self){
+        self.batchUnsupported = YES;
+        if(self.uploadClient == client){
+            self.uploadClient = nil;
+        }
+    }
+    [self drainUploadQueue];
+}
+
 
 #pragma mark - AppBladeDelegate
 - (void)appBlade:(AppBlade *)appBlade applicationApproved:(BOOL)approved error:(NSError *)error
@@ -1299,7 +1414,7 @@ static BOOL is_encrypted () {
 
     [self.feedbackDictionary setObject:feedback forKey:kAppBladeFeedbackKeyNotes];
     
-    ABDebugLog_internal(@"caching and attempting send of feedback %@", self.feedbackDictionary);
+    ABDebugLog_internal(@"caching and queueing feedback %@", self.feedbackDictionary);
     
     //store the feedback in the cache director in the event of a termination
     NSTimeInterval now = [[NSDate date] timeIntervalSince1970];
@@ -1318,11 +1433,10 @@ static BOOL is_encrypted () {
     if(!success){
         ABErrorLog(@"Error writing backup file to %@", backupFilePath);
     }
+    self.feedbackDictionary = nil;
     
-    AppBladeWebClient * client = [[AppBladeWebClient alloc] initWithDelegate:self];
-    ABDebugLog_internal(@"Sending screenshot");
-    [client sendFeedbackWithScreenshot:[self.feedbackDictionary objectForKey:kAppBladeFeedbackKeyScreenshot] note:feedback console:nil params:[self getCustomParams]];
-    [self.pendingRequests addOperation:client];
+    //move it from the backlog to the upload queue
+    [self handleBackloggedFeedback];
 }
 
 
@@ -1337,44 +1451,63 @@ static BOOL is_encrypted () {
         ABDebugLog_internal(@"handleBackloggedFeedback");
         NSString* backupFilePath = [[AppBlade cachesDirectoryPath] stringByAppendingPathComponent:kAppBladeBacklogFileName];
         NSMutableArray* backupFiles = [NSMutableArray arrayWithContentsOfFile:backupFilePath];
-        if (backupFiles.count > 0) {
-            NSString* fileName = [backupFiles objectAtIndex:0]; //get earliest unsent feedback
+        NSMutableArray* remainingFiles = [NSMutableArray array];
+        for (NSString* fileName in backupFiles) {
             NSString* feedbackPath = [[AppBlade cachesDirectoryPath] stringByAppendingPathComponent:fileName];
             
             NSDictionary* feedback = [NSDictionary dictionaryWithContentsOfFile:feedbackPath];
-            if (feedback) {
-                ABDebugLog_internal(@"Feedback found at %@", feedbackPath);
-                ABDebugLog_internal(@"backlog Feedback dictionary %@", feedback);
-                NSString *screenshotFileName = [feedback objectForKey:kAppBladeFeedbackKeyScreenshot];
-                //validate that additional files exist
-                NSString *screenshotFilePath = [[AppBlade cachesDirectoryPath] stringByAppendingPathComponent:screenshotFileName];
-                bool screenShotFileExists = [[NSFileManager defaultManager] fileExistsAtPath:screenshotFilePath];
-                if(screenShotFileExists){
-                    AppBladeWebClient * client = [[AppBladeWebClient alloc] initWithDelegate:self];
-                    client.userInfo = [NSDictionary dictionaryWithObjectsAndKeys:feedback, kAppBladeFeedbackKeyFeedback, fileName, kAppBladeFeedbackKeyBackup, nil];
-                    [client sendFeedbackWithScreenshot:screenshotFileName note:[feedback objectForKey:kAppBladeFeedbackKeyNotes] console:nil params:[self getCustomParams]];
-                    [self.pendingRequests addOperation:client];
-                }
-                else
-                {
-                    //clean up files if one doesn't exist
-                    [self removeIntermediateFeedbackFiles:feedbackPath];
-                    ABDebugLog_internal(@"invalid feedback at %@, removing File and intermediate files", feedbackPath);
-                    [backupFiles removeObject:fileName];
-                    ABDebugLog_internal(@"writing valid pending feedback objects back to file");
-                    [backupFiles writeToFile:backupFilePath atomically:YES];
-
-                }
+            if (feedback == nil) {
+                ABDebugLog_internal(@"No Feedback found at %@, invalid feedback, removing File", feedbackPath);
+                [[NSFileManager defaultManager] removeItemAtPath:feedbackPath error:nil];
+            }
+            else if ([self enqueueFeedback:feedback]) {
+                ABDebugLog_internal(@"Feedback at %@ queued for upload, removing File and intermediate files", feedbackPath);
+                [self removeIntermediateFeedbackFiles:feedbackPath];
             }
             else
             {
-                ABDebugLog_internal(@"No Feedback found at %@, invalid feedback, removing File", feedbackPath);
-                [backupFiles removeObject:fileName];
-                ABDebugLog_internal(@"writing valid pending feedback objects back to file");
-                [backupFiles writeToFile:backupFilePath atomically:YES];
+                ABErrorLog(@"Error queueing feedback at %@, keeping it in the backlog", feedbackPath);
+                [remainingFiles addObject:fileName];
             }
         }
+        
+        if (remainingFiles.count > 0) {
+            ABDebugLog_internal(@"writing pending feedback objects back to file");
+            [remainingFiles writeToFile:backupFilePath atomically:YES];
+        }
+        else
+        {
+            [[NSFileManager defaultManager] removeItemAtPath:backupFilePath error:nil];
+        }
+    }
+    
+    [self drainUploadQueue];
+}
+
+//Queues the feedback notes and screenshot as a single plist for upload.
+- (BOOL)enqueueFeedback:(NSDictionary *)feedback
+{
+    NSMutableDictionary* item = [NSMutableDictionary dictionaryWithCapacity:2];
+    NSString* notes = [feedback objectForKey:kAppBladeFeedbackKeyNotes];
+    if (notes) {
+        [item setObject:notes forKey:kAppBladeFeedbackKeyNotes];
+    }
+    NSString* screenshotFileName = [feedback objectForKey:kAppBladeFeedbackKeyScreenshot];
+    if (screenshotFileName) {
+        NSString* screenshotPath = [[AppBlade cachesDirectoryPath] stringByAppendingPathComponent:screenshotFileName];
+        NSData* screenshotData = [NSData dataWithContentsOfFile:screenshotPath];
+        if (screenshotData) {
+            [item setObject:screenshotData forKey:kAppBladeFeedbackKeyScreenshot];
+        }
+    }
+    
+    NSError* error = nil;
+    NSData* itemData = [NSPropertyListSerialization dataWithPropertyList:item format:NSPropertyListXMLFormat_v1_0 options:0 error:&error];
+    if (itemData == nil) {
+        ABErrorLog(@"Error serializing feedback %@", error);
+        return NO;
     }
+    return [self.uploadQueue enqueueData:itemData type:AppBladeUploadItemFeedback extension:@"feedback"];
 }
 
 -(NSString *)captureScreen
@@ -1479,18 +1612,6 @@ static BOOL is_encrypted () {
 
 
 #pragma mark - Analytics
-- (BOOL)hasPendingSessions
-{
-    if(self.isAllDisabled){
-        ABDebugLog_internal(@"Can't check hasPendingSessions, SDK disabled");
-        return NO;
-    }
-    //check active clients for API_Sessions
-    NSInteger sessionClients = [self pendingRequestsOfType:AppBladeWebClientAPI_Sessions];
-    return sessionClients > 0;
-}
-
-
 + (void)startSession
 {
     
@@ -1516,17 +1637,45 @@ static BOOL is_encrypted () {
     NSString* sessionFilePath = [[AppBlade cachesDirectoryPath] stringByAppendingPathComponent:kAppBladeSessionFile];
     ABDebugLog_internal(@"Checking Session Path: %@", sessionFilePath);
 
+    //sessions archived by earlier versions of the SDK
     if ([[NSFileManager defaultManager] fileExistsAtPath:sessionFilePath]) {
         NSArray* sessions = (NSArray*)[self readFile:sessionFilePath];
         
-        ABDebugLog_internal(@"%d Sessions Exist, posting them", [sessions count]);
+        ABDebugLog_internal(@"%d archived Sessions Exist, queueing them", [sessions count]);
+        
+        //once queued, the sessions can't be lost or sent twice, so start a new log for the sessions that follow
+        NSError* error = nil;
+        NSData* sessionData = sessions ? [NSPropertyListSerialization dataWithPropertyList:sessions format:NSPropertyListXMLFormat_v1_0 options:0 error:&error] : nil;
+        if (sessionData && [self.uploadQueue enqueueData:sessionData type:AppBladeUploadItemSessions extension:@"sessions"]) {
+            [[NSFileManager defaultManager] removeItemAtPath:sessionFilePath error:nil];
+        }
+        else
+        {
+            ABErrorLog(@"Error queueing sessions %@", error);
+        }
+    }
+    
+    if ([self.sessionLog count] > 0) {
+        ABDebugLog_internal(@"%d Sessions Exist, queueing them", [self.sessionLog count]);
+        
+        NSMutableArray* sessions = [NSMutableArray arrayWithCapacity:[self.sessionLog count]];
+        unsigned long long marker = 0;
+        BOOL read = [self.sessionLog enumerateSessionsUsingBlock:^(NSDictionary *session, BOOL *stop) {
+            [sessions addObject:session];
+        } marker:&marker];
         
-        if(![self hasPendingSessions]){
-            AppBladeWebClient * client = [[AppBladeWebClient alloc] initWithDelegate:self];
-            [client postSessions:sessions];
-            [self.pendingRequests addOperation:client];
+        //once queued, the sessions can't be lost or sent twice, so drop them from the log
+        NSError* error = nil;
+        NSData* sessionData = read ? [NSPropertyListSerialization dataWithPropertyList:sessions format:NSPropertyListXMLFormat_v1_0 options:0 error:&error] : nil;
+        if (sessionData && [self.uploadQueue enqueueData:sessionData type:AppBladeUploadItemSessions extension:@"sessions"]) {
+            [self.sessionLog discardSessionsThroughMarker:marker];
+        }
+        else
+        {
+            ABErrorLog(@"Error queueing sessions %@", error);
         }
     }
+    [self drainUploadQueue];
     
     self.sessionStartDate = [NSDate date];
     ABDebugLog_internal(@"Session begun at %@", self.sessionStartDate);
@@ -1544,28 +1693,38 @@ static BOOL is_encrypted () {
         return;
     }
     
-    ABDebugLog_internal(@"Session ended at %@", [NSDate date]);
+    NSDate* sessionEndDate = [NSDate date];
+    ABDebugLog_internal(@"Session ended at %@", sessionEndDate);
     
-    NSDictionary* sessionDict = [NSDictionary dictionaryWithObjectsAndKeys:self.sessionStartDate, @"started_at", [NSDate date], @"ended_at", [self getCustomParams], @"custom_params", nil];
-    ABDebugLog_internal(@"Full Session Data %@", sessionDict);
+    //appended to the journal; the sessions already logged are not read back
+    [self.sessionLog logSessionStartedAt:self.sessionStartDate endedAt:sessionEndDate customParams:[self getCustomParams]];
+}
 
-    NSMutableArray* pastSessions = nil;
-    NSString* sessionFilePath = [[AppBlade cachesDirectoryPath] stringByAppendingPathComponent:kAppBladeSessionFile];
-    if ([[NSFileManager defaultManager] fileExistsAtPath:sessionFilePath]) {
-        NSArray* sessions = (NSArray*)[self readFile:sessionFilePath];
-        pastSessions = [sessions mutableCopy] ;
-    }
-    else {
-        pastSessions = [NSMutableArray arrayWithCapacity:1];
+#pragma mark Session Log
+
+-(AppBladeSessionLog *) sessionLog {
+    @synchronized (self){
+        if(!_sessionLog){
+            NSString *path = [[AppBlade cachesDirectoryPath] stringByAppendingPathComponent:kAppBladeSessionJournalFile];
+            _sessionLog = [[AppBladeSessionLog alloc] initWithPath:path];
+        }
+        return _sessionLog;
     }
-    
-    [pastSessions addObject:sessionDict];
-    
-    NSData* sessionData = [NSKeyedArchiver archivedDataWithRootObject:pastSessions];
-    [sessionData writeToFile:sessionFilePath atomically:YES];
 }
 
 #pragma mark - AppBlade Custom Params
+
+-(AppBladeCustomParamsStore *) customParamsStore {
+    @synchronized (self){
+        if(!_customParamsStore){
+            NSString* customFieldsPath = [[AppBlade cachesDirectoryPath] stringByAppendingPathComponent:kAppBladeCustomFieldsFile];
+            _customParamsStore = [[AppBladeCustomParamsStore alloc] initWithPath:customFieldsPath];
+        }
+        return _customParamsStore;
+    }
+}
+
+//Returns the in-memory snapshot; safe to call from the crash path, as it does no I/O once the store is loaded.
 -(NSDictionary *)getCustomParams
 {
     if([[AppBlade sharedManager] isAllDisabled]){
@@ -1573,18 +1732,7 @@ static BOOL is_encrypted () {
         return [NSDictionary dictionary];;
     }
 
-    NSDictionary *toRet = nil;
-    NSString* customFieldsPath = [[AppBlade cachesDirectoryPath] stringByAppendingPathComponent:kAppBladeCustomFieldsFile];
-    if ([[NSFileManager defaultManager] fileExistsAtPath:customFieldsPath]) {
-        NSDictionary* currentFields = [NSDictionary dictionaryWithContentsOfFile:customFieldsPath];
-        toRet = currentFields;
-    }
-    else
-    {
-        ABDebugLog_internal(@"no file found, reinitializing");
-        toRet = [NSDictionary dictionary];
-        [self setCustomParams:toRet];
-    }
+    NSDictionary *toRet = [self.customParamsStore params];
     ABDebugLog_internal(@"getting Custom Params %@", toRet);
 
     return toRet;
@@ -1597,71 +1745,47 @@ static BOOL is_encrypted () {
         return;
     }
 
-    [self checkAndCreateAppBladeCacheDirectory];
-    NSString* customFieldsPath = [[AppBlade cachesDirectoryPath] stringByAppendingPathComponent:kAppBladeCustomFieldsFile];
-    if ([[NSFileManager defaultManager] fileExistsAtPath:customFieldsPath]) {
-        ABDebugLog_internal(@"WARNING: Overwriting all existing user params");
-    }
-    if(newFieldValues){
-        NSError *error = nil;
-        NSData *paramsData = [NSPropertyListSerialization dataWithPropertyList:newFieldValues format:NSPropertyListXMLFormat_v1_0 options:0 error:&error];
-        if(!error){
-            [paramsData writeToFile:customFieldsPath atomically:YES];
-        }
-        else
-        {
-            ABErrorLog(@"Error parsing custom params %@", newFieldValues);
-        }
-    }
-    else
-    {
-        ABDebugLog_internal(@"clearing custom params, removing file");
-        [[NSFileManager defaultManager] removeItemAtPath:customFieldsPath error:nil];
+    if(newFieldValues && ![NSPropertyListSerialization propertyList:newFieldValues isValidForFormat:NSPropertyListXMLFormat_v1_0]){
+        ABErrorLog(@"Error parsing custom params %@", newFieldValues);
+        return;
     }
+    ABDebugLog_internal(@"WARNING: Overwriting all existing user params");
+    [self.customParamsStore setParams:newFieldValues]; //written to disk in the background
 }
 
 -(void)setCustomParam:(id)newObject withValue:(NSString*)key{
-    NSDictionary* currentFields = [self getCustomParams];
-    if (currentFields == nil) {
-        currentFields = [NSDictionary dictionary];
-    }
-    NSMutableDictionary* mutableFields = [currentFields  mutableCopy];
-    if(key && newObject){
-        [mutableFields setObject:newObject forKey:key];
-    }
-    else if(key && !newObject){
-        [mutableFields removeObjectForKey:key];
-    }
-    else
-    {
-        ABErrorLog(@"AppBlade: invalid nil key when setting custom parameters");
-    }
-    ABDebugLog_internal(@"setting to %@", mutableFields);
-    currentFields = (NSDictionary *)mutableFields;
-    [self setCustomParams:currentFields];
+    [self setCustomParam:newObject forKey:key];
 }
 
 
 -(void)setCustomParam:(id)object forKey:(NSString*)key;
 {
-    NSDictionary* currentFields = [self getCustomParams];
-    if (currentFields == nil) {
-        currentFields = [NSDictionary dictionary];
-    }
-    NSMutableDictionary* mutableFields = [currentFields  mutableCopy] ;
-    if(key && object){
-        [mutableFields setObject:object forKey:key];
-    }
-    else if(key && !object){
-        [mutableFields removeObjectForKey:key];
+    if([[AppBlade sharedManager] isAllDisabled]){
+        ABDebugLog_internal(@"Can't setCustomParams, SDK disabled");
+        return;
     }
-    else
-    {
+    if(key == nil){
         ABErrorLog(@"invalid nil key");
+        return;
+    }
+    if(object && ![NSPropertyListSerialization propertyList:object isValidForFormat:NSPropertyListXMLFormat_v1_0]){
+        ABErrorLog(@"Error parsing custom param %@ for %@", object, key);
+        return;
     }
-    ABDebugLog_internal(@"setting to %@", mutableFields);
-    currentFields = (NSDictionary *)mutableFields;
-    [self setCustomParams:currentFields];
+
+    //read, modify and replace as one step, so concurrent changes are not lost
+    [self.customParamsStore updateParamsUsingBlock:^NSDictionary *(NSDictionary *params) {
+        NSMutableDictionary* mutableFields = [params mutableCopy];
+        if(object){
+            [mutableFields setObject:object forKey:key];
+        }
+        else
+        {
+            [mutableFields removeObjectForKey:key];
+        }
+        ABDebugLog_internal(@"setting to %@", mutableFields);
+        return mutableFields;
+    }];
 }
 
 -(void)clearAllCustomParams
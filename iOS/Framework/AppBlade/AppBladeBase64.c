@@ -0,0 +1,220 @@
+//
+//  AppBladeBase64.c
+//  AppBlade
+//
+//  Copyright (c) 2013 AppBlade. All rights reserved.
+//
+
+#include "AppBladeBase64.h"
+
+#include <string.h>
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define BASE64_NEON 1
+#elif defined(__SSSE3__)
+#include <tmmintrin.h>
+#define BASE64_SSSE3 1
+#endif
+
+static const char encode_table[64] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// Marks characters outside the alphabet in decode_table
+#define BASE64_INVALID 0xff
+
+static const uint8_t decode_table[256] = {
+    ['A'] =  0, ['B'] =  1, ['C'] =  2, ['D'] =  3, ['E'] =  4, ['F'] =  5, ['G'] =  6, ['H'] =  7,
+    ['I'] =  8, ['J'] =  9, ['K'] = 10, ['L'] = 11, ['M'] = 12, ['N'] = 13, ['O'] = 14, ['P'] = 15,
+    ['Q'] = 16, ['R'] = 17, ['S'] = 18, ['T'] = 19, ['U'] = 20, ['V'] = 21, ['W'] = 22, ['X'] = 23,
+    ['Y'] = 24, ['Z'] = 25, ['a'] = 26, ['b'] = 27, ['c'] = 28, ['d'] = 29, ['e'] = 30, ['f'] = 31,
+    ['g'] = 32, ['h'] = 33, ['i'] = 34, ['j'] = 35, ['k'] = 36, ['l'] = 37, ['m'] = 38, ['n'] = 39,
+    ['o'] = 40, ['p'] = 41, ['q'] = 42, ['r'] = 43, ['s'] = 44, ['t'] = 45, ['u'] = 46, ['v'] = 47,
+    ['w'] = 48, ['x'] = 49, ['y'] = 50, ['z'] = 51, ['0'] = 52, ['1'] = 53, ['2'] = 54, ['3'] = 55,
+    ['4'] = 56, ['5'] = 57, ['6'] = 58, ['7'] = 59, ['8'] = 60, ['9'] = 61, ['+'] = 62, ['/'] = 63,
+};
+
+// decode_table marks invalid characters with 0, which is also 'A'; this tells them apart.
+static inline uint8_t decode_char(char c) {
+    uint8_t value = decode_table[(uint8_t) c];
+    return (value == 0 && c != 'A') ? BASE64_INVALID : value;
+}
+
+#if BASE64_NEON
+
+// Encode 48 bytes into 64 characters. The loads deinterleave the input into its first, second and third bytes
+// of each group, and the stores interleave the four sextets back, so no shuffling is needed.
+static void encode_block(const uint8_t *src, char *dst) {
+    uint8x16x3_t in = vld3q_u8(src);
+    uint8x16_t mask = vdupq_n_u8(0x3f);
+    uint8x16x4_t out;
+
+    out.val[0] = vshrq_n_u8(in.val[0], 2);
+    out.val[1] = vandq_u8(vorrq_u8(vshlq_n_u8(in.val[0], 4), vshrq_n_u8(in.val[1], 4)), mask);
+    out.val[2] = vandq_u8(vorrq_u8(vshlq_n_u8(in.val[1], 2), vshrq_n_u8(in.val[2], 6)), mask);
+    out.val[3] = vandq_u8(in.val[2], mask);
+
+    // Map each sextet to its character by adding the offset for its range of the alphabet
+    for (int i = 0; i < 4; i++) {
+        uint8x16_t sextet = out.val[i];
+        uint8x16_t ascii = vaddq_u8(sextet, vdupq_n_u8('A'));
+        ascii = vaddq_u8(ascii, vandq_u8(vcgeq_u8(sextet, vdupq_n_u8(26)), vdupq_n_u8('a' - 26 - 'A')));
+        ascii = vaddq_u8(ascii, vandq_u8(vcgeq_u8(sextet, vdupq_n_u8(52)), vdupq_n_u8((uint8_t) ('0' - 52 - ('a' - 26)))));
+        ascii = vaddq_u8(ascii, vandq_u8(vcgeq_u8(sextet, vdupq_n_u8(62)), vdupq_n_u8((uint8_t) ('+' - 62 - ('0' - 52)))));
+        ascii = vaddq_u8(ascii, vandq_u8(vcgeq_u8(sextet, vdupq_n_u8(63)), vdupq_n_u8((uint8_t) ('/' - 63 - ('+' - 62)))));
+        out.val[i] = ascii;
+    }
+
+    vst4q_u8((uint8_t *) dst, out);
+}
+
+#define BASE64_BLOCK_INPUT 48
+#define BASE64_BLOCK_READ 48
+
+#elif BASE64_SSSE3
+
+// Encode 12 bytes into 16 characters. Reads 16 bytes of src.
+static void encode_block(const uint8_t *src, char *dst) {
+    __m128i in = _mm_loadu_si128((const __m128i *) src);
+
+    // Spread each 3 byte group across a 32 bit lane as bytes 1 0 2 1, then shift each sextet into its own byte
+    in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+    __m128i high = _mm_mulhi_epu16(_mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00)), _mm_set1_epi32(0x04000040));
+    __m128i low = _mm_mullo_epi16(_mm_and_si128(in, _mm_set1_epi32(0x003f03f0)), _mm_set1_epi32(0x01000010));
+    __m128i sextet = _mm_or_si128(high, low);
+
+    // Map each sextet to its character by adding the offset for its range of the alphabet. Sextets are below
+    // 64, so the signed comparisons are safe.
+    __m128i ascii = _mm_add_epi8(sextet, _mm_set1_epi8('A'));
+    ascii = _mm_add_epi8(ascii, _mm_and_si128(_mm_cmpgt_epi8(sextet, _mm_set1_epi8(25)), _mm_set1_epi8('a' - 26 - 'A')));
+    ascii = _mm_add_epi8(ascii, _mm_and_si128(_mm_cmpgt_epi8(sextet, _mm_set1_epi8(51)), _mm_set1_epi8('0' - 52 - ('a' - 26))));
+    ascii = _mm_add_epi8(ascii, _mm_and_si128(_mm_cmpgt_epi8(sextet, _mm_set1_epi8(61)), _mm_set1_epi8('+' - 62 - ('0' - 52))));
+    ascii = _mm_add_epi8(ascii, _mm_and_si128(_mm_cmpgt_epi8(sextet, _mm_set1_epi8(62)), _mm_set1_epi8('/' - 63 - ('+' - 62))));
+
+    _mm_storeu_si128((__m128i *) dst, ascii);
+}
+
+#define BASE64_BLOCK_INPUT 12
+#define BASE64_BLOCK_READ 16
+
+#endif
+
+// Encode whole 3 byte groups of src, returning the number of characters written. length must be a multiple of 3.
+static size_t encode_groups(const uint8_t *src, size_t length, char *dst) {
+    char *out = dst;
+
+#ifdef BASE64_BLOCK_INPUT
+    while (length >= BASE64_BLOCK_READ) {
+        encode_block(src, out);
+        src += BASE64_BLOCK_INPUT;
+        length -= BASE64_BLOCK_INPUT;
+        out += BASE64_BLOCK_INPUT / 3 * 4;
+    }
+#endif
+
+    for (; length >= 3; length -= 3, src += 3) {
+        uint32_t group = ((uint32_t) src[0] << 16) | ((uint32_t) src[1] << 8) | src[2];
+        *out++ = encode_table[group >> 18];
+        *out++ = encode_table[(group >> 12) & 0x3f];
+        *out++ = encode_table[(group >> 6) & 0x3f];
+        *out++ = encode_table[group & 0x3f];
+    }
+
+    return (size_t) (out - dst);
+}
+
+// Encode the final 1 or 2 bytes of a stream, with padding.
+static size_t encode_tail(const uint8_t *src, size_t length, char *dst) {
+    if (length == 0)
+        return 0;
+
+    uint32_t group = ((uint32_t) src[0] << 16) | (length > 1 ? ((uint32_t) src[1] << 8) : 0);
+    dst[0] = encode_table[group >> 18];
+    dst[1] = encode_table[(group >> 12) & 0x3f];
+    dst[2] = (length > 1) ? encode_table[(group >> 6) & 0x3f] : '=';
+    dst[3] = '=';
+    return 4;
+}
+
+size_t ab_base64_encode(const void *src, size_t length, char *dst) {
+    size_t whole = length - (length % 3);
+    size_t written = encode_groups(src, whole, dst);
+    return written + encode_tail((const uint8_t *) src + whole, length - whole, dst + written);
+}
+
+void ab_base64_encoder_init(ab_base64_encoder_t *encoder) {
+    memset(encoder, 0, sizeof(*encoder));
+}
+
+size_t ab_base64_encoder_update(ab_base64_encoder_t *encoder, const void *src, size_t length, char *dst) {
+    const uint8_t *in = src;
+    size_t written = 0;
+
+    // Complete the group carried from the previous call
+    if (encoder->carry_length > 0) {
+        uint8_t group[3];
+        size_t needed = 3 - encoder->carry_length;
+        if (length < needed) {
+            memcpy(encoder->carry + encoder->carry_length, in, length);
+            encoder->carry_length += length;
+            return 0;
+        }
+        memcpy(group, encoder->carry, encoder->carry_length);
+        memcpy(group + encoder->carry_length, in, needed);
+        written = encode_groups(group, 3, dst);
+        in += needed;
+        length -= needed;
+        encoder->carry_length = 0;
+    }
+
+    size_t whole = length - (length % 3);
+    written += encode_groups(in, whole, dst + written);
+
+    encoder->carry_length = length - whole;
+    memcpy(encoder->carry, in + whole, encoder->carry_length);
+    return written;
+}
+
+size_t ab_base64_encoder_final(ab_base64_encoder_t *encoder, char *dst) {
+    size_t written = encode_tail(encoder->carry, encoder->carry_length, dst);
+    encoder->carry_length = 0;
+    return written;
+}
+
+bool ab_base64_decode(const char *src, size_t length, void *dst, size_t *decoded_length) {
+    uint8_t *out = dst;
+
+    if (length % 4 != 0)
+        return false;
+
+    for (size_t i = 0; i < length; i += 4) {
+        uint8_t a = decode_char(src[i]);
+        uint8_t b = decode_char(src[i + 1]);
+        if (a == BASE64_INVALID || b == BASE64_INVALID)
+            return false;
+
+        // Padding may only end the final group
+        bool last = (i + 4 == length);
+        if (last && src[i + 2] == '=' && src[i + 3] == '=') {
+            *out++ = (uint8_t) ((a << 2) | (b >> 4));
+            break;
+        }
+        uint8_t c = decode_char(src[i + 2]);
+        if (c == BASE64_INVALID)
+            return false;
+        if (last && src[i + 3] == '=') {
+            *out++ = (uint8_t) ((a << 2) | (b >> 4));
+            *out++ = (uint8_t) ((b << 4) | (c >> 2));
+            break;
+        }
+        uint8_t d = decode_char(src[i + 3]);
+        if (d == BASE64_INVALID)
+            return false;
+
+        *out++ = (uint8_t) ((a << 2) | (b >> 4));
+        *out++ = (uint8_t) ((b << 4) | (c >> 2));
+        *out++ = (uint8_t) ((c << 6) | d);
+    }
+
+    *decoded_length = (size_t) (out - (uint8_t *) dst);
+    return true;
+}
@@ -0,0 +1,51 @@
+//
+//  AppBladeBase64.h
+//  AppBlade
+//
+//  Copyright (c) 2013 AppBlade. All rights reserved.
+//
+//  Base64 (RFC 4648, standard alphabet, padded, no line breaks) for the SDK's request payloads. Encoding runs
+//  48 input bytes at a time with NEON on devices, 12 at a time with SSSE3 in the simulator, and a 3 byte group at a
+//  time on the remainder; decoding is scalar. The streaming encoder accepts input of any length, carrying partial
+//  groups between calls, so large files can be encoded in chunks.
+//
+
+#ifndef APPBLADE_BASE64_H
+#define APPBLADE_BASE64_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Length of the encoding of length bytes. Also bounds the output of ab_base64_encoder_update for length input bytes.
+#define AB_BASE64_ENCODED_LENGTH(length) ((((length) + 2) / 3) * 4)
+
+// Maximum length of the decoding of length characters.
+#define AB_BASE64_DECODED_LENGTH(length) ((((length) + 3) / 4) * 3)
+
+// Encoder state, carrying the bytes of a partial group between calls
+typedef struct ab_base64_encoder {
+    uint8_t carry[2];
+    size_t carry_length;
+} ab_base64_encoder_t;
+
+// Encode length bytes of src into dst, which must hold AB_BASE64_ENCODED_LENGTH(length) characters. The output
+// is not NUL terminated. Returns the number of characters written.
+size_t ab_base64_encode(const void *src, size_t length, char *dst);
+
+// Prepare encoder to encode a new stream.
+void ab_base64_encoder_init(ab_base64_encoder_t *encoder);
+
+// Encode the next length bytes of the stream into dst, which must hold AB_BASE64_ENCODED_LENGTH(length)
+// characters. Returns the number of characters written.
+size_t ab_base64_encoder_update(ab_base64_encoder_t *encoder, const void *src, size_t length, char *dst);
+
+// Encode the end of the stream, with padding, into dst, which must hold 4 characters. Returns the number of
+// characters written.
+size_t ab_base64_encoder_final(ab_base64_encoder_t *encoder, char *dst);
+
+// Decode length characters of src into dst, which must hold AB_BASE64_DECODED_LENGTH(length) bytes, setting
+// decoded_length to the number of bytes written. Returns false if src is not valid padded base64.
+bool ab_base64_decode(const char *src, size_t length, void *dst, size_t *decoded_length);
+
+#endif
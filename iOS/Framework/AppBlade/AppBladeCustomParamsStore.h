@@ -0,0 +1,33 @@
+//
+//  AppBladeCustomParamsStore.h
+//  AppBlade
+//
+//  Copyright (c) 2013 AppBlade. All rights reserved.
+//
+//  Custom params, held in memory as an immutable snapshot that is replaced whole on every change. Reading the
+//  params never touches the filesystem. Changes are written to disk on a background queue, after a short delay
+//  so that a burst of changes costs a single write and fsync; pending changes are also written when the app
+//  enters the background or terminates.
+//
+
+#import <Foundation/Foundation.h>
+
+@interface AppBladeCustomParamsStore : NSObject
+
+// Opens the store persisted at path, loading the params saved there if any.
+- (id)initWithPath:(NSString *)path;
+
+// The current params. Never nil.
+- (NSDictionary *)params;
+
+// Replaces the params. nil clears them, and removes the file.
+- (void)setParams:(NSDictionary *)params;
+
+// Replaces the params with the result of block, which is passed the current params. Concurrent updates are
+// applied one at a time, so none are lost.
+- (void)updateParamsUsingBlock:(NSDictionary *(^)(NSDictionary *params))block;
+
+// Writes any pending change to disk, waiting until it is done.
+- (void)flush;
+
+@end
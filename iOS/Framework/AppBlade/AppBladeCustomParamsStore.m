@@ -0,0 +1,181 @@
+//
+//  AppBladeCustomParamsStore.m
+//  AppBlade
+//
+//  Copyright (c) 2013 AppBlade. All rights reserved.
+//
+
+#import "AppBladeCustomParamsStore.h"
+#import "AppBladeLogging.h"
+
+#import <UIKit/UIKit.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <unistd.h>
+
+// How long changes are held back so that they can be written together
+static const NSTimeInterval kAppBladeCustomParamsWriteDelay = 1.0;
+
+@interface AppBladeCustomParamsStore ()
+{
+    dispatch_queue_t _writeQueue;
+}
+
+@property (nonatomic, strong) NSString *path;
+
+// The params, or nil once cleared; replaced, never mutated
+@property (atomic, strong) NSDictionary *snapshot;
+
+// Whether the snapshot has changed since it was last written, and whether a write is already scheduled
+@property (nonatomic, assign) BOOL dirty;
+@property (nonatomic, assign) BOOL writeScheduled;
+
+- (void)replaceSnapshot:(NSDictionary *)params;
+- (void)writeSnapshot;
+- (BOOL)writeData:(NSData *)data;
+
+@end
+
+@implementation AppBladeCustomParamsStore
+
+#pragma mark - Lifecycle
+
+- (id)initWithPath:(NSString *)path
+{
+    if((self = [super init])) {
+        self.path = path;
+        self.snapshot = [NSDictionary dictionaryWithContentsOfFile:path];
+        _writeQueue = dispatch_queue_create("com.appblade.customparams", DISPATCH_QUEUE_SERIAL);
+
+        [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(flush) name:UIApplicationDidEnterBackgroundNotification object:nil];
+        [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(flush) name:UIApplicationWillTerminateNotification object:nil];
+    }
+
+    return self;
+}
+
+- (void)dealloc
+{
+    [[NSNotificationCenter defaultCenter] removeObserver:self];
+#if !OS_OBJECT_USE_OBJC
+    dispatch_release(_writeQueue);
+#endif
+}
+
+#pragma mark - Params
+
+- (NSDictionary *)params
+{
+    NSDictionary *params = self.snapshot;
+    return params ? params : [NSDictionary dictionary];
+}
+
+- (void)setParams:(NSDictionary *)params
+{
+    @synchronized (self) {
+        [self replaceSnapshot:params];
+    }
+}
+
+- (void)updateParamsUsingBlock:(NSDictionary *(^)(NSDictionary *params))block
+{
+    @synchronized (self) {
+        [self replaceSnapshot:block([self params])];
+    }
+}
+
+- (void)flush
+{
+    dispatch_sync(_writeQueue, ^{
+        [self writeSnapshot];
+    });
+}
+
+#pragma mark - Helper Methods
+
+// Must be called while synchronized on self.
+- (void)replaceSnapshot:(NSDictionary *)params
+{
+    self.snapshot = [params copy];
+    self.dirty = YES;
+
+    if (!self.writeScheduled) {
+        self.writeScheduled = YES;
+
+        // Pending changes are dropped if the store is released first, as when the cache directory is cleared
+        __weak AppBladeCustomParamsStore *weakSelf = self;
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(kAppBladeCustomParamsWriteDelay * NSEC_PER_SEC)), _writeQueue, ^{
+            [weakSelf writeSnapshot];
+        });
+    }
+}
+
+// Called on the write queue.
+- (void)writeSnapshot
+{
+    NSDictionary *params = nil;
+    @synchronized (self) {
+        if (!self.dirty) {
+            return;
+        }
+        params = self.snapshot;
+        self.dirty = NO;
+        self.writeScheduled = NO;
+    }
+
+    if (params == nil) {
+        ABDebugLog_internal(@"clearing custom params, removing file");
+        [[NSFileManager defaultManager] removeItemAtPath:self.path error:nil];
+        return;
+    }
+
+    NSError *error = nil;
+    NSData *paramsData = [NSPropertyListSerialization dataWithPropertyList:params format:NSPropertyListXMLFormat_v1_0 options:0 error:&error];
+    if (paramsData == nil) {
+        ABErrorLog(@"Error parsing custom params %@", params);
+        return;
+    }
+    [[NSFileManager defaultManager] createDirectoryAtPath:[self.path stringByDeletingLastPathComponent] withIntermediateDirectories:YES attributes:nil error:nil];
+    if (![self writeData:paramsData]) {
+        ABErrorLog(@"Error writing custom params: %s", strerror(errno));
+    }
+}
+
+// Replaces the file with data, durably: the data is synced to a temporary file which is renamed into place.
+- (BOOL)writeData:(NSData *)data
+{
+    NSString *tmpPath = [self.path stringByAppendingPathExtension:@"tmp"];
+    int fd = open([tmpPath fileSystemRepresentation], O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return NO;
+    }
+
+    const uint8_t *bytes = [data bytes];
+    size_t length = [data length];
+    while (length > 0) {
+        ssize_t written = write(fd, bytes, length);
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        bytes += written;
+        length -= (size_t)written;
+    }
+
+    BOOL success = (length == 0 && fsync(fd) == 0);
+    int err = errno;
+    close(fd);
+    if (success) {
+        if (rename([tmpPath fileSystemRepresentation], [self.path fileSystemRepresentation]) == 0) {
+            return YES;
+        }
+        err = errno;
+    }
+
+    unlink([tmpPath fileSystemRepresentation]);
+    errno = err;
+    return NO;
+}
+
+@end
@@ -0,0 +1,116 @@
+//
+//  AppBladeFileHash.c
+//  AppBlade
+//
+//  Copyright (c) 2013 AppBlade. All rights reserved.
+//
+
+#include "AppBladeFileHash.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <CommonCrypto/CommonDigest.h>
+
+// Amount hashed per CC_MD5_Update call, and read per call when the file cannot be mapped
+#define FILE_HASH_BLOCK_SIZE (1024 * 1024)
+
+#if defined(__APPLE__)
+#define FILE_HASH_MTIME st_mtimespec
+#else
+#define FILE_HASH_MTIME st_mtim
+#endif
+
+static void identity_from_stat(const struct stat *sb, ab_file_identity_t *identity) {
+    memset(identity, 0, sizeof(*identity));
+    identity->device = (uint64_t) sb->st_dev;
+    identity->inode = (uint64_t) sb->st_ino;
+    identity->size = (uint64_t) sb->st_size;
+    identity->mtime_sec = (int64_t) sb->FILE_HASH_MTIME.tv_sec;
+    identity->mtime_nsec = (int64_t) sb->FILE_HASH_MTIME.tv_nsec;
+}
+
+bool ab_file_identity(const char *path, ab_file_identity_t *identity) {
+    struct stat sb;
+
+    if (stat(path, &sb) != 0)
+        return false;
+    identity_from_stat(&sb, identity);
+    return true;
+}
+
+// Hash the file by reading it, for files that cannot be mapped.
+static bool hash_by_reading(int fd, CC_MD5_CTX *context) {
+    uint8_t *buf = malloc(FILE_HASH_BLOCK_SIZE);
+    ssize_t n;
+
+    if (buf == NULL)
+        return false;
+
+    while ((n = read(fd, buf, FILE_HASH_BLOCK_SIZE)) != 0) {
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            free(buf);
+            return false;
+        }
+        CC_MD5_Update(context, buf, (CC_LONG) n);
+    }
+
+    free(buf);
+    return true;
+}
+
+bool ab_file_hash_md5(const char *path, uint8_t digest[AB_FILE_HASH_MD5_LENGTH], ab_file_identity_t *identity) {
+    CC_MD5_CTX context;
+    struct stat sb;
+    bool success = false;
+    int fd;
+
+    if ((fd = open(path, O_RDONLY)) < 0)
+        return false;
+
+    if (fstat(fd, &sb) != 0)
+        goto done;
+
+    CC_MD5_Init(&context);
+
+    void *map = MAP_FAILED;
+    if (sb.st_size > 0 && (uint64_t) sb.st_size <= SIZE_MAX)
+        map = mmap(NULL, (size_t) sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    if (map != MAP_FAILED) {
+        const uint8_t *cursor = map;
+        size_t remaining = (size_t) sb.st_size;
+
+        // The pages are read once, front to back
+        madvise(map, remaining, MADV_SEQUENTIAL);
+        while (remaining > 0) {
+            size_t block = (remaining < FILE_HASH_BLOCK_SIZE) ? remaining : FILE_HASH_BLOCK_SIZE;
+            CC_MD5_Update(&context, cursor, (CC_LONG) block);
+            cursor += block;
+            remaining -= block;
+        }
+        munmap(map, (size_t) sb.st_size);
+    } else if (!hash_by_reading(fd, &context)) {
+        goto done;
+    }
+
+    CC_MD5_Final(digest, &context);
+    if (identity != NULL)
+        identity_from_stat(&sb, identity);
+    success = true;
+
+done:
+    {
+        int err = errno;
+        close(fd);
+        errno = err;
+    }
+    return success;
+}
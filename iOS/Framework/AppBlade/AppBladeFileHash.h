@@ -0,0 +1,35 @@
+//
+//  AppBladeFileHash.h
+//  AppBlade
+//
+//  Copyright (c) 2013 AppBlade. All rights reserved.
+//
+//  MD5 hashing of whole files, read through a memory mapping in large blocks rather than through a stream.
+//  Falls back to reading the file in large chunks where it cannot be mapped.
+//
+
+#ifndef APPBLADE_FILE_HASH_H
+#define APPBLADE_FILE_HASH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define AB_FILE_HASH_MD5_LENGTH 16
+
+// Identifies a version of a file: if any of these change, the file's contents may have changed
+typedef struct ab_file_identity {
+    uint64_t device;
+    uint64_t inode;
+    uint64_t size;
+    int64_t mtime_sec;
+    int64_t mtime_nsec;
+} ab_file_identity_t;
+
+// Get the identity of the file at path. Returns false and sets errno on failure.
+bool ab_file_identity(const char *path, ab_file_identity_t *identity);
+
+// Compute the MD5 digest of the file at path. If identity is not NULL, it is set to the identity of the file
+// that was hashed. Returns false and sets errno on failure.
+bool ab_file_hash_md5(const char *path, uint8_t digest[AB_FILE_HASH_MD5_LENGTH], ab_file_identity_t *identity);
+
+#endif
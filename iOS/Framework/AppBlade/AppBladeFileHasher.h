@@ -0,0 +1,24 @@
+//
+//  AppBladeFileHasher.h
+//  AppBlade
+//
+//  Copyright (c) 2013 AppBlade. All rights reserved.
+//
+//  MD5 hashes of the app's bundle files, cached across launches. A file is only hashed again when its inode,
+//  size or modification time change, or when the app's executable UUID changes, so an unchanged build costs a
+//  stat() per lookup rather than a read of the whole file.
+//
+
+#import <Foundation/Foundation.h>
+
+@interface AppBladeFileHasher : NSObject
+
++ (AppBladeFileHasher *)sharedHasher;
+
+// Opens the cache persisted at path.
+- (id)initWithPath:(NSString *)path;
+
+// The lowercase hex MD5 of the file at path, or nil if it cannot be read.
+- (NSString *)md5OfFileAtPath:(NSString *)path;
+
+@end
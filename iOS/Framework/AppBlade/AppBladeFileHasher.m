@@ -0,0 +1,151 @@
+//
+//  AppBladeFileHasher.m
+//  AppBlade
+//
+//  Copyright (c) 2013 AppBlade. All rights reserved.
+//
+
+#import "AppBladeFileHasher.h"
+#import "AppBlade.h"
+#import "AppBladeLogging.h"
+#include "AppBladeFileHash.h"
+
+#import <mach-o/dyld.h>
+#import <mach-o/loader.h>
+
+static NSString* const kAppBladeFileHashCacheFile = @"AppBladeFileHashes.plist";
+
+// Keys of each cache entry
+static NSString* const kAppBladeFileHashKeyDevice         = @"device";
+static NSString* const kAppBladeFileHashKeyInode          = @"inode";
+static NSString* const kAppBladeFileHashKeySize           = @"size";
+static NSString* const kAppBladeFileHashKeyModifiedSec    = @"mtime_sec";
+static NSString* const kAppBladeFileHashKeyModifiedNsec   = @"mtime_nsec";
+static NSString* const kAppBladeFileHashKeyExecutableUUID = @"executable_uuid";
+static NSString* const kAppBladeFileHashKeyMD5            = @"md5";
+
+// The LC_UUID of the main executable, which changes with every build. Unlike _mh_execute_header, the image
+// header is also found in the simulator.
+static NSString *main_executable_uuid(void) {
+    const struct mach_header *header = _dyld_get_image_header(0);
+    if (header == NULL) {
+        return @"";
+    }
+
+    const uint8_t *command = (const uint8_t *)header;
+    command += (header->magic == MH_MAGIC_64 || header->magic == MH_CIGAM_64) ? sizeof(struct mach_header_64) : sizeof(struct mach_header);
+    for (uint32_t idx = 0; idx < header->ncmds; ++idx) {
+        const struct load_command *load = (const struct load_command *)command;
+        if (load->cmd == LC_UUID) {
+            const uint8_t *uuid = ((const struct uuid_command *)load)->uuid;
+            NSMutableString *string = [NSMutableString stringWithCapacity:32];
+            for (int i = 0; i < 16; i++) {
+                [string appendFormat:@"%02X", uuid[i]];
+            }
+            return string;
+        }
+        command += load->cmdsize;
+    }
+    return @"";
+}
+
+static NSDictionary *entry_for_identity(const ab_file_identity_t *identity, NSString *executableUUID, NSString *md5) {
+    return [NSDictionary dictionaryWithObjectsAndKeys:
+            [NSNumber numberWithUnsignedLongLong:identity->device], kAppBladeFileHashKeyDevice,
+            [NSNumber numberWithUnsignedLongLong:identity->inode], kAppBladeFileHashKeyInode,
+            [NSNumber numberWithUnsignedLongLong:identity->size], kAppBladeFileHashKeySize,
+            [NSNumber numberWithLongLong:identity->mtime_sec], kAppBladeFileHashKeyModifiedSec,
+            [NSNumber numberWithLongLong:identity->mtime_nsec], kAppBladeFileHashKeyModifiedNsec,
+            executableUUID, kAppBladeFileHashKeyExecutableUUID,
+            md5, kAppBladeFileHashKeyMD5,
+            nil];
+}
+
+@interface AppBladeFileHasher ()
+
+@property (nonatomic, strong) NSString *path;
+@property (nonatomic, strong) NSString *executableUUID;
+
+// Cache entries, by file path
+@property (nonatomic, strong) NSMutableDictionary *entries;
+
+@end
+
+@implementation AppBladeFileHasher
+
+#pragma mark - Lifecycle
+
++ (AppBladeFileHasher *)sharedHasher
+{
+    static AppBladeFileHasher *sharedHasher = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        NSString *path = [[AppBlade cachesDirectoryPath] stringByAppendingPathComponent:kAppBladeFileHashCacheFile];
+        sharedHasher = [[AppBladeFileHasher alloc] initWithPath:path];
+    });
+    return sharedHasher;
+}
+
+- (id)initWithPath:(NSString *)path
+{
+    if((self = [super init])) {
+        self.path = path;
+        self.executableUUID = main_executable_uuid();
+
+        self.entries = [NSMutableDictionary dictionary];
+        NSDictionary *saved = [NSDictionary dictionaryWithContentsOfFile:path];
+        for (NSString *filePath in saved) {
+            // Entries from another build are stale
+            NSDictionary *entry = [saved objectForKey:filePath];
+            if ([entry isKindOfClass:[NSDictionary class]] && [[entry objectForKey:kAppBladeFileHashKeyExecutableUUID] isEqual:self.executableUUID]) {
+                [self.entries setObject:entry forKey:filePath];
+            }
+        }
+    }
+
+    return self;
+}
+
+#pragma mark - Hashing
+
+- (NSString *)md5OfFileAtPath:(NSString *)path
+{
+    if (path == nil) {
+        return nil;
+    }
+
+    @synchronized (self) {
+        ab_file_identity_t identity;
+        if (!ab_file_identity([path fileSystemRepresentation], &identity)) {
+            ABErrorLog(@"Error reading %@ for hashing: %s", path, strerror(errno));
+            return nil;
+        }
+
+        NSDictionary *entry = [self.entries objectForKey:path];
+        if (entry && [entry isEqualToDictionary:entry_for_identity(&identity, self.executableUUID, [entry objectForKey:kAppBladeFileHashKeyMD5])]) {
+            return [entry objectForKey:kAppBladeFileHashKeyMD5];
+        }
+
+        uint8_t digest[AB_FILE_HASH_MD5_LENGTH];
+        if (!ab_file_hash_md5([path fileSystemRepresentation], digest, &identity)) {
+            ABErrorLog(@"Error hashing %@: %s", path, strerror(errno));
+            return nil;
+        }
+
+        NSMutableString *md5 = [NSMutableString stringWithCapacity:AB_FILE_HASH_MD5_LENGTH * 2];
+        for (int i = 0; i < AB_FILE_HASH_MD5_LENGTH; i++) {
+            [md5 appendFormat:@"%02x", digest[i]];
+        }
+        ABDebugLog_internal(@"Hashed %@: %@", path, md5);
+
+        [self.entries setObject:entry_for_identity(&identity, self.executableUUID, md5) forKey:path];
+        [[NSFileManager defaultManager] createDirectoryAtPath:[self.path stringByDeletingLastPathComponent] withIntermediateDirectories:YES attributes:nil error:nil];
+        if (![self.entries writeToFile:self.path atomically:YES]) {
+            ABErrorLog(@"Error saving file hashes to %@", self.path);
+        }
+
+        return [md5 copy];
+    }
+}
+
+@end
@@ -0,0 +1,47 @@
+//
+//  AppBladeRequestBody.h
+//  AppBlade
+//
+//  Copyright (c) 2013 AppBlade. All rights reserved.
+//
+//  Request body built by appending chunks. Small bodies are kept in memory; larger ones are spooled to a
+//  temporary file and uploaded as a stream, so that memory use does not depend on the size of the payload.
+//  Each chunk is passed to the signer as it is appended, after compression if enabled.
+//
+
+#import <Foundation/Foundation.h>
+
+@class AppBladeRequestSigner;
+
+@interface AppBladeRequestBody : NSObject
+
+// Receives the body bytes, as they will be sent.
+@property (nonatomic, strong) AppBladeRequestSigner *signer;
+
+// Whether the body is gzip compressed as it is appended.
+@property (nonatomic, readonly, getter = isCompressed) BOOL compressed;
+
+// Number of bytes to be sent, so far.
+@property (nonatomic, readonly) unsigned long long length;
+
+- (id)initWithCompression:(BOOL)compressed;
+
+// Appending after a failure, or after -finish, has no effect; the failure is reported by -finish.
+- (void)appendData:(NSData *)data;
+- (void)appendString:(NSString *)string;
+- (void)appendBytes:(const void *)bytes length:(size_t)length;
+
+// Appends the file's contents, read in chunks.
+- (void)appendContentsOfFile:(NSString *)path;
+
+// Completes the body. Returns NO if any part of it could not be written.
+- (BOOL)finish;
+
+// Sets the finished body as the request's HTTPBody or HTTPBodyStream, with matching Content-Length and
+// Content-Encoding headers.
+- (void)attachToRequest:(NSMutableURLRequest *)request;
+
+// Returns a new stream over the finished body, for uploads that have to be restarted.
+- (NSInputStream *)inputStream;
+
+@end
@@ -0,0 +1,268 @@
+//
+//  AppBladeRequestBody.m
+//  AppBlade
+//
+//  Copyright (c) 2013 AppBlade. All rights reserved.
+//
+
+#import "AppBladeRequestBody.h"
+#import "AppBladeRequestSigner.h"
+#import "AppBladeLogging.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <zlib.h>
+
+// Bodies larger than this are spooled to disk
+static const NSUInteger kAppBladeRequestBodyMemoryLimit = 64 * 1024;
+
+// Size of the buffers used to read files and to hold compressed output
+static const NSUInteger kAppBladeRequestBodyChunkSize = 32 * 1024;
+
+// Write all of buf to fd, retrying on EINTR and short writes.
+static BOOL write_all(int fd, const uint8_t *buf, size_t length) {
+    while (length > 0) {
+        ssize_t written = write(fd, buf, length);
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            return NO;
+        }
+        buf += written;
+        length -= (size_t)written;
+    }
+    return YES;
+}
+
+@interface AppBladeRequestBody ()
+{
+    z_stream _zstream;
+    int _fd;
+}
+
+@property (nonatomic, readwrite, getter = isCompressed) BOOL compressed;
+@property (nonatomic, readwrite) unsigned long long length;
+@property (nonatomic, strong) NSMutableData *memoryBody;
+@property (nonatomic, strong) NSString *spoolPath;
+@property (nonatomic, assign) BOOL failed;
+@property (nonatomic, assign) BOOL finished;
+
+- (void)deflateBytes:(const void *)bytes length:(size_t)length flush:(int)flush;
+- (void)emitBytes:(const void *)bytes length:(size_t)length;
+- (BOOL)spoolToFile;
+
+@end
+
+@implementation AppBladeRequestBody
+
+- (id)initWithCompression:(BOOL)compressed
+{
+    if((self = [super init])) {
+        _fd = -1;
+        self.memoryBody = [NSMutableData data];
+
+        if (compressed) {
+            // A window of 15 bits, plus 16 for a gzip header and trailer
+            if (deflateInit2(&_zstream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+                ABErrorLog(@"Error initializing request body compression: %s", _zstream.msg ? _zstream.msg : "unknown");
+                return nil;
+            }
+            self.compressed = YES;
+        }
+    }
+
+    return self;
+}
+
+- (void)dealloc
+{
+    if (self.compressed) {
+        deflateEnd(&_zstream);
+    }
+    if (_fd >= 0) {
+        close(_fd);
+    }
+    if (self.spoolPath) {
+        unlink([self.spoolPath fileSystemRepresentation]);
+    }
+}
+
+#pragma mark - Appending
+
+- (void)appendData:(NSData *)data
+{
+    [self appendBytes:[data bytes] length:[data length]];
+}
+
+- (void)appendString:(NSString *)string
+{
+    [self appendData:[string dataUsingEncoding:NSUTF8StringEncoding]];
+}
+
+- (void)appendBytes:(const void *)bytes length:(size_t)length
+{
+    if (self.failed || self.finished || length == 0) {
+        return;
+    }
+
+    if (self.compressed) {
+        [self deflateBytes:bytes length:length flush:Z_NO_FLUSH];
+    }
+    else
+    {
+        [self emitBytes:bytes length:length];
+    }
+}
+
+- (void)appendContentsOfFile:(NSString *)path
+{
+    if (self.failed || self.finished) {
+        return;
+    }
+
+    int fd = open([path fileSystemRepresentation], O_RDONLY);
+    if (fd < 0) {
+        ABErrorLog(@"Error opening %@ for the request body: %s", path, strerror(errno));
+        self.failed = YES;
+        return;
+    }
+
+    uint8_t buffer[kAppBladeRequestBodyChunkSize];
+    ssize_t count;
+    while ((count = read(fd, buffer, sizeof(buffer))) != 0) {
+        if (count < 0) {
+            if (errno == EINTR)
+                continue;
+            ABErrorLog(@"Error reading %@ for the request body: %s", path, strerror(errno));
+            self.failed = YES;
+            break;
+        }
+        [self appendBytes:buffer length:(size_t)count];
+    }
+    close(fd);
+}
+
+- (BOOL)finish
+{
+    if (!self.finished) {
+        if (self.compressed && !self.failed) {
+            [self deflateBytes:NULL length:0 flush:Z_FINISH];
+        }
+        if (_fd >= 0) {
+            close(_fd);
+            _fd = -1;
+        }
+        self.finished = YES;
+    }
+    return !self.failed;
+}
+
+#pragma mark - Sending
+
+- (void)attachToRequest:(NSMutableURLRequest *)request
+{
+    NSAssert(self.finished, @"Request body attached before it was finished");
+
+    if (self.spoolPath) {
+        [request setHTTPBodyStream:[self inputStream]];
+    }
+    else
+    {
+        [request setHTTPBody:self.memoryBody];
+    }
+    [request setValue:[NSString stringWithFormat:@"%llu", self.length] forHTTPHeaderField:@"Content-Length"];
+    if (self.compressed) {
+        [request setValue:@"gzip" forHTTPHeaderField:@"Content-Encoding"];
+    }
+}
+
+- (NSInputStream *)inputStream
+{
+    if (self.spoolPath) {
+        return [NSInputStream inputStreamWithFileAtPath:self.spoolPath];
+    }
+    return [NSInputStream inputStreamWithData:self.memoryBody];
+}
+
+#pragma mark - Helper Methods
+
+- (void)deflateBytes:(const void *)bytes length:(size_t)length flush:(int)flush
+{
+    uint8_t buffer[kAppBladeRequestBodyChunkSize];
+
+    // zlib takes 32 bit lengths
+    const uint8_t *cursor = bytes;
+    do {
+        uInt chunk = (uInt)MIN(length, (size_t)UINT_MAX);
+        int chunkFlush = (chunk == length) ? flush : Z_NO_FLUSH;
+        _zstream.next_in = (Bytef *)cursor;
+        _zstream.avail_in = chunk;
+        cursor += chunk;
+        length -= chunk;
+
+        int err;
+        do {
+            _zstream.next_out = buffer;
+            _zstream.avail_out = sizeof(buffer);
+            err = deflate(&_zstream, chunkFlush);
+            if (err == Z_STREAM_ERROR) {
+                ABErrorLog(@"Error compressing the request body");
+                self.failed = YES;
+                return;
+            }
+            [self emitBytes:buffer length:sizeof(buffer) - _zstream.avail_out];
+        } while (_zstream.avail_out == 0 || (chunkFlush == Z_FINISH && err != Z_STREAM_END));
+    } while (length > 0);
+}
+
+- (void)emitBytes:(const void *)bytes length:(size_t)length
+{
+    if (self.failed || length == 0) {
+        return;
+    }
+
+    [self.signer updateWithBytes:bytes length:length];
+    self.length += length;
+
+    if (_fd < 0) {
+        [self.memoryBody appendBytes:bytes length:length];
+        if ([self.memoryBody length] > kAppBladeRequestBodyMemoryLimit && ![self spoolToFile]) {
+            self.failed = YES;
+        }
+        return;
+    }
+
+    if (!write_all(_fd, bytes, length)) {
+        ABErrorLog(@"Error writing the request body: %s", strerror(errno));
+        self.failed = YES;
+    }
+}
+
+// Moves the body written so far to a temporary file, to which the rest of the body is appended.
+- (BOOL)spoolToFile
+{
+    NSString *template = [NSTemporaryDirectory() stringByAppendingPathComponent:@"AppBladeRequestBody.XXXXXX"];
+    char *path = strdup([template fileSystemRepresentation]);
+    if (path == NULL) {
+        return NO;
+    }
+
+    _fd = mkstemp(path);
+    if (_fd < 0) {
+        ABErrorLog(@"Error creating a temporary file for the request body: %s", strerror(errno));
+        free(path);
+        return NO;
+    }
+    self.spoolPath = [[NSFileManager defaultManager] stringWithFileSystemRepresentation:path length:strlen(path)];
+    free(path);
+
+    NSData *spooled = self.memoryBody;
+    self.memoryBody = nil;
+    if (!write_all(_fd, [spooled bytes], [spooled length])) {
+        ABErrorLog(@"Error writing the request body: %s", strerror(errno));
+        return NO;
+    }
+    return YES;
+}
+
+@end
@@ -0,0 +1,33 @@
+//
+//  AppBladeRequestSigner.h
+//  AppBlade
+//
+//  Copyright (c) 2013 AppBlade. All rights reserved.
+//
+//  Incremental HMAC signing of AppBlade API requests. The request body is digested as it is produced, so that
+//  it never has to be held in memory to be signed.
+//
+//  The signature is computed over
+//
+//    body-hash = base64(SHA-256(<relative URL> "?" <body>))
+//    mac       = base64(HMAC-SHA-256(project secret, <nonce> "\n" <method> "\n" <relative URL> "?" <body> "\n"
+//                                    <host> "\n" <port> "\n" <body-hash> "\n" <device secret> "\n"))
+//
+//  where "?" <body> is omitted for requests without a body.
+//
+
+#import <Foundation/Foundation.h>
+
+@interface AppBladeRequestSigner : NSObject
+
+// Begins signing request, whose URL and HTTP method must already be set. If hasBody is YES, every byte of the
+// body must be passed to -updateWithBytes:length: before the Authorization header is requested.
+- (id)initWithRequest:(NSURLRequest *)request hasBody:(BOOL)hasBody nonce:(NSString *)nonce projectSecret:(NSString *)projectSecret deviceSecret:(NSString *)deviceSecret;
+
+// Digests the next bytes of the request body.
+- (void)updateWithBytes:(const void *)bytes length:(size_t)length;
+
+// Completes the signature and returns the value of the Authorization header. No more body may be digested.
+- (NSString *)authorizationHeader;
+
+@end
@@ -0,0 +1,133 @@
+//
+//  AppBladeRequestSigner.m
+//  AppBlade
+//
+//  Copyright (c) 2013 AppBlade. All rights reserved.
+//
+
+#import "AppBladeRequestSigner.h"
+#import "AppBladeWebClient.h"
+#include "AppBladeBase64.h"
+
+#import <CommonCrypto/CommonDigest.h>
+#import <CommonCrypto/CommonHMAC.h>
+
+static NSString *base64_digest(const unsigned char digest[CC_SHA256_DIGEST_LENGTH]) {
+    char encoded[AB_BASE64_ENCODED_LENGTH(CC_SHA256_DIGEST_LENGTH)];
+    size_t length = ab_base64_encode(digest, CC_SHA256_DIGEST_LENGTH, encoded);
+    return [[NSString alloc] initWithBytes:encoded length:length encoding:NSASCIIStringEncoding];
+}
+
+@interface AppBladeRequestSigner ()
+{
+    CC_SHA256_CTX _bodyHash;
+    CCHmacContext _mac;
+}
+
+@property (nonatomic, strong) NSString *nonce;
+@property (nonatomic, strong) NSString *projectSecret;
+@property (nonatomic, strong) NSString *deviceSecret;
+@property (nonatomic, strong) NSString *host;
+@property (nonatomic, strong) NSString *port;
+@property (nonatomic, strong) NSString *authorization;
+
+- (void)updateWithString:(NSString *)string;
+
+@end
+
+@implementation AppBladeRequestSigner
+
+- (id)initWithRequest:(NSURLRequest *)request hasBody:(BOOL)hasBody nonce:(NSString *)nonce projectSecret:(NSString *)projectSecret deviceSecret:(NSString *)deviceSecret
+{
+    if((self = [super init])) {
+        self.nonce = nonce;
+        self.projectSecret = projectSecret;
+        self.deviceSecret = deviceSecret;
+        self.host = [[request URL] host];
+
+        //determine http or https
+        NSString* scheme = [[request URL] scheme];
+        if(scheme == nil){
+            scheme = defaultURLScheme;
+        }
+        else
+        {
+            scheme = [scheme lowercaseString]; //for string comparison sanity
+        }
+        NSString* preparedHostName = [NSString stringWithFormat:@"%@://%@", scheme, self.host];
+
+        //find port number
+        if ([[request URL] port]) {
+            self.port = [[[request URL] port] stringValue];
+            preparedHostName = [preparedHostName stringByAppendingFormat:@":%@", self.port];
+        }
+        else
+        {   // Set port number based on the scheme
+            self.port = [scheme isEqualToString:@"https"] ? @"443" : @"80";
+        }
+
+        // The relative URL path, followed by "?" and the body if there is one.
+        NSString *relativeURL = [[[request URL] absoluteString] substringFromIndex:[preparedHostName length]];
+        if (hasBody) {
+            relativeURL = [relativeURL stringByAppendingString:@"?"];
+        }
+        NSData *relativeURLData = [relativeURL dataUsingEncoding:NSUTF8StringEncoding];
+
+        CC_SHA256_Init(&_bodyHash);
+        CC_SHA256_Update(&_bodyHash, [relativeURLData bytes], (CC_LONG)[relativeURLData length]);
+
+        NSData *key = [projectSecret dataUsingEncoding:NSUTF8StringEncoding];
+        CCHmacInit(&_mac, kCCHmacAlgSHA256, [key bytes], [key length]);
+        [self updateWithString:[NSString stringWithFormat:@"%@\n%@\n", nonce, [request HTTPMethod]]];
+        CCHmacUpdate(&_mac, [relativeURLData bytes], [relativeURLData length]);
+    }
+
+    return self;
+}
+
+- (void)updateWithBytes:(const void *)bytes length:(size_t)length
+{
+    NSAssert(self.authorization == nil, @"Request body digested after signing");
+
+    // CC_SHA256_Update takes a 32 bit length
+    const uint8_t *cursor = bytes;
+    while (length > 0) {
+        CC_LONG chunk = (CC_LONG)MIN(length, (size_t)UINT32_MAX);
+        CC_SHA256_Update(&_bodyHash, cursor, chunk);
+        CCHmacUpdate(&_mac, cursor, chunk);
+        cursor += chunk;
+        length -= chunk;
+    }
+}
+
+- (NSString *)authorizationHeader
+{
+    if (self.authorization == nil) {
+        unsigned char bodyHash[CC_SHA256_DIGEST_LENGTH];
+        CC_SHA256_Final(bodyHash, &_bodyHash);
+        NSString *requestBodyHash = base64_digest(bodyHash);
+
+        // Complete the normalized request.
+        [self updateWithString:[NSString stringWithFormat:@"\n%@\n%@\n%@\n%@\n", self.host, self.port, requestBodyHash, self.deviceSecret]];
+        unsigned char mac[CC_SHA256_DIGEST_LENGTH];
+        CCHmacFinal(&_mac, mac);
+        NSString *macString = base64_digest(mac);
+
+        NSMutableString *authHeader = [NSMutableString stringWithString:@"HMAC "];
+        [authHeader appendFormat:@"id=\"%@\"", self.projectSecret];
+        [authHeader appendFormat:@", nonce=\"%@\"", self.nonce];
+        [authHeader appendFormat:@", body-hash=\"%@\"", requestBodyHash];
+        [authHeader appendFormat:@", ext=\"%@\"", self.deviceSecret];
+        [authHeader appendFormat:@", mac=\"%@\"", macString];
+        self.authorization = authHeader;
+    }
+    return self.authorization;
+}
+
+- (void)updateWithString:(NSString *)string
+{
+    NSData *data = [string dataUsingEncoding:NSUTF8StringEncoding];
+    CCHmacUpdate(&_mac, [data bytes], [data length]);
+}
+
+@end
@@ -0,0 +1,565 @@
+//
+//  AppBladeSessionJournal.c
+//  AppBlade
+//
+//  Copyright (c) 2013 AppBlade. All rights reserved.
+//
+
+#include "AppBladeSessionJournal.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <zlib.h>
+
+#define JOURNAL_MAGIC "ABSJ"
+#define JOURNAL_VERSION 1
+#define JOURNAL_HEADER_SIZE 16
+
+// Size of a record, excluding its body
+#define JOURNAL_RECORD_SIZE 16
+
+// Size of a SESSION record's body
+#define JOURNAL_SESSION_SIZE 16
+
+#define JOURNAL_KIND_SESSION 1
+#define JOURNAL_KIND_PARAMS 2
+
+// Largest params blob accepted, guarding against corrupt lengths
+#define JOURNAL_PARAMS_MAX (1024 * 1024)
+
+// Size of the buffer used to copy records when compacting
+#define JOURNAL_COPY_BUFFER_SIZE (32 * 1024)
+
+static void put_le32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t) v;
+    p[1] = (uint8_t) (v >> 8);
+    p[2] = (uint8_t) (v >> 16);
+    p[3] = (uint8_t) (v >> 24);
+}
+
+static void put_le64(uint8_t *p, uint64_t v) {
+    put_le32(p, (uint32_t) v);
+    put_le32(p + 4, (uint32_t) (v >> 32));
+}
+
+static uint32_t get_le32(const uint8_t *p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static uint64_t get_le64(const uint8_t *p) {
+    return get_le32(p) | ((uint64_t) get_le32(p + 4) << 32);
+}
+
+// Write all of buf to fd, retrying on EINTR and short writes.
+static bool write_all(int fd, const uint8_t *buf, size_t length) {
+    while (length > 0) {
+        ssize_t written = write(fd, buf, length);
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        buf += written;
+        length -= (size_t) written;
+    }
+    return true;
+}
+
+// Read exactly length bytes at offset, failing with EIO at end of file.
+static bool read_all(int fd, uint8_t *buf, size_t length, off_t offset) {
+    while (length > 0) {
+        ssize_t n = pread(fd, buf, length, offset);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        if (n == 0) {
+            errno = EIO;
+            return false;
+        }
+        buf += n;
+        length -= (size_t) n;
+        offset += n;
+    }
+    return true;
+}
+
+// Grow *buf to hold at least length bytes.
+static bool reserve(uint8_t **buf, size_t *capacity, size_t length) {
+    uint8_t *grown;
+
+    if (length <= *capacity)
+        return true;
+    if ((grown = realloc(*buf, length)) == NULL)
+        return false;
+    *buf = grown;
+    *capacity = length;
+    return true;
+}
+
+static void encode_header(uint8_t *buf) {
+    memcpy(buf, JOURNAL_MAGIC, 4);
+    put_le32(buf + 4, JOURNAL_VERSION);
+    put_le64(buf + 8, 0);
+}
+
+// Encode a record's header into buf, for a body that is already in place after it.
+static void encode_record(uint8_t *buf, uint8_t kind, uint32_t params_id, uint32_t body_length) {
+    buf[4] = kind;
+    buf[5] = buf[6] = buf[7] = 0;
+    put_le32(buf + 8, params_id);
+    put_le32(buf + 12, body_length);
+    put_le32(buf, (uint32_t) crc32(0L, buf + 4, JOURNAL_RECORD_SIZE - 4 + body_length));
+}
+
+// Return the stored params with the given id, or NULL.
+static ab_session_journal_params_t *find_params(const ab_session_journal_t *journal, uint32_t id) {
+    size_t lo = 0, hi = journal->params_count;
+
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (journal->params[mid].id < id)
+            lo = mid + 1;
+        else if (journal->params[mid].id > id)
+            hi = mid;
+        else
+            return &journal->params[mid];
+    }
+    return NULL;
+}
+
+// Add stored params, whose id must be greater than that of any already stored.
+static bool add_params(ab_session_journal_t *journal, uint32_t id, uint32_t crc, off_t offset, uint32_t length) {
+    if (journal->params_count == journal->params_capacity) {
+        size_t capacity = (journal->params_capacity == 0) ? 4 : journal->params_capacity * 2;
+        ab_session_journal_params_t *params = realloc(journal->params, capacity * sizeof(*params));
+        if (params == NULL)
+            return false;
+        journal->params = params;
+        journal->params_capacity = capacity;
+    }
+
+    ab_session_journal_params_t *entry = &journal->params[journal->params_count++];
+    entry->id = id;
+    entry->crc = crc;
+    entry->offset = offset;
+    entry->length = length;
+    return true;
+}
+
+// Return true if the stored params entry holds exactly the given params.
+static bool params_equal(const ab_session_journal_t *journal, const ab_session_journal_params_t *entry, uint32_t crc, const void *params, size_t length, uint8_t **stored, size_t *capacity) {
+    if (entry->crc != crc || entry->length != length)
+        return false;
+    if (!reserve(stored, capacity, length) || !read_all(journal->fd, *stored, length, entry->offset))
+        return false;
+    return memcmp(*stored, params, length) == 0;
+}
+
+// Return the id of stored params identical to the given ones, or AB_SESSION_JOURNAL_NO_PARAMS.
+static uint32_t find_copy(const ab_session_journal_t *journal, uint32_t crc, const void *params, size_t length) {
+    uint8_t *stored = NULL;
+    size_t capacity = 0;
+    uint32_t found = AB_SESSION_JOURNAL_NO_PARAMS;
+
+    // Check the most recently used params first, then the rest from newest to oldest
+    const ab_session_journal_params_t *last = find_params(journal, journal->last_params_id);
+    if (last != NULL && params_equal(journal, last, crc, params, length, &stored, &capacity)) {
+        found = last->id;
+    } else {
+        for (size_t i = journal->params_count; i-- > 0; ) {
+            const ab_session_journal_params_t *entry = &journal->params[i];
+            if (entry != last && params_equal(journal, entry, crc, params, length, &stored, &capacity)) {
+                found = entry->id;
+                break;
+            }
+        }
+    }
+
+    free(stored);
+    return found;
+}
+
+// Scan the records from the header onwards, returning the length of the valid prefix.
+static bool replay(ab_session_journal_t *journal, off_t file_length, off_t *valid) {
+    uint8_t record[JOURNAL_RECORD_SIZE];
+    uint8_t *body = NULL;
+    size_t capacity = 0;
+    off_t offset = JOURNAL_HEADER_SIZE;
+
+    while (file_length - offset >= JOURNAL_RECORD_SIZE) {
+        if (!read_all(journal->fd, record, sizeof(record), offset))
+            goto error;
+
+        uint8_t kind = record[4];
+        uint32_t params_id = get_le32(record + 8);
+        uint32_t body_length = get_le32(record + 12);
+
+        if (body_length > JOURNAL_PARAMS_MAX || file_length - offset - JOURNAL_RECORD_SIZE < body_length)
+            break;
+        if (!reserve(&body, &capacity, body_length) || !read_all(journal->fd, body, body_length, offset + JOURNAL_RECORD_SIZE))
+            goto error;
+
+        uint32_t crc = (uint32_t) crc32(crc32(0L, record + 4, JOURNAL_RECORD_SIZE - 4), body, body_length);
+        if (get_le32(record) != crc)
+            break;
+
+        if (kind == JOURNAL_KIND_SESSION) {
+            if (body_length != JOURNAL_SESSION_SIZE)
+                break;
+            if (params_id != AB_SESSION_JOURNAL_NO_PARAMS && find_params(journal, params_id) == NULL)
+                break;
+            journal->count++;
+            journal->last_params_id = params_id;
+        } else if (kind == JOURNAL_KIND_PARAMS) {
+            uint32_t last_id = (journal->params_count > 0) ? journal->params[journal->params_count - 1].id : 0;
+            if (params_id <= last_id || body_length == 0)
+                break;
+            if (!add_params(journal, params_id, (uint32_t) crc32(0L, body, body_length), offset + JOURNAL_RECORD_SIZE, body_length))
+                goto error;
+        } else {
+            break;
+        }
+
+        offset += JOURNAL_RECORD_SIZE + body_length;
+    }
+
+    free(body);
+    *valid = offset;
+    return true;
+
+error:
+    free(body);
+    return false;
+}
+
+bool ab_session_journal_open(ab_session_journal_t *journal, const char *path) {
+    uint8_t header[JOURNAL_HEADER_SIZE];
+    struct stat sb;
+    off_t valid;
+
+    memset(journal, 0, sizeof(*journal));
+    journal->fd = -1;
+
+    if ((journal->path = strdup(path)) == NULL)
+        return false;
+
+    if ((journal->fd = open(path, O_RDWR | O_CREAT | O_APPEND, 0644)) < 0)
+        goto error;
+
+    if (fstat(journal->fd, &sb) != 0)
+        goto error;
+
+    if (sb.st_size >= JOURNAL_HEADER_SIZE && read_all(journal->fd, header, sizeof(header), 0) &&
+        memcmp(header, JOURNAL_MAGIC, 4) == 0 && get_le32(header + 4) == JOURNAL_VERSION)
+    {
+        if (!replay(journal, sb.st_size, &valid))
+            goto error;
+    } else {
+        // New or unreadable; start over
+        encode_header(header);
+        if (ftruncate(journal->fd, 0) != 0 || !write_all(journal->fd, header, sizeof(header)) || fsync(journal->fd) != 0)
+            goto error;
+        valid = sb.st_size = JOURNAL_HEADER_SIZE;
+    }
+
+    // Discard a torn or corrupt tail, so that later records are appended to a valid journal
+    if (valid < sb.st_size && ftruncate(journal->fd, valid) != 0)
+        goto error;
+    journal->length = valid;
+
+    return true;
+
+error:
+    {
+        int err = errno;
+        ab_session_journal_close(journal);
+        errno = err;
+    }
+    return false;
+}
+
+bool ab_session_journal_append(ab_session_journal_t *journal, int64_t started_at, int64_t ended_at, const void *params, size_t params_length) {
+    uint32_t params_id = AB_SESSION_JOURNAL_NO_PARAMS;
+    uint32_t params_crc = 0;
+    size_t params_record_length = 0;
+    uint8_t *buf;
+
+    if (params == NULL)
+        params_length = 0;
+    if (params_length > JOURNAL_PARAMS_MAX) {
+        errno = EINVAL;
+        return false;
+    }
+
+    if (params_length > 0) {
+        params_crc = (uint32_t) crc32(0L, params, (uInt) params_length);
+        params_id = find_copy(journal, params_crc, params, params_length);
+        if (params_id == AB_SESSION_JOURNAL_NO_PARAMS) {
+            params_id = (journal->params_count > 0) ? journal->params[journal->params_count - 1].id + 1 : 1;
+            params_record_length = JOURNAL_RECORD_SIZE + params_length;
+        }
+    }
+
+    // New params and the session are written together, so that a session is never stored without its params
+    if ((buf = malloc(params_record_length + JOURNAL_RECORD_SIZE + JOURNAL_SESSION_SIZE)) == NULL)
+        return false;
+
+    if (params_record_length > 0) {
+        memcpy(buf + JOURNAL_RECORD_SIZE, params, params_length);
+        encode_record(buf, JOURNAL_KIND_PARAMS, params_id, (uint32_t) params_length);
+    }
+
+    uint8_t *session = buf + params_record_length;
+    put_le64(session + JOURNAL_RECORD_SIZE, (uint64_t) started_at);
+    put_le64(session + JOURNAL_RECORD_SIZE + 8, (uint64_t) ended_at);
+    encode_record(session, JOURNAL_KIND_SESSION, params_id, JOURNAL_SESSION_SIZE);
+
+    // Not synced: a session lost to power failure is not worth a flush on every session end
+    size_t length = params_record_length + JOURNAL_RECORD_SIZE + JOURNAL_SESSION_SIZE;
+    if (!write_all(journal->fd, buf, length)) {
+        // Drop any partial record, so that later records remain readable
+        int err = errno;
+        ftruncate(journal->fd, journal->length);
+        free(buf);
+        errno = err;
+        return false;
+    }
+    free(buf);
+
+    if (params_record_length > 0 && !add_params(journal, params_id, params_crc, journal->length + JOURNAL_RECORD_SIZE, (uint32_t) params_length)) {
+        // The journal is valid on disk, but no longer matches what is in memory
+        ftruncate(journal->fd, journal->length);
+        errno = ENOMEM;
+        return false;
+    }
+
+    journal->length += length;
+    journal->count++;
+    journal->last_params_id = params_id;
+    return true;
+}
+
+bool ab_session_journal_read(ab_session_journal_t *journal, ab_session_journal_visitor_t visitor, void *context, off_t *end) {
+    uint8_t record[JOURNAL_RECORD_SIZE + JOURNAL_SESSION_SIZE];
+    uint8_t *params = NULL;
+    size_t capacity = 0;
+    uint32_t loaded_id = AB_SESSION_JOURNAL_NO_PARAMS;
+    off_t offset = JOURNAL_HEADER_SIZE;
+
+    // Records were verified when the journal was opened or appended to
+    while (offset < journal->length) {
+        if (!read_all(journal->fd, record, JOURNAL_RECORD_SIZE, offset))
+            goto error;
+
+        uint32_t params_id = get_le32(record + 8);
+        uint32_t body_length = get_le32(record + 12);
+
+        if (record[4] == JOURNAL_KIND_SESSION) {
+            ab_session_journal_session_t session;
+
+            if (!read_all(journal->fd, record + JOURNAL_RECORD_SIZE, JOURNAL_SESSION_SIZE, offset + JOURNAL_RECORD_SIZE))
+                goto error;
+
+            session.started_at = (int64_t) get_le64(record + JOURNAL_RECORD_SIZE);
+            session.ended_at = (int64_t) get_le64(record + JOURNAL_RECORD_SIZE + 8);
+            session.params_id = params_id;
+            session.params = NULL;
+            session.params_length = 0;
+
+            if (params_id != AB_SESSION_JOURNAL_NO_PARAMS) {
+                const ab_session_journal_params_t *entry = find_params(journal, params_id);
+                if (entry == NULL) {
+                    errno = EINVAL;
+                    goto error;
+                }
+
+                // Consecutive sessions usually share params; load them once
+                if (params_id != loaded_id) {
+                    if (!reserve(&params, &capacity, entry->length) || !read_all(journal->fd, params, entry->length, entry->offset))
+                        goto error;
+                    loaded_id = params_id;
+                }
+                session.params = params;
+                session.params_length = entry->length;
+            }
+
+            offset += JOURNAL_RECORD_SIZE + body_length;
+            if (!visitor(context, &session))
+                break;
+        } else {
+            offset += JOURNAL_RECORD_SIZE + body_length;
+        }
+    }
+
+    free(params);
+    *end = offset;
+    return true;
+
+error:
+    {
+        int err = errno;
+        free(params);
+        errno = err;
+    }
+    return false;
+}
+
+// Rewrite the journal with only the sessions from offset start onwards, and the params they reference.
+static bool compact(ab_session_journal_t *journal, off_t start) {
+    size_t tmp_length = strlen(journal->path) + sizeof(".tmp");
+    char *tmp_path = NULL;
+    bool *live = NULL;
+    uint8_t *buf = NULL;
+    off_t *offsets = NULL;
+    uint8_t record[JOURNAL_RECORD_SIZE];
+    size_t count = 0;
+    off_t length;
+    off_t offset;
+    int fd = -1;
+    int err;
+
+    if ((tmp_path = malloc(tmp_length)) == NULL)
+        goto error;
+    strcpy(tmp_path, journal->path);
+    strcat(tmp_path, ".tmp");
+
+    if ((buf = malloc(JOURNAL_COPY_BUFFER_SIZE)) == NULL)
+        goto error;
+    if (journal->params_count > 0) {
+        if ((live = calloc(journal->params_count, sizeof(*live))) == NULL || (offsets = calloc(journal->params_count, sizeof(*offsets))) == NULL)
+            goto error;
+    }
+
+    // Find the params still referenced
+    for (offset = start; offset < journal->length; offset += JOURNAL_RECORD_SIZE + get_le32(record + 12)) {
+        if (!read_all(journal->fd, record, sizeof(record), offset))
+            goto error;
+        if (record[4] == JOURNAL_KIND_SESSION) {
+            const ab_session_journal_params_t *entry = find_params(journal, get_le32(record + 8));
+            if (entry != NULL)
+                live[entry - journal->params] = true;
+            count++;
+        }
+    }
+
+    if ((fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0)
+        goto error;
+
+    encode_header(buf);
+    if (!write_all(fd, buf, JOURNAL_HEADER_SIZE))
+        goto error;
+    length = JOURNAL_HEADER_SIZE;
+
+    // Params first, then the sessions referring to them; records are copied unchanged
+    for (size_t i = 0; i < journal->params_count; i++) {
+        const ab_session_journal_params_t *entry = &journal->params[i];
+        size_t remaining = JOURNAL_RECORD_SIZE + entry->length;
+
+        if (!live[i])
+            continue;
+
+        offsets[i] = length + JOURNAL_RECORD_SIZE;
+        for (off_t from = entry->offset - JOURNAL_RECORD_SIZE; remaining > 0; ) {
+            size_t chunk = (remaining < JOURNAL_COPY_BUFFER_SIZE) ? remaining : JOURNAL_COPY_BUFFER_SIZE;
+            if (!read_all(journal->fd, buf, chunk, from) || !write_all(fd, buf, chunk))
+                goto error;
+            from += chunk;
+            remaining -= chunk;
+            length += chunk;
+        }
+    }
+
+    for (offset = start; offset < journal->length; offset += JOURNAL_RECORD_SIZE + get_le32(buf + 12)) {
+        if (!read_all(journal->fd, buf, JOURNAL_RECORD_SIZE, offset))
+            goto error;
+        if (buf[4] != JOURNAL_KIND_SESSION)
+            continue;
+        if (!read_all(journal->fd, buf + JOURNAL_RECORD_SIZE, JOURNAL_SESSION_SIZE, offset + JOURNAL_RECORD_SIZE))
+            goto error;
+        if (!write_all(fd, buf, JOURNAL_RECORD_SIZE + JOURNAL_SESSION_SIZE))
+            goto error;
+        length += JOURNAL_RECORD_SIZE + JOURNAL_SESSION_SIZE;
+    }
+
+    if (fsync(fd) != 0)
+        goto error;
+    close(fd);
+    fd = -1;
+
+    if (rename(tmp_path, journal->path) != 0)
+        goto error;
+
+    // Reopen the new journal for appending
+    if ((fd = open(journal->path, O_RDWR | O_APPEND)) < 0)
+        goto error;
+    close(journal->fd);
+    journal->fd = fd;
+    journal->length = length;
+    journal->count = count;
+
+    // Keep only the live params, at their new offsets
+    size_t kept = 0;
+    for (size_t i = 0; i < journal->params_count; i++) {
+        if (!live[i])
+            continue;
+        journal->params[kept] = journal->params[i];
+        journal->params[kept].offset = offsets[i];
+        kept++;
+    }
+    journal->params_count = kept;
+    if (find_params(journal, journal->last_params_id) == NULL)
+        journal->last_params_id = AB_SESSION_JOURNAL_NO_PARAMS;
+
+    free(offsets);
+    free(live);
+    free(buf);
+    free(tmp_path);
+    return true;
+
+error:
+    err = errno;
+    if (fd >= 0)
+        close(fd);
+    if (tmp_path != NULL)
+        unlink(tmp_path);
+    free(offsets);
+    free(live);
+    free(buf);
+    free(tmp_path);
+    errno = err;
+    return false;
+}
+
+bool ab_session_journal_discard(ab_session_journal_t *journal, off_t end) {
+    if (end <= JOURNAL_HEADER_SIZE)
+        return true;
+
+    if (end < journal->length)
+        return compact(journal, end);
+
+    // Everything was read; truncating back to the header is atomic
+    if (ftruncate(journal->fd, JOURNAL_HEADER_SIZE) != 0)
+        return false;
+    journal->length = JOURNAL_HEADER_SIZE;
+    journal->count = 0;
+    journal->params_count = 0;
+    journal->last_params_id = AB_SESSION_JOURNAL_NO_PARAMS;
+    return true;
+}
+
+void ab_session_journal_close(ab_session_journal_t *journal) {
+    if (journal->fd >= 0)
+        close(journal->fd);
+    free(journal->path);
+    free(journal->params);
+    memset(journal, 0, sizeof(*journal));
+    journal->fd = -1;
+}
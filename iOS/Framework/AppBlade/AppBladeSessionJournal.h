@@ -0,0 +1,108 @@
+//
+//  AppBladeSessionJournal.h
+//  AppBlade
+//
+//  Copyright (c) 2013 AppBlade. All rights reserved.
+//
+//  Append-only on-disk journal of the sessions waiting to be uploaded.
+//
+//  The journal is a 16 byte header followed by a log of records. Each session is a fixed size SESSION record;
+//  its custom params are stored once in a PARAMS record and referenced by id, so that sessions sharing the same
+//  params share a single copy. Each record carries a CRC-32, so a record torn by a crash or power loss is
+//  detected and discarded when the journal is reopened. Once sessions have been handed off for upload the
+//  journal is truncated, or, if sessions were logged in the meantime, rewritten with only those sessions and
+//  the params they reference.
+//
+//  All values are little-endian.
+//
+//    header:  "ABSJ"  uint32 version  uint64 reserved
+//    record:  uint32 crc32 of the remainder of the record
+//             uint8 kind  uint8[3] reserved  uint32 params id  uint32 body length  body bytes
+//    SESSION body:  int64 start time  int64 end time, in milliseconds since 1970
+//    PARAMS body:   the params, in a caller-defined encoding
+//
+
+#ifndef APPBLADE_SESSION_JOURNAL_H
+#define APPBLADE_SESSION_JOURNAL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+// Params id of a session without params
+#define AB_SESSION_JOURNAL_NO_PARAMS 0
+
+// A params blob stored in the journal
+typedef struct ab_session_journal_params {
+    // Params id, unique within the journal
+    uint32_t id;
+
+    // CRC-32 of the params, used to find an existing copy
+    uint32_t crc;
+
+    // Offset and length of the params within the journal
+    off_t offset;
+    uint32_t length;
+} ab_session_journal_params_t;
+
+// A session read from the journal
+typedef struct ab_session_journal_session {
+    // Start and end times, in milliseconds since 1970
+    int64_t started_at;
+    int64_t ended_at;
+
+    // Params id, or AB_SESSION_JOURNAL_NO_PARAMS
+    uint32_t params_id;
+
+    // The session's params, valid only for the duration of the callback; NULL if it has none
+    const uint8_t *params;
+    size_t params_length;
+} ab_session_journal_session_t;
+
+// Called for each session in the journal, in the order logged. Return false to stop reading.
+typedef bool (*ab_session_journal_visitor_t)(void *context, const ab_session_journal_session_t *session);
+
+// An open session journal
+typedef struct ab_session_journal {
+    // Journal file descriptor, opened for appending
+    int fd;
+
+    // Journal file path
+    char *path;
+
+    // Length of the valid journal
+    off_t length;
+
+    // Number of sessions in the journal
+    size_t count;
+
+    // Params stored in the journal, in id order
+    ab_session_journal_params_t *params;
+    size_t params_count;
+    size_t params_capacity;
+
+    // Params of the most recently logged session, which usually match the next
+    uint32_t last_params_id;
+} ab_session_journal_t;
+
+// Open the journal at path, creating it if necessary. A torn or corrupt tail is truncated; an unreadable header
+// reinitializes the journal. Returns false and sets errno on failure.
+bool ab_session_journal_open(ab_session_journal_t *journal, const char *path);
+
+// Append a session, storing its params unless an identical copy is already in the journal. params may be NULL
+// if the session has none. Returns false and sets errno on failure.
+bool ab_session_journal_append(ab_session_journal_t *journal, int64_t started_at, int64_t ended_at, const void *params, size_t params_length);
+
+// Read the sessions in the journal, passing each to visitor. On success end is set to the journal offset up to
+// which sessions were read, to be passed to ab_session_journal_discard(). Returns false and sets errno on failure.
+bool ab_session_journal_read(ab_session_journal_t *journal, ab_session_journal_visitor_t visitor, void *context, off_t *end);
+
+// Discard the sessions before end, as returned by ab_session_journal_read(), compacting the journal. Returns
+// false and sets errno on failure, leaving the journal unchanged.
+bool ab_session_journal_discard(ab_session_journal_t *journal, off_t end);
+
+// Close the journal and free its storage.
+void ab_session_journal_close(ab_session_journal_t *journal);
+
+#endif
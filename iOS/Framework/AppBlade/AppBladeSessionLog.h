@@ -0,0 +1,33 @@
+//
+//  AppBladeSessionLog.h
+//  AppBlade
+//
+//  Copyright (c) 2013 AppBlade. All rights reserved.
+//
+//  Log of the sessions waiting to be uploaded, kept in an append-only journal (see AppBladeSessionJournal.h).
+//  Logging a session appends a fixed size record, however many sessions are already logged, and custom params
+//  are stored once for all the sessions that share them.
+//
+
+#import <Foundation/Foundation.h>
+
+@interface AppBladeSessionLog : NSObject
+
+// Opens the log at path, creating it if necessary.
+- (id)initWithPath:(NSString *)path;
+
+// Appends a session. customParams may be nil.
+- (BOOL)logSessionStartedAt:(NSDate *)startedAt endedAt:(NSDate *)endedAt customParams:(NSDictionary *)customParams;
+
+// Passes each logged session to block, oldest first, as a dictionary with started_at, ended_at and (if it has
+// any) custom_params keys; consecutive sessions with the same params share one dictionary. On success marker is set to
+// the point reached, to be passed to -discardSessionsThroughMarker: once the sessions are safely stored elsewhere.
+- (BOOL)enumerateSessionsUsingBlock:(void (^)(NSDictionary *session, BOOL *stop))block marker:(unsigned long long *)marker;
+
+// Removes the sessions enumerated up to marker, compacting the log.
+- (BOOL)discardSessionsThroughMarker:(unsigned long long)marker;
+
+// Number of logged sessions.
+- (NSUInteger)count;
+
+@end
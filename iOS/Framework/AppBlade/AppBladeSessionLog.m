@@ -0,0 +1,164 @@
+//
+//  AppBladeSessionLog.m
+//  AppBlade
+//
+//  Copyright (c) 2013 AppBlade. All rights reserved.
+//
+
+#import "AppBladeSessionLog.h"
+#import "AppBladeLogging.h"
+
+#include <math.h>
+#include "AppBladeSessionJournal.h"
+
+static NSString* const kAppBladeSessionKeyStartedAt    = @"started_at";
+static NSString* const kAppBladeSessionKeyEndedAt      = @"ended_at";
+static NSString* const kAppBladeSessionKeyCustomParams = @"custom_params";
+
+@interface AppBladeSessionLog ()
+{
+    ab_session_journal_t _journal;
+}
+
+// State of the enumeration in progress
+@property (nonatomic, copy) void (^enumerationBlock)(NSDictionary *session, BOOL *stop);
+@property (nonatomic, strong) NSDictionary *enumerationParams;
+@property (nonatomic, assign) uint32_t enumerationParamsId;
+
+- (BOOL)visitSession:(const ab_session_journal_session_t *)session;
+
+@end
+
+// Journal visitor, forwarding to the log enumerating it
+static bool visit_session(void *context, const ab_session_journal_session_t *session) {
+    return [(__bridge AppBladeSessionLog *)context visitSession:session];
+}
+
+static int64_t milliseconds_since_1970(NSDate *date) {
+    return (int64_t) llround([date timeIntervalSince1970] * 1000.0);
+}
+
+@implementation AppBladeSessionLog
+
+#pragma mark - Lifecycle
+
+- (id)initWithPath:(NSString *)path
+{
+    if((self = [super init])) {
+        if (!ab_session_journal_open(&_journal, [path fileSystemRepresentation])) {
+            ABErrorLog(@"Error opening session journal %@: %s", path, strerror(errno));
+            return nil;
+        }
+        ABDebugLog_internal(@"Session journal has %d sessions", [self count]);
+    }
+
+    return self;
+}
+
+- (void)dealloc
+{
+    // Not opened if initialization failed
+    if (_journal.path != NULL) {
+        ab_session_journal_close(&_journal);
+    }
+}
+
+#pragma mark - Sessions
+
+- (BOOL)logSessionStartedAt:(NSDate *)startedAt endedAt:(NSDate *)endedAt customParams:(NSDictionary *)customParams
+{
+    @synchronized (self) {
+        NSData *params = nil;
+        if ([customParams count] > 0) {
+            NSError *error = nil;
+            params = [NSPropertyListSerialization dataWithPropertyList:customParams format:NSPropertyListBinaryFormat_v1_0 options:0 error:&error];
+            if (params == nil) {
+                ABErrorLog(@"Error encoding session custom params, logging the session without them: %@", error);
+            }
+        }
+
+        if (!ab_session_journal_append(&_journal, milliseconds_since_1970(startedAt), milliseconds_since_1970(endedAt), [params bytes], [params length])) {
+            ABErrorLog(@"Error logging session: %s", strerror(errno));
+            return NO;
+        }
+        return YES;
+    }
+}
+
+- (BOOL)enumerateSessionsUsingBlock:(void (^)(NSDictionary *session, BOOL *stop))block marker:(unsigned long long *)marker
+{
+    @synchronized (self) {
+        self.enumerationBlock = block;
+        self.enumerationParams = nil;
+        self.enumerationParamsId = AB_SESSION_JOURNAL_NO_PARAMS;
+
+        off_t end = 0;
+        BOOL success = ab_session_journal_read(&_journal, visit_session, (__bridge void *)self, &end);
+        if (!success) {
+            ABErrorLog(@"Error reading session journal: %s", strerror(errno));
+        }
+        else if (marker != NULL) {
+            *marker = (unsigned long long)end;
+        }
+
+        self.enumerationBlock = nil;
+        self.enumerationParams = nil;
+        return success;
+    }
+}
+
+- (BOOL)discardSessionsThroughMarker:(unsigned long long)marker
+{
+    @synchronized (self) {
+        if (!ab_session_journal_discard(&_journal, (off_t)marker)) {
+            ABErrorLog(@"Error discarding logged sessions: %s", strerror(errno));
+            return NO;
+        }
+        return YES;
+    }
+}
+
+- (NSUInteger)count
+{
+    @synchronized (self) {
+        return _journal.count;
+    }
+}
+
+#pragma mark - Helper Methods
+
+- (BOOL)visitSession:(const ab_session_journal_session_t *)session
+{
+    @autoreleasepool {
+        NSMutableDictionary *sessionDict = [NSMutableDictionary dictionaryWithCapacity:3];
+        [sessionDict setObject:[NSDate dateWithTimeIntervalSince1970:session->started_at / 1000.0] forKey:kAppBladeSessionKeyStartedAt];
+        [sessionDict setObject:[NSDate dateWithTimeIntervalSince1970:session->ended_at / 1000.0] forKey:kAppBladeSessionKeyEndedAt];
+
+        // Decode each params blob once for the run of sessions sharing it
+        if (session->params_id != self.enumerationParamsId) {
+            self.enumerationParamsId = session->params_id;
+            self.enumerationParams = nil;
+            if (session->params != NULL) {
+                NSData *data = [NSData dataWithBytesNoCopy:(void *)session->params length:session->params_length freeWhenDone:NO];
+                NSError *error = nil;
+                id params = [NSPropertyListSerialization propertyListWithData:data options:NSPropertyListImmutable format:NULL error:&error];
+                if ([params isKindOfClass:[NSDictionary class]]) {
+                    self.enumerationParams = params;
+                }
+                else
+                {
+                    ABErrorLog(@"Error decoding session custom params: %@", error);
+                }
+            }
+        }
+        if (self.enumerationParams) {
+            [sessionDict setObject:self.enumerationParams forKey:kAppBladeSessionKeyCustomParams];
+        }
+
+        BOOL stop = NO;
+        self.enumerationBlock(sessionDict, &stop);
+        return !stop;
+    }
+}
+
+@end
@@ -0,0 +1,411 @@
+//
+//  AppBladeUploadIndex.c
+//  AppBlade
+//
+//  Copyright (c) 2013 AppBlade. All rights reserved.
+//
+
+#include "AppBladeUploadIndex.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <zlib.h>
+
+#define INDEX_MAGIC "ABUQ"
+#define INDEX_VERSION 1
+#define INDEX_HEADER_SIZE 16
+
+// Size of a record, excluding its name
+#define INDEX_RECORD_SIZE 28
+
+#define INDEX_OP_ADD 1
+#define INDEX_OP_ACK 2
+
+// Minimum number of dead records before the log is compacted
+#define INDEX_COMPACT_MIN_DEAD 32
+
+static void put_le16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t) v;
+    p[1] = (uint8_t) (v >> 8);
+}
+
+static void put_le32(uint8_t *p, uint32_t v) {
+    put_le16(p, (uint16_t) v);
+    put_le16(p + 2, (uint16_t) (v >> 16));
+}
+
+static void put_le64(uint8_t *p, uint64_t v) {
+    put_le32(p, (uint32_t) v);
+    put_le32(p + 4, (uint32_t) (v >> 32));
+}
+
+static uint16_t get_le16(const uint8_t *p) {
+    return (uint16_t) (p[0] | (p[1] << 8));
+}
+
+static uint32_t get_le32(const uint8_t *p) {
+    return get_le16(p) | ((uint32_t) get_le16(p + 2) << 16);
+}
+
+static uint64_t get_le64(const uint8_t *p) {
+    return get_le32(p) | ((uint64_t) get_le32(p + 4) << 32);
+}
+
+// Write all of buf to fd, retrying on EINTR and short writes.
+static bool write_all(int fd, const uint8_t *buf, size_t length) {
+    while (length > 0) {
+        ssize_t written = write(fd, buf, length);
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        buf += written;
+        length -= (size_t) written;
+    }
+    return true;
+}
+
+static void encode_header(uint8_t *buf, uint64_t next_id) {
+    memcpy(buf, INDEX_MAGIC, 4);
+    put_le32(buf + 4, INDEX_VERSION);
+    put_le64(buf + 8, next_id);
+}
+
+// Encode a record into buf, which must hold INDEX_RECORD_SIZE + AB_UPLOAD_INDEX_NAME_MAX bytes. Returns the
+// record length.
+static size_t encode_record(uint8_t *buf, uint8_t op, uint8_t type, uint64_t id, uint64_t size, const char *name) {
+    size_t name_length = (name != NULL) ? strlen(name) : 0;
+
+    buf[4] = op;
+    buf[5] = type;
+    put_le16(buf + 6, (uint16_t) name_length);
+    put_le32(buf + 8, 0);
+    put_le64(buf + 12, id);
+    put_le64(buf + 20, size);
+    if (name_length > 0)
+        memcpy(buf + INDEX_RECORD_SIZE, name, name_length);
+    put_le32(buf, (uint32_t) crc32(0L, buf + 4, (uInt) (INDEX_RECORD_SIZE - 4 + name_length)));
+
+    return INDEX_RECORD_SIZE + name_length;
+}
+
+// Return the position at which an item with the given id is, or would be inserted.
+static size_t item_position(const ab_upload_index_t *index, uint64_t id) {
+    size_t lo = 0, hi = index->count;
+
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (index->items[mid].id < id)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+// Insert a pending item, keeping the items in id order. Returns false if the id is already pending.
+static bool insert_item(ab_upload_index_t *index, uint64_t id, uint8_t type, uint64_t size, const char *name, size_t name_length) {
+    size_t pos = item_position(index, id);
+
+    if (pos < index->count && index->items[pos].id == id)
+        return false;
+
+    if (index->count == index->capacity) {
+        size_t capacity = (index->capacity == 0) ? 16 : index->capacity * 2;
+        ab_upload_index_item_t *items = realloc(index->items, capacity * sizeof(*items));
+        if (items == NULL)
+            return false;
+        index->items = items;
+        index->capacity = capacity;
+    }
+
+    memmove(&index->items[pos + 1], &index->items[pos], (index->count - pos) * sizeof(*index->items));
+    index->items[pos].id = id;
+    index->items[pos].type = type;
+    index->items[pos].size = size;
+    memcpy(index->items[pos].name, name, name_length);
+    index->items[pos].name[name_length] = '\0';
+    index->count++;
+
+    if (id >= index->next_id)
+        index->next_id = id + 1;
+    return true;
+}
+
+// Remove a pending item. Returns false if the id is not pending.
+static bool remove_item(ab_upload_index_t *index, uint64_t id) {
+    size_t pos = item_position(index, id);
+
+    if (pos == index->count || index->items[pos].id != id)
+        return false;
+
+    memmove(&index->items[pos], &index->items[pos + 1], (index->count - pos - 1) * sizeof(*index->items));
+    index->count--;
+    return true;
+}
+
+// Replay the records in buf, returning the length of the valid prefix.
+static size_t replay(ab_upload_index_t *index, const uint8_t *buf, size_t length) {
+    size_t offset = INDEX_HEADER_SIZE;
+
+    while (length - offset >= INDEX_RECORD_SIZE) {
+        const uint8_t *record = buf + offset;
+        uint8_t op = record[4];
+        size_t name_length = get_le16(record + 6);
+        uint64_t id = get_le64(record + 12);
+
+        if (name_length > AB_UPLOAD_INDEX_NAME_MAX || length - offset - INDEX_RECORD_SIZE < name_length)
+            break;
+        if (get_le32(record) != (uint32_t) crc32(0L, record + 4, (uInt) (INDEX_RECORD_SIZE - 4 + name_length)))
+            break;
+
+        if (op == INDEX_OP_ADD) {
+            if (name_length == 0)
+                break;
+            if (!insert_item(index, id, record[5], get_le64(record + 20), (const char *) record + INDEX_RECORD_SIZE, name_length))
+                index->dead++;
+        } else if (op == INDEX_OP_ACK) {
+            // The ACK and its ADD are both dead; an ACK without a pending ADD is dead alone
+            index->dead += remove_item(index, id) ? 2 : 1;
+        } else {
+            break;
+        }
+
+        offset += INDEX_RECORD_SIZE + name_length;
+    }
+
+    return offset;
+}
+
+// Read the whole of the file open at fd.
+static uint8_t *read_file(int fd, size_t *length) {
+    struct stat sb;
+    uint8_t *buf;
+    size_t offset = 0;
+
+    if (fstat(fd, &sb) != 0)
+        return NULL;
+
+    if ((buf = malloc((size_t) sb.st_size + 1)) == NULL)
+        return NULL;
+
+    while (offset < (size_t) sb.st_size) {
+        ssize_t n = pread(fd, buf + offset, (size_t) sb.st_size - offset, (off_t) offset);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        offset += (size_t) n;
+    }
+
+    *length = offset;
+    return buf;
+}
+
+bool ab_upload_index_open(ab_upload_index_t *index, const char *path) {
+    uint8_t *buf;
+    size_t length;
+    size_t valid;
+
+    memset(index, 0, sizeof(*index));
+    index->fd = -1;
+    index->next_id = 1;
+
+    if ((index->path = strdup(path)) == NULL)
+        return false;
+
+    if ((index->fd = open(path, O_RDWR | O_CREAT | O_APPEND, 0644)) < 0)
+        goto error;
+
+    if ((buf = read_file(index->fd, &length)) == NULL)
+        goto error;
+
+    if (length >= INDEX_HEADER_SIZE && memcmp(buf, INDEX_MAGIC, 4) == 0 && get_le32(buf + 4) == INDEX_VERSION) {
+        index->next_id = get_le64(buf + 8);
+        valid = replay(index, buf, length);
+    } else {
+        // New or unreadable; start over
+        uint8_t header[INDEX_HEADER_SIZE];
+
+        encode_header(header, index->next_id);
+        if (ftruncate(index->fd, 0) != 0 || !write_all(index->fd, header, sizeof(header)) || fsync(index->fd) != 0) {
+            free(buf);
+            goto error;
+        }
+        valid = length = INDEX_HEADER_SIZE;
+    }
+    free(buf);
+
+    // Discard a torn or corrupt tail, so that later records are appended to a valid log
+    if (valid < length && ftruncate(index->fd, (off_t) valid) != 0)
+        goto error;
+
+    return true;
+
+error:
+    {
+        int err = errno;
+        ab_upload_index_close(index);
+        errno = err;
+    }
+    return false;
+}
+
+uint64_t ab_upload_index_reserve_id(ab_upload_index_t *index) {
+    return index->next_id++;
+}
+
+bool ab_upload_index_add(ab_upload_index_t *index, uint64_t id, uint8_t type, const char *name, uint64_t size) {
+    uint8_t record[INDEX_RECORD_SIZE + AB_UPLOAD_INDEX_NAME_MAX];
+    size_t name_length = strlen(name);
+    size_t record_length;
+    struct stat sb;
+
+    if (name_length == 0 || name_length > AB_UPLOAD_INDEX_NAME_MAX || ab_upload_index_find(index, id) != NULL) {
+        errno = EINVAL;
+        return false;
+    }
+
+    if (fstat(index->fd, &sb) != 0)
+        return false;
+
+    record_length = encode_record(record, INDEX_OP_ADD, type, id, size, name);
+    if (!write_all(index->fd, record, record_length) || fsync(index->fd) != 0) {
+        // Drop any partial record, so that later records remain readable
+        int err = errno;
+        ftruncate(index->fd, sb.st_size);
+        errno = err;
+        return false;
+    }
+
+    if (!insert_item(index, id, type, size, name, name_length)) {
+        errno = ENOMEM;
+        return false;
+    }
+    return true;
+}
+
+bool ab_upload_index_ack(ab_upload_index_t *index, uint64_t id) {
+    uint8_t record[INDEX_RECORD_SIZE];
+    size_t record_length;
+    struct stat sb;
+
+    if (ab_upload_index_find(index, id) == NULL)
+        return true;
+
+    if (fstat(index->fd, &sb) != 0)
+        return false;
+
+    // Not synced: if the ACK is lost the item is offered again, and the caller has already removed its payload
+    record_length = encode_record(record, INDEX_OP_ACK, 0, id, 0, NULL);
+    if (!write_all(index->fd, record, record_length)) {
+        int err = errno;
+        ftruncate(index->fd, sb.st_size);
+        errno = err;
+        return false;
+    }
+
+    remove_item(index, id);
+    index->dead += 2;
+
+    // Compaction failure leaves a valid, if longer, log
+    if (index->dead >= INDEX_COMPACT_MIN_DEAD && index->dead > index->count)
+        ab_upload_index_compact(index);
+
+    return true;
+}
+
+const ab_upload_index_item_t *ab_upload_index_find(const ab_upload_index_t *index, uint64_t id) {
+    size_t pos = item_position(index, id);
+
+    if (pos == index->count || index->items[pos].id != id)
+        return NULL;
+    return &index->items[pos];
+}
+
+size_t ab_upload_index_batch(const ab_upload_index_t *index, size_t max_items, uint64_t max_bytes) {
+    uint64_t bytes = 0;
+    size_t n;
+
+    for (n = 0; n < index->count && n < max_items; n++) {
+        if (n > 0 && bytes + index->items[n].size > max_bytes)
+            break;
+        bytes += index->items[n].size;
+    }
+
+    return n;
+}
+
+bool ab_upload_index_compact(ab_upload_index_t *index) {
+    size_t tmp_length = strlen(index->path) + sizeof(".tmp");
+    char *tmp_path;
+    uint8_t *buf;
+    size_t length;
+    int fd = -1;
+    int err;
+
+    // Header and records, as written
+    if ((buf = malloc(INDEX_HEADER_SIZE + index->count * (INDEX_RECORD_SIZE + AB_UPLOAD_INDEX_NAME_MAX))) == NULL)
+        return false;
+
+    if ((tmp_path = malloc(tmp_length)) == NULL) {
+        free(buf);
+        return false;
+    }
+    strcpy(tmp_path, index->path);
+    strcat(tmp_path, ".tmp");
+
+    encode_header(buf, index->next_id);
+    length = INDEX_HEADER_SIZE;
+    for (size_t i = 0; i < index->count; i++) {
+        const ab_upload_index_item_t *item = &index->items[i];
+        length += encode_record(buf + length, INDEX_OP_ADD, item->type, item->id, item->size, item->name);
+    }
+
+    if ((fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0)
+        goto error;
+    if (!write_all(fd, buf, length) || fsync(fd) != 0)
+        goto error;
+    close(fd);
+    fd = -1;
+
+    if (rename(tmp_path, index->path) != 0)
+        goto error;
+
+    // Reopen the new log for appending
+    if ((fd = open(index->path, O_RDWR | O_APPEND)) < 0)
+        goto error;
+    close(index->fd);
+    index->fd = fd;
+    index->dead = 0;
+
+    free(tmp_path);
+    free(buf);
+    return true;
+
+error:
+    err = errno;
+    if (fd >= 0)
+        close(fd);
+    unlink(tmp_path);
+    free(tmp_path);
+    free(buf);
+    errno = err;
+    return false;
+}
+
+void ab_upload_index_close(ab_upload_index_t *index) {
+    if (index->fd >= 0)
+        close(index->fd);
+    free(index->path);
+    free(index->items);
+    memset(index, 0, sizeof(*index));
+    index->fd = -1;
+}
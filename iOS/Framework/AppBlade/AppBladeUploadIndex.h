@@ -0,0 +1,95 @@
+//
+//  AppBladeUploadIndex.h
+//  AppBlade
+//
+//  Copyright (c) 2013 AppBlade. All rights reserved.
+//
+//  Append-only on-disk index of the items waiting in the upload queue.
+//
+//  The index is a 16 byte header followed by a log of records. Adding an item appends an ADD record and
+//  acknowledging it appends an ACK record; the pending items are those with an ADD but no ACK. Each record
+//  carries a CRC-32, so a record torn by a crash or power loss is detected and discarded when the index is
+//  reopened. Once acknowledged records outnumber the pending ones the log is compacted by rewriting it with
+//  only the pending items and atomically renaming it into place.
+//
+//  All values are little-endian.
+//
+//    header:  "ABUQ"  uint32 version  uint64 first unused item id
+//    record:  uint32 crc32 of the remainder of the record
+//             uint8 op  uint8 type  uint16 name length  uint32 reserved
+//             uint64 item id  uint64 payload size  name bytes
+//
+
+#ifndef APPBLADE_UPLOAD_INDEX_H
+#define APPBLADE_UPLOAD_INDEX_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Maximum length of an item's payload file name, excluding the terminating NUL
+#define AB_UPLOAD_INDEX_NAME_MAX 63
+
+// An item in the upload queue
+typedef struct ab_upload_index_item {
+    // Unique, increasing item identifier
+    uint64_t id;
+
+    // Caller-defined item type
+    uint8_t type;
+
+    // Payload size in bytes
+    uint64_t size;
+
+    // Payload file name, relative to the queue directory
+    char name[AB_UPLOAD_INDEX_NAME_MAX + 1];
+} ab_upload_index_item_t;
+
+// An open upload index
+typedef struct ab_upload_index {
+    // Index file descriptor, opened for appending
+    int fd;
+
+    // Index file path
+    char *path;
+
+    // Next item id to be handed out
+    uint64_t next_id;
+
+    // Pending items, in id order
+    ab_upload_index_item_t *items;
+    size_t count;
+    size_t capacity;
+
+    // Number of records in the log that no longer describe a pending item
+    size_t dead;
+} ab_upload_index_t;
+
+// Open the index at path, creating it if necessary, and replay it to find the pending items. A torn or corrupt
+// tail is truncated; an unreadable header reinitializes the index. Returns false and sets errno on failure.
+bool ab_upload_index_open(ab_upload_index_t *index, const char *path);
+
+// Reserve an item id, to name the item's payload file before it is added.
+uint64_t ab_upload_index_reserve_id(ab_upload_index_t *index);
+
+// Durably record a pending item. Returns false and sets errno on failure.
+bool ab_upload_index_add(ab_upload_index_t *index, uint64_t id, uint8_t type, const char *name, uint64_t size);
+
+// Record that an item has been delivered, compacting the log if worthwhile. Acknowledging an unknown id
+// succeeds without effect. Returns false and sets errno on failure.
+bool ab_upload_index_ack(ab_upload_index_t *index, uint64_t id);
+
+// Return the pending item with the given id, or NULL.
+const ab_upload_index_item_t *ab_upload_index_find(const ab_upload_index_t *index, uint64_t id);
+
+// Return the number of leading pending items that together hold at most max_bytes of payload, capped at
+// max_items. At least one item is selected whenever any are pending, whatever its size.
+size_t ab_upload_index_batch(const ab_upload_index_t *index, size_t max_items, uint64_t max_bytes);
+
+// Rewrite the log with only the pending items. Returns false and sets errno on failure.
+bool ab_upload_index_compact(ab_upload_index_t *index);
+
+// Close the index and free its storage.
+void ab_upload_index_close(ab_upload_index_t *index);
+
+#endif
@@ -0,0 +1,52 @@
+//
+//  AppBladeUploadQueue.h
+//  AppBlade
+//
+//  Copyright (c) 2013 AppBlade. All rights reserved.
+//
+//  Persistent queue of crash reports, feedback and sessions waiting to be uploaded. Each item's payload is a
+//  file in the queue directory; the pending items are tracked in an append-only index (see AppBladeUploadIndex.h),
+//  so that items survive termination and are uploaded in batches until the server acknowledges them.
+//
+
+#import <Foundation/Foundation.h>
+
+typedef enum {
+    AppBladeUploadItemCrashReport = 1,
+    AppBladeUploadItemFeedback,
+    AppBladeUploadItemSessions
+} AppBladeUploadItemType;
+
+@interface AppBladeUploadItem : NSObject
+
+@property (nonatomic, readonly) uint64_t identifier;
+@property (nonatomic, readonly) AppBladeUploadItemType type;
+@property (nonatomic, readonly, strong) NSString *path;
+@property (nonatomic, readonly) unsigned long long size;
+
+@end
+
+@interface AppBladeUploadQueue : NSObject
+
+@property (nonatomic, readonly, strong) NSString *directory;
+
+// Opens the queue in directory, creating it if necessary.
+- (id)initWithDirectory:(NSString *)directory;
+
+// Adds an item whose payload is data. The payload file takes the given extension.
+- (BOOL)enqueueData:(NSData *)data type:(AppBladeUploadItemType)type extension:(NSString *)extension;
+
+// Adds an item by moving the file at path into the queue, keeping its extension.
+- (BOOL)enqueueFileAtPath:(NSString *)path type:(AppBladeUploadItemType)type;
+
+// Returns the oldest pending items, up to maxItems of them and maxBytes of payload. The first item is always
+// returned, whatever its size. Items whose payload has gone missing are dropped.
+- (NSArray *)nextBatchWithMaxItems:(NSUInteger)maxItems maxBytes:(unsigned long long)maxBytes;
+
+// Removes an item, once the server has acknowledged (or permanently rejected) it.
+- (void)acknowledgeItem:(AppBladeUploadItem *)item;
+
+// Number of pending items.
+- (NSUInteger)count;
+
+@end
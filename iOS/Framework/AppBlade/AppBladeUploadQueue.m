@@ -0,0 +1,235 @@
+//
+//  AppBladeUploadQueue.m
+//  AppBlade
+//
+//  Copyright (c) 2013 AppBlade. All rights reserved.
+//
+
+#import "AppBladeUploadQueue.h"
+#import "AppBladeLogging.h"
+
+#include "AppBladeUploadIndex.h"
+
+static NSString* const kAppBladeUploadIndexFileName = @"queue.idx";
+
+@interface AppBladeUploadItem ()
+
+@property (nonatomic, readwrite) uint64_t identifier;
+@property (nonatomic, readwrite) AppBladeUploadItemType type;
+@property (nonatomic, readwrite, strong) NSString *path;
+@property (nonatomic, readwrite) unsigned long long size;
+
+@end
+
+@implementation AppBladeUploadItem
+
+- (NSString *)description
+{
+    return [NSString stringWithFormat:@"<%@ %llu type %d: %@ (%llu bytes)>", [self class], self.identifier, self.type, [self.path lastPathComponent], self.size];
+}
+
+@end
+
+
+@interface AppBladeUploadQueue ()
+{
+    ab_upload_index_t _index;
+}
+
+@property (nonatomic, readwrite, strong) NSString *directory;
+
+- (AppBladeUploadItemType)typeForExtension:(NSString *)extension;
+- (void)enqueueOrphanedFiles;
+- (BOOL)addItemNamed:(NSString *)fileName identifier:(uint64_t)identifier type:(AppBladeUploadItemType)type;
+
+@end
+
+@implementation AppBladeUploadQueue
+
+#pragma mark - Lifecycle
+
+- (id)initWithDirectory:(NSString *)directory
+{
+    if((self = [super init])) {
+        self.directory = directory;
+
+        NSError *error = nil;
+        if (![[NSFileManager defaultManager] createDirectoryAtPath:directory withIntermediateDirectories:YES attributes:nil error:&error]) {
+            ABErrorLog(@"Error creating upload queue directory %@", error);
+            return nil;
+        }
+
+        NSString *indexPath = [directory stringByAppendingPathComponent:kAppBladeUploadIndexFileName];
+        if (!ab_upload_index_open(&_index, [indexPath fileSystemRepresentation])) {
+            ABErrorLog(@"Error opening upload queue index %@: %s", indexPath, strerror(errno));
+            return nil;
+        }
+
+        [self enqueueOrphanedFiles];
+        ABDebugLog_internal(@"Upload queue has %d pending items", [self count]);
+    }
+
+    return self;
+}
+
+- (void)dealloc
+{
+    // Not opened if initialization failed
+    if (_index.path != NULL) {
+        ab_upload_index_close(&_index);
+    }
+}
+
+#pragma mark - Queue
+
+- (BOOL)enqueueData:(NSData *)data type:(AppBladeUploadItemType)type extension:(NSString *)extension
+{
+    @synchronized (self) {
+        uint64_t identifier = ab_upload_index_reserve_id(&_index);
+        NSString *fileName = [[NSString stringWithFormat:@"%llu", identifier] stringByAppendingPathExtension:extension];
+        NSString *filePath = [self.directory stringByAppendingPathComponent:fileName];
+
+        NSError *error = nil;
+        if (![data writeToFile:filePath options:NSDataWritingAtomic error:&error]) {
+            ABErrorLog(@"Error writing upload queue item %@: %@", filePath, error);
+            return NO;
+        }
+
+        if (![self addItemNamed:fileName identifier:identifier type:type]) {
+            [[NSFileManager defaultManager] removeItemAtPath:filePath error:nil];
+            return NO;
+        }
+        return YES;
+    }
+}
+
+- (BOOL)enqueueFileAtPath:(NSString *)path type:(AppBladeUploadItemType)type
+{
+    @synchronized (self) {
+        uint64_t identifier = ab_upload_index_reserve_id(&_index);
+        NSString *fileName = [[NSString stringWithFormat:@"%llu", identifier] stringByAppendingPathExtension:[path pathExtension]];
+        NSString *filePath = [self.directory stringByAppendingPathComponent:fileName];
+
+        NSError *error = nil;
+        if (![[NSFileManager defaultManager] moveItemAtPath:path toPath:filePath error:&error]) {
+            ABErrorLog(@"Error moving %@ to the upload queue: %@", path, error);
+            return NO;
+        }
+
+        // On failure the file stays in the queue directory, and is picked up when the queue is next opened
+        return [self addItemNamed:fileName identifier:identifier type:type];
+    }
+}
+
+- (NSArray *)nextBatchWithMaxItems:(NSUInteger)maxItems maxBytes:(unsigned long long)maxBytes
+{
+    @synchronized (self) {
+        NSMutableArray *batch = [NSMutableArray array];
+        BOOL droppedItems = NO;
+
+        do {
+            [batch removeAllObjects];
+            droppedItems = NO;
+
+            size_t count = ab_upload_index_batch(&_index, maxItems, maxBytes);
+            NSMutableArray *missing = [NSMutableArray array];
+            for (size_t i = 0; i < count; i++) {
+                const ab_upload_index_item_t *entry = &_index.items[i];
+                AppBladeUploadItem *item = [[AppBladeUploadItem alloc] init];
+                item.identifier = entry->id;
+                item.type = (AppBladeUploadItemType)entry->type;
+                item.path = [self.directory stringByAppendingPathComponent:[NSString stringWithUTF8String:entry->name]];
+                item.size = entry->size;
+
+                if ([[NSFileManager defaultManager] fileExistsAtPath:item.path]) {
+                    [batch addObject:item];
+                }
+                else {
+                    [missing addObject:item];
+                }
+            }
+
+            // Acknowledge outside the loop above, as it may compact the index
+            for (AppBladeUploadItem *item in missing) {
+                ABErrorLog(@"Upload queue item %@ is missing its payload, dropping it", item);
+                ab_upload_index_ack(&_index, item.identifier);
+                droppedItems = YES;
+            }
+        } while (droppedItems && _index.count > 0);
+
+        return batch;
+    }
+}
+
+- (void)acknowledgeItem:(AppBladeUploadItem *)item
+{
+    @synchronized (self) {
+        // Remove the payload first: if the acknowledgement is lost, the item is dropped as missing rather than resent
+        NSError *error = nil;
+        if (![[NSFileManager defaultManager] removeItemAtPath:item.path error:&error]) {
+            ABErrorLog(@"Error removing upload queue item %@: %@", item.path, error);
+        }
+
+        if (!ab_upload_index_ack(&_index, item.identifier)) {
+            ABErrorLog(@"Error acknowledging upload queue item %@: %s", item, strerror(errno));
+        }
+    }
+}
+
+- (NSUInteger)count
+{
+    @synchronized (self) {
+        return _index.count;
+    }
+}
+
+#pragma mark - Helper Methods
+
+- (AppBladeUploadItemType)typeForExtension:(NSString *)extension
+{
+    if ([extension isEqualToString:@"txt"] || [extension isEqualToString:@"plcrash"]) {
+        return AppBladeUploadItemCrashReport;
+    }
+    else if ([extension isEqualToString:@"feedback"]) {
+        return AppBladeUploadItemFeedback;
+    }
+    else if ([extension isEqualToString:@"sessions"]) {
+        return AppBladeUploadItemSessions;
+    }
+    return 0;
+}
+
+// Payload files written or moved in without a matching index entry, because the app was terminated (or the
+// index write failed) in between, were never uploaded; add them back.
+- (void)enqueueOrphanedFiles
+{
+    NSMutableSet *pendingNames = [NSMutableSet setWithCapacity:_index.count];
+    for (size_t i = 0; i < _index.count; i++) {
+        [pendingNames addObject:[NSString stringWithUTF8String:_index.items[i].name]];
+    }
+
+    NSArray *fileNames = [[NSFileManager defaultManager] contentsOfDirectoryAtPath:self.directory error:nil];
+    for (NSString *fileName in [fileNames sortedArrayUsingSelector:@selector(compare:)]) {
+        AppBladeUploadItemType type = [self typeForExtension:[fileName pathExtension]];
+        if (type == 0 || [pendingNames containsObject:fileName]) {
+            continue;
+        }
+
+        ABDebugLog_internal(@"Re-queueing orphaned upload %@", fileName);
+        [self addItemNamed:fileName identifier:ab_upload_index_reserve_id(&_index) type:type];
+    }
+}
+
+- (BOOL)addItemNamed:(NSString *)fileName identifier:(uint64_t)identifier type:(AppBladeUploadItemType)type
+{
+    NSString *filePath = [self.directory stringByAppendingPathComponent:fileName];
+    NSDictionary *attributes = [[NSFileManager defaultManager] attributesOfItemAtPath:filePath error:nil];
+
+    if (!ab_upload_index_add(&_index, identifier, (uint8_t)type, [fileName UTF8String], [attributes fileSize])) {
+        ABErrorLog(@"Error adding %@ to the upload queue index: %s", fileName, strerror(errno));
+        return NO;
+    }
+    return YES;
+}
+
+@end
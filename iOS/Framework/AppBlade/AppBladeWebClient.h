@@ -10,6 +10,7 @@
 #import <UIKit/UIKit.h>
 
 @class AppBladeWebClient;
+@class AppBladeUploadItem;
 
 typedef enum {
     AppBladeWebClientAPI_GenerateToken,
@@ -19,6 +20,7 @@ typedef enum {
     AppBladeWebClientAPI_Feedback,
     AppBladeWebClientAPI_Sessions,
     AppBladeWebClientAPI_UpdateCheck,
+    AppBladeWebClientAPI_Batch,
     AppBladeWebClientAPI_AllTypes
 } AppBladeWebClientAPI;
 
@@ -28,6 +30,12 @@ extern NSString *approvalURLFormat;
 extern NSString *reportCrashURLFormat;
 extern NSString *reportFeedbackURLFormat;
 extern NSString *sessionURLFormat;
+// Batch upload contract: a gzip compressed multipart/form-data POST with one part per item, named
+// crash_reports[id], feedback[id] or sessions[id] after the item's AppBladeUploadItem identifier, plus optional
+// custom_params. A 2xx response may carry JSON of the form {"items": {"<id>": <status>, ...}} giving each item's
+// HTTP status; without it the response status applies to every item. Any other status fails the whole batch, except
+// 404 and 405, which mean the host has no batch endpoint and its items must be sent to the per-item endpoints.
+extern NSString *batchURLFormat;
 
 extern NSString *deviceSecretHeaderField;
 
@@ -50,6 +58,10 @@ extern NSString *deviceSecretHeaderField;
 - (void)appBladeWebClientSentFeedback:(AppBladeWebClient *)client withSuccess:(BOOL)success;
 - (void)appBladeWebClientSentSessions:(AppBladeWebClient *)client withSuccess:(BOOL)success;
 - (void)appBladeWebClient:(AppBladeWebClient *)client receivedUpdate:(NSDictionary*)permissions;
+// itemStatuses maps each AppBladeUploadItem identifier (as an NSNumber) the server reported on to its HTTP status.
+- (void)appBladeWebClient:(AppBladeWebClient *)client uploadedBatch:(NSDictionary *)itemStatuses;
+// The host answered a batch upload with 404 or 405; none of its items were sent.
+- (void)appBladeWebClientBatchUnsupported:(AppBladeWebClient *)client;
 
 @end
 
@@ -76,6 +88,13 @@ extern NSString *deviceSecretHeaderField;
 - (void)checkPermissions;
 - (void)checkForUpdates;
 - (void)reportCrash:(NSString *)crashReport withParams:(NSDictionary *)params;
+- (void)reportCrashData:(NSData *)crashReport compressed:(BOOL)compressed withParams:(NSDictionary *)params;
 - (void)sendFeedbackWithScreenshot:(NSString*)screenshot note:(NSString*)note console:(NSString*)console params:(NSDictionary*)paramsData;
 - (void)postSessions:(NSArray *)sessions;
+// Uploads AppBladeUploadItems in a single gzip compressed multipart request.
+- (void)uploadBatch:(NSArray *)items withParams:(NSDictionary *)params;
+// Uploads a single AppBladeUploadItem to its own endpoint, for hosts without batch support. Success, or a rejection of
+// the payload (400, 413, 415 or 422), is reported as a batch of one item whose status is that of the request; any
+// other status, including 401 and 403, fails the request like a failed batch and keeps the item.
+- (void)uploadItem:(AppBladeUploadItem *)item withParams:(NSDictionary *)params;
 @end
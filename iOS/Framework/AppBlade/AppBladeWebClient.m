@@ -8,12 +8,16 @@
 
 #import "AppBladeWebClient.h"
 #import "PLCrashReporter.h"
+#import "PLCrashCompression.h"
 
 #import "AppBlade.h"
 #import "AppBladeLogging.h"
+#import "AppBladeUploadQueue.h"
+#import "AppBladeRequestBody.h"
+#import "AppBladeRequestSigner.h"
+#import "AppBladeFileHasher.h"
+#include "AppBladeBase64.h"
 
-#import <CommonCrypto/CommonHMAC.h>
-#include "FileMD5Hash.h"
 #import <dlfcn.h>
 #import <mach-o/dyld.h>
 #import <TargetConditionals.h>
@@ -31,6 +35,7 @@ NSString *reportCrashURLFormat       = @"%@/api/3/crash_reports";
 NSString *reportFeedbackURLFormat    = @"%@/api/3/feedback";
 NSString *sessionURLFormat           = @"%@/api/3/user_sessions";
 NSString *updateURLFormat            = @"%@/api/3/updates";
+NSString *batchURLFormat             = @"%@/api/3/batch";
 
 NSString *deviceSecretHeaderField    = @"X-device-secret";
 
@@ -53,17 +58,25 @@ NSString *deviceSecretHeaderField    = @"X-device-secret";
 @property (nonatomic, assign) NSTimeInterval timeoutInterval;
 @property (nonatomic, assign) UIBackgroundTaskIdentifier backgroundTaskId;
 @property (nonatomic, strong) NSThread *connectionThread;
+@property (nonatomic, strong) NSArray *batchItems;
+@property (nonatomic, assign) BOOL itemUpload; //batchItems holds a single item, sent to its own endpoint
+@property (nonatomic, strong) AppBladeRequestBody *requestBody;
 -(void)issueRequest;
 -(void)scheduleTimeout;
 -(void)cancelTimeout;
 
 // Request builder methods.
 - (NSMutableURLRequest *)requestForURL:(NSURL *)url;
+- (AppBladeRequestSigner *)signerForRequest:(NSMutableURLRequest *)request hasBody:(BOOL)hasBody;
 - (void)addSecurityToRequest:(NSMutableURLRequest *)request;
+- (AppBladeRequestBody *)bodyForRequest:(NSMutableURLRequest *)request compressed:(BOOL)compressed;
+- (BOOL)addBody:(AppBladeRequestBody *)body toRequest:(NSMutableURLRequest *)request;
+- (void)reportCrashFileData:(NSData *)data fileName:(NSString *)fileName contentType:(NSString *)contentType withParams:(NSDictionary *)paramsDict;
+- (void)appendParams:(NSDictionary *)paramsDict toBody:(AppBladeRequestBody *)body boundary:(NSString *)multipartBoundary;
+- (void)appendUploadItem:(AppBladeUploadItem *)item toBody:(AppBladeRequestBody *)body boundary:(NSString *)multipartBoundary;
+- (void)appendBase64File:(NSString *)path toBody:(AppBladeRequestBody *)body;
+- (void)requestBuildFailed;
 // Crypto methods.
-- (NSString *)HMAC_SHA256_Base64:(NSString *)data with_key:(NSString *)key;
-- (NSString *)SHA_Base64:(NSString *)raw;
-- (NSString *)encodeBase64WithData:(NSData *)objData;
 - (NSString *)genRandStringLength:(int)len;
 - (NSString *)genRandNumberLength:(int)len;
 - (NSString *)urlEncodeValue:(NSString*)string; //no longer being used
@@ -81,6 +94,7 @@ NSString *deviceSecretHeaderField    = @"X-device-secret";
 
 
 const int kNonceRandomStringLength = 74;
+const NSUInteger kBase64ChunkLength = 3 * 16 * 1024;
 
 #pragma mark - Lifecycle
 
@@ -252,6 +266,10 @@ const int kNonceRandomStringLength = 74;
 		// Clone and retarget request to new URL.
         NSMutableURLRequest *redirectRequest = [self.request mutableCopy] ;
         [redirectRequest setURL: [aRequest URL]];
+        if ([self.request HTTPBodyStream]) {
+            // A stream can only be read once
+            [redirectRequest setHTTPBodyStream:[self.requestBody inputStream]];
+        }
         return [redirectRequest copy];
     }
     else
@@ -260,6 +278,12 @@ const int kNonceRandomStringLength = 74;
     }
 }
 
+- (NSInputStream *)connection:(NSURLConnection *)connection needNewBodyStream:(NSURLRequest *)request
+{
+    // Called when a streamed upload has to be resent, e.g. for an authentication challenge
+    return [self.requestBody inputStream];
+}
+
 - (void)connection:(NSURLConnection *)connection didReceiveData:(NSData *)data
 {
 	[self.receivedData appendData:data];
@@ -418,6 +442,69 @@ const int kNonceRandomStringLength = 74;
             });
         }
     }
+    else if(self.api == AppBladeWebClientAPI_Batch) {
+        int status = [[self.responseHeaders valueForKey:@"statusCode"] intValue];
+        AppBladeWebClient *selfReference = self;
+        id<AppBladeWebClientDelegate> delegateReference = self.delegate;
+        if (self.itemUpload && !((status >= 200 && status < 300) || status == 400 || status == 413 || status == 415 || status == 422)) {
+            // Only success or a rejection of the payload itself settles the item. Anything else, notably an
+            // expired or revoked token, fails the request so the token is refreshed and the item kept.
+            ABErrorLog(@"Upload of %@ failed with status %d", [self.batchItems lastObject], status);
+            dispatch_async(dispatch_get_main_queue(), ^{
+                [delegateReference appBladeWebClientFailed:selfReference];
+            });
+        }
+        else if (self.itemUpload) {
+            // Item endpoints don't report on items; the request's status is the item's
+            NSNumber *itemKey = [NSNumber numberWithUnsignedLongLong:[(AppBladeUploadItem *)[self.batchItems lastObject] identifier]];
+            NSDictionary *itemStatuses = [NSDictionary dictionaryWithObject:[NSNumber numberWithInt:status] forKey:itemKey];
+            self.receivedData = nil;
+            dispatch_async(dispatch_get_main_queue(), ^{
+                [delegateReference appBladeWebClient:selfReference uploadedBatch:itemStatuses];
+            });
+        }
+        else if (status >= 200 && status < 300) {
+            // The server may report on each item; otherwise the request's status applies to all of them
+            NSError *error = nil;
+            NSDictionary *json = [self.receivedData length] > 0 ? [NSJSONSerialization JSONObjectWithData:self.receivedData options:0 error:&error] : nil;
+            NSDictionary *reportedStatuses = [json isKindOfClass:[NSDictionary class]] ? [json objectForKey:@"items"] : nil;
+            if (![reportedStatuses isKindOfClass:[NSDictionary class]]) {
+                reportedStatuses = nil;
+            }
+            
+            NSMutableDictionary *itemStatuses = [NSMutableDictionary dictionaryWithCapacity:[self.batchItems count]];
+            for (AppBladeUploadItem *item in self.batchItems) {
+                NSNumber *itemKey = [NSNumber numberWithUnsignedLongLong:item.identifier];
+                if (reportedStatuses == nil) {
+                    [itemStatuses setObject:[NSNumber numberWithInt:status] forKey:itemKey];
+                }
+                else
+                {
+                    id itemStatus = [reportedStatuses objectForKey:[itemKey stringValue]];
+                    if ([itemStatus respondsToSelector:@selector(intValue)]) {
+                        [itemStatuses setObject:[NSNumber numberWithInt:[itemStatus intValue]] forKey:itemKey];
+                    }
+                }
+            }
+            self.receivedData = nil;
+            dispatch_async(dispatch_get_main_queue(), ^{
+                [delegateReference appBladeWebClient:selfReference uploadedBatch:itemStatuses];
+            });
+        }
+        else if (status == 404 || status == 405) {
+            ABErrorLog(@"Batch uploads not supported by %@ (status %d)", [self.delegate appBladeHost], status);
+            dispatch_async(dispatch_get_main_queue(), ^{
+                [delegateReference appBladeWebClientBatchUnsupported:selfReference];
+            });
+        }
+        else
+        {
+            ABErrorLog(@"Batch upload failed with status %d", status);
+            dispatch_async(dispatch_get_main_queue(), ^{
+                [delegateReference appBladeWebClientFailed:selfReference];
+            });
+        }
+    }
     else
     {
         ABErrorLog(@"Unhandled connection with AppBladeWebClientAPI value %d", self.api);
@@ -546,6 +633,27 @@ const int kNonceRandomStringLength = 74;
 }
 
 - (void)reportCrash:(NSString *)crashReport withParams:(NSDictionary *)paramsDict {
+    [self reportCrashFileData:[crashReport dataUsingEncoding:NSUTF8StringEncoding] fileName:@"report.crash" contentType:@"text/plain" withParams:paramsDict];
+}
+
+- (void)reportCrashData:(NSData *)crashReport compressed:(BOOL)compressed withParams:(NSDictionary *)paramsDict {
+    if(compressed){
+        plcrash_report_output_t output;
+        plcrash_report_output_init_buffer(&output, 0);
+        plcrash_error_t err = plcrash_gzip_compress([crashReport bytes], [crashReport length], &output);
+        if(err == PLCRASH_ESUCCESS){
+            NSData *compressedReport = [NSData dataWithBytes:output.buffer length:output.length];
+            plcrash_report_output_free(&output);
+            [self reportCrashFileData:compressedReport fileName:@"report.plcrash.gz" contentType:@"application/gzip" withParams:paramsDict];
+            return;
+        }
+        plcrash_report_output_free(&output);
+        ABErrorLog(@"Error compressing crash report, sending it uncompressed: %s", plcrash_strerror(err));
+    }
+    [self reportCrashFileData:crashReport fileName:@"report.plcrash" contentType:@"application/octet-stream" withParams:paramsDict];
+}
+
+- (void)reportCrashFileData:(NSData *)data fileName:(NSString *)fileName contentType:(NSString *)contentType withParams:(NSDictionary *)paramsDict {
     [self setApi: AppBladeWebClientAPI_ReportCrash];
     @synchronized (self)
     {
@@ -559,35 +667,20 @@ const int kNonceRandomStringLength = 74;
         [apiRequest setValue:[@"multipart/form-data; boundary=" stringByAppendingString:multipartBoundary] forHTTPHeaderField:@"Content-Type"];
     [apiRequest setHTTPMethod:@"POST"];
     
-    NSMutableData* body = [NSMutableData dataWithData:[[NSString stringWithFormat:@"--%@\r\n",multipartBoundary] dataUsingEncoding:NSUTF8StringEncoding]];
-    [body appendData:[@"Content-Disposition: form-data; name=\"file\"; filename=\"report.crash\"\r\n" dataUsingEncoding:NSUTF8StringEncoding]];
-    [body appendData:[@"Content-Type: text/plain\r\n\r\n" dataUsingEncoding:NSUTF8StringEncoding]];
+    AppBladeRequestBody* body = [self bodyForRequest:apiRequest compressed:NO];
+    [body appendString:[NSString stringWithFormat:@"--%@\r\n",multipartBoundary]];
+    [body appendString:[NSString stringWithFormat:@"Content-Disposition: form-data; name=\"file\"; filename=\"%@\"\r\n", fileName]];
+    [body appendString:[NSString stringWithFormat:@"Content-Type: %@\r\n\r\n", contentType]];
     
-    NSData* data = [crashReport dataUsingEncoding:NSUTF8StringEncoding];
     [body appendData:data];
     
-    if([NSPropertyListSerialization propertyList:paramsDict isValidForFormat:NSPropertyListXMLFormat_v1_0]){
-        NSError* error = nil;
-        NSData *paramsData = [NSPropertyListSerialization dataWithPropertyList:paramsDict format:NSPropertyListXMLFormat_v1_0 options:0 error:&error];
-        if(error == nil){
-            [body appendData:[[NSString stringWithFormat:@"\r\n--%@\r\n",multipartBoundary] dataUsingEncoding:NSUTF8StringEncoding]];
-            [body appendData:[@"Content-Disposition: form-data; name=\"custom_params\"\r\n" dataUsingEncoding:NSUTF8StringEncoding]];
-            [body appendData:[@"Content-Type: text/xml\r\n\r\n" dataUsingEncoding:NSUTF8StringEncoding]];
-            [body appendData:paramsData];
-            ABDebugLog_internal(@"Parsed params! They were included.");
-        }
-        else
-        {
-            ABErrorLog(@"Error parsing params. They weren't included. %@ ",error.debugDescription);
-        }
-    }
+    [self appendParams:paramsDict toBody:body boundary:multipartBoundary];
     
-    [body appendData:[[[@"\r\n--" stringByAppendingString:multipartBoundary] stringByAppendingString:@"--"] dataUsingEncoding:NSUTF8StringEncoding]];
+    [body appendString:[[@"\r\n--" stringByAppendingString:multipartBoundary] stringByAppendingString:@"--"]];
     
-    [apiRequest setHTTPBody:body];
-    [apiRequest setValue:[NSString stringWithFormat:@"%d", [body length]] forHTTPHeaderField:@"Content-Length"];
-
-    [self addSecurityToRequest:apiRequest];
+    if (![self addBody:body toRequest:apiRequest]) {
+        [self requestBuildFailed];
+    }
 
         //apiRequest is a retained reference to the _request ivar.
     }
@@ -613,40 +706,25 @@ const int kNonceRandomStringLength = 74;
         [apiRequest setValue:@"application/json" forHTTPHeaderField:@"Accept"];
         [apiRequest setHTTPMethod:@"POST"];
         
-        NSMutableData* body = [NSMutableData dataWithData:[[NSString stringWithFormat:@"--%@\r\n",multipartBoundary] dataUsingEncoding:NSUTF8StringEncoding]];
-        [body appendData:[@"Content-Disposition: form-data; name=\"feedback[notes]\"\r\n\r\n" dataUsingEncoding:NSUTF8StringEncoding]];
-        
-        [body appendData:[note dataUsingEncoding:NSUTF8StringEncoding]];
+        AppBladeRequestBody* body = [self bodyForRequest:apiRequest compressed:NO];
+        [body appendString:[NSString stringWithFormat:@"--%@\r\n",multipartBoundary]];
+        [body appendString:@"Content-Disposition: form-data; name=\"feedback[notes]\"\r\n\r\n"];
         
-        [body appendData:[[NSString stringWithFormat:@"\r\n--%@\r\n",multipartBoundary] dataUsingEncoding:NSUTF8StringEncoding]];
-        [body appendData:[[NSString stringWithFormat:@"Content-Disposition: form-data; name=\"feedback[screenshot]\"; filename=\"base64:%@\"\r\n", screenshot] dataUsingEncoding:NSUTF8StringEncoding]];
-        [body appendData:[@"Content-Type: application/octet-stream\r\n\r\n" dataUsingEncoding:NSUTF8StringEncoding]];
+        [body appendString:note];
         
-        NSData* screenshotData = [[self encodeBase64WithData:[NSData dataWithContentsOfFile:screenshotPath]] dataUsingEncoding:NSUTF8StringEncoding];
-        [body appendData:screenshotData];
+        [body appendString:[NSString stringWithFormat:@"\r\n--%@\r\n",multipartBoundary]];
+        [body appendString:[NSString stringWithFormat:@"Content-Disposition: form-data; name=\"feedback[screenshot]\"; filename=\"base64:%@\"\r\n", screenshot]];
+        [body appendString:@"Content-Type: application/octet-stream\r\n\r\n"];
         
-        if([NSPropertyListSerialization propertyList:paramsDict isValidForFormat:NSPropertyListXMLFormat_v1_0]){
-            NSError* error = nil;
-            NSData *paramsData = [NSPropertyListSerialization dataWithPropertyList:paramsDict format:NSPropertyListXMLFormat_v1_0 options:0 error:&error];
-            if(error == nil){
-                [body appendData:[[NSString stringWithFormat:@"\r\n--%@\r\n",multipartBoundary] dataUsingEncoding:NSUTF8StringEncoding]];
-                [body appendData:[@"Content-Disposition: form-data; name=\"custom_params\"\r\n" dataUsingEncoding:NSUTF8StringEncoding]];
-                [body appendData:[@"Content-Type: text/xml\r\n\r\n" dataUsingEncoding:NSUTF8StringEncoding]];
-                [body appendData:paramsData];
-                ABDebugLog_internal(@"Parsed params! They were included.");
-            }
-            else
-            {
-                ABErrorLog(@"Error parsing params. They weren't included. %@ ",error.debugDescription);
-            }
-        }
+        [self appendBase64File:screenshotPath toBody:body];
         
-        [body appendData:[[[@"\r\n--" stringByAppendingString:multipartBoundary] stringByAppendingString:@"--"] dataUsingEncoding:NSUTF8StringEncoding]];
+        [self appendParams:paramsDict toBody:body boundary:multipartBoundary];
         
-        [apiRequest setHTTPBody:body];
-        [apiRequest setValue:[NSString stringWithFormat:@"%d", [body length]] forHTTPHeaderField:@"Content-Length"];
+        [body appendString:[[@"\r\n--" stringByAppendingString:multipartBoundary] stringByAppendingString:@"--"]];
         
-        [self addSecurityToRequest:apiRequest];
+        if (![self addBody:body toRequest:apiRequest]) {
+            [self requestBuildFailed];
+        }
         
         //apiRequest is a retained reference to the _request ivar.
     }
@@ -669,25 +747,25 @@ const int kNonceRandomStringLength = 74;
         [request setHTTPMethod:@"PUT"];
         [request setValue:[@"multipart/form-data; boundary=" stringByAppendingString:multipartBoundary] forHTTPHeaderField:@"Content-Type"];
         
-        NSMutableData* body = [NSMutableData dataWithData:[[NSString stringWithFormat:@"--%@\r\n",multipartBoundary] dataUsingEncoding:NSUTF8StringEncoding]];
-        [body appendData:[@"Content-Disposition: form-data; name=\"device_secret\"\r\n\r\n" dataUsingEncoding:NSUTF8StringEncoding]];
-        [body appendData:[[[AppBlade sharedManager] appBladeDeviceSecret] dataUsingEncoding:NSUTF8StringEncoding]];
+        AppBladeRequestBody* body = [self bodyForRequest:request compressed:NO];
+        [body appendString:[NSString stringWithFormat:@"--%@\r\n",multipartBoundary]];
+        [body appendString:@"Content-Disposition: form-data; name=\"device_secret\"\r\n\r\n"];
+        [body appendString:[[AppBlade sharedManager] appBladeDeviceSecret]];
         
-        [body appendData:[[NSString stringWithFormat:@"\r\n--%@\r\n",multipartBoundary] dataUsingEncoding:NSUTF8StringEncoding]];
-        [body appendData:[@"Content-Disposition: form-data; name=\"project_secret\"\r\n\r\n" dataUsingEncoding:NSUTF8StringEncoding]];
-        [body appendData:[[[AppBlade sharedManager] appBladeProjectSecret] dataUsingEncoding:NSUTF8StringEncoding]];
+        [body appendString:[NSString stringWithFormat:@"\r\n--%@\r\n",multipartBoundary]];
+        [body appendString:@"Content-Disposition: form-data; name=\"project_secret\"\r\n\r\n"];
+        [body appendString:[[AppBlade sharedManager] appBladeProjectSecret]];
         
-        [body appendData:[[NSString stringWithFormat:@"\r\n--%@\r\n",multipartBoundary] dataUsingEncoding:NSUTF8StringEncoding]];
-        [body appendData:[@"Content-Disposition: form-data; name=\"sessions\"\r\n" dataUsingEncoding:NSUTF8StringEncoding]];
-        [body appendData:[@"Content-Type: text/xml\r\n\r\n" dataUsingEncoding:NSUTF8StringEncoding]];
+        [body appendString:[NSString stringWithFormat:@"\r\n--%@\r\n",multipartBoundary]];
+        [body appendString:@"Content-Disposition: form-data; name=\"sessions\"\r\n"];
+        [body appendString:@"Content-Type: text/xml\r\n\r\n"];
     
         [body appendData:requestData];
-        [body appendData:[[[@"\r\n--" stringByAppendingString:multipartBoundary] stringByAppendingString:@"--"] dataUsingEncoding:NSUTF8StringEncoding]];
+        [body appendString:[[@"\r\n--" stringByAppendingString:multipartBoundary] stringByAppendingString:@"--"]];
         
-        [request setHTTPBody:body];
-        [request setValue:[NSString stringWithFormat:@"%d", [body length]] forHTTPHeaderField:@"Content-Length"];
-
-        [self addSecurityToRequest:request];
+        if (![self addBody:body toRequest:request]) {
+            [self requestBuildFailed];
+        }
         //request is a retained reference to the _request ivar.
     }
     else {
@@ -696,13 +774,256 @@ const int kNonceRandomStringLength = 74;
             ABErrorLog(@"Error %@", [error debugDescription]);
         
         //we may have to remove the sessions file in extreme cases
-        AppBladeWebClient *selfReference = self;
-        id<AppBladeWebClientDelegate> delegateReference = self.delegate;
-        dispatch_async(dispatch_get_main_queue(), ^{
-        [delegateReference appBladeWebClientFailed:selfReference];
-        });
+        [self requestBuildFailed];
+    }
+    
+}
+
+- (void)uploadBatch:(NSArray *)items withParams:(NSDictionary *)paramsDict
+{
+    [self setApi: AppBladeWebClientAPI_Batch];
+    
+    @synchronized (self)
+    {
+        self.batchItems = items;
+        
+        NSString* batchString = [NSString stringWithFormat:batchURLFormat, [self.delegate appBladeHost]];
+        NSURL* batchURL = [NSURL URLWithString:batchString];
+        
+        NSString *multipartBoundary = [NSString stringWithFormat:@"---------------------------%@", [self genRandNumberLength:64]];
+        
+        NSMutableURLRequest* apiRequest = [self requestForURL:batchURL];
+        [apiRequest setValue:[@"multipart/form-data; boundary=" stringByAppendingString:multipartBoundary] forHTTPHeaderField:@"Content-Type"];
+        [apiRequest setValue:@"application/json" forHTTPHeaderField:@"Accept"];
+        [apiRequest setHTTPMethod:@"POST"];
+        
+        // Crash reports, plists and sessions all compress well; compress the body as it is built
+        AppBladeRequestBody* body = [self bodyForRequest:apiRequest compressed:YES];
+        for (AppBladeUploadItem *item in items) {
+            [self appendUploadItem:item toBody:body boundary:multipartBoundary];
+        }
+        
+        if([NSPropertyListSerialization propertyList:paramsDict isValidForFormat:NSPropertyListXMLFormat_v1_0]){
+            NSError* error = nil;
+            NSData *paramsData = [NSPropertyListSerialization dataWithPropertyList:paramsDict format:NSPropertyListXMLFormat_v1_0 options:0 error:&error];
+            if(error == nil){
+                [body appendString:[NSString stringWithFormat:@"--%@\r\n",multipartBoundary]];
+                [body appendString:@"Content-Disposition: form-data; name=\"custom_params\"\r\n"];
+                [body appendString:@"Content-Type: text/xml\r\n\r\n"];
+                [body appendData:paramsData];
+                [body appendString:@"\r\n"];
+            }
+            else
+            {
+                ABErrorLog(@"Error parsing params. They weren't included. %@ ",error.debugDescription);
+            }
+        }
+        
+        [body appendString:[[@"--" stringByAppendingString:multipartBoundary] stringByAppendingString:@"--"]];
+        
+        if ([self addBody:body toRequest:apiRequest]) {
+            ABDebugLog_internal(@"Compressed %d item batch to %llu bytes", [items count], body.length);
+        }
+        else
+        {
+            [self requestBuildFailed];
+        }
+        
+        //apiRequest is a retained reference to the _request ivar.
+    }
+}
+
+- (void)uploadItem:(AppBladeUploadItem *)item withParams:(NSDictionary *)paramsDict
+{
+    [self setApi: AppBladeWebClientAPI_Batch];
+
+    @synchronized (self)
+    {
+        self.batchItems = [NSArray arrayWithObject:item];
+        self.itemUpload = YES;
+
+        NSString *urlFormat = nil;
+        NSString *method = @"POST";
+        if (item.type == AppBladeUploadItemCrashReport) {
+            urlFormat = reportCrashURLFormat;
+        }
+        else if (item.type == AppBladeUploadItemFeedback) {
+            urlFormat = reportFeedbackURLFormat;
+        }
+        else if (item.type == AppBladeUploadItemSessions) {
+            urlFormat = sessionURLFormat;
+            method = @"PUT";
+        }
+        else
+        {
+            ABErrorLog(@"Unknown upload item type %d, not sent", item.type);
+            [self requestBuildFailed];
+            return;
+        }
+
+        NSString* itemString = [NSString stringWithFormat:urlFormat, [self.delegate appBladeHost]];
+        NSURL* itemURL = [NSURL URLWithString:itemString];
+
+        NSString *multipartBoundary = [NSString stringWithFormat:@"---------------------------%@", [self genRandNumberLength:64]];
+
+        NSMutableURLRequest* apiRequest = [self requestForURL:itemURL];
+        [apiRequest setValue:[@"multipart/form-data; boundary=" stringByAppendingString:multipartBoundary] forHTTPHeaderField:@"Content-Type"];
+        [apiRequest setHTTPMethod:method];
+
+        // The same forms as reportCrash:, sendFeedbackWithScreenshot: and postSessions:, built from the queued payload
+        AppBladeRequestBody* body = [self bodyForRequest:apiRequest compressed:NO];
+        if (item.type == AppBladeUploadItemCrashReport) {
+            BOOL binary = [[item.path pathExtension] isEqualToString:@"plcrash"];
+            [body appendString:[NSString stringWithFormat:@"--%@\r\n",multipartBoundary]];
+            [body appendString:[NSString stringWithFormat:@"Content-Disposition: form-data; name=\"file\"; filename=\"%@\"\r\n", (binary ? @"report.plcrash" : @"report.crash")]];
+            [body appendString:[NSString stringWithFormat:@"Content-Type: %@\r\n\r\n", (binary ? @"application/octet-stream" : @"text/plain")]];
+            [body appendContentsOfFile:item.path];
+            [self appendParams:paramsDict toBody:body boundary:multipartBoundary];
+        }
+        else if (item.type == AppBladeUploadItemFeedback) {
+            NSData *itemData = [NSData dataWithContentsOfFile:item.path];
+            NSDictionary *feedback = itemData ? [NSPropertyListSerialization propertyListWithData:itemData options:NSPropertyListImmutable format:NULL error:NULL] : nil;
+            if (![feedback isKindOfClass:[NSDictionary class]]) {
+                ABErrorLog(@"Error reading queued feedback %@", item.path);
+                [self requestBuildFailed];
+                return;
+            }
+
+            [apiRequest setValue:@"application/json" forHTTPHeaderField:@"Accept"];
+            NSString *note = [feedback objectForKey:@"notes"];
+            [body appendString:[NSString stringWithFormat:@"--%@\r\n",multipartBoundary]];
+            [body appendString:@"Content-Disposition: form-data; name=\"feedback[notes]\"\r\n\r\n"];
+            [body appendString:([note isKindOfClass:[NSString class]] ? note : @"")];
+
+            NSData *screenshot = [feedback objectForKey:@"screenshot"];
+            char *encoded = [screenshot isKindOfClass:[NSData class]] ? malloc(AB_BASE64_ENCODED_LENGTH([screenshot length])) : NULL;
+            if (encoded != NULL) {
+                size_t length = ab_base64_encode([screenshot bytes], [screenshot length], encoded);
+                [body appendString:[NSString stringWithFormat:@"\r\n--%@\r\n",multipartBoundary]];
+                [body appendString:@"Content-Disposition: form-data; name=\"feedback[screenshot]\"; filename=\"base64:screenshot.png\"\r\n"];
+                [body appendString:@"Content-Type: application/octet-stream\r\n\r\n"];
+                [body appendBytes:encoded length:length];
+                free(encoded);
+            }
+
+            [self appendParams:paramsDict toBody:body boundary:multipartBoundary];
+        }
+        else
+        {
+            [body appendString:[NSString stringWithFormat:@"--%@\r\n",multipartBoundary]];
+            [body appendString:@"Content-Disposition: form-data; name=\"device_secret\"\r\n\r\n"];
+            [body appendString:[[AppBlade sharedManager] appBladeDeviceSecret]];
+
+            [body appendString:[NSString stringWithFormat:@"\r\n--%@\r\n",multipartBoundary]];
+            [body appendString:@"Content-Disposition: form-data; name=\"project_secret\"\r\n\r\n"];
+            [body appendString:[[AppBlade sharedManager] appBladeProjectSecret]];
+
+            [body appendString:[NSString stringWithFormat:@"\r\n--%@\r\n",multipartBoundary]];
+            [body appendString:@"Content-Disposition: form-data; name=\"sessions\"\r\n"];
+            [body appendString:@"Content-Type: text/xml\r\n\r\n"];
+            [body appendContentsOfFile:item.path];
+        }
+
+        [body appendString:[[@"\r\n--" stringByAppendingString:multipartBoundary] stringByAppendingString:@"--"]];
+
+        if (![self addBody:body toRequest:apiRequest]) {
+            [self requestBuildFailed];
+        }
+
+        //apiRequest is a retained reference to the _request ivar.
+    }
+}
+
+- (void)appendParams:(NSDictionary *)paramsDict toBody:(AppBladeRequestBody *)body boundary:(NSString *)multipartBoundary
+{
+    if([NSPropertyListSerialization propertyList:paramsDict isValidForFormat:NSPropertyListXMLFormat_v1_0]){
+        NSError* error = nil;
+        NSData *paramsData = [NSPropertyListSerialization dataWithPropertyList:paramsDict format:NSPropertyListXMLFormat_v1_0 options:0 error:&error];
+        if(error == nil){
+            [body appendString:[NSString stringWithFormat:@"\r\n--%@\r\n",multipartBoundary]];
+            [body appendString:@"Content-Disposition: form-data; name=\"custom_params\"\r\n"];
+            [body appendString:@"Content-Type: text/xml\r\n\r\n"];
+            [body appendData:paramsData];
+            ABDebugLog_internal(@"Parsed params! They were included.");
+        }
+        else
+        {
+            ABErrorLog(@"Error parsing params. They weren't included. %@ ",error.debugDescription);
+        }
+    }
+}
+
+- (void)appendUploadItem:(AppBladeUploadItem *)item toBody:(AppBladeRequestBody *)body boundary:(NSString *)multipartBoundary
+{
+    NSString *fieldName = nil;
+    NSString *fileName = nil;
+    NSString *contentType = nil;
+    if (item.type == AppBladeUploadItemCrashReport) {
+        fieldName = @"crash_reports";
+        if ([[item.path pathExtension] isEqualToString:@"plcrash"]) {
+            fileName = @"report.plcrash";
+            contentType = @"application/octet-stream";
+        }
+        else
+        {
+            fileName = @"report.crash";
+            contentType = @"text/plain";
+        }
+    }
+    else if (item.type == AppBladeUploadItemFeedback) {
+        fieldName = @"feedback";
+        fileName = @"feedback.plist";
+        contentType = @"text/xml";
+    }
+    else if (item.type == AppBladeUploadItemSessions) {
+        fieldName = @"sessions";
+        fileName = @"sessions.plist";
+        contentType = @"text/xml";
+    }
+    else
+    {
+        ABErrorLog(@"Unknown upload item type %d, not sent", item.type);
+        return;
+    }
+    
+    // Payloads were checked when the batch was taken from the queue; one that cannot be read now fails the batch
+    [body appendString:[NSString stringWithFormat:@"--%@\r\n",multipartBoundary]];
+    [body appendString:[NSString stringWithFormat:@"Content-Disposition: form-data; name=\"%@[%llu]\"; filename=\"%@\"\r\n", fieldName, item.identifier, fileName]];
+    [body appendString:[NSString stringWithFormat:@"Content-Type: %@\r\n\r\n", contentType]];
+    [body appendContentsOfFile:item.path];
+    [body appendString:@"\r\n"];
+}
+
+// Appends the file base64 encoded, reading it a chunk at a time.
+- (void)appendBase64File:(NSString *)path toBody:(AppBladeRequestBody *)body
+{
+    NSFileHandle *file = [NSFileHandle fileHandleForReadingAtPath:path];
+    if (file == nil) {
+        ABErrorLog(@"Error opening %@, not included", path);
+        return;
     }
     
+    ab_base64_encoder_t encoder;
+    ab_base64_encoder_init(&encoder);
+    char *encoded = malloc(AB_BASE64_ENCODED_LENGTH(kBase64ChunkLength));
+    if (encoded == NULL) {
+        [file closeFile];
+        return;
+    }
+
+    NSData *chunk = nil;
+    do {
+        @autoreleasepool {
+            chunk = [file readDataOfLength:kBase64ChunkLength];
+            size_t length = ab_base64_encoder_update(&encoder, [chunk bytes], [chunk length], encoded);
+            [body appendBytes:encoded length:length];
+        }
+    } while ([chunk length] == kBase64ChunkLength);
+    size_t length = ab_base64_encoder_final(&encoder, encoded);
+    [body appendBytes:encoded length:length];
+
+    free(encoded);
+    [file closeFile];
 }
 
 
@@ -754,145 +1075,73 @@ const int kNonceRandomStringLength = 74;
     return apiRequest;
 }
 
-- (void)addSecurityToRequest:(NSMutableURLRequest *)request
-{    //determine http or https
-    NSString* scheme = [[request URL] scheme];
-    if(scheme == nil){
-        scheme = defaultURLScheme;
-    }
-    else
-    {
-        scheme = [scheme lowercaseString]; //for string comparison sanity
-    }
-    NSString* preparedHostName = [NSString stringWithFormat:@"%@://%@", scheme, [[request URL] host] ];
-    
-    //find port number
-    NSString* port = nil;
-    if ([[request URL] port]) {
-        port = [[[request URL] port] stringValue];
-        preparedHostName = [preparedHostName stringByAppendingFormat:@":%@", port];
-    }
-    else
-    {   // Set port number based on the scheme
-        port = [scheme isEqualToString:@"https"] ? @"443" : @"80";
-    }
-
-    // Construct the relative URL path, followed by the body if POST.
-    NSMutableString *requestBodyRaw = [NSMutableString stringWithString:[[[request URL] absoluteString] substringFromIndex:[preparedHostName length]]];
-    if([request HTTPBody]) {
-        // Append "?" and the HTTP body.
-        NSString* dataString = [[NSString alloc] initWithData:[request HTTPBody] encoding:NSUTF8StringEncoding] ;
-        [requestBodyRaw appendFormat:@"?%@", dataString];
-    }
-    
-    
+// Starts signing the request, whose URL and method must already be set.
+- (AppBladeRequestSigner *)signerForRequest:(NSMutableURLRequest *)request hasBody:(BOOL)hasBody
+{
     // Construct the nonce (salt). First part of the salt is the delta of the current time and the stored time the
     // version was issued at, then a colon, then a random string of a certain length.
     NSString* randomString = [self genRandStringLength:kNonceRandomStringLength];
     NSString* nonce = [NSString stringWithFormat:@"%@:%@", [self.delegate appBladeProjectSecret], randomString];
-    NSString* ext = [self.delegate appBladeDeviceSecret];
     
-    NSString *requestBodyHash = [self SHA_Base64:requestBodyRaw];
-    ABDebugLog_internal(@"%d", [requestBodyRaw length]);
-    
-    // Compose the normalized request body.
-    NSMutableString* request_body = [NSMutableString stringWithFormat:@"%@\n%@\n%@\n%@\n%@\n%@\n%@\n",
-                                     nonce,
-                                     [request HTTPMethod],
-                                     requestBodyRaw,
-                                     [[request URL] host],
-                                     port,
-                                     requestBodyHash,
-                                     ext];
-    ABDebugLog_internal(@"%@", requestBodyHash);
-    ABDebugLog_internal(@"%@", [requestBodyRaw substringToIndex:MIN([requestBodyRaw length], 1000)]);
-    
-    // Digest the normalized request body.
-    NSString* mac = [self HMAC_SHA256_Base64:request_body with_key:[self.delegate appBladeProjectSecret]];
-    
-    NSMutableString *authHeader = [NSMutableString stringWithString:@"HMAC "];
-    [authHeader appendFormat:@"id=\"%@\"", [self.delegate appBladeProjectSecret]];
-    [authHeader appendFormat:@", nonce=\"%@\"", nonce];
-    [authHeader appendFormat:@", body-hash=\"%@\"", requestBodyHash];
-    [authHeader appendFormat:@", ext=\"%@\"", ext];
-    [authHeader appendFormat:@", mac=\"%@\"", mac];
-    [request setValue:authHeader forHTTPHeaderField:@"Authorization"];
+    return [[AppBladeRequestSigner alloc] initWithRequest:request hasBody:hasBody nonce:nonce projectSecret:[self.delegate appBladeProjectSecret] deviceSecret:[self.delegate appBladeDeviceSecret]];
+}
+
+- (void)addSecurityToRequest:(NSMutableURLRequest *)request
+{
+    NSData *httpBody = [request HTTPBody];
+    AppBladeRequestSigner *signer = [self signerForRequest:request hasBody:(httpBody != nil)];
+    [signer updateWithBytes:[httpBody bytes] length:[httpBody length]];
+    [request setValue:[signer authorizationHeader] forHTTPHeaderField:@"Authorization"];
     
     // Request is now fully prepared and secure.
 }
 
-
-- (NSString *)urlEncodeValue:(NSString *)str //no longer being used
+// Creates a body for the request, signed as it is appended. The request's URL and method must already be set.
+- (AppBladeRequestBody *)bodyForRequest:(NSMutableURLRequest *)request compressed:(BOOL)compressed
 {
-    NSString *result = (__bridge NSString *)(CFURLCreateStringByAddingPercentEscapes(kCFAllocatorDefault, (__bridge CFStringRef)str, NULL, CFSTR("?=&+"), kCFStringEncodingUTF8));
-    return result ;
+    AppBladeRequestBody *body = [[AppBladeRequestBody alloc] initWithCompression:compressed];
+    body.signer = [self signerForRequest:request hasBody:YES];
+    self.requestBody = body;
+    return body;
 }
 
-#pragma mark - Crypto utilities
-
-// Generates an HMAC digest using SHA-256 and base 64.
-- (NSString *)HMAC_SHA256_Base64:(NSString*)data with_key:(NSString *)key
+// Finishes the body and sets it on the request, along with its signature.
+- (BOOL)addBody:(AppBladeRequestBody *)body toRequest:(NSMutableURLRequest *)request
 {
-    unsigned char cHMAC[CC_SHA256_DIGEST_LENGTH];
-    CCHmac(kCCHmacAlgSHA256, [key UTF8String], [key lengthOfBytesUsingEncoding:NSASCIIStringEncoding], [data UTF8String], [data lengthOfBytesUsingEncoding:NSASCIIStringEncoding], cHMAC);
-    NSData *HMAC = [[NSData alloc] initWithBytes:cHMAC length:sizeof(cHMAC)];
-    return [self encodeBase64WithData:HMAC];
+    if (body == nil || ![body finish]) {
+        ABErrorLog(@"Error building request body for %@", [request URL]);
+        return NO;
+    }
+    
+    [body attachToRequest:request];
+    [request setValue:[body.signer authorizationHeader] forHTTPHeaderField:@"Authorization"];
+    
+    // Request is now fully prepared and secure.
+    return YES;
 }
 
-- (NSString*)SHA_Base64:(NSString*)raw
+// Reports a request that could not be built, which is then never issued.
+- (void)requestBuildFailed
 {
-    unsigned char hashedChars[CC_SHA256_DIGEST_LENGTH];
-    CC_SHA256([raw UTF8String], [raw lengthOfBytesUsingEncoding:NSASCIIStringEncoding], hashedChars);
-    NSData *toEncode = [[NSData alloc] initWithBytes:hashedChars length:sizeof(hashedChars)];
-    return [self encodeBase64WithData:toEncode];
+    self.request = nil;
+    self.requestBody = nil;
+    
+    AppBladeWebClient *selfReference = self;
+    id<AppBladeWebClientDelegate> delegateReference = self.delegate;
+    dispatch_async(dispatch_get_main_queue(), ^{
+        [delegateReference appBladeWebClientFailed:selfReference];
+    });
 }
 
-// Derived from QSUtilities.
-- (NSString *)encodeBase64WithData:(NSData *)objData
+
+- (NSString *)urlEncodeValue:(NSString *)str //no longer being used
 {
-    static const char _base64EncodingTable[64] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
-    const unsigned char * objRawData = [objData bytes];
-	char * objPointer;
-	char * strResult;
-	// Get the Raw Data length and ensure we actually have data
-	int intLength = [objData length];
-	if (intLength == 0) return nil;
-	// Setup the String-based Result placeholder and pointer within that placeholder
-	strResult = (char *)calloc(((intLength + 2) / 3) * 4, sizeof(char));
-	objPointer = strResult;
-	// Iterate through everything
-	while (intLength > 2) { // keep going until we have less than 24 bits
-		*objPointer++ = _base64EncodingTable[objRawData[0] >> 2];
-		*objPointer++ = _base64EncodingTable[((objRawData[0] & 0x03) << 4) + (objRawData[1] >> 4)];
-		*objPointer++ = _base64EncodingTable[((objRawData[1] & 0x0f) << 2) + (objRawData[2] >> 6)];
-		*objPointer++ = _base64EncodingTable[objRawData[2] & 0x3f];	
-		// we just handled 3 octets (24 bits) of data
-		objRawData += 3;
-		intLength -= 3; 
-	}
-	// now deal with the tail end of things
-	if (intLength != 0) {
-		*objPointer++ = _base64EncodingTable[objRawData[0] >> 2];
-		if (intLength > 1) {
-			*objPointer++ = _base64EncodingTable[((objRawData[0] & 0x03) << 4) + (objRawData[1] >> 4)];
-			*objPointer++ = _base64EncodingTable[(objRawData[1] & 0x0f) << 2];
-			*objPointer++ = '=';
-		}
-        else
-        {
-			*objPointer++ = _base64EncodingTable[(objRawData[0] & 0x03) << 4];
-			*objPointer++ = '=';
-			*objPointer++ = '=';
-		}
-	}
-	// Terminate the string-based result
-	*objPointer = '\0';
-    NSString *toRet = [NSString stringWithCString:strResult encoding:NSASCIIStringEncoding];
-    free(strResult);
-	// Return the results as an NSString object
-	return toRet;
+    NSString *result = (__bridge NSString *)(CFURLCreateStringByAddingPercentEscapes(kCFAllocatorDefault, (__bridge CFStringRef)str, NULL, CFSTR("?=&+"), kCFStringEncodingUTF8));
+    return result ;
 }
 
+#pragma mark - Crypto utilities
+
 // Derived from http://stackoverflow.com/q/2633801/2633948#2633948
 - (NSString *)genRandStringLength:(int)len
 {
@@ -919,15 +1168,7 @@ const int kNonceRandomStringLength = 74;
 
 - (NSString*)hashFile:(NSString *)filePath
 {
-    
-    NSString* returnString = nil;
-    CFStringRef executableFileMD5Hash =
-    FileMD5HashCreateWithPath((__bridge CFStringRef)(filePath), FileHashDefaultChunkSizeForReadingData);
-    if (executableFileMD5Hash) {
-        returnString = (__bridge NSString *)(executableFileMD5Hash);
-         CFRelease(executableFileMD5Hash);
-    }
-    return returnString ;
+    return [[AppBladeFileHasher sharedHasher] md5OfFileAtPath:filePath];
 }
 
 - (NSString*)hashExecutable
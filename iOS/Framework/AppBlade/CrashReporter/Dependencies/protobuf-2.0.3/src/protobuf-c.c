@@ -1181,7 +1181,8 @@ parse_required_member (ScannedMember *scanned_member,
         const ProtobufCBinaryData *def_bd;
         unsigned pref_len = scanned_member->length_prefix_len;
         def_bd = scanned_member->field->default_value;
-        if (maybe_clear && bd->data != NULL && bd->data != def_bd->data)
+        /* appblade - 10/19/2026 (single-pass unpack) Fields without a default have no default_value */
+        if (maybe_clear && bd->data != NULL && (def_bd == NULL || bd->data != def_bd->data))
           FREE (allocator, bd->data);
         bd->data = ALLOC (allocator, len - pref_len);
         memcpy (bd->data, data + pref_len, len - pref_len);
@@ -1327,6 +1328,42 @@ setup_default_values (ProtobufCMessage *message)
       }
 }
 
+/* appblade - 10/19/2026 (single-pass unpack)
+ *
+ * The original unpack scanned every field into a list of ScannedMember slabs, counting the repeated
+ * fields as it went, allocated each repeated array at its final size, and then walked the slabs a
+ * second time to parse the members. Messages with thousands of repeated frames paid for two passes
+ * over the input and the slab allocations.
+ *
+ * Members are now parsed as soon as they are scanned. Repeated and unknown field arrays are grown by
+ * doubling; the capacity of an array is implied by its element count (the smallest power of two, no
+ * less than REPEATED_ARRAY_MIN, that holds it), so no side table is needed. Arrays remain individually
+ * allocated, and are released by protobuf_c_message_free_unpacked() as before. */
+#define REPEATED_ARRAY_MIN 4
+
+static protobuf_c_boolean
+repeated_array_reserve (void **parray, size_t n, size_t elt_size, ProtobufCAllocator *allocator)
+{
+  void *array;
+
+  /* The array is full only when n is zero, or a power of two no less than REPEATED_ARRAY_MIN */
+  if (n == 0)
+    {
+      *parray = ALLOC (allocator, elt_size * REPEATED_ARRAY_MIN);
+      return *parray != NULL;
+    }
+  if (n < REPEATED_ARRAY_MIN || (n & (n - 1)) != 0)
+    return TRUE;
+
+  array = ALLOC (allocator, elt_size * n * 2);
+  if (array == NULL)
+    return FALSE;
+  memcpy (array, *parray, elt_size * n);
+  FREE (allocator, *parray);
+  *parray = array;
+  return TRUE;
+}
+
 ProtobufCMessage *
 protobuf_c_message_unpack         (const ProtobufCMessageDescriptor *desc,
                                    ProtobufCAllocator  *allocator,
@@ -1337,20 +1374,12 @@ protobuf_c_message_unpack         (const ProtobufCMessageDescriptor *desc,
   size_t rem = len;
   const uint8_t *at = data;
   const ProtobufCFieldDescriptor *last_field = desc->fields + 0;
-  ScannedMember first_member_slab[16];
-  ScannedMember *scanned_member_slabs[30];               /* size of member i is (1<<(i+4)) */
-  unsigned which_slab = 0;
-  unsigned in_slab_index = 0;
-  size_t n_unknown = 0;
-  unsigned f;
-  unsigned i_slab;
 
   ASSERT_IS_MESSAGE_DESCRIPTOR (desc);
 
   if (allocator == NULL)
     allocator = &protobuf_c_default_allocator;
   rv = ALLOC (allocator, desc->sizeof_message);
-  scanned_member_slabs[0] = first_member_slab;
 
   memset (rv, 0, desc->sizeof_message);
   rv->descriptor = desc;
@@ -1371,22 +1400,29 @@ protobuf_c_message_unpack         (const ProtobufCMessageDescriptor *desc,
                          (unsigned)(at-data)));
           goto error_cleanup;
         }
-      /* XXX: consider optimizing for field[1].id == tag, if field[1] exists! */
       if (last_field->id != tag)
         {
-          /* lookup field */
-          int field_index = int_range_lookup (desc->n_field_ranges,
-                                              desc->field_ranges,
-                                              tag);
-          if (field_index < 0)
+          /* Fields are usually encoded in declaration order; try the next field before searching */
+          if (last_field + 1 < desc->fields + desc->n_fields && last_field[1].id == tag)
             {
-              field = NULL;
-              n_unknown++;
+              field = last_field + 1;
+              last_field = field;
             }
           else
             {
-              field = desc->fields + field_index;
-              last_field = field;
+              /* lookup field */
+              int field_index = int_range_lookup (desc->n_field_ranges,
+                                                  desc->field_ranges,
+                                                  tag);
+              if (field_index < 0)
+                {
+                  field = NULL;
+                }
+              else
+                {
+                  field = desc->fields + field_index;
+                  last_field = field;
+                }
             }
         }
       else
@@ -1404,6 +1440,21 @@ protobuf_c_message_unpack         (const ProtobufCMessageDescriptor *desc,
           {
             unsigned max_len = rem < 10 ? rem : 10;
             unsigned i;
+#if __LITTLE_ENDIAN__
+            /* appblade - 10/19/2026 (word-at-a-time varint scan)
+             * Locate the terminating byte of the first eight from their inverted continuation bits */
+            if (rem >= 8)
+              {
+                uint64_t word, stop;
+                memcpy (&word, at, 8);
+                stop = ~word & 0x8080808080808080ULL;
+                if (stop != 0)
+                  {
+                    tmp.len = (__builtin_ctzll (stop) + 1) / 8;
+                    break;
+                  }
+              }
+#endif
             for (i = 0; i < max_len; i++)
               if ((at[i] & 0x80) == 0)
                 break;
@@ -1453,86 +1504,43 @@ protobuf_c_message_unpack         (const ProtobufCMessageDescriptor *desc,
             }
           tmp.len = 4;
           break;
+        default:
+          /* appblade - 10/19/2026 (single-pass unpack) Wire types 6 and 7 are not defined */
+          UNPACK_ERROR (("invalid wiretype %u at offset %u",
+                         (unsigned) wire_type, (unsigned)(at-data)));
+          goto error_cleanup;
         }
-      if (in_slab_index == (1U<<(which_slab+4)))
+
+      /* Make room for the new element of a repeated or unknown field */
+      if (field == NULL)
         {
-          size_t size;
-          in_slab_index = 0;
-          which_slab++;
-          size = sizeof(ScannedMember) << (which_slab+4);
-          /* TODO: consider using alloca() ! */
-          if (allocator->tmp_alloc != NULL)
-            scanned_member_slabs[which_slab] = TMPALLOC(allocator, size);
-          else
-            scanned_member_slabs[which_slab] = ALLOC(allocator, size);
+          if (!repeated_array_reserve ((void **) &rv->unknown_fields, rv->n_unknown_fields,
+                                       sizeof (ProtobufCMessageUnknownField), allocator))
+            goto error_cleanup;
         }
-      scanned_member_slabs[which_slab][in_slab_index++] = tmp;
-
-      if (field != NULL && field->label == PROTOBUF_C_LABEL_REPEATED)
+      else if (field->label == PROTOBUF_C_LABEL_REPEATED)
         {
-          size_t *n_ptr = (size_t*)((char*)rv + field->quantifier_offset);
-          (*n_ptr) += 1;
+          size_t n = STRUCT_MEMBER (size_t, rv, field->quantifier_offset);
+          if (!repeated_array_reserve (STRUCT_MEMBER_PTR (void *, rv, field->offset), n,
+                                       sizeof_elt_in_repeated_array (field->type), allocator))
+            goto error_cleanup;
         }
 
-      at += tmp.len;
-      rem -= tmp.len;
-    }
-
-  /* allocate space for repeated fields */
-  for (f = 0; f < desc->n_fields; f++)
-    if (desc->fields[f].label == PROTOBUF_C_LABEL_REPEATED)
-      {
-        const ProtobufCFieldDescriptor *field = desc->fields + f;
-        size_t siz = sizeof_elt_in_repeated_array (field->type);
-        size_t *n_ptr = STRUCT_MEMBER_PTR (size_t, rv, field->quantifier_offset);
-        if (*n_ptr != 0)
-          {
-            STRUCT_MEMBER (void *, rv, field->offset) = ALLOC (allocator, siz * (*n_ptr));
-            *n_ptr = 0;
-          }
-      }
-
-  /* allocate space for unknown fields */
-  if (n_unknown)
-    {
-      rv->unknown_fields = ALLOC (allocator, n_unknown * sizeof (ProtobufCMessageUnknownField));
-    }
-
-  /* do real parsing */
-  for (i_slab = 0; i_slab <= which_slab; i_slab++)
-    {
-      unsigned max = (i_slab == which_slab) ? in_slab_index : (1U<<(i_slab+4));
-      ScannedMember *slab = scanned_member_slabs[i_slab];
-      unsigned j;
-      for (j = 0; j < max; j++)
+      if (!parse_member (&tmp, rv, allocator))
         {
-          if (!parse_member (slab + j, rv, allocator))
-            {
-              UNPACK_ERROR (("error parsing member %s of %s",
-                             slab->field ? slab->field->name : "(unknown)", desc->name));
-              goto error_cleanup;
-            }
+          UNPACK_ERROR (("error parsing member %s of %s",
+                         field ? field->name : "(unknown)", desc->name));
+          goto error_cleanup;
         }
-    }
 
-  /* cleanup */
-  if (allocator->tmp_alloc == NULL)
-    {
-      unsigned j;
-      for (j = 1; j <= which_slab; j++)
-        FREE (allocator, scanned_member_slabs[j]);
+      at += tmp.len;
+      rem -= tmp.len;
     }
 
   return rv;
 
 error_cleanup:
   protobuf_c_message_free_unpacked (rv, allocator);
-  if (allocator->tmp_alloc == NULL)
-    {
-      unsigned j;
-      for (j = 1; j <= which_slab; j++)
-        FREE (allocator, scanned_member_slabs[j]);
-    }
   return NULL;
 }
 
@@ -1597,6 +1605,13 @@ protobuf_c_message_free_unpacked  (ProtobufCMessage    *message,
             protobuf_c_message_free_unpacked (sm, allocator);
         }
     }
+
+  /* appblade - 10/19/2026 (single-pass unpack) Release unknown fields, which were previously leaked */
+  for (f = 0; f < message->n_unknown_fields; f++)
+    FREE (allocator, message->unknown_fields[f].data);
+  if (message->unknown_fields != NULL)
+    FREE (allocator, message->unknown_fields);
+
   FREE (allocator, message);
 }
 
@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2008-2011 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Base64 round trip test.
+ *
+ * Checks the SDK's Base64 codec against the RFC 4648 test vectors and a scalar reference encoder, for every
+ * length around the SIMD block sizes and for every way of splitting the input across streaming encoder calls.
+ * Build with the device or simulator flags (eg, -mssse3) to cover the vectorized encoder.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "AppBladeBase64.h"
+
+/* Longest input tested; spans several 48 byte NEON blocks and 12 byte SSSE3 blocks */
+#define TEST_MAX_LENGTH 200
+
+static int failures;
+
+#define TEST_ASSERT(cond, ...) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: ", __FILE__, __LINE__); \
+        fprintf(stderr, __VA_ARGS__); \
+        fprintf(stderr, "\n"); \
+        failures++; \
+    } \
+} while (0)
+
+/*
+ * Encode @a length bytes of @a src a bit at a time, as the reference for the codec under test.
+ */
+static size_t reference_encode (const uint8_t *src, size_t length, char *dst) {
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    size_t written = 0;
+
+    for (size_t i = 0; i < length * 8; i += 6) {
+        unsigned value = 0;
+        for (size_t bit = i; bit < i + 6; bit++) {
+            value <<= 1;
+            if (bit < length * 8)
+                value |= (src[bit / 8] >> (7 - bit % 8)) & 1;
+        }
+        dst[written++] = alphabet[value];
+    }
+    while (written % 4 != 0)
+        dst[written++] = '=';
+
+    return written;
+}
+
+static void test_vectors (void) {
+    static const char *vectors[][2] = {
+        { "", "" },
+        { "f", "Zg==" },
+        { "fo", "Zm8=" },
+        { "foo", "Zm9v" },
+        { "foob", "Zm9vYg==" },
+        { "fooba", "Zm9vYmE=" },
+        { "foobar", "Zm9vYmFy" },
+    };
+    char encoded[16];
+    uint8_t decoded[16];
+    size_t length;
+
+    for (size_t i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++) {
+        const char *plain = vectors[i][0];
+        const char *expected = vectors[i][1];
+
+        length = ab_base64_encode(plain, strlen(plain), encoded);
+        TEST_ASSERT(length == strlen(expected) && memcmp(encoded, expected, length) == 0, "Encoding of \"%s\" is incorrect", plain);
+
+        TEST_ASSERT(ab_base64_decode(expected, strlen(expected), decoded, &length), "Could not decode \"%s\"", expected);
+        TEST_ASSERT(length == strlen(plain) && memcmp(decoded, plain, length) == 0, "Decoding of \"%s\" is incorrect", expected);
+    }
+}
+
+static void test_round_trip (void) {
+    static uint8_t data[TEST_MAX_LENGTH];
+    static char expected[AB_BASE64_ENCODED_LENGTH(TEST_MAX_LENGTH)];
+    static char encoded[AB_BASE64_ENCODED_LENGTH(TEST_MAX_LENGTH)];
+    static uint8_t decoded[AB_BASE64_DECODED_LENGTH(AB_BASE64_ENCODED_LENGTH(TEST_MAX_LENGTH))];
+    uint32_t state = 0x9E3779B9;
+
+    for (size_t i = 0; i < TEST_MAX_LENGTH; i++) {
+        state = state * 1664525 + 1013904223;
+        data[i] = (uint8_t) (state >> 24);
+    }
+
+    for (size_t length = 0; length <= TEST_MAX_LENGTH; length++) {
+        size_t expected_length = reference_encode(data, length, expected);
+        size_t encoded_length;
+        size_t decoded_length;
+
+        encoded_length = ab_base64_encode(data, length, encoded);
+        TEST_ASSERT(encoded_length == AB_BASE64_ENCODED_LENGTH(length), "Encoded %zu bytes to %zu characters", length, encoded_length);
+        TEST_ASSERT(encoded_length == expected_length && memcmp(encoded, expected, expected_length) == 0, "Encoding of %zu bytes is incorrect", length);
+
+        TEST_ASSERT(ab_base64_decode(encoded, encoded_length, decoded, &decoded_length), "Could not decode %zu bytes", length);
+        TEST_ASSERT(decoded_length == length && memcmp(decoded, data, length) == 0, "Round trip of %zu bytes is incorrect", length);
+
+        /* Streaming, split into equal chunks of every size */
+        for (size_t chunk = 1; chunk <= length; chunk++) {
+            ab_base64_encoder_t encoder;
+
+            ab_base64_encoder_init(&encoder);
+            encoded_length = 0;
+            for (size_t offset = 0; offset < length; offset += chunk) {
+                size_t remaining = length - offset;
+                encoded_length += ab_base64_encoder_update(&encoder, data + offset, remaining < chunk ? remaining : chunk, encoded + encoded_length);
+            }
+            encoded_length += ab_base64_encoder_final(&encoder, encoded + encoded_length);
+
+            TEST_ASSERT(encoded_length == expected_length && memcmp(encoded, expected, expected_length) == 0,
+                        "Streaming encoding of %zu bytes in %zu byte chunks is incorrect", length, chunk);
+        }
+    }
+}
+
+static void test_invalid (void) {
+    static const char *invalid[] = {
+        "Zg=",          /* Not a multiple of 4 */
+        "Zg==Zg==",     /* Padding before the final group */
+        "Z===",         /* Padding in the second position */
+        "Zm9v!A==",     /* Outside the alphabet */
+        "Zm9v\nYmFy",   /* Line breaks are not accepted */
+        "Zm=v",         /* Data after padding */
+    };
+    uint8_t decoded[16];
+    size_t length;
+
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++)
+        TEST_ASSERT(!ab_base64_decode(invalid[i], strlen(invalid[i]), decoded, &length), "Decoded invalid input \"%s\"", invalid[i]);
+}
+
+int main (void) {
+    test_vectors();
+    test_round_trip();
+    test_invalid();
+
+    if (failures > 0) {
+        fprintf(stderr, "%d Base64 test failures\n", failures);
+        return 1;
+    }
+
+    printf("Base64 round trip test passed\n");
+    return 0;
+}
@@ -0,0 +1,54 @@
+/*
+ * Author: Landon Fuller <landonf@plausiblelabs.com>
+ *
+ * Copyright (c) 2008-2011 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+
+#import "CrashReporter.h"
+
+/*
+ * Decode and format an encoded crash report with PLCrashReportTextFormatter, returning the
+ * length of the formatted text. Used by the format benchmark (plcrash-bench.c).
+ */
+size_t plcrash_bench_format (const void *data, size_t len) {
+    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+    NSData *encoded = [NSData dataWithBytesNoCopy: (void *) data length: len freeWhenDone: NO];
+    NSError *error;
+    size_t rv;
+
+    PLCrashReport *report = [[[PLCrashReport alloc] initWithData: encoded error: &error] autorelease];
+    if (report == nil) {
+        fprintf(stderr, "Could not decode synthetic report: %s\n", [[error localizedDescription] UTF8String]);
+        exit(1);
+    }
+
+    NSString *text = [PLCrashReportTextFormatter stringValueForCrashReport: report withTextFormat: PLCrashReportTextFormatiOS];
+    rv = [text lengthOfBytesUsingEncoding: NSUTF8StringEncoding];
+
+    [pool release];
+    return rv;
+}
@@ -0,0 +1,1049 @@
+/*
+ * Author: Landon Fuller <landonf@plausiblelabs.com>
+ *
+ * Copyright (c) 2008-2011 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Crash capture and decode benchmarks.
+ *
+ * Only the portable parts of the pipeline are exercised here: the protobuf field encoder, the async-safe
+ * buffered file writer, the protobuf-c decoder, and the SDK's Base64 codec used for upload payloads. Reports are synthesized with the same two-pass
+ * (size, then write) encoding used by PLCrashLogWriter, so no Mach APIs are required. Results are written as
+ * one JSON object per line.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#ifdef __APPLE__
+#include <mach/mach_time.h>
+#else
+#include <time.h>
+#endif
+
+#include "PLCrashAsync.h"
+#include "PLCrashReportEncoder.h"
+#include "crash_report.pb-c.h"
+#include "PLCrashReportDecoder.h"
+#include "PLCrashReportVarint.h"
+#include "PLCrashReportCore.h"
+#include "PLCrashBucket.h"
+#include "PLCrashColumnar.h"
+#include "PLCrashCompression.h"
+#include "AppBladeBase64.h"
+
+/* Crash log file header. Must match PLCRASH_REPORT_FILE_MAGIC and PLCRASH_REPORT_FILE_VERSION (PLCrashReport.h) */
+#define BENCH_REPORT_FILE_MAGIC "plcrash"
+#define BENCH_REPORT_FILE_VERSION 1
+
+/* Number of registers written for the crashed thread (matches x86-64) */
+#define BENCH_REGISTER_COUNT 21
+
+#ifdef PLCRASH_BENCH_FORMAT
+/* Decode and format an encoded report, returning the length of the formatted text (plcrash-bench-format.m) */
+extern size_t plcrash_bench_format (const void *data, size_t len);
+#endif
+
+/**
+ * Synthetic report dimensions.
+ */
+typedef struct bench_report_shape {
+    /** Number of threads */
+    uint32_t threads;
+
+    /** Number of frames per thread */
+    uint32_t frames;
+
+    /** Number of binary images */
+    uint32_t images;
+} bench_report_shape_t;
+
+/** Report shapes exercised by the encode, decode and format benchmarks */
+static const bench_report_shape_t report_shapes[] = {
+    { 1, 16, 16 },
+    { 8, 32, 64 },
+    { 32, 64, 256 },
+    { 128, 128, 512 },
+    /* Deep recursion: a few threads with thousands of frames each */
+    { 4, 4096, 16 },
+};
+
+/** Chunk sizes exercised by the file write benchmark */
+static const size_t write_chunk_sizes[] = { 1, 8, 64, 255, 256, 1024, 4096 };
+
+/** Payload sizes exercised by the Base64 benchmark: a single NEON block, a short field, and a screenshot chunk */
+static const size_t base64_sizes[] = { 48, 1024, 3 * 16 * 1024 };
+
+/** Benchmark configuration */
+static struct {
+    /** Result output */
+    FILE *output;
+
+    /** If non-NULL, only benchmarks whose name contains this string are run */
+    const char *filter;
+
+    /** Iteration count for the field encoding benchmarks */
+    uint64_t pack_iterations;
+
+    /** Bytes written per case by the file write benchmarks */
+    uint64_t write_bytes;
+
+    /** Iteration count for the report benchmarks */
+    uint64_t report_iterations;
+} config;
+
+/* Prevents the compiler from eliding benchmark work */
+static volatile uint64_t bench_sink;
+
+
+/*
+ * Return a monotonic timestamp in nanoseconds.
+ */
+static uint64_t bench_now_ns (void) {
+#ifdef __APPLE__
+    static mach_timebase_info_data_t timebase;
+    if (timebase.denom == 0)
+        mach_timebase_info(&timebase);
+
+    return (mach_absolute_time() * timebase.numer) / timebase.denom;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t) ts.tv_sec * 1000000000ULL) + ts.tv_nsec;
+#endif
+}
+
+/*
+ * Return true if the named benchmark should be run.
+ */
+static bool bench_enabled (const char *name) {
+    if (config.filter == NULL)
+        return true;
+
+    return strstr(name, config.filter) != NULL;
+}
+
+/*
+ * Write a single benchmark result.
+ */
+static void bench_result (const char *name, const char *variant, uint64_t iterations, uint64_t elapsed_ns, uint64_t bytes) {
+    double seconds = (double) elapsed_ns / 1000000000.0;
+
+    fprintf(config.output, "{\"benchmark\":\"%s\",\"variant\":\"%s\",\"iterations\":%llu,\"elapsed_ns\":%llu,"
+            "\"ns_per_op\":%.3f,\"bytes\":%llu,\"mb_per_sec\":%.3f}\n",
+            name, variant, (unsigned long long) iterations, (unsigned long long) elapsed_ns,
+            iterations > 0 ? (double) elapsed_ns / iterations : 0.0, (unsigned long long) bytes,
+            seconds > 0 ? ((double) bytes / (1024.0 * 1024.0)) / seconds : 0.0);
+    fflush(config.output);
+}
+
+/*
+ * Open the null device for writing.
+ */
+static int bench_open_null (void) {
+    int fd = open("/dev/null", O_WRONLY);
+    if (fd < 0) {
+        perror("Could not open /dev/null");
+        exit(1);
+    }
+    return fd;
+}
+
+
+/* === Synthetic report encoding === */
+
+/* Register names (x86-64) */
+static const char *register_names[BENCH_REGISTER_COUNT] = {
+    "rax", "rbx", "rcx", "rdx", "rdi", "rsi", "rbp", "rsp", "r8", "r9", "r10",
+    "r11", "r12", "r13", "r14", "r15", "rip", "rflags", "cs", "fs", "gs"
+};
+
+static size_t bench_write_processor (plcrash_async_file_t *file) {
+    uint32_t encoding = 1; // TYPE_ENCODING_MACH
+    uint64_t type = 0x01000007; // CPU_TYPE_X86_64
+    uint64_t subtype = 3;
+    size_t rv = 0;
+
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_PROCESSOR_ENCODING_ID, PLPROTOBUF_C_TYPE_ENUM, &encoding);
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_PROCESSOR_TYPE_ID, PLPROTOBUF_C_TYPE_UINT64, &type);
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_PROCESSOR_SUBTYPE_ID, PLPROTOBUF_C_TYPE_UINT64, &subtype);
+
+    return rv;
+}
+
+static size_t bench_write_system_info (plcrash_async_file_t *file) {
+    uint32_t os = 0; // MAC_OS_X
+    uint32_t arch = 1; // X86_64
+    int64_t timestamp = 1300000000;
+    size_t rv = 0;
+
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_SYSTEM_INFO_OPERATING_SYSTEM_ID, PLPROTOBUF_C_TYPE_ENUM, &os);
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_SYSTEM_INFO_OS_VERSION_ID, PLPROTOBUF_C_TYPE_STRING, "10.6.7");
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_SYSTEM_INFO_OS_BUILD_ID, PLPROTOBUF_C_TYPE_STRING, "10J869");
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_SYSTEM_INFO_ARCHITECTURE_ID, PLPROTOBUF_C_TYPE_ENUM, &arch);
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_SYSTEM_INFO_TIMESTAMP_ID, PLPROTOBUF_C_TYPE_INT64, &timestamp);
+
+    return rv;
+}
+
+static size_t bench_write_machine_info (plcrash_async_file_t *file) {
+    uint32_t count = 4;
+    uint32_t size;
+    size_t rv = 0;
+
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_MACHINE_INFO_MODEL_ID, PLPROTOBUF_C_TYPE_STRING, "MacBookPro6,1");
+
+    size = bench_write_processor(NULL);
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_MACHINE_INFO_PROCESSOR_ID, PLPROTOBUF_C_TYPE_MESSAGE, &size);
+    rv += bench_write_processor(file);
+
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_MACHINE_INFO_PROCESSOR_COUNT_ID, PLPROTOBUF_C_TYPE_UINT32, &count);
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_MACHINE_INFO_LOGICAL_PROCESSOR_COUNT_ID, PLPROTOBUF_C_TYPE_UINT32, &count);
+
+    return rv;
+}
+
+static size_t bench_write_app_info (plcrash_async_file_t *file) {
+    size_t rv = 0;
+
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_APPLICATION_INFO_IDENTIFIER_ID, PLPROTOBUF_C_TYPE_STRING, "com.example.bench");
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_APPLICATION_INFO_VERSION_ID, PLPROTOBUF_C_TYPE_STRING, "1.0");
+
+    return rv;
+}
+
+static size_t bench_write_process_info (plcrash_async_file_t *file) {
+    uint32_t pid = 1234;
+    uint32_t ppid = 1;
+    bool native = true;
+    size_t rv = 0;
+
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_PROCESS_INFO_PROCESS_NAME_ID, PLPROTOBUF_C_TYPE_STRING, "bench");
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_PROCESS_INFO_PROCESS_ID_ID, PLPROTOBUF_C_TYPE_UINT32, &pid);
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_PROCESS_INFO_PROCESS_PATH_ID, PLPROTOBUF_C_TYPE_STRING, "/Applications/Bench.app/Contents/MacOS/bench");
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_PROCESS_INFO_PARENT_PROCESS_NAME_ID, PLPROTOBUF_C_TYPE_STRING, "launchd");
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_PROCESS_INFO_PARENT_PROCESS_ID_ID, PLPROTOBUF_C_TYPE_UINT32, &ppid);
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_PROCESS_INFO_NATIVE_ID, PLPROTOBUF_C_TYPE_BOOL, &native);
+
+    return rv;
+}
+
+/* Base address of the synthetic binary image at the given index */
+static uint64_t bench_image_base (uint32_t index) {
+    return 0x100000000ULL + ((uint64_t) index * 0x200000ULL);
+}
+
+static size_t bench_write_frame (plcrash_async_file_t *file, uint64_t pc) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_THREAD_STACK_FRAME_PC_ID, PLPROTOBUF_C_TYPE_UINT64, &pc);
+}
+
+static size_t bench_write_register (plcrash_async_file_t *file, const char *name, uint64_t value) {
+    size_t rv = 0;
+
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_THREAD_REGISTER_VALUE_NAME_ID, PLPROTOBUF_C_TYPE_STRING, name);
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_THREAD_REGISTER_VALUE_VALUE_ID, PLPROTOBUF_C_TYPE_UINT64, &value);
+
+    return rv;
+}
+
+static size_t bench_write_thread (plcrash_async_file_t *file, const bench_report_shape_t *shape, uint32_t thread_number) {
+    bool crashed = (thread_number == 0);
+    size_t rv = 0;
+
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_THREAD_THREAD_NUMBER_ID, PLPROTOBUF_C_TYPE_UINT32, &thread_number);
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_THREAD_CRASHED_ID, PLPROTOBUF_C_TYPE_BOOL, &crashed);
+
+    /* Spread the frames across the loaded images */
+    for (uint32_t i = 0; i < shape->frames; i++) {
+        uint32_t image = (thread_number * 31 + i * 7) % shape->images;
+        uint64_t pc = bench_image_base(image) + 0x1000 + ((i * 0x9E37) & 0xFFFF);
+        uint32_t size;
+
+        size = bench_write_frame(NULL, pc);
+        rv += plcrash_writer_pack(file, PLCRASH_PROTO_THREAD_FRAMES_ID, PLPROTOBUF_C_TYPE_MESSAGE, &size);
+        rv += bench_write_frame(file, pc);
+    }
+
+    /* Registers are only written for the crashed thread */
+    if (crashed) {
+        for (uint32_t i = 0; i < BENCH_REGISTER_COUNT; i++) {
+            uint64_t value = 0x7fff5fbff000ULL + i * 8;
+            uint32_t size;
+
+            size = bench_write_register(NULL, register_names[i], value);
+            rv += plcrash_writer_pack(file, PLCRASH_PROTO_THREAD_REGISTERS_ID, PLPROTOBUF_C_TYPE_MESSAGE, &size);
+            rv += bench_write_register(file, register_names[i], value);
+        }
+    }
+
+    return rv;
+}
+
+static size_t bench_write_binary_image (plcrash_async_file_t *file, uint32_t index) {
+    uint64_t base = bench_image_base(index);
+    uint64_t length = 0x180000;
+    uint8_t uuid_bytes[16];
+    PLProtobufCBinaryData uuid;
+    char name[64];
+    uint32_t size;
+    size_t rv = 0;
+
+    snprintf(name, sizeof(name), "/usr/lib/libbench%u.dylib", index);
+    for (size_t i = 0; i < sizeof(uuid_bytes); i++)
+        uuid_bytes[i] = (uint8_t) (index + i);
+
+    uuid.len = sizeof(uuid_bytes);
+    uuid.data = uuid_bytes;
+
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_BINARY_IMAGE_BASE_ADDRESS_ID, PLPROTOBUF_C_TYPE_UINT64, &base);
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_BINARY_IMAGE_SIZE_ID, PLPROTOBUF_C_TYPE_UINT64, &length);
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_BINARY_IMAGE_NAME_ID, PLPROTOBUF_C_TYPE_STRING, name);
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_BINARY_IMAGE_UUID_ID, PLPROTOBUF_C_TYPE_BYTES, &uuid);
+
+    size = bench_write_processor(NULL);
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_BINARY_IMAGE_CODE_TYPE_ID, PLPROTOBUF_C_TYPE_MESSAGE, &size);
+    rv += bench_write_processor(file);
+
+    return rv;
+}
+
+static size_t bench_write_signal (plcrash_async_file_t *file) {
+    uint64_t address = 0x0;
+    size_t rv = 0;
+
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_SIGNAL_NAME_ID, PLPROTOBUF_C_TYPE_STRING, "SIGSEGV");
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_SIGNAL_CODE_ID, PLPROTOBUF_C_TYPE_STRING, "SEGV_MAPERR");
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_SIGNAL_ADDRESS_ID, PLPROTOBUF_C_TYPE_UINT64, &address);
+
+    return rv;
+}
+
+/*
+ * Write a complete synthetic crash report, including the file header, in the same order and with the same
+ * two-pass encoding used by plcrash_log_writer_write(). Returns the number of bytes written.
+ */
+static size_t bench_write_report (plcrash_async_file_t *file, const bench_report_shape_t *shape) {
+    uint8_t version = BENCH_REPORT_FILE_VERSION;
+    uint32_t size;
+    size_t rv = 0;
+
+    /* File header */
+    plcrash_async_file_write(file, BENCH_REPORT_FILE_MAGIC, strlen(BENCH_REPORT_FILE_MAGIC));
+    plcrash_async_file_write(file, &version, sizeof(version));
+    rv += strlen(BENCH_REPORT_FILE_MAGIC) + sizeof(version);
+
+    size = bench_write_system_info(NULL);
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_CRASH_REPORT_SYSTEM_INFO_ID, PLPROTOBUF_C_TYPE_MESSAGE, &size);
+    rv += bench_write_system_info(file);
+
+    size = bench_write_machine_info(NULL);
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_CRASH_REPORT_MACHINE_INFO_ID, PLPROTOBUF_C_TYPE_MESSAGE, &size);
+    rv += bench_write_machine_info(file);
+
+    size = bench_write_app_info(NULL);
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_CRASH_REPORT_APPLICATION_INFO_ID, PLPROTOBUF_C_TYPE_MESSAGE, &size);
+    rv += bench_write_app_info(file);
+
+    size = bench_write_process_info(NULL);
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_CRASH_REPORT_PROCESS_INFO_ID, PLPROTOBUF_C_TYPE_MESSAGE, &size);
+    rv += bench_write_process_info(file);
+
+    for (uint32_t i = 0; i < shape->threads; i++) {
+        size = bench_write_thread(NULL, shape, i);
+        rv += plcrash_writer_pack(file, PLCRASH_PROTO_CRASH_REPORT_THREADS_ID, PLPROTOBUF_C_TYPE_MESSAGE, &size);
+        rv += bench_write_thread(file, shape, i);
+    }
+
+    for (uint32_t i = 0; i < shape->images; i++) {
+        size = bench_write_binary_image(NULL, i);
+        rv += plcrash_writer_pack(file, PLCRASH_PROTO_CRASH_REPORT_BINARY_IMAGES_ID, PLPROTOBUF_C_TYPE_MESSAGE, &size);
+        rv += bench_write_binary_image(file, i);
+    }
+
+    size = bench_write_signal(NULL);
+    rv += plcrash_writer_pack(file, PLCRASH_PROTO_CRASH_REPORT_SIGNAL_ID, PLPROTOBUF_C_TYPE_MESSAGE, &size);
+    rv += bench_write_signal(file);
+
+    return rv;
+}
+
+/*
+ * Encode a synthetic report into a newly allocated buffer. The caller is responsible for free()ing
+ * the returned buffer.
+ */
+static uint8_t *bench_encode_report (const bench_report_shape_t *shape, size_t *length) {
+    plcrash_async_file_t file;
+    char path[] = "/tmp/plcrash-bench.XXXXXX";
+    struct stat statbuf;
+    uint8_t *data;
+    int fd;
+
+    if ((fd = mkstemp(path)) < 0) {
+        perror("Could not create temporary file");
+        exit(1);
+    }
+    unlink(path);
+
+    plcrash_async_file_init(&file, fd, 0);
+    bench_write_report(&file, shape);
+    plcrash_async_file_flush(&file);
+
+    if (fstat(fd, &statbuf) != 0 || (data = malloc(statbuf.st_size)) == NULL) {
+        perror("Could not read temporary file");
+        exit(1);
+    }
+
+    if (pread(fd, data, statbuf.st_size, 0) != statbuf.st_size) {
+        perror("Could not read temporary file");
+        exit(1);
+    }
+
+    plcrash_async_file_close(&file);
+
+    *length = statbuf.st_size;
+    return data;
+}
+
+
+/* === Benchmarks === */
+
+/*
+ * Measure plcrash_writer_pack() throughput for a single field type.
+ */
+static void bench_pack_field (const char *variant, PLProtobufCType type, const void *value) {
+    plcrash_async_file_t file;
+    uint64_t bytes = 0;
+    uint64_t start;
+
+    plcrash_async_file_init(&file, bench_open_null(), 0);
+
+    start = bench_now_ns();
+    for (uint64_t i = 0; i < config.pack_iterations; i++)
+        bytes += plcrash_writer_pack(&file, 1, type, value);
+    plcrash_async_file_flush(&file);
+
+    bench_result("pack", variant, config.pack_iterations, bench_now_ns() - start, bytes);
+    plcrash_async_file_close(&file);
+}
+
+static void bench_pack (void) {
+    uint32_t small32 = 42;
+    uint32_t large32 = 0xFFFFFFF0;
+    uint64_t small64 = 42;
+    uint64_t large64 = 0x7fff5fbff8a0ULL;
+    int64_t negative64 = -1;
+    bool boolean = true;
+    uint32_t message_length = 300;
+    uint8_t bytes[16] = { 0 };
+    PLProtobufCBinaryData binary = { sizeof(bytes), bytes };
+
+    if (!bench_enabled("pack"))
+        return;
+
+    bench_pack_field("uint32.small", PLPROTOBUF_C_TYPE_UINT32, &small32);
+    bench_pack_field("uint32.large", PLPROTOBUF_C_TYPE_UINT32, &large32);
+    bench_pack_field("uint64.small", PLPROTOBUF_C_TYPE_UINT64, &small64);
+    bench_pack_field("uint64.large", PLPROTOBUF_C_TYPE_UINT64, &large64);
+    bench_pack_field("int64.negative", PLPROTOBUF_C_TYPE_INT64, &negative64);
+    bench_pack_field("sint64.negative", PLPROTOBUF_C_TYPE_SINT64, &negative64);
+    bench_pack_field("fixed64", PLPROTOBUF_C_TYPE_FIXED64, &large64);
+    bench_pack_field("bool", PLPROTOBUF_C_TYPE_BOOL, &boolean);
+    bench_pack_field("string.short", PLPROTOBUF_C_TYPE_STRING, "SIGSEGV");
+    bench_pack_field("string.path", PLPROTOBUF_C_TYPE_STRING, "/System/Library/Frameworks/Foundation.framework/Versions/C/Foundation");
+    bench_pack_field("bytes.uuid", PLPROTOBUF_C_TYPE_BYTES, &binary);
+    bench_pack_field("message.header", PLPROTOBUF_C_TYPE_MESSAGE, &message_length);
+}
+
+/*
+ * Measure plcrash_async_file_write() throughput for a range of write sizes.
+ */
+static void bench_file_write (void) {
+    static uint8_t chunk[4096];
+
+    if (!bench_enabled("file_write"))
+        return;
+
+    memset(chunk, 0xA5, sizeof(chunk));
+
+    for (size_t i = 0; i < sizeof(write_chunk_sizes) / sizeof(write_chunk_sizes[0]); i++) {
+        size_t chunk_size = write_chunk_sizes[i];
+        uint64_t iterations = config.write_bytes / chunk_size;
+        plcrash_async_file_t file;
+        char variant[32];
+        uint64_t start;
+
+        plcrash_async_file_init(&file, bench_open_null(), 0);
+
+        start = bench_now_ns();
+        for (uint64_t j = 0; j < iterations; j++)
+            plcrash_async_file_write(&file, chunk, chunk_size);
+        plcrash_async_file_flush(&file);
+
+        snprintf(variant, sizeof(variant), "chunk.%zu", chunk_size);
+        bench_result("file_write", variant, iterations, bench_now_ns() - start, iterations * chunk_size);
+        plcrash_async_file_close(&file);
+    }
+}
+
+/*
+ * Encode @a count varints into @a buf, drawn from the given value generator. Returns the encoded length.
+ */
+static size_t bench_varint_encode (uint8_t *buf, size_t count, uint64_t (*generator)(uint32_t)) {
+    size_t length = 0;
+
+    for (uint32_t i = 0; i < count; i++) {
+        uint64_t value = generator(i);
+        do {
+            buf[length++] = (value & 0x7F) | (value > 0x7F ? 0x80 : 0);
+            value >>= 7;
+        } while (value != 0);
+    }
+
+    return length;
+}
+
+/* Frame PCs within a 64-bit process' text segments; five byte varints */
+static uint64_t bench_varint_pc (uint32_t i) {
+    return bench_image_base(i % 16) + ((i * 2654435761U) % 0x100000);
+}
+
+/* A register set: stack addresses, pointers, small integers, and the occasional negative value */
+static uint64_t bench_varint_mixed (uint32_t i) {
+    switch (i % 4) {
+        case 0: return 0x7fff5fbff000ULL + (i % 4096);
+        case 1: return bench_image_base(i % 16) + (i % 65536);
+        case 2: return i % 300;
+        default: return (i % 64) == 3 ? (uint64_t) -1 : i;
+    }
+}
+
+/* Values of one to eight encoded bytes in no predictable order, as found in unknown or mixed-type data */
+static uint64_t bench_varint_random (uint32_t i) {
+    uint64_t hash = (i + 1) * 0x9E3779B97F4A7C15ULL;
+    unsigned bits;
+
+    /* splitmix64 finalizer */
+    hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBULL;
+    hash ^= hash >> 31;
+
+    bits = 7 * (1 + (unsigned) (hash >> 61));
+    return (hash & ((1ULL << bits) - 1)) | (1ULL << (bits - 1));
+}
+
+/*
+ * Measure varint decoding throughput of the word-at-a-time decoder against the scalar decoder. Each
+ * iteration is a single decoded value; values per second is 1e9 / ns_per_op.
+ */
+static void bench_varint (void) {
+    static const struct {
+        const char *name;
+        uint64_t (*generator)(uint32_t);
+    } sets[] = {
+        { "pc", bench_varint_pc },
+        { "mixed", bench_varint_mixed },
+        { "random", bench_varint_random },
+    };
+    const size_t count = 65536;
+    uint64_t rounds = config.pack_iterations / count + 1;
+    uint8_t *buf;
+
+    if (!bench_enabled("varint"))
+        return;
+
+    buf = malloc(count * 10);
+    for (size_t i = 0; i < sizeof(sets) / sizeof(sets[0]); i++) {
+        size_t length = bench_varint_encode(buf, count, sets[i].generator);
+        const uint8_t *end = buf + length;
+        char variant[32];
+        uint64_t start;
+
+        for (int word = 0; word < 2; word++) {
+            uint64_t sum = 0;
+
+            start = bench_now_ns();
+            for (uint64_t r = 0; r < rounds; r++) {
+                const uint8_t *pos = buf;
+                uint64_t value;
+
+                while (pos < end) {
+                    bool ok = word ? plcrash_varint_decode(&pos, end, &value) : plcrash_varint_decode_scalar(&pos, end, &value);
+                    if (!ok) {
+                        fprintf(stderr, "Could not decode varint %s\n", sets[i].name);
+                        exit(1);
+                    }
+                    sum += value;
+                }
+            }
+            bench_sink += sum;
+
+            snprintf(variant, sizeof(variant), "%s.%s", sets[i].name, word ? "word" : "scalar");
+            bench_result("varint", variant, rounds * count, bench_now_ns() - start, rounds * length);
+        }
+    }
+    free(buf);
+}
+
+/*
+ * Measure AppBladeBase64 throughput: one-shot encoding, streaming encoding in uneven chunks, and decoding. Each
+ * round trip is verified before timing. Bytes are always counted on the unencoded side.
+ */
+static void bench_base64 (void) {
+    if (!bench_enabled("base64"))
+        return;
+
+    for (size_t i = 0; i < sizeof(base64_sizes) / sizeof(base64_sizes[0]); i++) {
+        size_t size = base64_sizes[i];
+        uint64_t iterations = config.write_bytes / size;
+        uint8_t *data = malloc(size);
+        uint8_t *decoded = malloc(AB_BASE64_DECODED_LENGTH(AB_BASE64_ENCODED_LENGTH(size)));
+        char *encoded = malloc(AB_BASE64_ENCODED_LENGTH(size));
+        size_t encoded_length;
+        size_t decoded_length;
+        char variant[32];
+        uint64_t start;
+        uint64_t sum;
+
+        if (data == NULL || decoded == NULL || encoded == NULL) {
+            perror("Could not allocate Base64 buffers");
+            exit(1);
+        }
+
+        for (size_t j = 0; j < size; j++)
+            data[j] = (uint8_t) bench_varint_random((uint32_t) j);
+
+        encoded_length = ab_base64_encode(data, size, encoded);
+        if (!ab_base64_decode(encoded, encoded_length, decoded, &decoded_length) || decoded_length != size ||
+            memcmp(data, decoded, size) != 0)
+        {
+            fprintf(stderr, "Base64 round trip of %zu bytes failed\n", size);
+            exit(1);
+        }
+
+        sum = 0;
+        start = bench_now_ns();
+        for (uint64_t j = 0; j < iterations; j++)
+            sum += ab_base64_encode(data, size, encoded);
+        bench_sink += sum;
+        snprintf(variant, sizeof(variant), "encode.%zu", size);
+        bench_result("base64", variant, iterations, bench_now_ns() - start, iterations * size);
+
+        /* Chunks of 7 bytes less than the payload carry a partial group into every call */
+        sum = 0;
+        start = bench_now_ns();
+        for (uint64_t j = 0; j < iterations; j++) {
+            ab_base64_encoder_t encoder;
+            size_t offset = 0;
+            size_t chunk = size > 7 ? size - 7 : 1;
+
+            size_t written = 0;
+
+            ab_base64_encoder_init(&encoder);
+            while (offset < size) {
+                size_t length = (size - offset < chunk) ? size - offset : chunk;
+                written += ab_base64_encoder_update(&encoder, data + offset, length, encoded + written);
+                offset += length;
+            }
+            written += ab_base64_encoder_final(&encoder, encoded + written);
+            sum += written;
+        }
+        bench_sink += sum;
+        snprintf(variant, sizeof(variant), "encode_stream.%zu", size);
+        bench_result("base64", variant, iterations, bench_now_ns() - start, iterations * size);
+
+        sum = 0;
+        start = bench_now_ns();
+        for (uint64_t j = 0; j < iterations; j++) {
+            if (!ab_base64_decode(encoded, encoded_length, decoded, &decoded_length)) {
+                fprintf(stderr, "Could not decode %zu Base64 bytes\n", size);
+                exit(1);
+            }
+            sum += decoded[j % decoded_length];
+        }
+        bench_sink += sum;
+        snprintf(variant, sizeof(variant), "decode.%zu", size);
+        bench_result("base64", variant, iterations, bench_now_ns() - start, iterations * size);
+
+        free(data);
+        free(decoded);
+        free(encoded);
+    }
+}
+
+/*
+ * Measure end-to-end encoding, decoding and formatting of synthetic reports.
+ */
+static void bench_reports (void) {
+    for (size_t i = 0; i < sizeof(report_shapes) / sizeof(report_shapes[0]); i++) {
+        const bench_report_shape_t *shape = &report_shapes[i];
+        uint64_t iterations = config.report_iterations;
+        uint8_t *data;
+        size_t length;
+        char variant[64];
+        uint64_t start;
+
+        snprintf(variant, sizeof(variant), "t%u.f%u.i%u", shape->threads, shape->frames, shape->images);
+        data = bench_encode_report(shape, &length);
+
+        /* Encode */
+        if (bench_enabled("encode")) {
+            plcrash_async_file_t file;
+            uint64_t bytes = 0;
+
+            plcrash_async_file_init(&file, bench_open_null(), 0);
+
+            start = bench_now_ns();
+            for (uint64_t j = 0; j < iterations; j++)
+                bytes += bench_write_report(&file, shape);
+            plcrash_async_file_flush(&file);
+
+            bench_result("encode", variant, iterations, bench_now_ns() - start, bytes);
+            plcrash_async_file_close(&file);
+        }
+
+        /* Decode */
+        if (bench_enabled("decode")) {
+            const uint8_t *body = data + strlen(BENCH_REPORT_FILE_MAGIC) + 1;
+            size_t body_length = length - (strlen(BENCH_REPORT_FILE_MAGIC) + 1);
+
+            start = bench_now_ns();
+            for (uint64_t j = 0; j < iterations; j++) {
+                ProtobufCMessage *msg;
+
+                msg = protobuf_c_message_unpack(&plcrash__crash_report__descriptor, &protobuf_c_system_allocator, body_length, body);
+                if (msg == NULL) {
+                    fprintf(stderr, "Could not decode synthetic report %s\n", variant);
+                    exit(1);
+                }
+
+                bench_sink += ((Plcrash__CrashReport *) msg)->n_threads;
+                protobuf_c_message_free_unpacked(msg, &protobuf_c_system_allocator);
+            }
+
+            bench_result("decode", variant, iterations, bench_now_ns() - start, (uint64_t) body_length * iterations);
+
+            /* Schema-specialized decoder */
+            start = bench_now_ns();
+            for (uint64_t j = 0; j < iterations; j++) {
+                Plcrash__CrashReport *report;
+
+                report = plcrash_proto_crash_report_unpack(&protobuf_c_system_allocator, body_length, body);
+                if (report == NULL) {
+                    fprintf(stderr, "Could not decode synthetic report %s with the generated decoder\n", variant);
+                    exit(1);
+                }
+
+                bench_sink += report->n_threads;
+                protobuf_c_message_free_unpacked((ProtobufCMessage *) report, &protobuf_c_system_allocator);
+            }
+
+            bench_result("decode_generated", variant, iterations, bench_now_ns() - start, (uint64_t) body_length * iterations);
+        }
+
+        /* Format */
+        if (bench_enabled("format")) {
+            plcrash_report_output_t output;
+            char fd_buffer[16384];
+            uint64_t bytes = 0;
+            int null_fd;
+
+            /* Foundation-free decode and format, reusing the output buffer across iterations */
+            plcrash_report_output_init_buffer(&output, 0);
+            start = bench_now_ns();
+            for (uint64_t j = 0; j < iterations; j++) {
+                plcrash_report_t report;
+
+                if (plcrash_report_decode(&report, data, length, NULL) != PLCRASH_ESUCCESS) {
+                    fprintf(stderr, "Could not decode synthetic report %s with the core decoder\n", variant);
+                    exit(1);
+                }
+
+                plcrash_report_output_reset(&output);
+                if (plcrash_report_write_text(&report, PLCRASH_REPORT_TEXT_FORMAT_IOS, &output) != PLCRASH_ESUCCESS) {
+                    fprintf(stderr, "Could not format synthetic report %s\n", variant);
+                    exit(1);
+                }
+
+                bytes += output.length;
+                plcrash_report_free(&report);
+            }
+            bench_result("format_core", variant, iterations, bench_now_ns() - start, bytes);
+            plcrash_report_output_free(&output);
+
+            /* Stream directly to a file descriptor, as plcrashutil does */
+            if ((null_fd = open("/dev/null", O_WRONLY)) == -1) {
+                perror("Could not open /dev/null");
+                exit(1);
+            }
+
+            bytes = 0;
+            plcrash_report_output_init_fd(&output, null_fd, fd_buffer, sizeof(fd_buffer));
+            start = bench_now_ns();
+            for (uint64_t j = 0; j < iterations; j++) {
+                plcrash_report_t report;
+
+                if (plcrash_report_decode(&report, data, length, NULL) != PLCRASH_ESUCCESS) {
+                    fprintf(stderr, "Could not decode synthetic report %s with the core decoder\n", variant);
+                    exit(1);
+                }
+
+                if (plcrash_report_write_text(&report, PLCRASH_REPORT_TEXT_FORMAT_IOS, &output) != PLCRASH_ESUCCESS) {
+                    fprintf(stderr, "Could not write synthetic report %s\n", variant);
+                    exit(1);
+                }
+
+                plcrash_report_free(&report);
+            }
+            bytes = output.total;
+            bench_result("format_core_fd", variant, iterations, bench_now_ns() - start, bytes);
+            close(null_fd);
+
+#ifdef PLCRASH_BENCH_FORMAT
+            bytes = 0;
+            start = bench_now_ns();
+            for (uint64_t j = 0; j < iterations; j++)
+                bytes += plcrash_bench_format(data, length);
+
+            bench_result("format", variant, iterations, bench_now_ns() - start, bytes);
+#endif
+        }
+
+        /* JSON export */
+        if (bench_enabled("json")) {
+            plcrash_report_output_t output;
+            uint64_t bytes = 0;
+
+            plcrash_report_output_init_buffer(&output, 0);
+            start = bench_now_ns();
+            for (uint64_t j = 0; j < iterations; j++) {
+                plcrash_report_t report;
+
+                if (plcrash_report_decode(&report, data, length, NULL) != PLCRASH_ESUCCESS) {
+                    fprintf(stderr, "Could not decode synthetic report %s with the core decoder\n", variant);
+                    exit(1);
+                }
+
+                plcrash_report_output_reset(&output);
+                if (plcrash_report_write_json(&report, &output) != PLCRASH_ESUCCESS) {
+                    fprintf(stderr, "Could not export synthetic report %s\n", variant);
+                    exit(1);
+                }
+
+                bytes += output.length;
+                plcrash_report_free(&report);
+            }
+            bench_result("json", variant, iterations, bench_now_ns() - start, bytes);
+            plcrash_report_output_free(&output);
+        }
+
+        /* gzip compression for upload, and decode of the compressed report */
+        if (bench_enabled("gzip")) {
+            plcrash_report_output_t output;
+            uint64_t bytes = 0;
+
+            plcrash_report_output_init_buffer(&output, 0);
+            start = bench_now_ns();
+            for (uint64_t j = 0; j < iterations; j++) {
+                plcrash_report_output_reset(&output);
+                if (plcrash_gzip_compress(data, length, &output) != PLCRASH_ESUCCESS) {
+                    fprintf(stderr, "Could not compress synthetic report %s\n", variant);
+                    exit(1);
+                }
+                bytes += output.length;
+            }
+            bench_result("gzip", variant, iterations, bench_now_ns() - start, bytes);
+
+            start = bench_now_ns();
+            for (uint64_t j = 0; j < iterations; j++) {
+                plcrash_report_t report;
+
+                if (plcrash_report_decode(&report, output.buffer, output.length, NULL) != PLCRASH_ESUCCESS) {
+                    fprintf(stderr, "Could not decode compressed synthetic report %s\n", variant);
+                    exit(1);
+                }
+
+                bench_sink += report.thread_count;
+                plcrash_report_free(&report);
+            }
+            bench_result("gzip_decode", variant, iterations, bench_now_ns() - start, (uint64_t) output.length * iterations);
+            plcrash_report_output_free(&output);
+        }
+
+        /* Fingerprint and bucket */
+        if (bench_enabled("bucket")) {
+            plcrash_bucket_table_t table;
+
+            if (plcrash_bucket_table_init(&table, PLCRASH_BUCKET_DEFAULT_FRAMES) != PLCRASH_ESUCCESS) {
+                fprintf(stderr, "Could not initialize the bucket table\n");
+                exit(1);
+            }
+
+            /* Decode and bucket, as performed per report by plcrash_bucket_table_add_paths() */
+            start = bench_now_ns();
+            for (uint64_t j = 0; j < iterations; j++) {
+                plcrash_report_t report;
+
+                if (plcrash_report_decode(&report, data, length, NULL) != PLCRASH_ESUCCESS) {
+                    fprintf(stderr, "Could not decode synthetic report %s with the core decoder\n", variant);
+                    exit(1);
+                }
+
+                if (plcrash_bucket_table_add(&table, &report, "bench.plcrash") != PLCRASH_ESUCCESS) {
+                    fprintf(stderr, "Could not bucket synthetic report %s\n", variant);
+                    exit(1);
+                }
+
+                plcrash_report_free(&report);
+            }
+            bench_result("bucket", variant, iterations, bench_now_ns() - start, (uint64_t) length * iterations);
+            plcrash_bucket_table_free(&table);
+        }
+
+        /* Columnar export, on a single thread, of the report written to disk once per iteration */
+        if (bench_enabled("columnar")) {
+            char input[] = "/tmp/plcrash-bench.XXXXXX";
+            char directory[] = "/tmp/plcrash-bench-columns.XXXXXX";
+            plcrash_columnar_stats_t stats;
+            const char **paths;
+            struct dirent *entry;
+            DIR *dir;
+            int input_fd;
+
+            if ((input_fd = mkstemp(input)) < 0 || write(input_fd, data, length) != (ssize_t) length || mkdtemp(directory) == NULL) {
+                perror("Could not create columnar export files");
+                exit(1);
+            }
+            close(input_fd);
+
+            if ((paths = malloc(iterations * sizeof(*paths))) == NULL) {
+                perror("Could not allocate columnar export paths");
+                exit(1);
+            }
+            for (uint64_t j = 0; j < iterations; j++)
+                paths[j] = input;
+
+            start = bench_now_ns();
+            if (plcrash_columnar_export(directory, paths, iterations, 1, &stats) != PLCRASH_ESUCCESS || stats.reports != iterations) {
+                fprintf(stderr, "Could not export synthetic report %s\n", variant);
+                exit(1);
+            }
+            bench_result("columnar", variant, iterations, bench_now_ns() - start, (uint64_t) length * iterations);
+
+            /* Remove the exported columns */
+            if ((dir = opendir(directory)) != NULL) {
+                while ((entry = readdir(dir)) != NULL) {
+                    char path[sizeof(directory) + 256];
+
+                    if (entry->d_name[0] == '.')
+                        continue;
+
+                    snprintf(path, sizeof(path), "%s/%s", directory, entry->d_name);
+                    unlink(path);
+                }
+                closedir(dir);
+            }
+            rmdir(directory);
+            unlink(input);
+            free(paths);
+        }
+
+        free(data);
+    }
+}
+
+/*
+ * Print command line usage.
+ */
+static void print_usage (void) {
+    fprintf(stderr, "Usage: plcrash-bench [-o <file>] [-f <filter>] [-s <scale>]\n"
+                    "  -o <file>     Write results to the given file (default: stdout).\n"
+                    "  -f <filter>   Only run benchmarks whose name contains the given string.\n"
+                    "                Benchmarks: pack, file_write, varint, encode, decode, repack, format, json,\n"
+                    "                gzip, bucket, columnar, base64.\n"
+                    "  -s <scale>    Multiply all iteration counts by the given factor (default: 1).\n\n"
+                    "Results are written as one JSON object per line.\n");
+}
+
+int main (int argc, char *argv[]) {
+    double scale = 1.0;
+    int ch;
+
+    config.output = stdout;
+
+    while ((ch = getopt(argc, argv, "o:f:s:h")) != -1) {
+        switch (ch) {
+            case 'o':
+                if ((config.output = fopen(optarg, "w")) == NULL) {
+                    perror("Could not open output file");
+                    return 1;
+                }
+                break;
+            case 'f':
+                config.filter = optarg;
+                break;
+            case 's':
+                scale = strtod(optarg, NULL);
+                if (scale <= 0) {
+                    print_usage();
+                    return 1;
+                }
+                break;
+            default:
+                print_usage();
+                return 1;
+        }
+    }
+
+    config.pack_iterations = (uint64_t) (2000000 * scale);
+    config.write_bytes = (uint64_t) (32 * 1024 * 1024 * scale);
+    config.report_iterations = (uint64_t) (200 * scale);
+    if (config.report_iterations == 0)
+        config.report_iterations = 1;
+
+#ifndef PLCRASH_BENCH_FORMAT
+    if (bench_enabled("format"))
+        fprintf(stderr, "PLCrashReportTextFormatter requires Foundation; only the format_core benchmark is available\n");
+#endif
+
+    bench_pack();
+    bench_file_write();
+    bench_varint();
+    bench_base64();
+    bench_reports();
+
+    if (config.output != stdout)
+        fclose(config.output);
+
+    return 0;
+}
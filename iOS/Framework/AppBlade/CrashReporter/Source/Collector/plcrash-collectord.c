@@ -0,0 +1,256 @@
+/*
+ * Copyright (c) 2008-2011 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/*
+ * Host-wide crash collector daemon.
+ *
+ * Listens on a Unix domain socket for reports submitted with plcrash_collector_submit(), deduplicates and
+ * compresses them, and uploads them in batches to a single HTTP endpoint; see PLCrashCollector.h. With -c, submits
+ * the given report files to a running collector instead, printing the collector's reply to each.
+ */
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <sys/stat.h>
+
+#include "PLCrashCollector.h"
+
+/* Set by the termination signal handler */
+static volatile sig_atomic_t stop_requested = 0;
+
+/*
+ * Request a clean shutdown.
+ */
+static void handle_stop (int signo) {
+    (void) signo;
+    stop_requested = 1;
+}
+
+/*
+ * Print command line usage.
+ */
+static void print_usage (void) {
+    fprintf(stderr, "Usage: plcrash-collectord -s <socket> -u <url> [-m <mode>] [-b <reports>] [-B <bytes>] [-i <seconds>]\n"
+                    "                          [-w <seconds>] [-q <bytes>] [-t <seconds>]\n"
+                    "       plcrash-collectord -s <socket> -c <report> ...\n"
+                    "  -s <socket>   Unix domain socket to listen on, or to submit to.\n"
+                    "  -u <url>      Upload endpoint, as http://host[:port][/path].\n"
+                    "  -m <mode>     Socket permissions, in octal (default: 660).\n"
+                    "  -b <reports>  Maximum reports per upload (default: 32).\n"
+                    "  -B <bytes>    Maximum bytes per upload (default: 1048576).\n"
+                    "  -i <seconds>  Maximum time a report waits for a batch to fill (default: 30).\n"
+                    "  -w <seconds>  Window in which duplicate reports are only counted (default: 3600).\n"
+                    "  -q <bytes>    Maximum bytes queued before reports are refused (default: 67108864).\n"
+                    "  -t <seconds>  Upload and client I/O timeout (default: 10).\n"
+                    "  -c            Submit the given report files to a running collector.\n\n"
+                    "The collector runs until it receives SIGINT or SIGTERM, then uploads any queued reports.\n");
+}
+
+/*
+ * Parse a non-negative integer option, exiting on error.
+ */
+static unsigned long long parse_number (const char *arg, int base) {
+    char *end;
+    unsigned long long value;
+
+    errno = 0;
+    value = strtoull(arg, &end, base);
+    if (errno != 0 || end == arg || *end != '\0' || arg[0] == '-') {
+        print_usage();
+        exit(1);
+    }
+    return value;
+}
+
+/*
+ * Read the file at @a path into a newly allocated buffer.
+ */
+static void *read_file (const char *path, size_t *length) {
+    struct stat sb;
+    uint8_t *data;
+    size_t offset = 0;
+    int fd;
+
+    if ((fd = open(path, O_RDONLY)) < 0)
+        return NULL;
+
+    if (fstat(fd, &sb) != 0 || (data = malloc(sb.st_size > 0 ? (size_t) sb.st_size : 1)) == NULL) {
+        close(fd);
+        return NULL;
+    }
+
+    while (offset < (size_t) sb.st_size) {
+        ssize_t count = read(fd, data + offset, (size_t) sb.st_size - offset);
+        if (count < 0 && errno == EINTR)
+            continue;
+        if (count <= 0) {
+            free(data);
+            close(fd);
+            return NULL;
+        }
+        offset += (size_t) count;
+    }
+
+    close(fd);
+    *length = offset;
+    return data;
+}
+
+/*
+ * Submit each report file to the collector at @a socket_path.
+ */
+static int submit_reports (const char *socket_path, char * const *paths, int count, uint32_t timeout_ms) {
+    static const char *replies[] = { "accepted", "duplicate", "busy", "invalid" };
+    int failed = 0;
+
+    for (int i = 0; i < count; i++) {
+        plcrash_collector_status_t status;
+        size_t length;
+        void *data = read_file(paths[i], &length);
+
+        if (data == NULL) {
+            fprintf(stderr, "Could not read %s: %s\n", paths[i], strerror(errno));
+            failed = 1;
+            continue;
+        }
+
+        if (plcrash_collector_submit(socket_path, data, length, timeout_ms, &status) != PLCRASH_ESUCCESS) {
+            fprintf(stderr, "Could not submit %s to %s\n", paths[i], socket_path);
+            failed = 1;
+        } else {
+            printf("%s: %s\n", paths[i], replies[status]);
+            if (status == PLCRASH_COLLECTOR_BUSY || status == PLCRASH_COLLECTOR_INVALID)
+                failed = 1;
+        }
+        free(data);
+    }
+
+    return failed;
+}
+
+int main (int argc, char *argv[]) {
+    plcrash_collector_config_t config;
+    plcrash_collector_t collector;
+    plcrash_collector_stats_t stats;
+    struct sigaction sa;
+    plcrash_error_t err;
+    bool submit = false;
+    int ch;
+
+    plcrash_collector_config_init(&config);
+
+    while ((ch = getopt(argc, argv, "s:u:m:b:B:i:w:q:t:ch")) != -1) {
+        switch (ch) {
+            case 's':
+                config.socket_path = optarg;
+                break;
+            case 'u':
+                config.upload_url = optarg;
+                break;
+            case 'm':
+                config.socket_mode = (mode_t) parse_number(optarg, 8);
+                break;
+            case 'b':
+                config.batch_max_reports = (size_t) parse_number(optarg, 10);
+                break;
+            case 'B':
+                config.batch_max_bytes = (size_t) parse_number(optarg, 10);
+                break;
+            case 'i':
+                config.flush_interval_ms = (uint32_t) (parse_number(optarg, 10) * 1000);
+                break;
+            case 'w':
+                config.dedup_window_ms = (uint32_t) (parse_number(optarg, 10) * 1000);
+                break;
+            case 'q':
+                config.queue_max_bytes = (size_t) parse_number(optarg, 10);
+                break;
+            case 't':
+                config.io_timeout_ms = (uint32_t) (parse_number(optarg, 10) * 1000);
+                break;
+            case 'c':
+                submit = true;
+                break;
+            default:
+                print_usage();
+                return 1;
+        }
+    }
+
+    if (config.socket_path == NULL) {
+        print_usage();
+        return 1;
+    }
+
+    if (submit)
+        return submit_reports(config.socket_path, argv + optind, argc - optind, config.io_timeout_ms);
+
+    if (config.upload_url == NULL || optind != argc) {
+        print_usage();
+        return 1;
+    }
+
+    /* Peers that disconnect early must not terminate the collector */
+    signal(SIGPIPE, SIG_IGN);
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = handle_stop;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    if ((err = plcrash_collector_init(&collector, &config)) != PLCRASH_ESUCCESS) {
+        fprintf(stderr, "Could not start the collector on %s: %s\n", config.socket_path, plcrash_strerror(err));
+        return 1;
+    }
+
+    while (!stop_requested) {
+        if (plcrash_collector_run(&collector, 1000) != PLCRASH_ESUCCESS) {
+            fprintf(stderr, "Could not wait for clients: %s\n", strerror(errno));
+            break;
+        }
+    }
+
+    plcrash_collector_stop(&collector);
+    plcrash_collector_get_stats(&collector, &stats);
+    plcrash_collector_free(&collector);
+
+    fprintf(stderr, "accepted %llu, duplicates %llu, busy %llu, invalid %llu, uploaded %llu entries in %llu batches, "
+                    "%llu failed uploads, %llu dropped entries\n",
+            (unsigned long long) stats.accepted, (unsigned long long) stats.duplicates,
+            (unsigned long long) stats.busy, (unsigned long long) stats.invalid,
+            (unsigned long long) stats.uploaded_entries, (unsigned long long) stats.uploaded_batches,
+            (unsigned long long) stats.upload_failures, (unsigned long long) stats.dropped_entries);
+
+    return 0;
+}
@@ -35,6 +35,10 @@
 #import "PLCrashReporter.h"
 #import "PLCrashReport.h"
 #import "PLCrashReportTextFormatter.h"
+#import "PLCrashReportJSONFormatter.h"
+#import "PLCrashReportSymbolicator.h"
+#import "PLCrashReportBucketer.h"
+#import "PLCrashReportColumnarExporter.h"
 
 /**
  * @defgroup functions Crash Reporter Functions Reference
@@ -96,6 +100,10 @@ typedef enum {
 #import "PLCrashReporter.h"
 #import "PLCrashReport.h"
 #import "PLCrashReportTextFormatter.h"
+#import "PLCrashReportJSONFormatter.h"
+#import "PLCrashReportSymbolicator.h"
+#import "PLCrashReportBucketer.h"
+#import "PLCrashReportColumnarExporter.h"
 
 /**
  * @mainpage Plausible Crash Reporter
@@ -138,6 +138,7 @@ void plcrash_async_file_init (plcrash_async_file_t *file, int fd, off_t output_l
     file->buflen = 0;
     file->total_bytes = 0;
     file->limit_bytes = output_limit;
+    file->write_failed = false;
 }
 
 
@@ -148,6 +149,7 @@ void plcrash_async_file_init (plcrash_async_file_t *file, int fd, off_t output_l
 bool plcrash_async_file_write (plcrash_async_file_t *file, const void *data, size_t len) {
     /* Check and update output limit */
     if (file->limit_bytes != 0 && len + file->total_bytes > file->limit_bytes) {
+        file->write_failed = true;
         return false;
     } else if (file->limit_bytes != 0) {
         file->total_bytes += len;
@@ -157,6 +159,7 @@ bool plcrash_async_file_write (plcrash_async_file_t *file, const void *data, siz
     if (file->buflen + len > sizeof(file->buffer)) {
         /* Flush the buffer */
         if (writen(file->fd, file->buffer, file->buflen) < 0) {
+            file->write_failed = true;
             return false;
         }
         
@@ -173,6 +176,7 @@ bool plcrash_async_file_write (plcrash_async_file_t *file, const void *data, siz
     } else {
         /* Won't fit in the buffer, just write it */
         if (writen(file->fd, data, len) < 0) {
+            file->write_failed = true;
             return false;
         }
         
@@ -190,8 +194,10 @@ bool plcrash_async_file_flush (plcrash_async_file_t *file) {
         return true;
     
     /* Write remaining */
-    if (writen(file->fd, file->buffer, file->buflen) < 0)
+    if (writen(file->fd, file->buffer, file->buflen) < 0) {
+        file->write_failed = true;
         return false;
+    }
     
     file->buflen = 0;
     
@@ -96,6 +96,9 @@ typedef struct plcrash_async_file {
     /** Total bytes written */
     off_t total_bytes;
 
+    /** True if any write or flush has failed, including writes dropped at the output limit */
+    bool write_failed;
+
     /** Current length of data in buffer */
     size_t buflen;
 
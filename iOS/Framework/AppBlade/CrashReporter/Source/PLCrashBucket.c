@@ -0,0 +1,827 @@
+/*
+ * Copyright (c) 2008-2011 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PLCrashBucket.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/**
+ * @ingroup plcrash_bucket
+ * @{
+ */
+
+/* FNV-1a 64-bit parameters */
+#define BUCKET_FNV_OFFSET 0xcbf29ce484222325ULL
+#define BUCKET_FNV_PRIME 0x100000001b3ULL
+
+/* Fingerprint record tags */
+enum {
+    BUCKET_TAG_UUID_FRAME = 1,
+    BUCKET_TAG_NAMED_FRAME = 2,
+    BUCKET_TAG_ADDRESS_FRAME = 3,
+    BUCKET_TAG_SIGNAL = 4,
+    BUCKET_TAG_EXCEPTION = 5
+};
+
+/* Initial number of hash table slots. Must be a power of two. */
+#define BUCKET_INITIAL_SLOTS 64
+
+/* Number of paths claimed by a worker at a time */
+#define BUCKET_BATCH_SIZE 64
+
+/* Maximum number of worker threads */
+#define BUCKET_THREAD_MAX 64
+
+/* Files larger than this are not crash reports, and are not read */
+#define BUCKET_FILE_MAX (64 * 1024 * 1024)
+
+/**
+ * @internal
+ * Add @a length bytes to the FNV-1a @a hash.
+ */
+static uint64_t bucket_hash_bytes (uint64_t hash, const void *data, size_t length) {
+    const uint8_t *p = data;
+
+    for (size_t i = 0; i < length; i++) {
+        hash ^= p[i];
+        hash *= BUCKET_FNV_PRIME;
+    }
+
+    return hash;
+}
+
+/**
+ * @internal
+ * Add a little-endian 64-bit value to @a hash.
+ */
+static uint64_t bucket_hash_u64 (uint64_t hash, uint64_t value) {
+    uint8_t bytes[8];
+
+    for (size_t i = 0; i < sizeof(bytes); i++)
+        bytes[i] = (uint8_t) (value >> (i * 8));
+
+    return bucket_hash_bytes(hash, bytes, sizeof(bytes));
+}
+
+/**
+ * @internal
+ * Add a record tag to @a hash.
+ */
+static uint64_t bucket_hash_tag (uint64_t hash, uint8_t tag) {
+    return bucket_hash_bytes(hash, &tag, sizeof(tag));
+}
+
+/**
+ * @internal
+ * Add a length-prefixed string to @a hash. NULL is hashed as the empty string.
+ */
+static uint64_t bucket_hash_string (uint64_t hash, const char *str) {
+    size_t length = (str != NULL) ? strlen(str) : 0;
+
+    hash = bucket_hash_u64(hash, length);
+    return bucket_hash_bytes(hash, str, length);
+}
+
+/**
+ * @internal
+ * Return the last path component of an image name.
+ */
+static const char *bucket_basename (const char *path) {
+    const char *p;
+
+    if (path == NULL)
+        return "???";
+
+    if ((p = strrchr(path, '/')) != NULL)
+        return p + 1;
+
+    return path;
+}
+
+/**
+ * @internal
+ * Return the crashed thread of @a report, or NULL if no thread is marked as crashed.
+ */
+static const plcrash_report_thread_t *bucket_crashed_thread (const plcrash_report_t *report) {
+    for (size_t i = 0; i < report->thread_count; i++) {
+        if (report->threads[i].crashed)
+            return &report->threads[i];
+    }
+
+    return NULL;
+}
+
+/**
+ * @internal
+ * Return the number of frames of @a thread that are included in a fingerprint of @a frame_count frames.
+ */
+static size_t bucket_thread_frames (const plcrash_report_thread_t *thread, size_t frame_count) {
+    if (thread == NULL)
+        return 0;
+
+    return thread->frame_count < frame_count ? thread->frame_count : frame_count;
+}
+
+/**
+ * @internal
+ * Add the normalized frame at @a pc to @a hash.
+ */
+static uint64_t bucket_hash_frame (uint64_t hash, const plcrash_report_t *report, uint64_t pc) {
+    const plcrash_report_image_t *image = plcrash_report_image_for_address(report, pc);
+
+    if (image == NULL) {
+        hash = bucket_hash_tag(hash, BUCKET_TAG_ADDRESS_FRAME);
+        return bucket_hash_u64(hash, pc);
+    }
+
+    if (image->uuid != NULL && image->uuid_length > 0) {
+        hash = bucket_hash_tag(hash, BUCKET_TAG_UUID_FRAME);
+        hash = bucket_hash_u64(hash, image->uuid_length);
+        hash = bucket_hash_bytes(hash, image->uuid, image->uuid_length);
+    } else {
+        hash = bucket_hash_tag(hash, BUCKET_TAG_NAMED_FRAME);
+        hash = bucket_hash_string(hash, bucket_basename(image->name));
+    }
+
+    return bucket_hash_u64(hash, pc - image->base_address);
+}
+
+/**
+ * Compute the fingerprint of @a report.
+ *
+ * @param report The report to fingerprint.
+ * @param frame_count The maximum number of crashed thread frames to include, starting from the top of the stack.
+ *
+ * @return Returns the report's fingerprint.
+ */
+uint64_t plcrash_bucket_fingerprint (const plcrash_report_t *report, size_t frame_count) {
+    const plcrash_report_thread_t *thread = bucket_crashed_thread(report);
+    size_t count = bucket_thread_frames(thread, frame_count);
+    uint64_t hash = BUCKET_FNV_OFFSET;
+
+    for (size_t i = 0; i < count; i++)
+        hash = bucket_hash_frame(hash, report, report->frames[thread->frame_index + i].pc);
+
+    hash = bucket_hash_tag(hash, BUCKET_TAG_SIGNAL);
+    hash = bucket_hash_string(hash, report->signal_info.name);
+
+    if (report->has_exception_info) {
+        hash = bucket_hash_tag(hash, BUCKET_TAG_EXCEPTION);
+        hash = bucket_hash_string(hash, report->exception_info.name);
+    }
+
+    return hash;
+}
+
+/**
+ * @internal
+ * Describe the normalized frames included in the fingerprint of @a report.
+ *
+ * @return Returns a NUL-terminated string that must be released with free(), or NULL if memory could not be allocated.
+ */
+static char *bucket_describe_frames (const plcrash_report_t *report, size_t frame_count) {
+    const plcrash_report_thread_t *thread = bucket_crashed_thread(report);
+    size_t count = bucket_thread_frames(thread, frame_count);
+    plcrash_report_output_t output;
+    size_t length;
+    char *result;
+
+    plcrash_report_output_init_buffer(&output, 128);
+
+    for (size_t i = 0; i < count; i++) {
+        uint64_t pc = report->frames[thread->frame_index + i].pc;
+        const plcrash_report_image_t *image = plcrash_report_image_for_address(report, pc);
+        char text[32];
+
+        if (i > 0)
+            plcrash_report_output_write(&output, " | ", 3);
+
+        if (image != NULL) {
+            const char *name = bucket_basename(image->name);
+
+            plcrash_report_output_write(&output, name, strlen(name));
+            snprintf(text, sizeof(text), " + 0x%" PRIx64, pc - image->base_address);
+        } else {
+            snprintf(text, sizeof(text), "0x%016" PRIx64, pc);
+        }
+
+        plcrash_report_output_write(&output, text, strlen(text));
+    }
+
+    plcrash_report_output_write(&output, "", 1);
+
+    result = plcrash_report_output_detach(&output, &length);
+    plcrash_report_output_free(&output);
+
+    return result;
+}
+
+/**
+ * @internal
+ * Free the strings owned by @a bucket.
+ */
+static void bucket_release (plcrash_bucket_t *bucket) {
+    free(bucket->signal_name);
+    free(bucket->exception_name);
+    free(bucket->frames);
+
+    for (size_t i = 0; i < bucket->sample_count; i++)
+        free(bucket->samples[i]);
+}
+
+/**
+ * @internal
+ * Extend the first and last seen timestamps of @a bucket to include @a first and @a last. Unknown (0) timestamps
+ * are ignored.
+ */
+static void bucket_update_seen (plcrash_bucket_t *bucket, int64_t first, int64_t last) {
+    if (first != 0 && (bucket->first_seen == 0 || first < bucket->first_seen))
+        bucket->first_seen = first;
+
+    if (last != 0 && (bucket->last_seen == 0 || last > bucket->last_seen))
+        bucket->last_seen = last;
+}
+
+/**
+ * @internal
+ * Return true if the sample (@a timestamp, @a identifier) is ordered before (@a other_timestamp, @a other_identifier):
+ * newer samples come first, and samples with the same timestamp are ordered by identifier.
+ */
+static bool bucket_sample_precedes (int64_t timestamp, const char *identifier, int64_t other_timestamp, const char *other_identifier) {
+    if (timestamp != other_timestamp)
+        return timestamp > other_timestamp;
+
+    return strcmp(identifier, other_identifier) < 0;
+}
+
+/**
+ * @internal
+ * Retain @a identifier as a representative sample of @a bucket if it is among the bucket's most recent
+ * PLCRASH_BUCKET_SAMPLE_MAX reports. As the retained samples depend only on the set of reports offered, they are
+ * independent of the order in which reports are added or tables are merged.
+ *
+ * @param bucket The bucket.
+ * @param timestamp The report timestamp.
+ * @param identifier The report identifier.
+ * @param owned If non-NULL, a heap-allocated copy of @a identifier whose ownership is transferred to this function.
+ */
+static plcrash_error_t bucket_offer_sample (plcrash_bucket_t *bucket, int64_t timestamp, const char *identifier, char *owned) {
+    size_t pos = bucket->sample_count;
+
+    while (pos > 0 && bucket_sample_precedes(timestamp, identifier, bucket->sample_timestamps[pos - 1], bucket->samples[pos - 1]))
+        pos--;
+
+    /* A report that is added more than once is only retained once */
+    if (pos > 0 && bucket->sample_timestamps[pos - 1] == timestamp && strcmp(bucket->samples[pos - 1], identifier) == 0)
+        pos = PLCRASH_BUCKET_SAMPLE_MAX;
+
+    if (pos == PLCRASH_BUCKET_SAMPLE_MAX) {
+        free(owned);
+        return PLCRASH_ESUCCESS;
+    }
+
+    if (owned == NULL && (owned = strdup(identifier)) == NULL)
+        return PLCRASH_ENOMEM;
+
+    if (bucket->sample_count == PLCRASH_BUCKET_SAMPLE_MAX) {
+        free(bucket->samples[PLCRASH_BUCKET_SAMPLE_MAX - 1]);
+        bucket->sample_count--;
+    }
+
+    memmove(&bucket->samples[pos + 1], &bucket->samples[pos], (bucket->sample_count - pos) * sizeof(bucket->samples[0]));
+    memmove(&bucket->sample_timestamps[pos + 1], &bucket->sample_timestamps[pos], (bucket->sample_count - pos) * sizeof(bucket->sample_timestamps[0]));
+
+    bucket->samples[pos] = owned;
+    bucket->sample_timestamps[pos] = timestamp;
+    bucket->sample_count++;
+
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * @internal
+ * Return the hash table slot of @a fingerprint: either the slot referencing its bucket, or the empty slot at which
+ * it would be inserted.
+ */
+static size_t *bucket_find_slot (const plcrash_bucket_table_t *table, uint64_t fingerprint) {
+    size_t mask = table->slot_count - 1;
+    size_t i = (size_t) (fingerprint ^ (fingerprint >> 32)) & mask;
+
+    while (table->slots[i] != 0 && table->buckets[table->slots[i] - 1].fingerprint != fingerprint)
+        i = (i + 1) & mask;
+
+    return &table->slots[i];
+}
+
+/**
+ * @internal
+ * Rebuild the hash table of @a table with @a slot_count slots.
+ */
+static plcrash_error_t bucket_rehash (plcrash_bucket_table_t *table, size_t slot_count) {
+    size_t *slots = calloc(slot_count, sizeof(*slots));
+    if (slots == NULL)
+        return PLCRASH_ENOMEM;
+
+    free(table->slots);
+    table->slots = slots;
+    table->slot_count = slot_count;
+
+    for (size_t i = 0; i < table->bucket_count; i++)
+        *bucket_find_slot(table, table->buckets[i].fingerprint) = i + 1;
+
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * @internal
+ * Insert @a bucket, whose fingerprint must not already be present. On success, ownership of the bucket's
+ * strings is transferred to @a table.
+ *
+ * @return Returns the inserted bucket, or NULL if memory could not be allocated.
+ */
+static plcrash_bucket_t *bucket_insert (plcrash_bucket_table_t *table, const plcrash_bucket_t *bucket) {
+    /* Keep the load factor at or below 1/2 */
+    if ((table->bucket_count + 1) * 2 > table->slot_count) {
+        if (bucket_rehash(table, table->slot_count * 2) != PLCRASH_ESUCCESS)
+            return NULL;
+    }
+
+    if (table->bucket_count == table->bucket_capacity) {
+        size_t capacity = table->bucket_capacity > 0 ? table->bucket_capacity * 2 : 32;
+        plcrash_bucket_t *buckets = realloc(table->buckets, capacity * sizeof(*buckets));
+
+        if (buckets == NULL)
+            return NULL;
+
+        table->buckets = buckets;
+        table->bucket_capacity = capacity;
+    }
+
+    table->buckets[table->bucket_count] = *bucket;
+    table->bucket_count++;
+    *bucket_find_slot(table, bucket->fingerprint) = table->bucket_count;
+
+    return &table->buckets[table->bucket_count - 1];
+}
+
+/**
+ * Initialize an empty bucket table.
+ *
+ * @param table The table to initialize.
+ * @param frame_count The number of crashed thread frames to include in each fingerprint. If 0,
+ * PLCRASH_BUCKET_DEFAULT_FRAMES is used.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, or PLCRASH_ENOMEM if memory could not be allocated.
+ */
+plcrash_error_t plcrash_bucket_table_init (plcrash_bucket_table_t *table, size_t frame_count) {
+    memset(table, 0, sizeof(*table));
+
+    table->frame_count = frame_count > 0 ? frame_count : PLCRASH_BUCKET_DEFAULT_FRAMES;
+    table->slot_count = BUCKET_INITIAL_SLOTS;
+    table->slots = calloc(table->slot_count, sizeof(*table->slots));
+    if (table->slots == NULL)
+        return PLCRASH_ENOMEM;
+
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * Add a report to its bucket.
+ *
+ * @param table The table.
+ * @param report The report to add.
+ * @param identifier An identifier for the report (eg, its path), retained if the report is one of its bucket's
+ * most recent reports. May be NULL.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, or PLCRASH_ENOMEM if memory could not be allocated.
+ */
+plcrash_error_t plcrash_bucket_table_add (plcrash_bucket_table_t *table, const plcrash_report_t *report, const char *identifier) {
+    uint64_t fingerprint = plcrash_bucket_fingerprint(report, table->frame_count);
+    int64_t timestamp = report->system_info.timestamp;
+    size_t *slot = bucket_find_slot(table, fingerprint);
+    plcrash_bucket_t *bucket;
+
+    if (*slot != 0) {
+        bucket = &table->buckets[*slot - 1];
+    } else {
+        plcrash_bucket_t entry;
+
+        /* The descriptive strings are only built for the first report of each bucket */
+        memset(&entry, 0, sizeof(entry));
+        entry.fingerprint = fingerprint;
+        entry.signal_name = strdup(report->signal_info.name != NULL ? report->signal_info.name : "");
+        entry.frames = bucket_describe_frames(report, table->frame_count);
+        if (report->has_exception_info)
+            entry.exception_name = strdup(report->exception_info.name != NULL ? report->exception_info.name : "");
+
+        if (entry.signal_name == NULL || entry.frames == NULL || (report->has_exception_info && entry.exception_name == NULL)) {
+            bucket_release(&entry);
+            return PLCRASH_ENOMEM;
+        }
+
+        if ((bucket = bucket_insert(table, &entry)) == NULL) {
+            bucket_release(&entry);
+            return PLCRASH_ENOMEM;
+        }
+    }
+
+    bucket->count++;
+    bucket_update_seen(bucket, timestamp, timestamp);
+    table->report_count++;
+
+    if (identifier != NULL)
+        return bucket_offer_sample(bucket, timestamp, identifier, NULL);
+
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * Merge all buckets of @a source into @a table. The two tables must use the same frame count. The result is
+ * identical to having added the reports of both tables to @a table.
+ *
+ * @param table The destination table.
+ * @param source The table to merge. Its contents are moved to @a table, and it is freed, whether or not the
+ * merge succeeds.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, PLCRASH_EINVAL if the frame counts differ, or PLCRASH_ENOMEM if
+ * memory could not be allocated.
+ */
+plcrash_error_t plcrash_bucket_table_merge (plcrash_bucket_table_t *table, plcrash_bucket_table_t *source) {
+    plcrash_error_t err = PLCRASH_ESUCCESS;
+
+    if (table->frame_count != source->frame_count) {
+        plcrash_bucket_table_free(source);
+        return PLCRASH_EINVAL;
+    }
+
+    for (size_t i = 0; i < source->bucket_count && err == PLCRASH_ESUCCESS; i++) {
+        plcrash_bucket_t *src = &source->buckets[i];
+        size_t *slot = bucket_find_slot(table, src->fingerprint);
+
+        /* New buckets are moved as-is */
+        if (*slot == 0) {
+            if (bucket_insert(table, src) == NULL) {
+                err = PLCRASH_ENOMEM;
+                break;
+            }
+
+            memset(src, 0, sizeof(*src));
+            continue;
+        }
+
+        /* Combine with the existing bucket, moving over any retained samples */
+        plcrash_bucket_t *dest = &table->buckets[*slot - 1];
+        dest->count += src->count;
+        bucket_update_seen(dest, src->first_seen, src->last_seen);
+
+        for (size_t j = 0; j < src->sample_count; j++) {
+            char *sample = src->samples[j];
+
+            /* Offering an owned sample can not fail */
+            src->samples[j] = NULL;
+            bucket_offer_sample(dest, src->sample_timestamps[j], sample, sample);
+        }
+    }
+
+    if (err == PLCRASH_ESUCCESS) {
+        table->report_count += source->report_count;
+        table->failed_count += source->failed_count;
+    }
+
+    plcrash_bucket_table_free(source);
+    return err;
+}
+
+/**
+ * @internal
+ * qsort() comparator ordering buckets by descending report count, and then by fingerprint.
+ */
+static int bucket_compare (const void *a, const void *b) {
+    const plcrash_bucket_t *lhs = a;
+    const plcrash_bucket_t *rhs = b;
+
+    if (lhs->count != rhs->count)
+        return lhs->count > rhs->count ? -1 : 1;
+
+    if (lhs->fingerprint != rhs->fingerprint)
+        return lhs->fingerprint < rhs->fingerprint ? -1 : 1;
+
+    return 0;
+}
+
+/**
+ * Sort the buckets of @a table by descending report count. Buckets with the same count are ordered by
+ * fingerprint, so that the order is deterministic.
+ *
+ * @param table The table to sort.
+ */
+void plcrash_bucket_table_sort (plcrash_bucket_table_t *table) {
+    if (table->bucket_count == 0)
+        return;
+
+    qsort(table->buckets, table->bucket_count, sizeof(table->buckets[0]), bucket_compare);
+
+    /* Re-index the sorted buckets in place */
+    memset(table->slots, 0, table->slot_count * sizeof(table->slots[0]));
+    for (size_t i = 0; i < table->bucket_count; i++)
+        *bucket_find_slot(table, table->buckets[i].fingerprint) = i + 1;
+}
+
+/**
+ * @internal
+ * Read the file at @a path into @a buffer, growing the buffer as required. Reports are read rather than mapped,
+ * as they are small, and unmapping from many threads at once is considerably more expensive than copying.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, PLCRASH_EINVAL if the file could not be read, or PLCRASH_ENOMEM
+ * if memory could not be allocated.
+ */
+static plcrash_error_t bucket_read_file (const char *path, uint8_t **buffer, size_t *capacity, size_t *length) {
+    struct stat sb;
+    size_t size;
+    size_t offset = 0;
+    int fd;
+
+    if ((fd = open(path, O_RDONLY)) == -1)
+        return PLCRASH_EINVAL;
+
+    if (fstat(fd, &sb) != 0 || !S_ISREG(sb.st_mode) || sb.st_size <= 0 || sb.st_size > BUCKET_FILE_MAX) {
+        close(fd);
+        return PLCRASH_EINVAL;
+    }
+    size = (size_t) sb.st_size;
+
+    if (size > *capacity) {
+        uint8_t *grown = realloc(*buffer, size);
+        if (grown == NULL) {
+            close(fd);
+            return PLCRASH_ENOMEM;
+        }
+
+        *buffer = grown;
+        *capacity = size;
+    }
+
+    while (offset < size) {
+        ssize_t nread = read(fd, *buffer + offset, size - offset);
+        if (nread < 0 && errno == EINTR)
+            continue;
+
+        if (nread <= 0) {
+            close(fd);
+            return PLCRASH_EINVAL;
+        }
+
+        offset += (size_t) nread;
+    }
+
+    close(fd);
+    *length = size;
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * @internal
+ * State shared by the workers of plcrash_bucket_table_add_paths().
+ */
+typedef struct bucket_pipeline {
+    /** Input paths */
+    const char * const *paths;
+    size_t count;
+
+    /** Guards the fields below */
+    pthread_mutex_t lock;
+
+    /** Index of the next unclaimed path */
+    size_t next;
+
+    /** True if a worker has failed, and the remaining paths should not be processed */
+    bool aborted;
+} bucket_pipeline_t;
+
+/**
+ * @internal
+ * A bucketing worker. Each worker accumulates its reports in a private table, which is merged once all
+ * workers have finished.
+ */
+typedef struct bucket_worker {
+    /** Shared pipeline state */
+    bucket_pipeline_t *pipeline;
+
+    /** Worker-local table */
+    plcrash_bucket_table_t table;
+
+    /** Result of the worker */
+    plcrash_error_t error;
+
+    /** Worker thread, if started */
+    pthread_t thread;
+    bool started;
+} bucket_worker_t;
+
+/**
+ * @internal
+ * Claim the next batch of paths.
+ *
+ * @return Returns false if no paths remain.
+ */
+static bool bucket_pipeline_claim (bucket_pipeline_t *pipeline, size_t *start, size_t *end) {
+    bool claimed = false;
+
+    pthread_mutex_lock(&pipeline->lock);
+    if (!pipeline->aborted && pipeline->next < pipeline->count) {
+        *start = pipeline->next;
+        *end = (pipeline->count - *start) > BUCKET_BATCH_SIZE ? *start + BUCKET_BATCH_SIZE : pipeline->count;
+        pipeline->next = *end;
+        claimed = true;
+    }
+    pthread_mutex_unlock(&pipeline->lock);
+
+    return claimed;
+}
+
+/**
+ * @internal
+ * Worker entry point: read, decode, and bucket batches of reports until none remain.
+ */
+static void *bucket_worker_run (void *arg) {
+    bucket_worker_t *worker = arg;
+    bucket_pipeline_t *pipeline = worker->pipeline;
+    uint8_t *buffer = NULL;
+    size_t capacity = 0;
+    size_t start, end;
+
+    while (worker->error == PLCRASH_ESUCCESS && bucket_pipeline_claim(pipeline, &start, &end)) {
+        for (size_t i = start; i < end && worker->error == PLCRASH_ESUCCESS; i++) {
+            plcrash_report_t report;
+            plcrash_error_t err;
+            size_t length;
+
+            err = bucket_read_file(pipeline->paths[i], &buffer, &capacity, &length);
+            if (err == PLCRASH_ESUCCESS)
+                err = plcrash_report_decode(&report, buffer, length, NULL);
+
+            /* Unreadable files and invalid reports are counted and skipped */
+            if (err != PLCRASH_ESUCCESS) {
+                if (err == PLCRASH_ENOMEM)
+                    worker->error = err;
+                else
+                    worker->table.failed_count++;
+                continue;
+            }
+
+            worker->error = plcrash_bucket_table_add(&worker->table, &report, pipeline->paths[i]);
+            plcrash_report_free(&report);
+        }
+    }
+
+    if (worker->error != PLCRASH_ESUCCESS) {
+        pthread_mutex_lock(&pipeline->lock);
+        pipeline->aborted = true;
+        pthread_mutex_unlock(&pipeline->lock);
+    }
+
+    free(buffer);
+    return NULL;
+}
+
+/**
+ * Read, decode, and bucket the reports at @a paths, using @a thread_count threads. Each report is identified
+ * by its path. Files that can not be read or decoded are skipped, and counted in the table's failed_count.
+ *
+ * Paths are claimed by the workers in small batches, and each worker buckets its reports into a private table;
+ * the worker tables are merged into @a table once all reports have been processed. The result is independent
+ * of the number of threads.
+ *
+ * @param table The table to which the reports will be added.
+ * @param paths Report paths.
+ * @param count Number of paths.
+ * @param thread_count Number of threads to use, including the calling thread. If 0, one thread per online
+ * processor is used.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, or PLCRASH_ENOMEM if memory could not be allocated. If the
+ * allocation failure occurs while merging into @a table, only some of the reports may have been added.
+ */
+plcrash_error_t plcrash_bucket_table_add_paths (plcrash_bucket_table_t *table, const char * const *paths, size_t count, size_t thread_count) {
+    bucket_pipeline_t pipeline;
+    bucket_worker_t *workers;
+    plcrash_error_t err = PLCRASH_ESUCCESS;
+    size_t batches = (count + BUCKET_BATCH_SIZE - 1) / BUCKET_BATCH_SIZE;
+
+    if (thread_count == 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        thread_count = online > 0 ? (size_t) online : 1;
+    }
+
+    /* There is no benefit to more threads than batches */
+    if (thread_count > BUCKET_THREAD_MAX)
+        thread_count = BUCKET_THREAD_MAX;
+    if (thread_count > batches)
+        thread_count = batches;
+    if (thread_count == 0)
+        return PLCRASH_ESUCCESS;
+
+    if ((workers = calloc(thread_count, sizeof(*workers))) == NULL)
+        return PLCRASH_ENOMEM;
+
+    for (size_t i = 0; i < thread_count; i++) {
+        if ((err = plcrash_bucket_table_init(&workers[i].table, table->frame_count)) != PLCRASH_ESUCCESS) {
+            for (size_t j = 0; j <= i; j++)
+                plcrash_bucket_table_free(&workers[j].table);
+            free(workers);
+            return err;
+        }
+
+        workers[i].pipeline = &pipeline;
+        workers[i].error = PLCRASH_ESUCCESS;
+    }
+
+    pipeline.paths = paths;
+    pipeline.count = count;
+    pipeline.next = 0;
+    pipeline.aborted = false;
+    pthread_mutex_init(&pipeline.lock, NULL);
+
+    /* The calling thread acts as the first worker. If a thread can not be created, its share of the work is
+     * picked up by the remaining workers. */
+    for (size_t i = 1; i < thread_count; i++)
+        workers[i].started = (pthread_create(&workers[i].thread, NULL, bucket_worker_run, &workers[i]) == 0);
+
+    bucket_worker_run(&workers[0]);
+
+    for (size_t i = 1; i < thread_count; i++) {
+        if (workers[i].started)
+            pthread_join(workers[i].thread, NULL);
+    }
+
+    pthread_mutex_destroy(&pipeline.lock);
+
+    for (size_t i = 0; i < thread_count; i++) {
+        if (workers[i].error != PLCRASH_ESUCCESS)
+            err = workers[i].error;
+    }
+
+    if (err == PLCRASH_ESUCCESS) {
+        /* Merge the worker tables into a single table before touching the caller's table */
+        for (size_t i = 1; i < thread_count && err == PLCRASH_ESUCCESS; i++)
+            err = plcrash_bucket_table_merge(&workers[0].table, &workers[i].table);
+
+        if (err == PLCRASH_ESUCCESS)
+            err = plcrash_bucket_table_merge(table, &workers[0].table);
+    }
+
+    for (size_t i = 0; i < thread_count; i++)
+        plcrash_bucket_table_free(&workers[i].table);
+    free(workers);
+
+    return err;
+}
+
+/**
+ * Free all resources associated with @a table.
+ *
+ * @param table The table to free.
+ */
+void plcrash_bucket_table_free (plcrash_bucket_table_t *table) {
+    for (size_t i = 0; i < table->bucket_count; i++)
+        bucket_release(&table->buckets[i]);
+
+    free(table->buckets);
+    free(table->slots);
+
+    memset(table, 0, sizeof(*table));
+}
+
+/**
+ * @} plcrash_bucket
+ */
@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2008-2011 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef PLCRASH_BUCKET_H
+#define PLCRASH_BUCKET_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#import "PLCrashAsync.h"
+#include "PLCrashReportCore.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @internal
+ * @defgroup plcrash_bucket Crash Report Bucketing
+ *
+ * Groups decoded reports by a stable fingerprint of their crash site, accumulating per-bucket report counts,
+ * first and last seen timestamps, and a small set of representative report identifiers.
+ *
+ * A report's fingerprint is a 64-bit FNV-1a hash of the top frames of its crashed thread, each normalized to its
+ * image (by UUID, or by file name if the image has no UUID) and its offset within that image, followed by the
+ * signal name and the exception name. Fingerprints are therefore independent of ASLR slide, install path, and
+ * thread numbering, and are stable across runs, hosts, and thread counts. Frames outside any image are hashed
+ * by their absolute address.
+ *
+ * @{
+ */
+
+/** Default number of crashed thread frames included in a fingerprint */
+#define PLCRASH_BUCKET_DEFAULT_FRAMES 5
+
+/** Maximum number of representative report identifiers retained per bucket */
+#define PLCRASH_BUCKET_SAMPLE_MAX 3
+
+/**
+ * A single bucket.
+ */
+typedef struct plcrash_bucket {
+    /** Report fingerprint */
+    uint64_t fingerprint;
+
+    /** Number of reports */
+    uint64_t count;
+
+    /** Earliest and latest report timestamps, in seconds since the epoch, or 0 if no report had a timestamp */
+    int64_t first_seen;
+    int64_t last_seen;
+
+    /** Signal name */
+    char *signal_name;
+
+    /** Exception name, or NULL if the reports did not include an exception */
+    char *exception_name;
+
+    /** Normalized frames of the crashed thread, as "image + 0xoffset" separated by " | " */
+    char *frames;
+
+    /** Identifiers of the most recent reports, newest first; ties are ordered by identifier */
+    char *samples[PLCRASH_BUCKET_SAMPLE_MAX];
+    int64_t sample_timestamps[PLCRASH_BUCKET_SAMPLE_MAX];
+    size_t sample_count;
+} plcrash_bucket_t;
+
+/**
+ * A table of buckets. All fields are read-only.
+ */
+typedef struct plcrash_bucket_table {
+    /** Number of crashed thread frames included in each fingerprint */
+    size_t frame_count;
+
+    /** Buckets, in insertion order until sorted by plcrash_bucket_table_sort() */
+    plcrash_bucket_t *buckets;
+    size_t bucket_count;
+
+    /** Number of reports added */
+    uint64_t report_count;
+
+    /** Number of reports that could not be read or decoded by plcrash_bucket_table_add_paths() */
+    uint64_t failed_count;
+
+    /** @internal Bucket capacity */
+    size_t bucket_capacity;
+
+    /** @internal Open-addressed hash table mapping fingerprints to bucket index + 1 (0 marks an empty slot) */
+    size_t *slots;
+    size_t slot_count;
+} plcrash_bucket_table_t;
+
+uint64_t plcrash_bucket_fingerprint (const plcrash_report_t *report, size_t frame_count);
+
+plcrash_error_t plcrash_bucket_table_init (plcrash_bucket_table_t *table, size_t frame_count);
+plcrash_error_t plcrash_bucket_table_add (plcrash_bucket_table_t *table, const plcrash_report_t *report, const char *identifier);
+plcrash_error_t plcrash_bucket_table_add_paths (plcrash_bucket_table_t *table, const char * const *paths, size_t count, size_t thread_count);
+plcrash_error_t plcrash_bucket_table_merge (plcrash_bucket_table_t *table, plcrash_bucket_table_t *source);
+void plcrash_bucket_table_sort (plcrash_bucket_table_t *table);
+void plcrash_bucket_table_free (plcrash_bucket_table_t *table);
+
+/**
+ * @} plcrash_bucket
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PLCRASH_BUCKET_H */
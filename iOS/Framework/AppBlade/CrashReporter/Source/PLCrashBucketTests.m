@@ -0,0 +1,229 @@
+/*
+ * Author: Landon Fuller <landonf@plausiblelabs.com>
+ *
+ * Copyright (c) 2008-2009 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "GTMSenTestCase.h"
+
+#import "PLCrashBucket.h"
+#import "PLCrashLogWriter.h"
+#import "PLCrashFrameWalker.h"
+
+#import <fcntl.h>
+
+/* A hand-built report with a single crashed thread and two images */
+typedef struct bucket_test_report {
+    plcrash_report_t report;
+    plcrash_report_thread_t thread;
+    plcrash_report_frame_t frames[8];
+    plcrash_report_image_t images[2];
+} bucket_test_report_t;
+
+static const uint8_t bucket_test_uuid[16] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f };
+
+/*
+ * Initialize a report whose crashed thread has the given image offsets, with the images loaded at @a slide. Odd
+ * offsets are within the second image, which has no UUID.
+ */
+static void bucket_test_report_init (bucket_test_report_t *r, uint64_t slide, const uint64_t *offsets, size_t count,
+                                     const char *signal, const char *exception, int64_t timestamp)
+{
+    memset(r, 0, sizeof(*r));
+
+    r->images[0].base_address = 0x100000 + slide;
+    r->images[0].size = 0x100000;
+    r->images[0].name = "/usr/lib/libfirst.dylib";
+    r->images[0].uuid = bucket_test_uuid;
+    r->images[0].uuid_length = sizeof(bucket_test_uuid);
+
+    r->images[1].base_address = 0x800000 + slide;
+    r->images[1].size = 0x100000;
+    r->images[1].name = (slide == 0) ? "/var/mobile/A/Test.app/Test" : "/var/mobile/B/Test.app/Test";
+
+    for (size_t i = 0; i < count; i++)
+        r->frames[i].pc = r->images[offsets[i] % 2].base_address + offsets[i];
+
+    r->thread.crashed = true;
+    r->thread.frame_count = count;
+
+    r->report.system_info.timestamp = timestamp;
+    r->report.signal_info.name = signal;
+    r->report.has_exception_info = (exception != NULL);
+    r->report.exception_info.name = exception;
+    r->report.threads = &r->thread;
+    r->report.thread_count = 1;
+    r->report.frames = r->frames;
+    r->report.frame_count = count;
+    r->report.images = r->images;
+    r->report.image_count = 2;
+}
+
+@interface PLCrashBucketTests : SenTestCase {
+@private
+    /* Path to crash log */
+    NSString *_logPath;
+
+    /* Test thread */
+    plframe_test_thead_t _thr_args;
+}
+
+@end
+
+@implementation PLCrashBucketTests
+
+- (void) setUp {
+    _logPath = [[NSTemporaryDirectory() stringByAppendingPathComponent: [[NSProcessInfo processInfo] globallyUniqueString]] retain];
+    plframe_test_thread_spawn(&_thr_args);
+}
+
+- (void) tearDown {
+    [[NSFileManager defaultManager] removeItemAtPath: _logPath error: NULL];
+    [_logPath release];
+
+    plframe_test_thread_stop(&_thr_args);
+}
+
+- (void) testFingerprint {
+    static const uint64_t offsets[] = { 0x10, 0x21, 0x30, 0x41, 0x50, 0x60 };
+    static const uint64_t other[] = { 0x10, 0x21, 0x30, 0x41, 0x50, 0x70 };
+    bucket_test_report_t a, b;
+
+    /* Image slide and install paths do not affect the fingerprint */
+    bucket_test_report_init(&a, 0, offsets, 6, "SIGSEGV", NULL, 0);
+    bucket_test_report_init(&b, 0x4000000, offsets, 6, "SIGSEGV", NULL, 0);
+    STAssertEquals(plcrash_bucket_fingerprint(&a.report, 5), plcrash_bucket_fingerprint(&b.report, 5), @"Fingerprint depends on the image slide");
+
+    /* Frames below the fingerprinted frames are ignored */
+    bucket_test_report_init(&b, 0, other, 6, "SIGSEGV", NULL, 0);
+    STAssertEquals(plcrash_bucket_fingerprint(&a.report, 5), plcrash_bucket_fingerprint(&b.report, 5), @"Fingerprint includes too many frames");
+    STAssertTrue(plcrash_bucket_fingerprint(&a.report, 6) != plcrash_bucket_fingerprint(&b.report, 6), @"Fingerprint ignores a frame");
+
+    /* The signal and exception names are included */
+    bucket_test_report_init(&b, 0, offsets, 6, "SIGBUS", NULL, 0);
+    STAssertTrue(plcrash_bucket_fingerprint(&a.report, 5) != plcrash_bucket_fingerprint(&b.report, 5), @"Fingerprint ignores the signal");
+
+    bucket_test_report_init(&b, 0, offsets, 6, "SIGSEGV", "NSRangeException", 0);
+    STAssertTrue(plcrash_bucket_fingerprint(&a.report, 5) != plcrash_bucket_fingerprint(&b.report, 5), @"Fingerprint ignores the exception");
+}
+
+- (void) testAggregate {
+    static const uint64_t first[] = { 0x10, 0x21 };
+    static const uint64_t second[] = { 0x30, 0x41 };
+    plcrash_bucket_table_t table, other;
+    bucket_test_report_t r;
+
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_bucket_table_init(&table, 0), @"Could not initialize the table");
+    STAssertEquals((size_t) PLCRASH_BUCKET_DEFAULT_FRAMES, table.frame_count, @"Incorrect default frame count");
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_bucket_table_init(&other, 0), @"Could not initialize the table");
+
+    /* Split the same reports across two tables */
+    bucket_test_report_init(&r, 0, first, 2, "SIGSEGV", NULL, 300);
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_bucket_table_add(&table, &r.report, "a"), @"Could not add report");
+    bucket_test_report_init(&r, 0x1000, first, 2, "SIGSEGV", NULL, 100);
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_bucket_table_add(&other, &r.report, "b"), @"Could not add report");
+    bucket_test_report_init(&r, 0, first, 2, "SIGSEGV", NULL, 0);
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_bucket_table_add(&other, &r.report, "c"), @"Could not add report");
+    bucket_test_report_init(&r, 0, first, 2, "SIGSEGV", NULL, 300);
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_bucket_table_add(&other, &r.report, "d"), @"Could not add report");
+
+    bucket_test_report_init(&r, 0, second, 2, "SIGABRT", "NSRangeException", 200);
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_bucket_table_add(&other, &r.report, "e"), @"Could not add report");
+
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_bucket_table_merge(&table, &other), @"Could not merge tables");
+    plcrash_bucket_table_sort(&table);
+
+    STAssertEquals((uint64_t) 5, table.report_count, @"Incorrect report count");
+    STAssertEquals((size_t) 2, table.bucket_count, @"Incorrect bucket count");
+
+    plcrash_bucket_t *bucket = &table.buckets[0];
+    STAssertEquals((uint64_t) 4, bucket->count, @"Incorrect count");
+    STAssertEquals((int64_t) 100, bucket->first_seen, @"Unknown timestamps were not ignored");
+    STAssertEquals((int64_t) 300, bucket->last_seen, @"Incorrect last seen timestamp");
+    STAssertEqualCStrings("SIGSEGV", bucket->signal_name, @"Incorrect signal name");
+    STAssertTrue(bucket->exception_name == NULL, @"Unexpected exception name");
+    STAssertEqualCStrings("libfirst.dylib + 0x10 | Test + 0x21", bucket->frames, @"Incorrect frames");
+
+    /* The most recent samples are retained, with ties ordered by identifier */
+    STAssertEquals((size_t) 3, bucket->sample_count, @"Incorrect sample count");
+    STAssertEqualCStrings("a", bucket->samples[0], @"Incorrect sample");
+    STAssertEqualCStrings("d", bucket->samples[1], @"Incorrect sample");
+    STAssertEqualCStrings("b", bucket->samples[2], @"Incorrect sample");
+
+    bucket = &table.buckets[1];
+    STAssertEquals((uint64_t) 1, bucket->count, @"Incorrect count");
+    STAssertEqualCStrings("NSRangeException", bucket->exception_name, @"Incorrect exception name");
+
+    plcrash_bucket_table_free(&table);
+}
+
+- (void) testAddPaths {
+    siginfo_t info;
+    plframe_cursor_t cursor;
+    plcrash_log_writer_t writer;
+    plcrash_async_file_t file;
+    plcrash_bucket_table_t table;
+    plcrash_report_t report;
+    NSData *data;
+
+    /* Write a crash report */
+    memset(&info, 0, sizeof(info));
+    info.si_signo = SIGSEGV;
+    info.si_code = SEGV_MAPERR;
+    plframe_cursor_thread_init(&cursor, pthread_mach_thread_np(_thr_args.thread));
+
+    int fd = open([_logPath fileSystemRepresentation], O_RDWR|O_CREAT|O_EXCL, 0644);
+    plcrash_async_file_init(&file, fd, 0);
+
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_log_writer_init(&writer, @"test.id", @"1.0"), @"Initialization failed");
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_log_writer_write(&writer, &file, &info, cursor.uap), @"Crash log failed");
+    plcrash_log_writer_close(&writer);
+    plcrash_log_writer_free(&writer);
+
+    plcrash_async_file_flush(&file);
+    plcrash_async_file_close(&file);
+
+    /* Bucket it twice, along with a missing file and a file that is not a crash report */
+    const char *paths[] = { [_logPath fileSystemRepresentation], "/nonexistent/report.plcrash", "/etc/hosts", [_logPath fileSystemRepresentation] };
+
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_bucket_table_init(&table, 0), @"Could not initialize the table");
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_bucket_table_add_paths(&table, paths, 4, 2), @"Could not bucket reports");
+
+    STAssertEquals((uint64_t) 2, table.report_count, @"Incorrect report count");
+    STAssertEquals((uint64_t) 2, table.failed_count, @"Incorrect failed count");
+    STAssertEquals((size_t) 1, table.bucket_count, @"Incorrect bucket count");
+    STAssertEquals((uint64_t) 2, table.buckets[0].count, @"Incorrect count");
+    STAssertEquals((size_t) 1, table.buckets[0].sample_count, @"Duplicate identifiers were retained");
+
+    /* The fingerprint matches that of the decoded report */
+    data = [NSData dataWithContentsOfFile: _logPath];
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_report_decode(&report, [data bytes], [data length], NULL), @"Decode failed");
+    STAssertEquals(plcrash_bucket_fingerprint(&report, PLCRASH_BUCKET_DEFAULT_FRAMES), table.buckets[0].fingerprint, @"Incorrect fingerprint");
+    plcrash_report_free(&report);
+
+    plcrash_bucket_table_free(&table);
+}
+
+@end
@@ -0,0 +1,1169 @@
+/*
+ * Copyright (c) 2008-2011 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "PLCrashCollector.h"
+#include "PLCrashBucket.h"
+#include "PLCrashCompression.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+#ifdef __APPLE__
+#include <mach/mach_time.h>
+#endif
+
+/**
+ * @ingroup plcrash_collector
+ * @{
+ */
+
+/* Size of each batch entry header */
+#define BATCH_ENTRY_HEADER_SIZE 16
+
+/* Initial dedup table capacity; must be a power of two */
+#define SEEN_INITIAL_CAPACITY 256
+
+/* Maximum length of an upload response header that is parsed */
+#define RESPONSE_HEADER_MAX 4096
+
+/* Suppress SIGPIPE if a peer closes its connection early */
+#ifdef MSG_NOSIGNAL
+#define COLLECTOR_SEND_FLAGS MSG_NOSIGNAL
+#else
+#define COLLECTOR_SEND_FLAGS 0
+#endif
+
+/**
+ * @internal
+ * A queued upload entry.
+ */
+struct plcrash_collector_entry {
+    /** Next entry in the queue */
+    plcrash_collector_entry_t *next;
+
+    /** Report fingerprint */
+    uint64_t fingerprint;
+
+    /** Number of reports this entry stands for */
+    uint32_t occurrences;
+
+    /** gzip compressed report, or NULL for a count-only entry */
+    uint8_t *report;
+    size_t length;
+
+    /** Time at which the entry was queued, in milliseconds */
+    uint64_t queued_at;
+};
+
+/**
+ * @internal
+ * Return the current monotonic time, in milliseconds.
+ */
+static uint64_t collector_now (void) {
+#ifdef __APPLE__
+    static mach_timebase_info_data_t timebase;
+    if (timebase.denom == 0)
+        mach_timebase_info(&timebase);
+    return (mach_absolute_time() * timebase.numer / timebase.denom) / 1000000;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000 + (uint64_t) ts.tv_nsec / 1000000;
+#endif
+}
+
+/**
+ * @internal
+ * Encode @a value into @a buf in little-endian byte order.
+ */
+static void collector_put_le (uint8_t *buf, uint64_t value, size_t size) {
+    for (size_t i = 0; i < size; i++)
+        buf[i] = (uint8_t) (value >> (8 * i));
+}
+
+/**
+ * @internal
+ * Decode a little-endian value of @a size bytes from @a buf.
+ */
+static uint32_t collector_get_le (const uint8_t *buf, size_t size) {
+    uint32_t value = 0;
+    for (size_t i = 0; i < size; i++)
+        value |= (uint32_t) buf[i] << (8 * i);
+    return value;
+}
+
+/**
+ * @internal
+ * Return the number of queued bytes accounted to @a entry.
+ */
+static size_t entry_size (const plcrash_collector_entry_t *entry) {
+    return BATCH_ENTRY_HEADER_SIZE + entry->length;
+}
+
+/**
+ * @internal
+ * Free @a entry and all entries following it.
+ */
+static void entry_free_list (plcrash_collector_entry_t *entry) {
+    while (entry != NULL) {
+        plcrash_collector_entry_t *next = entry->next;
+        free(entry->report);
+        free(entry);
+        entry = next;
+    }
+}
+
+/**
+ * @internal
+ * Parse @a url, of the form http://host[:port][/path], into @a endpoint.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, PLCRASH_ENOTSUP if the URL uses a scheme other than http,
+ * PLCRASH_EINVAL if it is malformed, or PLCRASH_ENOMEM if memory could not be allocated.
+ */
+static plcrash_error_t endpoint_parse (plcrash_collector_endpoint_t *endpoint, const char *url) {
+    static const char scheme[] = "http://";
+    const char *authority, *host_end, *port, *path;
+    size_t host_length;
+
+    memset(endpoint, 0, sizeof(*endpoint));
+
+    if (strncasecmp(url, scheme, sizeof(scheme) - 1) != 0)
+        return (strstr(url, "://") != NULL) ? PLCRASH_ENOTSUP : PLCRASH_EINVAL;
+
+    authority = url + sizeof(scheme) - 1;
+    path = strchr(authority, '/');
+    if (path == NULL)
+        path = authority + strlen(authority);
+
+    /* Bracketed IPv6 literal */
+    if (*authority == '[') {
+        host_end = memchr(authority, ']', (size_t) (path - authority));
+        if (host_end == NULL)
+            return PLCRASH_EINVAL;
+        authority++;
+        host_length = (size_t) (host_end - authority);
+        port = host_end + 1;
+    } else {
+        host_end = memchr(authority, ':', (size_t) (path - authority));
+        if (host_end == NULL)
+            host_end = path;
+        host_length = (size_t) (host_end - authority);
+        port = host_end;
+    }
+
+    if (host_length == 0)
+        return PLCRASH_EINVAL;
+
+    if (port < path) {
+        if (*port != ':' || port + 1 == path || strspn(port + 1, "0123456789") != (size_t) (path - port - 1))
+            return PLCRASH_EINVAL;
+        endpoint->port = strndup(port + 1, (size_t) (path - port - 1));
+    } else {
+        endpoint->port = strdup("80");
+    }
+
+    endpoint->host = strndup(authority, host_length);
+    endpoint->path = strdup(*path != '\0' ? path : "/");
+
+    if (endpoint->host == NULL || endpoint->port == NULL || endpoint->path == NULL)
+        return PLCRASH_ENOMEM;
+
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * @internal
+ * Free the storage held by @a endpoint.
+ */
+static void endpoint_free (plcrash_collector_endpoint_t *endpoint) {
+    free(endpoint->host);
+    free(endpoint->port);
+    free(endpoint->path);
+    memset(endpoint, 0, sizeof(*endpoint));
+}
+
+/**
+ * @internal
+ * Return the dedup table key for @a fingerprint. Zero marks an empty slot, and is remapped.
+ */
+static uint64_t seen_key (uint64_t fingerprint) {
+    return (fingerprint != 0) ? fingerprint : 1;
+}
+
+/**
+ * @internal
+ * Return the dedup table slot for @a fingerprint, or the empty slot at which it would be inserted.
+ */
+static plcrash_collector_seen_t *seen_slot (plcrash_collector_seen_t *table, size_t capacity, uint64_t fingerprint) {
+    uint64_t key = seen_key(fingerprint);
+    size_t mask = capacity - 1;
+
+    for (size_t i = (size_t) (key ^ (key >> 32)) & mask;; i = (i + 1) & mask) {
+        if (table[i].fingerprint == key || table[i].fingerprint == 0)
+            return &table[i];
+    }
+}
+
+/**
+ * @internal
+ * Return the dedup table entry for @a fingerprint, or NULL if there is none. Must be called with the lock held.
+ */
+static plcrash_collector_seen_t *seen_lookup (plcrash_collector_t *collector, uint64_t fingerprint) {
+    plcrash_collector_seen_t *slot = seen_slot(collector->seen, collector->seen_capacity, fingerprint);
+    return (slot->fingerprint != 0) ? slot : NULL;
+}
+
+/**
+ * @internal
+ * Rebuild the dedup table, dropping fingerprints that have no queued entry and whose dedup window has passed, and
+ * growing the table if it is still more than a quarter full. Must be called with the lock held.
+ */
+static bool seen_rebuild (plcrash_collector_t *collector, uint64_t now) {
+    size_t live = 0;
+    size_t capacity = collector->seen_capacity;
+    plcrash_collector_seen_t *table;
+
+    for (size_t i = 0; i < collector->seen_capacity; i++) {
+        plcrash_collector_seen_t *seen = &collector->seen[i];
+        if (seen->fingerprint == 0)
+            continue;
+        if (seen->pending == NULL && now - seen->queued_at >= collector->config.dedup_window_ms)
+            seen->fingerprint = 0;
+        else
+            live++;
+    }
+
+    if (live > capacity / 4)
+        capacity *= 2;
+
+    table = calloc(capacity, sizeof(*table));
+    if (table == NULL)
+        return false;
+
+    for (size_t i = 0; i < collector->seen_capacity; i++) {
+        if (collector->seen[i].fingerprint != 0)
+            *seen_slot(table, capacity, collector->seen[i].fingerprint) = collector->seen[i];
+    }
+
+    free(collector->seen);
+    collector->seen = table;
+    collector->seen_capacity = capacity;
+    collector->seen_count = live;
+    return true;
+}
+
+/**
+ * @internal
+ * Return the dedup table entry for @a fingerprint, inserting one if there is none. Must be called with the lock
+ * held.
+ *
+ * @return Returns the entry, or NULL if memory could not be allocated.
+ */
+static plcrash_collector_seen_t *seen_insert (plcrash_collector_t *collector, uint64_t fingerprint, uint64_t now) {
+    plcrash_collector_seen_t *slot = seen_slot(collector->seen, collector->seen_capacity, fingerprint);
+    if (slot->fingerprint != 0)
+        return slot;
+
+    /* Keep the table at most half full */
+    if (collector->seen_count + 1 > collector->seen_capacity / 2) {
+        if (!seen_rebuild(collector, now))
+            return NULL;
+        slot = seen_slot(collector->seen, collector->seen_capacity, fingerprint);
+    }
+
+    memset(slot, 0, sizeof(*slot));
+    slot->fingerprint = seen_key(fingerprint);
+    collector->seen_count++;
+    return slot;
+}
+
+/**
+ * @internal
+ * Append a new entry to the upload queue. Must be called with the lock held.
+ *
+ * @return Returns the entry, or NULL if memory could not be allocated, in which case @a report is not freed.
+ */
+static plcrash_collector_entry_t *queue_append (plcrash_collector_t *collector, uint64_t fingerprint, uint8_t *report, size_t length, uint64_t now) {
+    plcrash_collector_entry_t *entry = calloc(1, sizeof(*entry));
+    if (entry == NULL)
+        return NULL;
+
+    entry->fingerprint = fingerprint;
+    entry->occurrences = 1;
+    entry->report = report;
+    entry->length = length;
+    entry->queued_at = now;
+
+    if (collector->queue_tail != NULL)
+        collector->queue_tail->next = entry;
+    else
+        collector->queue_head = entry;
+    collector->queue_tail = entry;
+
+    collector->stats.queued_entries++;
+    collector->stats.queued_bytes += entry_size(entry);
+    pthread_cond_signal(&collector->cond);
+    return entry;
+}
+
+/**
+ * @internal
+ * Return true if the queued entries fill a batch. Must be called with the lock held.
+ */
+static bool queue_batch_full (plcrash_collector_t *collector) {
+    return collector->stats.queued_entries >= collector->config.batch_max_reports ||
+           collector->stats.queued_bytes >= collector->config.batch_max_bytes;
+}
+
+/**
+ * @internal
+ * Remove the next batch from the head of the queue. Duplicates of the batch's reports are no longer folded into
+ * them. Must be called with the lock held.
+ *
+ * @param count On return, the number of entries in the batch.
+ */
+static plcrash_collector_entry_t *queue_take_batch (plcrash_collector_t *collector, size_t *count) {
+    plcrash_collector_entry_t *batch = collector->queue_head;
+    plcrash_collector_entry_t *last = NULL;
+    size_t bytes = 0;
+
+    *count = 0;
+    for (plcrash_collector_entry_t *entry = batch; entry != NULL; entry = entry->next) {
+        /* A single oversized entry is still sent, on its own */
+        if (*count == collector->config.batch_max_reports || (*count > 0 && bytes + entry_size(entry) > collector->config.batch_max_bytes))
+            break;
+
+        plcrash_collector_seen_t *seen = seen_lookup(collector, entry->fingerprint);
+        if (seen != NULL && seen->pending == entry)
+            seen->pending = NULL;
+
+        bytes += entry_size(entry);
+        (*count)++;
+        last = entry;
+    }
+
+    collector->queue_head = last->next;
+    if (collector->queue_head == NULL)
+        collector->queue_tail = NULL;
+    last->next = NULL;
+
+    collector->stats.queued_entries -= *count;
+    collector->stats.queued_bytes -= bytes;
+    return batch;
+}
+
+/**
+ * @internal
+ * Return a batch whose upload failed to the head of the queue, so that it is retried before any later reports.
+ * Must be called with the lock held.
+ */
+static void queue_return_batch (plcrash_collector_t *collector, plcrash_collector_entry_t *batch) {
+    plcrash_collector_entry_t *last = NULL;
+
+    for (plcrash_collector_entry_t *entry = batch; entry != NULL; entry = entry->next) {
+        plcrash_collector_seen_t *seen = seen_lookup(collector, entry->fingerprint);
+        if (seen != NULL && seen->pending == NULL)
+            seen->pending = entry;
+
+        collector->stats.queued_entries++;
+        collector->stats.queued_bytes += entry_size(entry);
+        last = entry;
+    }
+
+    last->next = collector->queue_head;
+    collector->queue_head = batch;
+    if (collector->queue_tail == NULL)
+        collector->queue_tail = last;
+}
+
+/**
+ * @internal
+ * Encode @a batch into @a output in the batch upload format.
+ */
+static void batch_encode (plcrash_collector_entry_t *batch, size_t count, plcrash_report_output_t *output) {
+    uint8_t header[BATCH_ENTRY_HEADER_SIZE];
+
+    collector_put_le(header, PLCRASH_COLLECTOR_BATCH_MAGIC, 4);
+    collector_put_le(header + 4, PLCRASH_COLLECTOR_BATCH_VERSION, 4);
+    collector_put_le(header + 8, count, 4);
+    plcrash_report_output_write(output, header, 12);
+
+    for (plcrash_collector_entry_t *entry = batch; entry != NULL; entry = entry->next) {
+        collector_put_le(header, entry->fingerprint, 8);
+        collector_put_le(header + 8, entry->occurrences, 4);
+        collector_put_le(header + 12, entry->length, 4);
+        plcrash_report_output_write(output, header, sizeof(header));
+        if (entry->length > 0)
+            plcrash_report_output_write(output, entry->report, entry->length);
+    }
+}
+
+/**
+ * @internal
+ * Send all of @a data on @a fd, retrying on EINTR and short writes.
+ */
+static bool send_all (int fd, const void *data, size_t length) {
+    const uint8_t *p = data;
+
+    while (length > 0) {
+        ssize_t written = send(fd, p, length, COLLECTOR_SEND_FLAGS);
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        p += written;
+        length -= (size_t) written;
+    }
+    return true;
+}
+
+/**
+ * @internal
+ * Apply the collector's I/O timeout and SIGPIPE suppression to @a fd.
+ */
+static void socket_configure (int fd, uint32_t timeout_ms) {
+#ifdef SO_NOSIGPIPE
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+
+    if (timeout_ms > 0) {
+        struct timeval timeout;
+        timeout.tv_sec = timeout_ms / 1000;
+        timeout.tv_usec = (timeout_ms % 1000) * 1000;
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    }
+}
+
+/**
+ * @internal
+ * Connect to @a endpoint, waiting at most @a timeout_ms for each address.
+ *
+ * @return Returns a connected, blocking socket, or -1 on failure.
+ */
+static int http_connect (const plcrash_collector_endpoint_t *endpoint, uint32_t timeout_ms) {
+    struct addrinfo hints, *addrs;
+    int fd = -1;
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(endpoint->host, endpoint->port, &hints, &addrs) != 0) {
+        PLCF_DEBUG("Could not resolve upload host %s", endpoint->host);
+        return -1;
+    }
+
+    for (struct addrinfo *addr = addrs; addr != NULL; addr = addr->ai_next) {
+        struct pollfd pfd;
+        int flags, err = 0;
+        socklen_t err_length = sizeof(err);
+
+        fd = socket(addr->ai_family, addr->ai_socktype, addr->ai_protocol);
+        if (fd < 0)
+            continue;
+
+        /* Connect without blocking, so that an unresponsive host is bounded by the timeout */
+        flags = fcntl(fd, F_GETFL);
+        fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+        if (connect(fd, addr->ai_addr, addr->ai_addrlen) != 0) {
+            if (errno != EINPROGRESS) {
+                close(fd);
+                fd = -1;
+                continue;
+            }
+
+            pfd.fd = fd;
+            pfd.events = POLLOUT;
+            if (poll(&pfd, 1, timeout_ms > 0 ? (int) timeout_ms : -1) != 1 ||
+                getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &err_length) != 0 || err != 0)
+            {
+                close(fd);
+                fd = -1;
+                continue;
+            }
+        }
+
+        fcntl(fd, F_SETFL, flags);
+        socket_configure(fd, timeout_ms);
+        break;
+    }
+
+    freeaddrinfo(addrs);
+    return fd;
+}
+
+/**
+ * @internal
+ * POST @a body to @a endpoint.
+ *
+ * @param retry_after On return, the delay requested by a Retry-After response header, in milliseconds, or 0.
+ *
+ * @return Returns the HTTP status code, or -1 if the request could not be sent or no valid response was received.
+ */
+static int http_post (const plcrash_collector_endpoint_t *endpoint, const void *body, size_t length, uint32_t timeout_ms, uint64_t *retry_after) {
+    char request[1024];
+    char response[RESPONSE_HEADER_MAX + 1];
+    size_t response_length = 0;
+    int request_length;
+    int status = -1;
+    char *line;
+    int fd;
+
+    *retry_after = 0;
+
+    fd = http_connect(endpoint, timeout_ms);
+    if (fd < 0)
+        return -1;
+
+    request_length = snprintf(request, sizeof(request),
+                              "POST %s HTTP/1.1\r\n"
+                              "Host: %s%s%s%s%s\r\n"
+                              "Content-Type: application/x-plcrash-batch\r\n"
+                              "Content-Length: %zu\r\n"
+                              "Connection: close\r\n"
+                              "\r\n",
+                              endpoint->path,
+                              strchr(endpoint->host, ':') != NULL ? "[" : "", endpoint->host, strchr(endpoint->host, ':') != NULL ? "]" : "",
+                              strcmp(endpoint->port, "80") != 0 ? ":" : "", strcmp(endpoint->port, "80") != 0 ? endpoint->port : "",
+                              length);
+    if (request_length < 0 || (size_t) request_length >= sizeof(request) ||
+        !send_all(fd, request, (size_t) request_length) || !send_all(fd, body, length))
+    {
+        PLCF_DEBUG("Could not send upload request: %s", strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    /* Read the status line and headers; the body is ignored */
+    while (response_length < RESPONSE_HEADER_MAX) {
+        ssize_t count = recv(fd, response + response_length, RESPONSE_HEADER_MAX - response_length, 0);
+        if (count < 0 && errno == EINTR)
+            continue;
+        if (count <= 0)
+            break;
+        response_length += (size_t) count;
+        response[response_length] = '\0';
+        if (strstr(response, "\r\n\r\n") != NULL)
+            break;
+    }
+    close(fd);
+    response[response_length] = '\0';
+
+    if (response_length < 12 || strncmp(response, "HTTP/1.", 7) != 0 || response[8] != ' ')
+        return -1;
+    status = atoi(response + 9);
+    if (status < 100 || status > 999)
+        return -1;
+
+    for (line = strstr(response, "\r\n"); line != NULL; line = strstr(line, "\r\n")) {
+        line += 2;
+        if (strncasecmp(line, "Retry-After:", 12) == 0) {
+            /* Only the delay-seconds form is supported */
+            char *end;
+            unsigned long seconds = strtoul(line + 12, &end, 10);
+            if (end != line + 12)
+                *retry_after = (uint64_t) seconds * 1000;
+            break;
+        }
+    }
+
+    return status;
+}
+
+/**
+ * @internal
+ * Wait on the collector's condition for at most @a delay milliseconds. Must be called with the lock held.
+ */
+static void collector_wait (plcrash_collector_t *collector, uint64_t delay) {
+    struct timeval now;
+    struct timespec deadline;
+
+    gettimeofday(&now, NULL);
+    deadline.tv_sec = now.tv_sec + (time_t) (delay / 1000);
+    deadline.tv_nsec = (long) now.tv_usec * 1000 + (long) (delay % 1000) * 1000000;
+    if (deadline.tv_nsec >= 1000000000) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+    }
+
+    pthread_cond_timedwait(&collector->cond, &collector->lock, &deadline);
+}
+
+/**
+ * @internal
+ * Upload thread. Waits for a batch to become ready, uploads it, and applies backoff on failure. When the collector
+ * is stopped, the remaining queue is uploaded without waiting, until the queue is empty or an upload fails.
+ */
+static void *collector_upload_thread (void *arg) {
+    plcrash_collector_t *collector = arg;
+    plcrash_report_output_t body;
+
+    plcrash_report_output_init_buffer(&body, 0);
+
+    pthread_mutex_lock(&collector->lock);
+    for (;;) {
+        plcrash_collector_entry_t *batch;
+        uint64_t now = collector_now();
+        uint64_t retry_after;
+        size_t count;
+        int status;
+
+        if (collector->queue_head == NULL) {
+            collector->flush_requested = false;
+            if (collector->stopping)
+                break;
+            pthread_cond_wait(&collector->cond, &collector->lock);
+            continue;
+        }
+
+        if (!collector->stopping) {
+            uint64_t ready_at = collector->queue_head->queued_at + collector->config.flush_interval_ms;
+            if (collector->flush_requested || queue_batch_full(collector))
+                ready_at = now;
+            if (ready_at < collector->retry_at)
+                ready_at = collector->retry_at;
+
+            if (now < ready_at) {
+                collector_wait(collector, ready_at - now);
+                continue;
+            }
+        }
+
+        batch = queue_take_batch(collector, &count);
+        pthread_mutex_unlock(&collector->lock);
+
+        plcrash_report_output_reset(&body);
+        batch_encode(batch, count, &body);
+        if (body.error == PLCRASH_ESUCCESS)
+            status = http_post(&collector->endpoint, body.buffer, body.length, collector->config.io_timeout_ms, &retry_after);
+        else
+            status = -1;
+
+        pthread_mutex_lock(&collector->lock);
+        if (status >= 200 && status < 300) {
+            collector->stats.uploaded_entries += count;
+            collector->stats.uploaded_batches++;
+            collector->backoff = 0;
+            collector->retry_at = 0;
+            entry_free_list(batch);
+        } else if (status < 0 || status == 408 || status == 429 || status >= 500) {
+            PLCF_DEBUG("Upload failed with status %d; retrying", status);
+            collector->stats.upload_failures++;
+            queue_return_batch(collector, batch);
+
+            if (collector->stopping)
+                break;
+
+            if (collector->backoff == 0)
+                collector->backoff = collector->config.backoff_initial_ms;
+            else if (collector->backoff * 2 < collector->config.backoff_max_ms)
+                collector->backoff *= 2;
+            else
+                collector->backoff = collector->config.backoff_max_ms;
+
+            /* A Retry-After longer than the maximum backoff is capped, so that a misbehaving endpoint cannot stall the collector indefinitely */
+            if (retry_after > collector->config.backoff_max_ms)
+                retry_after = collector->config.backoff_max_ms;
+            collector->retry_at = collector_now() + ((retry_after > collector->backoff) ? retry_after : collector->backoff);
+            collector->flush_requested = false;
+        } else {
+            PLCF_DEBUG("Upload rejected with status %d; dropping %zu entries", status, count);
+            collector->stats.dropped_entries += count;
+            collector->backoff = 0;
+            collector->retry_at = 0;
+            entry_free_list(batch);
+        }
+    }
+    pthread_mutex_unlock(&collector->lock);
+
+    plcrash_report_output_free(&body);
+    return NULL;
+}
+
+/**
+ * @internal
+ * Deduplicate and queue a report received from a client.
+ *
+ * @return Returns the reply to be sent to the client.
+ */
+static plcrash_collector_status_t collector_receive (plcrash_collector_t *collector, const uint8_t *data, size_t length) {
+    plcrash_collector_seen_t *seen;
+    plcrash_collector_entry_t *entry;
+    plcrash_report_output_t compressed;
+    plcrash_report_t report;
+    const char *description;
+    uint64_t fingerprint;
+    uint8_t *stored;
+    size_t stored_length;
+    uint64_t now;
+
+    if (plcrash_report_decode(&report, data, length, &description) != PLCRASH_ESUCCESS) {
+        PLCF_DEBUG("Rejected report: %s", description);
+        pthread_mutex_lock(&collector->lock);
+        collector->stats.invalid++;
+        pthread_mutex_unlock(&collector->lock);
+        return PLCRASH_COLLECTOR_INVALID;
+    }
+    fingerprint = plcrash_bucket_fingerprint(&report, PLCRASH_BUCKET_DEFAULT_FRAMES);
+    plcrash_report_free(&report);
+
+    now = collector_now();
+    pthread_mutex_lock(&collector->lock);
+    seen = seen_lookup(collector, fingerprint);
+    if (seen != NULL && now - seen->queued_at < collector->config.dedup_window_ms) {
+        /* Fold into the queued entry, or start a count-only entry if the last report has already been uploaded */
+        if (seen->pending != NULL) {
+            seen->pending->occurrences++;
+        } else if ((seen->pending = queue_append(collector, fingerprint, NULL, 0, now)) == NULL) {
+            collector->stats.busy++;
+            pthread_mutex_unlock(&collector->lock);
+            return PLCRASH_COLLECTOR_BUSY;
+        }
+        collector->stats.duplicates++;
+        pthread_mutex_unlock(&collector->lock);
+        return PLCRASH_COLLECTOR_DUPLICATE;
+    } else if (seen != NULL && seen->pending != NULL && seen->pending->report != NULL) {
+        /* A full report is still waiting to be uploaded */
+        seen->pending->occurrences++;
+        collector->stats.duplicates++;
+        pthread_mutex_unlock(&collector->lock);
+        return PLCRASH_COLLECTOR_DUPLICATE;
+    }
+    pthread_mutex_unlock(&collector->lock);
+
+    /* Compress outside the lock. Only this thread queues reports, so the dedup state cannot change meanwhile. */
+    if (plcrash_gzip_detect(data, length)) {
+        stored = malloc(length);
+        if (stored != NULL)
+            memcpy(stored, data, length);
+        stored_length = length;
+    } else {
+        plcrash_report_output_init_buffer(&compressed, length / 2 + 64);
+        if (plcrash_gzip_compress(data, length, &compressed) == PLCRASH_ESUCCESS)
+            stored = (uint8_t *) plcrash_report_output_detach(&compressed, &stored_length);
+        else
+            stored = NULL;
+        plcrash_report_output_free(&compressed);
+    }
+
+    pthread_mutex_lock(&collector->lock);
+    if (stored == NULL || collector->stats.queued_bytes + BATCH_ENTRY_HEADER_SIZE + stored_length > collector->config.queue_max_bytes ||
+        (seen = seen_insert(collector, fingerprint, now)) == NULL ||
+        (entry = queue_append(collector, fingerprint, stored, stored_length, now)) == NULL)
+    {
+        collector->stats.busy++;
+        pthread_mutex_unlock(&collector->lock);
+        free(stored);
+        return PLCRASH_COLLECTOR_BUSY;
+    }
+
+    seen->pending = entry;
+    seen->queued_at = now;
+    collector->stats.accepted++;
+    pthread_mutex_unlock(&collector->lock);
+    return PLCRASH_COLLECTOR_ACCEPTED;
+}
+
+/**
+ * @internal
+ * Send @a status to @a client and close its connection.
+ */
+static void client_reply (plcrash_collector_client_t *client, plcrash_collector_status_t status) {
+    uint8_t reply = (uint8_t) status;
+
+    /* The socket buffer is empty, so a single byte never blocks */
+    send(client->fd, &reply, 1, COLLECTOR_SEND_FLAGS);
+    close(client->fd);
+    client->fd = -1;
+    free(client->report);
+    client->report = NULL;
+}
+
+/**
+ * @internal
+ * Close @a client's connection without a reply.
+ */
+static void client_close (plcrash_collector_client_t *client) {
+    close(client->fd);
+    client->fd = -1;
+    free(client->report);
+    client->report = NULL;
+}
+
+/**
+ * @internal
+ * Read the data available from @a client, and reply once its report is complete.
+ */
+static void client_read (plcrash_collector_t *collector, plcrash_collector_client_t *client) {
+    for (;;) {
+        uint8_t *buf;
+        size_t wanted;
+        ssize_t count;
+
+        if (client->header_length < sizeof(client->header)) {
+            buf = client->header + client->header_length;
+            wanted = sizeof(client->header) - client->header_length;
+        } else {
+            buf = client->report + client->received;
+            wanted = client->report_length - client->received;
+        }
+
+        count = recv(client->fd, buf, wanted, 0);
+        if (count < 0 && errno == EINTR)
+            continue;
+        if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return;
+        if (count <= 0) {
+            /* The client went away before sending a complete report */
+            client_close(client);
+            return;
+        }
+
+        if (client->header_length < sizeof(client->header)) {
+            client->header_length += (size_t) count;
+            if (client->header_length < sizeof(client->header))
+                continue;
+
+            client->report_length = collector_get_le(client->header + 8, 4);
+            if (collector_get_le(client->header, 4) != PLCRASH_COLLECTOR_MAGIC ||
+                collector_get_le(client->header + 4, 2) != PLCRASH_COLLECTOR_VERSION ||
+                client->report_length == 0 || client->report_length > PLCRASH_COLLECTOR_REPORT_MAX)
+            {
+                pthread_mutex_lock(&collector->lock);
+                collector->stats.invalid++;
+                pthread_mutex_unlock(&collector->lock);
+                client_reply(client, PLCRASH_COLLECTOR_INVALID);
+                return;
+            }
+
+            client->report = malloc(client->report_length);
+            if (client->report == NULL) {
+                pthread_mutex_lock(&collector->lock);
+                collector->stats.busy++;
+                pthread_mutex_unlock(&collector->lock);
+                client_reply(client, PLCRASH_COLLECTOR_BUSY);
+                return;
+            }
+        } else {
+            client->received += (size_t) count;
+            if (client->received == client->report_length) {
+                client_reply(client, collector_receive(collector, client->report, client->report_length));
+                return;
+            }
+        }
+    }
+}
+
+/**
+ * @internal
+ * Accept pending connections, up to PLCRASH_COLLECTOR_MAX_CLIENTS.
+ */
+static void collector_accept (plcrash_collector_t *collector, uint64_t now) {
+    while (collector->client_count < PLCRASH_COLLECTOR_MAX_CLIENTS) {
+        plcrash_collector_client_t *client;
+        int fd = accept(collector->listen_fd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR)
+                continue;
+            return;
+        }
+
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        socket_configure(fd, 0);
+
+        client = &collector->clients[collector->client_count++];
+        memset(client, 0, sizeof(*client));
+        client->fd = fd;
+        client->deadline = now + collector->config.io_timeout_ms;
+    }
+}
+
+/**
+ * Initialize @a config with the default collector configuration. The socket path and upload URL must be set by
+ * the caller.
+ *
+ * @param config The configuration to initialize.
+ */
+void plcrash_collector_config_init (plcrash_collector_config_t *config) {
+    memset(config, 0, sizeof(*config));
+    config->socket_mode = 0660;
+    config->batch_max_reports = 32;
+    config->batch_max_bytes = 1024 * 1024;
+    config->flush_interval_ms = 30 * 1000;
+    config->dedup_window_ms = 60 * 60 * 1000;
+    config->backoff_initial_ms = 1000;
+    config->backoff_max_ms = 5 * 60 * 1000;
+    config->io_timeout_ms = 10 * 1000;
+    config->queue_max_bytes = 64 * 1024 * 1024;
+}
+
+/**
+ * Initialize @a collector, listen on the configured socket, and start the upload thread. The configuration's
+ * strings are copied.
+ *
+ * @param collector The collector to initialize.
+ * @param config The collector configuration.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, PLCRASH_ENOTSUP if the upload URL is not an http:// URL,
+ * PLCRASH_EINVAL if the configuration is invalid, PLCRASH_OUTPUT_ERR if the socket could not be created, or
+ * PLCRASH_ENOMEM if memory could not be allocated. On failure, @a collector does not need to be freed.
+ */
+plcrash_error_t plcrash_collector_init (plcrash_collector_t *collector, const plcrash_collector_config_t *config) {
+    struct sockaddr_un addr;
+    struct stat sb;
+    plcrash_error_t err;
+
+    memset(collector, 0, sizeof(*collector));
+    collector->listen_fd = -1;
+
+    if (config->socket_path == NULL || config->upload_url == NULL || config->batch_max_reports == 0 ||
+        config->batch_max_bytes == 0 || strlen(config->socket_path) >= sizeof(addr.sun_path))
+    {
+        return PLCRASH_EINVAL;
+    }
+
+    collector->config = *config;
+    collector->config.upload_url = NULL;
+    collector->config.socket_path = strdup(config->socket_path);
+    if (collector->config.socket_path == NULL)
+        return PLCRASH_ENOMEM;
+
+    if ((err = endpoint_parse(&collector->endpoint, config->upload_url)) != PLCRASH_ESUCCESS)
+        goto error;
+
+    collector->seen_capacity = SEEN_INITIAL_CAPACITY;
+    collector->seen = calloc(collector->seen_capacity, sizeof(*collector->seen));
+    if (collector->seen == NULL) {
+        err = PLCRASH_ENOMEM;
+        goto error;
+    }
+
+    /* Replace a socket left behind by a previous collector, but never any other file */
+    if (lstat(config->socket_path, &sb) == 0 && S_ISSOCK(sb.st_mode))
+        unlink(config->socket_path);
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, config->socket_path, sizeof(addr.sun_path) - 1);
+
+    collector->listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (collector->listen_fd < 0 ||
+        bind(collector->listen_fd, (struct sockaddr *) &addr, sizeof(addr)) != 0 ||
+        chmod(config->socket_path, config->socket_mode) != 0 ||
+        listen(collector->listen_fd, SOMAXCONN) != 0)
+    {
+        PLCF_DEBUG("Could not listen on %s: %s", config->socket_path, strerror(errno));
+        err = PLCRASH_OUTPUT_ERR;
+        goto error;
+    }
+    fcntl(collector->listen_fd, F_SETFL, fcntl(collector->listen_fd, F_GETFL) | O_NONBLOCK);
+
+    pthread_mutex_init(&collector->lock, NULL);
+    pthread_cond_init(&collector->cond, NULL);
+
+    if (pthread_create(&collector->uploader, NULL, collector_upload_thread, collector) != 0) {
+        pthread_mutex_destroy(&collector->lock);
+        pthread_cond_destroy(&collector->cond);
+        err = PLCRASH_ENOMEM;
+        goto error;
+    }
+    collector->uploader_started = true;
+
+    return PLCRASH_ESUCCESS;
+
+error:
+    if (collector->listen_fd >= 0) {
+        close(collector->listen_fd);
+        unlink(config->socket_path);
+    }
+    free(collector->seen);
+    endpoint_free(&collector->endpoint);
+    free((char *) collector->config.socket_path);
+    memset(collector, 0, sizeof(*collector));
+    collector->listen_fd = -1;
+    return err;
+}
+
+/**
+ * Accept client connections and receive reports for at most @a timeout_ms, returning early once any socket has
+ * been serviced. Call repeatedly from the collector's main loop.
+ *
+ * @param collector The collector.
+ * @param timeout_ms Maximum time to wait for activity, in milliseconds.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, including when interrupted by a signal, or PLCRASH_EINTERNAL if
+ * polling failed.
+ */
+plcrash_error_t plcrash_collector_run (plcrash_collector_t *collector, uint32_t timeout_ms) {
+    struct pollfd fds[1 + PLCRASH_COLLECTOR_MAX_CLIENTS];
+    uint64_t now = collector_now();
+    uint64_t wait = timeout_ms;
+    size_t client_count = collector->client_count;
+    size_t live;
+    int ready;
+
+    /* Stop accepting while every client slot is in use */
+    fds[0].fd = (client_count < PLCRASH_COLLECTOR_MAX_CLIENTS) ? collector->listen_fd : -1;
+    fds[0].events = POLLIN;
+    fds[0].revents = 0;
+
+    for (size_t i = 0; i < client_count; i++) {
+        fds[1 + i].fd = collector->clients[i].fd;
+        fds[1 + i].events = POLLIN;
+        fds[1 + i].revents = 0;
+        if (collector->clients[i].deadline <= now)
+            wait = 0;
+        else if (collector->clients[i].deadline - now < wait)
+            wait = collector->clients[i].deadline - now;
+    }
+
+    ready = poll(fds, (nfds_t) (1 + client_count), (int) wait);
+    if (ready < 0) {
+        if (errno == EINTR)
+            return PLCRASH_ESUCCESS;
+        PLCF_DEBUG("poll() failed: %s", strerror(errno));
+        return PLCRASH_EINTERNAL;
+    }
+
+    now = collector_now();
+    for (size_t i = 0; i < client_count; i++) {
+        plcrash_collector_client_t *client = &collector->clients[i];
+        if (fds[1 + i].revents != 0)
+            client_read(collector, client);
+        if (client->fd >= 0 && client->deadline <= now)
+            client_close(client);
+    }
+
+    /* Compact the client table */
+    live = 0;
+    for (size_t i = 0; i < client_count; i++) {
+        if (collector->clients[i].fd >= 0)
+            collector->clients[live++] = collector->clients[i];
+    }
+    collector->client_count = live;
+
+    if (fds[0].revents != 0)
+        collector_accept(collector, now);
+
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * Upload all queued reports without waiting for the flush interval or any pending backoff.
+ *
+ * @param collector The collector.
+ */
+void plcrash_collector_flush (plcrash_collector_t *collector) {
+    pthread_mutex_lock(&collector->lock);
+    collector->flush_requested = true;
+    collector->retry_at = 0;
+    pthread_cond_signal(&collector->cond);
+    pthread_mutex_unlock(&collector->lock);
+}
+
+/**
+ * Copy the collector's current statistics to @a stats.
+ *
+ * @param collector The collector.
+ * @param stats On return, the collector statistics.
+ */
+void plcrash_collector_get_stats (plcrash_collector_t *collector, plcrash_collector_stats_t *stats) {
+    pthread_mutex_lock(&collector->lock);
+    *stats = collector->stats;
+    pthread_mutex_unlock(&collector->lock);
+}
+
+/**
+ * Stop listening for reports, upload the queued reports without waiting for a batch to fill, and stop the upload
+ * thread. Reports that cannot be uploaded remain queued until the collector is freed. Statistics remain available
+ * until then.
+ *
+ * @param collector The collector to stop.
+ */
+void plcrash_collector_stop (plcrash_collector_t *collector) {
+    for (size_t i = 0; i < collector->client_count; i++)
+        client_close(&collector->clients[i]);
+    collector->client_count = 0;
+
+    if (collector->listen_fd >= 0) {
+        close(collector->listen_fd);
+        unlink(collector->config.socket_path);
+        collector->listen_fd = -1;
+    }
+
+    if (!collector->uploader_started)
+        return;
+
+    pthread_mutex_lock(&collector->lock);
+    collector->stopping = true;
+    pthread_cond_signal(&collector->cond);
+    pthread_mutex_unlock(&collector->lock);
+
+    pthread_join(collector->uploader, NULL);
+    collector->uploader_started = false;
+}
+
+/**
+ * Stop @a collector if it is still running, discard any reports that could not be uploaded, and free all
+ * associated resources.
+ *
+ * @param collector The collector to free.
+ */
+void plcrash_collector_free (plcrash_collector_t *collector) {
+    /* The dedup table and lock exist only if initialization succeeded */
+    if (collector->seen != NULL) {
+        plcrash_collector_stop(collector);
+        pthread_mutex_destroy(&collector->lock);
+        pthread_cond_destroy(&collector->cond);
+    }
+
+    entry_free_list(collector->queue_head);
+    free(collector->seen);
+    endpoint_free(&collector->endpoint);
+    free((char *) collector->config.socket_path);
+
+    memset(collector, 0, sizeof(*collector));
+    collector->listen_fd = -1;
+}
+
+/**
+ * @} plcrash_collector
+ */
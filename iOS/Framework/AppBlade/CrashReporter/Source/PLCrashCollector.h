@@ -0,0 +1,247 @@
+/*
+ * Copyright (c) 2008-2011 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef PLCRASH_COLLECTOR_H
+#define PLCRASH_COLLECTOR_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#import "PLCrashAsync.h"
+#include "PLCrashCollectorClient.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @internal
+ * @defgroup plcrash_collector Crash Collector
+ *
+ * A host-wide crash collector. Crashing processes, or their capture helpers, hand finished reports to the
+ * collector over a Unix domain socket using plcrash_collector_submit(); the collector deduplicates them, compresses
+ * them, and uploads them in batches to a single HTTP endpoint.
+ *
+ * Each report is decoded and fingerprinted with plcrash_bucket_fingerprint(). A report whose fingerprint matches a
+ * report still waiting to be uploaded is folded into that report's occurrence count. Once that report has been
+ * uploaded, further reports with its fingerprint that arrive within the dedup window of it being queued are not
+ * uploaded again; they are counted, and their counts uploaded as a count-only entry. Reports that are queued are
+ * gzip compressed (see plcrash_compression).
+ *
+ * Queued reports are uploaded by a background thread once a batch is full, or once the oldest queued report has
+ * waited for the flush interval. Failed uploads, and uploads refused with HTTP 429 or 503, are retried with
+ * exponential backoff, honoring any Retry-After header; batches refused with any other 4xx status are dropped.
+ * When the queue reaches its size limit new reports are refused with PLCRASH_COLLECTOR_BUSY, leaving the client to
+ * retry them later.
+ *
+ * A batch is POSTed with the content type application/x-plcrash-batch, as a header followed by one entry per
+ * fingerprint. All values are little-endian.
+ *
+ *   header:  "PLCB"  uint32 version  uint32 entry count
+ *   entry:   uint64 fingerprint  uint32 occurrences  uint32 report length  report bytes (gzip; empty if count-only)
+ *
+ * Only http:// endpoints are supported; TLS should be terminated by a local proxy.
+ *
+ * These functions allocate memory, and are not async-safe.
+ *
+ * @{
+ */
+
+/** Batch magic ('PLCB') */
+#define PLCRASH_COLLECTOR_BATCH_MAGIC 0x42434c50
+
+/** Batch format version */
+#define PLCRASH_COLLECTOR_BATCH_VERSION 1
+
+/** Maximum number of simultaneous client connections */
+#define PLCRASH_COLLECTOR_MAX_CLIENTS 64
+
+/**
+ * Collector configuration. Initialize with plcrash_collector_config_init(), then set at least the socket path and
+ * upload URL.
+ */
+typedef struct plcrash_collector_config {
+    /** Path of the Unix domain socket to listen on. An existing socket at this path is replaced. */
+    const char *socket_path;
+
+    /** Permissions of the socket; 0660 by default */
+    mode_t socket_mode;
+
+    /** Upload endpoint, as http://host[:port][/path] */
+    const char *upload_url;
+
+    /** Maximum number of entries and of report bytes in a single upload */
+    size_t batch_max_reports;
+    size_t batch_max_bytes;
+
+    /** Maximum time a queued report waits for a batch to fill, in milliseconds */
+    uint32_t flush_interval_ms;
+
+    /** Time after a report is queued during which reports with the same fingerprint are only counted, in milliseconds */
+    uint32_t dedup_window_ms;
+
+    /** Initial and maximum delay between failed uploads, in milliseconds */
+    uint32_t backoff_initial_ms;
+    uint32_t backoff_max_ms;
+
+    /** Timeout for each upload connection, send and receive, and for idle clients, in milliseconds */
+    uint32_t io_timeout_ms;
+
+    /** Maximum number of compressed report bytes queued; reports beyond this are refused as busy */
+    size_t queue_max_bytes;
+} plcrash_collector_config_t;
+
+/**
+ * Collector statistics.
+ */
+typedef struct plcrash_collector_stats {
+    /** Reports received, by reply */
+    uint64_t accepted;
+    uint64_t duplicates;
+    uint64_t busy;
+    uint64_t invalid;
+
+    /** Entries and batches uploaded successfully */
+    uint64_t uploaded_entries;
+    uint64_t uploaded_batches;
+
+    /** Upload attempts that failed and will be retried */
+    uint64_t upload_failures;
+
+    /** Entries dropped because the endpoint rejected their batch */
+    uint64_t dropped_entries;
+
+    /** Entries and compressed report bytes currently queued */
+    uint64_t queued_entries;
+    uint64_t queued_bytes;
+} plcrash_collector_stats_t;
+
+/** @internal A parsed upload endpoint */
+typedef struct plcrash_collector_endpoint {
+    char *host;
+    char *port;
+    char *path;
+} plcrash_collector_endpoint_t;
+
+/** @internal A queued upload entry */
+typedef struct plcrash_collector_entry plcrash_collector_entry_t;
+
+/** @internal A client connection */
+typedef struct plcrash_collector_client {
+    /** Client socket */
+    int fd;
+
+    /** Frame header, and the number of its bytes received */
+    uint8_t header[PLCRASH_COLLECTOR_HEADER_SIZE];
+    size_t header_length;
+
+    /** Report buffer, its expected length, and the number of bytes received */
+    uint8_t *report;
+    size_t report_length;
+    size_t received;
+
+    /** Time after which the client is disconnected, in milliseconds */
+    uint64_t deadline;
+} plcrash_collector_client_t;
+
+/** @internal Dedup table slot */
+typedef struct plcrash_collector_seen {
+    /** Fingerprint; 0 marks an empty slot */
+    uint64_t fingerprint;
+
+    /** Time at which the last full report with this fingerprint was queued, in milliseconds */
+    uint64_t queued_at;
+
+    /** The queued entry with this fingerprint that duplicates are folded into, or NULL */
+    plcrash_collector_entry_t *pending;
+} plcrash_collector_seen_t;
+
+/**
+ * A running collector. All fields are private.
+ */
+typedef struct plcrash_collector {
+    /** @internal Configuration, and the parsed upload endpoint */
+    plcrash_collector_config_t config;
+    plcrash_collector_endpoint_t endpoint;
+
+    /** @internal Listening socket */
+    int listen_fd;
+
+    /** @internal Connected clients */
+    plcrash_collector_client_t clients[PLCRASH_COLLECTOR_MAX_CLIENTS];
+    size_t client_count;
+
+    /** @internal Guards all fields below */
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+
+    /** @internal Upload queue, oldest first */
+    plcrash_collector_entry_t *queue_head;
+    plcrash_collector_entry_t *queue_tail;
+
+    /** @internal Open-addressed dedup table, and the number of occupied slots */
+    plcrash_collector_seen_t *seen;
+    size_t seen_capacity;
+    size_t seen_count;
+
+    /** @internal Current backoff delay, and the time before which no upload is attempted, in milliseconds */
+    uint64_t backoff;
+    uint64_t retry_at;
+
+    /** @internal Set to upload immediately, and to stop the upload thread */
+    bool flush_requested;
+    bool stopping;
+
+    /** @internal Statistics */
+    plcrash_collector_stats_t stats;
+
+    /** @internal Upload thread */
+    pthread_t uploader;
+    bool uploader_started;
+} plcrash_collector_t;
+
+void plcrash_collector_config_init (plcrash_collector_config_t *config);
+
+plcrash_error_t plcrash_collector_init (plcrash_collector_t *collector, const plcrash_collector_config_t *config);
+plcrash_error_t plcrash_collector_run (plcrash_collector_t *collector, uint32_t timeout_ms);
+void plcrash_collector_flush (plcrash_collector_t *collector);
+void plcrash_collector_get_stats (plcrash_collector_t *collector, plcrash_collector_stats_t *stats);
+void plcrash_collector_stop (plcrash_collector_t *collector);
+void plcrash_collector_free (plcrash_collector_t *collector);
+
+/**
+ * @} plcrash_collector
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PLCRASH_COLLECTOR_H */
@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) 2008-2011 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "PLCrashCollectorClient.h"
+
+#include <errno.h>
+#include <stdbool.h>
+#include <string.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+/**
+ * @ingroup plcrash_collector_client
+ * @{
+ */
+
+/* Suppress SIGPIPE if the collector closes the connection early */
+#ifdef MSG_NOSIGNAL
+#define CLIENT_SEND_FLAGS MSG_NOSIGNAL
+#else
+#define CLIENT_SEND_FLAGS 0
+#endif
+
+/**
+ * @internal
+ * Send all of @a data on @a fd, retrying on EINTR and short writes.
+ */
+static bool client_send_all (int fd, const uint8_t *data, size_t length) {
+    while (length > 0) {
+        ssize_t written = send(fd, data, length, CLIENT_SEND_FLAGS);
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        data += written;
+        length -= (size_t) written;
+    }
+    return true;
+}
+
+/**
+ * @internal
+ * Connect @a fd to @a addr. An interrupted connect() may continue asynchronously, in which case calling connect()
+ * again would fail with EALREADY or EISCONN. Instead, wait for the socket to become writable and fetch the result
+ * with SO_ERROR. Some systems abandon an interrupted Unix domain connect instead; if the socket is not connected
+ * once writable, the connect is issued again.
+ *
+ * @param fd The socket to connect.
+ * @param addr The collector's address.
+ * @param timeout_ms Maximum time to wait for an interrupted connect to complete, or 0 to wait indefinitely.
+ *
+ * @return Returns true on success, or false with errno set on failure.
+ */
+static bool client_connect (int fd, const struct sockaddr_un *addr, uint32_t timeout_ms) {
+    struct sockaddr_un peer;
+    struct pollfd pfd;
+    socklen_t len;
+    int err;
+    int rv;
+
+    while (connect(fd, (const struct sockaddr *) addr, sizeof(*addr)) != 0) {
+        if (errno != EINTR)
+            return false;
+
+        pfd.fd = fd;
+        pfd.events = POLLOUT;
+        do {
+            rv = poll(&pfd, 1, timeout_ms > 0 ? (int) timeout_ms : -1);
+        } while (rv < 0 && errno == EINTR);
+
+        if (rv == 0) {
+            errno = ETIMEDOUT;
+            return false;
+        } else if (rv < 0) {
+            return false;
+        }
+
+        len = sizeof(err);
+        if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) != 0)
+            return false;
+
+        if (err != 0) {
+            errno = err;
+            return false;
+        }
+
+        /* Completed in the background */
+        len = sizeof(peer);
+        if (getpeername(fd, (struct sockaddr *) &peer, &len) == 0)
+            return true;
+
+        if (errno != ENOTCONN)
+            return false;
+    }
+
+    return true;
+}
+
+/**
+ * @internal
+ * Encode @a value into @a buf in little-endian byte order.
+ */
+static void client_put_le (uint8_t *buf, uint32_t value, size_t size) {
+    for (size_t i = 0; i < size; i++)
+        buf[i] = (uint8_t) (value >> (8 * i));
+}
+
+/**
+ * Submit an encoded crash report to the collector listening on @a socket_path, and wait for its reply.
+ *
+ * This function is async-safe.
+ *
+ * @param socket_path Path of the collector's Unix domain socket.
+ * @param report The encoded report, optionally gzip compressed.
+ * @param length Length of @a report, at most PLCRASH_COLLECTOR_REPORT_MAX.
+ * @param timeout_ms Maximum time to wait for an interrupted connect, for each send, and for the reply, in
+ * milliseconds, or 0 to wait indefinitely.
+ * @param status On success, the collector's reply.
+ *
+ * @return Returns PLCRASH_ESUCCESS if the report was delivered and a reply received, PLCRASH_EINVAL if the
+ * arguments are invalid, or PLCRASH_OUTPUT_ERR if the collector could not be reached. A delivered report that the
+ * collector did not queue is reported through @a status, not as an error.
+ */
+plcrash_error_t plcrash_collector_submit (const char *socket_path, const void *report, size_t length, uint32_t timeout_ms, plcrash_collector_status_t *status) {
+    struct sockaddr_un addr;
+    uint8_t header[PLCRASH_COLLECTOR_HEADER_SIZE];
+    uint8_t reply;
+    size_t path_length;
+    ssize_t count;
+    int fd;
+
+    if (length == 0 || length > PLCRASH_COLLECTOR_REPORT_MAX)
+        return PLCRASH_EINVAL;
+
+    /* strlen() is not async-safe */
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    for (path_length = 0; socket_path[path_length] != '\0'; path_length++) {
+        if (path_length + 1 >= sizeof(addr.sun_path))
+            return PLCRASH_EINVAL;
+        addr.sun_path[path_length] = socket_path[path_length];
+    }
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        PLCF_DEBUG("Could not create collector socket: %s", strerror(errno));
+        return PLCRASH_OUTPUT_ERR;
+    }
+
+#ifdef SO_NOSIGPIPE
+    {
+        int on = 1;
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+    }
+#endif
+
+    if (timeout_ms > 0) {
+        struct timeval timeout;
+        timeout.tv_sec = timeout_ms / 1000;
+        timeout.tv_usec = (timeout_ms % 1000) * 1000;
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    }
+
+    if (!client_connect(fd, &addr, timeout_ms)) {
+        PLCF_DEBUG("Could not connect to the crash collector: %s", strerror(errno));
+        close(fd);
+        return PLCRASH_OUTPUT_ERR;
+    }
+
+    client_put_le(header, PLCRASH_COLLECTOR_MAGIC, 4);
+    client_put_le(header + 4, PLCRASH_COLLECTOR_VERSION, 2);
+    client_put_le(header + 6, 0, 2);
+    client_put_le(header + 8, (uint32_t) length, 4);
+
+    if (!client_send_all(fd, header, sizeof(header)) || !client_send_all(fd, report, length)) {
+        PLCF_DEBUG("Could not send the report to the crash collector: %s", strerror(errno));
+        close(fd);
+        return PLCRASH_OUTPUT_ERR;
+    }
+
+    /* Signal the end of the report, then wait for the reply */
+    shutdown(fd, SHUT_WR);
+    do {
+        count = recv(fd, &reply, 1, 0);
+    } while (count < 0 && errno == EINTR);
+    close(fd);
+
+    if (count != 1 || reply > PLCRASH_COLLECTOR_INVALID) {
+        PLCF_DEBUG("No reply from the crash collector");
+        return PLCRASH_OUTPUT_ERR;
+    }
+
+    *status = (plcrash_collector_status_t) reply;
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * @} plcrash_collector_client
+ */
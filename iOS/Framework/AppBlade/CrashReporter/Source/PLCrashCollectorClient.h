@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2008-2011 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef PLCRASH_COLLECTOR_CLIENT_H
+#define PLCRASH_COLLECTOR_CLIENT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#import "PLCrashAsync.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @internal
+ * @defgroup plcrash_collector_client Crash Collector Client
+ *
+ * Hands a finished crash report to a host-wide crash collector (see plcrash_collector) over a Unix domain socket,
+ * so that the collector, rather than the crashed process, deduplicates, compresses and uploads it.
+ *
+ * Each connection carries a single report. The client sends a fixed size frame header followed by the encoded
+ * report, which may be gzip compressed, and the collector replies with a single status byte before closing the
+ * connection. All header fields are little-endian.
+ *
+ *   header:  "PLCC"  uint16 version  uint16 flags (0)  uint32 report length
+ *   reply:   uint8 plcrash_collector_status_t
+ *
+ * plcrash_collector_submit() is async-safe, and may be called from a signal handler or a capture helper.
+ *
+ * @{
+ */
+
+/** Frame header magic ('PLCC') */
+#define PLCRASH_COLLECTOR_MAGIC 0x43434c50
+
+/** Protocol version */
+#define PLCRASH_COLLECTOR_VERSION 1
+
+/** Size of the frame header */
+#define PLCRASH_COLLECTOR_HEADER_SIZE 12
+
+/** Maximum length of a submitted report */
+#define PLCRASH_COLLECTOR_REPORT_MAX (4 * 1024 * 1024)
+
+/**
+ * Collector replies.
+ */
+typedef enum {
+    /** The report was queued for upload */
+    PLCRASH_COLLECTOR_ACCEPTED = 0,
+
+    /** The report duplicates one already queued or recently uploaded, and was counted rather than queued */
+    PLCRASH_COLLECTOR_DUPLICATE = 1,
+
+    /** The collector's queue is full; the client should keep the report and submit it later */
+    PLCRASH_COLLECTOR_BUSY = 2,
+
+    /** The report could not be decoded, or the frame was malformed */
+    PLCRASH_COLLECTOR_INVALID = 3
+} plcrash_collector_status_t;
+
+plcrash_error_t plcrash_collector_submit (const char *socket_path, const void *report, size_t length, uint32_t timeout_ms, plcrash_collector_status_t *status);
+
+/**
+ * @} plcrash_collector_client
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PLCRASH_COLLECTOR_CLIENT_H */
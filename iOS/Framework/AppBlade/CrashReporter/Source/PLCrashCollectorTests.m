@@ -0,0 +1,288 @@
+/*
+ * Copyright (c) 2008-2011 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#import "GTMSenTestCase.h"
+
+#import "PLCrashCollector.h"
+#import "PLCrashCompression.h"
+#import "PLCrashBucket.h"
+#import "PLCrashLogWriter.h"
+#import "PLCrashFrameWalker.h"
+
+#if !TARGET_OS_IPHONE
+#import "GTMHTTPServer.h"
+#endif
+
+@interface PLCrashCollectorTests : SenTestCase {
+@private
+    /* Path to crash log */
+    NSString *_logPath;
+
+    /* Path of the collector socket */
+    NSString *_socketPath;
+
+    /* Test thread */
+    plframe_test_thead_t _thr_args;
+
+    /* Bodies of the requests received by the local HTTP server */
+    NSMutableArray *_requests;
+
+    /* Status codes to be returned by the local HTTP server, in order; 201 once exhausted */
+    NSMutableArray *_responseCodes;
+}
+
+@end
+
+@implementation PLCrashCollectorTests
+
+- (void) setUp {
+    NSString *name = [[NSProcessInfo processInfo] globallyUniqueString];
+    _logPath = [[NSTemporaryDirectory() stringByAppendingPathComponent: name] retain];
+    _socketPath = [[NSTemporaryDirectory() stringByAppendingPathComponent: [name stringByAppendingString: @".sock"]] retain];
+    _requests = [[NSMutableArray alloc] init];
+    _responseCodes = [[NSMutableArray alloc] init];
+    plframe_test_thread_spawn(&_thr_args);
+}
+
+- (void) tearDown {
+    [[NSFileManager defaultManager] removeItemAtPath: _logPath error: NULL];
+    [[NSFileManager defaultManager] removeItemAtPath: _socketPath error: NULL];
+    [_logPath release];
+    [_socketPath release];
+    [_requests release];
+    [_responseCodes release];
+
+    plframe_test_thread_stop(&_thr_args);
+}
+
+/* Write a crash report for the test thread, returning its encoded data */
+- (NSData *) writeReport {
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_log_writer_write_test_report(pthread_mach_thread_np(_thr_args.thread), [_logPath fileSystemRepresentation], false),
+                   @"Could not write the crash report");
+    return [NSData dataWithContentsOfFile: _logPath];
+}
+
+/* Return the bucket fingerprint of the given report */
+- (uint64_t) fingerprintForReportData: (NSData *) data {
+    plcrash_report_t report;
+    uint64_t fingerprint;
+
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_report_decode(&report, [data bytes], [data length], NULL), @"Decode failed");
+    fingerprint = plcrash_bucket_fingerprint(&report, PLCRASH_BUCKET_DEFAULT_FRAMES);
+    plcrash_report_free(&report);
+
+    return fingerprint;
+}
+
+/* Initialize a collector listening on the test socket, uploading to the given URL */
+- (plcrash_error_t) initCollector: (plcrash_collector_t *) collector url: (NSString *) url config: (plcrash_collector_config_t *) config {
+    config->socket_path = [_socketPath fileSystemRepresentation];
+    config->upload_url = [url UTF8String];
+    return plcrash_collector_init(collector, config);
+}
+
+/* Submit a report from a background thread, servicing the collector until the reply is received */
+- (plcrash_collector_status_t) submit: (NSData *) data toCollector: (plcrash_collector_t *) collector {
+    __block volatile BOOL finished = NO;
+    __block plcrash_error_t err = PLCRASH_EUNKNOWN;
+    __block plcrash_collector_status_t status = PLCRASH_COLLECTOR_INVALID;
+    const char *path = [_socketPath fileSystemRepresentation];
+
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        err = plcrash_collector_submit(path, [data bytes], [data length], 10000, &status);
+        finished = YES;
+    });
+
+    NSDate *deadline = [NSDate dateWithTimeIntervalSinceNow: 10.0];
+    while (!finished && [deadline timeIntervalSinceNow] > 0)
+        plcrash_collector_run(collector, 10);
+
+    STAssertTrue(finished, @"Submission timed out");
+    STAssertEquals(PLCRASH_ESUCCESS, err, @"Submission failed");
+    return status;
+}
+
+#if !TARGET_OS_IPHONE
+
+/* Local HTTP stand-in for the collector's upload endpoint; records each request */
+- (GTMHTTPResponseMessage *) httpServer: (GTMHTTPServer *) server handleRequest: (GTMHTTPRequestMessage *) request {
+    int code = 201;
+
+    @synchronized (self) {
+        STAssertEqualObjects(@"application/x-plcrash-batch", [[request allHeaderFieldValues] objectForKey: @"Content-Type"], @"Incorrect content type");
+        [_requests addObject: [request body]];
+        if ([_responseCodes count] > 0) {
+            code = [[_responseCodes objectAtIndex: 0] intValue];
+            [_responseCodes removeObjectAtIndex: 0];
+        }
+    }
+
+    return [GTMHTTPResponseMessage emptyResponseWithCode: code];
+}
+
+/* Service the local HTTP server until the collector has completed the given number of uploads */
+- (BOOL) waitForUploads: (uint64_t) count collector: (plcrash_collector_t *) collector {
+    plcrash_collector_stats_t stats;
+
+    NSDate *deadline = [NSDate dateWithTimeIntervalSinceNow: 10.0];
+    while ([deadline timeIntervalSinceNow] > 0) {
+        plcrash_collector_get_stats(collector, &stats);
+        if (stats.uploaded_batches >= count)
+            return YES;
+        [[NSRunLoop currentRunLoop] runMode: NSDefaultRunLoopMode beforeDate: [NSDate dateWithTimeIntervalSinceNow: 0.1]];
+    }
+    return NO;
+}
+
+/* Decode a little-endian value from a batch */
+static uint64_t batch_get (NSData *batch, size_t offset, size_t size) {
+    const uint8_t *bytes = [batch bytes];
+    uint64_t value = 0;
+    for (size_t i = 0; i < size; i++)
+        value |= (uint64_t) bytes[offset + i] << (8 * i);
+    return value;
+}
+
+- (void) testDeduplicateAndUpload {
+    plcrash_collector_config_t config;
+    plcrash_collector_t collector;
+    plcrash_collector_stats_t stats;
+    NSData *report = [self writeReport];
+    NSError *error = nil;
+
+    GTMHTTPServer *server = [[[GTMHTTPServer alloc] initWithDelegate: self] autorelease];
+    STAssertTrue([server start: &error], @"Could not start local HTTP server: %@", error);
+
+    plcrash_collector_config_init(&config);
+    NSString *url = [NSString stringWithFormat: @"http://127.0.0.1:%hu/api/3/crash_batches", [server port]];
+    STAssertEquals(PLCRASH_ESUCCESS, [self initCollector: &collector url: url config: &config], @"Could not start the collector");
+
+    /* The second report is folded into the first; data that is not a report is refused */
+    STAssertEquals(PLCRASH_COLLECTOR_ACCEPTED, [self submit: report toCollector: &collector], @"Report not accepted");
+    STAssertEquals(PLCRASH_COLLECTOR_DUPLICATE, [self submit: report toCollector: &collector], @"Duplicate not detected");
+    STAssertEquals(PLCRASH_COLLECTOR_INVALID, [self submit: [@"not a crash report" dataUsingEncoding: NSUTF8StringEncoding] toCollector: &collector], @"Invalid report accepted");
+
+    plcrash_collector_flush(&collector);
+    STAssertTrue([self waitForUploads: 1 collector: &collector], @"Batch not uploaded");
+    [server stop];
+    STAssertEquals((NSUInteger) 1, [_requests count], @"Incorrect request count");
+
+    /* A single entry, counting both reports, holding the compressed report */
+    NSData *batch = [_requests objectAtIndex: 0];
+    STAssertTrue([batch length] >= 28, @"Batch too short");
+    STAssertEquals((uint64_t) PLCRASH_COLLECTOR_BATCH_MAGIC, batch_get(batch, 0, 4), @"Incorrect batch magic");
+    STAssertEquals((uint64_t) PLCRASH_COLLECTOR_BATCH_VERSION, batch_get(batch, 4, 4), @"Incorrect batch version");
+    STAssertEquals((uint64_t) 1, batch_get(batch, 8, 4), @"Incorrect entry count");
+    STAssertEquals([self fingerprintForReportData: report], batch_get(batch, 12, 8), @"Incorrect fingerprint");
+    STAssertEquals((uint64_t) 2, batch_get(batch, 20, 4), @"Incorrect occurrence count");
+
+    uint64_t length = batch_get(batch, 24, 4);
+    STAssertEquals((uint64_t) [batch length], 28 + length, @"Incorrect entry length");
+    NSData *uploaded = [batch subdataWithRange: NSMakeRange(28, (NSUInteger) length)];
+    STAssertTrue(plcrash_gzip_detect([uploaded bytes], [uploaded length]), @"Uploaded report is not compressed");
+    STAssertEquals([self fingerprintForReportData: report], [self fingerprintForReportData: uploaded], @"Uploaded report does not match");
+
+    plcrash_collector_stop(&collector);
+    plcrash_collector_get_stats(&collector, &stats);
+    STAssertEquals((uint64_t) 1, stats.accepted, @"Incorrect accepted count");
+    STAssertEquals((uint64_t) 1, stats.duplicates, @"Incorrect duplicate count");
+    STAssertEquals((uint64_t) 1, stats.invalid, @"Incorrect invalid count");
+    STAssertEquals((uint64_t) 1, stats.uploaded_entries, @"Incorrect uploaded count");
+    plcrash_collector_free(&collector);
+
+    STAssertFalse([[NSFileManager defaultManager] fileExistsAtPath: _socketPath], @"Socket not removed");
+}
+
+- (void) testRetryAfterFailure {
+    plcrash_collector_config_t config;
+    plcrash_collector_t collector;
+    plcrash_collector_stats_t stats;
+    NSError *error = nil;
+
+    GTMHTTPServer *server = [[[GTMHTTPServer alloc] initWithDelegate: self] autorelease];
+    STAssertTrue([server start: &error], @"Could not start local HTTP server: %@", error);
+    [_responseCodes addObject: [NSNumber numberWithInt: 503]];
+
+    plcrash_collector_config_init(&config);
+    config.flush_interval_ms = 0;
+    config.backoff_initial_ms = 100;
+    NSString *url = [NSString stringWithFormat: @"http://127.0.0.1:%hu/", [server port]];
+    STAssertEquals(PLCRASH_ESUCCESS, [self initCollector: &collector url: url config: &config], @"Could not start the collector");
+
+    STAssertEquals(PLCRASH_COLLECTOR_ACCEPTED, [self submit: [self writeReport] toCollector: &collector], @"Report not accepted");
+
+    /* The refused batch is retried once the backoff has passed */
+    STAssertTrue([self waitForUploads: 1 collector: &collector], @"Batch not retried");
+    [server stop];
+    STAssertEquals((NSUInteger) 2, [_requests count], @"Incorrect request count");
+    STAssertEqualObjects([_requests objectAtIndex: 0], [_requests objectAtIndex: 1], @"Retried batch differs");
+
+    plcrash_collector_stop(&collector);
+    plcrash_collector_get_stats(&collector, &stats);
+    STAssertEquals((uint64_t) 1, stats.upload_failures, @"Incorrect failure count");
+    STAssertEquals((uint64_t) 1, stats.uploaded_entries, @"Incorrect uploaded count");
+    STAssertEquals((uint64_t) 0, stats.queued_entries, @"Entries left queued");
+    plcrash_collector_free(&collector);
+}
+
+#endif /* !TARGET_OS_IPHONE */
+
+- (void) testQueueLimit {
+    plcrash_collector_config_t config;
+    plcrash_collector_t collector;
+    plcrash_collector_stats_t stats;
+
+    /* Nothing listens on the discard port, so nothing is uploaded */
+    plcrash_collector_config_init(&config);
+    config.queue_max_bytes = 16;
+    STAssertEquals(PLCRASH_ESUCCESS, [self initCollector: &collector url: @"http://127.0.0.1:9/" config: &config], @"Could not start the collector");
+
+    STAssertEquals(PLCRASH_COLLECTOR_BUSY, [self submit: [self writeReport] toCollector: &collector], @"Queue limit not enforced");
+
+    plcrash_collector_get_stats(&collector, &stats);
+    STAssertEquals((uint64_t) 1, stats.busy, @"Incorrect busy count");
+    STAssertEquals((uint64_t) 0, stats.queued_entries, @"Refused report queued");
+    plcrash_collector_free(&collector);
+}
+
+- (void) testUploadURL {
+    plcrash_collector_config_t config;
+    plcrash_collector_t collector;
+
+    plcrash_collector_config_init(&config);
+    STAssertEquals(PLCRASH_ENOTSUP, [self initCollector: &collector url: @"https://localhost/" config: &config], @"https endpoint accepted");
+    STAssertEquals(PLCRASH_EINVAL, [self initCollector: &collector url: @"localhost" config: &config], @"Malformed endpoint accepted");
+    STAssertEquals(PLCRASH_EINVAL, [self initCollector: &collector url: @"http://localhost:port/" config: &config], @"Malformed port accepted");
+
+    STAssertEquals(PLCRASH_ESUCCESS, [self initCollector: &collector url: @"http://[::1]:8080/batches" config: &config], @"IPv6 endpoint rejected");
+    STAssertEqualCStrings("::1", collector.endpoint.host, @"Incorrect host");
+    STAssertEqualCStrings("8080", collector.endpoint.port, @"Incorrect port");
+    STAssertEqualCStrings("/batches", collector.endpoint.path, @"Incorrect path");
+    plcrash_collector_free(&collector);
+}
+
+@end
@@ -0,0 +1,1549 @@
+/*
+ * Copyright (c) 2008-2011 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PLCrashColumnar.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/**
+ * @ingroup plcrash_columnar
+ * @{
+ */
+
+/* Column magic */
+static const uint8_t column_magic[8] = { 'p', 'l', 'c', 'o', 'l', 'm', 'n', '\0' };
+
+/* Header field offsets */
+#define COLUMN_HDR_MAGIC 0
+#define COLUMN_HDR_VERSION 8
+#define COLUMN_HDR_TYPE 12
+#define COLUMN_HDR_ENCODING 16
+#define COLUMN_HDR_BLOCK_ROWS 20
+#define COLUMN_HDR_SIZE 24
+
+/* Block header field offsets */
+#define COLUMN_BLOCK_ROWS 0
+#define COLUMN_BLOCK_LENGTH 4
+#define COLUMN_BLOCK_FIRST 8
+#define COLUMN_BLOCK_HDR_SIZE 16
+
+/* Footer field offsets, relative to the start of the footer */
+#define COLUMN_FTR_ROW_COUNT 0
+#define COLUMN_FTR_BLOCK_COUNT 8
+#define COLUMN_FTR_INDEX_OFFSET 16
+#define COLUMN_FTR_DICT_OFFSET 24
+#define COLUMN_FTR_MAGIC 32
+#define COLUMN_FTR_SIZE 40
+
+/* Dictionary header size: entry count (8) and string table size (8) */
+#define COLUMN_DICT_HDR_SIZE 16
+
+/* Size of the file output buffer used by each column writer */
+#define COLUMN_OUTPUT_BUFFER 65536
+
+/* Number of reports decoded by a worker at a time */
+#define COLUMNAR_BATCH_SIZE 16
+
+/* Maximum number of decoding threads */
+#define COLUMNAR_THREAD_MAX 64
+
+/* Files larger than this are not crash reports, and are not read */
+#define COLUMNAR_FILE_MAX (64 * 1024 * 1024)
+
+/* Thread number recorded for the frames of an exception backtrace */
+#define COLUMNAR_EXCEPTION_THREAD UINT32_MAX
+
+/* Image index recorded for frames outside any image */
+#define COLUMNAR_NO_IMAGE UINT32_MAX
+
+/* Maximum length of an exported image UUID, in bytes */
+#define COLUMNAR_UUID_MAX 32
+
+/**
+ * @internal
+ * Read a little-endian 32-bit value.
+ */
+static uint32_t column_read32 (const uint8_t *p) {
+    return ((uint32_t) p[3] << 24) | ((uint32_t) p[2] << 16) | ((uint32_t) p[1] << 8) | p[0];
+}
+
+/**
+ * @internal
+ * Read a little-endian 64-bit value.
+ */
+static uint64_t column_read64 (const uint8_t *p) {
+    return ((uint64_t) column_read32(p + 4) << 32) | column_read32(p);
+}
+
+/**
+ * @internal
+ * Write a little-endian 32-bit value.
+ */
+static void column_write32 (uint8_t *p, uint32_t value) {
+    p[0] = (uint8_t) value;
+    p[1] = (uint8_t) (value >> 8);
+    p[2] = (uint8_t) (value >> 16);
+    p[3] = (uint8_t) (value >> 24);
+}
+
+/**
+ * @internal
+ * Write a little-endian 64-bit value.
+ */
+static void column_write64 (uint8_t *p, uint64_t value) {
+    column_write32(p, (uint32_t) value);
+    column_write32(p + 4, (uint32_t) (value >> 32));
+}
+
+/**
+ * @internal
+ * Return the width of a single plain-encoded value of @a type, or 0 for strings.
+ */
+static size_t column_value_width (plcrash_column_type_t type) {
+    switch (type) {
+        case PLCRASH_COLUMN_TYPE_UINT8:
+            return 1;
+        case PLCRASH_COLUMN_TYPE_UINT32:
+            return 4;
+        case PLCRASH_COLUMN_TYPE_UINT64:
+        case PLCRASH_COLUMN_TYPE_INT64:
+            return 8;
+        case PLCRASH_COLUMN_TYPE_STRING:
+            return 0;
+    }
+
+    return 0;
+}
+
+/**
+ * @internal
+ * Return true if @a encoding is supported for @a type.
+ */
+static bool column_encoding_valid (plcrash_column_type_t type, plcrash_column_encoding_t encoding) {
+    switch (encoding) {
+        case PLCRASH_COLUMN_ENCODING_PLAIN:
+            return type >= PLCRASH_COLUMN_TYPE_UINT8 && type <= PLCRASH_COLUMN_TYPE_STRING;
+        case PLCRASH_COLUMN_ENCODING_DELTA:
+            return type == PLCRASH_COLUMN_TYPE_UINT64 || type == PLCRASH_COLUMN_TYPE_INT64;
+        case PLCRASH_COLUMN_ENCODING_DICT:
+            return type == PLCRASH_COLUMN_TYPE_STRING;
+    }
+
+    return false;
+}
+
+/**
+ * @internal
+ * Return the number of padding bytes required to align @a offset to 8 bytes.
+ */
+static size_t column_padding (uint64_t offset) {
+    return (size_t) ((8 - (offset & 7)) & 7);
+}
+
+
+/* === Reading === */
+
+/**
+ * Initialize a view of the column file @a data. The header, footer, block index, and dictionary bounds are
+ * validated; blocks are validated as they are read.
+ *
+ * @param column The view to initialize.
+ * @param data Column data. The data must remain valid for the lifetime of the view.
+ * @param size Size of @a data.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, PLCRASH_ENOTSUP if @a data is not a column file (or is an
+ * unsupported version), or PLCRASH_EINVAL if the column is corrupt.
+ */
+plcrash_error_t plcrash_column_init (plcrash_column_t *column, const void *data, size_t size) {
+    const uint8_t *bytes = data;
+    const uint8_t *footer;
+    uint64_t block_count;
+    uint64_t index_offset;
+    uint64_t dict_offset;
+
+    memset(column, 0, sizeof(*column));
+
+    if (size < COLUMN_HDR_SIZE || memcmp(bytes, column_magic, sizeof(column_magic)) != 0)
+        return PLCRASH_ENOTSUP;
+
+    if (column_read32(bytes + COLUMN_HDR_VERSION) != PLCRASH_COLUMN_VERSION)
+        return PLCRASH_ENOTSUP;
+
+    if (size < COLUMN_HDR_SIZE + COLUMN_FTR_SIZE)
+        return PLCRASH_EINVAL;
+
+    column->type = column_read32(bytes + COLUMN_HDR_TYPE);
+    column->encoding = column_read32(bytes + COLUMN_HDR_ENCODING);
+    if (!column_encoding_valid(column->type, column->encoding))
+        return PLCRASH_EINVAL;
+
+    footer = bytes + size - COLUMN_FTR_SIZE;
+    if (memcmp(footer + COLUMN_FTR_MAGIC, column_magic, sizeof(column_magic)) != 0)
+        return PLCRASH_EINVAL;
+
+    column->row_count = column_read64(footer + COLUMN_FTR_ROW_COUNT);
+    block_count = column_read64(footer + COLUMN_FTR_BLOCK_COUNT);
+    index_offset = column_read64(footer + COLUMN_FTR_INDEX_OFFSET);
+    dict_offset = column_read64(footer + COLUMN_FTR_DICT_OFFSET);
+
+    /* The block index immediately precedes the footer */
+    if (index_offset > size - COLUMN_FTR_SIZE || block_count != (size - COLUMN_FTR_SIZE - index_offset) / 8)
+        return PLCRASH_EINVAL;
+
+    column->block_count = (size_t) block_count;
+    column->index = bytes + index_offset;
+
+    if (column->encoding == PLCRASH_COLUMN_ENCODING_DICT) {
+        uint64_t dict_count;
+        uint64_t strings_size;
+        uint64_t offsets_size;
+
+        if (dict_offset < COLUMN_HDR_SIZE || dict_offset > index_offset || index_offset - dict_offset < COLUMN_DICT_HDR_SIZE)
+            return PLCRASH_EINVAL;
+
+        dict_count = column_read64(bytes + dict_offset);
+        strings_size = column_read64(bytes + dict_offset + 8);
+        if (dict_count > (index_offset - dict_offset - COLUMN_DICT_HDR_SIZE) / 4)
+            return PLCRASH_EINVAL;
+
+        offsets_size = dict_count * 4 + column_padding(dict_count * 4);
+        if (strings_size > index_offset - dict_offset - COLUMN_DICT_HDR_SIZE - offsets_size)
+            return PLCRASH_EINVAL;
+
+        /* The string table must be NUL-terminated, so that any in-bounds offset yields a terminated string */
+        if (dict_count > 0 && (strings_size == 0 || bytes[dict_offset + COLUMN_DICT_HDR_SIZE + offsets_size + strings_size - 1] != '\0'))
+            return PLCRASH_EINVAL;
+
+        column->dict_count = (size_t) dict_count;
+        column->dict_offsets = bytes + dict_offset + COLUMN_DICT_HDR_SIZE;
+        column->dict_strings = (const char *) column->dict_offsets + offsets_size;
+        column->dict_strings_size = (size_t) strings_size;
+    }
+
+    column->data = bytes;
+    column->size = size;
+
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * @internal
+ * Locate block @a block of @a column.
+ */
+static plcrash_error_t column_block (const plcrash_column_t *column, size_t block, const uint8_t **header, const uint8_t **payload,
+                                     size_t *rows, size_t *length)
+{
+    uint64_t offset;
+    const uint8_t *end = column->index;
+
+    if (block >= column->block_count)
+        return PLCRASH_EINVAL;
+
+    offset = column_read64(column->index + block * 8);
+    if (offset < COLUMN_HDR_SIZE || offset > (uint64_t) (end - column->data) || (uint64_t) (end - column->data) - offset < COLUMN_BLOCK_HDR_SIZE)
+        return PLCRASH_EINVAL;
+
+    *header = column->data + offset;
+    *payload = *header + COLUMN_BLOCK_HDR_SIZE;
+    *rows = column_read32(*header + COLUMN_BLOCK_ROWS);
+    *length = column_read32(*header + COLUMN_BLOCK_LENGTH);
+
+    if (*rows == 0 || *rows > PLCRASH_COLUMN_BLOCK_ROWS || *length > (size_t) (end - *payload))
+        return PLCRASH_EINVAL;
+
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * Decode the values of block @a block of @a column. For dictionary-encoded columns, the values are dictionary
+ * indices. String columns with plain encoding must be read with plcrash_column_read_strings().
+ *
+ * @param column The column.
+ * @param block The block index.
+ * @param values On return, the block's values. Must have room for PLCRASH_COLUMN_BLOCK_ROWS values.
+ * @param count On return, the number of rows in the block.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, PLCRASH_ENOTSUP if the column holds plain strings, or
+ * PLCRASH_EINVAL if the block is out of range or corrupt.
+ */
+plcrash_error_t plcrash_column_read_block (const plcrash_column_t *column, size_t block, uint64_t *values, size_t *count) {
+    const uint8_t *header;
+    const uint8_t *payload;
+    size_t rows, length;
+    plcrash_error_t err;
+
+    if (column->type == PLCRASH_COLUMN_TYPE_STRING && column->encoding == PLCRASH_COLUMN_ENCODING_PLAIN)
+        return PLCRASH_ENOTSUP;
+
+    if ((err = column_block(column, block, &header, &payload, &rows, &length)) != PLCRASH_ESUCCESS)
+        return err;
+
+    switch (column->encoding) {
+        case PLCRASH_COLUMN_ENCODING_PLAIN:
+        case PLCRASH_COLUMN_ENCODING_DICT: {
+            size_t width = (column->encoding == PLCRASH_COLUMN_ENCODING_DICT) ? 4 : column_value_width(column->type);
+
+            if (length < rows * width)
+                return PLCRASH_EINVAL;
+
+            for (size_t i = 0; i < rows; i++) {
+                const uint8_t *p = payload + i * width;
+
+                switch (width) {
+                    case 1:
+                        values[i] = *p;
+                        break;
+                    case 4:
+                        values[i] = column_read32(p);
+                        break;
+                    default:
+                        values[i] = column_read64(p);
+                        break;
+                }
+            }
+            break;
+        }
+
+        case PLCRASH_COLUMN_ENCODING_DELTA: {
+            size_t pos = 0;
+
+            values[0] = column_read64(header + COLUMN_BLOCK_FIRST);
+            for (size_t i = 1; i < rows; i++) {
+                uint64_t zigzag = 0;
+                unsigned int shift = 0;
+                uint8_t byte;
+
+                do {
+                    if (pos == length || shift > 63)
+                        return PLCRASH_EINVAL;
+
+                    byte = payload[pos++];
+                    zigzag |= (uint64_t) (byte & 0x7f) << shift;
+                    shift += 7;
+                } while (byte & 0x80);
+
+                /* Deltas wrap modulo 2^64 */
+                values[i] = values[i - 1] + ((zigzag >> 1) ^ (~(zigzag & 1) + 1));
+            }
+            break;
+        }
+    }
+
+    *count = rows;
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * Read the strings of block @a block of a plain-encoded string column. The strings refer directly to the
+ * column data.
+ *
+ * @param column The column.
+ * @param block The block index.
+ * @param strings On return, the block's strings. Must have room for PLCRASH_COLUMN_BLOCK_ROWS strings.
+ * @param count On return, the number of rows in the block.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, PLCRASH_ENOTSUP if the column does not hold plain strings, or
+ * PLCRASH_EINVAL if the block is out of range or corrupt.
+ */
+plcrash_error_t plcrash_column_read_strings (const plcrash_column_t *column, size_t block, const char **strings, size_t *count) {
+    const uint8_t *header;
+    const uint8_t *payload;
+    size_t rows, length;
+    plcrash_error_t err;
+
+    if (column->type != PLCRASH_COLUMN_TYPE_STRING || column->encoding != PLCRASH_COLUMN_ENCODING_PLAIN)
+        return PLCRASH_ENOTSUP;
+
+    if ((err = column_block(column, block, &header, &payload, &rows, &length)) != PLCRASH_ESUCCESS)
+        return err;
+
+    /* The string data follows the offset table, and must end with a NUL */
+    size_t table = rows * 4;
+    if (length <= table || payload[length - 1] != '\0')
+        return PLCRASH_EINVAL;
+
+    for (size_t i = 0; i < rows; i++) {
+        uint32_t offset = column_read32(payload + i * 4);
+        if (offset >= length - table)
+            return PLCRASH_EINVAL;
+
+        strings[i] = (const char *) payload + table + offset;
+    }
+
+    *count = rows;
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * Return the dictionary string at @a index, or NULL if @a index is PLCRASH_COLUMN_NULL or out of range.
+ *
+ * @param column A dictionary-encoded column.
+ * @param index A dictionary index, as returned by plcrash_column_read_block().
+ */
+const char *plcrash_column_dict_string (const plcrash_column_t *column, uint32_t index) {
+    uint32_t offset;
+
+    if (index >= column->dict_count)
+        return NULL;
+
+    offset = column_read32(column->dict_offsets + (size_t) index * 4);
+    if (offset >= column->dict_strings_size)
+        return NULL;
+
+    return column->dict_strings + offset;
+}
+
+
+/* === Writing === */
+
+/**
+ * @internal
+ * A growable byte buffer.
+ */
+typedef struct column_bytes {
+    uint8_t *data;
+    size_t length;
+    size_t capacity;
+} column_bytes_t;
+
+/**
+ * @internal
+ * Reserve room for @a length additional bytes.
+ */
+static plcrash_error_t column_bytes_reserve (column_bytes_t *bytes, size_t length) {
+    if (length <= bytes->capacity - bytes->length)
+        return PLCRASH_ESUCCESS;
+
+    size_t capacity = bytes->capacity > 0 ? bytes->capacity : 4096;
+    while (capacity - bytes->length < length) {
+        if (capacity > SIZE_MAX / 2)
+            return PLCRASH_ENOMEM;
+        capacity *= 2;
+    }
+
+    uint8_t *data = realloc(bytes->data, capacity);
+    if (data == NULL)
+        return PLCRASH_ENOMEM;
+
+    bytes->data = data;
+    bytes->capacity = capacity;
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * @internal
+ * A string dictionary, mapping strings to their index in order of first appearance.
+ */
+typedef struct column_dict {
+    /** NUL-terminated strings */
+    column_bytes_t strings;
+
+    /** Offset of each entry within @a strings */
+    uint32_t *offsets;
+    size_t count;
+    size_t capacity;
+
+    /** Open-addressed hash table mapping strings to entry index + 1 (0 marks an empty slot) */
+    uint32_t *slots;
+    size_t slot_count;
+} column_dict_t;
+
+/**
+ * @internal
+ * FNV-1a hash of a string.
+ */
+static uint64_t column_dict_hash (const char *str, size_t length) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (uint8_t) str[i];
+        hash *= 0x100000001b3ULL;
+    }
+
+    return hash;
+}
+
+/**
+ * @internal
+ * Return the hash table slot of @a str: either the slot referencing its entry, or the empty slot at which it
+ * would be inserted.
+ */
+static uint32_t *column_dict_slot (const column_dict_t *dict, const char *str, size_t length) {
+    size_t mask = dict->slot_count - 1;
+    size_t i = (size_t) column_dict_hash(str, length) & mask;
+
+    while (dict->slots[i] != 0) {
+        const char *entry = (const char *) dict->strings.data + dict->offsets[dict->slots[i] - 1];
+
+        if (strncmp(entry, str, length) == 0 && entry[length] == '\0')
+            break;
+
+        i = (i + 1) & mask;
+    }
+
+    return &dict->slots[i];
+}
+
+/**
+ * @internal
+ * Return the index of @a str, adding it to the dictionary if necessary.
+ */
+static plcrash_error_t column_dict_intern (column_dict_t *dict, const char *str, uint32_t *index) {
+    size_t length = strlen(str);
+    uint32_t *slot;
+
+    if (dict->slot_count == 0 || (dict->count + 1) * 2 > dict->slot_count) {
+        size_t slot_count = dict->slot_count > 0 ? dict->slot_count * 2 : 256;
+        uint32_t *slots = calloc(slot_count, sizeof(*slots));
+
+        if (slots == NULL)
+            return PLCRASH_ENOMEM;
+
+        free(dict->slots);
+        dict->slots = slots;
+        dict->slot_count = slot_count;
+
+        for (size_t i = 0; i < dict->count; i++) {
+            const char *entry = (const char *) dict->strings.data + dict->offsets[i];
+            *column_dict_slot(dict, entry, strlen(entry)) = (uint32_t) i + 1;
+        }
+    }
+
+    slot = column_dict_slot(dict, str, length);
+    if (*slot != 0) {
+        *index = *slot - 1;
+        return PLCRASH_ESUCCESS;
+    }
+
+    /* Offsets and indices are 32-bit */
+    if (dict->count >= PLCRASH_COLUMN_NULL - 1 || dict->strings.length + length + 1 > UINT32_MAX)
+        return PLCRASH_ENOMEM;
+
+    if (dict->count == dict->capacity) {
+        size_t capacity = dict->capacity > 0 ? dict->capacity * 2 : 256;
+        uint32_t *offsets = realloc(dict->offsets, capacity * sizeof(*offsets));
+
+        if (offsets == NULL)
+            return PLCRASH_ENOMEM;
+
+        dict->offsets = offsets;
+        dict->capacity = capacity;
+    }
+
+    if (column_bytes_reserve(&dict->strings, length + 1) != PLCRASH_ESUCCESS)
+        return PLCRASH_ENOMEM;
+
+    dict->offsets[dict->count] = (uint32_t) dict->strings.length;
+    memcpy(dict->strings.data + dict->strings.length, str, length + 1);
+    dict->strings.length += length + 1;
+
+    *slot = (uint32_t) dict->count + 1;
+    *index = (uint32_t) dict->count;
+    dict->count++;
+
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * @internal
+ * Free a dictionary.
+ */
+static void column_dict_free (column_dict_t *dict) {
+    free(dict->strings.data);
+    free(dict->offsets);
+    free(dict->slots);
+}
+
+/**
+ * @internal
+ * Writes a single column file, one block at a time.
+ */
+typedef struct column_writer {
+    /** Value type and encoding */
+    plcrash_column_type_t type;
+    plcrash_column_encoding_t encoding;
+
+    /** Output file, and whether it was created by the writer */
+    int fd;
+    bool created;
+    plcrash_report_output_t output;
+    char *output_buffer;
+
+    /** Number of bytes written */
+    uint64_t offset;
+
+    /** Total number of rows */
+    uint64_t row_count;
+
+    /** Values (or string offsets) of the current block */
+    uint64_t *values;
+    size_t value_count;
+
+    /** String data of the current block (plain string columns) */
+    column_bytes_t strings;
+
+    /** Encoded payload of the current block */
+    column_bytes_t payload;
+
+    /** File offset of each block written */
+    uint64_t *index;
+    size_t index_count;
+    size_t index_capacity;
+
+    /** Dictionary (dictionary-encoded columns) */
+    column_dict_t dict;
+} column_writer_t;
+
+/**
+ * @internal
+ * Write @a length bytes to the column file.
+ */
+static void column_writer_write (column_writer_t *writer, const void *data, size_t length) {
+    plcrash_report_output_write(&writer->output, data, length);
+    writer->offset += length;
+}
+
+/**
+ * @internal
+ * Pad the column file to an 8-byte boundary.
+ */
+static void column_writer_align (column_writer_t *writer) {
+    static const uint8_t zero[8] = { 0 };
+    column_writer_write(writer, zero, column_padding(writer->offset));
+}
+
+/**
+ * @internal
+ * Create the column file at @a path and write its header.
+ */
+static plcrash_error_t column_writer_open (column_writer_t *writer, const char *path, plcrash_column_type_t type, plcrash_column_encoding_t encoding) {
+    uint8_t header[COLUMN_HDR_SIZE];
+
+    memset(writer, 0, sizeof(*writer));
+    writer->type = type;
+    writer->encoding = encoding;
+    writer->fd = -1;
+
+    writer->values = malloc(PLCRASH_COLUMN_BLOCK_ROWS * sizeof(*writer->values));
+    writer->output_buffer = malloc(COLUMN_OUTPUT_BUFFER);
+    if (writer->values == NULL || writer->output_buffer == NULL)
+        return PLCRASH_ENOMEM;
+
+    if ((writer->fd = open(path, O_WRONLY|O_CREAT|O_TRUNC, 0644)) == -1)
+        return PLCRASH_OUTPUT_ERR;
+
+    writer->created = true;
+    plcrash_report_output_init_fd(&writer->output, writer->fd, writer->output_buffer, COLUMN_OUTPUT_BUFFER);
+
+    memset(header, 0, sizeof(header));
+    memcpy(header + COLUMN_HDR_MAGIC, column_magic, sizeof(column_magic));
+    column_write32(header + COLUMN_HDR_VERSION, PLCRASH_COLUMN_VERSION);
+    column_write32(header + COLUMN_HDR_TYPE, type);
+    column_write32(header + COLUMN_HDR_ENCODING, encoding);
+    column_write32(header + COLUMN_HDR_BLOCK_ROWS, PLCRASH_COLUMN_BLOCK_ROWS);
+    column_writer_write(writer, header, sizeof(header));
+
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * @internal
+ * Encode and write the current block.
+ */
+static plcrash_error_t column_writer_flush_block (column_writer_t *writer) {
+    column_bytes_t *payload = &writer->payload;
+    uint8_t header[COLUMN_BLOCK_HDR_SIZE];
+    size_t rows = writer->value_count;
+    uint64_t first = 0;
+
+    if (rows == 0)
+        return PLCRASH_ESUCCESS;
+
+    payload->length = 0;
+
+    switch (writer->encoding) {
+        case PLCRASH_COLUMN_ENCODING_PLAIN:
+        case PLCRASH_COLUMN_ENCODING_DICT: {
+            size_t width = column_value_width(writer->type);
+            if (writer->type == PLCRASH_COLUMN_TYPE_STRING)
+                width = 4;
+
+            if (column_bytes_reserve(payload, rows * width) != PLCRASH_ESUCCESS)
+                return PLCRASH_ENOMEM;
+
+            for (size_t i = 0; i < rows; i++) {
+                uint8_t *p = payload->data + i * width;
+
+                switch (width) {
+                    case 1:
+                        *p = (uint8_t) writer->values[i];
+                        break;
+                    case 4:
+                        column_write32(p, (uint32_t) writer->values[i]);
+                        break;
+                    default:
+                        column_write64(p, writer->values[i]);
+                        break;
+                }
+            }
+            payload->length = rows * width;
+
+            /* Plain strings follow their offsets */
+            if (writer->type == PLCRASH_COLUMN_TYPE_STRING && writer->encoding == PLCRASH_COLUMN_ENCODING_PLAIN) {
+                if (column_bytes_reserve(payload, writer->strings.length) != PLCRASH_ESUCCESS)
+                    return PLCRASH_ENOMEM;
+
+                memcpy(payload->data + payload->length, writer->strings.data, writer->strings.length);
+                payload->length += writer->strings.length;
+                writer->strings.length = 0;
+            } else if (writer->type != PLCRASH_COLUMN_TYPE_STRING) {
+                first = writer->values[0];
+            }
+            break;
+        }
+
+        case PLCRASH_COLUMN_ENCODING_DELTA:
+            /* At most 10 bytes per varint */
+            if (column_bytes_reserve(payload, (rows - 1) * 10) != PLCRASH_ESUCCESS)
+                return PLCRASH_ENOMEM;
+
+            first = writer->values[0];
+            for (size_t i = 1; i < rows; i++) {
+                uint64_t delta = writer->values[i] - writer->values[i - 1];
+                uint64_t zigzag = (delta << 1) ^ (uint64_t) ((int64_t) delta >> 63);
+
+                while (zigzag >= 0x80) {
+                    payload->data[payload->length++] = (uint8_t) (zigzag | 0x80);
+                    zigzag >>= 7;
+                }
+                payload->data[payload->length++] = (uint8_t) zigzag;
+            }
+            break;
+    }
+
+    /* Block payloads are limited to 32-bit lengths */
+    if (payload->length > UINT32_MAX)
+        return PLCRASH_ENOMEM;
+
+    if (writer->index_count == writer->index_capacity) {
+        size_t capacity = writer->index_capacity > 0 ? writer->index_capacity * 2 : 64;
+        uint64_t *index = realloc(writer->index, capacity * sizeof(*index));
+
+        if (index == NULL)
+            return PLCRASH_ENOMEM;
+
+        writer->index = index;
+        writer->index_capacity = capacity;
+    }
+    writer->index[writer->index_count++] = writer->offset;
+
+    column_write32(header + COLUMN_BLOCK_ROWS, (uint32_t) rows);
+    column_write32(header + COLUMN_BLOCK_LENGTH, (uint32_t) payload->length);
+    column_write64(header + COLUMN_BLOCK_FIRST, first);
+
+    column_writer_write(writer, header, sizeof(header));
+    column_writer_write(writer, payload->data, payload->length);
+    column_writer_align(writer);
+
+    writer->value_count = 0;
+    return writer->output.error;
+}
+
+/**
+ * @internal
+ * Append an integer value.
+ */
+static plcrash_error_t column_writer_append (column_writer_t *writer, uint64_t value) {
+    writer->values[writer->value_count++] = value;
+    writer->row_count++;
+
+    if (writer->value_count == PLCRASH_COLUMN_BLOCK_ROWS)
+        return column_writer_flush_block(writer);
+
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * @internal
+ * Append a string value. NULL is stored as PLCRASH_COLUMN_NULL in dictionary-encoded columns, and as the empty
+ * string in plain columns.
+ */
+static plcrash_error_t column_writer_append_string (column_writer_t *writer, const char *str) {
+    if (writer->encoding == PLCRASH_COLUMN_ENCODING_DICT) {
+        uint32_t index = PLCRASH_COLUMN_NULL;
+        plcrash_error_t err;
+
+        if (str != NULL && (err = column_dict_intern(&writer->dict, str, &index)) != PLCRASH_ESUCCESS)
+            return err;
+
+        return column_writer_append(writer, index);
+    }
+
+    if (str == NULL)
+        str = "";
+
+    size_t length = strlen(str) + 1;
+    if (writer->strings.length + length > UINT32_MAX || column_bytes_reserve(&writer->strings, length) != PLCRASH_ESUCCESS)
+        return PLCRASH_ENOMEM;
+
+    memcpy(writer->strings.data + writer->strings.length, str, length);
+    uint64_t offset = writer->strings.length;
+    writer->strings.length += length;
+
+    return column_writer_append(writer, offset);
+}
+
+/**
+ * @internal
+ * Write the final block, dictionary, block index, and footer, and close the column file.
+ */
+static plcrash_error_t column_writer_finish (column_writer_t *writer) {
+    uint8_t footer[COLUMN_FTR_SIZE];
+    uint64_t dict_offset = 0;
+    uint64_t index_offset;
+    plcrash_error_t err;
+
+    if ((err = column_writer_flush_block(writer)) != PLCRASH_ESUCCESS)
+        return err;
+
+    if (writer->encoding == PLCRASH_COLUMN_ENCODING_DICT) {
+        column_dict_t *dict = &writer->dict;
+        uint8_t header[COLUMN_DICT_HDR_SIZE];
+
+        dict_offset = writer->offset;
+        column_write64(header, dict->count);
+        column_write64(header + 8, dict->strings.length);
+        column_writer_write(writer, header, sizeof(header));
+
+        for (size_t i = 0; i < dict->count; i++) {
+            uint8_t offset[4];
+
+            column_write32(offset, dict->offsets[i]);
+            column_writer_write(writer, offset, sizeof(offset));
+        }
+        column_writer_align(writer);
+
+        column_writer_write(writer, dict->strings.data, dict->strings.length);
+        column_writer_align(writer);
+    }
+
+    index_offset = writer->offset;
+    for (size_t i = 0; i < writer->index_count; i++) {
+        uint8_t offset[8];
+
+        column_write64(offset, writer->index[i]);
+        column_writer_write(writer, offset, sizeof(offset));
+    }
+
+    column_write64(footer + COLUMN_FTR_ROW_COUNT, writer->row_count);
+    column_write64(footer + COLUMN_FTR_BLOCK_COUNT, writer->index_count);
+    column_write64(footer + COLUMN_FTR_INDEX_OFFSET, index_offset);
+    column_write64(footer + COLUMN_FTR_DICT_OFFSET, dict_offset);
+    memcpy(footer + COLUMN_FTR_MAGIC, column_magic, sizeof(column_magic));
+    column_writer_write(writer, footer, sizeof(footer));
+
+    if ((err = plcrash_report_output_flush(&writer->output)) != PLCRASH_ESUCCESS) {
+        errno = writer->output.errnum;
+        return err;
+    }
+
+    if (close(writer->fd) != 0) {
+        writer->fd = -1;
+        return PLCRASH_OUTPUT_ERR;
+    }
+    writer->fd = -1;
+
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * @internal
+ * Free all resources associated with @a writer, closing the file if it is still open.
+ */
+static void column_writer_free (column_writer_t *writer) {
+    if (writer->fd != -1)
+        close(writer->fd);
+
+    free(writer->output_buffer);
+    free(writer->values);
+    free(writer->strings.data);
+    free(writer->payload.data);
+    free(writer->index);
+    column_dict_free(&writer->dict);
+}
+
+
+/* === Export === */
+
+/**
+ * @internal
+ * Exported columns.
+ */
+enum {
+    COL_REPORTS_PATH,
+    COL_REPORTS_TIMESTAMP,
+    COL_REPORTS_OS_VERSION,
+    COL_REPORTS_APP_IDENTIFIER,
+    COL_REPORTS_APP_VERSION,
+    COL_REPORTS_SIGNAL,
+    COL_REPORTS_SIGNAL_CODE,
+    COL_REPORTS_SIGNAL_ADDRESS,
+    COL_REPORTS_EXCEPTION,
+    COL_REPORTS_CRASHED_THREAD,
+
+    COL_THREADS_REPORT,
+    COL_THREADS_NUMBER,
+    COL_THREADS_CRASHED,
+    COL_THREADS_FRAME_COUNT,
+
+    COL_FRAMES_REPORT,
+    COL_FRAMES_THREAD,
+    COL_FRAMES_DEPTH,
+    COL_FRAMES_PC,
+    COL_FRAMES_IMAGE,
+    COL_FRAMES_OFFSET,
+
+    COL_IMAGES_REPORT,
+    COL_IMAGES_INDEX,
+    COL_IMAGES_BASE_ADDRESS,
+    COL_IMAGES_SIZE,
+    COL_IMAGES_NAME,
+    COL_IMAGES_UUID,
+
+    COL_COUNT
+};
+
+/**
+ * @internal
+ * Exported column definitions, indexed by the COL_ constants.
+ */
+static const struct {
+    /** File name, without the extension */
+    const char *name;
+
+    /** Value type */
+    plcrash_column_type_t type;
+
+    /** Encoding */
+    plcrash_column_encoding_t encoding;
+} columnar_columns[COL_COUNT] = {
+    { "reports.path",           PLCRASH_COLUMN_TYPE_STRING, PLCRASH_COLUMN_ENCODING_PLAIN },
+    { "reports.timestamp",      PLCRASH_COLUMN_TYPE_INT64,  PLCRASH_COLUMN_ENCODING_DELTA },
+    { "reports.os_version",     PLCRASH_COLUMN_TYPE_STRING, PLCRASH_COLUMN_ENCODING_DICT },
+    { "reports.app_identifier", PLCRASH_COLUMN_TYPE_STRING, PLCRASH_COLUMN_ENCODING_DICT },
+    { "reports.app_version",    PLCRASH_COLUMN_TYPE_STRING, PLCRASH_COLUMN_ENCODING_DICT },
+    { "reports.signal",         PLCRASH_COLUMN_TYPE_STRING, PLCRASH_COLUMN_ENCODING_DICT },
+    { "reports.signal_code",    PLCRASH_COLUMN_TYPE_STRING, PLCRASH_COLUMN_ENCODING_DICT },
+    { "reports.signal_address", PLCRASH_COLUMN_TYPE_UINT64, PLCRASH_COLUMN_ENCODING_PLAIN },
+    { "reports.exception",      PLCRASH_COLUMN_TYPE_STRING, PLCRASH_COLUMN_ENCODING_DICT },
+    { "reports.crashed_thread", PLCRASH_COLUMN_TYPE_UINT32, PLCRASH_COLUMN_ENCODING_PLAIN },
+
+    { "threads.report",         PLCRASH_COLUMN_TYPE_UINT64, PLCRASH_COLUMN_ENCODING_DELTA },
+    { "threads.number",         PLCRASH_COLUMN_TYPE_UINT32, PLCRASH_COLUMN_ENCODING_PLAIN },
+    { "threads.crashed",        PLCRASH_COLUMN_TYPE_UINT8,  PLCRASH_COLUMN_ENCODING_PLAIN },
+    { "threads.frame_count",    PLCRASH_COLUMN_TYPE_UINT32, PLCRASH_COLUMN_ENCODING_PLAIN },
+
+    { "frames.report",          PLCRASH_COLUMN_TYPE_UINT64, PLCRASH_COLUMN_ENCODING_DELTA },
+    { "frames.thread",          PLCRASH_COLUMN_TYPE_UINT32, PLCRASH_COLUMN_ENCODING_PLAIN },
+    { "frames.depth",           PLCRASH_COLUMN_TYPE_UINT32, PLCRASH_COLUMN_ENCODING_PLAIN },
+    { "frames.pc",              PLCRASH_COLUMN_TYPE_UINT64, PLCRASH_COLUMN_ENCODING_DELTA },
+    { "frames.image",           PLCRASH_COLUMN_TYPE_UINT32, PLCRASH_COLUMN_ENCODING_PLAIN },
+    { "frames.offset",          PLCRASH_COLUMN_TYPE_UINT64, PLCRASH_COLUMN_ENCODING_PLAIN },
+
+    { "images.report",          PLCRASH_COLUMN_TYPE_UINT64, PLCRASH_COLUMN_ENCODING_DELTA },
+    { "images.index",           PLCRASH_COLUMN_TYPE_UINT32, PLCRASH_COLUMN_ENCODING_PLAIN },
+    { "images.base_address",    PLCRASH_COLUMN_TYPE_UINT64, PLCRASH_COLUMN_ENCODING_DELTA },
+    { "images.size",            PLCRASH_COLUMN_TYPE_UINT64, PLCRASH_COLUMN_ENCODING_PLAIN },
+    { "images.name",            PLCRASH_COLUMN_TYPE_STRING, PLCRASH_COLUMN_ENCODING_DICT },
+    { "images.uuid",            PLCRASH_COLUMN_TYPE_STRING, PLCRASH_COLUMN_ENCODING_DICT },
+};
+
+/**
+ * @internal
+ * A decoded report awaiting export.
+ */
+typedef struct columnar_entry {
+    /** True if the report was decoded */
+    bool decoded;
+
+    /** Decoded report */
+    plcrash_report_t report;
+
+    /** Index of the image containing each of the report's frames, or COLUMNAR_NO_IMAGE */
+    uint32_t *frame_images;
+} columnar_entry_t;
+
+/**
+ * @internal
+ * A batch of consecutive input files, decoded by a single worker.
+ */
+typedef struct columnar_batch {
+    /** True once the batch has been decoded. Guarded by the pipeline lock. */
+    bool ready;
+
+    /** Decoding result */
+    plcrash_error_t error;
+
+    /** Decoded reports */
+    columnar_entry_t entries[COLUMNAR_BATCH_SIZE];
+} columnar_batch_t;
+
+/**
+ * @internal
+ * Export pipeline state. Workers decode batches of input files in parallel, while the exporting thread appends
+ * the decoded batches to the columns in input order. At most @a window batches are decoded ahead of the writer,
+ * bounding the memory held by decoded reports.
+ */
+typedef struct columnar_pipeline {
+    /** Input paths */
+    const char * const *paths;
+    size_t count;
+    size_t batch_count;
+
+    /** Batch slots; batch n is decoded into slot n % window */
+    columnar_batch_t *slots;
+    size_t window;
+
+    /** Guards the fields below, and the slots' ready flags */
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+
+    /** Index of the next batch to decode */
+    size_t next_batch;
+
+    /** Number of batches appended by the writer */
+    size_t written_batches;
+
+    /** True if the export has failed */
+    bool aborted;
+} columnar_pipeline_t;
+
+/**
+ * @internal
+ * Read the file at @a path into @a buffer, growing the buffer as required.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, PLCRASH_EINVAL if the file could not be read, or PLCRASH_ENOMEM
+ * if memory could not be allocated.
+ */
+static plcrash_error_t columnar_read_file (const char *path, uint8_t **buffer, size_t *capacity, size_t *length) {
+    struct stat sb;
+    size_t size;
+    size_t offset = 0;
+    int fd;
+
+    if ((fd = open(path, O_RDONLY)) == -1)
+        return PLCRASH_EINVAL;
+
+    if (fstat(fd, &sb) != 0 || !S_ISREG(sb.st_mode) || sb.st_size <= 0 || sb.st_size > COLUMNAR_FILE_MAX) {
+        close(fd);
+        return PLCRASH_EINVAL;
+    }
+    size = (size_t) sb.st_size;
+
+    if (size > *capacity) {
+        uint8_t *grown = realloc(*buffer, size);
+        if (grown == NULL) {
+            close(fd);
+            return PLCRASH_ENOMEM;
+        }
+
+        *buffer = grown;
+        *capacity = size;
+    }
+
+    while (offset < size) {
+        ssize_t nread = read(fd, *buffer + offset, size - offset);
+        if (nread < 0 && errno == EINTR)
+            continue;
+
+        if (nread <= 0) {
+            close(fd);
+            return PLCRASH_EINVAL;
+        }
+
+        offset += (size_t) nread;
+    }
+
+    close(fd);
+    *length = size;
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * @internal
+ * An image's address range and index within its report, used to resolve frames to images.
+ */
+typedef struct columnar_image_ref {
+    uint64_t base_address;
+    uint64_t end_address;
+    uint32_t index;
+} columnar_image_ref_t;
+
+/**
+ * @internal
+ * qsort() comparator ordering image references by base address, and then by index.
+ */
+static int columnar_image_ref_compare (const void *a, const void *b) {
+    const columnar_image_ref_t *lhs = a;
+    const columnar_image_ref_t *rhs = b;
+
+    if (lhs->base_address != rhs->base_address)
+        return lhs->base_address < rhs->base_address ? -1 : 1;
+
+    return lhs->index < rhs->index ? -1 : (lhs->index > rhs->index);
+}
+
+/**
+ * @internal
+ * Resolve the image containing each frame of @a entry's report. Images are sorted once per report, so that
+ * reports with many frames and images are not resolved in quadratic time.
+ */
+static plcrash_error_t columnar_resolve_frames (columnar_entry_t *entry) {
+    const plcrash_report_t *report = &entry->report;
+    columnar_image_ref_t *refs;
+
+    entry->frame_images = malloc((report->frame_count > 0 ? report->frame_count : 1) * sizeof(*entry->frame_images));
+    refs = malloc((report->image_count > 0 ? report->image_count : 1) * sizeof(*refs));
+    if (entry->frame_images == NULL || refs == NULL) {
+        free(refs);
+        return PLCRASH_ENOMEM;
+    }
+
+    for (size_t i = 0; i < report->image_count; i++) {
+        refs[i].base_address = report->images[i].base_address;
+        refs[i].end_address = report->images[i].base_address + report->images[i].size;
+        refs[i].index = (uint32_t) i;
+    }
+    qsort(refs, report->image_count, sizeof(*refs), columnar_image_ref_compare);
+
+    for (size_t i = 0; i < report->frame_count; i++) {
+        uint64_t pc = report->frames[i].pc;
+        size_t lo = 0;
+        size_t hi = report->image_count;
+
+        /* Find the last image based at or below pc */
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+
+            if (refs[mid].base_address <= pc)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+
+        entry->frame_images[i] = COLUMNAR_NO_IMAGE;
+        if (lo > 0 && pc < refs[lo - 1].end_address)
+            entry->frame_images[i] = refs[lo - 1].index;
+    }
+
+    free(refs);
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * @internal
+ * Release the decoded reports of @a batch.
+ */
+static void columnar_batch_release (columnar_batch_t *batch) {
+    for (size_t i = 0; i < COLUMNAR_BATCH_SIZE; i++) {
+        columnar_entry_t *entry = &batch->entries[i];
+
+        if (entry->decoded)
+            plcrash_report_free(&entry->report);
+
+        free(entry->frame_images);
+        memset(entry, 0, sizeof(*entry));
+    }
+}
+
+/**
+ * @internal
+ * Decode batch @a index into its slot.
+ */
+static void columnar_decode_batch (columnar_pipeline_t *pipeline, size_t index, uint8_t **buffer, size_t *capacity) {
+    columnar_batch_t *batch = &pipeline->slots[index % pipeline->window];
+    size_t start = index * COLUMNAR_BATCH_SIZE;
+    size_t end = (pipeline->count - start) > COLUMNAR_BATCH_SIZE ? start + COLUMNAR_BATCH_SIZE : pipeline->count;
+
+    batch->error = PLCRASH_ESUCCESS;
+
+    for (size_t i = start; i < end; i++) {
+        columnar_entry_t *entry = &batch->entries[i - start];
+        plcrash_error_t err;
+        size_t length;
+
+        err = columnar_read_file(pipeline->paths[i], buffer, capacity, &length);
+        if (err == PLCRASH_ESUCCESS)
+            err = plcrash_report_decode(&entry->report, *buffer, length, NULL);
+
+        /* Unreadable files and invalid reports are skipped */
+        if (err != PLCRASH_ESUCCESS) {
+            if (err == PLCRASH_ENOMEM) {
+                batch->error = err;
+                return;
+            }
+            continue;
+        }
+
+        entry->decoded = true;
+        if ((batch->error = columnar_resolve_frames(entry)) != PLCRASH_ESUCCESS)
+            return;
+    }
+}
+
+/**
+ * @internal
+ * Worker entry point: decode batches until none remain, staying at most one window ahead of the writer.
+ */
+static void *columnar_worker_run (void *arg) {
+    columnar_pipeline_t *pipeline = arg;
+    uint8_t *buffer = NULL;
+    size_t capacity = 0;
+
+    pthread_mutex_lock(&pipeline->lock);
+    for (;;) {
+        while (!pipeline->aborted && pipeline->next_batch < pipeline->batch_count &&
+               pipeline->next_batch >= pipeline->written_batches + pipeline->window)
+        {
+            pthread_cond_wait(&pipeline->cond, &pipeline->lock);
+        }
+
+        if (pipeline->aborted || pipeline->next_batch == pipeline->batch_count)
+            break;
+
+        size_t index = pipeline->next_batch++;
+        pthread_mutex_unlock(&pipeline->lock);
+
+        columnar_decode_batch(pipeline, index, &buffer, &capacity);
+
+        pthread_mutex_lock(&pipeline->lock);
+        pipeline->slots[index % pipeline->window].ready = true;
+        pthread_cond_broadcast(&pipeline->cond);
+    }
+    pthread_mutex_unlock(&pipeline->lock);
+
+    free(buffer);
+    return NULL;
+}
+
+/**
+ * @internal
+ * Format @a length bytes of @a uuid as lower-case hexadecimal.
+ */
+static void columnar_format_uuid (const uint8_t *uuid, size_t length, char *buffer) {
+    static const char hex[] = "0123456789abcdef";
+
+    for (size_t i = 0; i < length; i++) {
+        buffer[i * 2] = hex[uuid[i] >> 4];
+        buffer[i * 2 + 1] = hex[uuid[i] & 0xf];
+    }
+    buffer[length * 2] = '\0';
+}
+
+/**
+ * @internal
+ * Append the frames of a thread or exception backtrace.
+ */
+static plcrash_error_t columnar_append_frames (column_writer_t *columns, const columnar_entry_t *entry, uint64_t row,
+                                               uint32_t thread_number, size_t frame_index, size_t frame_count)
+{
+    const plcrash_report_t *report = &entry->report;
+    plcrash_error_t err = PLCRASH_ESUCCESS;
+
+    for (size_t i = 0; i < frame_count && err == PLCRASH_ESUCCESS; i++) {
+        uint64_t pc = report->frames[frame_index + i].pc;
+        uint32_t image = entry->frame_images[frame_index + i];
+        uint64_t offset = (image != COLUMNAR_NO_IMAGE) ? pc - report->images[image].base_address : 0;
+
+        err = column_writer_append(&columns[COL_FRAMES_REPORT], row);
+        if (err == PLCRASH_ESUCCESS)
+            err = column_writer_append(&columns[COL_FRAMES_THREAD], thread_number);
+        if (err == PLCRASH_ESUCCESS)
+            err = column_writer_append(&columns[COL_FRAMES_DEPTH], i);
+        if (err == PLCRASH_ESUCCESS)
+            err = column_writer_append(&columns[COL_FRAMES_PC], pc);
+        if (err == PLCRASH_ESUCCESS)
+            err = column_writer_append(&columns[COL_FRAMES_IMAGE], image);
+        if (err == PLCRASH_ESUCCESS)
+            err = column_writer_append(&columns[COL_FRAMES_OFFSET], offset);
+    }
+
+    return err;
+}
+
+/**
+ * @internal
+ * Append a decoded report to all tables.
+ */
+static plcrash_error_t columnar_append_report (column_writer_t *columns, const columnar_entry_t *entry, const char *path,
+                                               plcrash_columnar_stats_t *stats)
+{
+    const plcrash_report_t *report = &entry->report;
+    uint64_t row = stats->reports;
+    uint32_t crashed_thread = UINT32_MAX;
+    plcrash_error_t err;
+
+    for (size_t i = 0; i < report->thread_count; i++) {
+        if (report->threads[i].crashed) {
+            crashed_thread = report->threads[i].thread_number;
+            break;
+        }
+    }
+
+    /* Reports */
+#define APPEND(expr) do { if ((err = (expr)) != PLCRASH_ESUCCESS) return err; } while (0)
+    APPEND(column_writer_append_string(&columns[COL_REPORTS_PATH], path));
+    APPEND(column_writer_append(&columns[COL_REPORTS_TIMESTAMP], (uint64_t) report->system_info.timestamp));
+    APPEND(column_writer_append_string(&columns[COL_REPORTS_OS_VERSION], report->system_info.os_version));
+    APPEND(column_writer_append_string(&columns[COL_REPORTS_APP_IDENTIFIER], report->application_info.identifier));
+    APPEND(column_writer_append_string(&columns[COL_REPORTS_APP_VERSION], report->application_info.version));
+    APPEND(column_writer_append_string(&columns[COL_REPORTS_SIGNAL], report->signal_info.name));
+    APPEND(column_writer_append_string(&columns[COL_REPORTS_SIGNAL_CODE], report->signal_info.code));
+    APPEND(column_writer_append(&columns[COL_REPORTS_SIGNAL_ADDRESS], report->signal_info.address));
+    APPEND(column_writer_append_string(&columns[COL_REPORTS_EXCEPTION], report->has_exception_info ? report->exception_info.name : NULL));
+    APPEND(column_writer_append(&columns[COL_REPORTS_CRASHED_THREAD], crashed_thread));
+    stats->reports++;
+
+    /* Threads and their frames */
+    for (size_t i = 0; i < report->thread_count; i++) {
+        const plcrash_report_thread_t *thread = &report->threads[i];
+
+        APPEND(column_writer_append(&columns[COL_THREADS_REPORT], row));
+        APPEND(column_writer_append(&columns[COL_THREADS_NUMBER], thread->thread_number));
+        APPEND(column_writer_append(&columns[COL_THREADS_CRASHED], thread->crashed ? 1 : 0));
+        APPEND(column_writer_append(&columns[COL_THREADS_FRAME_COUNT], thread->frame_count));
+        APPEND(columnar_append_frames(columns, entry, row, thread->thread_number, thread->frame_index, thread->frame_count));
+
+        stats->threads++;
+        stats->frames += thread->frame_count;
+    }
+
+    if (report->has_exception_info) {
+        const plcrash_report_exception_info_t *exception = &report->exception_info;
+
+        APPEND(columnar_append_frames(columns, entry, row, COLUMNAR_EXCEPTION_THREAD, exception->frame_index, exception->frame_count));
+        stats->frames += exception->frame_count;
+    }
+
+    /* Images */
+    for (size_t i = 0; i < report->image_count; i++) {
+        const plcrash_report_image_t *image = &report->images[i];
+        char uuid[COLUMNAR_UUID_MAX * 2 + 1];
+        const char *uuid_string = NULL;
+
+        if (image->uuid != NULL && image->uuid_length > 0 && image->uuid_length <= COLUMNAR_UUID_MAX) {
+            columnar_format_uuid(image->uuid, image->uuid_length, uuid);
+            uuid_string = uuid;
+        }
+
+        APPEND(column_writer_append(&columns[COL_IMAGES_REPORT], row));
+        APPEND(column_writer_append(&columns[COL_IMAGES_INDEX], i));
+        APPEND(column_writer_append(&columns[COL_IMAGES_BASE_ADDRESS], image->base_address));
+        APPEND(column_writer_append(&columns[COL_IMAGES_SIZE], image->size));
+        APPEND(column_writer_append_string(&columns[COL_IMAGES_NAME], image->name));
+        APPEND(column_writer_append_string(&columns[COL_IMAGES_UUID], uuid_string));
+
+        stats->images++;
+    }
+#undef APPEND
+
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * @internal
+ * Build the path of column @a column within @a directory.
+ */
+static bool columnar_column_path (const char *directory, size_t column, char *path, size_t size) {
+    int length = snprintf(path, size, "%s/%s.%s", directory, columnar_columns[column].name, PLCRASH_COLUMN_EXTENSION);
+    return length > 0 && (size_t) length < size;
+}
+
+/**
+ * Export the reports at @a paths as column files in @a directory, replacing any existing column files. Reports
+ * are exported in input order; files that can not be read or decoded are skipped, and are counted in
+ * @a stats.
+ *
+ * Input files are decoded in parallel, in small batches; the decoded batches are appended to the columns in
+ * input order by the calling thread. The number of decoded reports held in memory is bounded by the number of
+ * threads, and each column holds at most one block of rows, so memory use does not depend on the number of
+ * reports (other than through the dictionaries of distinct strings).
+ *
+ * Tables:
+ *
+ * - reports: path, timestamp, os_version, app_identifier, app_version, signal, signal_code, signal_address,
+ *   exception (NULL if none), and crashed_thread (the crashed thread's number, or UINT32_MAX if none).
+ * - threads: report, number, crashed, and frame_count.
+ * - frames: report, thread (the thread number, or UINT32_MAX for the exception backtrace), depth, pc, image (the
+ *   row's index within its report's images, or UINT32_MAX if the frame is outside any image), and offset (from
+ *   the image base address, or 0).
+ * - images: report, index, base_address, size, name, and uuid (lower-case hexadecimal, or NULL if unavailable).
+ *
+ * @param directory The output directory. The directory must exist.
+ * @param paths Report paths.
+ * @param count Number of paths.
+ * @param thread_count Number of decoding threads, or 0 to use one thread per online processor. If 1, reports are
+ * decoded on the calling thread.
+ * @param stats On return, the number of rows written to each table, and the number of files that could not be
+ * read. May be NULL.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, PLCRASH_OUTPUT_ERR if a column file could not be written (with
+ * errno set), or PLCRASH_ENOMEM if memory could not be allocated. On failure, any column files written are removed.
+ */
+plcrash_error_t plcrash_columnar_export (const char *directory, const char * const *paths, size_t count, size_t thread_count,
+                                         plcrash_columnar_stats_t *stats)
+{
+    column_writer_t columns[COL_COUNT];
+    columnar_pipeline_t pipeline;
+    plcrash_columnar_stats_t result;
+    pthread_t threads[COLUMNAR_THREAD_MAX];
+    size_t started = 0;
+    size_t opened = 0;
+    plcrash_error_t err = PLCRASH_ESUCCESS;
+    uint8_t *buffer = NULL;
+    size_t capacity = 0;
+    char path[PATH_MAX];
+
+    memset(&result, 0, sizeof(result));
+    memset(&pipeline, 0, sizeof(pipeline));
+
+    if (thread_count == 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        thread_count = online > 0 ? (size_t) online : 1;
+    }
+    if (thread_count > COLUMNAR_THREAD_MAX)
+        thread_count = COLUMNAR_THREAD_MAX;
+
+    /* Create the columns */
+    for (opened = 0; opened < COL_COUNT && err == PLCRASH_ESUCCESS; opened++) {
+        if (!columnar_column_path(directory, opened, path, sizeof(path))) {
+            errno = ENAMETOOLONG;
+            err = PLCRASH_OUTPUT_ERR;
+            break;
+        }
+
+        err = column_writer_open(&columns[opened], path, columnar_columns[opened].type, columnar_columns[opened].encoding);
+    }
+
+    pipeline.paths = paths;
+    pipeline.count = count;
+    pipeline.batch_count = (count + COLUMNAR_BATCH_SIZE - 1) / COLUMNAR_BATCH_SIZE;
+    pipeline.window = thread_count * 2;
+    pthread_mutex_init(&pipeline.lock, NULL);
+    pthread_cond_init(&pipeline.cond, NULL);
+
+    if (err == PLCRASH_ESUCCESS && (pipeline.slots = calloc(pipeline.window, sizeof(*pipeline.slots))) == NULL)
+        err = PLCRASH_ENOMEM;
+
+    /* Start the decoding workers. If no worker can be started, batches are decoded by the calling thread. */
+    if (err == PLCRASH_ESUCCESS && thread_count > 1) {
+        for (size_t i = 0; i < thread_count && i < pipeline.batch_count; i++) {
+            if (pthread_create(&threads[started], NULL, columnar_worker_run, &pipeline) == 0)
+                started++;
+        }
+    }
+
+    /* Append the decoded batches in input order */
+    for (size_t index = 0; index < pipeline.batch_count && err == PLCRASH_ESUCCESS; index++) {
+        columnar_batch_t *batch = &pipeline.slots[index % pipeline.window];
+        size_t start = index * COLUMNAR_BATCH_SIZE;
+        size_t end = (count - start) > COLUMNAR_BATCH_SIZE ? start + COLUMNAR_BATCH_SIZE : count;
+
+        if (started == 0) {
+            columnar_decode_batch(&pipeline, index, &buffer, &capacity);
+        } else {
+            pthread_mutex_lock(&pipeline.lock);
+            while (!batch->ready)
+                pthread_cond_wait(&pipeline.cond, &pipeline.lock);
+            pthread_mutex_unlock(&pipeline.lock);
+        }
+
+        err = batch->error;
+        for (size_t i = start; i < end && err == PLCRASH_ESUCCESS; i++) {
+            const columnar_entry_t *entry = &batch->entries[i - start];
+
+            if (entry->decoded)
+                err = columnar_append_report(columns, entry, paths[i], &result);
+            else
+                result.failed++;
+        }
+
+        columnar_batch_release(batch);
+
+        pthread_mutex_lock(&pipeline.lock);
+        batch->ready = false;
+        pipeline.written_batches++;
+        if (err != PLCRASH_ESUCCESS)
+            pipeline.aborted = true;
+        pthread_cond_broadcast(&pipeline.cond);
+        pthread_mutex_unlock(&pipeline.lock);
+    }
+
+    for (size_t i = 0; i < started; i++)
+        pthread_join(threads[i], NULL);
+
+    /* Release any batches decoded ahead of a failure */
+    if (pipeline.slots != NULL) {
+        for (size_t i = 0; i < pipeline.window; i++)
+            columnar_batch_release(&pipeline.slots[i]);
+        free(pipeline.slots);
+    }
+
+    pthread_cond_destroy(&pipeline.cond);
+    pthread_mutex_destroy(&pipeline.lock);
+    free(buffer);
+
+    /* Complete the columns */
+    for (size_t i = 0; i < opened && err == PLCRASH_ESUCCESS; i++)
+        err = column_writer_finish(&columns[i]);
+
+    /* Preserve errno across cleanup */
+    int errnum = errno;
+    for (size_t i = 0; i < opened; i++) {
+        if (err != PLCRASH_ESUCCESS && columns[i].created && columnar_column_path(directory, i, path, sizeof(path)))
+            unlink(path);
+
+        column_writer_free(&columns[i]);
+    }
+    errno = errnum;
+
+    if (stats != NULL)
+        *stats = result;
+
+    return err;
+}
+
+/**
+ * @} plcrash_columnar
+ */
@@ -0,0 +1,179 @@
+/*
+ * Copyright (c) 2008-2011 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef PLCRASH_COLUMNAR_H
+#define PLCRASH_COLUMNAR_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#import "PLCrashAsync.h"
+#include "PLCrashReportCore.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @internal
+ * @defgroup plcrash_columnar Columnar Export
+ *
+ * Flattens decoded reports into four tables -- reports, threads, frames, and images -- stored as one file per
+ * column, named "<table>.<column>.plcol". Rows of the threads, frames, and images tables reference their report
+ * by row number in the reports table.
+ *
+ * Columns are written in blocks of at most PLCRASH_COLUMN_BLOCK_ROWS rows, so that the memory required to
+ * write a column does not depend on the number of rows. Each block is independently decodable, and is located
+ * through the block index at the end of the file, allowing readers to map a column and scan (or skip) blocks
+ * directly.
+ *
+ * The format is little-endian:
+ *
+ * - Header (24 bytes): the magic "plcolmn\0", version, value type, encoding, and maximum rows per block.
+ * - Blocks, each aligned to 8 bytes: row count (4), payload length (4), first value (8), then the payload:
+ *   - PLCRASH_COLUMN_ENCODING_PLAIN: fixed-width values, or, for strings, a 4-byte offset per row (relative to
+ *     the end of the offset table) followed by the NUL-terminated strings.
+ *   - PLCRASH_COLUMN_ENCODING_DELTA: zigzag-encoded base 128 varint deltas from the previous value, beginning
+ *     with the second row; the first row's value is the block's first value.
+ *   - PLCRASH_COLUMN_ENCODING_DICT: a 4-byte dictionary index per row, or PLCRASH_COLUMN_NULL.
+ * - Dictionary (dictionary-encoded columns only): entry count (8), string table size (8), a 4-byte string
+ *   table offset per entry (padded to 8 bytes), and the NUL-terminated strings.
+ * - Block index: the 8-byte file offset of each block.
+ * - Footer (40 bytes): row count, block count, block index offset, dictionary offset (0 if none), and the magic.
+ *
+ * @{
+ */
+
+/** Column file extension */
+#define PLCRASH_COLUMN_EXTENSION "plcol"
+
+/** Current column format version */
+#define PLCRASH_COLUMN_VERSION 1
+
+/** Maximum number of rows per block */
+#define PLCRASH_COLUMN_BLOCK_ROWS 16384
+
+/** Dictionary index of a NULL value */
+#define PLCRASH_COLUMN_NULL UINT32_MAX
+
+/**
+ * Column value types.
+ */
+typedef enum {
+    /** Unsigned 8-bit integer */
+    PLCRASH_COLUMN_TYPE_UINT8 = 1,
+
+    /** Unsigned 32-bit integer */
+    PLCRASH_COLUMN_TYPE_UINT32 = 2,
+
+    /** Unsigned 64-bit integer */
+    PLCRASH_COLUMN_TYPE_UINT64 = 3,
+
+    /** Signed 64-bit integer */
+    PLCRASH_COLUMN_TYPE_INT64 = 4,
+
+    /** NUL-terminated UTF-8 string */
+    PLCRASH_COLUMN_TYPE_STRING = 5
+} plcrash_column_type_t;
+
+/**
+ * Column encodings.
+ */
+typedef enum {
+    /** Values stored as-is. Supported by all types. */
+    PLCRASH_COLUMN_ENCODING_PLAIN = 0,
+
+    /** Varint deltas. Supported by 64-bit integer columns. */
+    PLCRASH_COLUMN_ENCODING_DELTA = 1,
+
+    /** Dictionary indices. Supported by string columns. */
+    PLCRASH_COLUMN_ENCODING_DICT = 2
+} plcrash_column_encoding_t;
+
+/**
+ * A read-only view of a column file. The column data must remain valid (eg, mapped) for the lifetime of the view.
+ */
+typedef struct plcrash_column {
+    /** Value type */
+    plcrash_column_type_t type;
+
+    /** Encoding */
+    plcrash_column_encoding_t encoding;
+
+    /** Total number of rows */
+    uint64_t row_count;
+
+    /** Number of blocks */
+    size_t block_count;
+
+    /** Number of dictionary entries */
+    size_t dict_count;
+
+    /** @internal Column data */
+    const uint8_t *data;
+    size_t size;
+
+    /** @internal Block index */
+    const uint8_t *index;
+
+    /** @internal Dictionary string offsets and strings */
+    const uint8_t *dict_offsets;
+    const char *dict_strings;
+    size_t dict_strings_size;
+} plcrash_column_t;
+
+plcrash_error_t plcrash_column_init (plcrash_column_t *column, const void *data, size_t size);
+plcrash_error_t plcrash_column_read_block (const plcrash_column_t *column, size_t block, uint64_t *values, size_t *count);
+plcrash_error_t plcrash_column_read_strings (const plcrash_column_t *column, size_t block, const char **strings, size_t *count);
+const char *plcrash_column_dict_string (const plcrash_column_t *column, uint32_t index);
+
+/**
+ * Columnar export results.
+ */
+typedef struct plcrash_columnar_stats {
+    /** Number of rows written to each table */
+    uint64_t reports;
+    uint64_t threads;
+    uint64_t frames;
+    uint64_t images;
+
+    /** Number of input files that could not be read or decoded */
+    uint64_t failed;
+} plcrash_columnar_stats_t;
+
+plcrash_error_t plcrash_columnar_export (const char *directory, const char * const *paths, size_t count, size_t thread_count,
+                                         plcrash_columnar_stats_t *stats);
+
+/**
+ * @} plcrash_columnar
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PLCRASH_COLUMNAR_H */
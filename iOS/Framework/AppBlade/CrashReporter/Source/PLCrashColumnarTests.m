@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2008-2011 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "GTMSenTestCase.h"
+
+#import "PLCrashColumnar.h"
+#import "PLCrashLogWriter.h"
+#import "PLCrashFrameWalker.h"
+
+@interface PLCrashColumnarTests : SenTestCase {
+@private
+    /* Path to crash log */
+    NSString *_logPath;
+
+    /* Column output directory */
+    NSString *_outputPath;
+
+    /* Test thread */
+    plframe_test_thead_t _thr_args;
+}
+
+@end
+
+@implementation PLCrashColumnarTests
+
+- (void) setUp {
+    _logPath = [[NSTemporaryDirectory() stringByAppendingPathComponent: [[NSProcessInfo processInfo] globallyUniqueString]] retain];
+    _outputPath = [[NSTemporaryDirectory() stringByAppendingPathComponent: [[NSProcessInfo processInfo] globallyUniqueString]] retain];
+    [[NSFileManager defaultManager] createDirectoryAtPath: _outputPath withIntermediateDirectories: YES attributes: nil error: NULL];
+
+    plframe_test_thread_spawn(&_thr_args);
+}
+
+- (void) tearDown {
+    [[NSFileManager defaultManager] removeItemAtPath: _logPath error: NULL];
+    [[NSFileManager defaultManager] removeItemAtPath: _outputPath error: NULL];
+    [_logPath release];
+    [_outputPath release];
+
+    plframe_test_thread_stop(&_thr_args);
+}
+
+/* Map the named column, returning its data */
+- (NSData *) columnData: (NSString *) name column: (plcrash_column_t *) column {
+    NSString *path = [_outputPath stringByAppendingPathComponent: [name stringByAppendingPathExtension: @PLCRASH_COLUMN_EXTENSION]];
+    NSData *data = [NSData dataWithContentsOfFile: path options: NSMappedRead error: NULL];
+
+    STAssertNotNil(data, @"Missing column %@", name);
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_column_init(column, [data bytes], [data length]), @"Could not read column %@", name);
+
+    return data;
+}
+
+- (void) testExport {
+    plcrash_columnar_stats_t stats;
+    plcrash_report_t report;
+    plcrash_column_t column;
+    uint64_t *values;
+    const char **strings;
+    size_t count;
+    NSData *data;
+
+    /* Write a crash report */
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_log_writer_write_test_report(pthread_mach_thread_np(_thr_args.thread), [_logPath fileSystemRepresentation], false),
+                   @"Could not write the crash report");
+    data = [NSData dataWithContentsOfFile: _logPath];
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_report_decode(&report, [data bytes], [data length], NULL), @"Decode failed");
+
+    /* Export it twice, along with a missing file */
+    const char *paths[] = { [_logPath fileSystemRepresentation], "/nonexistent/report.plcrash", [_logPath fileSystemRepresentation] };
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_columnar_export([_outputPath fileSystemRepresentation], paths, 3, 2, &stats), @"Export failed");
+
+    STAssertEquals((uint64_t) 2, stats.reports, @"Incorrect report count");
+    STAssertEquals((uint64_t) 1, stats.failed, @"Incorrect failed count");
+    STAssertEquals((uint64_t) report.thread_count * 2, stats.threads, @"Incorrect thread count");
+    STAssertEquals((uint64_t) report.image_count * 2, stats.images, @"Incorrect image count");
+
+    values = malloc(PLCRASH_COLUMN_BLOCK_ROWS * sizeof(*values));
+    strings = malloc(PLCRASH_COLUMN_BLOCK_ROWS * sizeof(*strings));
+
+    /* Plain strings */
+    [self columnData: @"reports.path" column: &column];
+    STAssertEquals((uint64_t) 2, column.row_count, @"Incorrect row count");
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_column_read_strings(&column, 0, strings, &count), @"Could not read block");
+    STAssertEquals((size_t) 2, count, @"Incorrect block row count");
+    STAssertEqualCStrings(paths[2], strings[1], @"Incorrect path");
+    STAssertEquals(PLCRASH_ENOTSUP, plcrash_column_read_block(&column, 0, values, &count), @"Plain strings read as integers");
+
+    /* Dictionary strings are stored once */
+    [self columnData: @"reports.app_identifier" column: &column];
+    STAssertEquals((size_t) 1, column.dict_count, @"Incorrect dictionary size");
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_column_read_block(&column, 0, values, &count), @"Could not read block");
+    STAssertEqualCStrings("test.id", plcrash_column_dict_string(&column, (uint32_t) values[1]), @"Incorrect identifier");
+
+    [self columnData: @"reports.exception" column: &column];
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_column_read_block(&column, 0, values, &count), @"Could not read block");
+    STAssertEquals((uint64_t) PLCRASH_COLUMN_NULL, values[0], @"Missing exception was not NULL");
+    STAssertTrue(plcrash_column_dict_string(&column, PLCRASH_COLUMN_NULL) == NULL, @"NULL index returned a string");
+
+    /* Delta-encoded addresses round-trip, and are grouped by report */
+    [self columnData: @"frames.pc" column: &column];
+    STAssertEquals(stats.frames, column.row_count, @"Incorrect frame count");
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_column_read_block(&column, 0, values, &count), @"Could not read block");
+
+    size_t frame = 0;
+    for (size_t i = 0; i < report.thread_count; i++) {
+        const plcrash_report_thread_t *thread = &report.threads[i];
+
+        for (size_t j = 0; j < thread->frame_count; j++, frame++)
+            STAssertEquals(report.frames[thread->frame_index + j].pc, values[frame], @"Incorrect pc");
+    }
+
+    [self columnData: @"frames.report" column: &column];
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_column_read_block(&column, 0, values, &count), @"Could not read block");
+    STAssertEquals((uint64_t) 0, values[0], @"Incorrect report row");
+    STAssertEquals((uint64_t) 1, values[count - 1], @"Incorrect report row");
+
+    /* Image names */
+    [self columnData: @"images.name" column: &column];
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_column_read_block(&column, 0, values, &count), @"Could not read block");
+    STAssertEqualCStrings(report.images[0].name, plcrash_column_dict_string(&column, (uint32_t) values[0]), @"Incorrect image name");
+    STAssertEquals(values[0], values[report.image_count], @"Image name was not deduplicated");
+
+    free(values);
+    free(strings);
+    plcrash_report_free(&report);
+}
+
+- (void) testInvalidColumn {
+    plcrash_columnar_stats_t stats;
+    plcrash_column_t column;
+    uint64_t values[1];
+    size_t count;
+    const char *paths[] = { "/nonexistent/report.plcrash" };
+
+    /* Export to a missing directory */
+    NSString *missing = [_outputPath stringByAppendingPathComponent: @"missing"];
+    STAssertEquals(PLCRASH_OUTPUT_ERR, plcrash_columnar_export([missing fileSystemRepresentation], paths, 1, 1, &stats), @"Export succeeded");
+
+    /* An empty export produces empty columns */
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_columnar_export([_outputPath fileSystemRepresentation], paths, 1, 1, &stats), @"Export failed");
+    STAssertEquals((uint64_t) 1, stats.failed, @"Incorrect failed count");
+
+    NSData *data = [self columnData: @"frames.pc" column: &column];
+    STAssertEquals((uint64_t) 0, column.row_count, @"Incorrect row count");
+    STAssertEquals(PLCRASH_EINVAL, plcrash_column_read_block(&column, 0, values, &count), @"Read past the last block");
+
+    /* Truncated and unrecognized data is rejected */
+    STAssertEquals(PLCRASH_EINVAL, plcrash_column_init(&column, [data bytes], [data length] - 1), @"Accepted a truncated column");
+    STAssertEquals(PLCRASH_ENOTSUP, plcrash_column_init(&column, "not a column", 12), @"Accepted an invalid column");
+}
+
+@end
@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2008-2011 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PLCrashCompression.h"
+
+#include <limits.h>
+#include <string.h>
+#include <zlib.h>
+
+/**
+ * @ingroup plcrash_compression
+ * @{
+ */
+
+/* Size of the intermediate buffer used to stream (de)compressed data to the output */
+#define GZIP_CHUNK_SIZE 16384
+
+/* zlib window bits selecting the gzip wrapper */
+#define GZIP_WINDOW_BITS (MAX_WBITS + 16)
+
+/* zlib memory level used for compression (the zlib default) */
+#define GZIP_MEM_LEVEL 8
+
+/**
+ * Return true if @a data begins with the gzip magic and the deflate compression method.
+ *
+ * @param data The data to check.
+ * @param length The length of @a data.
+ */
+bool plcrash_gzip_detect (const void *data, size_t length) {
+    const uint8_t *bytes = data;
+    return length >= 3 && bytes[0] == 0x1f && bytes[1] == 0x8b && bytes[2] == Z_DEFLATED;
+}
+
+/**
+ * @internal
+ * Set the next input of @a strm from @a *data, consuming at most UINT_MAX bytes.
+ */
+static void gzip_next_input (z_stream *strm, const uint8_t **data, size_t *length) {
+    uInt chunk = (*length > UINT_MAX) ? UINT_MAX : (uInt) *length;
+
+    strm->next_in = (Bytef *) *data;
+    strm->avail_in = chunk;
+    *data += chunk;
+    *length -= chunk;
+}
+
+/**
+ * Compress @a data as a single gzip member, writing the result to @a output.
+ *
+ * @param data The data to compress.
+ * @param length The length of @a data.
+ * @param output The output to which the compressed data will be written.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, PLCRASH_ENOMEM if memory could not be allocated, or the error
+ * recorded by @a output.
+ */
+plcrash_error_t plcrash_gzip_compress (const void *data, size_t length, plcrash_report_output_t *output) {
+    uint8_t chunk[GZIP_CHUNK_SIZE];
+    const uint8_t *input = data;
+    z_stream strm;
+    int ret;
+
+    memset(&strm, 0, sizeof(strm));
+    if (deflateInit2(&strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED, GZIP_WINDOW_BITS, GZIP_MEM_LEVEL, Z_DEFAULT_STRATEGY) != Z_OK)
+        return PLCRASH_ENOMEM;
+
+    do {
+        if (strm.avail_in == 0)
+            gzip_next_input(&strm, &input, &length);
+
+        strm.next_out = chunk;
+        strm.avail_out = sizeof(chunk);
+
+        ret = deflate(&strm, (length == 0) ? Z_FINISH : Z_NO_FLUSH);
+        if (ret == Z_STREAM_ERROR) {
+            deflateEnd(&strm);
+            return PLCRASH_EINTERNAL;
+        }
+
+        plcrash_report_output_write(output, chunk, sizeof(chunk) - strm.avail_out);
+    } while (ret != Z_STREAM_END && output->error == PLCRASH_ESUCCESS);
+
+    deflateEnd(&strm);
+    return output->error;
+}
+
+/**
+ * Decompress the gzip member at the start of @a data, writing the result to @a output. Any data following the
+ * member is ignored.
+ *
+ * @param data The compressed data.
+ * @param length The length of @a data.
+ * @param limit The maximum number of decompressed bytes to accept.
+ * @param output The output to which the decompressed data will be written.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, PLCRASH_EINVAL if @a data is not valid gzip data, is truncated,
+ * or decompresses to more than @a limit bytes, PLCRASH_ENOMEM if memory could not be allocated, or the error
+ * recorded by @a output.
+ */
+plcrash_error_t plcrash_gzip_decompress (const void *data, size_t length, size_t limit, plcrash_report_output_t *output) {
+    uint8_t chunk[GZIP_CHUNK_SIZE];
+    const uint8_t *input = data;
+    size_t total = 0;
+    z_stream strm;
+    int ret;
+
+    if (!plcrash_gzip_detect(data, length))
+        return PLCRASH_EINVAL;
+
+    memset(&strm, 0, sizeof(strm));
+    if (inflateInit2(&strm, GZIP_WINDOW_BITS) != Z_OK)
+        return PLCRASH_ENOMEM;
+
+    do {
+        size_t produced;
+
+        if (strm.avail_in == 0 && length > 0)
+            gzip_next_input(&strm, &input, &length);
+
+        strm.next_out = chunk;
+        strm.avail_out = sizeof(chunk);
+
+        ret = inflate(&strm, Z_NO_FLUSH);
+        switch (ret) {
+            case Z_OK:
+            case Z_STREAM_END:
+                break;
+
+            case Z_BUF_ERROR:
+                /* No progress is possible with the remaining input; the member is truncated */
+                inflateEnd(&strm);
+                return PLCRASH_EINVAL;
+
+            case Z_MEM_ERROR:
+                inflateEnd(&strm);
+                return PLCRASH_ENOMEM;
+
+            default:
+                inflateEnd(&strm);
+                return PLCRASH_EINVAL;
+        }
+
+        produced = sizeof(chunk) - strm.avail_out;
+        if (produced > limit - total) {
+            inflateEnd(&strm);
+            return PLCRASH_EINVAL;
+        }
+        total += produced;
+
+        plcrash_report_output_write(output, chunk, produced);
+    } while (ret != Z_STREAM_END && output->error == PLCRASH_ESUCCESS);
+
+    inflateEnd(&strm);
+    return output->error;
+}
+
+/**
+ * @} plcrash_compression
+ */
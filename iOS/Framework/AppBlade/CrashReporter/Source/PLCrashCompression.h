@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2008-2011 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef PLCRASH_COMPRESSION_H
+#define PLCRASH_COMPRESSION_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#import "PLCrashAsync.h"
+#include "PLCrashReportCore.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @internal
+ * @defgroup plcrash_compression Report Compression
+ *
+ * gzip (RFC 1952) compression of encoded crash reports, for storage and upload. plcrash_report_decode()
+ * accepts compressed reports directly, so that a compressed upload may be decoded and formatted exactly as
+ * the original report.
+ *
+ * These functions allocate memory, and are not async-safe.
+ *
+ * @{
+ */
+
+/** Maximum decompressed size of a compressed report accepted by plcrash_report_decode() */
+#define PLCRASH_GZIP_REPORT_MAX (64 * 1024 * 1024)
+
+bool plcrash_gzip_detect (const void *data, size_t length);
+plcrash_error_t plcrash_gzip_compress (const void *data, size_t length, plcrash_report_output_t *output);
+plcrash_error_t plcrash_gzip_decompress (const void *data, size_t length, size_t limit, plcrash_report_output_t *output);
+
+/**
+ * @} plcrash_compression
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PLCRASH_COMPRESSION_H */
@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2008-2011 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "GTMSenTestCase.h"
+
+#import "PLCrashCompression.h"
+#import "PLCrashReport.h"
+#import "PLCrashReportTextFormatter.h"
+#import "PLCrashLogWriter.h"
+#import "PLCrashFrameWalker.h"
+
+#if !TARGET_OS_IPHONE
+#import "GTMHTTPServer.h"
+#endif
+
+@interface PLCrashCompressionTests : SenTestCase {
+@private
+    /* Path to crash log */
+    NSString *_logPath;
+
+    /* Test thread */
+    plframe_test_thead_t _thr_args;
+
+    /* Body of the last request received by the local HTTP server */
+    NSData *_receivedBody;
+
+    /* Content-Type of the last request received by the local HTTP server */
+    NSString *_receivedContentType;
+}
+
+@end
+
+@implementation PLCrashCompressionTests
+
+- (void) setUp {
+    _logPath = [[NSTemporaryDirectory() stringByAppendingPathComponent: [[NSProcessInfo processInfo] globallyUniqueString]] retain];
+    plframe_test_thread_spawn(&_thr_args);
+}
+
+- (void) tearDown {
+    [[NSFileManager defaultManager] removeItemAtPath: _logPath error: NULL];
+    [_logPath release];
+    [_receivedBody release];
+    [_receivedContentType release];
+
+    plframe_test_thread_stop(&_thr_args);
+}
+
+/* Write a crash report for the test thread, returning its encoded data */
+- (NSData *) writeReport {
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_log_writer_write_test_report(pthread_mach_thread_np(_thr_args.thread), [_logPath fileSystemRepresentation], false),
+                   @"Could not write the crash report");
+    return [NSData dataWithContentsOfFile: _logPath];
+}
+
+/* Compress the given data */
+- (NSData *) compress: (NSData *) data {
+    plcrash_report_output_t output;
+    NSData *result;
+
+    plcrash_report_output_init_buffer(&output, 0);
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_gzip_compress([data bytes], [data length], &output), @"Compression failed");
+    result = [NSData dataWithBytes: output.buffer length: output.length];
+    plcrash_report_output_free(&output);
+
+    return result;
+}
+
+/* Decode and format the given report as iOS text */
+- (NSString *) textForReportData: (NSData *) data {
+    NSError *error;
+    PLCrashReport *report = [[[PLCrashReport alloc] initWithData: data error: &error] autorelease];
+    STAssertNotNil(report, @"Could not decode report: %@", error);
+
+    return [PLCrashReportTextFormatter stringValueForCrashReport: report withTextFormat: PLCrashReportTextFormatiOS];
+}
+
+- (void) testRoundTrip {
+    plcrash_report_output_t output;
+    NSMutableData *data = [NSMutableData dataWithLength: 256 * 1024];
+    uint8_t *bytes = [data mutableBytes];
+
+    /* Larger than the internal chunk size, and not trivially compressible */
+    for (size_t i = 0; i < [data length]; i++)
+        bytes[i] = (uint8_t) ((i * 2654435761U) >> 13);
+
+    NSData *compressed = [self compress: data];
+    STAssertTrue(plcrash_gzip_detect([compressed bytes], [compressed length]), @"gzip header not detected");
+    STAssertFalse(plcrash_gzip_detect([data bytes], [data length]), @"gzip header detected in uncompressed data");
+
+    plcrash_report_output_init_buffer(&output, 0);
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_gzip_decompress([compressed bytes], [compressed length], [data length], &output), @"Decompression failed");
+    STAssertEquals((size_t) [data length], output.length, @"Incorrect decompressed length");
+    STAssertTrue(memcmp(bytes, output.buffer, output.length) == 0, @"Decompressed data does not match");
+
+    /* Output beyond the limit is rejected */
+    plcrash_report_output_reset(&output);
+    STAssertEquals(PLCRASH_EINVAL, plcrash_gzip_decompress([compressed bytes], [compressed length], [data length] - 1, &output), @"Limit not enforced");
+
+    /* As is truncated input */
+    plcrash_report_output_reset(&output);
+    STAssertEquals(PLCRASH_EINVAL, plcrash_gzip_decompress([compressed bytes], [compressed length] / 2, SIZE_MAX, &output), @"Truncated input accepted");
+
+    plcrash_report_output_free(&output);
+}
+
+- (void) testDecodeCompressedReport {
+    NSData *data = [self writeReport];
+    NSData *compressed = [self compress: data];
+    plcrash_report_t report;
+    const char *description;
+
+    STAssertTrue([compressed length] < [data length], @"Report did not compress");
+
+    /* Compressed reports are decoded transparently, and format identically */
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_report_decode(&report, [compressed bytes], [compressed length], NULL), @"Decode failed");
+    plcrash_report_free(&report);
+
+    STAssertEqualObjects([self textForReportData: data], [self textForReportData: compressed], @"Compressed report formatted differently");
+
+    /* A truncated compressed report is reported as such */
+    STAssertEquals(PLCRASH_EINVAL, plcrash_report_decode(&report, [compressed bytes], [compressed length] - 8, &description), @"Truncated report decoded");
+    STAssertEqualCStrings("Could not decompress crash log", description, @"Incorrect description");
+}
+
+#if !TARGET_OS_IPHONE
+
+/* Local HTTP stand-in for the crash report endpoint; records the request */
+- (GTMHTTPResponseMessage *) httpServer: (GTMHTTPServer *) server handleRequest: (GTMHTTPRequestMessage *) request {
+    [_receivedBody release];
+    [_receivedContentType release];
+    _receivedBody = [[request body] retain];
+    _receivedContentType = [[[request allHeaderFieldValues] objectForKey: @"Content-Type"] retain];
+
+    return [GTMHTTPResponseMessage emptyResponseWithCode: 201];
+}
+
+- (void) testUploadCompressedReport {
+    NSData *data = [self writeReport];
+    NSError *error = nil;
+
+    GTMHTTPServer *server = [[[GTMHTTPServer alloc] initWithDelegate: self] autorelease];
+    STAssertTrue([server start: &error], @"Could not start local HTTP server: %@", error);
+
+    NSString *url = [NSString stringWithFormat: @"http://localhost:%hu/api/3/crash_reports", [server port]];
+    NSMutableURLRequest *request = [NSMutableURLRequest requestWithURL: [NSURL URLWithString: url]];
+    [request setHTTPMethod: @"POST"];
+    [request setValue: @"application/gzip" forHTTPHeaderField: @"Content-Type"];
+    [request setHTTPBody: [self compress: data]];
+
+    /* The server is serviced by this thread's run loop */
+    __block BOOL finished = NO;
+    __block NSInteger status = 0;
+    [NSURLConnection sendAsynchronousRequest: request queue: [NSOperationQueue mainQueue] completionHandler: ^(NSURLResponse *response, NSData *body, NSError *connectionError) {
+        status = [(NSHTTPURLResponse *) response statusCode];
+        finished = YES;
+    }];
+
+    NSDate *deadline = [NSDate dateWithTimeIntervalSinceNow: 10.0];
+    while (!finished && [deadline timeIntervalSinceNow] > 0)
+        [[NSRunLoop currentRunLoop] runMode: NSDefaultRunLoopMode beforeDate: [NSDate dateWithTimeIntervalSinceNow: 0.1]];
+    [server stop];
+
+    STAssertTrue(finished, @"Request timed out");
+    STAssertEquals((NSInteger) 201, status, @"Unexpected status");
+    STAssertEqualObjects(@"application/gzip", _receivedContentType, @"Incorrect content type");
+
+    /* The received report converts to exactly the text that on-device formatting produces */
+    STAssertTrue(plcrash_gzip_detect([_receivedBody bytes], [_receivedBody length]), @"Received report is not compressed");
+    STAssertEqualObjects([self textForReportData: data], [self textForReportData: _receivedBody], @"Received report formatted differently");
+}
+
+#endif /* !TARGET_OS_IPHONE */
+
+@end
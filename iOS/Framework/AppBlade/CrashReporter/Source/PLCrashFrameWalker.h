@@ -102,6 +102,9 @@ typedef struct plframe_cursor {
     
     /** Stack frame data */
     void *fp[PLFRAME_STACKFRAME_LEN];
+
+    /** Number of failed memory reads performed by this cursor */
+    uint32_t read_failures;
     
     // for thread-initialized cursors
     /** Generated ucontext_t */
@@ -121,6 +124,9 @@ typedef struct plframe_cursor {
 typedef enum {
     /** Instruction pointer */
     PLFRAME_REG_IP = PLFRAME_PDEF_REG_IP,
+
+    /** Stack pointer */
+    PLFRAME_REG_SP = PLFRAME_PDEF_REG_SP,
     
     /** Last register */
     PLFRAME_REG_LAST = PLFRAME_PDEF_LAST_REG
@@ -87,4 +87,20 @@
     }
 }
 
+/* test that failed reads are counted by the cursor */
+- (void) testReadFailureCount {
+    plframe_cursor_t cursor;
+
+    STAssertEquals(PLFRAME_ESUCCESS, plframe_cursor_thread_init(&cursor, pthread_mach_thread_np(_thr_args.thread)), @"Initialization failed");
+    STAssertEquals((uint32_t) 0, cursor.read_failures, @"Read failures not reset");
+
+    /* The first frame is available without a read */
+    STAssertEquals(PLFRAME_ESUCCESS, plframe_cursor_next(&cursor), @"Next failed");
+
+    /* Point the frame at the unmapped page at 0x0 */
+    cursor.fp[0] = (void *) sizeof(void *);
+    STAssertEquals(PLFRAME_EBADFRAME, plframe_cursor_next(&cursor), @"Read of a bad frame succeeded");
+    STAssertEquals((uint32_t) 1, cursor.read_failures, @"Read failure not counted");
+}
+
 @end
@@ -73,6 +73,8 @@ typedef enum {
     /* Common registers */
     
     PLFRAME_PDEF_REG_IP = PLFRAME_ARM_PC,
+
+    PLFRAME_PDEF_REG_SP = PLFRAME_ARM_SP,
     
     /** Last register */
     PLFRAME_PDEF_LAST_REG = PLFRAME_ARM_CPSR
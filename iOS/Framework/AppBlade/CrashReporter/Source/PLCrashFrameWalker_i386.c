@@ -45,6 +45,7 @@ plframe_error_t plframe_cursor_init (plframe_cursor_t *cursor, ucontext_t *uap)
     cursor->uap = uap;
     cursor->init_frame = true;
     cursor->fp[0] = NULL;
+    cursor->read_failures = 0;
 
     return PLFRAME_ESUCCESS;
 }
@@ -121,8 +122,10 @@ plframe_error_t plframe_cursor_next (plframe_cursor_t *cursor) {
     }
     
     /* Was the read successful? */
-    if (kr != KERN_SUCCESS)
+    if (kr != KERN_SUCCESS) {
+        cursor->read_failures++;
         return PLFRAME_EBADFRAME;
+    }
     
     /* Check for completion */
     if (cursor->fp[0] == NULL)
@@ -97,6 +97,8 @@ typedef enum {
     PLFRAME_X86_GS,
 
     PLFRAME_PDEF_REG_IP = PLFRAME_X86_EIP,
+
+    PLFRAME_PDEF_REG_SP = PLFRAME_X86_ESP,
     
     /** Last register */
     PLFRAME_PDEF_LAST_REG = PLFRAME_X86_GS
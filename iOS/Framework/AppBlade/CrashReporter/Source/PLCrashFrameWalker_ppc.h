@@ -99,6 +99,8 @@ typedef enum {
 
     
     PLFRAME_PDEF_REG_IP = PLFRAME_PPC_SRR0,
+
+    PLFRAME_PDEF_REG_SP = PLFRAME_PPC_R1,
     
     /* Last register */
     PLFRAME_PDEF_LAST_REG = PLFRAME_PPC_VRSAVE
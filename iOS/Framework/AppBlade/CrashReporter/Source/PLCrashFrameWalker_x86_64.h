@@ -107,6 +107,8 @@ typedef enum {
 
     PLFRAME_PDEF_REG_IP = PLFRAME_X86_64_RIP,
 
+    PLFRAME_PDEF_REG_SP = PLFRAME_X86_64_RSP,
+
     /** Last register */
     PLFRAME_PDEF_LAST_REG = PLFRAME_X86_64_GS
 } plframe_x86_64_regnum_t;
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2008-2011 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "PLCrashHostInfo.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @ingroup plcrash_host_info
+ * @{
+ */
+
+/**
+ * Return the host information provider for the current platform, or NULL if the platform is not supported.
+ */
+const plcrash_host_info_provider_t *plcrash_host_info_default_provider (void) {
+#if defined(__APPLE__)
+    return &plcrash_host_info_darwin_provider;
+#elif defined(__linux__)
+    return &plcrash_host_info_linux_provider;
+#else
+    return NULL;
+#endif
+}
+
+/**
+ * Gather the host information.
+ *
+ * @param info The host information to be initialized.
+ * @param provider The provider to gather the information from, or NULL to use
+ * plcrash_host_info_default_provider().
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, PLCRASH_ENOTSUP if no provider is available for the current platform,
+ * or the provider's error on failure.
+ *
+ * @note If this function fails, plcrash_host_info_free() should be called to free any partially gathered data.
+ *
+ * @warning This function is not async-safe.
+ */
+plcrash_error_t plcrash_host_info_init (plcrash_host_info_t *info, const plcrash_host_info_provider_t *provider) {
+    memset(info, 0, sizeof(*info));
+    info->operating_system = PLCRASH_REPORT_OS_UNKNOWN;
+    info->process_info.native = true;
+
+    if (provider == NULL)
+        provider = plcrash_host_info_default_provider();
+    if (provider == NULL)
+        return PLCRASH_ENOTSUP;
+
+    return provider->gather(info);
+}
+
+/**
+ * Free all storage associated with @a info. It is safe to call this function on a zero-initialized value.
+ *
+ * @param info The host information to free.
+ */
+void plcrash_host_info_free (plcrash_host_info_t *info) {
+    free(info->system_info.version);
+    free(info->system_info.build);
+    free(info->machine_info.model);
+    free(info->process_info.process_name);
+    free(info->process_info.process_path);
+    free(info->process_info.parent_process_name);
+    memset(info, 0, sizeof(*info));
+}
+
+/**
+ * @} plcrash_host_info
+ */
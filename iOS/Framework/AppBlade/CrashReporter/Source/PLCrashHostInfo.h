@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2008-2011 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef PLCRASH_HOST_INFO_H
+#define PLCRASH_HOST_INFO_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#import "PLCrashAsync.h"
+#include "PLCrashReportCore.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @internal
+ * @defgroup plcrash_host_info Host Information
+ * @ingroup plcrash_host
+ *
+ * The system, machine and process information written to each crash report. It is gathered once, by a
+ * platform-specific provider, when the crash log writer is initialized; nothing is gathered on the crash path.
+ *
+ * Providers are available for Darwin (Mac OS X and iOS, using sysctl and the platform's version APIs) and Linux
+ * (using uname(), /proc and sysconf()). plcrash_host_info_default_provider() returns the provider for the host;
+ * another provider may be passed to plcrash_host_info_init() explicitly.
+ *
+ * @{
+ */
+
+/**
+ * Host information. All strings are malloc-allocated, and freed by plcrash_host_info_free().
+ */
+typedef struct plcrash_host_info {
+    /** The host operating system */
+    plcrash_report_os_t operating_system;
+
+    /** System data */
+    struct {
+        /** The host OS version. */
+        char *version;
+
+        /** The host OS build number. This may be NULL. */
+        char *build;
+    } system_info;
+
+    /** Machine data */
+    struct {
+        /** The host model (may be NULL). */
+        char *model;
+
+        /** The host CPU type, as a Mach CPU type. */
+        uint64_t cpu_type;
+
+        /** The host CPU subtype, as a Mach CPU subtype. */
+        uint64_t cpu_subtype;
+
+        /** The total number of physical cores */
+        uint32_t processor_count;
+
+        /** The total number of logical cores */
+        uint32_t logical_processor_count;
+    } machine_info;
+
+    /** Process data */
+    struct {
+        /** Process name (may be null) */
+        char *process_name;
+
+        /** Process ID */
+        pid_t process_id;
+
+        /** Process path (may be null) */
+        char *process_path;
+
+        /** Parent process name (may be null) */
+        char *parent_process_name;
+
+        /** Parent process ID */
+        pid_t parent_process_id;
+
+        /** If false, the reporting process is being run under process emulation (such as Rosetta). */
+        bool native;
+    } process_info;
+} plcrash_host_info_t;
+
+/**
+ * A host information provider.
+ */
+typedef struct plcrash_host_info_provider {
+    /** Provider name */
+    const char *name;
+
+    /**
+     * Populate a zero-initialized @a info. Information that is unavailable is left unset, and does not cause the
+     * provider to fail.
+     *
+     * @return Returns PLCRASH_ESUCCESS on success, or an error if information required by the crash report
+     * (the OS version) could not be determined.
+     */
+    plcrash_error_t (*gather) (plcrash_host_info_t *info);
+} plcrash_host_info_provider_t;
+
+#ifdef __APPLE__
+extern const plcrash_host_info_provider_t plcrash_host_info_darwin_provider;
+#endif
+
+#ifdef __linux__
+extern const plcrash_host_info_provider_t plcrash_host_info_linux_provider;
+#endif
+
+const plcrash_host_info_provider_t *plcrash_host_info_default_provider (void);
+
+plcrash_error_t plcrash_host_info_init (plcrash_host_info_t *info, const plcrash_host_info_provider_t *provider);
+void plcrash_host_info_free (plcrash_host_info_t *info);
+
+/**
+ * @} plcrash_host_info
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PLCRASH_HOST_INFO_H */
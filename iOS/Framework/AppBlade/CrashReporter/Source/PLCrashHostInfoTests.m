@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2008-2011 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "GTMSenTestCase.h"
+
+#import "GTMSenTestCase.h"
+
+#import "PLCrashHostInfo.h"
+#import "PLCrashReportSystemInfo.h"
+
+@interface PLCrashHostInfoTests : SenTestCase @end
+
+/* Provider used to verify that an explicitly supplied provider is used in place of the default */
+static plcrash_error_t test_gather (plcrash_host_info_t *info) {
+    info->operating_system = PLCRASH_REPORT_OS_LINUX;
+    info->system_info.version = strdup("1.2.3");
+    info->process_info.process_id = 42;
+    return PLCRASH_ESUCCESS;
+}
+
+static const plcrash_host_info_provider_t test_provider = {
+    .name = "test",
+    .gather = test_gather
+};
+
+/* Provider that fails */
+static plcrash_error_t failing_gather (plcrash_host_info_t *info) {
+    return PLCRASH_EINTERNAL;
+}
+
+static const plcrash_host_info_provider_t failing_provider = {
+    .name = "failing",
+    .gather = failing_gather
+};
+
+@implementation PLCrashHostInfoTests
+
+/* Test gathering host information with the default provider */
+- (void) testDefaultProvider {
+    plcrash_host_info_t info;
+
+    STAssertNotNULL(plcrash_host_info_default_provider(), @"No provider for the host");
+    STAssertEquals(plcrash_host_info_init(&info, NULL), PLCRASH_ESUCCESS, @"Failed to gather host info");
+
+    STAssertEquals((PLCrashReportOperatingSystem) info.operating_system, PLCrashReportHostOperatingSystem, @"Incorrect OS");
+    STAssertNotNULL(info.system_info.version, @"No OS version");
+    STAssertNotNULL(info.machine_info.model, @"No model");
+    STAssertTrue(info.machine_info.logical_processor_count > 0, @"No logical processors");
+    STAssertTrue(info.machine_info.processor_count > 0, @"No physical processors");
+
+    STAssertEquals(info.process_info.process_id, getpid(), @"Incorrect pid");
+    STAssertEquals(info.process_info.parent_process_id, getppid(), @"Incorrect parent pid");
+    STAssertNotNULL(info.process_info.process_name, @"No process name");
+    STAssertNotNULL(info.process_info.process_path, @"No process path");
+
+    plcrash_host_info_free(&info);
+}
+
+/* Test that an explicitly supplied provider is used */
+- (void) testCustomProvider {
+    plcrash_host_info_t info;
+
+    STAssertEquals(plcrash_host_info_init(&info, &test_provider), PLCRASH_ESUCCESS, @"Failed to gather host info");
+    STAssertEquals(info.operating_system, (plcrash_report_os_t) PLCRASH_REPORT_OS_LINUX, @"Provider was not used");
+    STAssertEqualCStrings(info.system_info.version, "1.2.3", @"Incorrect OS version");
+    STAssertEquals(info.process_info.process_id, (pid_t) 42, @"Incorrect pid");
+
+    /* Fields the provider does not set are left empty */
+    STAssertNULL(info.system_info.build, @"Unexpected OS build");
+    STAssertNULL(info.process_info.process_path, @"Unexpected process path");
+
+    plcrash_host_info_free(&info);
+}
+
+/* Test that a provider's error is returned */
+- (void) testProviderFailure {
+    plcrash_host_info_t info;
+
+    STAssertEquals(plcrash_host_info_init(&info, &failing_provider), PLCRASH_EINTERNAL, @"Provider error was not returned");
+    plcrash_host_info_free(&info);
+}
+
+@end
@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) 2008-2011 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#import "PLCrashHostInfo.h"
+#import "PLCrashSysctl.h"
+
+#import <stdlib.h>
+#import <string.h>
+#import <errno.h>
+#import <unistd.h>
+#import <inttypes.h>
+
+#import <sys/sysctl.h>
+#import <mach-o/dyld.h>
+
+#import <TargetConditionals.h>
+
+#if TARGET_OS_IPHONE
+#import <UIKit/UIKit.h> // For UIDevice
+#endif
+
+/**
+ * @ingroup plcrash_host_info
+ * @{
+ */
+
+/**
+ * @internal
+ * Gather the host information from sysctl and the platform's version APIs.
+ */
+static plcrash_error_t plcrash_host_info_darwin_gather (plcrash_host_info_t *info) {
+    /* Operating system */
+#if TARGET_IPHONE_SIMULATOR
+    info->operating_system = PLCRASH_REPORT_OS_IPHONE_SIMULATOR;
+#elif TARGET_OS_IPHONE
+    info->operating_system = PLCRASH_REPORT_OS_IPHONE_OS;
+#else
+    info->operating_system = PLCRASH_REPORT_OS_MAC_OS_X;
+#endif
+
+    /* Fetch the process information */
+    {
+        /* MIB used to fetch process info */
+        struct kinfo_proc process_info;
+        size_t process_info_len = sizeof(process_info);
+        int process_info_mib[4] = { CTL_KERN, KERN_PROC, KERN_PROC_PID, 0 };
+        int process_info_mib_len = 4;
+
+        /* Current process */
+        {            
+            /* Retrieve PID */
+            info->process_info.process_id = getpid();
+
+            /* Retrieve name */
+            process_info_mib[3] = info->process_info.process_id;
+            if (sysctl(process_info_mib, process_info_mib_len, &process_info, &process_info_len, NULL, 0) == 0) {
+                info->process_info.process_name = strdup(process_info.kp_proc.p_comm);
+            } else {
+                PLCF_DEBUG("Could not retreive process name: %s", strerror(errno));
+            }
+
+            /* Retrieve path */
+            char *process_path = NULL;
+            uint32_t process_path_len = 0;
+
+            _NSGetExecutablePath(NULL, &process_path_len);
+            if (process_path_len > 0) {
+                process_path = malloc(process_path_len);
+                _NSGetExecutablePath(process_path, &process_path_len);
+                info->process_info.process_path = process_path;
+            }
+        }
+
+        /* Parent process */
+        {            
+            /* Retrieve PID */
+            info->process_info.parent_process_id = getppid();
+
+            /* Retrieve name */
+            process_info_mib[3] = info->process_info.parent_process_id;
+            if (sysctl(process_info_mib, process_info_mib_len, &process_info, &process_info_len, NULL, 0) == 0) {
+                info->process_info.parent_process_name = strdup(process_info.kp_proc.p_comm);
+            } else {
+                PLCF_DEBUG("Could not retreive parent process name: %s", strerror(errno));
+            }
+
+        }
+    }
+
+    /* Fetch the machine information */
+    {
+        /* Model */
+#if TARGET_OS_IPHONE
+        /* On iOS, we want hw.machine (e.g. hw.machine = iPad2,1; hw.model = K93AP) */
+        info->machine_info.model = plcrash_sysctl_string("hw.machine");
+#else
+        /* On Mac OS X, we want hw.model (e.g. hw.machine = x86_64; hw.model = Macmini5,3) */
+        info->machine_info.model = plcrash_sysctl_string("hw.model");
+#endif
+        if (info->machine_info.model == NULL) {
+            PLCF_DEBUG("Could not retrive hw.model: %s", strerror(errno));
+        }
+        
+        /* CPU */
+        {
+            int retval;
+
+            /* Fetch the CPU types */
+            if (plcrash_sysctl_int("hw.cputype", &retval)) {
+                info->machine_info.cpu_type = retval;
+            } else {
+                PLCF_DEBUG("Could not retrive hw.cputype: %s", strerror(errno));
+            }
+            
+            if (plcrash_sysctl_int("hw.cpusubtype", &retval)) {
+                info->machine_info.cpu_subtype = retval;
+            } else {
+                PLCF_DEBUG("Could not retrive hw.cpusubtype: %s", strerror(errno));
+            }
+
+            /* Processor count */
+            if (plcrash_sysctl_int("hw.physicalcpu_max", &retval)) {
+                info->machine_info.processor_count = retval;
+            } else {
+                PLCF_DEBUG("Could not retrive hw.physicalcpu_max: %s", strerror(errno));
+            }
+
+            if (plcrash_sysctl_int("hw.logicalcpu_max", &retval)) {
+                info->machine_info.logical_processor_count = retval;
+            } else {
+                PLCF_DEBUG("Could not retrive hw.logicalcpu_max: %s", strerror(errno));
+            }
+        }
+        
+        /*
+         * Check if the process is emulated. This sysctl is defined in the Universal Binary Programming Guidelines,
+         * Second Edition:
+         *
+         * http://developer.apple.com/legacy/mac/library/documentation/MacOSX/Conceptual/universal_binary/universal_binary.pdf
+         */
+        {
+            int retval;
+
+            if (plcrash_sysctl_int("sysctl.proc_native", &retval)) {
+                if (retval == 0) {
+                    info->process_info.native = false;
+                } else {
+                    info->process_info.native = true;
+                }
+            } else {
+                /* If the sysctl is not available, the process can be assumed to be native. */
+                info->process_info.native = true;
+            }
+        }
+    }
+
+    /* Fetch the OS information */    
+    info->system_info.build = plcrash_sysctl_string("kern.osversion");
+    if (info->system_info.build == NULL) {
+        PLCF_DEBUG("Could not retrive kern.osversion: %s", strerror(errno));
+    }
+
+#if TARGET_OS_IPHONE
+    /* iPhone OS */
+    info->system_info.version = strdup([[[UIDevice currentDevice] systemVersion] UTF8String]);
+#elif TARGET_OS_MAC
+    /* Mac OS X */
+    {
+        SInt32 major, minor, bugfix;
+
+        /* Fetch the major, minor, and bugfix versions.
+         * Fetching the OS version should not fail. */
+        if (Gestalt(gestaltSystemVersionMajor, &major) != noErr) {
+            PLCF_DEBUG("Could not retreive system major version with Gestalt");
+            return PLCRASH_EINTERNAL;
+        }
+        if (Gestalt(gestaltSystemVersionMinor, &minor) != noErr) {
+            PLCF_DEBUG("Could not retreive system minor version with Gestalt");
+            return PLCRASH_EINTERNAL;
+        }
+        if (Gestalt(gestaltSystemVersionBugFix, &bugfix) != noErr) {
+            PLCF_DEBUG("Could not retreive system bugfix version with Gestalt");
+            return PLCRASH_EINTERNAL;
+        }
+
+        /* Compose the string */
+        asprintf(&info->system_info.version, "%" PRId32 ".%" PRId32 ".%" PRId32, (int32_t)major, (int32_t)minor, (int32_t)bugfix);
+    }
+#else
+#error Unsupported Platform
+#endif
+
+    return PLCRASH_ESUCCESS;
+}
+
+/** Darwin host information provider */
+const plcrash_host_info_provider_t plcrash_host_info_darwin_provider = {
+    .name = "darwin",
+    .gather = plcrash_host_info_darwin_gather
+};
+
+/**
+ * @} plcrash_host_info
+ */
@@ -0,0 +1,281 @@
+/*
+ * Copyright (c) 2008-2011 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "PLCrashHostInfo.h"
+
+#ifdef __linux__
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/utsname.h>
+
+/**
+ * @ingroup plcrash_host_info
+ * @{
+ */
+
+/* Maximum number of distinct physical packages counted from /proc/cpuinfo */
+#define CPUINFO_MAX_PACKAGES 64
+
+/**
+ * @internal
+ * Read the first line of a small file, such as /proc/self/comm, without its trailing newline.
+ *
+ * @return Returns a malloc-allocated string, or NULL if the file could not be read.
+ */
+static char *linux_read_line (const char *path) {
+    char buf[256];
+    size_t length;
+    FILE *fp;
+
+    if ((fp = fopen(path, "r")) == NULL) {
+        PLCF_DEBUG("Could not open %s: %s", path, strerror(errno));
+        return NULL;
+    }
+
+    if (fgets(buf, sizeof(buf), fp) == NULL) {
+        fclose(fp);
+        return NULL;
+    }
+    fclose(fp);
+
+    length = strcspn(buf, "\n");
+    return strndup(buf, length);
+}
+
+/**
+ * @internal
+ * Read the target of a symbolic link, such as /proc/self/exe.
+ *
+ * @return Returns a malloc-allocated string, or NULL if the link could not be read.
+ */
+static char *linux_read_link (const char *path) {
+    size_t size = 256;
+    char *buf = NULL;
+
+    /* readlink() truncates silently; grow the buffer until the target fits */
+    for (;;) {
+        char *grown = realloc(buf, size);
+        ssize_t length;
+
+        if (grown == NULL) {
+            free(buf);
+            return NULL;
+        }
+        buf = grown;
+
+        length = readlink(path, buf, size);
+        if (length < 0) {
+            PLCF_DEBUG("Could not read %s: %s", path, strerror(errno));
+            free(buf);
+            return NULL;
+        }
+
+        if ((size_t) length < size) {
+            buf[length] = '\0';
+            return buf;
+        }
+        size *= 2;
+    }
+}
+
+/**
+ * @internal
+ * Map a uname() machine name to the equivalent Mach CPU type and subtype, so that reports from Linux hosts are
+ * formatted and symbolicated like those from Darwin hosts. Unrecognized machines are left as zero.
+ */
+static void linux_cpu_type (const char *machine, uint64_t *type, uint64_t *subtype) {
+    if (strcmp(machine, "x86_64") == 0) {
+        *type = PLCRASH_REPORT_MACH_CPU_TYPE_X86_64;
+        *subtype = PLCRASH_REPORT_MACH_CPU_SUBTYPE_X86_ALL;
+    } else if (machine[0] == 'i' && strcmp(machine + 2, "86") == 0) {
+        *type = PLCRASH_REPORT_MACH_CPU_TYPE_X86;
+        *subtype = PLCRASH_REPORT_MACH_CPU_SUBTYPE_X86_ALL;
+    } else if (strcmp(machine, "aarch64") == 0) {
+        *type = PLCRASH_REPORT_MACH_CPU_TYPE_ARM64;
+        *subtype = 0;
+    } else if (strncmp(machine, "armv7", 5) == 0) {
+        *type = PLCRASH_REPORT_MACH_CPU_TYPE_ARM;
+        *subtype = PLCRASH_REPORT_MACH_CPU_SUBTYPE_ARM_V7;
+    } else if (strncmp(machine, "armv6", 5) == 0) {
+        *type = PLCRASH_REPORT_MACH_CPU_TYPE_ARM;
+        *subtype = PLCRASH_REPORT_MACH_CPU_SUBTYPE_ARM_V6;
+    } else if (strncmp(machine, "arm", 3) == 0) {
+        *type = PLCRASH_REPORT_MACH_CPU_TYPE_ARM;
+        *subtype = 0;
+    } else if (strcmp(machine, "ppc64") == 0 || strcmp(machine, "ppc64le") == 0) {
+        *type = PLCRASH_REPORT_MACH_CPU_TYPE_POWERPC64;
+        *subtype = 0;
+    } else if (strcmp(machine, "ppc") == 0) {
+        *type = PLCRASH_REPORT_MACH_CPU_TYPE_POWERPC;
+        *subtype = 0;
+    }
+}
+
+/**
+ * @internal
+ * Read the machine model and the number of physical cores from /proc/cpuinfo.
+ *
+ * The model is the board model reported by ARM kernels ("Model", or "Hardware" on older kernels) if present,
+ * and otherwise the processor's model name. Physical cores are counted as the number of distinct physical
+ * packages multiplied by the cores per package; kernels that do not report packages leave the count unset.
+ */
+static void linux_read_cpuinfo (plcrash_host_info_t *info) {
+    long packages[CPUINFO_MAX_PACKAGES];
+    size_t package_count = 0;
+    long cores_per_package = 0;
+    char *model = NULL;
+    int model_rank = 0;
+    char *line = NULL;
+    size_t capacity = 0;
+    FILE *fp;
+
+    if ((fp = fopen("/proc/cpuinfo", "r")) == NULL) {
+        PLCF_DEBUG("Could not open /proc/cpuinfo: %s", strerror(errno));
+        return;
+    }
+
+    while (getline(&line, &capacity, fp) > 0) {
+        char *sep = strchr(line, ':');
+        char *value;
+        size_t key_length;
+        int rank = 0;
+
+        if (sep == NULL)
+            continue;
+
+        /* "key<tabs>: value" */
+        key_length = (size_t) (sep - line);
+        while (key_length > 0 && (line[key_length - 1] == '\t' || line[key_length - 1] == ' '))
+            key_length--;
+        value = sep + 1;
+        value += strspn(value, " \t");
+        value[strcspn(value, "\n")] = '\0';
+
+        if (key_length == 11 && strncmp(line, "physical id", 11) == 0) {
+            long id = strtol(value, NULL, 10);
+            size_t i;
+
+            for (i = 0; i < package_count && packages[i] != id; i++)
+                ;
+            if (i == package_count && package_count < CPUINFO_MAX_PACKAGES)
+                packages[package_count++] = id;
+        } else if (key_length == 9 && strncmp(line, "cpu cores", 9) == 0) {
+            cores_per_package = strtol(value, NULL, 10);
+        } else if (key_length == 5 && strncmp(line, "Model", 5) == 0) {
+            rank = 3;
+        } else if (key_length == 8 && strncmp(line, "Hardware", 8) == 0) {
+            rank = 2;
+        } else if (key_length == 10 && strncmp(line, "model name", 10) == 0) {
+            rank = 1;
+        }
+
+        if (rank > model_rank && *value != '\0') {
+            char *copy = strdup(value);
+            if (copy != NULL) {
+                free(model);
+                model = copy;
+                model_rank = rank;
+            }
+        }
+    }
+
+    free(line);
+    fclose(fp);
+
+    info->machine_info.model = model;
+    if (package_count > 0 && cores_per_package > 0)
+        info->machine_info.processor_count = (uint32_t) (package_count * (size_t) cores_per_package);
+}
+
+/**
+ * @internal
+ * Gather the host information from uname(), /proc and sysconf().
+ */
+static plcrash_error_t plcrash_host_info_linux_gather (plcrash_host_info_t *info) {
+    struct utsname name;
+    char path[64];
+    long count;
+
+    info->operating_system = PLCRASH_REPORT_OS_LINUX;
+
+    /* Fetch the OS information. The kernel release is the closest equivalent of the OS version, and its build
+     * string the closest equivalent of the OS build. */
+    if (uname(&name) != 0) {
+        PLCF_DEBUG("Could not retrieve uname: %s", strerror(errno));
+        return PLCRASH_EINTERNAL;
+    }
+
+    info->system_info.version = strdup(name.release);
+    info->system_info.build = strdup(name.version);
+    if (info->system_info.version == NULL)
+        return PLCRASH_ENOMEM;
+
+    /* Fetch the machine information */
+    linux_cpu_type(name.machine, &info->machine_info.cpu_type, &info->machine_info.cpu_subtype);
+    linux_read_cpuinfo(info);
+
+    count = sysconf(_SC_NPROCESSORS_CONF);
+    if (count > 0) {
+        info->machine_info.logical_processor_count = (uint32_t) count;
+    } else {
+        PLCF_DEBUG("Could not retrieve the processor count: %s", strerror(errno));
+    }
+
+    /* Without package information, assume one logical processor per core */
+    if (info->machine_info.processor_count == 0)
+        info->machine_info.processor_count = info->machine_info.logical_processor_count;
+
+    /* Fetch the process information */
+    info->process_info.process_id = getpid();
+    info->process_info.process_name = linux_read_line("/proc/self/comm");
+    info->process_info.process_path = linux_read_link("/proc/self/exe");
+
+    info->process_info.parent_process_id = getppid();
+    snprintf(path, sizeof(path), "/proc/%ld/comm", (long) info->process_info.parent_process_id);
+    info->process_info.parent_process_name = linux_read_line(path);
+
+    /* Process emulation is not detected */
+    info->process_info.native = true;
+
+    return PLCRASH_ESUCCESS;
+}
+
+/** Linux host information provider */
+const plcrash_host_info_provider_t plcrash_host_info_linux_provider = {
+    .name = "linux",
+    .gather = plcrash_host_info_linux_gather
+};
+
+/**
+ * @} plcrash_host_info
+ */
+
+#endif /* __linux__ */
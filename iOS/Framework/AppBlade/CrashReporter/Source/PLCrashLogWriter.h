@@ -31,6 +31,9 @@
 
 #import "PLCrashAsync.h"
 #import "PLCrashAsyncImage.h"
+#import "PLCrashHostInfo.h"
+
+#import <mach/mach_time.h>
 
 /**
  * @internal
@@ -43,38 +46,61 @@
  * @{
  */
 
+/**
+ * @internal
+ * Maximum number of distinct stack pages that will be written to a single crash report.
+ */
+#define PLCRASH_LOG_WRITER_STACK_MAX_PAGES 32
+
+/**
+ * @internal
+ * Maximum number of crashed thread frames considered when selecting the binary images to be written first in
+ * prioritized mode.
+ */
+#define PLCRASH_LOG_WRITER_PRIORITY_MAX_FRAMES 128
+
+/**
+ * @internal
+ * Maximum number of binary images that will be written first in prioritized mode.
+ */
+#define PLCRASH_LOG_WRITER_PRIORITY_MAX_IMAGES 32
+
+/**
+ * @internal
+ * Maximum number of threads for which individual writer statistics will be recorded.
+ */
+#define PLCRASH_LOG_WRITER_STATS_MAX_THREADS 64
+
 /**
  * @internal
  *
- * Crash log writer context.
+ * Per-thread crash log writer statistics. All times are in mach_absolute_time() units.
  */
-typedef struct plcrash_log_writer {
-    /** System data */
-    struct {
-        /** The host OS version. */
-        char *version;
+typedef struct plcrash_log_writer_thread_stats {
+    /** Thread number */
+    uint32_t thread_number;
 
-        /** The host OS build number. This may be NULL. */
-        char *build;
-    } system_info;
+    /** Time spent suspending the thread */
+    uint64_t suspend_time;
 
-    /* Machine data */
-    struct {
-        /** The host model (may be NULL). */
-        char *model;
+    /** Time spent in the sizing pass */
+    uint64_t walk_time;
 
-        /** The host CPU type. */
-        uint64_t cpu_type;
+    /** Time spent in the writing pass */
+    uint64_t write_time;
 
-        /** The host CPU subtype. */
-        uint64_t cpu_subtype;
-        
-        /** The total number of physical cores */
-        uint32_t processor_count;
-        
-        /** The total number of logical cores */
-        uint32_t logical_processor_count;
-    } machine_info;
+    /** True if the backtrace was truncated at the frame limit */
+    bool truncated;
+} plcrash_log_writer_thread_stats_t;
+
+/**
+ * @internal
+ *
+ * Crash log writer context.
+ */
+typedef struct plcrash_log_writer {
+    /** Host system, machine and process data */
+    plcrash_host_info_t host_info;
 
     /** Application data */
     struct {
@@ -85,27 +111,6 @@ typedef struct plcrash_log_writer {
         char *app_version;
     } application_info;
     
-    /** Process data */
-    struct {
-        /** Process name (may be null) */
-        char *process_name;
-        
-        /** Process ID */
-        pid_t process_id;
-        
-        /** Process path (may be null) */
-        char *process_path;
-        
-        /** Parent process name (may be null) */
-        char *parent_process_name;
-        
-        /** Parent process ID */
-        pid_t parent_process_id;
-        
-        /** If false, the reporting process is being run under process emulation (such as Rosetta). */
-        bool native;
-    } process_info;
-    
     /** Binary image data */
     struct {
         /** The list of the processes' loaded images, as provided by dyld. */
@@ -129,11 +134,117 @@ typedef struct plcrash_log_writer {
         /** Call stack frame count, or 0 if the call stack is unavailable */
         size_t callstack_count;
     } uncaught_exception;
+
+    /** Stack memory capture (disabled unless configured via plcrash_log_writer_set_stack_capture()) */
+    struct {
+        /** If true, raw stack memory will be captured */
+        bool enabled;
+
+        /** If true, stack memory will be captured for all threads, rather than just the crashed thread */
+        bool all_threads;
+
+        /** Number of bytes to capture below the stack pointer (eg, the red zone) */
+        uint32_t below_sp;
+
+        /** Number of bytes to capture at and above the stack pointer */
+        uint32_t above_sp;
+
+        /** Maximum number of stack bytes that will be written to a single crash report */
+        uint32_t budget;
+
+        /** Number of budgeted bytes consumed by the current crash report. */
+        uint32_t used;
+
+        /** Number of budgeted bytes held back for the crashed thread until its stack memory has been written. */
+        uint32_t reserved;
+
+        /** Number of pages held back for the crashed thread until its stack memory has been written. */
+        size_t reserved_pages;
+
+        /** Page-sized scratch buffer used when reading stack memory. Allocated at configuration time. */
+        uint8_t *buffer;
+
+        /** Size of the scratch buffer, and the granularity of page de-duplication. */
+        size_t page_size;
+
+        /** Base addresses of all pages written to the current crash report. */
+        uintptr_t pages[PLCRASH_LOG_WRITER_STACK_MAX_PAGES];
+
+        /** Number of valid entries in pages. */
+        size_t page_count;
+    } stack_memory;
+
+    /** Prioritized output (disabled unless configured via plcrash_log_writer_set_priority()) */
+    struct {
+        /** If true, the crashed thread and its images are written first, and the remainder is subject to the budgets. */
+        bool enabled;
+
+        /** Wall-clock budget, in mach_absolute_time() units, or 0 if unlimited. */
+        uint64_t deadline;
+
+        /** Maximum number of bytes to be written, or 0 if unlimited. */
+        size_t byte_budget;
+
+        /** Frame addresses recorded from the crashed thread while writing the current report. */
+        uintptr_t pcs[PLCRASH_LOG_WRITER_PRIORITY_MAX_FRAMES];
+
+        /** Number of valid entries in pcs. */
+        size_t pc_count;
+
+        /** Header addresses of the images already written for the current report. */
+        uintptr_t images[PLCRASH_LOG_WRITER_PRIORITY_MAX_IMAGES];
+
+        /** Number of valid entries in images. */
+        size_t image_count;
+    } priority;
+
+    /** Writer self-instrumentation. Statistics are always gathered, but are only written if enabled. */
+    struct {
+        /** If true, a writer_stats message will be written. */
+        bool enabled;
+
+        /** Timebase used to convert mach_absolute_time() values to nanoseconds. */
+        mach_timebase_info_data_t timebase;
+
+        /** Time spent parsing and writing binary images, in mach_absolute_time() units */
+        uint64_t image_time;
+
+        /** Number of failed memory reads while writing the current report (write pass only) */
+        uint32_t read_failures;
+
+        /** Number of threads whose backtrace was truncated at the frame limit */
+        uint32_t truncated_threads;
+
+        /** True if the most recently written thread's backtrace was truncated at the frame limit */
+        bool thread_truncated;
+
+        /** Bytes emitted per section */
+        struct {
+            uint32_t system_info;
+            uint32_t machine_info;
+            uint32_t application_info;
+            uint32_t process_info;
+            uint32_t threads;
+            uint32_t binary_images;
+            uint32_t exception;
+            uint32_t signal;
+        } bytes;
+
+        /** Per-thread statistics */
+        plcrash_log_writer_thread_stats_t threads[PLCRASH_LOG_WRITER_STATS_MAX_THREADS];
+
+        /** Number of valid entries in threads */
+        size_t thread_count;
+    } stats;
 } plcrash_log_writer_t;
 
 
 plcrash_error_t plcrash_log_writer_init (plcrash_log_writer_t *writer, NSString *app_identifier, NSString *app_version);
 void plcrash_log_writer_set_exception (plcrash_log_writer_t *writer, NSException *exception);
+plcrash_error_t plcrash_log_writer_set_stack_capture (plcrash_log_writer_t *writer, uint32_t below_sp, uint32_t above_sp,
+                                                      bool all_threads, uint32_t budget);
+void plcrash_log_writer_set_priority (plcrash_log_writer_t *writer, uint32_t deadline_ms, size_t byte_budget);
+void plcrash_log_writer_set_stats_enabled (plcrash_log_writer_t *writer, bool enabled);
 
 void plcrash_log_writer_add_image (plcrash_log_writer_t *writer, const void *header_addr);
 void plcrash_log_writer_remove_image (plcrash_log_writer_t *writer, const void *header_addr);
@@ -142,6 +253,8 @@ plcrash_error_t plcrash_log_writer_write (plcrash_log_writer_t *writer, plcrash_
 plcrash_error_t plcrash_log_writer_close (plcrash_log_writer_t *writer);
 void plcrash_log_writer_free (plcrash_log_writer_t *writer);
 
+plcrash_error_t plcrash_log_writer_write_test_report (thread_t thread, const char *path, bool extended);
+
 /**
  * @} plcrash_log_writer
  */
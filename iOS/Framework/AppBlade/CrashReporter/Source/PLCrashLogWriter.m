@@ -37,22 +37,18 @@
 #import <sys/time.h>
 
 #import <mach-o/dyld.h>
+#import <mach/mach_time.h>
 
 #import <libkern/OSAtomic.h>
 
 #import "PLCrashReport.h"
 #import "PLCrashLogWriter.h"
 #import "PLCrashLogWriterEncoding.h"
+#import "PLCrashReportEncoder.h"
 #import "PLCrashAsync.h"
 #import "PLCrashAsyncSignalInfo.h"
 #import "PLCrashFrameWalker.h"
 
-#import "PLCrashSysctl.h"
-
-#if TARGET_OS_IPHONE
-#import <UIKit/UIKit.h> // For UIDevice
-#endif
-
 /**
  * @internal
  * Maximum number of frames that will be written to the crash report for a single thread. Used as a safety measure
@@ -60,160 +56,6 @@
  */
 #define MAX_THREAD_FRAMES 512 // matches Apple's crash reporting on Snow Leopard
 
-/**
- * @internal
- * Protobuf Field IDs, as defined in crashreport.proto
- */
-enum {
-    /** CrashReport.system_info */
-    PLCRASH_PROTO_SYSTEM_INFO_ID = 1,
-
-    /** CrashReport.system_info.operating_system */
-    PLCRASH_PROTO_SYSTEM_INFO_OS_ID = 1,
-
-    /** CrashReport.system_info.os_version */
-    PLCRASH_PROTO_SYSTEM_INFO_OS_VERSION_ID = 2,
-
-    /** CrashReport.system_info.architecture */
-    PLCRASH_PROTO_SYSTEM_INFO_ARCHITECTURE_TYPE_ID = 3,
-
-    /** CrashReport.system_info.timestamp */
-    PLCRASH_PROTO_SYSTEM_INFO_TIMESTAMP_ID = 4,
-
-    /** CrashReport.system_info.os_build */
-    PLCRASH_PROTO_SYSTEM_INFO_OS_BUILD_ID = 5,
-
-    /** CrashReport.app_info */
-    PLCRASH_PROTO_APP_INFO_ID = 2,
-    
-    /** CrashReport.app_info.app_identifier */
-    PLCRASH_PROTO_APP_INFO_APP_IDENTIFIER_ID = 1,
-    
-    /** CrashReport.app_info.app_version */
-    PLCRASH_PROTO_APP_INFO_APP_VERSION_ID = 2,
-
-
-    /** CrashReport.threads */
-    PLCRASH_PROTO_THREADS_ID = 3,
-    
-
-    /** CrashReports.thread.thread_number */
-    PLCRASH_PROTO_THREAD_THREAD_NUMBER_ID = 1,
-
-    /** CrashReports.thread.frames */
-    PLCRASH_PROTO_THREAD_FRAMES_ID = 2,
-
-    /** CrashReport.thread.crashed */
-    PLCRASH_PROTO_THREAD_CRASHED_ID = 3,
-
-
-    /** CrashReport.thread.frame.pc */
-    PLCRASH_PROTO_THREAD_FRAME_PC_ID = 3,
-
-
-    /** CrashReport.thread.registers */
-    PLCRASH_PROTO_THREAD_REGISTERS_ID = 4,
-
-    /** CrashReport.thread.register.name */
-    PLCRASH_PROTO_THREAD_REGISTER_NAME_ID = 1,
-
-    /** CrashReport.thread.register.name */
-    PLCRASH_PROTO_THREAD_REGISTER_VALUE_ID = 2,
-
-
-    /** CrashReport.images */
-    PLCRASH_PROTO_BINARY_IMAGES_ID = 4,
-
-    /** CrashReport.BinaryImage.base_address */
-    PLCRASH_PROTO_BINARY_IMAGE_ADDR_ID = 1,
-
-    /** CrashReport.BinaryImage.size */
-    PLCRASH_PROTO_BINARY_IMAGE_SIZE_ID = 2,
-
-    /** CrashReport.BinaryImage.name */
-    PLCRASH_PROTO_BINARY_IMAGE_NAME_ID = 3,
-    
-    /** CrashReport.BinaryImage.uuid */
-    PLCRASH_PROTO_BINARY_IMAGE_UUID_ID = 4,
-
-    /** CrashReport.BinaryImage.code_type */
-    PLCRASH_PROTO_BINARY_IMAGE_CODE_TYPE_ID = 5,
-
-    
-    /** CrashReport.exception */
-    PLCRASH_PROTO_EXCEPTION_ID = 5,
-
-    /** CrashReport.exception.name */
-    PLCRASH_PROTO_EXCEPTION_NAME_ID = 1,
-    
-    /** CrashReport.exception.reason */
-    PLCRASH_PROTO_EXCEPTION_REASON_ID = 2,
-    
-    /** CrashReports.exception.frames */
-    PLCRASH_PROTO_EXCEPTION_FRAMES_ID = 3,
-
-
-    /** CrashReport.signal */
-    PLCRASH_PROTO_SIGNAL_ID = 6,
-
-    /** CrashReport.signal.name */
-    PLCRASH_PROTO_SIGNAL_NAME_ID = 1,
-
-    /** CrashReport.signal.code */
-    PLCRASH_PROTO_SIGNAL_CODE_ID = 2,
-    
-    /** CrashReport.signal.address */
-    PLCRASH_PROTO_SIGNAL_ADDRESS_ID = 3,
-    
-    
-    /** CrashReport.process_info */
-    PLCRASH_PROTO_PROCESS_INFO_ID = 7,
-    
-    /** CrashReport.process_info.process_name */
-    PLCRASH_PROTO_PROCESS_INFO_PROCESS_NAME_ID = 1,
-    
-    /** CrashReport.process_info.process_id */
-    PLCRASH_PROTO_PROCESS_INFO_PROCESS_ID_ID = 2,
-    
-    /** CrashReport.process_info.process_path */
-    PLCRASH_PROTO_PROCESS_INFO_PROCESS_PATH_ID = 3,
-    
-    /** CrashReport.process_info.parent_process_name */
-    PLCRASH_PROTO_PROCESS_INFO_PARENT_PROCESS_NAME_ID = 4,
-    
-    /** CrashReport.process_info.parent_process_id */
-    PLCRASH_PROTO_PROCESS_INFO_PARENT_PROCESS_ID_ID = 5,
-    
-    /** CrashReport.process_info.native */
-    PLCRASH_PROTO_PROCESS_INFO_NATIVE_ID = 6,
-
-    
-    /** CrashReport.Processor.encoding */
-    PLCRASH_PROTO_PROCESSOR_ENCODING_ID = 1,
-    
-    /** CrashReport.Processor.encoding */
-    PLCRASH_PROTO_PROCESSOR_TYPE_ID = 2,
-    
-    /** CrashReport.Processor.encoding */
-    PLCRASH_PROTO_PROCESSOR_SUBTYPE_ID = 3,
-
-
-    /** CrashReport.machine_info */
-    PLCRASH_PROTO_MACHINE_INFO_ID = 8,
-
-    /** CrashReport.machine_info.model */
-    PLCRASH_PROTO_MACHINE_INFO_MODEL_ID = 1,
-
-    /** CrashReport.machine_info.processor */
-    PLCRASH_PROTO_MACHINE_INFO_PROCESSOR_ID = 2,
-
-    /** CrashReport.machine_info.processor_count */
-    PLCRASH_PROTO_MACHINE_INFO_PROCESSOR_COUNT_ID = 3,
-
-    /** CrashReport.machine_info.logical_processor_count */
-    PLCRASH_PROTO_MACHINE_INFO_LOGICAL_PROCESSOR_COUNT_ID = 4,
-};
-
 /**
  * Initialize a new crash log writer instance and issue a memory barrier upon completion. This fetches all necessary
  * environment information.
@@ -237,158 +79,15 @@ plcrash_error_t plcrash_log_writer_init (plcrash_log_writer_t *writer, NSString
         writer->application_info.app_version = strdup([app_version UTF8String]);
     }
     
-    /* Fetch the process information */
+    /* Fetch the host information */
     {
-        /* MIB used to fetch process info */
-        struct kinfo_proc process_info;
-        size_t process_info_len = sizeof(process_info);
-        int process_info_mib[4] = { CTL_KERN, KERN_PROC, KERN_PROC_PID, 0 };
-        int process_info_mib_len = 4;
-
-        /* Current process */
-        {            
-            /* Retrieve PID */
-            writer->process_info.process_id = getpid();
-
-            /* Retrieve name */
-            process_info_mib[3] = writer->process_info.process_id;
-            if (sysctl(process_info_mib, process_info_mib_len, &process_info, &process_info_len, NULL, 0) == 0) {
-                writer->process_info.process_name = strdup(process_info.kp_proc.p_comm);
-            } else {
-                PLCF_DEBUG("Could not retreive process name: %s", strerror(errno));
-            }
-
-            /* Retrieve path */
-            char *process_path = NULL;
-            uint32_t process_path_len = 0;
-
-            _NSGetExecutablePath(NULL, &process_path_len);
-            if (process_path_len > 0) {
-                process_path = malloc(process_path_len);
-                _NSGetExecutablePath(process_path, &process_path_len);
-                writer->process_info.process_path = process_path;
-            }
-        }
-
-        /* Parent process */
-        {            
-            /* Retrieve PID */
-            writer->process_info.parent_process_id = getppid();
-
-            /* Retrieve name */
-            process_info_mib[3] = writer->process_info.parent_process_id;
-            if (sysctl(process_info_mib, process_info_mib_len, &process_info, &process_info_len, NULL, 0) == 0) {
-                writer->process_info.parent_process_name = strdup(process_info.kp_proc.p_comm);
-            } else {
-                PLCF_DEBUG("Could not retreive parent process name: %s", strerror(errno));
-            }
-
-        }
-    }
-
-    /* Fetch the machine information */
-    {
-        /* Model */
-#if TARGET_OS_IPHONE
-        /* On iOS, we want hw.machine (e.g. hw.machine = iPad2,1; hw.model = K93AP) */
-        writer->machine_info.model = plcrash_sysctl_string("hw.machine");
-#else
-        /* On Mac OS X, we want hw.model (e.g. hw.machine = x86_64; hw.model = Macmini5,3) */
-        writer->machine_info.model = plcrash_sysctl_string("hw.model");
-#endif
-        if (writer->machine_info.model == NULL) {
-            PLCF_DEBUG("Could not retrive hw.model: %s", strerror(errno));
-        }
-        
-        /* CPU */
-        {
-            int retval;
-
-            /* Fetch the CPU types */
-            if (plcrash_sysctl_int("hw.cputype", &retval)) {
-                writer->machine_info.cpu_type = retval;
-            } else {
-                PLCF_DEBUG("Could not retrive hw.cputype: %s", strerror(errno));
-            }
-            
-            if (plcrash_sysctl_int("hw.cpusubtype", &retval)) {
-                writer->machine_info.cpu_subtype = retval;
-            } else {
-                PLCF_DEBUG("Could not retrive hw.cpusubtype: %s", strerror(errno));
-            }
-
-            /* Processor count */
-            if (plcrash_sysctl_int("hw.physicalcpu_max", &retval)) {
-                writer->machine_info.processor_count = retval;
-            } else {
-                PLCF_DEBUG("Could not retrive hw.physicalcpu_max: %s", strerror(errno));
-            }
-
-            if (plcrash_sysctl_int("hw.logicalcpu_max", &retval)) {
-                writer->machine_info.logical_processor_count = retval;
-            } else {
-                PLCF_DEBUG("Could not retrive hw.logicalcpu_max: %s", strerror(errno));
-            }
+        plcrash_error_t err = plcrash_host_info_init(&writer->host_info, NULL);
+        if (err != PLCRASH_ESUCCESS) {
+            PLCF_DEBUG("Could not gather the host information: %s", plcrash_strerror(err));
+            return err;
         }
-        
-        /*
-         * Check if the process is emulated. This sysctl is defined in the Universal Binary Programming Guidelines,
-         * Second Edition:
-         *
-         * http://developer.apple.com/legacy/mac/library/documentation/MacOSX/Conceptual/universal_binary/universal_binary.pdf
-         */
-        {
-            int retval;
-
-            if (plcrash_sysctl_int("sysctl.proc_native", &retval)) {
-                if (retval == 0) {
-                    writer->process_info.native = false;
-                } else {
-                    writer->process_info.native = true;
-                }
-            } else {
-                /* If the sysctl is not available, the process can be assumed to be native. */
-                writer->process_info.native = true;
-            }
-        }
-    }
-
-    /* Fetch the OS information */    
-    writer->system_info.build = plcrash_sysctl_string("kern.osversion");
-    if (writer->system_info.build == NULL) {
-        PLCF_DEBUG("Could not retrive kern.osversion: %s", strerror(errno));
     }
 
-#if TARGET_OS_IPHONE
-    /* iPhone OS */
-    writer->system_info.version = strdup([[[UIDevice currentDevice] systemVersion] UTF8String]);
-#elif TARGET_OS_MAC
-    /* Mac OS X */
-    {
-        SInt32 major, minor, bugfix;
-
-        /* Fetch the major, minor, and bugfix versions.
-         * Fetching the OS version should not fail. */
-        if (Gestalt(gestaltSystemVersionMajor, &major) != noErr) {
-            PLCF_DEBUG("Could not retreive system major version with Gestalt");
-            return PLCRASH_EINTERNAL;
-        }
-        if (Gestalt(gestaltSystemVersionMinor, &minor) != noErr) {
-            PLCF_DEBUG("Could not retreive system minor version with Gestalt");
-            return PLCRASH_EINTERNAL;
-        }
-        if (Gestalt(gestaltSystemVersionBugFix, &bugfix) != noErr) {
-            PLCF_DEBUG("Could not retreive system bugfix version with Gestalt");
-            return PLCRASH_EINTERNAL;
-        }
-
-        /* Compose the string */
-        asprintf(&writer->system_info.version, "%" PRId32 ".%" PRId32 ".%" PRId32, (int32_t)major, (int32_t)minor, (int32_t)bugfix);
-    }
-#else
-#error Unsupported Platform
-#endif
-    
     /* Initialize the image info list. */
     plcrash_async_image_list_init(&writer->image_info.image_list);
 
@@ -464,6 +163,99 @@ void plcrash_log_writer_set_exception (plcrash_log_writer_t *writer, NSException
     OSMemoryBarrier();
 }
 
+/**
+ * Enable capture of raw stack memory surrounding each thread's stack pointer. Memory is read in page-bounded
+ * chunks, and any page that has already been written to the report will not be written again.
+ *
+ * @param writer The writer to configure.
+ * @param below_sp Number of bytes to capture below the stack pointer (eg, the ABI's red zone).
+ * @param above_sp Number of bytes to capture at and above the stack pointer.
+ * @param all_threads If true, stack memory will be captured for all threads. Otherwise, only the crashed
+ * thread's stack memory will be written.
+ * @param budget The maximum total number of stack bytes to be written to a single crash report. Crash reports
+ * are size-limited; this value should be kept small relative to that limit.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, PLCRASH_EINVAL if the budget is 0, or PLCRASH_ENOMEM if the read
+ * buffer could not be allocated.
+ *
+ * @warning This function is not async safe, and must be called outside of a signal handler.
+ */
+plcrash_error_t plcrash_log_writer_set_stack_capture (plcrash_log_writer_t *writer, uint32_t below_sp, uint32_t above_sp,
+                                                      bool all_threads, uint32_t budget)
+{
+    if (budget == 0 || (below_sp == 0 && above_sp == 0))
+        return PLCRASH_EINVAL;
+
+    /* Allocate the page-sized read buffer */
+    if (writer->stack_memory.buffer == NULL) {
+        writer->stack_memory.page_size = vm_page_size;
+        writer->stack_memory.buffer = malloc(writer->stack_memory.page_size);
+        if (writer->stack_memory.buffer == NULL)
+            return PLCRASH_ENOMEM;
+    }
+
+    writer->stack_memory.below_sp = below_sp;
+    writer->stack_memory.above_sp = above_sp;
+    writer->stack_memory.all_threads = all_threads;
+    writer->stack_memory.budget = budget;
+    writer->stack_memory.enabled = true;
+
+    /* Ensure that any signal handler has a consistent view of the above initialization. */
+    OSMemoryBarrier();
+
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * Enable prioritized output. The signal, exception, crashed thread, and the binary images referenced by the
+ * crashed thread will be written first; the remaining threads and images will then be written until either
+ * budget is exhausted. Any omitted threads or images are recorded in the report's truncation message.
+ *
+ * @param writer The writer to configure.
+ * @param deadline_ms Wall-clock budget for writing the report, in milliseconds, or 0 for no time limit.
+ * @param byte_budget Maximum number of bytes to write, or 0 for no limit. This should leave headroom below
+ * the output file's hard limit, as the crashed thread and its images are always written.
+ *
+ * @warning This function is not async safe, and must be called outside of a signal handler.
+ */
+void plcrash_log_writer_set_priority (plcrash_log_writer_t *writer, uint32_t deadline_ms, size_t byte_budget) {
+    mach_timebase_info_data_t timebase;
+
+    /* Convert the deadline to mach_absolute_time() units */
+    writer->priority.deadline = 0;
+    if (deadline_ms > 0 && mach_timebase_info(&timebase) == KERN_SUCCESS && timebase.numer != 0) {
+        writer->priority.deadline = ((uint64_t) deadline_ms * NSEC_PER_MSEC * timebase.denom) / timebase.numer;
+    }
+
+    writer->priority.byte_budget = byte_budget;
+    writer->priority.enabled = true;
+
+    /* Ensure that any signal handler has a consistent view of the above initialization. */
+    OSMemoryBarrier();
+}
+
+/**
+ * Enable or disable writer self-instrumentation. If enabled, each report will include a writer_stats
+ * message recording the time spent suspending, walking, and writing each thread, the time spent writing
+ * binary images, the number of failed memory reads and dropped frames, and the bytes emitted per section.
+ *
+ * @param writer The writer to configure.
+ * @param enabled If true, writer statistics will be written.
+ *
+ * @warning This function is not async safe, and must be called outside of a signal handler.
+ */
+void plcrash_log_writer_set_stats_enabled (plcrash_log_writer_t *writer, bool enabled) {
+    if (enabled && mach_timebase_info(&writer->stats.timebase) != KERN_SUCCESS) {
+        PLCF_DEBUG("Could not fetch the mach timebase; writer statistics will not be written");
+        enabled = false;
+    }
+
+    writer->stats.enabled = enabled;
+
+    /* Ensure that any signal handler has a consistent view of the above initialization. */
+    OSMemoryBarrier();
+}
+
 /**
  * Close the plcrash_writer_t output.
  *
@@ -485,24 +277,8 @@ void plcrash_log_writer_free (plcrash_log_writer_t *writer) {
     if (writer->application_info.app_version != NULL)
         free(writer->application_info.app_version);
 
-    /* Free the process info */
-    if (writer->process_info.process_name != NULL) 
-        free(writer->process_info.process_name);
-    if (writer->process_info.process_path != NULL) 
-        free(writer->process_info.process_path);
-    if (writer->process_info.parent_process_name != NULL) 
-        free(writer->process_info.parent_process_name);
-    
-    /* Free the system info */
-    if (writer->system_info.version != NULL)
-        free(writer->system_info.version);
-    
-    if (writer->system_info.build != NULL)
-        free(writer->system_info.build);
-    
-    /* Free the machine info */
-    if (writer->machine_info.model != NULL)
-        free(writer->machine_info.model);
+    /* Free the host info */
+    plcrash_host_info_free(&writer->host_info);
 
     /* Free the binary image info */
     plcrash_async_image_list_free(&writer->image_info.image_list);
@@ -518,6 +294,10 @@ void plcrash_log_writer_free (plcrash_log_writer_t *writer) {
         if (writer->uncaught_exception.callstack != NULL)
             free(writer->uncaught_exception.callstack);
     }
+
+    /* Free the stack memory read buffer */
+    if (writer->stack_memory.buffer != NULL)
+        free(writer->stack_memory.buffer);
 }
 
 /**
@@ -533,21 +313,21 @@ static size_t plcrash_writer_write_system_info (plcrash_async_file_t *file, plcr
     uint32_t enumval;
 
     /* OS */
-    enumval = PLCrashReportHostOperatingSystem;
-    rv += plcrash_writer_pack(file, PLCRASH_PROTO_SYSTEM_INFO_OS_ID, PLPROTOBUF_C_TYPE_ENUM, &enumval);
+    enumval = writer->host_info.operating_system;
+    rv += plcrash_proto_system_info_operating_system_pack(file, &enumval);
 
     /* OS Version */
-    rv += plcrash_writer_pack(file, PLCRASH_PROTO_SYSTEM_INFO_OS_VERSION_ID, PLPROTOBUF_C_TYPE_STRING, writer->system_info.version);
+    rv += plcrash_proto_system_info_os_version_pack(file, writer->host_info.system_info.version);
     
     /* OS Build */
-    rv += plcrash_writer_pack(file, PLCRASH_PROTO_SYSTEM_INFO_OS_BUILD_ID, PLPROTOBUF_C_TYPE_STRING, writer->system_info.build);
+    rv += plcrash_proto_system_info_os_build_pack(file, writer->host_info.system_info.build);
 
     /* Machine type */
     enumval = PLCrashReportHostArchitecture;
-    rv += plcrash_writer_pack(file, PLCRASH_PROTO_SYSTEM_INFO_ARCHITECTURE_TYPE_ID, PLPROTOBUF_C_TYPE_ENUM, &enumval);
+    rv += plcrash_proto_system_info_architecture_pack(file, &enumval);
 
     /* Timestamp */
-    rv += plcrash_writer_pack(file, PLCRASH_PROTO_SYSTEM_INFO_TIMESTAMP_ID, PLPROTOBUF_C_TYPE_INT64, &timestamp);
+    rv += plcrash_proto_system_info_timestamp_pack(file, &timestamp);
 
     return rv;
 }
@@ -567,13 +347,13 @@ static size_t plcrash_writer_write_processor_info (plcrash_async_file_t *file, u
     
     /* Encoding */
     enumval = PLCrashReportProcessorTypeEncodingMach;
-    rv += plcrash_writer_pack(file, PLCRASH_PROTO_PROCESSOR_ENCODING_ID, PLPROTOBUF_C_TYPE_ENUM, &enumval);
+    rv += plcrash_proto_processor_encoding_pack(file, &enumval);
 
     /* Type */
-    rv += plcrash_writer_pack(file, PLCRASH_PROTO_PROCESSOR_TYPE_ID, PLPROTOBUF_C_TYPE_UINT64, &cpu_type);
+    rv += plcrash_proto_processor_type_pack(file, &cpu_type);
 
     /* Subtype */
-    rv += plcrash_writer_pack(file, PLCRASH_PROTO_PROCESSOR_SUBTYPE_ID, PLPROTOBUF_C_TYPE_UINT64, &cpu_subtype);
+    rv += plcrash_proto_processor_subtype_pack(file, &cpu_subtype);
     
     return rv;
 }
@@ -589,26 +369,26 @@ static size_t plcrash_writer_write_machine_info (plcrash_async_file_t *file, plc
     size_t rv = 0;
     
     /* Model */
-    if (writer->machine_info.model != NULL)
-        rv += plcrash_writer_pack(file, PLCRASH_PROTO_MACHINE_INFO_MODEL_ID, PLPROTOBUF_C_TYPE_STRING, writer->machine_info.model);
+    if (writer->host_info.machine_info.model != NULL)
+        rv += plcrash_proto_machine_info_model_pack(file, writer->host_info.machine_info.model);
 
     /* Processor */
     {
         uint32_t size;
 
         /* Determine size */
-        size = plcrash_writer_write_processor_info(NULL, writer->machine_info.cpu_type, writer->machine_info.cpu_subtype);
+        size = plcrash_writer_write_processor_info(NULL, writer->host_info.machine_info.cpu_type, writer->host_info.machine_info.cpu_subtype);
 
         /* Write message */
-        rv += plcrash_writer_pack(file, PLCRASH_PROTO_MACHINE_INFO_PROCESSOR_ID, PLPROTOBUF_C_TYPE_MESSAGE, &size);
-        rv += plcrash_writer_write_processor_info(file, writer->machine_info.cpu_type, writer->machine_info.cpu_subtype);
+        rv += plcrash_proto_machine_info_processor_pack(file, &size);
+        rv += plcrash_writer_write_processor_info(file, writer->host_info.machine_info.cpu_type, writer->host_info.machine_info.cpu_subtype);
     }
 
     /* Physical Processor Count */
-    rv += plcrash_writer_pack(file, PLCRASH_PROTO_MACHINE_INFO_PROCESSOR_COUNT_ID, PLPROTOBUF_C_TYPE_UINT32, &writer->machine_info.processor_count);
+    rv += plcrash_proto_machine_info_processor_count_pack(file, &writer->host_info.machine_info.processor_count);
     
     /* Logical Processor Count */
-    rv += plcrash_writer_pack(file, PLCRASH_PROTO_MACHINE_INFO_LOGICAL_PROCESSOR_COUNT_ID, PLPROTOBUF_C_TYPE_UINT32, &writer->machine_info.logical_processor_count);
+    rv += plcrash_proto_machine_info_logical_processor_count_pack(file, &writer->host_info.machine_info.logical_processor_count);
     
     return rv;
 }
@@ -626,10 +406,10 @@ static size_t plcrash_writer_write_app_info (plcrash_async_file_t *file, const c
     size_t rv = 0;
 
     /* App identifier */
-    rv += plcrash_writer_pack(file, PLCRASH_PROTO_APP_INFO_APP_IDENTIFIER_ID, PLPROTOBUF_C_TYPE_STRING, app_identifier);
+    rv += plcrash_proto_application_info_identifier_pack(file, app_identifier);
     
     /* App version */
-    rv += plcrash_writer_pack(file, PLCRASH_PROTO_APP_INFO_APP_VERSION_ID, PLPROTOBUF_C_TYPE_STRING, app_version);
+    rv += plcrash_proto_application_info_version_pack(file, app_version);
     
     return rv;
 }
@@ -653,27 +433,30 @@ static size_t plcrash_writer_write_process_info (plcrash_async_file_t *file, con
                                                  bool native) 
 {
     size_t rv = 0;
+    uint32_t pid;
 
     /* Process name */
     if (process_name != NULL)
-        rv += plcrash_writer_pack(file, PLCRASH_PROTO_PROCESS_INFO_PROCESS_NAME_ID, PLPROTOBUF_C_TYPE_STRING, process_name);
+        rv += plcrash_proto_process_info_process_name_pack(file, process_name);
 
     /* Process ID */
-    rv += plcrash_writer_pack(file, PLCRASH_PROTO_PROCESS_INFO_PROCESS_ID_ID, PLPROTOBUF_C_TYPE_UINT64, &process_id);
+    pid = process_id;
+    rv += plcrash_proto_process_info_process_id_pack(file, &pid);
 
     /* Process path */
     if (process_path != NULL)
-        rv += plcrash_writer_pack(file, PLCRASH_PROTO_PROCESS_INFO_PROCESS_PATH_ID, PLPROTOBUF_C_TYPE_STRING, process_path);
+        rv += plcrash_proto_process_info_process_path_pack(file, process_path);
 
     /* Parent process name */
     if (parent_process_name != NULL)
-        rv += plcrash_writer_pack(file, PLCRASH_PROTO_PROCESS_INFO_PARENT_PROCESS_NAME_ID, PLPROTOBUF_C_TYPE_STRING, parent_process_name);
+        rv += plcrash_proto_process_info_parent_process_name_pack(file, parent_process_name);
 
     /* Parent process ID */
-    rv += plcrash_writer_pack(file, PLCRASH_PROTO_PROCESS_INFO_PARENT_PROCESS_ID_ID, PLPROTOBUF_C_TYPE_UINT64, &parent_process_id);
+    pid = parent_process_id;
+    rv += plcrash_proto_process_info_parent_process_id_pack(file, &pid);
 
     /* Native process. */
-    rv += plcrash_writer_pack(file, PLCRASH_PROTO_PROCESS_INFO_NATIVE_ID, PLPROTOBUF_C_TYPE_BOOL, &native);
+    rv += plcrash_proto_process_info_native_pack(file, &native);
 
     return rv;
 }
@@ -691,11 +474,11 @@ static size_t plcrash_writer_write_thread_register (plcrash_async_file_t *file,
     size_t rv = 0;
 
     /* Write the name */
-    rv += plcrash_writer_pack(file, PLCRASH_PROTO_THREAD_REGISTER_NAME_ID, PLPROTOBUF_C_TYPE_STRING, regname);
+    rv += plcrash_proto_thread_register_value_name_pack(file, regname);
 
     /* Write the value */
     uint64val = regval;
-    rv += plcrash_writer_pack(file, PLCRASH_PROTO_THREAD_REGISTER_VALUE_ID, PLPROTOBUF_C_TYPE_UINT64, &uint64val);
+    rv += plcrash_proto_thread_register_value_value_pack(file, &uint64val);
     
     return rv;
 }
@@ -749,7 +532,7 @@ static size_t plcrash_writer_write_thread_registers (plcrash_async_file_t *file,
         msgsize = plcrash_writer_write_thread_register(NULL, regname, regVal);
         
         /* Write the header and message */
-        rv += plcrash_writer_pack(file, PLCRASH_PROTO_THREAD_REGISTERS_ID, PLPROTOBUF_C_TYPE_MESSAGE, &msgsize);
+        rv += plcrash_proto_thread_registers_pack(file, &msgsize);
         rv += plcrash_writer_write_thread_register(file, regname, regVal);
     }
     
@@ -767,7 +550,131 @@ static size_t plcrash_writer_write_thread_registers (plcrash_async_file_t *file,
 static size_t plcrash_writer_write_thread_frame (plcrash_async_file_t *file, uint64_t pcval) {
     size_t rv = 0;
 
-    rv += plcrash_writer_pack(file, PLCRASH_PROTO_THREAD_FRAME_PC_ID, PLPROTOBUF_C_TYPE_UINT64, &pcval);
+    rv += plcrash_proto_thread_stack_frame_pc_pack(file, &pcval);
+
+    return rv;
+}
+
+/**
+ * @internal
+ *
+ * Write a stack memory message
+ *
+ * @param file Output file
+ * @param base_address The address of the first captured byte.
+ * @param contents The captured bytes.
+ */
+static size_t plcrash_writer_write_stack_memory (plcrash_async_file_t *file, uint64_t base_address, PLProtobufCBinaryData *contents) {
+    size_t rv = 0;
+
+    rv += plcrash_proto_thread_stack_memory_base_address_pack(file, &base_address);
+    rv += plcrash_proto_thread_stack_memory_contents_pack(file, contents);
+
+    return rv;
+}
+
+/**
+ * @internal
+ *
+ * Write all stack memory messages for a thread. The configured window surrounding @a sp is split at page
+ * boundaries; each chunk is fetched with a single plframe_read_addr() call, and unreadable chunks (eg, guard
+ * pages) are skipped.
+ *
+ * Page de-duplication and budget accounting are only committed when @a file is non-NULL, guaranteeing that
+ * the sizing pass returns the same value as the subsequent write pass.
+ *
+ * Until the crashed thread has been written, other threads may not use the bytes and pages reserved for its
+ * window; threads listed before the crashed thread can not exhaust the budget.
+ *
+ * @param file Output file
+ * @param writer Writer containing the stack memory configuration.
+ * @param sp The thread's stack pointer.
+ * @param crashed_thread True if this is the crashed thread.
+ */
+static size_t plcrash_writer_write_thread_stack (plcrash_async_file_t *file, plcrash_log_writer_t *writer, plframe_greg_t sp,
+                                                 bool crashed_thread)
+{
+    size_t rv = 0;
+    uint32_t used = writer->stack_memory.used;
+    uint32_t budget = writer->stack_memory.budget;
+    size_t max_pages = PLCRASH_LOG_WRITER_STACK_MAX_PAGES;
+    size_t committed_pages = writer->stack_memory.page_count;
+    size_t page_count = committed_pages;
+    uint32_t read_failures = 0;
+    uintptr_t page_mask = ~((uintptr_t) writer->stack_memory.page_size - 1);
+    uintptr_t start, end, addr;
+
+    /* Leave the crashed thread's reservation untouched */
+    if (!crashed_thread) {
+        budget -= writer->stack_memory.reserved;
+        max_pages -= writer->stack_memory.reserved_pages;
+    }
+
+    /* Compute the capture window, clamping to the address space */
+    start = (sp > writer->stack_memory.below_sp) ? (uintptr_t) sp - writer->stack_memory.below_sp : 0;
+    if (UINTPTR_MAX - sp > writer->stack_memory.above_sp)
+        end = (uintptr_t) sp + writer->stack_memory.above_sp;
+    else
+        end = UINTPTR_MAX;
+
+    addr = start;
+    while (addr < end && used < budget && page_count < max_pages) {
+        uintptr_t page = addr & page_mask;
+        uintptr_t chunk_end = page + writer->stack_memory.page_size;
+        bool duplicate = false;
+        size_t len;
+
+        /* Clamp to the window (and handle overflow on the final page) */
+        if (chunk_end > end || chunk_end < page)
+            chunk_end = end;
+
+        len = chunk_end - addr;
+        if (len > budget - used)
+            len = budget - used;
+
+        /* Skip any page already written by a previous thread */
+        for (size_t i = 0; i < committed_pages; i++) {
+            if (writer->stack_memory.pages[i] == page) {
+                duplicate = true;
+                break;
+            }
+        }
+
+        if (!duplicate && plframe_read_addr((const void *) addr, writer->stack_memory.buffer, len) == KERN_SUCCESS) {
+            PLProtobufCBinaryData contents;
+            uint32_t msgsize;
+
+            contents.len = len;
+            contents.data = writer->stack_memory.buffer;
+
+            /* Write the header and message */
+            msgsize = plcrash_writer_write_stack_memory(NULL, addr, &contents);
+            rv += plcrash_proto_thread_stack_memory_pack(file, &msgsize);
+            rv += plcrash_writer_write_stack_memory(file, addr, &contents);
+
+            if (file != NULL)
+                writer->stack_memory.pages[page_count] = page;
+            page_count++;
+            used += len;
+        } else if (!duplicate) {
+            /* Unreadable (eg, a guard page) */
+            read_failures++;
+        }
+
+        addr = chunk_end;
+    }
+
+    /* Commit, releasing the reservation once the crashed thread has been written */
+    if (file != NULL) {
+        writer->stack_memory.used = used;
+        writer->stack_memory.page_count = page_count;
+        writer->stats.read_failures += read_failures;
+
+        if (crashed_thread) {
+            writer->stack_memory.reserved = 0;
+            writer->stack_memory.reserved_pages = 0;
+        }
+    }
 
     return rv;
 }
@@ -778,21 +685,26 @@ static size_t plcrash_writer_write_thread_frame (plcrash_async_file_t *file, uin
  * Write a thread message
  *
  * @param file Output file
+ * @param writer Writer containing the stack memory configuration.
  * @param thread Thread for which we'll output data.
  * @param crashctx Context to use for currently running thread (rather than fetching the thread
  * context, which we've invalidated by running at all)
  */
-static size_t plcrash_writer_write_thread (plcrash_async_file_t *file, thread_t thread, uint32_t thread_number, ucontext_t *crashctx) {
+static size_t plcrash_writer_write_thread (plcrash_async_file_t *file, plcrash_log_writer_t *writer, thread_t thread,
+                                           uint32_t thread_number, ucontext_t *crashctx)
+{
     size_t rv = 0;
     plframe_cursor_t cursor;
     plframe_error_t ferr;
+    plframe_greg_t sp = 0;
+    bool has_sp = false;
     bool crashed_thread = false;
 
     /* Write the required elements first; fatal errors may occur below, in which case we need to have
      * written out required elements before returning. */
     {
         /* Write the thread ID */
-        rv += plcrash_writer_pack(file, PLCRASH_PROTO_THREAD_THREAD_NUMBER_ID, PLPROTOBUF_C_TYPE_UINT32, &thread_number);
+        rv += plcrash_proto_thread_thread_number_pack(file, &thread_number);
 
         /* Is this the crashed thread? */
         thread_t thr_self = mach_thread_self();
@@ -800,7 +712,7 @@ static size_t plcrash_writer_write_thread (plcrash_async_file_t *file, thread_t
             crashed_thread = true;
 
         /* Note crashed status */
-        rv += plcrash_writer_pack(file, PLCRASH_PROTO_THREAD_CRASHED_ID, PLPROTOBUF_C_TYPE_BOOL, &crashed_thread);
+        rv += plcrash_proto_thread_crashed_pack(file, &crashed_thread);
     }
 
 
@@ -820,6 +732,10 @@ static size_t plcrash_writer_write_thread (plcrash_async_file_t *file, thread_t
                 PLCF_DEBUG("An error occured initializing the frame cursor: %s", plframe_strerror(ferr));
                 return rv;
             }
+
+            /* Save the stack pointer; it is only available prior to walking the stack */
+            if (plframe_get_reg(&cursor, PLFRAME_REG_SP, &sp) == PLFRAME_ESUCCESS)
+                has_sp = true;
         }
 
         /* Walk the stack, limiting the total number of frames that are output. */
@@ -834,14 +750,26 @@ static size_t plcrash_writer_write_thread (plcrash_async_file_t *file, thread_t
                 break;
             }
 
+            /* Record the crashed thread's PCs for prioritized image output */
+            if (file != NULL && crashed_thread && writer->priority.pc_count < PLCRASH_LOG_WRITER_PRIORITY_MAX_FRAMES)
+                writer->priority.pcs[writer->priority.pc_count++] = pc;
+
             /* Determine the size */
             frame_size = plcrash_writer_write_thread_frame(NULL, pc);
             
-            rv += plcrash_writer_pack(file, PLCRASH_PROTO_THREAD_FRAMES_ID, PLPROTOBUF_C_TYPE_MESSAGE, &frame_size);
+            rv += plcrash_proto_thread_frames_pack(file, &frame_size);
             rv += plcrash_writer_write_thread_frame(file, pc);
             frame_count++;
         }
 
+        /* Note truncation at the frame limit. The walk stopped on a valid frame; no further frames are walked. */
+        if (file != NULL && frame_count == MAX_THREAD_FRAMES && ferr == PLFRAME_ESUCCESS)
+            writer->stats.thread_truncated = true;
+
+        /* Count the walker's read failures once, in the write pass */
+        if (file != NULL)
+            writer->stats.read_failures += cursor.read_failures;
+
         /* Did we reach the end successfully? */
         if (ferr != PLFRAME_ENOFRAME) {
             /* This is non-fatal, and in some circumstances -could- be caused by reaching the end of the stack if the
@@ -855,6 +783,11 @@ static size_t plcrash_writer_write_thread (plcrash_async_file_t *file, thread_t
         rv += plcrash_writer_write_thread_registers(file, crashctx);
     }
 
+    /* Dump raw stack memory, if enabled */
+    if (writer->stack_memory.enabled && has_sp && (crashed_thread || writer->stack_memory.all_threads)) {
+        rv += plcrash_writer_write_thread_stack(file, writer, sp, crashed_thread);
+    }
+
     return rv;
 }
 
@@ -862,22 +795,23 @@ static size_t plcrash_writer_write_thread (plcrash_async_file_t *file, thread_t
 /**
  * @internal
  *
- * Write a binary image frame
+ * Parse the Mach-O header of a loaded binary image.
  *
- * @param file Output file
- * @param name binary image path (or name).
- * @param image_base Mach-O image base.
+ * @param header Mach-O image base.
+ * @param text_size On return, the size of the image's __TEXT segment (or 0 if not found).
+ * @param uuid On return, the image's LC_UUID command, or NULL if not found.
+ * @param cpu_type On return, the image's CPU type.
+ * @param cpu_subtype On return, the image's CPU subtype.
+ *
+ * @return Returns true on success, or false if the header is not a valid Mach-O header.
  */
-static size_t plcrash_writer_write_binary_image (plcrash_async_file_t *file, const char *name, const void *header) {
-    size_t rv = 0;
-    uint64_t mach_size = 0;
+static bool plcrash_writer_parse_image (const void *header, uint64_t *text_size, struct uuid_command **uuid,
+                                        cpu_type_t *cpu_type, cpu_subtype_t *cpu_subtype)
+{
     uint32_t ncmds;
     const struct mach_header *header32 = (const struct mach_header *) header;
     const struct mach_header_64 *header64 = (const struct mach_header_64 *) header;
-
     struct load_command *cmd;
-    cpu_type_t cpu_type;
-    cpu_subtype_t cpu_subtype;
 
     /* Check for 32-bit/64-bit header and extract required values */
     switch (header32->magic) {
@@ -885,8 +819,8 @@ static size_t plcrash_writer_write_binary_image (plcrash_async_file_t *file, con
         case MH_MAGIC:
         case MH_CIGAM:
             ncmds = header32->ncmds;
-            cpu_type = header32->cputype;
-            cpu_subtype = header32->cpusubtype;
+            *cpu_type = header32->cputype;
+            *cpu_subtype = header32->cpusubtype;
             cmd = (struct load_command *) (header32 + 1);
             break;
 
@@ -894,25 +828,26 @@ static size_t plcrash_writer_write_binary_image (plcrash_async_file_t *file, con
         case MH_MAGIC_64:
         case MH_CIGAM_64:
             ncmds = header64->ncmds;
-            cpu_type = header64->cputype;
-            cpu_subtype = header64->cpusubtype;
+            *cpu_type = header64->cputype;
+            *cpu_subtype = header64->cpusubtype;
             cmd = (struct load_command *) (header64 + 1);
             break;
 
         default:
             PLCF_DEBUG("Invalid Mach-O header magic value: %x", header32->magic);
-            return 0;
+            return false;
     }
 
     /* Compute the image size and search for a UUID */
-    struct uuid_command *uuid = NULL;
+    *text_size = 0;
+    *uuid = NULL;
 
     for (uint32_t i = 0; cmd != NULL && i < ncmds; i++) {
         /* 32-bit text segment */
         if (cmd->cmd == LC_SEGMENT) {
             struct segment_command *segment = (struct segment_command *) cmd;
             if (strcmp(segment->segname, SEG_TEXT) == 0) {
-                mach_size = segment->vmsize;
+                *text_size = segment->vmsize;
             }
         }
         /* 64-bit text segment */
@@ -920,18 +855,40 @@ static size_t plcrash_writer_write_binary_image (plcrash_async_file_t *file, con
             struct segment_command_64 *segment = (struct segment_command_64 *) cmd;
 
             if (strcmp(segment->segname, SEG_TEXT) == 0) {
-                mach_size = segment->vmsize;
+                *text_size = segment->vmsize;
             }
         }
         /* DWARF dSYM UUID */
         else if (cmd->cmd == LC_UUID && cmd->cmdsize == sizeof(struct uuid_command)) {
-            uuid = (struct uuid_command *) cmd;
+            *uuid = (struct uuid_command *) cmd;
         }
 
         cmd = (struct load_command *) ((uint8_t *) cmd + cmd->cmdsize);
     }
 
-    rv += plcrash_writer_pack(file, PLCRASH_PROTO_BINARY_IMAGE_SIZE_ID, PLPROTOBUF_C_TYPE_UINT64, &mach_size);
+    return true;
+}
+
+/**
+ * @internal
+ *
+ * Write a binary image frame
+ *
+ * @param file Output file
+ * @param name binary image path (or name).
+ * @param image_base Mach-O image base.
+ */
+static size_t plcrash_writer_write_binary_image (plcrash_async_file_t *file, const char *name, const void *header) {
+    size_t rv = 0;
+    uint64_t mach_size = 0;
+    struct uuid_command *uuid = NULL;
+    cpu_type_t cpu_type;
+    cpu_subtype_t cpu_subtype;
+
+    if (!plcrash_writer_parse_image(header, &mach_size, &uuid, &cpu_type, &cpu_subtype))
+        return 0;
+
+    rv += plcrash_proto_binary_image_size_pack(file, &mach_size);
     
     /* Base address */
     {
@@ -940,11 +897,11 @@ static size_t plcrash_writer_write_binary_image (plcrash_async_file_t *file, con
 
         base_addr = (uintptr_t) header;
         u64 = base_addr;
-        rv += plcrash_writer_pack(file, PLCRASH_PROTO_BINARY_IMAGE_ADDR_ID, PLPROTOBUF_C_TYPE_UINT64, &u64);
+        rv += plcrash_proto_binary_image_base_address_pack(file, &u64);
     }
 
     /* Name */
-    rv += plcrash_writer_pack(file, PLCRASH_PROTO_BINARY_IMAGE_NAME_ID, PLPROTOBUF_C_TYPE_STRING, name);
+    rv += plcrash_proto_binary_image_name_pack(file, name);
 
     /* UUID */
     if (uuid != NULL) {
@@ -953,14 +910,14 @@ static size_t plcrash_writer_write_binary_image (plcrash_async_file_t *file, con
         /* Write the 128-bit UUID */
         binary.len = sizeof(uuid->uuid);
         binary.data = uuid->uuid;
-        rv += plcrash_writer_pack(file, PLCRASH_PROTO_BINARY_IMAGE_UUID_ID, PLPROTOBUF_C_TYPE_BYTES, &binary);
+        rv += plcrash_proto_binary_image_uuid_pack(file, &binary);
     }
     
     /* Get the processor message size */
     uint32_t msgsize = plcrash_writer_write_processor_info(NULL, cpu_type, cpu_subtype);
 
     /* Write the header and message */
-    rv += plcrash_writer_pack(file, PLCRASH_PROTO_BINARY_IMAGE_CODE_TYPE_ID, PLPROTOBUF_C_TYPE_MESSAGE, &msgsize);
+    rv += plcrash_proto_binary_image_code_type_pack(file, &msgsize);
     rv += plcrash_writer_write_processor_info(file, cpu_type, cpu_subtype);
 
     return rv;
@@ -980,8 +937,8 @@ static size_t plcrash_writer_write_exception (plcrash_async_file_t *file, plcras
 
     /* Write the name and reason */
     assert(writer->uncaught_exception.has_exception);
-    rv += plcrash_writer_pack(file, PLCRASH_PROTO_EXCEPTION_NAME_ID, PLPROTOBUF_C_TYPE_STRING, writer->uncaught_exception.name);
-    rv += plcrash_writer_pack(file, PLCRASH_PROTO_EXCEPTION_REASON_ID, PLPROTOBUF_C_TYPE_STRING, writer->uncaught_exception.reason);
+    rv += plcrash_proto_exception_name_pack(file, writer->uncaught_exception.name);
+    rv += plcrash_proto_exception_reason_pack(file, writer->uncaught_exception.reason);
     
     /* Write the stack frames, if any */
     uint32_t frame_count = 0;
@@ -991,7 +948,7 @@ static size_t plcrash_writer_write_exception (plcrash_async_file_t *file, plcras
         /* Determine the size */
         uint32_t frame_size = plcrash_writer_write_thread_frame(NULL, pc);
         
-        rv += plcrash_writer_pack(file, PLCRASH_PROTO_EXCEPTION_FRAMES_ID, PLPROTOBUF_C_TYPE_MESSAGE, &frame_size);
+        rv += plcrash_proto_exception_frames_pack(file, &frame_size);
         rv += plcrash_writer_write_thread_frame(file, pc);
         frame_count++;
     }
@@ -1032,16 +989,316 @@ static size_t plcrash_writer_write_signal (plcrash_async_file_t *file, siginfo_t
     uint64_t addr = (uintptr_t) siginfo->si_addr;
 
     /* Write it out */
-    rv += plcrash_writer_pack(file, PLCRASH_PROTO_SIGNAL_NAME_ID, PLPROTOBUF_C_TYPE_STRING, name);
-    rv += plcrash_writer_pack(file, PLCRASH_PROTO_SIGNAL_CODE_ID, PLPROTOBUF_C_TYPE_STRING, code);
-    rv += plcrash_writer_pack(file, PLCRASH_PROTO_SIGNAL_ADDRESS_ID, PLPROTOBUF_C_TYPE_UINT64, &addr);
+    rv += plcrash_proto_signal_name_pack(file, name);
+    rv += plcrash_proto_signal_code_pack(file, code);
+    rv += plcrash_proto_signal_address_pack(file, &addr);
+
+    return rv;
+}
+
+/**
+ * @internal
+ *
+ * Write the crash writer truncation message
+ *
+ * @param file Output file
+ * @param omitted_threads Number of threads that were not written.
+ * @param omitted_images Number of binary images that were not written.
+ * @param deadline_exceeded True if the time budget was exhausted.
+ * @param byte_budget_exceeded True if the byte budget was exhausted.
+ */
+static size_t plcrash_writer_write_truncation (plcrash_async_file_t *file, uint32_t omitted_threads, uint32_t omitted_images,
+                                               bool deadline_exceeded, bool byte_budget_exceeded)
+{
+    size_t rv = 0;
+
+    rv += plcrash_proto_truncation_omitted_threads_pack(file, &omitted_threads);
+    rv += plcrash_proto_truncation_omitted_images_pack(file, &omitted_images);
+    rv += plcrash_proto_truncation_deadline_exceeded_pack(file, &deadline_exceeded);
+    rv += plcrash_proto_truncation_byte_budget_exceeded_pack(file, &byte_budget_exceeded);
+
+    return rv;
+}
+
+/**
+ * @internal
+ *
+ * Convert a mach_absolute_time() interval to nanoseconds.
+ *
+ * @param writer Writer context
+ * @param interval The interval to convert.
+ */
+static uint64_t plcrash_writer_stats_nsec (plcrash_log_writer_t *writer, uint64_t interval) {
+    if (writer->stats.timebase.denom == 0)
+        return 0;
+
+    return (interval * writer->stats.timebase.numer) / writer->stats.timebase.denom;
+}
+
+/**
+ * @internal
+ *
+ * Write a CrashReport.writer_stats.threads message
+ *
+ * @param file Output file
+ * @param writer Writer context
+ * @param stats The thread statistics to be written.
+ */
+static size_t plcrash_writer_write_thread_stats (plcrash_async_file_t *file, plcrash_log_writer_t *writer,
+                                                 plcrash_log_writer_thread_stats_t *stats)
+{
+    uint64_t suspend_time = plcrash_writer_stats_nsec(writer, stats->suspend_time);
+    uint64_t walk_time = plcrash_writer_stats_nsec(writer, stats->walk_time);
+    uint64_t write_time = plcrash_writer_stats_nsec(writer, stats->write_time);
+    size_t rv = 0;
+
+    rv += plcrash_proto_writer_stats_thread_stats_thread_number_pack(file, &stats->thread_number);
+    rv += plcrash_proto_writer_stats_thread_stats_suspend_time_pack(file, &suspend_time);
+    rv += plcrash_proto_writer_stats_thread_stats_walk_time_pack(file, &walk_time);
+    rv += plcrash_proto_writer_stats_thread_stats_write_time_pack(file, &write_time);
+    rv += plcrash_proto_writer_stats_thread_stats_truncated_pack(file, &stats->truncated);
+
+    return rv;
+}
+
+/**
+ * @internal
+ *
+ * Write the crash writer statistics message
+ *
+ * @param file Output file
+ * @param writer Writer context
+ * @param total_time Total time spent writing the report, in mach_absolute_time() units.
+ */
+static size_t plcrash_writer_write_stats (plcrash_async_file_t *file, plcrash_log_writer_t *writer, uint64_t total_time) {
+    uint64_t total_nsec = plcrash_writer_stats_nsec(writer, total_time);
+    uint64_t image_nsec = plcrash_writer_stats_nsec(writer, writer->stats.image_time);
+    size_t rv = 0;
+
+    /* Per-thread statistics */
+    for (size_t i = 0; i < writer->stats.thread_count; i++) {
+        uint32_t size;
+
+        size = plcrash_writer_write_thread_stats(NULL, writer, &writer->stats.threads[i]);
+        rv += plcrash_proto_writer_stats_threads_pack(file, &size);
+        rv += plcrash_writer_write_thread_stats(file, writer, &writer->stats.threads[i]);
+    }
+
+    rv += plcrash_proto_writer_stats_total_time_pack(file, &total_nsec);
+    rv += plcrash_proto_writer_stats_image_time_pack(file, &image_nsec);
+    rv += plcrash_proto_writer_stats_read_failures_pack(file, &writer->stats.read_failures);
+    rv += plcrash_proto_writer_stats_truncated_threads_pack(file, &writer->stats.truncated_threads);
+
+    /* Section sizes */
+    rv += plcrash_proto_writer_stats_system_info_bytes_pack(file, &writer->stats.bytes.system_info);
+    rv += plcrash_proto_writer_stats_machine_info_bytes_pack(file, &writer->stats.bytes.machine_info);
+    rv += plcrash_proto_writer_stats_application_info_bytes_pack(file, &writer->stats.bytes.application_info);
+    rv += plcrash_proto_writer_stats_process_info_bytes_pack(file, &writer->stats.bytes.process_info);
+    rv += plcrash_proto_writer_stats_threads_bytes_pack(file, &writer->stats.bytes.threads);
+    rv += plcrash_proto_writer_stats_binary_images_bytes_pack(file, &writer->stats.bytes.binary_images);
+    rv += plcrash_proto_writer_stats_exception_bytes_pack(file, &writer->stats.bytes.exception);
+    rv += plcrash_proto_writer_stats_signal_bytes_pack(file, &writer->stats.bytes.signal);
+
+    return rv;
+}
+
+/**
+ * @internal
+ *
+ * Write a complete CrashReport.threads message, suspending the target thread (unless it is the current thread)
+ * for the duration of the write.
+ *
+ * @param file Output file
+ * @param writer Writer context
+ * @param thread Thread for which we'll output data.
+ * @param thread_number The thread's index in the task's thread list.
+ * @param crashctx Context of the crashed thread.
+ * @param max_bytes Maximum number of bytes that may be written, or 0 if unlimited. If the message would exceed
+ * this value, nothing is written.
+ * @param over_budget If non-NULL, set to true if the message was not written due to @a max_bytes.
+ *
+ * @return Returns the number of bytes written.
+ */
+static size_t plcrash_writer_write_thread_message (plcrash_async_file_t *file, plcrash_log_writer_t *writer, thread_t thread,
+                                                   uint32_t thread_number, ucontext_t *crashctx, size_t max_bytes, bool *over_budget)
+{
+    thread_t self_thr = mach_thread_self();
+    bool suspend_thread = true;
+    uint64_t suspend_start, walk_start, write_start, write_end;
+    uint32_t size;
+    size_t rv = 0;
+
+    /* Check if we're running on the to be examined thread */
+    if (MACH_PORT_INDEX(self_thr) == MACH_PORT_INDEX(thread)) {
+        suspend_thread = false;
+    }
+
+    /* Suspend the thread */
+    suspend_start = mach_absolute_time();
+    if (suspend_thread && thread_suspend(thread) != KERN_SUCCESS) {
+        PLCF_DEBUG("Could not suspend thread %d", thread_number);
+        return 0;
+    }
+
+    /* Determine the size */
+    walk_start = mach_absolute_time();
+    size = plcrash_writer_write_thread(NULL, writer, thread, thread_number, crashctx);
+
+    /* Write message (if it fits) */
+    write_start = mach_absolute_time();
+    writer->stats.thread_truncated = false;
+    if (max_bytes == 0 || plcrash_proto_crash_report_threads_pack(NULL, &size) + size <= max_bytes) {
+        rv += plcrash_proto_crash_report_threads_pack(file, &size);
+        rv += plcrash_writer_write_thread(file, writer, thread, thread_number, crashctx);
+    } else if (over_budget != NULL) {
+        *over_budget = true;
+    }
+    write_end = mach_absolute_time();
+
+    /* Resume the thread */
+    if (suspend_thread)
+        thread_resume(thread);
+
+    /* Record statistics */
+    if (file != NULL && rv > 0) {
+        writer->stats.bytes.threads += rv;
+        if (writer->stats.thread_truncated)
+            writer->stats.truncated_threads++;
+
+        if (writer->stats.thread_count < PLCRASH_LOG_WRITER_STATS_MAX_THREADS) {
+            plcrash_log_writer_thread_stats_t *stats = &writer->stats.threads[writer->stats.thread_count++];
+            stats->thread_number = thread_number;
+            stats->suspend_time = walk_start - suspend_start;
+            stats->walk_time = write_start - walk_start;
+            stats->write_time = write_end - write_start;
+            stats->truncated = writer->stats.thread_truncated;
+        }
+    }
+
+    return rv;
+}
+
+/**
+ * @internal
+ *
+ * Write a complete CrashReport.binary_images message.
+ *
+ * @param file Output file
+ * @param writer Writer context
+ * @param image The image to be written.
+ * @param max_bytes Maximum number of bytes that may be written, or 0 if unlimited. If the message would exceed
+ * this value, nothing is written.
+ * @param over_budget If non-NULL, set to true if the message was not written due to @a max_bytes.
+ *
+ * @return Returns the number of bytes written.
+ */
+static size_t plcrash_writer_write_binary_image_message (plcrash_async_file_t *file, plcrash_log_writer_t *writer,
+                                                         plcrash_async_image_t *image, size_t max_bytes, bool *over_budget)
+{
+    uint64_t start_time = mach_absolute_time();
+    uint32_t size;
+    size_t rv = 0;
+
+    /* Calculate the message size */
+    // TODO - switch to plframe_read_addr()
+    size = plcrash_writer_write_binary_image(NULL, image->name, (const void *) image->header);
+    if (max_bytes != 0 && plcrash_proto_crash_report_binary_images_pack(NULL, &size) + size > max_bytes) {
+        if (over_budget != NULL)
+            *over_budget = true;
+        return 0;
+    }
+
+    rv += plcrash_proto_crash_report_binary_images_pack(file, &size);
+    rv += plcrash_writer_write_binary_image(file, image->name, (const void *) image->header);
+
+    /* Record statistics */
+    if (file != NULL) {
+        writer->stats.bytes.binary_images += rv;
+        writer->stats.image_time += mach_absolute_time() - start_time;
+    }
 
     return rv;
 }
 
+/**
+ * @internal
+ *
+ * Returns true if the prioritized write deadline has passed.
+ *
+ * @param writer Writer context
+ * @param start_time The mach_absolute_time() value at which the write began.
+ */
+static bool plcrash_writer_deadline_exceeded (plcrash_log_writer_t *writer, uint64_t start_time) {
+    if (writer->priority.deadline == 0)
+        return false;
+
+    return (mach_absolute_time() - start_time) > writer->priority.deadline;
+}
+
+/**
+ * @internal
+ *
+ * Returns the number of bytes that may still be written within the prioritized byte budget, or 0 if no budget
+ * is set. If the budget has been fully consumed, 1 is returned; no message can be written in a single byte.
+ *
+ * @param writer Writer context
+ * @param written Number of bytes already written.
+ */
+static size_t plcrash_writer_bytes_remaining (plcrash_log_writer_t *writer, size_t written) {
+    if (writer->priority.byte_budget == 0)
+        return 0;
+
+    if (written >= writer->priority.byte_budget)
+        return 1;
+
+    return writer->priority.byte_budget - written;
+}
+
+/**
+ * @internal
+ *
+ * Returns true if @a image's __TEXT segment contains any of the crashed thread's recorded frame addresses.
+ */
+static bool plcrash_writer_image_is_referenced (plcrash_log_writer_t *writer, plcrash_async_image_t *image) {
+    struct uuid_command *uuid;
+    cpu_type_t cpu_type;
+    cpu_subtype_t cpu_subtype;
+    uint64_t text_size;
+
+    if (!plcrash_writer_parse_image((const void *) image->header, &text_size, &uuid, &cpu_type, &cpu_subtype))
+        return false;
+
+    for (size_t i = 0; i < writer->priority.pc_count; i++) {
+        uintptr_t pc = writer->priority.pcs[i];
+        if (pc >= image->header && pc - image->header < text_size)
+            return true;
+    }
+
+    return false;
+}
+
+/**
+ * @internal
+ *
+ * Returns true if @a image was already written as part of the prioritized image set.
+ */
+static bool plcrash_writer_image_is_written (plcrash_log_writer_t *writer, plcrash_async_image_t *image) {
+    for (size_t i = 0; i < writer->priority.image_count; i++) {
+        if (writer->priority.images[i] == image->header)
+            return true;
+    }
+
+    return false;
+}
+
 /**
  * Write the crash report. All other running threads are suspended while the crash report is generated.
  *
+ * If prioritized output has been enabled via plcrash_log_writer_set_priority(), the signal, exception,
+ * crashed thread, and the binary images referenced by the crashed thread are written first. The remaining
+ * threads and images are then written until the configured time or byte budget is exhausted, and any
+ * omissions are recorded in the report's truncation message.
+ *
  * @param writer The writer context
  * @param file The output file.
  * @param siginfo Signal information
@@ -1054,6 +1311,23 @@ static size_t plcrash_writer_write_signal (plcrash_async_file_t *file, siginfo_t
 plcrash_error_t plcrash_log_writer_write (plcrash_log_writer_t *writer, plcrash_async_file_t *file, siginfo_t *siginfo, ucontext_t *crashctx) {
     thread_act_array_t threads;
     mach_msg_type_number_t thread_count;
+    bool prioritized = writer->priority.enabled;
+    uint64_t start_time = mach_absolute_time();
+    size_t written = 0;
+    size_t mark;
+
+    /* Truncation state (prioritized output only) */
+    uint32_t omitted_threads = 0;
+    uint32_t omitted_images = 0;
+    bool deadline_exceeded = false;
+    bool byte_budget_exceeded = false;
+
+    /* Reset the writer statistics */
+    memset(&writer->stats.bytes, 0, sizeof(writer->stats.bytes));
+    writer->stats.image_time = 0;
+    writer->stats.read_failures = 0;
+    writer->stats.truncated_threads = 0;
+    writer->stats.thread_count = 0;
 
     /* File header */
     {
@@ -1062,6 +1336,28 @@ plcrash_error_t plcrash_log_writer_write (plcrash_log_writer_t *writer, plcrash_
         /* Write the magic string (with no trailing NULL) and the version number */
         plcrash_async_file_write(file, PLCRASH_REPORT_FILE_MAGIC, strlen(PLCRASH_REPORT_FILE_MAGIC));
         plcrash_async_file_write(file, &version, sizeof(version));
+        written += strlen(PLCRASH_REPORT_FILE_MAGIC) + sizeof(version);
+    }
+
+    /* In prioritized mode, the signal and exception are written before anything else */
+    if (prioritized) {
+        uint32_t size;
+
+        /* Signal */
+        mark = written;
+        size = plcrash_writer_write_signal(NULL, siginfo);
+        written += plcrash_proto_crash_report_signal_pack(file, &size);
+        written += plcrash_writer_write_signal(file, siginfo);
+        writer->stats.bytes.signal = written - mark;
+
+        /* Exception */
+        if (writer->uncaught_exception.has_exception) {
+            mark = written;
+            size = plcrash_writer_write_exception(NULL, writer);
+            written += plcrash_proto_crash_report_exception_pack(file, &size);
+            written += plcrash_writer_write_exception(file, writer);
+            writer->stats.bytes.exception = written - mark;
+        }
     }
 
     /* System Info */
@@ -1079,8 +1375,10 @@ plcrash_error_t plcrash_log_writer_write (plcrash_log_writer_t *writer, plcrash_
         size = plcrash_writer_write_system_info(NULL, writer, timestamp);
         
         /* Write message */
-        plcrash_writer_pack(file, PLCRASH_PROTO_SYSTEM_INFO_ID, PLPROTOBUF_C_TYPE_MESSAGE, &size);
-        plcrash_writer_write_system_info(file, writer, timestamp);
+        mark = written;
+        written += plcrash_proto_crash_report_system_info_pack(file, &size);
+        written += plcrash_writer_write_system_info(file, writer, timestamp);
+        writer->stats.bytes.system_info = written - mark;
     }
     
     /* Machine Info */
@@ -1091,8 +1389,10 @@ plcrash_error_t plcrash_log_writer_write (plcrash_log_writer_t *writer, plcrash_
         size = plcrash_writer_write_machine_info(NULL, writer);
 
         /* Write message */
-        plcrash_writer_pack(file, PLCRASH_PROTO_MACHINE_INFO_ID, PLPROTOBUF_C_TYPE_MESSAGE, &size);
-        plcrash_writer_write_machine_info(file, writer);
+        mark = written;
+        written += plcrash_proto_crash_report_machine_info_pack(file, &size);
+        written += plcrash_writer_write_machine_info(file, writer);
+        writer->stats.bytes.machine_info = written - mark;
     }
 
     /* App info */
@@ -1103,8 +1403,10 @@ plcrash_error_t plcrash_log_writer_write (plcrash_log_writer_t *writer, plcrash_
         size = plcrash_writer_write_app_info(NULL, writer->application_info.app_identifier, writer->application_info.app_version);
         
         /* Write message */
-        plcrash_writer_pack(file, PLCRASH_PROTO_APP_INFO_ID, PLPROTOBUF_C_TYPE_MESSAGE, &size);
-        plcrash_writer_write_app_info(file, writer->application_info.app_identifier, writer->application_info.app_version);
+        mark = written;
+        written += plcrash_proto_crash_report_application_info_pack(file, &size);
+        written += plcrash_writer_write_app_info(file, writer->application_info.app_identifier, writer->application_info.app_version);
+        writer->stats.bytes.application_info = written - mark;
     }
     
     /* Process info */
@@ -1112,21 +1414,33 @@ plcrash_error_t plcrash_log_writer_write (plcrash_log_writer_t *writer, plcrash_
         uint32_t size;
         
         /* Determine size */
-        size = plcrash_writer_write_process_info(NULL, writer->process_info.process_name, writer->process_info.process_id, 
-                                                 writer->process_info.process_path, writer->process_info.parent_process_name,
-                                                 writer->process_info.parent_process_id, writer->process_info.native);
+        size = plcrash_writer_write_process_info(NULL, writer->host_info.process_info.process_name, writer->host_info.process_info.process_id, 
+                                                 writer->host_info.process_info.process_path, writer->host_info.process_info.parent_process_name,
+                                                 writer->host_info.process_info.parent_process_id, writer->host_info.process_info.native);
         
         /* Write message */
-        plcrash_writer_pack(file, PLCRASH_PROTO_PROCESS_INFO_ID, PLPROTOBUF_C_TYPE_MESSAGE, &size);
-        plcrash_writer_write_process_info(file, writer->process_info.process_name, writer->process_info.process_id, 
-                                          writer->process_info.process_path, writer->process_info.parent_process_name, 
-                                          writer->process_info.parent_process_id, writer->process_info.native);
+        mark = written;
+        written += plcrash_proto_crash_report_process_info_pack(file, &size);
+        written += plcrash_writer_write_process_info(file, writer->host_info.process_info.process_name, writer->host_info.process_info.process_id, 
+                                                     writer->host_info.process_info.process_path, writer->host_info.process_info.parent_process_name, 
+                                                     writer->host_info.process_info.parent_process_id, writer->host_info.process_info.native);
+        writer->stats.bytes.process_info = written - mark;
     }
     
     /* Threads */
     {
         task_t self = mach_task_self();
         thread_t self_thr = mach_thread_self();
+        mach_msg_type_number_t crashed_idx = 0;
+        bool have_crashed_thread = false;
+
+        /* Reset the stack memory budget and de-duplication state */
+        writer->stack_memory.used = 0;
+        writer->stack_memory.page_count = 0;
+
+        /* Reset the prioritized image state */
+        writer->priority.pc_count = 0;
+        writer->priority.image_count = 0;
 
         /* Get a list of all threads */
         if (task_threads(self, &threads, &thread_count) != KERN_SUCCESS) {
@@ -1134,33 +1448,69 @@ plcrash_error_t plcrash_log_writer_write (plcrash_log_writer_t *writer, plcrash_
             thread_count = 0;
         }
 
-        /* Suspend each thread and write out its state */
+        /* Find the crashed thread */
         for (mach_msg_type_number_t i = 0; i < thread_count; i++) {
-            thread_t thread = threads[i];
-            uint32_t size;
-            bool suspend_thread = true;
-            
-            /* Check if we're running on the to be examined thread */
             if (MACH_PORT_INDEX(self_thr) == MACH_PORT_INDEX(threads[i])) {
-                suspend_thread = false;
+                crashed_idx = i;
+                have_crashed_thread = true;
+                break;
             }
-            
-            /* Suspend the thread */
-            if (suspend_thread && thread_suspend(threads[i]) != KERN_SUCCESS) {
-                PLCF_DEBUG("Could not suspend thread %d", i);
-                continue;
+        }
+
+        /* Reserve the crashed thread's stack window, so that the threads preceding it can not exhaust the budget */
+        writer->stack_memory.reserved = 0;
+        writer->stack_memory.reserved_pages = 0;
+        if (writer->stack_memory.enabled && have_crashed_thread) {
+            uint64_t window = (uint64_t) writer->stack_memory.below_sp + writer->stack_memory.above_sp;
+            uint64_t pages = (window + writer->stack_memory.page_size - 1) / writer->stack_memory.page_size + 1;
+
+            writer->stack_memory.reserved = (uint32_t) MIN(window, (uint64_t) writer->stack_memory.budget);
+            writer->stack_memory.reserved_pages = (size_t) MIN(pages, (uint64_t) PLCRASH_LOG_WRITER_STACK_MAX_PAGES);
+        }
+
+        /* Write the crashed thread, followed by the images it references */
+        if (prioritized && have_crashed_thread) {
+            plcrash_async_image_t *image = NULL;
+
+            written += plcrash_writer_write_thread_message(file, writer, threads[crashed_idx], crashed_idx, crashctx, 0, NULL);
+
+            plcrash_async_image_list_set_reading(&writer->image_info.image_list, true);
+            while ((image = plcrash_async_image_list_next(&writer->image_info.image_list, image)) != NULL) {
+                if (writer->priority.image_count == PLCRASH_LOG_WRITER_PRIORITY_MAX_IMAGES)
+                    break;
+
+                if (!plcrash_writer_image_is_referenced(writer, image))
+                    continue;
+
+                written += plcrash_writer_write_binary_image_message(file, writer, image, 0, NULL);
+                writer->priority.images[writer->priority.image_count++] = image->header;
             }
-            
-            /* Determine the size */
-            size = plcrash_writer_write_thread(NULL, thread, i, crashctx);
-            
-            /* Write message */
-            plcrash_writer_pack(file, PLCRASH_PROTO_THREADS_ID, PLPROTOBUF_C_TYPE_MESSAGE, &size);
-            plcrash_writer_write_thread(file, thread, i, crashctx);
+            plcrash_async_image_list_set_reading(&writer->image_info.image_list, false);
+        }
 
-            /* Resume the thread */
-            if (suspend_thread)
-                thread_resume(threads[i]);
+        /* Suspend each thread and write out its state */
+        for (mach_msg_type_number_t i = 0; i < thread_count; i++) {
+            if (prioritized) {
+                /* Already written */
+                if (have_crashed_thread && i == crashed_idx)
+                    continue;
+
+                /* Check the budgets */
+                if (!deadline_exceeded && plcrash_writer_deadline_exceeded(writer, start_time))
+                    deadline_exceeded = true;
+
+                if (deadline_exceeded || byte_budget_exceeded) {
+                    omitted_threads++;
+                    continue;
+                }
+
+                written += plcrash_writer_write_thread_message(file, writer, threads[i], i, crashctx,
+                                                               plcrash_writer_bytes_remaining(writer, written), &byte_budget_exceeded);
+                if (byte_budget_exceeded)
+                    omitted_threads++;
+            } else {
+                written += plcrash_writer_write_thread_message(file, writer, threads[i], i, crashctx, 0, NULL);
+            }
         }
         
         /* Clean up the thread array */
@@ -1174,41 +1524,132 @@ plcrash_error_t plcrash_log_writer_write (plcrash_log_writer_t *writer, plcrash_
 
     plcrash_async_image_t *image = NULL;
     while ((image = plcrash_async_image_list_next(&writer->image_info.image_list, image)) != NULL) {
-        uint32_t size;
+        if (prioritized) {
+            /* Already written */
+            if (plcrash_writer_image_is_written(writer, image))
+                continue;
+
+            /* Check the budgets */
+            if (!deadline_exceeded && plcrash_writer_deadline_exceeded(writer, start_time))
+                deadline_exceeded = true;
 
-        /* Calculate the message size */
-        // TODO - switch to plframe_read_addr()
-        size = plcrash_writer_write_binary_image(NULL, image->name, (const void *) image->header);
-        plcrash_writer_pack(file, PLCRASH_PROTO_BINARY_IMAGES_ID, PLPROTOBUF_C_TYPE_MESSAGE, &size);
-        plcrash_writer_write_binary_image(file, image->name, (const void *) image->header);
+            if (deadline_exceeded || byte_budget_exceeded) {
+                omitted_images++;
+                continue;
+            }
+
+            written += plcrash_writer_write_binary_image_message(file, writer, image, plcrash_writer_bytes_remaining(writer, written), &byte_budget_exceeded);
+            if (byte_budget_exceeded)
+                omitted_images++;
+        } else {
+            written += plcrash_writer_write_binary_image_message(file, writer, image, 0, NULL);
+        }
     }
 
     plcrash_async_image_list_set_reading(&writer->image_info.image_list, false);
 
-    /* Exception */
-    if (writer->uncaught_exception.has_exception) {
+    if (!prioritized) {
+        /* Exception */
+        if (writer->uncaught_exception.has_exception) {
+            uint32_t size;
+
+            /* Calculate the message size */
+            mark = written;
+            size = plcrash_writer_write_exception(NULL, writer);
+            written += plcrash_proto_crash_report_exception_pack(file, &size);
+            written += plcrash_writer_write_exception(file, writer);
+            writer->stats.bytes.exception = written - mark;
+        }
+        
+        /* Signal */
+        {
+            uint32_t size;
+            
+            /* Calculate the message size */
+            mark = written;
+            size = plcrash_writer_write_signal(NULL, siginfo);
+            written += plcrash_proto_crash_report_signal_pack(file, &size);
+            written += plcrash_writer_write_signal(file, siginfo);
+            writer->stats.bytes.signal = written - mark;
+        }
+    }
+
+    /* Record any truncation. This is written regardless of the byte budget; it is small, and the byte budget is
+     * expected to leave headroom below the file's hard output limit. */
+    if (omitted_threads > 0 || omitted_images > 0) {
         uint32_t size;
 
-        /* Calculate the message size */
-        size = plcrash_writer_write_exception(NULL, writer);
-        plcrash_writer_pack(file, PLCRASH_PROTO_EXCEPTION_ID, PLPROTOBUF_C_TYPE_MESSAGE, &size);
-        plcrash_writer_write_exception(file, writer);
+        size = plcrash_writer_write_truncation(NULL, omitted_threads, omitted_images, deadline_exceeded, byte_budget_exceeded);
+        plcrash_proto_crash_report_truncation_pack(file, &size);
+        plcrash_writer_write_truncation(file, omitted_threads, omitted_images, deadline_exceeded, byte_budget_exceeded);
     }
-    
-    /* Signal */
-    {
+
+    /* Writer statistics. The elapsed time must stay the same across both calls. */
+    if (writer->stats.enabled) {
+        uint64_t total_time = mach_absolute_time() - start_time;
         uint32_t size;
-        
-        /* Calculate the message size */
-        size = plcrash_writer_write_signal(NULL, siginfo);
-        plcrash_writer_pack(file, PLCRASH_PROTO_SIGNAL_ID, PLPROTOBUF_C_TYPE_MESSAGE, &size);
-        plcrash_writer_write_signal(file, siginfo);
+
+        size = plcrash_writer_write_stats(NULL, writer, total_time);
+        plcrash_proto_crash_report_writer_stats_pack(file, &size);
+        plcrash_writer_write_stats(file, writer, total_time);
     }
     
     return PLCRASH_ESUCCESS;
 }
 
 
+/**
+ * Write a crash report for @a thread to @a path, as if @a thread had crashed with SIGSEGV. Any existing file at
+ * @a path is replaced. (For testing only!)
+ *
+ * @param thread A suspended or blocked thread to use as the crashed thread, eg, one started with
+ * plframe_test_thread_spawn().
+ * @param path The path to write the report to.
+ * @param extended If true, stack memory capture and writer statistics are enabled.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, or an error if the report could not be written.
+ */
+plcrash_error_t plcrash_log_writer_write_test_report (thread_t thread, const char *path, bool extended) {
+    siginfo_t info;
+    plframe_cursor_t cursor;
+    plcrash_log_writer_t writer;
+    plcrash_async_file_t file;
+    plcrash_error_t err;
+    int fd;
+
+    /* Initialze faux crash data */
+    memset(&info, 0, sizeof(info));
+    info.si_signo = SIGSEGV;
+    info.si_code = SEGV_MAPERR;
+    if (plframe_cursor_thread_init(&cursor, thread) != PLFRAME_ESUCCESS)
+        return PLCRASH_EINTERNAL;
+
+    /* Open the output file */
+    fd = open(path, O_RDWR|O_CREAT|O_TRUNC, 0644);
+    if (fd < 0)
+        return PLCRASH_OUTPUT_ERR;
+    plcrash_async_file_init(&file, fd, 0);
+
+    if ((err = plcrash_log_writer_init(&writer, @"test.id", @"1.0")) == PLCRASH_ESUCCESS) {
+        if (extended) {
+            err = plcrash_log_writer_set_stack_capture(&writer, 128, 1024, true, 4096);
+            plcrash_log_writer_set_stats_enabled(&writer, true);
+        }
+
+        /* Write the crash report */
+        if (err == PLCRASH_ESUCCESS)
+            err = plcrash_log_writer_write(&writer, &file, &info, cursor.uap);
+        plcrash_log_writer_close(&writer);
+    }
+    plcrash_log_writer_free(&writer);
+
+    if (!plcrash_async_file_flush(&file) && err == PLCRASH_ESUCCESS)
+        err = PLCRASH_OUTPUT_ERR;
+    plcrash_async_file_close(&file);
+
+    return err;
+}
+
 /**
  * @} plcrash_log_writer
  */
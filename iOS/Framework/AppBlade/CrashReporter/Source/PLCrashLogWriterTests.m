@@ -40,6 +40,7 @@
 #import <mach-o/loader.h>
 
 #import "crash_report.pb-c.h"
+#import "PLCrashReportDecoder.h"
 
 @interface PLCrashLogWriterTests : SenTestCase {
 @private
@@ -274,4 +275,356 @@
     plcrash_async_file_close(&file);
 }
 
+- (void) testWritePrioritizedReport {
+    siginfo_t info;
+    plframe_cursor_t cursor;
+    plcrash_log_writer_t writer;
+    plcrash_async_file_t file;
+
+    /* Initialze faux crash data */
+    memset(&info, 0, sizeof(info));
+    info.si_signo = SIGSEGV;
+    info.si_code = SEGV_MAPERR;
+    plframe_cursor_thread_init(&cursor, pthread_mach_thread_np(_thr_args.thread));
+
+    /* Open the output file */
+    int fd = open([_logPath UTF8String], O_RDWR|O_CREAT|O_EXCL, 0644);
+    plcrash_async_file_init(&file, fd, 0);
+
+    /* Initialize a writer with a byte budget too small for anything but the prioritized sections */
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_log_writer_init(&writer, @"test.id", @"1.0"), @"Initialization failed");
+    plcrash_log_writer_set_priority(&writer, 0, 1);
+
+    /* Write the crash report */
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_log_writer_write(&writer, &file, &info, cursor.uap), @"Crash log failed");
+    plcrash_log_writer_close(&writer);
+    plcrash_log_writer_free(&writer);
+    plcrash_async_file_flush(&file);
+
+    /* Read it back in */
+    struct stat statbuf;
+    STAssertEquals(0, stat([_logPath UTF8String], &statbuf), @"fstat failed");
+    void *buf = mmap(NULL, statbuf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    STAssertNotNULL(buf, @"Could not map pages");
+
+    struct PLCrashReportFileHeader *header = buf;
+    Plcrash__CrashReport *crashReport;
+    crashReport = plcrash__crash_report__unpack(&protobuf_c_system_allocator, statbuf.st_size - sizeof(struct PLCrashReportFileHeader), header->data);
+    STAssertNotNULL(crashReport, @"Could not decode crash report");
+
+    if (crashReport != NULL) {
+        [self checkSystemInfo: crashReport];
+
+        /* Only the crashed thread should have been written */
+        STAssertEquals((size_t) 1, crashReport->n_threads, @"Unexpected thread count");
+        if (crashReport->n_threads > 0)
+            STAssertTrue(crashReport->threads[0]->crashed, @"The crashed thread was not written");
+
+        /* The signal must always be written */
+        STAssertNotNULL(crashReport->signal, @"No signal was written");
+
+        /* The omitted threads must be recorded */
+        STAssertNotNULL(crashReport->truncation, @"No truncation record was written");
+        if (crashReport->truncation != NULL) {
+            STAssertTrue(crashReport->truncation->omitted_threads > 0, @"No omitted threads recorded");
+            STAssertTrue(crashReport->truncation->byte_budget_exceeded, @"Byte budget exhaustion not recorded");
+            STAssertFalse(crashReport->truncation->deadline_exceeded, @"Deadline exhaustion recorded with no deadline");
+        }
+
+        protobuf_c_message_free_unpacked((ProtobufCMessage *) crashReport, &protobuf_c_system_allocator);
+    }
+
+    STAssertEquals(0, munmap(buf, statbuf.st_size), @"Could not unmap pages: %s", strerror(errno));
+    plcrash_async_file_close(&file);
+}
+
+- (void) testWriteStackMemory {
+    siginfo_t info;
+    plframe_cursor_t cursor;
+    plcrash_log_writer_t writer;
+    plcrash_async_file_t file;
+    const uint32_t budget = 2048;
+
+    /* Initialze faux crash data */
+    memset(&info, 0, sizeof(info));
+    info.si_signo = SIGSEGV;
+    info.si_code = SEGV_MAPERR;
+    plframe_cursor_thread_init(&cursor, pthread_mach_thread_np(_thr_args.thread));
+
+    /* Open the output file */
+    int fd = open([_logPath UTF8String], O_RDWR|O_CREAT|O_EXCL, 0644);
+    plcrash_async_file_init(&file, fd, 0);
+
+    /* Initialize a writer with stack capture enabled for all threads */
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_log_writer_init(&writer, @"test.id", @"1.0"), @"Initialization failed");
+    STAssertEquals(PLCRASH_EINVAL, plcrash_log_writer_set_stack_capture(&writer, 128, 1024, true, 0), @"Zero budget accepted");
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_log_writer_set_stack_capture(&writer, 128, 1024, true, budget), @"Stack capture configuration failed");
+
+    /* Write the crash report */
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_log_writer_write(&writer, &file, &info, cursor.uap), @"Crash log failed");
+    plcrash_log_writer_close(&writer);
+    plcrash_log_writer_free(&writer);
+    plcrash_async_file_flush(&file);
+
+    /* Read it back in */
+    struct stat statbuf;
+    STAssertEquals(0, stat([_logPath UTF8String], &statbuf), @"fstat failed");
+    void *buf = mmap(NULL, statbuf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    STAssertNotNULL(buf, @"Could not map pages");
+
+    struct PLCrashReportFileHeader *header = buf;
+    Plcrash__CrashReport *crashReport;
+    crashReport = plcrash__crash_report__unpack(&protobuf_c_system_allocator, statbuf.st_size - sizeof(struct PLCrashReportFileHeader), header->data);
+    STAssertNotNULL(crashReport, @"Could not decode crash report");
+
+    if (crashReport != NULL) {
+        uintptr_t pages[PLCRASH_LOG_WRITER_STACK_MAX_PAGES];
+        size_t page_count = 0;
+        size_t total = 0;
+        BOOL foundCrashedMemory = NO;
+
+        for (size_t i = 0; i < crashReport->n_threads; i++) {
+            Plcrash__CrashReport__Thread *thread = crashReport->threads[i];
+
+            if (thread->crashed && thread->n_stack_memory > 0)
+                foundCrashedMemory = YES;
+
+            for (size_t j = 0; j < thread->n_stack_memory; j++) {
+                Plcrash__CrashReport__Thread__StackMemory *mem = thread->stack_memory[j];
+                uintptr_t page = (uintptr_t) mem->base_address & ~((uintptr_t) vm_page_size - 1);
+
+                STAssertTrue(mem->contents.len > 0, @"Empty stack memory range");
+                STAssertTrue(mem->base_address + mem->contents.len <= page + vm_page_size, @"Stack memory range crosses a page boundary");
+
+                /* Verify that no page is written twice */
+                for (size_t k = 0; k < page_count; k++)
+                    STAssertNotEquals(pages[k], page, @"Page %p was written twice", (void *) page);
+
+                STAssertTrue(page_count < PLCRASH_LOG_WRITER_STACK_MAX_PAGES, @"Page limit exceeded");
+                if (page_count < PLCRASH_LOG_WRITER_STACK_MAX_PAGES)
+                    pages[page_count++] = page;
+
+                total += mem->contents.len;
+            }
+        }
+
+        STAssertTrue(foundCrashedMemory, @"No stack memory was written for the crashed thread");
+        STAssertTrue(total <= budget, @"Stack memory budget exceeded (%zu > %u)", total, budget);
+
+        protobuf_c_message_free_unpacked((ProtobufCMessage *) crashReport, &protobuf_c_system_allocator);
+    }
+
+    STAssertEquals(0, munmap(buf, statbuf.st_size), @"Could not unmap pages: %s", strerror(errno));
+    plcrash_async_file_close(&file);
+}
+
+/* Threads preceding the crashed thread must not consume the budget reserved for the crashed thread's window */
+- (void) testWriteStackMemoryReservesCrashedThread {
+    siginfo_t info;
+    plframe_cursor_t cursor;
+    plcrash_log_writer_t writer;
+    plcrash_async_file_t file;
+    const uint32_t below_sp = 128;
+    const uint32_t above_sp = 1024;
+
+    /* Initialze faux crash data */
+    memset(&info, 0, sizeof(info));
+    info.si_signo = SIGSEGV;
+    info.si_code = SEGV_MAPERR;
+    plframe_cursor_thread_init(&cursor, pthread_mach_thread_np(_thr_args.thread));
+
+    /* Open the output file */
+    int fd = open([_logPath UTF8String], O_RDWR|O_CREAT|O_EXCL, 0644);
+    plcrash_async_file_init(&file, fd, 0);
+
+    /* Capture all threads, with a budget that only covers a single window */
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_log_writer_init(&writer, @"test.id", @"1.0"), @"Initialization failed");
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_log_writer_set_stack_capture(&writer, below_sp, above_sp, true, below_sp + above_sp), @"Stack capture configuration failed");
+
+    /* Write the crash report */
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_log_writer_write(&writer, &file, &info, cursor.uap), @"Crash log failed");
+    plcrash_log_writer_close(&writer);
+    plcrash_log_writer_free(&writer);
+    plcrash_async_file_flush(&file);
+
+    /* Read it back in */
+    struct stat statbuf;
+    STAssertEquals(0, stat([_logPath UTF8String], &statbuf), @"fstat failed");
+    void *buf = mmap(NULL, statbuf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    STAssertNotNULL(buf, @"Could not map pages");
+
+    struct PLCrashReportFileHeader *header = buf;
+    Plcrash__CrashReport *crashReport;
+    crashReport = plcrash__crash_report__unpack(&protobuf_c_system_allocator, statbuf.st_size - sizeof(struct PLCrashReportFileHeader), header->data);
+    STAssertNotNULL(crashReport, @"Could not decode crash report");
+
+    if (crashReport != NULL) {
+        BOOL foundCrashedThread = NO;
+
+        for (size_t i = 0; i < crashReport->n_threads; i++) {
+            Plcrash__CrashReport__Thread *thread = crashReport->threads[i];
+
+            if (thread->crashed) {
+                STAssertTrue(thread->n_stack_memory > 0, @"No stack memory was written for the crashed thread");
+                foundCrashedThread = YES;
+                break;
+            }
+
+            STAssertEquals(thread->n_stack_memory, (size_t) 0, @"Thread %u consumed the crashed thread's reservation", thread->thread_number);
+        }
+
+        STAssertTrue(foundCrashedThread, @"No crashed thread");
+        protobuf_c_message_free_unpacked((ProtobufCMessage *) crashReport, &protobuf_c_system_allocator);
+    }
+
+    STAssertEquals(0, munmap(buf, statbuf.st_size), @"Could not unmap pages: %s", strerror(errno));
+    plcrash_async_file_close(&file);
+}
+
+- (void) testWriteStats {
+    siginfo_t info;
+    plframe_cursor_t cursor;
+    plcrash_log_writer_t writer;
+    plcrash_async_file_t file;
+
+    /* Initialze faux crash data */
+    memset(&info, 0, sizeof(info));
+    info.si_signo = SIGSEGV;
+    info.si_code = SEGV_MAPERR;
+    plframe_cursor_thread_init(&cursor, pthread_mach_thread_np(_thr_args.thread));
+
+    /* Open the output file */
+    int fd = open([_logPath UTF8String], O_RDWR|O_CREAT|O_EXCL, 0644);
+    plcrash_async_file_init(&file, fd, 0);
+
+    /* Initialize a writer with statistics enabled */
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_log_writer_init(&writer, @"test.id", @"1.0"), @"Initialization failed");
+    plcrash_log_writer_set_stats_enabled(&writer, true);
+
+    /* Write the crash report */
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_log_writer_write(&writer, &file, &info, cursor.uap), @"Crash log failed");
+    plcrash_log_writer_close(&writer);
+    plcrash_log_writer_free(&writer);
+    plcrash_async_file_flush(&file);
+
+    /* Read it back in */
+    struct stat statbuf;
+    STAssertEquals(0, stat([_logPath UTF8String], &statbuf), @"fstat failed");
+    void *buf = mmap(NULL, statbuf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    STAssertNotNULL(buf, @"Could not map pages");
+
+    struct PLCrashReportFileHeader *header = buf;
+    Plcrash__CrashReport *crashReport;
+    crashReport = plcrash__crash_report__unpack(&protobuf_c_system_allocator, statbuf.st_size - sizeof(struct PLCrashReportFileHeader), header->data);
+    STAssertNotNULL(crashReport, @"Could not decode crash report");
+
+    if (crashReport != NULL) {
+        Plcrash__CrashReport__WriterStats *stats = crashReport->writer_stats;
+        STAssertNotNULL(stats, @"No writer statistics were written");
+
+        if (stats != NULL) {
+            /* Every written thread should have an entry */
+            STAssertEquals(crashReport->n_threads, stats->n_threads, @"Thread statistics count does not match thread count");
+            for (size_t i = 0; i < stats->n_threads && i < crashReport->n_threads; i++)
+                STAssertEquals(crashReport->threads[i]->thread_number, stats->threads[i]->thread_number, @"Thread number mismatch");
+
+            STAssertTrue(stats->total_time >= stats->image_time, @"Image time exceeds total time");
+
+            /* Every required section must have been measured */
+            STAssertTrue(stats->system_info_bytes > 0, @"System info size not recorded");
+            STAssertTrue(stats->machine_info_bytes > 0, @"Machine info size not recorded");
+            STAssertTrue(stats->application_info_bytes > 0, @"Application info size not recorded");
+            STAssertTrue(stats->process_info_bytes > 0, @"Process info size not recorded");
+            STAssertTrue(stats->threads_bytes > 0, @"Thread size not recorded");
+            STAssertTrue(stats->binary_images_bytes > 0, @"Binary image size not recorded");
+            STAssertTrue(stats->signal_bytes > 0, @"Signal size not recorded");
+            STAssertEquals((uint32_t) 0, stats->exception_bytes, @"Exception size recorded with no exception");
+
+            /* The sections can not exceed the file's size */
+            uint64_t total = stats->system_info_bytes + stats->machine_info_bytes + stats->application_info_bytes +
+                stats->process_info_bytes + stats->threads_bytes + stats->binary_images_bytes + stats->signal_bytes;
+            STAssertTrue(total < (uint64_t) statbuf.st_size, @"Section sizes exceed the report size");
+        }
+
+        protobuf_c_message_free_unpacked((ProtobufCMessage *) crashReport, &protobuf_c_system_allocator);
+    }
+
+    STAssertEquals(0, munmap(buf, statbuf.st_size), @"Could not unmap pages: %s", strerror(errno));
+    plcrash_async_file_close(&file);
+}
+
+/* The generated decoder must produce the same message as the generic protobuf-c decoder */
+- (void) testGeneratedDecoder {
+    siginfo_t info;
+    plframe_cursor_t cursor;
+    plcrash_log_writer_t writer;
+    plcrash_async_file_t file;
+
+    /* Initialze faux crash data */
+    memset(&info, 0, sizeof(info));
+    info.si_signo = SIGSEGV;
+    info.si_code = SEGV_MAPERR;
+    plframe_cursor_thread_init(&cursor, pthread_mach_thread_np(_thr_args.thread));
+
+    /* Open the output file */
+    int fd = open([_logPath UTF8String], O_RDWR|O_CREAT|O_EXCL, 0644);
+    plcrash_async_file_init(&file, fd, 0);
+
+    /* Initialize a writer with every optional section enabled */
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_log_writer_init(&writer, @"test.id", @"1.0"), @"Initialization failed");
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_log_writer_set_stack_capture(&writer, 128, 1024, true, 4096), @"Stack capture configuration failed");
+    plcrash_log_writer_set_stats_enabled(&writer, true);
+
+    /* Write the crash report */
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_log_writer_write(&writer, &file, &info, cursor.uap), @"Crash log failed");
+    plcrash_log_writer_close(&writer);
+    plcrash_log_writer_free(&writer);
+    plcrash_async_file_flush(&file);
+
+    /* Read it back in */
+    struct stat statbuf;
+    STAssertEquals(0, stat([_logPath UTF8String], &statbuf), @"fstat failed");
+    void *buf = mmap(NULL, statbuf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    STAssertNotNULL(buf, @"Could not map pages");
+
+    struct PLCrashReportFileHeader *header = buf;
+    size_t length = statbuf.st_size - sizeof(struct PLCrashReportFileHeader);
+    Plcrash__CrashReport *expected = plcrash__crash_report__unpack(&protobuf_c_system_allocator, length, header->data);
+    Plcrash__CrashReport *actual = plcrash_proto_crash_report_unpack(&protobuf_c_system_allocator, length, header->data);
+    STAssertNotNULL(expected, @"Could not decode crash report");
+    STAssertNotNULL(actual, @"Could not decode crash report with the generated decoder");
+
+    if (expected != NULL && actual != NULL) {
+        /* Re-encoding both messages must produce identical output */
+        size_t expected_size = protobuf_c_message_get_packed_size((ProtobufCMessage *) expected);
+        size_t actual_size = protobuf_c_message_get_packed_size((ProtobufCMessage *) actual);
+        STAssertEquals(expected_size, actual_size, @"Decoded message sizes differ");
+        STAssertEquals(length, actual_size, @"Decoded message does not match the written size");
+
+        if (expected_size == actual_size) {
+            uint8_t *expected_data = malloc(expected_size);
+            uint8_t *actual_data = malloc(actual_size);
+
+            protobuf_c_message_pack((ProtobufCMessage *) expected, expected_data);
+            protobuf_c_message_pack((ProtobufCMessage *) actual, actual_data);
+            STAssertTrue(memcmp(expected_data, actual_data, expected_size) == 0, @"Decoded messages differ");
+
+            free(expected_data);
+            free(actual_data);
+        }
+    }
+
+    /* Truncated input must be rejected */
+    Plcrash__CrashReport *truncated = plcrash_proto_crash_report_unpack(&protobuf_c_system_allocator, length - 1, header->data);
+    STAssertNULL(truncated, @"Truncated crash report was decoded");
+
+    if (expected != NULL)
+        protobuf_c_message_free_unpacked((ProtobufCMessage *) expected, &protobuf_c_system_allocator);
+    if (actual != NULL)
+        protobuf_c_message_free_unpacked((ProtobufCMessage *) actual, &protobuf_c_system_allocator);
+
+    STAssertEquals(0, munmap(buf, statbuf.st_size), @"Could not unmap pages: %s", strerror(errno));
+    plcrash_async_file_close(&file);
+}
+
 @end
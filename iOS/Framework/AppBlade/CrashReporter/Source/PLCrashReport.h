@@ -35,6 +35,7 @@
 #import "PLCrashReportThreadInfo.h"
 #import "PLCrashReportBinaryImageInfo.h"
 #import "PLCrashReportExceptionInfo.h"
+#import "PLCrashReportWriterStats.h"
 
 /** 
  * @ingroup constants
@@ -74,6 +75,8 @@ struct PLCrashReportFileHeader {
  */
 typedef struct _PLCrashReportDecoder _PLCrashReportDecoder;
 
+struct plcrash_report;
+
 @interface PLCrashReport : NSObject {
 @private
     /** Private implementation variables (used to hide the underlying protobuf parser) */
@@ -102,12 +105,18 @@ typedef struct _PLCrashReportDecoder _PLCrashReportDecoder;
 
     /** Exception information (may be nil) */
     PLCrashReportExceptionInfo *_exceptionInfo;
+
+    /** Writer statistics (may be nil) */
+    PLCrashReportWriterStats *_writerStats;
 }
 
 - (id) initWithData: (NSData *) encodedData error: (NSError **) outError;
 
 - (PLCrashReportBinaryImageInfo *) imageForAddress: (uint64_t) address;
 
+/* Underlying Foundation-free report (PLCrashReportCore.h) */
+- (const struct plcrash_report *) coreReport;
+
 /**
  * System information.
  */
@@ -166,4 +175,15 @@ typedef struct _PLCrashReportDecoder _PLCrashReportDecoder;
  */
 @property(nonatomic, readonly) PLCrashReportExceptionInfo *exceptionInfo;
 
+/**
+ * YES if writer statistics are available.
+ */
+@property(nonatomic, readonly) BOOL hasWriterStats;
+
+/**
+ * Crash log writer statistics. Only available if writer statistics were enabled when the
+ * report was written, otherwise nil.
+ */
+@property(nonatomic, readonly) PLCrashReportWriterStats *writerStats;
+
 @end
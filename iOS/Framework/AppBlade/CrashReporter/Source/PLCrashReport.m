@@ -29,35 +29,38 @@
 #import "PLCrashReport.h"
 #import "CrashReporter.h"
 
-#import "crash_report.pb-c.h"
+#import "PLCrashReportCore.h"
 
 struct _PLCrashReportDecoder {
-    Plcrash__CrashReport *crashReport;
+    plcrash_report_t report;
 };
 
-#define IMAGE_UUID_DIGEST_LEN 16
-
 @interface PLCrashReport (PrivateMethods)
 
-- (Plcrash__CrashReport *) decodeCrashData: (NSData *) data error: (NSError **) outError;
-- (PLCrashReportSystemInfo *) extractSystemInfo: (Plcrash__CrashReport__SystemInfo *) systemInfo error: (NSError **) outError;
-- (PLCrashReportProcessorInfo *) extractProcessorInfo: (Plcrash__CrashReport__Processor *) processorInfo error: (NSError **) outError;
-- (PLCrashReportMachineInfo *) extractMachineInfo: (Plcrash__CrashReport__MachineInfo *) machineInfo error: (NSError **) outError;
-- (PLCrashReportApplicationInfo *) extractApplicationInfo: (Plcrash__CrashReport__ApplicationInfo *) applicationInfo error: (NSError **) outError;
-- (PLCrashReportProcessInfo *) extractProcessInfo: (Plcrash__CrashReport__ProcessInfo *) processInfo error: (NSError **) outError;
-- (NSArray *) extractThreadInfo: (Plcrash__CrashReport *) crashReport error: (NSError **) outError;
-- (NSArray *) extractImageInfo: (Plcrash__CrashReport *) crashReport error: (NSError **) outError;
-- (PLCrashReportExceptionInfo *) extractExceptionInfo: (Plcrash__CrashReport__Exception *) exceptionInfo error: (NSError **) outError;
-- (PLCrashReportSignalInfo *) extractSignalInfo: (Plcrash__CrashReport__Signal *) signalInfo error: (NSError **) outError;
+- (PLCrashReportSystemInfo *) extractSystemInfo: (const plcrash_report_system_info_t *) systemInfo;
+- (PLCrashReportProcessorInfo *) extractProcessorInfo: (const plcrash_report_processor_t *) processorInfo;
+- (PLCrashReportMachineInfo *) extractMachineInfo: (const plcrash_report_machine_info_t *) machineInfo;
+- (PLCrashReportApplicationInfo *) extractApplicationInfo: (const plcrash_report_application_info_t *) applicationInfo;
+- (PLCrashReportProcessInfo *) extractProcessInfo: (const plcrash_report_process_info_t *) processInfo;
+- (NSArray *) extractStackFrames: (size_t) frameIndex count: (size_t) frameCount;
+- (NSArray *) extractThreadInfo;
+- (NSArray *) extractImageInfo;
+- (PLCrashReportExceptionInfo *) extractExceptionInfo: (const plcrash_report_exception_info_t *) exceptionInfo;
+- (PLCrashReportSignalInfo *) extractSignalInfo: (const plcrash_report_signal_info_t *) signalInfo;
+- (PLCrashReportWriterStats *) extractWriterStats: (const plcrash_report_writer_stats_t *) writerStats;
 
 @end
 
 
 static void populate_nserror (NSError **error, PLCrashReporterError code, NSString *description);
+static NSString *string_or_nil (const char *str);
 
 /**
  * Provides decoding of crash logs generated by the PLCrashReporter framework.
  *
+ * Decoding and validation are performed by the Foundation-free plcrash_report_decode(); this class provides
+ * an Objective-C object model over the decoded report.
+ *
  * @warning This API should be considered in-development and subject to change.
  */
 @implementation PLCrashReport
@@ -76,6 +79,9 @@ static void populate_nserror (NSError **error, PLCrashReporterError code, NSStri
  * This method is the designated initializer for the PLCrashReport class.
  */
 - (id) initWithData: (NSData *) encodedData error: (NSError **) outError {
+    const char *description = NULL;
+    plcrash_report_t *report;
+
     if ((self = [super init]) == nil) {
         // This shouldn't happen, but we have to fufill our API contract
         populate_nserror(outError, PLCrashReporterErrorUnknown, @"Could not initialize superclass");
@@ -84,60 +90,49 @@ static void populate_nserror (NSError **error, PLCrashReporterError code, NSStri
 
 
     /* Allocate the struct and attempt to parse */
-    _decoder = malloc(sizeof(_PLCrashReportDecoder));
-    _decoder->crashReport = [self decodeCrashData: encodedData error: outError];
+    _decoder = calloc(1, sizeof(_PLCrashReportDecoder));
+    if (_decoder == NULL) {
+        populate_nserror(outError, PLCrashReporterErrorUnknown, @"Could not allocate crash report decoder");
+        goto error;
+    }
 
-    /* Check if decoding failed. If so, outError has already been populated. */
-    if (_decoder->crashReport == NULL) {
+    if (plcrash_report_decode(&_decoder->report, [encodedData bytes], [encodedData length], &description) != PLCRASH_ESUCCESS) {
+        populate_nserror(outError, PLCrashReporterErrorCrashReportInvalid, [NSString stringWithUTF8String: description]);
         goto error;
     }
 
+    report = &_decoder->report;
 
     /* System info */
-    _systemInfo = [[self extractSystemInfo: _decoder->crashReport->system_info error: outError] retain];
-    if (!_systemInfo)
-        goto error;
-    
+    _systemInfo = [[self extractSystemInfo: &report->system_info] retain];
+
     /* Machine info */
-    if (_decoder->crashReport->machine_info != NULL) {
-        _machineInfo = [[self extractMachineInfo: _decoder->crashReport->machine_info error: outError] retain];
-        if (!_machineInfo)
-            goto error;
-    }
+    if (report->has_machine_info)
+        _machineInfo = [[self extractMachineInfo: &report->machine_info] retain];
 
     /* Application info */
-    _applicationInfo = [[self extractApplicationInfo: _decoder->crashReport->application_info error: outError] retain];
-    if (!_applicationInfo)
-        goto error;
-    
+    _applicationInfo = [[self extractApplicationInfo: &report->application_info] retain];
+
     /* Process info. Handle missing info gracefully -- it is only included in v1.1+ crash reports. */
-    if (_decoder->crashReport->process_info != NULL) {
-        _processInfo = [[self extractProcessInfo: _decoder->crashReport->process_info error:outError] retain];
-        if (!_processInfo)
-            goto error;
-    }
+    if (report->has_process_info)
+        _processInfo = [[self extractProcessInfo: &report->process_info] retain];
 
     /* Signal info */
-    _signalInfo = [[self extractSignalInfo: _decoder->crashReport->signal error: outError] retain];
-    if (!_signalInfo)
-        goto error;
+    _signalInfo = [[self extractSignalInfo: &report->signal_info] retain];
 
     /* Thread info */
-    _threads = [[self extractThreadInfo: _decoder->crashReport error: outError] retain];
-    if (!_threads)
-        goto error;
+    _threads = [[self extractThreadInfo] retain];
 
     /* Image info */
-    _images = [[self extractImageInfo: _decoder->crashReport error: outError] retain];
-    if (!_images)
-        goto error;
+    _images = [[self extractImageInfo] retain];
 
     /* Exception info, if it is available */
-    if (_decoder->crashReport->exception != NULL) {
-        _exceptionInfo = [[self extractExceptionInfo: _decoder->crashReport->exception error: outError] retain];
-        if (!_exceptionInfo)
-            goto error;
-    }
+    if (report->has_exception_info)
+        _exceptionInfo = [[self extractExceptionInfo: &report->exception_info] retain];
+
+    /* Writer statistics, if available */
+    if (report->has_writer_stats)
+        _writerStats = [[self extractWriterStats: &report->writer_stats] retain];
 
     return self;
 
@@ -149,19 +144,18 @@ error:
 - (void) dealloc {
     /* Free the data objects */
     [_systemInfo release];
+    [_machineInfo release];
     [_applicationInfo release];
     [_processInfo release];
     [_signalInfo release];
     [_threads release];
     [_images release];
     [_exceptionInfo release];
+    [_writerStats release];
 
     /* Free the decoder state */
     if (_decoder != NULL) {
-        if (_decoder->crashReport != NULL) {
-            protobuf_c_message_free_unpacked((ProtobufCMessage *) _decoder->crashReport, &protobuf_c_system_allocator);
-        }
-
+        plcrash_report_free(&_decoder->report);
         free(_decoder);
         _decoder = NULL;
     }
@@ -176,13 +170,22 @@ error:
  * @param address The address to search for.
  */
 - (PLCrashReportBinaryImageInfo *) imageForAddress: (uint64_t) address {
-    for (PLCrashReportBinaryImageInfo *imageInfo in self.images) {
-        if (imageInfo.imageBaseAddress <= address && address < (imageInfo.imageBaseAddress + imageInfo.imageSize))
-            return imageInfo;
-    }
+    const plcrash_report_image_t *image = plcrash_report_image_for_address(&_decoder->report, address);
+    if (image == NULL)
+        return nil;
 
-    /* Not found */
-    return nil;
+    /* Images are extracted in report order */
+    return [_images objectAtIndex: (NSUInteger) (image - _decoder->report.images)];
+}
+
+/**
+ * @internal
+ *
+ * Return the underlying decoded report. The returned report is owned by the receiver, and remains valid
+ * for the lifetime of the receiver.
+ */
+- (const struct plcrash_report *) coreReport {
+    return &_decoder->report;
 }
 
 // property getter. Returns YES if machine information is available.
@@ -206,6 +209,13 @@ error:
     return NO;
 }
 
+// property getter. Returns YES if writer statistics are available.
+- (BOOL) hasWriterStats {
+    if (_writerStats != nil)
+        return YES;
+    return NO;
+}
+
 @synthesize systemInfo = _systemInfo;
 @synthesize machineInfo = _machineInfo;
 @synthesize applicationInfo = _applicationInfo;
@@ -214,343 +224,157 @@ error:
 @synthesize threads = _threads;
 @synthesize images = _images;
 @synthesize exceptionInfo = _exceptionInfo;
+@synthesize writerStats = _writerStats;
 
 @end
 
 
 /**
  * @internal
- * Private Methods
+ * Private Methods. The decoded report has already been validated by plcrash_report_decode(); these methods
+ * only build the corresponding Objective-C objects.
  */
 @implementation PLCrashReport (PrivateMethods)
 
 /**
- * Decode the crash log message.
- *
- * @warning MEMORY WARNING. The caller is responsible for deallocating th ePlcrash__CrashReport instance
- * returned by this method via protobuf_c_message_free_unpacked().
- */
-- (Plcrash__CrashReport *) decodeCrashData: (NSData *) data error: (NSError **) outError {
-    const struct PLCrashReportFileHeader *header;
-    const void *bytes;
-
-    bytes = [data bytes];
-    header = bytes;
-
-    /* Verify that the crash log is sufficently large */
-    if (sizeof(struct PLCrashReportFileHeader) >= [data length]) {
-        populate_nserror(outError, PLCrashReporterErrorCrashReportInvalid, NSLocalizedString(@"Could not decode truncated crash log",
-                                                                                             @"Crash log decoding error message"));
-        return NULL;
-    }
-
-    /* Check the file magic */
-    if (memcmp(header->magic, PLCRASH_REPORT_FILE_MAGIC, strlen(PLCRASH_REPORT_FILE_MAGIC)) != 0) {
-        populate_nserror(outError, PLCrashReporterErrorCrashReportInvalid,NSLocalizedString(@"Could not decode invalid crash log header",
-                                                                                            @"Crash log decoding error message"));
-        return NULL;
-    }
-
-    /* Check the version */
-    if(header->version != PLCRASH_REPORT_FILE_VERSION) {
-        populate_nserror(outError, PLCrashReporterErrorCrashReportInvalid, [NSString stringWithFormat: NSLocalizedString(@"Could not decode unsupported crash report version: %d", 
-                                                                                                                         @"Crash log decoding message"), header->version]);
-        return NULL;
-    }
-
-    Plcrash__CrashReport *crashReport = plcrash__crash_report__unpack(&protobuf_c_system_allocator, [data length] - sizeof(struct PLCrashReportFileHeader), header->data);
-    if (crashReport == NULL) {
-        populate_nserror(outError, PLCrashReporterErrorCrashReportInvalid, NSLocalizedString(@"An unknown error occured decoding the crash report", 
-                                                                                             @"Crash log decoding error message"));
-        return NULL;
-    }
-
-    return crashReport;
-}
-
-
-/**
- * Extract system information from the crash log. Returns nil on error.
+ * Extract system information from the crash log.
  */
-- (PLCrashReportSystemInfo *) extractSystemInfo: (Plcrash__CrashReport__SystemInfo *) systemInfo error: (NSError **) outError {
+- (PLCrashReportSystemInfo *) extractSystemInfo: (const plcrash_report_system_info_t *) systemInfo {
     NSDate *timestamp = nil;
-    NSString *osBuild = nil;
-    
-    /* Validate */
-    if (systemInfo == NULL) {
-        populate_nserror(outError, PLCrashReporterErrorCrashReportInvalid, 
-                         NSLocalizedString(@"Crash report is missing System Information section", 
-                                           @"Missing sysinfo in crash report"));
-        return nil;
-    }
-    
-    if (systemInfo->os_version == NULL) {
-        populate_nserror(outError, PLCrashReporterErrorCrashReportInvalid, 
-                         NSLocalizedString(@"Crash report is missing System Information OS version field", 
-                                           @"Missing sysinfo operating system in crash report"));
-        return nil;
-    }
 
-    /* Set up the build, if available */
-    if (systemInfo->os_build != NULL)
-        osBuild = [NSString stringWithUTF8String: systemInfo->os_build];
-    
     /* Set up the timestamp, if available */
     if (systemInfo->timestamp != 0)
         timestamp = [NSDate dateWithTimeIntervalSince1970: systemInfo->timestamp];
-    
+
     /* Done */
     return [[[PLCrashReportSystemInfo alloc] initWithOperatingSystem: (PLCrashReportOperatingSystem) systemInfo->operating_system
                                               operatingSystemVersion: [NSString stringWithUTF8String: systemInfo->os_version]
-                                                operatingSystemBuild: osBuild
+                                                operatingSystemBuild: string_or_nil(systemInfo->os_build)
                                                         architecture: (PLCrashReportArchitecture) systemInfo->architecture
                                                            timestamp: timestamp] autorelease];
 }
 
 /**
- * Extract processor information from the crash log. Returns nil on error.
+ * Extract processor information from the crash log.
  */
-- (PLCrashReportProcessorInfo *) extractProcessorInfo: (Plcrash__CrashReport__Processor *) processorInfo error: (NSError **) outError {   
-    /* Validate */
-    if (processorInfo == NULL) {
-        populate_nserror(outError, PLCrashReporterErrorCrashReportInvalid, 
-                         NSLocalizedString(@"Crash report is missing processor info section", 
-                                           @"Missing processor info in crash report"));
-        return nil;
-    }
-
-    return [[[PLCrashReportProcessorInfo alloc] initWithTypeEncoding: (PLCrashReportProcessorTypeEncoding) processorInfo->encoding
+- (PLCrashReportProcessorInfo *) extractProcessorInfo: (const plcrash_report_processor_t *) processorInfo {
+    return [[[PLCrashReportProcessorInfo alloc] initWithTypeEncoding: (PLCrashReportProcessorTypeEncoding) processorInfo->type_encoding
                                                                 type: processorInfo->type
                                                              subtype: processorInfo->subtype] autorelease];
 }
 
 /**
- * Extract machine information from the crash log. Returns nil on error.
+ * Extract machine information from the crash log.
  */
-- (PLCrashReportMachineInfo *) extractMachineInfo: (Plcrash__CrashReport__MachineInfo *) machineInfo error: (NSError **) outError {
-    NSString *model = nil;
-    PLCrashReportProcessorInfo *processorInfo;
-
-    /* Validate */
-    if (machineInfo == NULL) {
-        populate_nserror(outError, PLCrashReporterErrorCrashReportInvalid, 
-                         NSLocalizedString(@"Crash report is missing Machine Information section", 
-                                           @"Missing machine_info in crash report"));
-        return nil;
-    }
-
-    /* Set up the model, if available */
-    if (machineInfo->model != NULL)
-        model = [NSString stringWithUTF8String: machineInfo->model];
-
-    /* Set up the processor info. */
-    processorInfo = [self extractProcessorInfo: machineInfo->processor error: outError];
-    if (processorInfo == nil)
-        return nil;
-
-    /* Done */
-    return [[[PLCrashReportMachineInfo alloc] initWithModelName: model
-                                                  processorInfo: processorInfo
+- (PLCrashReportMachineInfo *) extractMachineInfo: (const plcrash_report_machine_info_t *) machineInfo {
+    return [[[PLCrashReportMachineInfo alloc] initWithModelName: string_or_nil(machineInfo->model)
+                                                  processorInfo: [self extractProcessorInfo: &machineInfo->processor]
                                                  processorCount: machineInfo->processor_count
                                           logicalProcessorCount: machineInfo->logical_processor_count] autorelease];
 }
 
 /**
- * Extract application information from the crash log. Returns nil on error.
+ * Extract application information from the crash log.
  */
-- (PLCrashReportApplicationInfo *) extractApplicationInfo: (Plcrash__CrashReport__ApplicationInfo *) applicationInfo 
-                                                    error: (NSError **) outError
-{    
-    /* Validate */
-    if (applicationInfo == NULL) {
-        populate_nserror(outError, PLCrashReporterErrorCrashReportInvalid, 
-                         NSLocalizedString(@"Crash report is missing Application Information section", 
-                                           @"Missing app info in crash report"));
-        return nil;
-    }
-
-    /* Identifier available? */
-    if (applicationInfo->identifier == NULL) {
-        populate_nserror(outError, PLCrashReporterErrorCrashReportInvalid, 
-                         NSLocalizedString(@"Crash report is missing Application Information app identifier field", 
-                                           @"Missing app identifier in crash report"));
-        return nil;
-    }
-
-    /* Version available? */
-    if (applicationInfo->version == NULL) {
-        populate_nserror(outError, PLCrashReporterErrorCrashReportInvalid, 
-                         NSLocalizedString(@"Crash report is missing Application Information app version field", 
-                                           @"Missing app version in crash report"));
-        return nil;
-    }
-    
-    /* Done */
-    NSString *identifier = [NSString stringWithUTF8String: applicationInfo->identifier];
-    NSString *version = [NSString stringWithUTF8String: applicationInfo->version];
-
-    return [[[PLCrashReportApplicationInfo alloc] initWithApplicationIdentifier: identifier
-                                                          applicationVersion: version] autorelease];
+- (PLCrashReportApplicationInfo *) extractApplicationInfo: (const plcrash_report_application_info_t *) applicationInfo {
+    return [[[PLCrashReportApplicationInfo alloc] initWithApplicationIdentifier: [NSString stringWithUTF8String: applicationInfo->identifier]
+                                                          applicationVersion: [NSString stringWithUTF8String: applicationInfo->version]] autorelease];
 }
 
 
 /**
- * Extract process information from the crash log. Returns nil on error.
+ * Extract process information from the crash log.
  */
-- (PLCrashReportProcessInfo *) extractProcessInfo: (Plcrash__CrashReport__ProcessInfo *) processInfo 
-                                            error: (NSError **) outError
-{    
-    /* Validate */
-    if (processInfo == NULL) {
-        populate_nserror(outError, PLCrashReporterErrorCrashReportInvalid, 
-                         NSLocalizedString(@"Crash report is missing Process Information section", 
-                                           @"Missing process info in crash report"));
-        return nil;
-    }
-    
-    /* Name available? */
-    NSString *processName = nil;
-    if (processInfo->process_name != NULL)
-        processName = [NSString stringWithUTF8String: processInfo->process_name];
-    
-    /* Path available? */
-    NSString *processPath = nil;
-    if (processInfo->process_path != NULL)
-        processPath = [NSString stringWithUTF8String: processInfo->process_path];
-    
-    /* Parent Name available? */
-    NSString *parentProcessName = nil;
-    if (processInfo->parent_process_name != NULL)
-        parentProcessName = [NSString stringWithUTF8String: processInfo->parent_process_name];
-
-    /* Required elements */
-    NSUInteger processID = processInfo->process_id;
-    NSUInteger parentProcessID = processInfo->parent_process_id;
-
-    /* Done */
-    return [[[PLCrashReportProcessInfo alloc] initWithProcessName: processName
-                                                        processID: processID
-                                                      processPath: processPath
-                                                parentProcessName: parentProcessName
-                                                  parentProcessID: parentProcessID
+- (PLCrashReportProcessInfo *) extractProcessInfo: (const plcrash_report_process_info_t *) processInfo {
+    return [[[PLCrashReportProcessInfo alloc] initWithProcessName: string_or_nil(processInfo->process_name)
+                                                        processID: processInfo->process_id
+                                                      processPath: string_or_nil(processInfo->process_path)
+                                                parentProcessName: string_or_nil(processInfo->parent_process_name)
+                                                  parentProcessID: processInfo->parent_process_id
                                                            native: processInfo->native] autorelease];
 }
 
 /**
- * Extract stack frame information from the crash log. Returns nil on error, or a PLCrashReportStackFrameInfo
- * instance on success.
+ * Extract @a frameCount stack frames, starting at @a frameIndex in the decoded report's frame array.
  */
-- (PLCrashReportStackFrameInfo *) extractStackFrameInfo: (Plcrash__CrashReport__Thread__StackFrame *) stackFrame error: (NSError **) outError {
-    /* There should be at least one thread */
-    if (stackFrame == NULL) {
-        populate_nserror(outError, PLCrashReporterErrorCrashReportInvalid,
-                         NSLocalizedString(@"Crash report is missing stack frame information",
-                                           @"Missing stack frame info in crash report"));
-        return nil;
+- (NSArray *) extractStackFrames: (size_t) frameIndex count: (size_t) frameCount {
+    NSMutableArray *frames = [NSMutableArray arrayWithCapacity: frameCount];
+
+    for (size_t i = 0; i < frameCount; i++) {
+        const plcrash_report_frame_t *frame = &_decoder->report.frames[frameIndex + i];
+        [frames addObject: [[[PLCrashReportStackFrameInfo alloc] initWithInstructionPointer: frame->pc] autorelease]];
     }
-    
-    return [[[PLCrashReportStackFrameInfo alloc] initWithInstructionPointer: stackFrame->pc] autorelease];
+
+    return frames;
 }
 
 /**
- * Extract thread information from the crash log. Returns nil on error, or an array of PLCrashLogThreadInfo
- * instances on success.
+ * Extract thread information from the crash log. Returns an array of PLCrashLogThreadInfo instances, in
+ * thread number order.
  */
-- (NSArray *) extractThreadInfo: (Plcrash__CrashReport *) crashReport error: (NSError **) outError {
-    /* There should be at least one thread */
-    if (crashReport->n_threads == 0) {
-        populate_nserror(outError, PLCrashReporterErrorCrashReportInvalid,
-                         NSLocalizedString(@"Crash report is missing thread state information",
-                                           @"Missing thread info in crash report"));
-        return nil;
-    }
+- (NSArray *) extractThreadInfo {
+    const plcrash_report_t *report = &_decoder->report;
+    NSMutableArray *threadResult = [NSMutableArray arrayWithCapacity: report->thread_count];
+
+    for (size_t thr_idx = 0; thr_idx < report->thread_count; thr_idx++) {
+        const plcrash_report_thread_t *thread = &report->threads[thr_idx];
 
-    /* Handle all threads */
-    NSMutableArray *threadResult = [NSMutableArray arrayWithCapacity: crashReport->n_threads];
-    for (size_t thr_idx = 0; thr_idx < crashReport->n_threads; thr_idx++) {
-        Plcrash__CrashReport__Thread *thread = crashReport->threads[thr_idx];
-        
         /* Fetch stack frames for this thread */
-        NSMutableArray *frames = [NSMutableArray arrayWithCapacity: thread->n_frames];
-        for (size_t frame_idx = 0; frame_idx < thread->n_frames; frame_idx++) {
-            Plcrash__CrashReport__Thread__StackFrame *frame = thread->frames[frame_idx];
-            PLCrashReportStackFrameInfo *frameInfo = [self extractStackFrameInfo: frame error: outError];
-            if (frameInfo == nil)
-                return nil;
-
-            [frames addObject: frameInfo];
-        }
+        NSArray *frames = [self extractStackFrames: thread->frame_index count: thread->frame_count];
 
         /* Fetch registers for this thread */
-        NSMutableArray *registers = [NSMutableArray arrayWithCapacity: thread->n_registers];
-        for (size_t reg_idx = 0; reg_idx < thread->n_registers; reg_idx++) {
-            Plcrash__CrashReport__Thread__RegisterValue *reg = thread->registers[reg_idx];
+        NSMutableArray *registers = [NSMutableArray arrayWithCapacity: thread->register_count];
+        for (size_t reg_idx = 0; reg_idx < thread->register_count; reg_idx++) {
+            const plcrash_report_register_t *reg = &report->registers[thread->register_index + reg_idx];
             PLCrashReportRegisterInfo *regInfo;
 
-            /* Handle missing register name (should not occur!) */
-            if (reg->name == NULL) {
-                populate_nserror(outError, PLCrashReporterErrorCrashReportInvalid, @"Missing register name in register value");
-                return nil;
-            }
-
             regInfo = [[[PLCrashReportRegisterInfo alloc] initWithRegisterName: [NSString stringWithUTF8String: reg->name]
                                                               registerValue: reg->value] autorelease];
             [registers addObject: regInfo];
         }
 
+        /* Fetch stack memory for this thread */
+        NSMutableArray *stackMemory = [NSMutableArray arrayWithCapacity: thread->stack_memory_count];
+        for (size_t mem_idx = 0; mem_idx < thread->stack_memory_count; mem_idx++) {
+            const plcrash_report_stack_memory_t *mem = &report->stack_memory[thread->stack_memory_index + mem_idx];
+            PLCrashReportStackMemoryInfo *memInfo;
+            NSData *contents;
+
+            contents = [NSData dataWithBytes: mem->contents length: mem->length];
+            memInfo = [[[PLCrashReportStackMemoryInfo alloc] initWithBaseAddress: mem->base_address contents: contents] autorelease];
+            [stackMemory addObject: memInfo];
+        }
+
         /* Create the thread info instance */
         PLCrashReportThreadInfo *threadInfo = [[[PLCrashReportThreadInfo alloc] initWithThreadNumber: thread->thread_number
                                                                                    stackFrames: frames 
                                                                                        crashed: thread->crashed 
-                                                                                     registers: registers] autorelease];
+                                                                                     registers: registers
+                                                                                   stackMemory: stackMemory] autorelease];
         [threadResult addObject: threadInfo];
     }
-    
+
     return threadResult;
 }
 
 
 /**
- * Extract binary image information from the crash log. Returns nil on error.
+ * Extract binary image information from the crash log, in report order.
  */
-- (NSArray *) extractImageInfo: (Plcrash__CrashReport *) crashReport error: (NSError **) outError {
-    /* There should be at least one image */
-    if (crashReport->n_binary_images == 0) {
-        populate_nserror(outError, PLCrashReporterErrorCrashReportInvalid,
-                         NSLocalizedString(@"Crash report is missing binary image information",
-                                           @"Missing image info in crash report"));
-        return nil;
-    }
+- (NSArray *) extractImageInfo {
+    const plcrash_report_t *report = &_decoder->report;
+    NSMutableArray *images = [NSMutableArray arrayWithCapacity: report->image_count];
 
-    /* Handle all records */
-    NSMutableArray *images = [NSMutableArray arrayWithCapacity: crashReport->n_binary_images];
-    for (size_t i = 0; i < crashReport->n_binary_images; i++) {
-        Plcrash__CrashReport__BinaryImage *image = crashReport->binary_images[i];
+    for (size_t i = 0; i < report->image_count; i++) {
+        const plcrash_report_image_t *image = &report->images[i];
         PLCrashReportBinaryImageInfo *imageInfo;
 
-        /* Validate */
-        if (image->name == NULL) {
-            populate_nserror(outError, PLCrashReporterErrorCrashReportInvalid, @"Missing image name in image record");
-            return nil;
-        }
-
         /* Extract UUID value */
         NSData *uuid = nil;
-        if (image->uuid.len == 0) {
-            /* No UUID */
-            uuid = nil;
-        } else {
-            uuid = [NSData dataWithBytes: image->uuid.data length: image->uuid.len];
-        }
-        assert(image->uuid.len == 0 || uuid != nil);
-        
-        /* Extract code type (if available). */
-        PLCrashReportProcessorInfo *codeType = nil;
-        if ((codeType = [self extractProcessorInfo: image->code_type error: outError]) == nil)
-            return nil;
+        if (image->uuid != NULL)
+            uuid = [NSData dataWithBytes: image->uuid length: image->uuid_length];
 
-
-        imageInfo = [[[PLCrashReportBinaryImageInfo alloc] initWithCodeType: codeType
+        imageInfo = [[[PLCrashReportBinaryImageInfo alloc] initWithCodeType: [self extractProcessorInfo: &image->code_type]
                                                                 baseAddress: image->base_address
                                                                        size: image->size
                                                                        name: [NSString stringWithUTF8String: image->name]
@@ -562,99 +386,72 @@ error:
 }
 
 /**
- * Extract  exception information from the crash log. Returns nil on error.
+ * Extract exception information from the crash log.
  */
-- (PLCrashReportExceptionInfo *) extractExceptionInfo: (Plcrash__CrashReport__Exception *) exceptionInfo
-                                               error: (NSError **) outError
-{
-    /* Validate */
-    if (exceptionInfo == NULL) {
-        populate_nserror(outError, PLCrashReporterErrorCrashReportInvalid, 
-                         NSLocalizedString(@"Crash report is missing Exception Information section", 
-                                           @"Missing appinfo in crash report"));
-        return nil;
-    }
-    
-    /* Name available? */
-    if (exceptionInfo->name == NULL) {
-        populate_nserror(outError, PLCrashReporterErrorCrashReportInvalid, 
-                         NSLocalizedString(@"Crash report is missing exception name field", 
-                                           @"Missing appinfo operating system in crash report"));
-        return nil;
-    }
-    
-    /* Reason available? */
-    if (exceptionInfo->reason == NULL) {
-        populate_nserror(outError, PLCrashReporterErrorCrashReportInvalid, 
-                         NSLocalizedString(@"Crash report is missing exception reason field", 
-                                           @"Missing appinfo operating system in crash report"));
-        return nil;
-    }
-    
-    /* Done */
+- (PLCrashReportExceptionInfo *) extractExceptionInfo: (const plcrash_report_exception_info_t *) exceptionInfo {
     NSString *name = [NSString stringWithUTF8String: exceptionInfo->name];
     NSString *reason = [NSString stringWithUTF8String: exceptionInfo->reason];
-    
-    /* Fetch stack frames for this thread */
-    NSMutableArray *frames = nil;
-    if (exceptionInfo->n_frames > 0) {
-        frames = [NSMutableArray arrayWithCapacity: exceptionInfo->n_frames];
-        for (size_t frame_idx = 0; frame_idx < exceptionInfo->n_frames; frame_idx++) {
-            Plcrash__CrashReport__Thread__StackFrame *frame = exceptionInfo->frames[frame_idx];
-            PLCrashReportStackFrameInfo *frameInfo = [self extractStackFrameInfo: frame error: outError];
-            if (frameInfo == nil)
-                return nil;
-            
-            [frames addObject: frameInfo];
-        }
-    }
 
-    if (frames == nil) {
+    if (exceptionInfo->frame_count == 0)
         return [[[PLCrashReportExceptionInfo alloc] initWithExceptionName: name reason: reason] autorelease];
-    } else {
-        return [[[PLCrashReportExceptionInfo alloc] initWithExceptionName: name
-                                                                   reason: reason 
-                                                              stackFrames: frames] autorelease];
-    }
+
+    return [[[PLCrashReportExceptionInfo alloc] initWithExceptionName: name
+                                                               reason: reason
+                                                          stackFrames: [self extractStackFrames: exceptionInfo->frame_index
+                                                                                          count: exceptionInfo->frame_count]] autorelease];
 }
 
 /**
- * Extract signal information from the crash log. Returns nil on error.
+ * Extract signal information from the crash log.
  */
-- (PLCrashReportSignalInfo *) extractSignalInfo: (Plcrash__CrashReport__Signal *) signalInfo
-                                       error: (NSError **) outError
-{
-    /* Validate */
-    if (signalInfo == NULL) {
-        populate_nserror(outError, PLCrashReporterErrorCrashReportInvalid, 
-                         NSLocalizedString(@"Crash report is missing Signal Information section", 
-                                           @"Missing appinfo in crash report"));
-        return nil;
-    }
-    
-    /* Name available? */
-    if (signalInfo->name == NULL) {
-        populate_nserror(outError, PLCrashReporterErrorCrashReportInvalid, 
-                         NSLocalizedString(@"Crash report is missing signal name field", 
-                                           @"Missing appinfo operating system in crash report"));
-        return nil;
-    }
-    
-    /* Code available? */
-    if (signalInfo->code == NULL) {
-        populate_nserror(outError, PLCrashReporterErrorCrashReportInvalid, 
-                         NSLocalizedString(@"Crash report is missing signal code field", 
-                                           @"Missing appinfo operating system in crash report"));
-        return nil;
-    }
-    
-    /* Done */
+- (PLCrashReportSignalInfo *) extractSignalInfo: (const plcrash_report_signal_info_t *) signalInfo {
     NSString *name = [NSString stringWithUTF8String: signalInfo->name];
     NSString *code = [NSString stringWithUTF8String: signalInfo->code];
     
     return [[[PLCrashReportSignalInfo alloc] initWithSignalName: name code: code address: signalInfo->address] autorelease];
 }
 
+/**
+ * Extract writer statistics from the crash log.
+ */
+- (PLCrashReportWriterStats *) extractWriterStats: (const plcrash_report_writer_stats_t *) writerStats {
+    NSMutableArray *threadStats = [NSMutableArray arrayWithCapacity: writerStats->thread_stats_count];
+    NSDictionary *sectionBytes;
+
+    /* Per-thread statistics */
+    for (size_t i = 0; i < writerStats->thread_stats_count; i++) {
+        const plcrash_report_writer_thread_stats_t *thr = &_decoder->report.writer_thread_stats[writerStats->thread_stats_index + i];
+        PLCrashReportWriterThreadStats *stats;
+
+        stats = [[[PLCrashReportWriterThreadStats alloc] initWithThreadNumber: thr->thread_number
+                                                                  suspendTime: thr->suspend_time
+                                                                     walkTime: thr->walk_time
+                                                                    writeTime: thr->write_time
+                                                                    truncated: thr->truncated] autorelease];
+        [threadStats addObject: stats];
+    }
+
+    /* Section sizes */
+    sectionBytes = [NSDictionary dictionaryWithObjectsAndKeys:
+                    [NSNumber numberWithUnsignedInt: writerStats->system_info_bytes], PLCrashReportWriterStatsSectionSystemInfo,
+                    [NSNumber numberWithUnsignedInt: writerStats->machine_info_bytes], PLCrashReportWriterStatsSectionMachineInfo,
+                    [NSNumber numberWithUnsignedInt: writerStats->application_info_bytes], PLCrashReportWriterStatsSectionApplicationInfo,
+                    [NSNumber numberWithUnsignedInt: writerStats->process_info_bytes], PLCrashReportWriterStatsSectionProcessInfo,
+                    [NSNumber numberWithUnsignedInt: writerStats->threads_bytes], PLCrashReportWriterStatsSectionThreads,
+                    [NSNumber numberWithUnsignedInt: writerStats->binary_images_bytes], PLCrashReportWriterStatsSectionBinaryImages,
+                    [NSNumber numberWithUnsignedInt: writerStats->exception_bytes], PLCrashReportWriterStatsSectionException,
+                    [NSNumber numberWithUnsignedInt: writerStats->signal_bytes], PLCrashReportWriterStatsSectionSignal,
+                    nil];
+
+    /* Done */
+    return [[[PLCrashReportWriterStats alloc] initWithThreadStats: threadStats
+                                                        totalTime: writerStats->total_time
+                                                        imageTime: writerStats->image_time
+                                                     readFailures: writerStats->read_failures
+                                                 truncatedThreads: writerStats->truncated_threads
+                                                     sectionBytes: sectionBytes] autorelease];
+}
+
 @end
 
 /**
@@ -681,4 +478,15 @@ static void populate_nserror (NSError **error, PLCrashReporterError code, NSStri
                 ];
     
     *error = [NSError errorWithDomain: PLCrashReporterErrorDomain code: code userInfo: userInfo];
-}
\ No newline at end of file
+}
+
+/**
+ * @internal
+ *
+ * Return a new NSString for @a str, or nil if @a str is NULL.
+ */
+static NSString *string_or_nil (const char *str) {
+    if (str == NULL)
+        return nil;
+    return [NSString stringWithUTF8String: str];
+}
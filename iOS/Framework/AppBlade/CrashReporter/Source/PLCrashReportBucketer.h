@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2008-2011 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+
+#import "PLCrashReport.h"
+
+@interface PLCrashReportBucket : NSObject {
+@private
+    /** Report fingerprint */
+    uint64_t _fingerprint;
+
+    /** Number of reports */
+    uint64_t _reportCount;
+
+    /** Earliest and latest report timestamps (may be nil) */
+    NSDate *_firstSeen;
+    NSDate *_lastSeen;
+
+    /** Signal name */
+    NSString *_signalName;
+
+    /** Exception name (may be nil) */
+    NSString *_exceptionName;
+
+    /** Normalized crashed thread frames */
+    NSString *_frames;
+
+    /** Representative report identifiers */
+    NSArray *_sampleIdentifiers;
+}
+
+- (id) initWithFingerprint: (uint64_t) fingerprint
+               reportCount: (uint64_t) reportCount
+                 firstSeen: (NSDate *) firstSeen
+                  lastSeen: (NSDate *) lastSeen
+                signalName: (NSString *) signalName
+             exceptionName: (NSString *) exceptionName
+                    frames: (NSString *) frames
+         sampleIdentifiers: (NSArray *) sampleIdentifiers;
+
+/**
+ * The fingerprint shared by all reports in this bucket.
+ */
+@property(nonatomic, readonly) uint64_t fingerprint;
+
+/**
+ * Number of reports in this bucket.
+ */
+@property(nonatomic, readonly) uint64_t reportCount;
+
+/**
+ * Timestamp of the earliest report, or nil if none of the reports included a timestamp.
+ */
+@property(nonatomic, readonly) NSDate *firstSeen;
+
+/**
+ * Timestamp of the latest report, or nil if none of the reports included a timestamp.
+ */
+@property(nonatomic, readonly) NSDate *lastSeen;
+
+/**
+ * Signal name.
+ */
+@property(nonatomic, readonly) NSString *signalName;
+
+/**
+ * Uncaught exception name, or nil if the reports did not include an exception.
+ */
+@property(nonatomic, readonly) NSString *exceptionName;
+
+/**
+ * The fingerprinted frames of the crashed thread, as "image + 0xoffset" separated by " | ".
+ */
+@property(nonatomic, readonly) NSString *frames;
+
+/**
+ * Identifiers of up to three representative reports, most recent first.
+ */
+@property(nonatomic, readonly) NSArray *sampleIdentifiers;
+
+@end
+
+
+@interface PLCrashReportBucketer : NSObject {
+@private
+    /** Underlying bucket table (PLCrashBucket.h) */
+    struct plcrash_bucket_table *_table;
+}
+
+- (id) initWithFrameCount: (NSUInteger) frameCount;
+
+- (uint64_t) fingerprintForReport: (PLCrashReport *) report;
+
+- (BOOL) addReport: (PLCrashReport *) report identifier: (NSString *) identifier error: (NSError **) outError;
+
+- (BOOL) addReportsAtPaths: (NSArray *) paths threadCount: (NSUInteger) threadCount error: (NSError **) outError;
+
+/** Number of crashed thread frames included in each fingerprint. */
+@property(nonatomic, readonly) NSUInteger frameCount;
+
+/** Number of reports added. */
+@property(nonatomic, readonly) uint64_t reportCount;
+
+/** Number of files passed to addReportsAtPaths:threadCount:error: that could not be read or decoded. */
+@property(nonatomic, readonly) uint64_t failedCount;
+
+/** All buckets (PLCrashReportBucket instances), ordered by descending report count. */
+@property(nonatomic, readonly) NSArray *buckets;
+
+@end
@@ -0,0 +1,314 @@
+/*
+ * Copyright (c) 2008-2011 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "CrashReporter.h"
+
+#import "PLCrashReportBucketer.h"
+#import "PLCrashBucket.h"
+
+static void populate_nserror (NSError **error, PLCrashReporterError code, NSString *description, NSError *cause);
+
+/**
+ * A group of crash reports that share a fingerprint.
+ */
+@implementation PLCrashReportBucket
+
+/**
+ * Initialize with the provided bucket data.
+ */
+- (id) initWithFingerprint: (uint64_t) fingerprint
+               reportCount: (uint64_t) reportCount
+                 firstSeen: (NSDate *) firstSeen
+                  lastSeen: (NSDate *) lastSeen
+                signalName: (NSString *) signalName
+             exceptionName: (NSString *) exceptionName
+                    frames: (NSString *) frames
+         sampleIdentifiers: (NSArray *) sampleIdentifiers
+{
+    if ((self = [super init]) == nil)
+        return nil;
+
+    _fingerprint = fingerprint;
+    _reportCount = reportCount;
+    _firstSeen = [firstSeen retain];
+    _lastSeen = [lastSeen retain];
+    _signalName = [signalName retain];
+    _exceptionName = [exceptionName retain];
+    _frames = [frames retain];
+    _sampleIdentifiers = [sampleIdentifiers retain];
+
+    return self;
+}
+
+- (void) dealloc {
+    [_firstSeen release];
+    [_lastSeen release];
+    [_signalName release];
+    [_exceptionName release];
+    [_frames release];
+    [_sampleIdentifiers release];
+    [super dealloc];
+}
+
+@synthesize fingerprint = _fingerprint;
+@synthesize reportCount = _reportCount;
+@synthesize firstSeen = _firstSeen;
+@synthesize lastSeen = _lastSeen;
+@synthesize signalName = _signalName;
+@synthesize exceptionName = _exceptionName;
+@synthesize frames = _frames;
+@synthesize sampleIdentifiers = _sampleIdentifiers;
+
+@end
+
+
+/**
+ * Groups crash reports by a stable fingerprint of their crash site, for triage of large report collections.
+ *
+ * A report's fingerprint hashes the top frames of its crashed thread, each normalized to its binary image UUID
+ * and offset within the image, together with the signal name and the uncaught exception name. Reports of the
+ * same crash therefore share a fingerprint regardless of ASLR slide, install path, or the host they were
+ * collected on.
+ *
+ * Each bucket records its report count, first and last seen timestamps, and the identifiers of its most
+ * recent reports. Reports on disk may be bucketed in parallel with addReportsAtPaths:threadCount:error:, which
+ * decodes reports directly, without creating PLCrashReport instances.
+ */
+@implementation PLCrashReportBucketer
+
+/**
+ * Initialize a bucketer that fingerprints the top five frames of each report's crashed thread.
+ */
+- (id) init {
+    return [self initWithFrameCount: PLCRASH_BUCKET_DEFAULT_FRAMES];
+}
+
+/**
+ * Initialize a bucketer.
+ *
+ * @param frameCount The number of crashed thread frames to include in each fingerprint, or 0 to use the default
+ * of five frames. Fewer frames group reports more coarsely.
+ */
+- (id) initWithFrameCount: (NSUInteger) frameCount {
+    if ((self = [super init]) == nil)
+        return nil;
+
+    _table = malloc(sizeof(plcrash_bucket_table_t));
+    if (_table == NULL || plcrash_bucket_table_init(_table, frameCount) != PLCRASH_ESUCCESS) {
+        free(_table);
+        _table = NULL;
+
+        [self release];
+        return nil;
+    }
+
+    return self;
+}
+
+- (void) dealloc {
+    if (_table != NULL) {
+        plcrash_bucket_table_free(_table);
+        free(_table);
+    }
+
+    [super dealloc];
+}
+
+/**
+ * Return the fingerprint of @a report, without adding it to a bucket.
+ *
+ * @param report The report to fingerprint.
+ */
+- (uint64_t) fingerprintForReport: (PLCrashReport *) report {
+    return plcrash_bucket_fingerprint([report coreReport], _table->frame_count);
+}
+
+/**
+ * Add @a report to its bucket.
+ *
+ * @param report The report to add.
+ * @param identifier An identifier for the report, retained if it is one of its bucket's most recent reports.
+ * May be nil.
+ * @param outError If an error occurs, this pointer will contain an NSError object indicating why the report
+ * could not be added. If no error occurs, this parameter will be left unmodified. You may specify NULL for
+ * this parameter, and no error information will be provided.
+ *
+ * @return Returns YES on success, or NO if memory could not be allocated.
+ */
+- (BOOL) addReport: (PLCrashReport *) report identifier: (NSString *) identifier error: (NSError **) outError {
+    if (plcrash_bucket_table_add(_table, [report coreReport], [identifier UTF8String]) != PLCRASH_ESUCCESS) {
+        populate_nserror(outError, PLCrashReporterErrorUnknown, @"Could not allocate the report's bucket", nil);
+        return NO;
+    }
+
+    return YES;
+}
+
+/**
+ * Read, decode, and bucket the crash reports at @a paths in parallel. Each report is identified by its path.
+ * Files that can not be read or decoded are skipped, and are counted by failedCount.
+ *
+ * @param paths The paths of the crash reports to add.
+ * @param threadCount The number of threads to use, including the calling thread, or 0 to use one thread per
+ * processor. The result does not depend on the number of threads.
+ * @param outError If an error occurs, this pointer will contain an NSError object indicating why the reports
+ * could not be added. If no error occurs, this parameter will be left unmodified. You may specify NULL for
+ * this parameter, and no error information will be provided.
+ *
+ * @return Returns YES on success, or NO if memory could not be allocated.
+ */
+- (BOOL) addReportsAtPaths: (NSArray *) paths threadCount: (NSUInteger) threadCount error: (NSError **) outError {
+    NSUInteger count = [paths count];
+    NSUInteger converted = 0;
+    plcrash_error_t err = PLCRASH_ENOMEM;
+    char **cpaths;
+
+    /* The file system representations are copied out, as autoreleased copies of a large number of paths would
+     * otherwise be retained for the duration of the call */
+    cpaths = calloc(count > 0 ? count : 1, sizeof(*cpaths));
+    if (cpaths == NULL)
+        goto cleanup;
+
+    while (converted < count) {
+        NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+        NSUInteger end = MIN(converted + 1024, count);
+        BOOL failed = NO;
+
+        for (; converted < end; converted++) {
+            if ((cpaths[converted] = strdup([[paths objectAtIndex: converted] fileSystemRepresentation])) == NULL) {
+                failed = YES;
+                break;
+            }
+        }
+
+        [pool release];
+        if (failed)
+            goto cleanup;
+    }
+
+    err = plcrash_bucket_table_add_paths(_table, (const char * const *) cpaths, count, threadCount);
+
+cleanup:
+    if (cpaths != NULL) {
+        for (NSUInteger i = 0; i < converted; i++)
+            free(cpaths[i]);
+        free(cpaths);
+    }
+
+    if (err != PLCRASH_ESUCCESS) {
+        populate_nserror(outError, PLCrashReporterErrorUnknown, @"Could not allocate the report buckets", nil);
+        return NO;
+    }
+
+    return YES;
+}
+
+// property getter
+- (NSUInteger) frameCount {
+    return _table->frame_count;
+}
+
+// property getter
+- (uint64_t) reportCount {
+    return _table->report_count;
+}
+
+// property getter
+- (uint64_t) failedCount {
+    return _table->failed_count;
+}
+
+// property getter
+- (NSArray *) buckets {
+    NSMutableArray *buckets = [NSMutableArray arrayWithCapacity: _table->bucket_count];
+
+    plcrash_bucket_table_sort(_table);
+
+    for (size_t i = 0; i < _table->bucket_count; i++) {
+        const plcrash_bucket_t *bucket = &_table->buckets[i];
+        NSMutableArray *samples = [NSMutableArray arrayWithCapacity: bucket->sample_count];
+        NSDate *firstSeen = nil;
+        NSDate *lastSeen = nil;
+        NSString *exceptionName = nil;
+
+        for (size_t j = 0; j < bucket->sample_count; j++)
+            [samples addObject: [NSString stringWithUTF8String: bucket->samples[j]]];
+
+        if (bucket->first_seen != 0)
+            firstSeen = [NSDate dateWithTimeIntervalSince1970: bucket->first_seen];
+
+        if (bucket->last_seen != 0)
+            lastSeen = [NSDate dateWithTimeIntervalSince1970: bucket->last_seen];
+
+        if (bucket->exception_name != NULL)
+            exceptionName = [NSString stringWithUTF8String: bucket->exception_name];
+
+        PLCrashReportBucket *entry = [[PLCrashReportBucket alloc] initWithFingerprint: bucket->fingerprint
+                                                                          reportCount: bucket->count
+                                                                            firstSeen: firstSeen
+                                                                             lastSeen: lastSeen
+                                                                           signalName: [NSString stringWithUTF8String: bucket->signal_name]
+                                                                        exceptionName: exceptionName
+                                                                               frames: [NSString stringWithUTF8String: bucket->frames]
+                                                                    sampleIdentifiers: samples];
+        [buckets addObject: entry];
+        [entry release];
+    }
+
+    return buckets;
+}
+
+@end
+
+/**
+ * @internal
+ *
+ * Populate an NSError instance with the provided information.
+ *
+ * @param error Error instance to populate. If NULL, this method returns
+ * and nothing is modified.
+ * @param code The error code corresponding to this error.
+ * @param description A localized error description.
+ * @param cause The underlying cause, if any. May be nil.
+ */
+static void populate_nserror (NSError **error, PLCrashReporterError code, NSString *description, NSError *cause) {
+    NSMutableDictionary *userInfo;
+    
+    if (error == NULL)
+        return;
+    
+    /* Create the userInfo dictionary */
+    userInfo = [NSMutableDictionary dictionaryWithObjectsAndKeys:
+                description, NSLocalizedDescriptionKey,
+                nil
+                ];
+
+    /* Add the cause, if available */
+    if (cause != nil)
+        [userInfo setObject: cause forKey: NSUnderlyingErrorKey];
+    
+    *error = [NSError errorWithDomain: PLCrashReporterErrorDomain code: code userInfo: userInfo];
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2008-2011 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+
+@interface PLCrashReportColumnarExporter : NSObject {
+@private
+    /** Number of rows written to each table by the most recent export */
+    uint64_t _reportCount;
+    uint64_t _threadRowCount;
+    uint64_t _frameRowCount;
+    uint64_t _imageRowCount;
+
+    /** Number of files that could not be read or decoded by the most recent export */
+    uint64_t _failedCount;
+}
+
+- (BOOL) exportReportsAtPaths: (NSArray *) paths
+                  toDirectory: (NSString *) directory
+                  threadCount: (NSUInteger) threadCount
+                        error: (NSError **) outError;
+
+/** Number of rows written to the reports table by the most recent export. */
+@property(nonatomic, readonly) uint64_t reportCount;
+
+/** Number of rows written to the threads table by the most recent export. */
+@property(nonatomic, readonly) uint64_t threadRowCount;
+
+/** Number of rows written to the frames table by the most recent export. */
+@property(nonatomic, readonly) uint64_t frameRowCount;
+
+/** Number of rows written to the images table by the most recent export. */
+@property(nonatomic, readonly) uint64_t imageRowCount;
+
+/** Number of input files that could not be read or decoded by the most recent export. */
+@property(nonatomic, readonly) uint64_t failedCount;
+
+@end
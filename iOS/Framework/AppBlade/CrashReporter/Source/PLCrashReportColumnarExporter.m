@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2008-2011 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "CrashReporter.h"
+
+#import "PLCrashReportColumnarExporter.h"
+#import "PLCrashColumnar.h"
+
+static void populate_nserror (NSError **error, PLCrashReporterError code, NSString *description, NSError *cause);
+
+/**
+ * Exports crash reports as column files for analytics.
+ *
+ * Reports are flattened into reports, threads, frames, and images tables, stored as one file per column
+ * ("<table>.<column>.plcol"). Image names, UUIDs, and other repetitive strings are dictionary-encoded, and
+ * addresses and timestamps are delta-encoded. Columns are written block by block, so that memory use does not
+ * grow with the number of reports, and may be memory-mapped and scanned directly; see PLCrashColumnar.h for
+ * the file format.
+ *
+ * Input files are decoded in parallel, without creating PLCrashReport instances, and are exported in input order.
+ */
+@implementation PLCrashReportColumnarExporter
+
+/**
+ * Export the reports at @a paths to @a directory, replacing any column files previously exported to the
+ * directory. Files that can not be read or decoded are skipped, and counted by failedCount.
+ *
+ * @param paths Report file paths.
+ * @param directory An existing output directory.
+ * @param threadCount Number of decoding threads, or 0 to use one thread per online processor.
+ * @param outError If an error occurs, this pointer will contain an NSError object indicating why the reports
+ * could not be exported. If no error occurs, this parameter will be left unmodified. You may specify NULL for
+ * this parameter, and no error information will be provided.
+ *
+ * @return Returns YES on success, or NO if the column files could not be written. On failure, no column files
+ * are left in @a directory.
+ */
+- (BOOL) exportReportsAtPaths: (NSArray *) paths
+                  toDirectory: (NSString *) directory
+                  threadCount: (NSUInteger) threadCount
+                        error: (NSError **) outError
+{
+    plcrash_columnar_stats_t stats;
+    NSUInteger count = [paths count];
+    NSUInteger converted = 0;
+    plcrash_error_t err = PLCRASH_ENOMEM;
+    int errnum = 0;
+    char **cpaths;
+
+    memset(&stats, 0, sizeof(stats));
+
+    /* The file system representations are copied out, as autoreleased copies of a large number of paths would
+     * otherwise be retained for the duration of the call */
+    cpaths = calloc(count > 0 ? count : 1, sizeof(*cpaths));
+    if (cpaths == NULL)
+        goto cleanup;
+
+    while (converted < count) {
+        NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+        NSUInteger end = MIN(converted + 1024, count);
+        BOOL failed = NO;
+
+        for (; converted < end; converted++) {
+            if ((cpaths[converted] = strdup([[paths objectAtIndex: converted] fileSystemRepresentation])) == NULL) {
+                failed = YES;
+                break;
+            }
+        }
+
+        [pool release];
+        if (failed)
+            goto cleanup;
+    }
+
+    err = plcrash_columnar_export([directory fileSystemRepresentation], (const char * const *) cpaths, count, threadCount, &stats);
+    errnum = errno;
+
+cleanup:
+    if (cpaths != NULL) {
+        for (NSUInteger i = 0; i < converted; i++)
+            free(cpaths[i]);
+        free(cpaths);
+    }
+
+    _reportCount = stats.reports;
+    _threadRowCount = stats.threads;
+    _frameRowCount = stats.frames;
+    _imageRowCount = stats.images;
+    _failedCount = stats.failed;
+
+    switch (err) {
+        case PLCRASH_ESUCCESS:
+            return YES;
+
+        case PLCRASH_OUTPUT_ERR: {
+            NSError *cause = [NSError errorWithDomain: NSPOSIXErrorDomain code: errnum userInfo: nil];
+            populate_nserror(outError, PLCrashReporterErrorOperatingSystem,
+                             [NSString stringWithFormat: @"Could not write column files to %@", directory], cause);
+            return NO;
+        }
+
+        default:
+            populate_nserror(outError, PLCrashReporterErrorUnknown, @"Could not allocate the column buffers", nil);
+            return NO;
+    }
+}
+
+@synthesize reportCount = _reportCount;
+@synthesize threadRowCount = _threadRowCount;
+@synthesize frameRowCount = _frameRowCount;
+@synthesize imageRowCount = _imageRowCount;
+@synthesize failedCount = _failedCount;
+
+@end
+
+/**
+ * @internal
+ *
+ * Populate an NSError instance with the provided information.
+ *
+ * @param error Error instance to populate. If NULL, this method returns
+ * and nothing is modified.
+ * @param code The error code corresponding to this error.
+ * @param description A localized error description.
+ * @param cause The underlying cause, if any. May be nil.
+ */
+static void populate_nserror (NSError **error, PLCrashReporterError code, NSString *description, NSError *cause) {
+    NSMutableDictionary *userInfo;
+    
+    if (error == NULL)
+        return;
+    
+    /* Create the userInfo dictionary */
+    userInfo = [NSMutableDictionary dictionaryWithObjectsAndKeys:
+                description, NSLocalizedDescriptionKey,
+                nil
+                ];
+
+    /* Add the cause, if available */
+    if (cause != nil)
+        [userInfo setObject: cause forKey: NSUnderlyingErrorKey];
+    
+    *error = [NSError errorWithDomain: PLCrashReporterErrorDomain code: code userInfo: userInfo];
+}
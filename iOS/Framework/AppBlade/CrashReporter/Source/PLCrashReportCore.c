@@ -0,0 +1,563 @@
+/*
+ * Copyright (c) 2008-2011 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PLCrashReportCore.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "crash_report.pb-c.h"
+#include "PLCrashReportDecoder.h"
+#include "PLCrashCompression.h"
+
+/**
+ * @ingroup plcrash_report_core
+ * @{
+ */
+
+/* Crash log file header. Must match PLCRASH_REPORT_FILE_MAGIC and PLCRASH_REPORT_FILE_VERSION (PLCrashReport.h) */
+#define CORE_FILE_MAGIC "plcrash"
+#define CORE_FILE_MAGIC_LEN 7
+#define CORE_FILE_VERSION 1
+
+/* Length of the file header: magic identifier plus version byte */
+#define CORE_FILE_HEADER_LEN (CORE_FILE_MAGIC_LEN + 1)
+
+/* Alignment of each array within the report storage */
+#define CORE_STORAGE_ALIGN sizeof(uint64_t)
+
+/**
+ * @internal
+ * Report storage layout and bump allocator. Sizes are accumulated in a first pass over the decoded message,
+ * and the same sequence of requests is then served from a single allocation.
+ */
+typedef struct core_storage {
+    /** Backing buffer, or NULL during the sizing pass */
+    uint8_t *base;
+
+    /** Bytes consumed */
+    size_t offset;
+} core_storage_t;
+
+/**
+ * @internal
+ * Reserve @a size bytes of storage aligned to @a align. Returns NULL during the sizing pass.
+ */
+static void *core_storage_alloc (core_storage_t *storage, size_t size, size_t align) {
+    void *ptr;
+
+    storage->offset = (storage->offset + (align - 1)) & ~(align - 1);
+    ptr = storage->base != NULL ? storage->base + storage->offset : NULL;
+    storage->offset += size;
+
+    return ptr;
+}
+
+/**
+ * @internal
+ * Copy a NUL-terminated string into report storage. NULL strings remain NULL.
+ */
+static const char *core_storage_strdup (core_storage_t *storage, const char *str) {
+    size_t len;
+    char *dest;
+
+    if (str == NULL)
+        return NULL;
+
+    len = strlen(str) + 1;
+    dest = core_storage_alloc(storage, len, 1);
+    if (dest != NULL)
+        memcpy(dest, str, len);
+
+    return dest;
+}
+
+/**
+ * @internal
+ * Copy a byte buffer into report storage. Empty buffers are returned as NULL.
+ */
+static const uint8_t *core_storage_memdup (core_storage_t *storage, const ProtobufCBinaryData *data) {
+    uint8_t *dest;
+
+    if (data->len == 0)
+        return NULL;
+
+    dest = core_storage_alloc(storage, data->len, 1);
+    if (dest != NULL)
+        memcpy(dest, data->data, data->len);
+
+    return dest;
+}
+
+/**
+ * @internal
+ * Verify that all required fields are present in the decoded message. The checks and messages match those
+ * historically performed by PLCrashReport.
+ */
+static const char *core_validate (const Plcrash__CrashReport *msg) {
+    if (msg->system_info == NULL)
+        return "Crash report is missing System Information section";
+
+    if (msg->system_info->os_version == NULL)
+        return "Crash report is missing System Information OS version field";
+
+    if (msg->machine_info != NULL && msg->machine_info->processor == NULL)
+        return "Crash report is missing processor info section";
+
+    if (msg->application_info == NULL)
+        return "Crash report is missing Application Information section";
+
+    if (msg->application_info->identifier == NULL)
+        return "Crash report is missing Application Information app identifier field";
+
+    if (msg->application_info->version == NULL)
+        return "Crash report is missing Application Information app version field";
+
+    if (msg->signal == NULL)
+        return "Crash report is missing Signal Information section";
+
+    if (msg->signal->name == NULL)
+        return "Crash report is missing signal name field";
+
+    if (msg->signal->code == NULL)
+        return "Crash report is missing signal code field";
+
+    if (msg->n_threads == 0)
+        return "Crash report is missing thread state information";
+
+    for (size_t i = 0; i < msg->n_threads; i++) {
+        const Plcrash__CrashReport__Thread *thread = msg->threads[i];
+
+        for (size_t j = 0; j < thread->n_registers; j++) {
+            if (thread->registers[j]->name == NULL)
+                return "Missing register name in register value";
+        }
+    }
+
+    if (msg->n_binary_images == 0)
+        return "Crash report is missing binary image information";
+
+    for (size_t i = 0; i < msg->n_binary_images; i++) {
+        if (msg->binary_images[i]->name == NULL)
+            return "Missing image name in image record";
+
+        if (msg->binary_images[i]->code_type == NULL)
+            return "Crash report is missing processor info section";
+    }
+
+    if (msg->exception != NULL) {
+        if (msg->exception->name == NULL)
+            return "Crash report is missing exception name field";
+
+        if (msg->exception->reason == NULL)
+            return "Crash report is missing exception reason field";
+    }
+
+    return NULL;
+}
+
+/**
+ * @internal
+ * Copy a processor record.
+ */
+static void core_copy_processor (plcrash_report_processor_t *dest, const Plcrash__CrashReport__Processor *src) {
+    dest->type_encoding = (plcrash_report_processor_encoding_t) src->encoding;
+    dest->type = src->type;
+    dest->subtype = src->subtype;
+}
+
+/**
+ * @internal
+ * Lay out and (if storage->base is non-NULL) populate @a report from the validated message @a msg. Called once
+ * with a NULL base to size the storage, and again to fill it; both passes must request identical allocations.
+ */
+static void core_flatten (plcrash_report_t *report, const Plcrash__CrashReport *msg, core_storage_t *storage) {
+    bool fill = (storage->base != NULL);
+    size_t frame_count = 0;
+    size_t register_count = 0;
+    size_t stack_memory_count = 0;
+
+    /* Count the flattened records */
+    for (size_t i = 0; i < msg->n_threads; i++) {
+        frame_count += msg->threads[i]->n_frames;
+        register_count += msg->threads[i]->n_registers;
+        stack_memory_count += msg->threads[i]->n_stack_memory;
+    }
+
+    if (msg->exception != NULL)
+        frame_count += msg->exception->n_frames;
+
+    /* Arrays */
+    report->thread_count = msg->n_threads;
+    report->threads = core_storage_alloc(storage, sizeof(plcrash_report_thread_t) * msg->n_threads, CORE_STORAGE_ALIGN);
+
+    report->frame_count = frame_count;
+    report->frames = core_storage_alloc(storage, sizeof(plcrash_report_frame_t) * frame_count, CORE_STORAGE_ALIGN);
+
+    report->register_count = register_count;
+    report->registers = core_storage_alloc(storage, sizeof(plcrash_report_register_t) * register_count, CORE_STORAGE_ALIGN);
+
+    report->stack_memory_count = stack_memory_count;
+    report->stack_memory = core_storage_alloc(storage, sizeof(plcrash_report_stack_memory_t) * stack_memory_count, CORE_STORAGE_ALIGN);
+
+    report->image_count = msg->n_binary_images;
+    report->images = core_storage_alloc(storage, sizeof(plcrash_report_image_t) * msg->n_binary_images, CORE_STORAGE_ALIGN);
+
+    report->writer_thread_stats_count = msg->writer_stats != NULL ? msg->writer_stats->n_threads : 0;
+    report->writer_thread_stats = core_storage_alloc(storage, sizeof(plcrash_report_writer_thread_stats_t) * report->writer_thread_stats_count,
+                                                     CORE_STORAGE_ALIGN);
+
+    /* System info */
+    {
+        const Plcrash__CrashReport__SystemInfo *src = msg->system_info;
+        plcrash_report_system_info_t *dest = &report->system_info;
+
+        dest->operating_system = (plcrash_report_os_t) src->operating_system;
+        dest->os_version = core_storage_strdup(storage, src->os_version);
+        dest->os_build = core_storage_strdup(storage, src->os_build);
+        dest->architecture = (plcrash_report_arch_t) src->architecture;
+        dest->timestamp = src->timestamp;
+    }
+
+    /* Machine info */
+    report->has_machine_info = (msg->machine_info != NULL);
+    if (report->has_machine_info) {
+        const Plcrash__CrashReport__MachineInfo *src = msg->machine_info;
+        plcrash_report_machine_info_t *dest = &report->machine_info;
+
+        dest->model = core_storage_strdup(storage, src->model);
+        core_copy_processor(&dest->processor, src->processor);
+        dest->processor_count = src->processor_count;
+        dest->logical_processor_count = src->logical_processor_count;
+    }
+
+    /* Application info */
+    report->application_info.identifier = core_storage_strdup(storage, msg->application_info->identifier);
+    report->application_info.version = core_storage_strdup(storage, msg->application_info->version);
+
+    /* Process info */
+    report->has_process_info = (msg->process_info != NULL);
+    if (report->has_process_info) {
+        const Plcrash__CrashReport__ProcessInfo *src = msg->process_info;
+        plcrash_report_process_info_t *dest = &report->process_info;
+
+        dest->process_name = core_storage_strdup(storage, src->process_name);
+        dest->process_id = src->process_id;
+        dest->process_path = core_storage_strdup(storage, src->process_path);
+        dest->parent_process_name = core_storage_strdup(storage, src->parent_process_name);
+        dest->parent_process_id = src->parent_process_id;
+        dest->native = src->native;
+    }
+
+    /* Signal info */
+    report->signal_info.name = core_storage_strdup(storage, msg->signal->name);
+    report->signal_info.code = core_storage_strdup(storage, msg->signal->code);
+    report->signal_info.address = msg->signal->address;
+
+    /* Threads */
+    frame_count = 0;
+    register_count = 0;
+    stack_memory_count = 0;
+    for (size_t i = 0; i < msg->n_threads; i++) {
+        const Plcrash__CrashReport__Thread *src = msg->threads[i];
+        plcrash_report_thread_t thread;
+
+        thread.thread_number = src->thread_number;
+        thread.crashed = src->crashed;
+        thread.frame_index = frame_count;
+        thread.frame_count = src->n_frames;
+        thread.register_index = register_count;
+        thread.register_count = src->n_registers;
+        thread.stack_memory_index = stack_memory_count;
+        thread.stack_memory_count = src->n_stack_memory;
+
+        for (size_t j = 0; j < src->n_frames; j++) {
+            if (fill)
+                report->frames[frame_count].pc = src->frames[j]->pc;
+            frame_count++;
+        }
+
+        for (size_t j = 0; j < src->n_registers; j++) {
+            const char *name = core_storage_strdup(storage, src->registers[j]->name);
+            if (fill) {
+                report->registers[register_count].name = name;
+                report->registers[register_count].value = src->registers[j]->value;
+            }
+            register_count++;
+        }
+
+        for (size_t j = 0; j < src->n_stack_memory; j++) {
+            const uint8_t *contents = core_storage_memdup(storage, &src->stack_memory[j]->contents);
+            if (fill) {
+                report->stack_memory[stack_memory_count].base_address = src->stack_memory[j]->base_address;
+                report->stack_memory[stack_memory_count].contents = contents;
+                report->stack_memory[stack_memory_count].length = src->stack_memory[j]->contents.len;
+            }
+            stack_memory_count++;
+        }
+
+        if (fill)
+            report->threads[i] = thread;
+    }
+
+    /* Exception info */
+    report->has_exception_info = (msg->exception != NULL);
+    if (report->has_exception_info) {
+        const Plcrash__CrashReport__Exception *src = msg->exception;
+        plcrash_report_exception_info_t *dest = &report->exception_info;
+
+        dest->name = core_storage_strdup(storage, src->name);
+        dest->reason = core_storage_strdup(storage, src->reason);
+        dest->frame_index = frame_count;
+        dest->frame_count = src->n_frames;
+
+        for (size_t j = 0; j < src->n_frames; j++) {
+            if (fill)
+                report->frames[frame_count].pc = src->frames[j]->pc;
+            frame_count++;
+        }
+    }
+
+    /* Binary images */
+    for (size_t i = 0; i < msg->n_binary_images; i++) {
+        const Plcrash__CrashReport__BinaryImage *src = msg->binary_images[i];
+        const char *name = core_storage_strdup(storage, src->name);
+        const uint8_t *uuid = core_storage_memdup(storage, &src->uuid);
+
+        if (fill) {
+            plcrash_report_image_t *dest = &report->images[i];
+
+            dest->base_address = src->base_address;
+            dest->size = src->size;
+            dest->name = name;
+            dest->uuid = uuid;
+            dest->uuid_length = src->uuid.len;
+            core_copy_processor(&dest->code_type, src->code_type);
+        }
+    }
+
+    /* Truncation */
+    report->has_truncation = (msg->truncation != NULL);
+    if (report->has_truncation) {
+        report->truncation.omitted_threads = msg->truncation->omitted_threads;
+        report->truncation.omitted_images = msg->truncation->omitted_images;
+        report->truncation.deadline_exceeded = msg->truncation->deadline_exceeded;
+        report->truncation.byte_budget_exceeded = msg->truncation->byte_budget_exceeded;
+    }
+
+    /* Writer statistics */
+    report->has_writer_stats = (msg->writer_stats != NULL);
+    if (report->has_writer_stats) {
+        const Plcrash__CrashReport__WriterStats *src = msg->writer_stats;
+        plcrash_report_writer_stats_t *dest = &report->writer_stats;
+
+        dest->thread_stats_index = 0;
+        dest->thread_stats_count = src->n_threads;
+        dest->total_time = src->total_time;
+        dest->image_time = src->image_time;
+        dest->read_failures = src->read_failures;
+        dest->truncated_threads = src->truncated_threads;
+        dest->system_info_bytes = src->system_info_bytes;
+        dest->machine_info_bytes = src->machine_info_bytes;
+        dest->application_info_bytes = src->application_info_bytes;
+        dest->process_info_bytes = src->process_info_bytes;
+        dest->threads_bytes = src->threads_bytes;
+        dest->binary_images_bytes = src->binary_images_bytes;
+        dest->exception_bytes = src->exception_bytes;
+        dest->signal_bytes = src->signal_bytes;
+
+        for (size_t i = 0; fill && i < src->n_threads; i++) {
+            const Plcrash__CrashReport__WriterStats__ThreadStats *thr = src->threads[i];
+            plcrash_report_writer_thread_stats_t *stats = &report->writer_thread_stats[i];
+
+            stats->thread_number = thr->thread_number;
+            stats->suspend_time = thr->suspend_time;
+            stats->walk_time = thr->walk_time;
+            stats->write_time = thr->write_time;
+            stats->truncated = thr->truncated;
+        }
+    }
+}
+
+/**
+ * @internal
+ * Restore thread number ordering. Prioritized reports write the crashed thread first, and are otherwise in
+ * order, so a stable insertion sort is effectively linear here.
+ */
+static void core_sort_threads (plcrash_report_t *report) {
+    for (size_t i = 1; i < report->thread_count; i++) {
+        plcrash_report_thread_t thread = report->threads[i];
+        size_t j = i;
+
+        while (j > 0 && report->threads[j - 1].thread_number > thread.thread_number) {
+            report->threads[j] = report->threads[j - 1];
+            j--;
+        }
+
+        report->threads[j] = thread;
+    }
+}
+
+/**
+ * @internal
+ * Decode an uncompressed crash report, including its file header.
+ */
+static plcrash_error_t core_decode (plcrash_report_t *report, const void *data, size_t length, const char **description) {
+    const uint8_t *bytes = data;
+    Plcrash__CrashReport *msg;
+    core_storage_t storage;
+    const char *error;
+
+    memset(report, 0, sizeof(*report));
+
+    /* Verify that the crash log is sufficently large */
+    if (CORE_FILE_HEADER_LEN >= length) {
+        if (description != NULL)
+            *description = "Could not decode truncated crash log";
+        return PLCRASH_EINVAL;
+    }
+
+    /* Check the file magic */
+    if (memcmp(bytes, CORE_FILE_MAGIC, CORE_FILE_MAGIC_LEN) != 0) {
+        if (description != NULL)
+            *description = "Could not decode invalid crash log header";
+        return PLCRASH_EINVAL;
+    }
+
+    /* Check the version */
+    if (bytes[CORE_FILE_MAGIC_LEN] != CORE_FILE_VERSION) {
+        if (description != NULL)
+            *description = "Could not decode unsupported crash report version";
+        return PLCRASH_EINVAL;
+    }
+
+    msg = plcrash_proto_crash_report_unpack(&protobuf_c_system_allocator, length - CORE_FILE_HEADER_LEN, bytes + CORE_FILE_HEADER_LEN);
+    if (msg == NULL) {
+        if (description != NULL)
+            *description = "An unknown error occured decoding the crash report";
+        return PLCRASH_EINVAL;
+    }
+
+    if ((error = core_validate(msg)) != NULL) {
+        protobuf_c_message_free_unpacked((ProtobufCMessage *) msg, &protobuf_c_system_allocator);
+        if (description != NULL)
+            *description = error;
+        return PLCRASH_EINVAL;
+    }
+
+    /* Size the storage, then populate it */
+    storage.base = NULL;
+    storage.offset = 0;
+    core_flatten(report, msg, &storage);
+
+    report->storage = malloc(storage.offset);
+    if (report->storage == NULL) {
+        protobuf_c_message_free_unpacked((ProtobufCMessage *) msg, &protobuf_c_system_allocator);
+        memset(report, 0, sizeof(*report));
+        if (description != NULL)
+            *description = plcrash_strerror(PLCRASH_ENOMEM);
+        return PLCRASH_ENOMEM;
+    }
+
+    storage.base = report->storage;
+    storage.offset = 0;
+    core_flatten(report, msg, &storage);
+
+    protobuf_c_message_free_unpacked((ProtobufCMessage *) msg, &protobuf_c_system_allocator);
+
+    core_sort_threads(report);
+
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * Decode an encoded crash report, including its file header. The report may be gzip-compressed, as by
+ * plcrash_gzip_compress().
+ *
+ * @param report The report to initialize. On success, the report must be released with plcrash_report_free().
+ * On failure, the report is zero-initialized and need not be freed.
+ * @param data The encoded crash report.
+ * @param length The length of @a data.
+ * @param description On failure, if non-NULL, set to a static description of the error.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, PLCRASH_EINVAL if the report is malformed or incomplete, or
+ * PLCRASH_ENOMEM if the report storage could not be allocated.
+ */
+plcrash_error_t plcrash_report_decode (plcrash_report_t *report, const void *data, size_t length, const char **description) {
+    plcrash_report_output_t output;
+    plcrash_error_t err;
+
+    if (!plcrash_gzip_detect(data, length))
+        return core_decode(report, data, length, description);
+
+    /* The decoded report does not reference the decompressed data. Size the buffer for a typical compression
+     * ratio; it grows as required. */
+    plcrash_report_output_init_buffer(&output, (length < PLCRASH_GZIP_REPORT_MAX / 4) ? length * 4 : PLCRASH_GZIP_REPORT_MAX);
+    err = plcrash_gzip_decompress(data, length, PLCRASH_GZIP_REPORT_MAX, &output);
+    if (err == PLCRASH_ESUCCESS) {
+        err = core_decode(report, output.buffer, output.length, description);
+    } else {
+        memset(report, 0, sizeof(*report));
+        if (description != NULL)
+            *description = (err == PLCRASH_ENOMEM) ? plcrash_strerror(err) : "Could not decompress crash log";
+    }
+
+    plcrash_report_output_free(&output);
+    return err;
+}
+
+/**
+ * Free all storage associated with @a report. It is safe to call this function on a zero-initialized report.
+ *
+ * @param report The report to free.
+ */
+void plcrash_report_free (plcrash_report_t *report) {
+    free(report->symbols);
+    free(report->storage);
+    memset(report, 0, sizeof(*report));
+}
+
+/**
+ * Return the binary image containing @a address, or NULL if no binary image is found.
+ *
+ * @param report The report to search.
+ * @param address The address to search for.
+ */
+const plcrash_report_image_t *plcrash_report_image_for_address (const plcrash_report_t *report, uint64_t address) {
+    for (size_t i = 0; i < report->image_count; i++) {
+        const plcrash_report_image_t *image = &report->images[i];
+
+        if (image->base_address <= address && address < (image->base_address + image->size))
+            return image;
+    }
+
+    /* Not found */
+    return NULL;
+}
+
+/**
+ * @} plcrash_report_core
+ */
@@ -0,0 +1,553 @@
+/*
+ * Copyright (c) 2008-2011 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef PLCRASH_REPORT_CORE_H
+#define PLCRASH_REPORT_CORE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#import "PLCrashAsync.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @internal
+ *
+ * @defgroup plcrash_report_core Crash Report Decoding Core
+ * @ingroup plcrash_internal
+ *
+ * Foundation-free crash report decoding and text formatting.
+ *
+ * A decoded report is a single allocation: every thread, frame, register, stack memory range, binary image and
+ * string is stored in flat, contiguous arrays, and threads refer to their frames, registers and stack memory by
+ * index. PLCrashReport and PLCrashReportTextFormatter are implemented on top of this API, and it may be used
+ * directly where Foundation is unavailable.
+ *
+ * Formatted text and JSON are streamed to a plcrash_report_output_t, which may target a file descriptor, a
+ * reusable growable buffer, or a fixed caller-provided buffer.
+ *
+ * @{
+ */
+
+/** Operating system values (matches PLCrashReportOperatingSystem and crash_report.proto) */
+typedef enum {
+    PLCRASH_REPORT_OS_MAC_OS_X = 0,
+    PLCRASH_REPORT_OS_IPHONE_OS = 1,
+    PLCRASH_REPORT_OS_IPHONE_SIMULATOR = 2,
+    PLCRASH_REPORT_OS_UNKNOWN = 3,
+    PLCRASH_REPORT_OS_LINUX = 4
+} plcrash_report_os_t;
+
+/** Architecture values (matches PLCrashReportArchitecture and crash_report.proto) */
+typedef enum {
+    PLCRASH_REPORT_ARCH_X86_32 = 0,
+    PLCRASH_REPORT_ARCH_X86_64 = 1,
+    PLCRASH_REPORT_ARCH_ARMV6 = 2,
+    PLCRASH_REPORT_ARCH_PPC = 3,
+    PLCRASH_REPORT_ARCH_PPC64 = 4,
+    PLCRASH_REPORT_ARCH_ARMV7 = 5,
+    PLCRASH_REPORT_ARCH_ARMV7S = 6,
+    PLCRASH_REPORT_ARCH_UNKNOWN = 7
+} plcrash_report_arch_t;
+
+/** Processor type encodings (matches PLCrashReportProcessorTypeEncoding and crash_report.proto) */
+typedef enum {
+    PLCRASH_REPORT_PROCESSOR_ENCODING_UNKNOWN = 0,
+    PLCRASH_REPORT_PROCESSOR_ENCODING_MACH = 1
+} plcrash_report_processor_encoding_t;
+
+/**
+ * Mach CPU types and subtypes used when formatting reports, and when describing non-Darwin hosts. These are the
+ * stable values from mach/machine.h, duplicated here so that reports may be written and formatted on hosts without
+ * Mach headers.
+ */
+enum {
+    PLCRASH_REPORT_MACH_CPU_ARCH_MASK = 0xff000000,
+    PLCRASH_REPORT_MACH_CPU_TYPE_X86 = 7,
+    PLCRASH_REPORT_MACH_CPU_TYPE_X86_64 = 7 | 0x01000000,
+    PLCRASH_REPORT_MACH_CPU_TYPE_ARM = 12,
+    PLCRASH_REPORT_MACH_CPU_TYPE_POWERPC = 18,
+    PLCRASH_REPORT_MACH_CPU_TYPE_ARM64 = 12 | 0x01000000,
+    PLCRASH_REPORT_MACH_CPU_TYPE_POWERPC64 = 18 | 0x01000000,
+
+    PLCRASH_REPORT_MACH_CPU_SUBTYPE_X86_ALL = 3,
+    PLCRASH_REPORT_MACH_CPU_SUBTYPE_ARM_V6 = 6,
+    PLCRASH_REPORT_MACH_CPU_SUBTYPE_ARM_V7 = 9,
+    PLCRASH_REPORT_MACH_CPU_SUBTYPE_ARM_V7S = 11
+};
+
+/**
+ * Processor type.
+ */
+typedef struct plcrash_report_processor {
+    /** Type encoding used to interpret @a type and @a subtype */
+    plcrash_report_processor_encoding_t type_encoding;
+
+    /** CPU type */
+    uint64_t type;
+
+    /** CPU subtype */
+    uint64_t subtype;
+} plcrash_report_processor_t;
+
+/**
+ * Host operating system.
+ */
+typedef struct plcrash_report_system_info {
+    /** Operating system */
+    plcrash_report_os_t operating_system;
+
+    /** Operating system version */
+    const char *os_version;
+
+    /** Operating system build, or NULL if unavailable */
+    const char *os_build;
+
+    /** Processor architecture (deprecated in favor of the machine info processor) */
+    plcrash_report_arch_t architecture;
+
+    /** Report timestamp in seconds since the epoch, or 0 if unknown */
+    int64_t timestamp;
+} plcrash_report_system_info_t;
+
+/**
+ * Host hardware.
+ */
+typedef struct plcrash_report_machine_info {
+    /** Hardware model, or NULL if unavailable */
+    const char *model;
+
+    /** Host processor */
+    plcrash_report_processor_t processor;
+
+    /** Number of physical processor cores */
+    uint32_t processor_count;
+
+    /** Number of logical processors */
+    uint32_t logical_processor_count;
+} plcrash_report_machine_info_t;
+
+/**
+ * Crashed application.
+ */
+typedef struct plcrash_report_application_info {
+    /** Application identifier */
+    const char *identifier;
+
+    /** Application version */
+    const char *version;
+} plcrash_report_application_info_t;
+
+/**
+ * Crashed process.
+ */
+typedef struct plcrash_report_process_info {
+    /** Process name, or NULL if unavailable */
+    const char *process_name;
+
+    /** Process ID */
+    uint32_t process_id;
+
+    /** Process path, or NULL if unavailable */
+    const char *process_path;
+
+    /** Parent process name, or NULL if unavailable */
+    const char *parent_process_name;
+
+    /** Parent process ID */
+    uint32_t parent_process_id;
+
+    /** False if the process was run via process-level CPU emulation */
+    bool native;
+} plcrash_report_process_info_t;
+
+/**
+ * Fatal signal.
+ */
+typedef struct plcrash_report_signal_info {
+    /** Signal name */
+    const char *name;
+
+    /** Signal code */
+    const char *code;
+
+    /** Faulting instruction or address */
+    uint64_t address;
+} plcrash_report_signal_info_t;
+
+/**
+ * Uncaught exception.
+ */
+typedef struct plcrash_report_exception_info {
+    /** Exception name */
+    const char *name;
+
+    /** Exception reason */
+    const char *reason;
+
+    /** Index of the exception's first stack frame in plcrash_report_t::frames */
+    size_t frame_index;
+
+    /** Number of stack frames. May be 0. */
+    size_t frame_count;
+} plcrash_report_exception_info_t;
+
+/**
+ * Stack frame.
+ */
+typedef struct plcrash_report_frame {
+    /** Instruction pointer */
+    uint64_t pc;
+} plcrash_report_frame_t;
+
+/**
+ * Register value.
+ */
+typedef struct plcrash_report_register {
+    /** Register name */
+    const char *name;
+
+    /** Register value */
+    uint64_t value;
+} plcrash_report_register_t;
+
+/**
+ * Captured stack memory range.
+ */
+typedef struct plcrash_report_stack_memory {
+    /** Address of the first captured byte */
+    uint64_t base_address;
+
+    /** Captured bytes */
+    const uint8_t *contents;
+
+    /** Number of captured bytes */
+    size_t length;
+} plcrash_report_stack_memory_t;
+
+/**
+ * Thread state.
+ */
+typedef struct plcrash_report_thread {
+    /** Thread number */
+    uint32_t thread_number;
+
+    /** True if this is the crashed thread */
+    bool crashed;
+
+    /** Index of the thread's first stack frame in plcrash_report_t::frames */
+    size_t frame_index;
+
+    /** Number of stack frames */
+    size_t frame_count;
+
+    /** Index of the thread's first register in plcrash_report_t::registers */
+    size_t register_index;
+
+    /** Number of registers */
+    size_t register_count;
+
+    /** Index of the thread's first range in plcrash_report_t::stack_memory */
+    size_t stack_memory_index;
+
+    /** Number of stack memory ranges */
+    size_t stack_memory_count;
+} plcrash_report_thread_t;
+
+/**
+ * Binary image.
+ */
+typedef struct plcrash_report_image {
+    /** Image base address */
+    uint64_t base_address;
+
+    /** Image size */
+    uint64_t size;
+
+    /** Image path */
+    const char *name;
+
+    /** Image UUID, or NULL if unavailable */
+    const uint8_t *uuid;
+
+    /** Length of @a uuid */
+    size_t uuid_length;
+
+    /** Image code type */
+    plcrash_report_processor_t code_type;
+} plcrash_report_image_t;
+
+/**
+ * Report truncation.
+ */
+typedef struct plcrash_report_truncation {
+    /** Number of threads that were not written */
+    uint32_t omitted_threads;
+
+    /** Number of binary images that were not written */
+    uint32_t omitted_images;
+
+    /** True if the wall-clock budget was exhausted */
+    bool deadline_exceeded;
+
+    /** True if the byte budget was exhausted */
+    bool byte_budget_exceeded;
+} plcrash_report_truncation_t;
+
+/**
+ * Per-thread writer statistics.
+ */
+typedef struct plcrash_report_writer_thread_stats {
+    /** Thread number */
+    uint32_t thread_number;
+
+    /** Time spent suspending the thread, in nanoseconds */
+    uint64_t suspend_time;
+
+    /** Time spent walking the thread's stack, in nanoseconds */
+    uint64_t walk_time;
+
+    /** Time spent walking the thread's stack and writing the thread, in nanoseconds */
+    uint64_t write_time;
+
+    /** True if the thread's backtrace was truncated at the per-thread frame limit */
+    bool truncated;
+} plcrash_report_writer_thread_stats_t;
+
+/**
+ * Writer statistics.
+ */
+typedef struct plcrash_report_writer_stats {
+    /** Index of the first per-thread record in plcrash_report_t::writer_thread_stats */
+    size_t thread_stats_index;
+
+    /** Number of per-thread records */
+    size_t thread_stats_count;
+
+    /** Total time spent writing the report, in nanoseconds */
+    uint64_t total_time;
+
+    /** Time spent writing binary images, in nanoseconds */
+    uint64_t image_time;
+
+    /** Number of failed memory reads */
+    uint32_t read_failures;
+
+    /** Number of threads whose backtrace was truncated at the per-thread frame limit */
+    uint32_t truncated_threads;
+
+    /** Bytes emitted per section */
+    uint32_t system_info_bytes;
+    uint32_t machine_info_bytes;
+    uint32_t application_info_bytes;
+    uint32_t process_info_bytes;
+    uint32_t threads_bytes;
+    uint32_t binary_images_bytes;
+    uint32_t exception_bytes;
+    uint32_t signal_bytes;
+} plcrash_report_writer_stats_t;
+
+/**
+ * Symbol information for a stack frame.
+ */
+typedef struct plcrash_report_symbol {
+    /** Symbol name, or NULL if the frame could not be symbolicated */
+    const char *name;
+
+    /** Offset of the frame's instruction pointer from the start of the symbol */
+    uint64_t offset;
+
+    /** Source file name, or NULL if line information is unavailable */
+    const char *file;
+
+    /** Source line number, or 0 if line information is unavailable */
+    uint32_t line;
+} plcrash_report_symbol_t;
+
+/**
+ * A decoded crash report.
+ *
+ * All pointers refer to storage owned by the report, and remain valid until plcrash_report_free() is called.
+ */
+typedef struct plcrash_report {
+    /** System info */
+    plcrash_report_system_info_t system_info;
+
+    /** True if @a machine_info is available (v1.1+ reports) */
+    bool has_machine_info;
+
+    /** Machine info */
+    plcrash_report_machine_info_t machine_info;
+
+    /** Application info */
+    plcrash_report_application_info_t application_info;
+
+    /** True if @a process_info is available (v1.1+ reports) */
+    bool has_process_info;
+
+    /** Process info */
+    plcrash_report_process_info_t process_info;
+
+    /** Signal info */
+    plcrash_report_signal_info_t signal_info;
+
+    /** True if @a exception_info is available */
+    bool has_exception_info;
+
+    /** Exception info */
+    plcrash_report_exception_info_t exception_info;
+
+    /** True if @a truncation is available */
+    bool has_truncation;
+
+    /** Truncation info */
+    plcrash_report_truncation_t truncation;
+
+    /** True if @a writer_stats is available */
+    bool has_writer_stats;
+
+    /** Writer statistics */
+    plcrash_report_writer_stats_t writer_stats;
+
+    /** Threads, in ascending thread number order */
+    plcrash_report_thread_t *threads;
+    size_t thread_count;
+
+    /** Stack frames of all threads and the exception */
+    plcrash_report_frame_t *frames;
+    size_t frame_count;
+
+    /** Registers of all threads */
+    plcrash_report_register_t *registers;
+    size_t register_count;
+
+    /** Stack memory ranges of all threads */
+    plcrash_report_stack_memory_t *stack_memory;
+    size_t stack_memory_count;
+
+    /** Binary images, in report order */
+    plcrash_report_image_t *images;
+    size_t image_count;
+
+    /** Per-thread writer statistics */
+    plcrash_report_writer_thread_stats_t *writer_thread_stats;
+    size_t writer_thread_stats_count;
+
+    /** Symbol information for each entry in @a frames, or NULL if the report has not been symbolicated. The
+     * formatters include symbol names and source locations when available. See plcrash_symbolicator_symbolicate(). */
+    plcrash_report_symbol_t *symbols;
+
+    /** @internal Backing storage for all of the above, excluding @a symbols. */
+    void *storage;
+} plcrash_report_t;
+
+/**
+ * Supported text output formats (matches PLCrashReportTextFormat).
+ */
+typedef enum {
+    /** An iOS-compatible crash log text format */
+    PLCRASH_REPORT_TEXT_FORMAT_IOS = 0
+} plcrash_report_text_format_t;
+
+/** Output destinations supported by plcrash_report_output_t */
+typedef enum {
+    /** Output is written to a file descriptor, through a fixed buffer */
+    PLCRASH_REPORT_OUTPUT_FD = 0,
+
+    /** Output accumulates in a growable, reusable buffer */
+    PLCRASH_REPORT_OUTPUT_BUFFER = 1,
+
+    /** Output is written to a fixed caller-provided buffer; output beyond its end is counted, then discarded */
+    PLCRASH_REPORT_OUTPUT_FIXED = 2
+} plcrash_report_output_type_t;
+
+/**
+ * Text output stream used by the report formatters.
+ *
+ * Output is written in place with no intermediate per-line allocations. An output may be reused across
+ * reports; see plcrash_report_output_reset().
+ */
+typedef struct plcrash_report_output {
+    /** Output destination */
+    plcrash_report_output_type_t type;
+
+    /** Destination file descriptor (PLCRASH_REPORT_OUTPUT_FD) */
+    int fd;
+
+    /** Output buffer */
+    char *buffer;
+
+    /** Capacity of @a buffer */
+    size_t capacity;
+
+    /** Number of bytes currently held in @a buffer */
+    size_t length;
+
+    /** Total number of bytes of output produced since the output was last reset, including any that were discarded */
+    size_t total;
+
+    /** First error encountered, or PLCRASH_ESUCCESS. Once set, further output is discarded. */
+    plcrash_error_t error;
+
+    /** The errno value associated with a PLCRASH_OUTPUT_ERR error */
+    int errnum;
+
+    /** True if @a buffer was allocated by the output */
+    bool owns_buffer;
+} plcrash_report_output_t;
+
+plcrash_error_t plcrash_report_decode (plcrash_report_t *report, const void *data, size_t length, const char **description);
+void plcrash_report_free (plcrash_report_t *report);
+
+const plcrash_report_image_t *plcrash_report_image_for_address (const plcrash_report_t *report, uint64_t address);
+
+void plcrash_report_output_init_fd (plcrash_report_output_t *output, int fd, char *buffer, size_t size);
+void plcrash_report_output_init_buffer (plcrash_report_output_t *output, size_t initial_capacity);
+void plcrash_report_output_init_fixed (plcrash_report_output_t *output, char *buffer, size_t size);
+void plcrash_report_output_write (plcrash_report_output_t *output, const void *data, size_t length);
+plcrash_error_t plcrash_report_output_flush (plcrash_report_output_t *output);
+void plcrash_report_output_reset (plcrash_report_output_t *output);
+char *plcrash_report_output_detach (plcrash_report_output_t *output, size_t *length);
+void plcrash_report_output_free (plcrash_report_output_t *output);
+
+plcrash_error_t plcrash_report_write_text (const plcrash_report_t *report, plcrash_report_text_format_t format, plcrash_report_output_t *output);
+size_t plcrash_report_format_text (const plcrash_report_t *report, plcrash_report_text_format_t format, char *buf, size_t size);
+
+plcrash_error_t plcrash_report_write_json (const plcrash_report_t *report, plcrash_report_output_t *output);
+
+/**
+ * @} plcrash_report_core
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PLCRASH_REPORT_CORE_H */
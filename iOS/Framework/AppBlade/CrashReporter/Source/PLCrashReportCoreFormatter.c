@@ -0,0 +1,1418 @@
+/*
+ * Copyright (c) 2008-2011 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PLCrashReportCore.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * @ingroup plcrash_report_core
+ * @{
+ */
+
+/* Default buffer capacity of a growable output */
+#define CORE_OUTPUT_DEFAULT_CAPACITY 16384
+
+/**
+ * Initialize @a output to write to @a fd. Output is accumulated in @a buffer, and written to @a fd whenever the
+ * buffer fills and when plcrash_report_output_flush() is called.
+ *
+ * @param output The output to initialize.
+ * @param fd The destination file descriptor. The descriptor is not closed by the output.
+ * @param buffer The write buffer. If NULL, a buffer of @a size bytes is allocated, and released by
+ * plcrash_report_output_free().
+ * @param size The size of @a buffer.
+ */
+void plcrash_report_output_init_fd (plcrash_report_output_t *output, int fd, char *buffer, size_t size) {
+    memset(output, 0, sizeof(*output));
+    output->type = PLCRASH_REPORT_OUTPUT_FD;
+    output->fd = fd;
+
+    if (size == 0)
+        size = CORE_OUTPUT_DEFAULT_CAPACITY;
+
+    if (buffer == NULL) {
+        buffer = malloc(size);
+        output->owns_buffer = true;
+        if (buffer == NULL) {
+            output->error = PLCRASH_ENOMEM;
+            size = 0;
+        }
+    }
+
+    output->buffer = buffer;
+    output->capacity = size;
+}
+
+/**
+ * Initialize @a output to accumulate output in a growable buffer. The buffer is retained across
+ * plcrash_report_output_reset(), so that a single output may be reused for many reports without
+ * reallocation.
+ *
+ * @param output The output to initialize.
+ * @param initial_capacity The initial buffer capacity, or 0 to use a default capacity.
+ */
+void plcrash_report_output_init_buffer (plcrash_report_output_t *output, size_t initial_capacity) {
+    memset(output, 0, sizeof(*output));
+    output->type = PLCRASH_REPORT_OUTPUT_BUFFER;
+    output->fd = -1;
+    output->owns_buffer = true;
+
+    if (initial_capacity == 0)
+        initial_capacity = CORE_OUTPUT_DEFAULT_CAPACITY;
+
+    output->buffer = malloc(initial_capacity);
+    if (output->buffer == NULL) {
+        output->error = PLCRASH_ENOMEM;
+        return;
+    }
+
+    output->capacity = initial_capacity;
+}
+
+/**
+ * Initialize @a output to write to a fixed caller-provided buffer. Output that does not fit is discarded, but
+ * is still counted in plcrash_report_output_t::total, as with snprintf(). The output is not NUL-terminated.
+ *
+ * @param output The output to initialize.
+ * @param buffer The destination buffer. May be NULL if @a size is 0.
+ * @param size The size of @a buffer.
+ */
+void plcrash_report_output_init_fixed (plcrash_report_output_t *output, char *buffer, size_t size) {
+    memset(output, 0, sizeof(*output));
+    output->type = PLCRASH_REPORT_OUTPUT_FIXED;
+    output->fd = -1;
+    output->buffer = buffer;
+    output->capacity = size;
+}
+
+/**
+ * @internal
+ * Write all @a length bytes of @a data to @a output's file descriptor, retrying on EINTR.
+ */
+static bool core_output_writen (plcrash_report_output_t *output, const char *data, size_t length) {
+    while (length > 0) {
+        ssize_t written = write(output->fd, data, length);
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+
+            output->error = PLCRASH_OUTPUT_ERR;
+            output->errnum = errno;
+            return false;
+        }
+
+        data += written;
+        length -= (size_t) written;
+    }
+
+    return true;
+}
+
+/**
+ * @internal
+ * Slow path of plcrash_report_output_write(), called when @a length bytes do not fit in the remaining buffer
+ * space.
+ */
+static void core_output_overflow (plcrash_report_output_t *output, const char *data, size_t length) {
+    switch (output->type) {
+        case PLCRASH_REPORT_OUTPUT_FD:
+            if (plcrash_report_output_flush(output) != PLCRASH_ESUCCESS)
+                return;
+
+            /* Write large blocks directly */
+            if (length >= output->capacity) {
+                core_output_writen(output, data, length);
+                return;
+            }
+            break;
+
+        case PLCRASH_REPORT_OUTPUT_BUFFER: {
+            size_t capacity = output->capacity > 0 ? output->capacity : CORE_OUTPUT_DEFAULT_CAPACITY;
+            char *buffer;
+
+            while (capacity - output->length < length)
+                capacity *= 2;
+
+            if ((buffer = realloc(output->buffer, capacity)) == NULL) {
+                output->error = PLCRASH_ENOMEM;
+                return;
+            }
+
+            output->buffer = buffer;
+            output->capacity = capacity;
+            break;
+        }
+
+        case PLCRASH_REPORT_OUTPUT_FIXED:
+            /* Keep what fits; the remainder has already been counted */
+            if ((length = output->capacity - output->length) == 0)
+                return;
+            break;
+    }
+
+    memcpy(output->buffer + output->length, data, length);
+    output->length += length;
+}
+
+/**
+ * Write @a length bytes of @a data to @a output. Errors are recorded in plcrash_report_output_t::error, after
+ * which further output is discarded.
+ *
+ * @param output The output to write to.
+ * @param data The data to write.
+ * @param length The number of bytes to write.
+ */
+void plcrash_report_output_write (plcrash_report_output_t *output, const void *data, size_t length) {
+    if (output->error != PLCRASH_ESUCCESS || length == 0)
+        return;
+
+    output->total += length;
+
+    if (output->capacity - output->length >= length) {
+        memcpy(output->buffer + output->length, data, length);
+        output->length += length;
+        return;
+    }
+
+    core_output_overflow(output, data, length);
+}
+
+/**
+ * Write any buffered output to the output's file descriptor. For buffer outputs, this is a no-op.
+ *
+ * @param output The output to flush.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, or the first error recorded by the output.
+ */
+plcrash_error_t plcrash_report_output_flush (plcrash_report_output_t *output) {
+    if (output->error != PLCRASH_ESUCCESS)
+        return output->error;
+
+    if (output->type == PLCRASH_REPORT_OUTPUT_FD && output->length > 0) {
+        if (!core_output_writen(output, output->buffer, output->length))
+            return output->error;
+        output->length = 0;
+    }
+
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * Discard any buffered output and clear the output's error and byte count, retaining its buffer for reuse.
+ *
+ * @param output The output to reset.
+ */
+void plcrash_report_output_reset (plcrash_report_output_t *output) {
+    output->length = 0;
+    output->total = 0;
+    output->errnum = 0;
+
+    /* An allocation failure at initialization can not be cleared */
+    output->error = (output->owns_buffer && output->buffer == NULL) ? PLCRASH_ENOMEM : PLCRASH_ESUCCESS;
+}
+
+/**
+ * Transfer ownership of a buffer output's contents to the caller. The output is left empty, and must be
+ * re-initialized before reuse.
+ *
+ * @param output A buffer output.
+ * @param length On return, the number of bytes of output.
+ *
+ * @return Returns the buffer, which must be released with free(), or NULL if the output is not a buffer output
+ * or has recorded an error.
+ */
+char *plcrash_report_output_detach (plcrash_report_output_t *output, size_t *length) {
+    char *buffer;
+
+    if (output->type != PLCRASH_REPORT_OUTPUT_BUFFER || output->error != PLCRASH_ESUCCESS)
+        return NULL;
+
+    buffer = output->buffer;
+    *length = output->length;
+
+    output->buffer = NULL;
+    output->capacity = 0;
+    output->length = 0;
+    output->owns_buffer = false;
+
+    return buffer;
+}
+
+/**
+ * Free any buffer allocated by @a output. Buffered fd output that has not been flushed is discarded.
+ *
+ * @param output The output to free.
+ */
+void plcrash_report_output_free (plcrash_report_output_t *output) {
+    if (output->owns_buffer)
+        free(output->buffer);
+
+    output->buffer = NULL;
+    output->capacity = 0;
+    output->length = 0;
+    output->owns_buffer = false;
+}
+
+/**
+ * @internal
+ * Write a NUL-terminated string.
+ */
+static inline void core_puts (plcrash_report_output_t *output, const char *str) {
+    plcrash_report_output_write(output, str, strlen(str));
+}
+
+/**
+ * @internal
+ * Write @a count spaces.
+ */
+static void core_pad (plcrash_report_output_t *output, size_t count) {
+    static const char spaces[] = "                                        ";
+
+    while (count > 0) {
+        size_t n = count < sizeof(spaces) - 1 ? count : sizeof(spaces) - 1;
+        plcrash_report_output_write(output, spaces, n);
+        count -= n;
+    }
+}
+
+/**
+ * @internal
+ * Write @a length bytes of @a str, padded with spaces to @a width. Equivalent to "%-*.*s" if @a left is true,
+ * otherwise to "%*.*s".
+ */
+static void core_field (plcrash_report_output_t *output, const char *str, size_t length, size_t width, bool left) {
+    size_t padding = length < width ? width - length : 0;
+
+    if (!left)
+        core_pad(output, padding);
+
+    plcrash_report_output_write(output, str, length);
+
+    if (left)
+        core_pad(output, padding);
+}
+
+/**
+ * @internal
+ * Format @a value as lowercase hexadecimal with at least @a min_digits digits, ending at @a end. Returns the
+ * start of the formatted digits. The buffer must have room for 16 digits.
+ */
+static inline char *core_format_hex (char *end, uint64_t value, unsigned min_digits) {
+    static const char hex[] = "0123456789abcdef";
+    char *p = end;
+
+    do {
+        *--p = hex[value & 0xF];
+        value >>= 4;
+    } while (value != 0);
+
+    while ((unsigned) (end - p) < min_digits)
+        *--p = '0';
+
+    return p;
+}
+
+/**
+ * @internal
+ * Format @a value as unsigned decimal, ending at @a end. Returns the start of the formatted digits. The buffer
+ * must have room for 20 digits.
+ */
+static inline char *core_format_udec (char *end, uint64_t value) {
+    char *p = end;
+
+    do {
+        *--p = (char) ('0' + (value % 10));
+        value /= 10;
+    } while (value != 0);
+
+    return p;
+}
+
+/**
+ * @internal
+ * Write @a value as "0x"-prefixed hexadecimal with at least @a min_digits digits ("0x%0*" PRIx64).
+ */
+static void core_hex (plcrash_report_output_t *output, uint64_t value, unsigned min_digits) {
+    char buf[18];
+    char *end = buf + sizeof(buf);
+    char *p = core_format_hex(end, value, min_digits);
+
+    *--p = 'x';
+    *--p = '0';
+    plcrash_report_output_write(output, p, (size_t) (end - p));
+}
+
+/**
+ * @internal
+ * Write @a value as alternate-form hexadecimal, right-aligned to @a width ("%#*" PRIx64). As with printf(),
+ * zero is written without the "0x" prefix.
+ */
+static void core_hex_field (plcrash_report_output_t *output, uint64_t value, size_t width) {
+    char buf[18];
+    char *end = buf + sizeof(buf);
+    char *p = core_format_hex(end, value, 1);
+
+    if (value != 0) {
+        *--p = 'x';
+        *--p = '0';
+    }
+
+    core_field(output, p, (size_t) (end - p), width, false);
+}
+
+/**
+ * @internal
+ * Write @a value as unsigned decimal, padded to @a width. Equivalent to "%-*" PRIu64 if @a left is true.
+ */
+static void core_udec_field (plcrash_report_output_t *output, uint64_t value, size_t width, bool left) {
+    char buf[20];
+    char *end = buf + sizeof(buf);
+    char *p = core_format_udec(end, value);
+
+    core_field(output, p, (size_t) (end - p), width, left);
+}
+
+/**
+ * @internal
+ * Write @a value as unsigned decimal ("%" PRIu64).
+ */
+static void core_udec (plcrash_report_output_t *output, uint64_t value) {
+    core_udec_field(output, value, 0, true);
+}
+
+/**
+ * @internal
+ * Write @a value as signed decimal ("%" PRId64).
+ */
+static void core_sdec (plcrash_report_output_t *output, int64_t value) {
+    char buf[21];
+    char *end = buf + sizeof(buf);
+    char *p;
+
+    if (value < 0) {
+        p = core_format_udec(end, (uint64_t) 0 - (uint64_t) value);
+        *--p = '-';
+    } else {
+        p = core_format_udec(end, (uint64_t) value);
+    }
+
+    plcrash_report_output_write(output, p, (size_t) (end - p));
+}
+
+/**
+ * @internal
+ * Map the report to an Apple-style code type name, and determine whether the architecture is LP64. Returns NULL
+ * if the code type is unknown.
+ */
+static const char *core_code_type (const plcrash_report_t *report, bool *lp64) {
+    /* Attempt to derive the code type from the binary images */
+    for (size_t i = 0; i < report->image_count; i++) {
+        const plcrash_report_processor_t *code_type = &report->images[i].code_type;
+
+        /* Skip unknown encodings */
+        if (code_type->type_encoding != PLCRASH_REPORT_PROCESSOR_ENCODING_MACH)
+            continue;
+
+        switch (code_type->type) {
+            case PLCRASH_REPORT_MACH_CPU_TYPE_ARM:
+                *lp64 = false;
+                return "ARM";
+
+            case PLCRASH_REPORT_MACH_CPU_TYPE_X86:
+                *lp64 = false;
+                return "X86";
+
+            case PLCRASH_REPORT_MACH_CPU_TYPE_X86_64:
+                *lp64 = true;
+                return "X86-64";
+
+            case PLCRASH_REPORT_MACH_CPU_TYPE_POWERPC:
+                *lp64 = false;
+                return "PPC";
+
+            default:
+                break;
+        }
+    }
+
+    /* If we were unable to determine the code type, fall back on the legacy architecture value. */
+    switch (report->system_info.architecture) {
+        case PLCRASH_REPORT_ARCH_ARMV6:
+        case PLCRASH_REPORT_ARCH_ARMV7:
+            *lp64 = false;
+            return "ARM";
+
+        case PLCRASH_REPORT_ARCH_X86_32:
+            *lp64 = false;
+            return "X86";
+
+        case PLCRASH_REPORT_ARCH_X86_64:
+            *lp64 = true;
+            return "X86-64";
+
+        case PLCRASH_REPORT_ARCH_PPC:
+            *lp64 = false;
+            return "PPC";
+
+        default:
+            *lp64 = true;
+            return NULL;
+    }
+}
+
+/**
+ * @internal
+ * Write @a name, or "Unknown (<value>)" if @a name is NULL.
+ */
+static void core_name_or_unknown (plcrash_report_output_t *output, const char *name, int value) {
+    if (name != NULL) {
+        core_puts(output, name);
+        return;
+    }
+
+    core_puts(output, "Unknown (");
+    core_sdec(output, value);
+    core_puts(output, ")");
+}
+
+/**
+ * @internal
+ * Return the architecture name used in the binary image list.
+ */
+static const char *core_image_arch_name (const plcrash_report_image_t *image) {
+    if (image->code_type.type_encoding != PLCRASH_REPORT_PROCESSOR_ENCODING_MACH)
+        return "???";
+
+    switch (image->code_type.type) {
+        case PLCRASH_REPORT_MACH_CPU_TYPE_ARM:
+            /* Apple includes subtype for ARM binaries. */
+            switch (image->code_type.subtype) {
+                case PLCRASH_REPORT_MACH_CPU_SUBTYPE_ARM_V6:
+                    return "armv6";
+                case PLCRASH_REPORT_MACH_CPU_SUBTYPE_ARM_V7:
+                    return "armv7";
+                case PLCRASH_REPORT_MACH_CPU_SUBTYPE_ARM_V7S:
+                    return "armv7s";
+                default:
+                    return "arm-unknown";
+            }
+
+        case PLCRASH_REPORT_MACH_CPU_TYPE_X86:
+            return "i386";
+
+        case PLCRASH_REPORT_MACH_CPU_TYPE_X86_64:
+            return "x86_64";
+
+        case PLCRASH_REPORT_MACH_CPU_TYPE_POWERPC:
+            return "powerpc";
+
+        default:
+            return "???";
+    }
+}
+
+/**
+ * @internal
+ * Binary image sort key.
+ */
+typedef struct core_image_key {
+    /** Image base address */
+    uint64_t base_address;
+
+    /** Image end address (exclusive) */
+    uint64_t end_address;
+
+    /** Index of the image in plcrash_report_t::images */
+    size_t index;
+} core_image_key_t;
+
+/**
+ * @internal
+ * Binary images sorted by base address, used both to order the image list and to map frame addresses to
+ * images by binary search.
+ */
+typedef struct core_image_index {
+    /** Sorted image keys */
+    core_image_key_t *keys;
+
+    /** True if any two images overlap. Lookups then fall back to plcrash_report_image_for_address(), which
+     * returns the first matching image in report order. */
+    bool overlapping;
+} core_image_index_t;
+
+/**
+ * @internal
+ * Order images by base address, then by report order.
+ */
+static int core_image_compare (const void *a, const void *b) {
+    const core_image_key_t *key1 = a;
+    const core_image_key_t *key2 = b;
+
+    if (key1->base_address != key2->base_address)
+        return key1->base_address < key2->base_address ? -1 : 1;
+
+    return key1->index < key2->index ? -1 : (key1->index > key2->index);
+}
+
+/**
+ * @internal
+ * Build the sorted image index for @a report.
+ */
+static bool core_image_index_init (core_image_index_t *index, const plcrash_report_t *report) {
+    uint64_t max_end = 0;
+
+    index->overlapping = false;
+    index->keys = malloc(sizeof(core_image_key_t) * (report->image_count > 0 ? report->image_count : 1));
+    if (index->keys == NULL)
+        return false;
+
+    for (size_t i = 0; i < report->image_count; i++) {
+        index->keys[i].base_address = report->images[i].base_address;
+        index->keys[i].end_address = report->images[i].base_address + report->images[i].size;
+        index->keys[i].index = i;
+    }
+    qsort(index->keys, report->image_count, sizeof(core_image_key_t), core_image_compare);
+
+    for (size_t i = 0; i < report->image_count; i++) {
+        if (i > 0 && index->keys[i].base_address < max_end)
+            index->overlapping = true;
+
+        if (index->keys[i].end_address > max_end)
+            max_end = index->keys[i].end_address;
+    }
+
+    return true;
+}
+
+/**
+ * @internal
+ * Return the image containing @a address, or NULL if none.
+ */
+static const plcrash_report_image_t *core_image_index_lookup (const core_image_index_t *index, const plcrash_report_t *report, uint64_t address) {
+    size_t lo = 0;
+    size_t hi = report->image_count;
+
+    if (index->overlapping)
+        return plcrash_report_image_for_address(report, address);
+
+    /* Find the last image with a base address <= address */
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+
+        if (index->keys[mid].base_address <= address)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    if (lo == 0 || address >= index->keys[lo - 1].end_address)
+        return NULL;
+
+    return &report->images[index->keys[lo - 1].index];
+}
+
+/**
+ * @internal
+ * Return the last path component of @a path (as with -[NSString lastPathComponent]), setting @a len to its length.
+ */
+static const char *core_last_path_component (const char *path, size_t *len) {
+    size_t end = strlen(path);
+    size_t start;
+
+    /* Trailing slashes are ignored, unless the path is entirely slashes */
+    while (end > 1 && path[end - 1] == '/')
+        end--;
+
+    start = end;
+    while (start > 0 && path[start - 1] != '/')
+        start--;
+
+    if (start == end && end > 0)
+        start = end - 1;
+
+    *len = end - start;
+    return path + start;
+}
+
+/**
+ * @internal
+ * Write a stack frame line for display in a thread backtrace.
+ */
+static void core_write_frame (plcrash_report_output_t *output, const plcrash_report_t *report, const core_image_index_t *images,
+                              const plcrash_report_frame_t *frame, size_t frame_index)
+{
+    /* Base image address containing instrumention pointer, offset of the IP from that base
+     * address, and the associated image name */
+    const plcrash_report_image_t *image = core_image_index_lookup(images, report, frame->pc);
+    uint64_t base_address = 0x0;
+    uint64_t pc_offset = 0x0;
+    const char *image_name = "???";
+    size_t image_name_len = 3;
+
+    if (image != NULL) {
+        image_name = core_last_path_component(image->name, &image_name_len);
+        base_address = image->base_address;
+        pc_offset = frame->pc - image->base_address;
+    }
+
+    /* "%-4ld%-36s0x%08" PRIx64 " 0x%" PRIx64 " + %" PRId64 "\n" */
+    core_udec_field(output, frame_index, 4, true);
+    core_field(output, image_name, image_name_len, 36, true);
+    core_hex(output, frame->pc, 8);
+    core_puts(output, " ");
+
+    /* Symbolicated frames use the "symbol + offset (file:line)" form */
+    if (report->symbols != NULL && report->symbols[frame - report->frames].name != NULL) {
+        const plcrash_report_symbol_t *symbol = &report->symbols[frame - report->frames];
+
+        core_puts(output, symbol->name);
+        core_puts(output, " + ");
+        core_udec(output, symbol->offset);
+        if (symbol->file != NULL) {
+            core_puts(output, " (");
+            core_puts(output, symbol->file);
+            core_puts(output, ":");
+            core_udec(output, symbol->line);
+            core_puts(output, ")");
+        }
+        core_puts(output, "\n");
+        return;
+    }
+
+    core_hex(output, base_address, 1);
+    core_puts(output, " + ");
+    core_sdec(output, (int64_t) pc_offset);
+    core_puts(output, "\n");
+}
+
+/**
+ * @internal
+ * Write the binary image list. The iPhone crash report format sorts these in ascending order, by the base address.
+ */
+static void core_write_images (plcrash_report_output_t *output, const plcrash_report_t *report, const core_image_index_t *images, bool lp64) {
+    static const char hex[] = "0123456789abcdef";
+    size_t width = lp64 ? 18 : 10;
+
+    core_puts(output, "Binary Images:\n");
+
+    for (size_t i = 0; i < report->image_count; i++) {
+        const plcrash_report_image_t *image = &report->images[images->keys[i].index];
+        const char *name;
+        size_t name_len;
+
+        /* base_address - terminating_address [designator]file_name arch <uuid> file_path. The Apple format uses an
+         * inclusive range. */
+        core_hex_field(output, image->base_address, width);
+        core_puts(output, " - ");
+        core_hex_field(output, image->base_address + ((image->size > 1 ? image->size : 1) - 1), width);
+        core_puts(output, " ");
+
+        /* Determine if this is the main executable */
+        if (report->has_process_info && report->process_info.process_path != NULL && strcmp(image->name, report->process_info.process_path) == 0)
+            core_puts(output, "+");
+        else
+            core_puts(output, " ");
+
+        name = core_last_path_component(image->name, &name_len);
+        plcrash_report_output_write(output, name, name_len);
+        core_puts(output, " ");
+        core_puts(output, core_image_arch_name(image));
+        core_puts(output, "  <");
+
+        /* Write the UUID if it exists */
+        if (image->uuid != NULL) {
+            for (size_t j = 0; j < image->uuid_length; j++) {
+                char digits[2] = { hex[image->uuid[j] >> 4], hex[image->uuid[j] & 0x0F] };
+                plcrash_report_output_write(output, digits, sizeof(digits));
+            }
+        } else {
+            core_puts(output, "???");
+        }
+
+        core_puts(output, "> ");
+        core_puts(output, image->name);
+        core_puts(output, "\n");
+    }
+}
+
+/**
+ * Write @a report to @a output as human-readable text in the given @a format. File descriptor outputs are flushed
+ * before returning.
+ *
+ * @param report The report to format.
+ * @param format The text format to use.
+ * @param output The output to write to.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, PLCRASH_EINVAL if @a format is not supported, PLCRASH_ENOMEM if
+ * memory could not be allocated, or PLCRASH_OUTPUT_ERR if writing to the output's file descriptor failed (see
+ * plcrash_report_output_t::errnum).
+ */
+plcrash_error_t plcrash_report_write_text (const plcrash_report_t *report, plcrash_report_text_format_t format, plcrash_report_output_t *output) {
+    const plcrash_report_thread_t *crashed_thread = NULL;
+    core_image_index_t images;
+    uint32_t max_thread_num = 0;
+    const char *code_type;
+    bool lp64 = true;
+
+    /* The iOS format is the only one currently supported */
+    if (format != PLCRASH_REPORT_TEXT_FORMAT_IOS)
+        return PLCRASH_EINVAL;
+
+    if (!core_image_index_init(&images, report)) {
+        if (output->error == PLCRASH_ESUCCESS)
+            output->error = PLCRASH_ENOMEM;
+        return output->error;
+    }
+
+    /* Header */
+
+    /* Map to Apple-style code type, and mark whether architecture is LP64 (64-bit) */
+    code_type = core_code_type(report, &lp64);
+
+    {
+        const char *hardware_model = "???";
+        if (report->has_machine_info && report->machine_info.model != NULL)
+            hardware_model = report->machine_info.model;
+
+        core_puts(output, "Incident Identifier: [TODO]\n");
+        core_puts(output, "CrashReporter Key:   [TODO]\n");
+        core_puts(output, "Hardware Model:      ");
+        core_puts(output, hardware_model);
+        core_puts(output, "\n");
+    }
+
+    /* Application and process info */
+    {
+        const plcrash_report_process_info_t *info = report->has_process_info ? &report->process_info : NULL;
+
+        /* Process information was not available in earlier crash report versions */
+        core_puts(output, "Process:         ");
+        core_puts(output, info != NULL && info->process_name != NULL ? info->process_name : "???");
+        core_puts(output, " [");
+        if (info != NULL)
+            core_udec(output, info->process_id);
+        else
+            core_puts(output, "???");
+        core_puts(output, "]\n");
+
+        core_puts(output, "Path:            ");
+        core_puts(output, info != NULL && info->process_path != NULL ? info->process_path : "???");
+        core_puts(output, "\n");
+
+        core_puts(output, "Identifier:      ");
+        core_puts(output, report->application_info.identifier);
+        core_puts(output, "\n");
+
+        core_puts(output, "Version:         ");
+        core_puts(output, report->application_info.version);
+        core_puts(output, "\n");
+
+        core_puts(output, "Code Type:       ");
+        core_name_or_unknown(output, code_type, (int) report->system_info.architecture);
+        core_puts(output, "\n");
+
+        core_puts(output, "Parent Process:  ");
+        core_puts(output, info != NULL && info->parent_process_name != NULL ? info->parent_process_name : "???");
+        core_puts(output, " [");
+        if (info != NULL)
+            core_udec(output, info->parent_process_id);
+        else
+            core_puts(output, "???");
+        core_puts(output, "]\n");
+    }
+
+    core_puts(output, "\n");
+
+    /* System info */
+    {
+        const char *os_name;
+        char timestamp[64] = "(null)";
+
+        /* Map to Apple-style OS name */
+        switch (report->system_info.operating_system) {
+            case PLCRASH_REPORT_OS_MAC_OS_X:
+            case PLCRASH_REPORT_OS_IPHONE_SIMULATOR:
+                os_name = "Mac OS X";
+                break;
+            case PLCRASH_REPORT_OS_IPHONE_OS:
+                os_name = "iPhone OS";
+                break;
+            case PLCRASH_REPORT_OS_LINUX:
+                os_name = "Linux";
+                break;
+            default:
+                os_name = NULL;
+                break;
+        }
+
+        /* Matches the NSDate description format */
+        if (report->system_info.timestamp != 0) {
+            time_t t = (time_t) report->system_info.timestamp;
+            struct tm tm;
+
+            if (gmtime_r(&t, &tm) != NULL)
+                strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S +0000", &tm);
+        }
+
+        core_puts(output, "Date/Time:       ");
+        core_puts(output, timestamp);
+        core_puts(output, "\n");
+
+        core_puts(output, "OS Version:      ");
+        core_name_or_unknown(output, os_name, (int) report->system_info.operating_system);
+        core_puts(output, " ");
+        core_puts(output, report->system_info.os_version);
+        core_puts(output, " (");
+        core_puts(output, report->system_info.os_build != NULL ? report->system_info.os_build : "???");
+        core_puts(output, ")\n");
+
+        core_puts(output, "Report Version:  104\n");
+    }
+
+    core_puts(output, "\n");
+
+    /* Exception code */
+    core_puts(output, "Exception Type:  ");
+    core_puts(output, report->signal_info.name);
+    core_puts(output, "\n");
+
+    core_puts(output, "Exception Codes: ");
+    core_puts(output, report->signal_info.code);
+    core_puts(output, " at ");
+    core_hex(output, report->signal_info.address, 1);
+    core_puts(output, "\n");
+
+    for (size_t i = 0; i < report->thread_count; i++) {
+        if (report->threads[i].crashed) {
+            core_puts(output, "Crashed Thread:  ");
+            core_udec(output, report->threads[i].thread_number);
+            core_puts(output, "\n");
+            break;
+        }
+    }
+
+    core_puts(output, "\n");
+
+    /* Uncaught Exception */
+    if (report->has_exception_info) {
+        core_puts(output, "Application Specific Information:\n");
+        core_puts(output, "*** Terminating app due to uncaught exception '");
+        core_puts(output, report->exception_info.name);
+        core_puts(output, "', reason: '");
+        core_puts(output, report->exception_info.reason);
+        core_puts(output, "'\n");
+
+        core_puts(output, "\n");
+    }
+
+    /* Threads */
+    for (size_t i = 0; i < report->thread_count; i++) {
+        const plcrash_report_thread_t *thread = &report->threads[i];
+
+        core_puts(output, "Thread ");
+        core_udec(output, thread->thread_number);
+        if (thread->crashed) {
+            core_puts(output, " Crashed:\n");
+            crashed_thread = thread;
+        } else {
+            core_puts(output, ":\n");
+        }
+
+        for (size_t j = 0; j < thread->frame_count; j++)
+            core_write_frame(output, report, &images, &report->frames[thread->frame_index + j], j);
+        core_puts(output, "\n");
+
+        /* Track the highest thread number */
+        if (thread->thread_number > max_thread_num)
+            max_thread_num = thread->thread_number;
+    }
+
+    /* If an exception stack trace is available, output a pseudo-thread to provide the frame info */
+    if (report->has_exception_info && report->exception_info.frame_count > 0) {
+        const plcrash_report_exception_info_t *exception = &report->exception_info;
+        uint64_t thread_num = (uint64_t) max_thread_num + 1;
+
+        /* Create the pseudo-thread header. We use the named thread format to mark this thread */
+        core_puts(output, "Thread ");
+        core_udec(output, thread_num);
+        core_puts(output, " name:  Exception Backtrace\n");
+        core_puts(output, "Thread ");
+        core_udec(output, thread_num);
+        core_puts(output, ":\n");
+
+        /* Write out the frames */
+        for (size_t j = 0; j < exception->frame_count; j++)
+            core_write_frame(output, report, &images, &report->frames[exception->frame_index + j], j);
+        core_puts(output, "\n");
+    }
+
+    /* Registers */
+    if (crashed_thread != NULL) {
+        int reg_column = 0;
+        bool remap_ip = false;
+
+        core_puts(output, "Thread ");
+        core_udec(output, crashed_thread->thread_number);
+        core_puts(output, " crashed with ");
+        core_name_or_unknown(output, code_type, (int) report->system_info.architecture);
+        core_puts(output, " Thread State:\n");
+
+        /* Remap register names to match Apple's crash reports. Apple uses 'ip' rather than 'r12' on ARM */
+        if (report->has_machine_info && report->machine_info.processor.type_encoding == PLCRASH_REPORT_PROCESSOR_ENCODING_MACH) {
+            uint64_t arch_type = report->machine_info.processor.type & ~(uint64_t) PLCRASH_REPORT_MACH_CPU_ARCH_MASK;
+            remap_ip = (arch_type == PLCRASH_REPORT_MACH_CPU_TYPE_ARM);
+        }
+
+        for (size_t i = 0; i < crashed_thread->register_count; i++) {
+            const plcrash_report_register_t *reg = &report->registers[crashed_thread->register_index + i];
+            const char *reg_name = reg->name;
+
+            if (remap_ip && strcmp(reg_name, "r12") == 0)
+                reg_name = "ip";
+
+            /* Use 32-bit or 64-bit fixed width format for the register values ("%6s: 0x%016" PRIx64 " ") */
+            core_field(output, reg_name, strlen(reg_name), 6, false);
+            core_puts(output, ": ");
+            core_hex(output, reg->value, lp64 ? 16 : 8);
+            core_puts(output, " ");
+
+            reg_column++;
+            if (reg_column == 4) {
+                core_puts(output, "\n");
+                reg_column = 0;
+            }
+        }
+
+        if (reg_column != 0)
+            core_puts(output, "\n");
+
+        core_puts(output, "\n");
+    }
+
+    /* Images */
+    core_write_images(output, report, &images, lp64);
+
+    free(images.keys);
+
+    if (output->type == PLCRASH_REPORT_OUTPUT_FD)
+        return plcrash_report_output_flush(output);
+
+    return output->error;
+}
+
+/**
+ * Format @a report as human-readable text in the given @a format.
+ *
+ * The output is written to @a buf as with snprintf(): at most @a size - 1 bytes are written, followed by a NUL
+ * terminator if @a size is non-zero, and the full length of the formatted text is returned. Passing a NULL
+ * buffer and a size of 0 may be used to determine the required buffer size. Use plcrash_report_write_text() to
+ * stream output to a file descriptor or a growable buffer.
+ *
+ * @param report The report to format.
+ * @param format The text format to use.
+ * @param buf The output buffer. May be NULL if @a size is 0.
+ * @param size The size of @a buf.
+ *
+ * @return Returns the length of the formatted text, excluding the NUL terminator, or 0 if @a format is not
+ * supported or memory could not be allocated.
+ */
+size_t plcrash_report_format_text (const plcrash_report_t *report, plcrash_report_text_format_t format, char *buf, size_t size) {
+    plcrash_report_output_t output;
+
+    plcrash_report_output_init_fixed(&output, buf, size > 0 ? size - 1 : 0);
+    if (plcrash_report_write_text(report, format, &output) != PLCRASH_ESUCCESS) {
+        if (size > 0)
+            buf[0] = '\0';
+        return 0;
+    }
+
+    /* NUL terminate */
+    if (size > 0)
+        buf[output.length] = '\0';
+
+    return output.total;
+}
+
+/**
+ * @internal
+ * Write @a str as a JSON string, or null if @a str is NULL. Runs of characters that need no escaping are written
+ * in a single block.
+ */
+static void core_json_string (plcrash_report_output_t *output, const char *str) {
+    static const char hex[] = "0123456789abcdef";
+    const char *run;
+
+    if (str == NULL) {
+        core_puts(output, "null");
+        return;
+    }
+
+    core_puts(output, "\"");
+    for (run = str; *str != '\0'; str++) {
+        unsigned char c = (unsigned char) *str;
+        char escape[6];
+        size_t escape_length = 2;
+
+        if (c >= 0x20 && c != '"' && c != '\\')
+            continue;
+
+        escape[0] = '\\';
+        switch (c) {
+            case '"':  escape[1] = '"';  break;
+            case '\\': escape[1] = '\\'; break;
+            case '\n': escape[1] = 'n';  break;
+            case '\r': escape[1] = 'r';  break;
+            case '\t': escape[1] = 't';  break;
+            default:
+                escape[1] = 'u';
+                escape[2] = '0';
+                escape[3] = '0';
+                escape[4] = hex[c >> 4];
+                escape[5] = hex[c & 0x0F];
+                escape_length = 6;
+                break;
+        }
+
+        plcrash_report_output_write(output, run, (size_t) (str - run));
+        plcrash_report_output_write(output, escape, escape_length);
+        run = str + 1;
+    }
+    plcrash_report_output_write(output, run, (size_t) (str - run));
+    core_puts(output, "\"");
+}
+
+/**
+ * @internal
+ * Write @a value as a quoted "0x"-prefixed hexadecimal JSON string. Addresses are written as strings, as JSON
+ * consumers commonly can not represent 64-bit integers exactly.
+ */
+static void core_json_hex (plcrash_report_output_t *output, uint64_t value) {
+    core_puts(output, "\"");
+    core_hex(output, value, 1);
+    core_puts(output, "\"");
+}
+
+/**
+ * @internal
+ * Write a JSON boolean.
+ */
+static void core_json_bool (plcrash_report_output_t *output, bool value) {
+    core_puts(output, value ? "true" : "false");
+}
+
+/**
+ * @internal
+ * Write a JSON array of stack frames, with image-relative offsets.
+ */
+static void core_json_frames (plcrash_report_output_t *output, const plcrash_report_t *report, const core_image_index_t *images,
+                              size_t frame_index, size_t frame_count)
+{
+    core_puts(output, "[");
+    for (size_t i = 0; i < frame_count; i++) {
+        const plcrash_report_frame_t *frame = &report->frames[frame_index + i];
+        const plcrash_report_image_t *image = core_image_index_lookup(images, report, frame->pc);
+
+        if (i > 0)
+            core_puts(output, ",");
+
+        core_puts(output, "{\"pc\":");
+        core_json_hex(output, frame->pc);
+        if (image != NULL) {
+            core_puts(output, ",\"image\":");
+            core_udec(output, (uint64_t) (image - report->images));
+            core_puts(output, ",\"offset\":");
+            core_udec(output, frame->pc - image->base_address);
+        } else {
+            core_puts(output, ",\"image\":null,\"offset\":null");
+        }
+
+        /* Symbols are only included in symbolicated reports */
+        if (report->symbols != NULL) {
+            const plcrash_report_symbol_t *symbol = &report->symbols[frame_index + i];
+
+            core_puts(output, ",\"symbol\":");
+            if (symbol->name != NULL) {
+                core_puts(output, "{\"name\":");
+                core_json_string(output, symbol->name);
+                core_puts(output, ",\"offset\":");
+                core_udec(output, symbol->offset);
+                core_puts(output, ",\"file\":");
+                core_json_string(output, symbol->file);
+                core_puts(output, ",\"line\":");
+                if (symbol->file != NULL)
+                    core_udec(output, symbol->line);
+                else
+                    core_puts(output, "null");
+                core_puts(output, "}");
+            } else {
+                core_puts(output, "null");
+            }
+        }
+        core_puts(output, "}");
+    }
+    core_puts(output, "]");
+}
+
+/**
+ * @internal
+ * Write a JSON processor description.
+ */
+static void core_json_processor (plcrash_report_output_t *output, const plcrash_report_processor_t *processor) {
+    core_puts(output, "{\"encoding\":");
+    core_puts(output, processor->type_encoding == PLCRASH_REPORT_PROCESSOR_ENCODING_MACH ? "\"mach\"" : "\"unknown\"");
+    core_puts(output, ",\"type\":");
+    core_udec(output, processor->type);
+    core_puts(output, ",\"subtype\":");
+    core_udec(output, processor->subtype);
+    core_puts(output, "}");
+}
+
+/**
+ * Write @a report to @a output as a single-line JSON object, without a trailing newline. File descriptor outputs
+ * are flushed before returning.
+ *
+ * The schema is stable; fields are only ever added, and the "schema" member is incremented on incompatible
+ * changes. Sections that are not present in the report are written as null. Addresses are written as
+ * hexadecimal strings, and stack frames reference their containing image by index into the "images" array.
+ * Frames of symbolicated reports also include a "symbol" member.
+ *
+ * @param report The report to format.
+ * @param output The output to write to.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, PLCRASH_ENOMEM if memory could not be allocated, or
+ * PLCRASH_OUTPUT_ERR if writing to the output's file descriptor failed (see plcrash_report_output_t::errnum).
+ */
+plcrash_error_t plcrash_report_write_json (const plcrash_report_t *report, plcrash_report_output_t *output) {
+    static const char *os_names[] = { "mac_os_x", "ios", "ios_simulator", "unknown", "linux" };
+    static const char *arch_names[] = { "x86_32", "x86_64", "armv6", "ppc", "ppc64", "armv7", "armv7s" };
+    const plcrash_report_thread_t *crashed_thread = NULL;
+    core_image_index_t images;
+
+    if (!core_image_index_init(&images, report)) {
+        if (output->error == PLCRASH_ESUCCESS)
+            output->error = PLCRASH_ENOMEM;
+        return output->error;
+    }
+
+    /* System info */
+    core_puts(output, "{\"schema\":1,\"system\":{\"os\":");
+    if ((size_t) report->system_info.operating_system < sizeof(os_names) / sizeof(os_names[0]))
+        core_json_string(output, os_names[report->system_info.operating_system]);
+    else
+        core_puts(output, "\"unknown\"");
+    core_puts(output, ",\"os_version\":");
+    core_json_string(output, report->system_info.os_version);
+    core_puts(output, ",\"os_build\":");
+    core_json_string(output, report->system_info.os_build);
+    core_puts(output, ",\"arch\":");
+    if ((size_t) report->system_info.architecture < sizeof(arch_names) / sizeof(arch_names[0]))
+        core_json_string(output, arch_names[report->system_info.architecture]);
+    else
+        core_puts(output, "\"unknown\"");
+    core_puts(output, ",\"timestamp\":");
+    if (report->system_info.timestamp != 0)
+        core_sdec(output, report->system_info.timestamp);
+    else
+        core_puts(output, "null");
+    core_puts(output, "}");
+
+    /* Machine info */
+    core_puts(output, ",\"machine\":");
+    if (report->has_machine_info) {
+        core_puts(output, "{\"model\":");
+        core_json_string(output, report->machine_info.model);
+        core_puts(output, ",\"processor\":");
+        core_json_processor(output, &report->machine_info.processor);
+        core_puts(output, ",\"processor_count\":");
+        core_udec(output, report->machine_info.processor_count);
+        core_puts(output, ",\"logical_processor_count\":");
+        core_udec(output, report->machine_info.logical_processor_count);
+        core_puts(output, "}");
+    } else {
+        core_puts(output, "null");
+    }
+
+    /* Application info */
+    core_puts(output, ",\"application\":{\"identifier\":");
+    core_json_string(output, report->application_info.identifier);
+    core_puts(output, ",\"version\":");
+    core_json_string(output, report->application_info.version);
+    core_puts(output, "}");
+
+    /* Process info */
+    core_puts(output, ",\"process\":");
+    if (report->has_process_info) {
+        const plcrash_report_process_info_t *info = &report->process_info;
+
+        core_puts(output, "{\"name\":");
+        core_json_string(output, info->process_name);
+        core_puts(output, ",\"pid\":");
+        core_udec(output, info->process_id);
+        core_puts(output, ",\"path\":");
+        core_json_string(output, info->process_path);
+        core_puts(output, ",\"parent_name\":");
+        core_json_string(output, info->parent_process_name);
+        core_puts(output, ",\"parent_pid\":");
+        core_udec(output, info->parent_process_id);
+        core_puts(output, ",\"native\":");
+        core_json_bool(output, info->native);
+        core_puts(output, "}");
+    } else {
+        core_puts(output, "null");
+    }
+
+    /* Signal info */
+    core_puts(output, ",\"signal\":{\"name\":");
+    core_json_string(output, report->signal_info.name);
+    core_puts(output, ",\"code\":");
+    core_json_string(output, report->signal_info.code);
+    core_puts(output, ",\"address\":");
+    core_json_hex(output, report->signal_info.address);
+    core_puts(output, "}");
+
+    /* Uncaught exception */
+    core_puts(output, ",\"exception\":");
+    if (report->has_exception_info) {
+        core_puts(output, "{\"name\":");
+        core_json_string(output, report->exception_info.name);
+        core_puts(output, ",\"reason\":");
+        core_json_string(output, report->exception_info.reason);
+        core_puts(output, ",\"frames\":");
+        core_json_frames(output, report, &images, report->exception_info.frame_index, report->exception_info.frame_count);
+        core_puts(output, "}");
+    } else {
+        core_puts(output, "null");
+    }
+
+    /* Threads */
+    core_puts(output, ",\"threads\":[");
+    for (size_t i = 0; i < report->thread_count; i++) {
+        const plcrash_report_thread_t *thread = &report->threads[i];
+
+        if (thread->crashed)
+            crashed_thread = thread;
+
+        if (i > 0)
+            core_puts(output, ",");
+
+        core_puts(output, "{\"number\":");
+        core_udec(output, thread->thread_number);
+        core_puts(output, ",\"crashed\":");
+        core_json_bool(output, thread->crashed);
+        core_puts(output, ",\"frames\":");
+        core_json_frames(output, report, &images, thread->frame_index, thread->frame_count);
+
+        core_puts(output, ",\"registers\":{");
+        for (size_t j = 0; j < thread->register_count; j++) {
+            const plcrash_report_register_t *reg = &report->registers[thread->register_index + j];
+
+            if (j > 0)
+                core_puts(output, ",");
+
+            core_json_string(output, reg->name);
+            core_puts(output, ":");
+            core_json_hex(output, reg->value);
+        }
+        core_puts(output, "}}");
+    }
+    core_puts(output, "]");
+
+    core_puts(output, ",\"crashed_thread\":");
+    if (crashed_thread != NULL)
+        core_udec(output, crashed_thread->thread_number);
+    else
+        core_puts(output, "null");
+
+    /* Images, in report order */
+    core_puts(output, ",\"images\":[");
+    for (size_t i = 0; i < report->image_count; i++) {
+        static const char hex[] = "0123456789abcdef";
+        const plcrash_report_image_t *image = &report->images[i];
+        const char *arch = core_image_arch_name(image);
+
+        if (i > 0)
+            core_puts(output, ",");
+
+        core_puts(output, "{\"base\":");
+        core_json_hex(output, image->base_address);
+        core_puts(output, ",\"size\":");
+        core_udec(output, image->size);
+        core_puts(output, ",\"name\":");
+        core_json_string(output, image->name);
+        core_puts(output, ",\"uuid\":");
+        if (image->uuid != NULL) {
+            core_puts(output, "\"");
+            for (size_t j = 0; j < image->uuid_length; j++) {
+                char digits[2] = { hex[image->uuid[j] >> 4], hex[image->uuid[j] & 0x0F] };
+                plcrash_report_output_write(output, digits, sizeof(digits));
+            }
+            core_puts(output, "\"");
+        } else {
+            core_puts(output, "null");
+        }
+        core_puts(output, ",\"arch\":");
+        core_json_string(output, strcmp(arch, "???") == 0 ? NULL : arch);
+        core_puts(output, ",\"code_type\":");
+        core_json_processor(output, &image->code_type);
+        core_puts(output, "}");
+    }
+    core_puts(output, "]");
+
+    /* Truncation */
+    core_puts(output, ",\"truncation\":");
+    if (report->has_truncation) {
+        core_puts(output, "{\"omitted_threads\":");
+        core_udec(output, report->truncation.omitted_threads);
+        core_puts(output, ",\"omitted_images\":");
+        core_udec(output, report->truncation.omitted_images);
+        core_puts(output, ",\"deadline_exceeded\":");
+        core_json_bool(output, report->truncation.deadline_exceeded);
+        core_puts(output, ",\"byte_budget_exceeded\":");
+        core_json_bool(output, report->truncation.byte_budget_exceeded);
+        core_puts(output, "}");
+    } else {
+        core_puts(output, "null");
+    }
+
+    core_puts(output, "}");
+
+    free(images.keys);
+
+    if (output->type == PLCRASH_REPORT_OUTPUT_FD)
+        return plcrash_report_output_flush(output);
+
+    return output->error;
+}
+
+/**
+ * @} plcrash_report_core
+ */
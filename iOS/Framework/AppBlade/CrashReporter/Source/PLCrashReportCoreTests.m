@@ -0,0 +1,355 @@
+/*
+ * Author: Landon Fuller <landonf@plausiblelabs.com>
+ *
+ * Copyright (c) 2008-2009 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "GTMSenTestCase.h"
+
+#import "PLCrashReport.h"
+#import "PLCrashReportTextFormatter.h"
+#import "PLCrashReportJSONFormatter.h"
+#import "PLCrashLogWriter.h"
+#import "PLCrashFrameWalker.h"
+#import "PLCrashReportCore.h"
+
+#import <fcntl.h>
+
+@interface PLCrashReportCoreTests : SenTestCase {
+@private
+    /* Path to crash log */
+    NSString *_logPath;
+
+    /* Test thread */
+    plframe_test_thead_t _thr_args;
+}
+
+@end
+
+
+@implementation PLCrashReportCoreTests
+
+- (void) setUp {
+    /* Create a temporary log path */
+    _logPath = [[NSTemporaryDirectory() stringByAppendingString: [[NSProcessInfo processInfo] globallyUniqueString]] retain];
+
+    /* Create the test thread */
+    plframe_test_thread_spawn(&_thr_args);
+}
+
+- (void) tearDown {
+    NSError *error;
+
+    /* Delete the file */
+    STAssertTrue([[NSFileManager defaultManager] removeItemAtPath: _logPath error: &error], @"Could not remove log file");
+    [_logPath release];
+
+    /* Stop the test thread */
+    plframe_test_thread_stop(&_thr_args);
+}
+
+/* Write a crash report with stack memory and writer statistics enabled, returning its contents */
+- (NSData *) writeReport {
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_log_writer_write_test_report(pthread_mach_thread_np(_thr_args.thread), [_logPath fileSystemRepresentation], true),
+                   @"Could not write the crash report");
+    return [NSData dataWithContentsOfFile: _logPath];
+}
+
+- (void) testDecode {
+    NSData *data = [self writeReport];
+    NSError *error = nil;
+    plcrash_report_t report;
+    const char *description = NULL;
+
+    PLCrashReport *crashLog = [[[PLCrashReport alloc] initWithData: data error: &error] autorelease];
+    STAssertNotNil(crashLog, @"Could not decode crash log: %@", error);
+
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_report_decode(&report, [data bytes], [data length], &description), @"Decode failed: %s", description);
+
+    /* The object model must mirror the flat report */
+    STAssertEqualStrings(crashLog.systemInfo.operatingSystemVersion, [NSString stringWithUTF8String: report.system_info.os_version], @"OS version differs");
+    STAssertEqualStrings(crashLog.applicationInfo.applicationIdentifier, @"test.id", @"Incorrect app identifier");
+    STAssertEqualStrings(@"test.id", [NSString stringWithUTF8String: report.application_info.identifier], @"Incorrect app identifier");
+    STAssertEqualStrings(@"SIGSEGV", [NSString stringWithUTF8String: report.signal_info.name], @"Incorrect signal name");
+    STAssertTrue(report.has_machine_info, @"Machine info missing");
+    STAssertTrue(report.has_process_info, @"Process info missing");
+    STAssertTrue(report.has_writer_stats, @"Writer stats missing");
+
+    STAssertEquals((NSUInteger) report.thread_count, [crashLog.threads count], @"Thread count differs");
+    STAssertEquals((NSUInteger) report.image_count, [crashLog.images count], @"Image count differs");
+
+    size_t frames = 0;
+    for (size_t i = 0; i < report.thread_count; i++) {
+        const plcrash_report_thread_t *thread = &report.threads[i];
+        PLCrashReportThreadInfo *threadInfo = [crashLog.threads objectAtIndex: i];
+
+        /* Threads are in ascending order, and index within the flat arrays */
+        if (i > 0)
+            STAssertTrue(report.threads[i - 1].thread_number < thread->thread_number, @"Threads are listed out of order");
+        STAssertTrue(thread->frame_index + thread->frame_count <= report.frame_count, @"Frame range out of bounds");
+        STAssertTrue(thread->register_index + thread->register_count <= report.register_count, @"Register range out of bounds");
+        STAssertTrue(thread->stack_memory_index + thread->stack_memory_count <= report.stack_memory_count, @"Stack memory range out of bounds");
+
+        STAssertEquals((NSInteger) thread->thread_number, threadInfo.threadNumber, @"Thread number differs");
+        STAssertEquals((NSUInteger) thread->frame_count, [threadInfo.stackFrames count], @"Frame count differs");
+        for (size_t j = 0; j < thread->frame_count; j++) {
+            PLCrashReportStackFrameInfo *frameInfo = [threadInfo.stackFrames objectAtIndex: j];
+            STAssertEquals(report.frames[thread->frame_index + j].pc, frameInfo.instructionPointer, @"Frame PC differs");
+        }
+
+        frames += thread->frame_count;
+    }
+    STAssertEquals(frames, report.frame_count, @"Frames are not contiguous");
+
+    for (size_t i = 0; i < report.image_count; i++) {
+        PLCrashReportBinaryImageInfo *imageInfo = [crashLog.images objectAtIndex: i];
+        STAssertEquals(report.images[i].base_address, imageInfo.imageBaseAddress, @"Image address differs");
+        STAssertEqualStrings([NSString stringWithUTF8String: report.images[i].name], imageInfo.imageName, @"Image name differs");
+    }
+
+    plcrash_report_free(&report);
+}
+
+- (void) testFormatText {
+    NSData *data = [self writeReport];
+    plcrash_report_t report;
+
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_report_decode(&report, [data bytes], [data length], NULL), @"Decode failed");
+
+    /* Size the output */
+    size_t length = plcrash_report_format_text(&report, PLCRASH_REPORT_TEXT_FORMAT_IOS, NULL, 0);
+    STAssertTrue(length > 0, @"No text was produced");
+
+    /* Full output */
+    char *text = malloc(length + 1);
+    STAssertEquals(length, plcrash_report_format_text(&report, PLCRASH_REPORT_TEXT_FORMAT_IOS, text, length + 1), @"Length differs");
+    STAssertEquals(length, strlen(text), @"Output was not terminated");
+    STAssertTrue(strncmp(text, "Incident Identifier:", strlen("Incident Identifier:")) == 0, @"Unexpected header");
+
+    /* Truncated output is terminated, and reports the full length */
+    char small[32];
+    STAssertEquals(length, plcrash_report_format_text(&report, PLCRASH_REPORT_TEXT_FORMAT_IOS, small, sizeof(small)), @"Length differs");
+    STAssertEquals(sizeof(small) - 1, strlen(small), @"Truncated output was not terminated");
+    STAssertTrue(memcmp(small, text, sizeof(small) - 1) == 0, @"Truncated output differs");
+
+    /* The Objective-C formatter must produce identical text */
+    PLCrashReport *crashLog = [[[PLCrashReport alloc] initWithData: data error: NULL] autorelease];
+    NSString *formatted = [PLCrashReportTextFormatter stringValueForCrashReport: crashLog withTextFormat: PLCrashReportTextFormatiOS];
+    STAssertEqualStrings([NSString stringWithUTF8String: text], formatted, @"Formatted text differs");
+
+    free(text);
+    plcrash_report_free(&report);
+}
+
+- (void) testWriteTextBuffer {
+    NSData *data = [self writeReport];
+    plcrash_report_output_t output;
+    plcrash_report_t report;
+
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_report_decode(&report, [data bytes], [data length], NULL), @"Decode failed");
+
+    size_t length = plcrash_report_format_text(&report, PLCRASH_REPORT_TEXT_FORMAT_IOS, NULL, 0);
+    char *text = malloc(length + 1);
+    plcrash_report_format_text(&report, PLCRASH_REPORT_TEXT_FORMAT_IOS, text, length + 1);
+
+    /* Start small enough to force the buffer to grow */
+    plcrash_report_output_init_buffer(&output, 16);
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_report_write_text(&report, PLCRASH_REPORT_TEXT_FORMAT_IOS, &output), @"Write failed");
+    STAssertEquals(length, output.length, @"Length differs");
+    STAssertEquals(length, output.total, @"Total differs");
+    STAssertTrue(memcmp(output.buffer, text, length) == 0, @"Buffered output differs");
+
+    /* A reset output reuses its buffer */
+    char *buffer = output.buffer;
+    plcrash_report_output_reset(&output);
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_report_write_text(&report, PLCRASH_REPORT_TEXT_FORMAT_IOS, &output), @"Write failed");
+    STAssertEquals(buffer, output.buffer, @"Buffer was reallocated");
+    STAssertEquals(length, output.length, @"Length differs");
+    STAssertTrue(memcmp(output.buffer, text, length) == 0, @"Buffered output differs");
+
+    /* Detached output is owned by the caller */
+    size_t detached_length;
+    char *detached = plcrash_report_output_detach(&output, &detached_length);
+    STAssertNotNULL(detached, @"Detach failed");
+    STAssertEquals(length, detached_length, @"Length differs");
+    free(detached);
+
+    free(text);
+    plcrash_report_free(&report);
+}
+
+/* Unsupported formats are rejected rather than formatted as iOS text */
+- (void) testWriteTextUnsupportedFormat {
+    NSData *data = [self writeReport];
+    plcrash_report_output_t output;
+    plcrash_report_t report;
+    char buf[16];
+
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_report_decode(&report, [data bytes], [data length], NULL), @"Decode failed");
+
+    plcrash_report_output_init_buffer(&output, 16);
+    STAssertEquals(PLCRASH_EINVAL, plcrash_report_write_text(&report, (plcrash_report_text_format_t) 42, &output), @"Unsupported format accepted");
+    STAssertEquals((size_t) 0, output.length, @"Output was written");
+    plcrash_report_output_free(&output);
+
+    STAssertEquals((size_t) 0, plcrash_report_format_text(&report, (plcrash_report_text_format_t) 42, buf, sizeof(buf)), @"Unsupported format accepted");
+    STAssertEquals((char) '\0', buf[0], @"Output was not terminated");
+
+    plcrash_report_free(&report);
+}
+
+- (void) testWriteTextFileDescriptor {
+    NSData *data = [self writeReport];
+    NSString *textPath = [_logPath stringByAppendingPathExtension: @"txt"];
+    plcrash_report_output_t output;
+    plcrash_report_t report;
+    char buffer[64];
+
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_report_decode(&report, [data bytes], [data length], NULL), @"Decode failed");
+
+    size_t length = plcrash_report_format_text(&report, PLCRASH_REPORT_TEXT_FORMAT_IOS, NULL, 0);
+    char *text = malloc(length + 1);
+    plcrash_report_format_text(&report, PLCRASH_REPORT_TEXT_FORMAT_IOS, text, length + 1);
+
+    /* Stream through a buffer much smaller than the report */
+    int fd = open([textPath UTF8String], O_RDWR|O_CREAT|O_EXCL, 0644);
+    STAssertTrue(fd >= 0, @"Could not open output file");
+    plcrash_report_output_init_fd(&output, fd, buffer, sizeof(buffer));
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_report_write_text(&report, PLCRASH_REPORT_TEXT_FORMAT_IOS, &output), @"Write failed");
+    STAssertEquals((size_t) 0, output.length, @"Output was not flushed");
+    STAssertEquals(length, output.total, @"Total differs");
+    close(fd);
+
+    NSData *written = [NSData dataWithContentsOfFile: textPath];
+    STAssertEquals(length, (size_t) [written length], @"Written length differs");
+    STAssertTrue(memcmp([written bytes], text, length) == 0, @"Written output differs");
+
+    /* Write errors are reported with the failing errno */
+    plcrash_report_output_init_fd(&output, fd, buffer, sizeof(buffer));
+    STAssertEquals(PLCRASH_OUTPUT_ERR, plcrash_report_write_text(&report, PLCRASH_REPORT_TEXT_FORMAT_IOS, &output), @"Write to a closed descriptor succeeded");
+    STAssertEquals(EBADF, output.errnum, @"Incorrect errno");
+
+    /* The Objective-C formatter must write identical text */
+    PLCrashReport *crashLog = [[[PLCrashReport alloc] initWithData: data error: NULL] autorelease];
+    PLCrashReportTextFormatter *formatter = [[[PLCrashReportTextFormatter alloc] initWithTextFormat: PLCrashReportTextFormatiOS
+                                                                                     stringEncoding: NSUTF8StringEncoding] autorelease];
+    NSError *error = nil;
+    NSData *formatted = [formatter formatReport: crashLog error: &error];
+    STAssertNotNil(formatted, @"Could not format report: %@", error);
+    STAssertEqualObjects(written, formatted, @"Formatted data differs");
+
+    STAssertTrue([[NSFileManager defaultManager] removeItemAtPath: textPath error: &error], @"Could not remove text file");
+
+    free(text);
+    plcrash_report_free(&report);
+}
+
+- (void) testWriteJSON {
+    NSData *data = [self writeReport];
+    plcrash_report_output_t output;
+    plcrash_report_t report;
+    NSError *error = nil;
+
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_report_decode(&report, [data bytes], [data length], NULL), @"Decode failed");
+
+    plcrash_report_output_init_buffer(&output, 0);
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_report_write_json(&report, &output), @"Write failed");
+    STAssertTrue(memchr(output.buffer, '\n', output.length) == NULL, @"JSON is not a single line");
+
+    NSData *json = [NSData dataWithBytes: output.buffer length: output.length];
+    NSDictionary *dict = [NSJSONSerialization JSONObjectWithData: json options: 0 error: &error];
+    STAssertNotNil(dict, @"Could not parse JSON: %@", error);
+
+    STAssertEqualObjects([dict objectForKey: @"schema"], [NSNumber numberWithInt: 1], @"Incorrect schema version");
+    STAssertEqualStrings([[dict objectForKey: @"application"] objectForKey: @"identifier"], @"test.id", @"Incorrect app identifier");
+    STAssertEqualStrings([[dict objectForKey: @"signal"] objectForKey: @"name"], @"SIGSEGV", @"Incorrect signal name");
+
+    NSArray *threads = [dict objectForKey: @"threads"];
+    NSArray *images = [dict objectForKey: @"images"];
+    STAssertEquals((NSUInteger) report.thread_count, [threads count], @"Thread count differs");
+    STAssertEquals((NSUInteger) report.image_count, [images count], @"Image count differs");
+
+    /* Frames reference their image by index, with an image-relative offset */
+    for (size_t i = 0; i < report.thread_count; i++) {
+        const plcrash_report_thread_t *thread = &report.threads[i];
+        NSArray *frames = [[threads objectAtIndex: i] objectForKey: @"frames"];
+
+        STAssertEquals((NSUInteger) thread->frame_count, [frames count], @"Frame count differs");
+        for (size_t j = 0; j < thread->frame_count; j++) {
+            uint64_t pc = report.frames[thread->frame_index + j].pc;
+            const plcrash_report_image_t *image = plcrash_report_image_for_address(&report, pc);
+            NSDictionary *frame = [frames objectAtIndex: j];
+
+            STAssertEqualStrings([frame objectForKey: @"pc"], ([NSString stringWithFormat: @"0x%llx", (unsigned long long) pc]), @"Frame PC differs");
+            if (image == NULL) {
+                STAssertEqualObjects([frame objectForKey: @"image"], [NSNull null], @"Unexpected image");
+                continue;
+            }
+
+            NSUInteger imageIndex = [[frame objectForKey: @"image"] unsignedIntegerValue];
+            STAssertEquals((NSUInteger) (image - report.images), imageIndex, @"Frame image differs");
+            STAssertEquals(pc - image->base_address, [[frame objectForKey: @"offset"] unsignedLongLongValue], @"Frame offset differs");
+        }
+    }
+
+    /* The Objective-C formatter appends a newline */
+    PLCrashReport *crashLog = [[[PLCrashReport alloc] initWithData: data error: NULL] autorelease];
+    PLCrashReportJSONFormatter *formatter = [[[PLCrashReportJSONFormatter alloc] init] autorelease];
+    NSMutableData *line = [NSMutableData dataWithData: json];
+    [line appendBytes: "\n" length: 1];
+    STAssertEqualObjects(line, [formatter formatReport: crashLog error: NULL], @"Formatted data differs");
+    STAssertEqualObjects(line, [formatter formatReportData: data error: NULL], @"Formatted data differs");
+
+    plcrash_report_output_free(&output);
+    plcrash_report_free(&report);
+}
+
+- (void) testDecodeInvalid {
+    NSMutableData *data = [NSMutableData dataWithData: [self writeReport]];
+    plcrash_report_t report;
+    const char *description;
+
+    /* Truncated header */
+    description = NULL;
+    STAssertEquals(PLCRASH_EINVAL, plcrash_report_decode(&report, [data bytes], sizeof(struct PLCrashReportFileHeader), &description), @"Truncated report was decoded");
+    STAssertNotNULL(description, @"No error description");
+
+    /* Truncated body */
+    STAssertEquals(PLCRASH_EINVAL, plcrash_report_decode(&report, [data bytes], [data length] - 1, NULL), @"Truncated report was decoded");
+
+    /* Unsupported version */
+    ((uint8_t *) [data mutableBytes])[offsetof(struct PLCrashReportFileHeader, version)] = PLCRASH_REPORT_FILE_VERSION + 1;
+    STAssertEquals(PLCRASH_EINVAL, plcrash_report_decode(&report, [data bytes], [data length], NULL), @"Unsupported version was decoded");
+
+    /* Invalid magic */
+    ((uint8_t *) [data mutableBytes])[0] = 'x';
+    STAssertEquals(PLCRASH_EINVAL, plcrash_report_decode(&report, [data bytes], [data length], NULL), @"Invalid magic was decoded");
+
+    /* A failed decode leaves nothing to free */
+    STAssertNULL(report.storage, @"Storage allocated on failure");
+    plcrash_report_free(&report);
+}
+
+@end
@@ -0,0 +1,1595 @@
+/*
+ * Generated by Tools/plcrash-protogen.py from crash_report.proto. DO NOT EDIT.
+ *
+ * Copyright (c) 2008-2011 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "PLCrashReportDecoder.h"
+#include "PLCrashReportVarint.h"
+
+/*
+ * Decoding support. All readers advance *pos past the consumed bytes, and return false if the input is truncated
+ * or malformed.
+ */
+
+static inline bool plcrash_proto_read_varint (const uint8_t **pos, const uint8_t *end, uint64_t *value) {
+    return plcrash_varint_decode(pos, end, value);
+}
+
+static inline bool plcrash_proto_read_fixed32 (const uint8_t **pos, const uint8_t *end, uint32_t *value) {
+    const uint8_t *p = *pos;
+    if (end - p < 4)
+        return false;
+
+    *value = ((uint32_t) p[0]) | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+    *pos = p + 4;
+    return true;
+}
+
+static inline bool plcrash_proto_read_fixed64 (const uint8_t **pos, const uint8_t *end, uint64_t *value) {
+    uint32_t lo, hi;
+    if (!plcrash_proto_read_fixed32(pos, end, &lo) || !plcrash_proto_read_fixed32(pos, end, &hi))
+        return false;
+
+    *value = ((uint64_t) hi << 32) | lo;
+    return true;
+}
+
+/* Read a length prefix, verifying that the prefixed data is available */
+static inline bool plcrash_proto_read_length (const uint8_t **pos, const uint8_t *end, size_t *length) {
+    uint64_t value;
+    if (!plcrash_proto_read_varint(pos, end, &value))
+        return false;
+
+    if (value > (uint64_t) (end - *pos))
+        return false;
+
+    *length = (size_t) value;
+    return true;
+}
+
+/* Skip a field of the given wire type. Groups are not supported. */
+static bool plcrash_proto_skip (const uint8_t **pos, const uint8_t *end, unsigned wire_type) {
+    uint64_t ignored;
+    size_t length;
+
+    switch (wire_type) {
+        case 0:
+            return plcrash_proto_read_varint(pos, end, &ignored);
+        case 1:
+            if (end - *pos < 8)
+                return false;
+            *pos += 8;
+            return true;
+        case 2:
+            if (!plcrash_proto_read_length(pos, end, &length))
+                return false;
+            *pos += length;
+            return true;
+        case 5:
+            if (end - *pos < 4)
+                return false;
+            *pos += 4;
+            return true;
+        default:
+            return false;
+    }
+}
+
+/* Read a length-prefixed string into a newly allocated, NUL-terminated buffer */
+static bool plcrash_proto_read_string (const uint8_t **pos, const uint8_t *end, ProtobufCAllocator *allocator, char **value) {
+    size_t length;
+    char *str;
+
+    if (!plcrash_proto_read_length(pos, end, &length))
+        return false;
+
+    str = allocator->alloc(allocator->allocator_data, length + 1);
+    if (str == NULL)
+        return false;
+
+    memcpy(str, *pos, length);
+    str[length] = '\0';
+    *pos += length;
+
+    *value = str;
+    return true;
+}
+
+/* Read length-prefixed bytes into a newly allocated buffer */
+static bool plcrash_proto_read_bytes (const uint8_t **pos, const uint8_t *end, ProtobufCAllocator *allocator, ProtobufCBinaryData *value) {
+    size_t length;
+    uint8_t *data = NULL;
+
+    if (!plcrash_proto_read_length(pos, end, &length))
+        return false;
+
+    if (length > 0) {
+        data = allocator->alloc(allocator->allocator_data, length);
+        if (data == NULL)
+            return false;
+        memcpy(data, *pos, length);
+        *pos += length;
+    }
+
+    value->len = length;
+    value->data = data;
+    return true;
+}
+
+/* Ensure that a repeated field's array has room for one more element, doubling its capacity as required */
+static bool plcrash_proto_reserve (ProtobufCAllocator *allocator, void **array, size_t count, size_t *capacity, size_t element_size) {
+    void *new_array;
+    size_t new_capacity;
+
+    if (count < *capacity)
+        return true;
+
+    new_capacity = (*capacity == 0) ? 4 : *capacity * 2;
+    new_array = allocator->alloc(allocator->allocator_data, new_capacity * element_size);
+    if (new_array == NULL)
+        return false;
+
+    if (*array != NULL) {
+        memcpy(new_array, *array, count * element_size);
+        allocator->free(allocator->allocator_data, *array);
+    }
+
+    *array = new_array;
+    *capacity = new_capacity;
+    return true;
+}
+
+static inline int32_t plcrash_proto_unzigzag32 (uint32_t v) {
+    return (v & 1) ? -(int32_t) (v >> 1) - 1 : (int32_t) (v >> 1);
+}
+
+static inline int64_t plcrash_proto_unzigzag64 (uint64_t v) {
+    return (v & 1) ? -(int64_t) (v >> 1) - 1 : (int64_t) (v >> 1);
+}
+
+static Plcrash__CrashReport *plcrash_proto_crash_report_decode (ProtobufCAllocator *allocator, const uint8_t *pos, size_t length);
+static Plcrash__CrashReport__Processor *plcrash_proto_processor_decode (ProtobufCAllocator *allocator, const uint8_t *pos, size_t length);
+static Plcrash__CrashReport__SystemInfo *plcrash_proto_system_info_decode (ProtobufCAllocator *allocator, const uint8_t *pos, size_t length);
+static Plcrash__CrashReport__ApplicationInfo *plcrash_proto_application_info_decode (ProtobufCAllocator *allocator, const uint8_t *pos, size_t length);
+static Plcrash__CrashReport__Thread *plcrash_proto_thread_decode (ProtobufCAllocator *allocator, const uint8_t *pos, size_t length);
+static Plcrash__CrashReport__Thread__StackFrame *plcrash_proto_thread_stack_frame_decode (ProtobufCAllocator *allocator, const uint8_t *pos, size_t length);
+static Plcrash__CrashReport__Thread__RegisterValue *plcrash_proto_thread_register_value_decode (ProtobufCAllocator *allocator, const uint8_t *pos, size_t length);
+static Plcrash__CrashReport__Thread__StackMemory *plcrash_proto_thread_stack_memory_decode (ProtobufCAllocator *allocator, const uint8_t *pos, size_t length);
+static Plcrash__CrashReport__BinaryImage *plcrash_proto_binary_image_decode (ProtobufCAllocator *allocator, const uint8_t *pos, size_t length);
+static Plcrash__CrashReport__Exception *plcrash_proto_exception_decode (ProtobufCAllocator *allocator, const uint8_t *pos, size_t length);
+static Plcrash__CrashReport__Signal *plcrash_proto_signal_decode (ProtobufCAllocator *allocator, const uint8_t *pos, size_t length);
+static Plcrash__CrashReport__ProcessInfo *plcrash_proto_process_info_decode (ProtobufCAllocator *allocator, const uint8_t *pos, size_t length);
+static Plcrash__CrashReport__MachineInfo *plcrash_proto_machine_info_decode (ProtobufCAllocator *allocator, const uint8_t *pos, size_t length);
+static Plcrash__CrashReport__Truncation *plcrash_proto_truncation_decode (ProtobufCAllocator *allocator, const uint8_t *pos, size_t length);
+static Plcrash__CrashReport__WriterStats *plcrash_proto_writer_stats_decode (ProtobufCAllocator *allocator, const uint8_t *pos, size_t length);
+static Plcrash__CrashReport__WriterStats__ThreadStats *plcrash_proto_writer_stats_thread_stats_decode (ProtobufCAllocator *allocator, const uint8_t *pos, size_t length);
+
+/* Decode CrashReport */
+static Plcrash__CrashReport *plcrash_proto_crash_report_decode (ProtobufCAllocator *allocator, const uint8_t *pos, size_t length) {
+    const uint8_t *end = pos + length;
+    Plcrash__CrashReport *msg;
+    size_t threads_capacity = 0;
+    size_t binary_images_capacity = 0;
+
+    msg = allocator->alloc(allocator->allocator_data, sizeof(*msg));
+    if (msg == NULL)
+        return NULL;
+    memset(msg, 0, sizeof(*msg));
+    msg->base.descriptor = &plcrash__crash_report__descriptor;
+
+    while (pos < end) {
+        uint64_t tag;
+        if (!plcrash_proto_read_varint(&pos, end, &tag))
+            goto error;
+
+        switch (tag) {
+            case (1 << 3) | 2: { /* system_info */
+                size_t sublen;
+                Plcrash__CrashReport__SystemInfo *sub;
+                if (!plcrash_proto_read_length(&pos, end, &sublen))
+                    goto error;
+                sub = plcrash_proto_system_info_decode(allocator, pos, sublen);
+                if (sub == NULL)
+                    goto error;
+                pos += sublen;
+                if (msg->system_info != NULL)
+                    protobuf_c_message_free_unpacked(&msg->system_info->base, allocator);
+                msg->system_info = sub;
+                break;
+            }
+
+            case (2 << 3) | 2: { /* application_info */
+                size_t sublen;
+                Plcrash__CrashReport__ApplicationInfo *sub;
+                if (!plcrash_proto_read_length(&pos, end, &sublen))
+                    goto error;
+                sub = plcrash_proto_application_info_decode(allocator, pos, sublen);
+                if (sub == NULL)
+                    goto error;
+                pos += sublen;
+                if (msg->application_info != NULL)
+                    protobuf_c_message_free_unpacked(&msg->application_info->base, allocator);
+                msg->application_info = sub;
+                break;
+            }
+
+            case (3 << 3) | 2: { /* threads */
+                size_t sublen;
+                Plcrash__CrashReport__Thread *sub;
+                if (!plcrash_proto_reserve(allocator, (void **) &msg->threads, msg->n_threads, &threads_capacity, sizeof(*msg->threads)))
+                    goto error;
+                if (!plcrash_proto_read_length(&pos, end, &sublen))
+                    goto error;
+                sub = plcrash_proto_thread_decode(allocator, pos, sublen);
+                if (sub == NULL)
+                    goto error;
+                pos += sublen;
+                msg->threads[msg->n_threads++] = sub;
+                break;
+            }
+
+            case (4 << 3) | 2: { /* binary_images */
+                size_t sublen;
+                Plcrash__CrashReport__BinaryImage *sub;
+                if (!plcrash_proto_reserve(allocator, (void **) &msg->binary_images, msg->n_binary_images, &binary_images_capacity, sizeof(*msg->binary_images)))
+                    goto error;
+                if (!plcrash_proto_read_length(&pos, end, &sublen))
+                    goto error;
+                sub = plcrash_proto_binary_image_decode(allocator, pos, sublen);
+                if (sub == NULL)
+                    goto error;
+                pos += sublen;
+                msg->binary_images[msg->n_binary_images++] = sub;
+                break;
+            }
+
+            case (5 << 3) | 2: { /* exception */
+                size_t sublen;
+                Plcrash__CrashReport__Exception *sub;
+                if (!plcrash_proto_read_length(&pos, end, &sublen))
+                    goto error;
+                sub = plcrash_proto_exception_decode(allocator, pos, sublen);
+                if (sub == NULL)
+                    goto error;
+                pos += sublen;
+                if (msg->exception != NULL)
+                    protobuf_c_message_free_unpacked(&msg->exception->base, allocator);
+                msg->exception = sub;
+                break;
+            }
+
+            case (6 << 3) | 2: { /* signal */
+                size_t sublen;
+                Plcrash__CrashReport__Signal *sub;
+                if (!plcrash_proto_read_length(&pos, end, &sublen))
+                    goto error;
+                sub = plcrash_proto_signal_decode(allocator, pos, sublen);
+                if (sub == NULL)
+                    goto error;
+                pos += sublen;
+                if (msg->signal != NULL)
+                    protobuf_c_message_free_unpacked(&msg->signal->base, allocator);
+                msg->signal = sub;
+                break;
+            }
+
+            case (7 << 3) | 2: { /* process_info */
+                size_t sublen;
+                Plcrash__CrashReport__ProcessInfo *sub;
+                if (!plcrash_proto_read_length(&pos, end, &sublen))
+                    goto error;
+                sub = plcrash_proto_process_info_decode(allocator, pos, sublen);
+                if (sub == NULL)
+                    goto error;
+                pos += sublen;
+                if (msg->process_info != NULL)
+                    protobuf_c_message_free_unpacked(&msg->process_info->base, allocator);
+                msg->process_info = sub;
+                break;
+            }
+
+            case (8 << 3) | 2: { /* machine_info */
+                size_t sublen;
+                Plcrash__CrashReport__MachineInfo *sub;
+                if (!plcrash_proto_read_length(&pos, end, &sublen))
+                    goto error;
+                sub = plcrash_proto_machine_info_decode(allocator, pos, sublen);
+                if (sub == NULL)
+                    goto error;
+                pos += sublen;
+                if (msg->machine_info != NULL)
+                    protobuf_c_message_free_unpacked(&msg->machine_info->base, allocator);
+                msg->machine_info = sub;
+                break;
+            }
+
+            case (9 << 3) | 2: { /* truncation */
+                size_t sublen;
+                Plcrash__CrashReport__Truncation *sub;
+                if (!plcrash_proto_read_length(&pos, end, &sublen))
+                    goto error;
+                sub = plcrash_proto_truncation_decode(allocator, pos, sublen);
+                if (sub == NULL)
+                    goto error;
+                pos += sublen;
+                if (msg->truncation != NULL)
+                    protobuf_c_message_free_unpacked(&msg->truncation->base, allocator);
+                msg->truncation = sub;
+                break;
+            }
+
+            case (10 << 3) | 2: { /* writer_stats */
+                size_t sublen;
+                Plcrash__CrashReport__WriterStats *sub;
+                if (!plcrash_proto_read_length(&pos, end, &sublen))
+                    goto error;
+                sub = plcrash_proto_writer_stats_decode(allocator, pos, sublen);
+                if (sub == NULL)
+                    goto error;
+                pos += sublen;
+                if (msg->writer_stats != NULL)
+                    protobuf_c_message_free_unpacked(&msg->writer_stats->base, allocator);
+                msg->writer_stats = sub;
+                break;
+            }
+
+            default:
+                /* Known fields with an unexpected wire type are rejected, as by protobuf_c_message_unpack() */
+                switch (tag >> 3) {
+                    case 1:
+                    case 2:
+                    case 3:
+                    case 4:
+                    case 5:
+                    case 6:
+                    case 7:
+                    case 8:
+                    case 9:
+                    case 10:
+                        goto error;
+                }
+
+                if (!plcrash_proto_skip(&pos, end, (unsigned) (tag & 7)))
+                    goto error;
+                break;
+        }
+    }
+
+    return msg;
+
+error:
+    protobuf_c_message_free_unpacked(&msg->base, allocator);
+    return NULL;
+}
+
+/* Decode CrashReport.Processor */
+static Plcrash__CrashReport__Processor *plcrash_proto_processor_decode (ProtobufCAllocator *allocator, const uint8_t *pos, size_t length) {
+    const uint8_t *end = pos + length;
+    Plcrash__CrashReport__Processor *msg;
+
+    msg = allocator->alloc(allocator->allocator_data, sizeof(*msg));
+    if (msg == NULL)
+        return NULL;
+    memset(msg, 0, sizeof(*msg));
+    msg->base.descriptor = &plcrash__crash_report__processor__descriptor;
+    msg->encoding = 0;
+
+    while (pos < end) {
+        uint64_t tag;
+        if (!plcrash_proto_read_varint(&pos, end, &tag))
+            goto error;
+
+        switch (tag) {
+            case (1 << 3) | 0: { /* encoding */
+                uint64_t v;
+                if (!plcrash_proto_read_varint(&pos, end, &v))
+                    goto error;
+                msg->encoding = (int) v;
+                msg->has_encoding = 1;
+                break;
+            }
+
+            case (2 << 3) | 0: { /* type */
+                uint64_t v;
+                if (!plcrash_proto_read_varint(&pos, end, &v))
+                    goto error;
+                msg->type = v;
+                break;
+            }
+
+            case (3 << 3) | 0: { /* subtype */
+                uint64_t v;
+                if (!plcrash_proto_read_varint(&pos, end, &v))
+                    goto error;
+                msg->subtype = v;
+                break;
+            }
+
+            default:
+                /* Known fields with an unexpected wire type are rejected, as by protobuf_c_message_unpack() */
+                switch (tag >> 3) {
+                    case 1:
+                    case 2:
+                    case 3:
+                        goto error;
+                }
+
+                if (!plcrash_proto_skip(&pos, end, (unsigned) (tag & 7)))
+                    goto error;
+                break;
+        }
+    }
+
+    return msg;
+
+error:
+    protobuf_c_message_free_unpacked(&msg->base, allocator);
+    return NULL;
+}
+
+/* Decode CrashReport.SystemInfo */
+static Plcrash__CrashReport__SystemInfo *plcrash_proto_system_info_decode (ProtobufCAllocator *allocator, const uint8_t *pos, size_t length) {
+    const uint8_t *end = pos + length;
+    Plcrash__CrashReport__SystemInfo *msg;
+
+    msg = allocator->alloc(allocator->allocator_data, sizeof(*msg));
+    if (msg == NULL)
+        return NULL;
+    memset(msg, 0, sizeof(*msg));
+    msg->base.descriptor = &plcrash__crash_report__system_info__descriptor;
+    msg->operating_system = 3;
+    msg->architecture = 7;
+
+    while (pos < end) {
+        uint64_t tag;
+        if (!plcrash_proto_read_varint(&pos, end, &tag))
+            goto error;
+
+        switch (tag) {
+            case (1 << 3) | 0: { /* operating_system */
+                uint64_t v;
+                if (!plcrash_proto_read_varint(&pos, end, &v))
+                    goto error;
+                msg->operating_system = (int) v;
+                msg->has_operating_system = 1;
+                break;
+            }
+
+            case (2 << 3) | 2: { /* os_version */
+                char *v;
+                if (!plcrash_proto_read_string(&pos, end, allocator, &v))
+                    goto error;
+                if (msg->os_version != NULL)
+                    allocator->free(allocator->allocator_data, msg->os_version);
+                msg->os_version = v;
+                break;
+            }
+
+            case (3 << 3) | 0: { /* architecture */
+                uint64_t v;
+                if (!plcrash_proto_read_varint(&pos, end, &v))
+                    goto error;
+                msg->architecture = (int) v;
+                break;
+            }
+
+            case (4 << 3) | 0: { /* timestamp */
+                uint64_t v;
+                if (!plcrash_proto_read_varint(&pos, end, &v))
+                    goto error;
+                msg->timestamp = (int64_t) v;
+                break;
+            }
+
+            case (5 << 3) | 2: { /* os_build */
+                char *v;
+                if (!plcrash_proto_read_string(&pos, end, allocator, &v))
+                    goto error;
+                if (msg->os_build != NULL)
+                    allocator->free(allocator->allocator_data, msg->os_build);
+                msg->os_build = v;
+                break;
+            }
+
+            default:
+                /* Known fields with an unexpected wire type are rejected, as by protobuf_c_message_unpack() */
+                switch (tag >> 3) {
+                    case 1:
+                    case 2:
+                    case 3:
+                    case 4:
+                    case 5:
+                        goto error;
+                }
+
+                if (!plcrash_proto_skip(&pos, end, (unsigned) (tag & 7)))
+                    goto error;
+                break;
+        }
+    }
+
+    return msg;
+
+error:
+    protobuf_c_message_free_unpacked(&msg->base, allocator);
+    return NULL;
+}
+
+/* Decode CrashReport.ApplicationInfo */
+static Plcrash__CrashReport__ApplicationInfo *plcrash_proto_application_info_decode (ProtobufCAllocator *allocator, const uint8_t *pos, size_t length) {
+    const uint8_t *end = pos + length;
+    Plcrash__CrashReport__ApplicationInfo *msg;
+
+    msg = allocator->alloc(allocator->allocator_data, sizeof(*msg));
+    if (msg == NULL)
+        return NULL;
+    memset(msg, 0, sizeof(*msg));
+    msg->base.descriptor = &plcrash__crash_report__application_info__descriptor;
+
+    while (pos < end) {
+        uint64_t tag;
+        if (!plcrash_proto_read_varint(&pos, end, &tag))
+            goto error;
+
+        switch (tag) {
+            case (1 << 3) | 2: { /* identifier */
+                char *v;
+                if (!plcrash_proto_read_string(&pos, end, allocator, &v))
+                    goto error;
+                if (msg->identifier != NULL)
+                    allocator->free(allocator->allocator_data, msg->identifier);
+                msg->identifier = v;
+                break;
+            }
+
+            case (2 << 3) | 2: { /* version */
+                char *v;
+                if (!plcrash_proto_read_string(&pos, end, allocator, &v))
+                    goto error;
+                if (msg->version != NULL)
+                    allocator->free(allocator->allocator_data, msg->version);
+                msg->version = v;
+                break;
+            }
+
+            default:
+                /* Known fields with an unexpected wire type are rejected, as by protobuf_c_message_unpack() */
+                switch (tag >> 3) {
+                    case 1:
+                    case 2:
+                        goto error;
+                }
+
+                if (!plcrash_proto_skip(&pos, end, (unsigned) (tag & 7)))
+                    goto error;
+                break;
+        }
+    }
+
+    return msg;
+
+error:
+    protobuf_c_message_free_unpacked(&msg->base, allocator);
+    return NULL;
+}
+
+/* Decode CrashReport.Thread */
+static Plcrash__CrashReport__Thread *plcrash_proto_thread_decode (ProtobufCAllocator *allocator, const uint8_t *pos, size_t length) {
+    const uint8_t *end = pos + length;
+    Plcrash__CrashReport__Thread *msg;
+    size_t frames_capacity = 0;
+    size_t registers_capacity = 0;
+    size_t stack_memory_capacity = 0;
+
+    msg = allocator->alloc(allocator->allocator_data, sizeof(*msg));
+    if (msg == NULL)
+        return NULL;
+    memset(msg, 0, sizeof(*msg));
+    msg->base.descriptor = &plcrash__crash_report__thread__descriptor;
+
+    while (pos < end) {
+        uint64_t tag;
+        if (!plcrash_proto_read_varint(&pos, end, &tag))
+            goto error;
+
+        switch (tag) {
+            case (1 << 3) | 0: { /* thread_number */
+                uint64_t v;
+                if (!plcrash_proto_read_varint(&pos, end, &v))
+                    goto error;
+                msg->thread_number = (uint32_t) v;
+                break;
+            }
+
+            case (2 << 3) | 2: { /* frames */
+                size_t sublen;
+                Plcrash__CrashReport__Thread__StackFrame *sub;
+                if (!plcrash_proto_reserve(allocator, (void **) &msg->frames, msg->n_frames, &frames_capacity, sizeof(*msg->frames)))
+                    goto error;
+                if (!plcrash_proto_read_length(&pos, end, &sublen))
+                    goto error;
+                sub = plcrash_proto_thread_stack_frame_decode(allocator, pos, sublen);
+                if (sub == NULL)
+                    goto error;
+                pos += sublen;
+                msg->frames[msg->n_frames++] = sub;
+                break;
+            }
+
+            case (3 << 3) | 0: { /* crashed */
+                uint64_t v;
+                if (!plcrash_proto_read_varint(&pos, end, &v))
+                    goto error;
+                msg->crashed = v != 0;
+                break;
+            }
+
+            case (4 << 3) | 2: { /* registers */
+                size_t sublen;
+                Plcrash__CrashReport__Thread__RegisterValue *sub;
+                if (!plcrash_proto_reserve(allocator, (void **) &msg->registers, msg->n_registers, &registers_capacity, sizeof(*msg->registers)))
+                    goto error;
+                if (!plcrash_proto_read_length(&pos, end, &sublen))
+                    goto error;
+                sub = plcrash_proto_thread_register_value_decode(allocator, pos, sublen);
+                if (sub == NULL)
+                    goto error;
+                pos += sublen;
+                msg->registers[msg->n_registers++] = sub;
+                break;
+            }
+
+            case (5 << 3) | 2: { /* stack_memory */
+                size_t sublen;
+                Plcrash__CrashReport__Thread__StackMemory *sub;
+                if (!plcrash_proto_reserve(allocator, (void **) &msg->stack_memory, msg->n_stack_memory, &stack_memory_capacity, sizeof(*msg->stack_memory)))
+                    goto error;
+                if (!plcrash_proto_read_length(&pos, end, &sublen))
+                    goto error;
+                sub = plcrash_proto_thread_stack_memory_decode(allocator, pos, sublen);
+                if (sub == NULL)
+                    goto error;
+                pos += sublen;
+                msg->stack_memory[msg->n_stack_memory++] = sub;
+                break;
+            }
+
+            default:
+                /* Known fields with an unexpected wire type are rejected, as by protobuf_c_message_unpack() */
+                switch (tag >> 3) {
+                    case 1:
+                    case 2:
+                    case 3:
+                    case 4:
+                    case 5:
+                        goto error;
+                }
+
+                if (!plcrash_proto_skip(&pos, end, (unsigned) (tag & 7)))
+                    goto error;
+                break;
+        }
+    }
+
+    return msg;
+
+error:
+    protobuf_c_message_free_unpacked(&msg->base, allocator);
+    return NULL;
+}
+
+/* Decode CrashReport.Thread.StackFrame */
+static Plcrash__CrashReport__Thread__StackFrame *plcrash_proto_thread_stack_frame_decode (ProtobufCAllocator *allocator, const uint8_t *pos, size_t length) {
+    const uint8_t *end = pos + length;
+    Plcrash__CrashReport__Thread__StackFrame *msg;
+
+    msg = allocator->alloc(allocator->allocator_data, sizeof(*msg));
+    if (msg == NULL)
+        return NULL;
+    memset(msg, 0, sizeof(*msg));
+    msg->base.descriptor = &plcrash__crash_report__thread__stack_frame__descriptor;
+
+    while (pos < end) {
+        uint64_t tag;
+        if (!plcrash_proto_read_varint(&pos, end, &tag))
+            goto error;
+
+        switch (tag) {
+            case (3 << 3) | 0: { /* pc */
+                uint64_t v;
+                if (!plcrash_proto_read_varint(&pos, end, &v))
+                    goto error;
+                msg->pc = v;
+                break;
+            }
+
+            default:
+                /* Known fields with an unexpected wire type are rejected, as by protobuf_c_message_unpack() */
+                switch (tag >> 3) {
+                    case 3:
+                        goto error;
+                }
+
+                if (!plcrash_proto_skip(&pos, end, (unsigned) (tag & 7)))
+                    goto error;
+                break;
+        }
+    }
+
+    return msg;
+
+error:
+    protobuf_c_message_free_unpacked(&msg->base, allocator);
+    return NULL;
+}
+
+/* Decode CrashReport.Thread.RegisterValue */
+static Plcrash__CrashReport__Thread__RegisterValue *plcrash_proto_thread_register_value_decode (ProtobufCAllocator *allocator, const uint8_t *pos, size_t length) {
+    const uint8_t *end = pos + length;
+    Plcrash__CrashReport__Thread__RegisterValue *msg;
+
+    msg = allocator->alloc(allocator->allocator_data, sizeof(*msg));
+    if (msg == NULL)
+        return NULL;
+    memset(msg, 0, sizeof(*msg));
+    msg->base.descriptor = &plcrash__crash_report__thread__register_value__descriptor;
+
+    while (pos < end) {
+        uint64_t tag;
+        if (!plcrash_proto_read_varint(&pos, end, &tag))
+            goto error;
+
+        switch (tag) {
+            case (1 << 3) | 2: { /* name */
+                char *v;
+                if (!plcrash_proto_read_string(&pos, end, allocator, &v))
+                    goto error;
+                if (msg->name != NULL)
+                    allocator->free(allocator->allocator_data, msg->name);
+                msg->name = v;
+                break;
+            }
+
+            case (2 << 3) | 0: { /* value */
+                uint64_t v;
+                if (!plcrash_proto_read_varint(&pos, end, &v))
+                    goto error;
+                msg->value = v;
+                break;
+            }
+
+            default:
+                /* Known fields with an unexpected wire type are rejected, as by protobuf_c_message_unpack() */
+                switch (tag >> 3) {
+                    case 1:
+                    case 2:
+                        goto error;
+                }
+
+                if (!plcrash_proto_skip(&pos, end, (unsigned) (tag & 7)))
+                    goto error;
+                break;
+        }
+    }
+
+    return msg;
+
+error:
+    protobuf_c_message_free_unpacked(&msg->base, allocator);
+    return NULL;
+}
+
+/* Decode CrashReport.Thread.StackMemory */
+static Plcrash__CrashReport__Thread__StackMemory *plcrash_proto_thread_stack_memory_decode (ProtobufCAllocator *allocator, const uint8_t *pos, size_t length) {
+    const uint8_t *end = pos + length;
+    Plcrash__CrashReport__Thread__StackMemory *msg;
+
+    msg = allocator->alloc(allocator->allocator_data, sizeof(*msg));
+    if (msg == NULL)
+        return NULL;
+    memset(msg, 0, sizeof(*msg));
+    msg->base.descriptor = &plcrash__crash_report__thread__stack_memory__descriptor;
+
+    while (pos < end) {
+        uint64_t tag;
+        if (!plcrash_proto_read_varint(&pos, end, &tag))
+            goto error;
+
+        switch (tag) {
+            case (1 << 3) | 0: { /* base_address */
+                uint64_t v;
+                if (!plcrash_proto_read_varint(&pos, end, &v))
+                    goto error;
+                msg->base_address = v;
+                break;
+            }
+
+            case (2 << 3) | 2: { /* contents */
+                ProtobufCBinaryData v;
+                if (!plcrash_proto_read_bytes(&pos, end, allocator, &v))
+                    goto error;
+                if (msg->contents.data != NULL)
+                    allocator->free(allocator->allocator_data, msg->contents.data);
+                msg->contents = v;
+                break;
+            }
+
+            default:
+                /* Known fields with an unexpected wire type are rejected, as by protobuf_c_message_unpack() */
+                switch (tag >> 3) {
+                    case 1:
+                    case 2:
+                        goto error;
+                }
+
+                if (!plcrash_proto_skip(&pos, end, (unsigned) (tag & 7)))
+                    goto error;
+                break;
+        }
+    }
+
+    return msg;
+
+error:
+    protobuf_c_message_free_unpacked(&msg->base, allocator);
+    return NULL;
+}
+
+/* Decode CrashReport.BinaryImage */
+static Plcrash__CrashReport__BinaryImage *plcrash_proto_binary_image_decode (ProtobufCAllocator *allocator, const uint8_t *pos, size_t length) {
+    const uint8_t *end = pos + length;
+    Plcrash__CrashReport__BinaryImage *msg;
+
+    msg = allocator->alloc(allocator->allocator_data, sizeof(*msg));
+    if (msg == NULL)
+        return NULL;
+    memset(msg, 0, sizeof(*msg));
+    msg->base.descriptor = &plcrash__crash_report__binary_image__descriptor;
+
+    while (pos < end) {
+        uint64_t tag;
+        if (!plcrash_proto_read_varint(&pos, end, &tag))
+            goto error;
+
+        switch (tag) {
+            case (1 << 3) | 0: { /* base_address */
+                uint64_t v;
+                if (!plcrash_proto_read_varint(&pos, end, &v))
+                    goto error;
+                msg->base_address = v;
+                break;
+            }
+
+            case (2 << 3) | 0: { /* size */
+                uint64_t v;
+                if (!plcrash_proto_read_varint(&pos, end, &v))
+                    goto error;
+                msg->size = v;
+                break;
+            }
+
+            case (3 << 3) | 2: { /* name */
+                char *v;
+                if (!plcrash_proto_read_string(&pos, end, allocator, &v))
+                    goto error;
+                if (msg->name != NULL)
+                    allocator->free(allocator->allocator_data, msg->name);
+                msg->name = v;
+                break;
+            }
+
+            case (4 << 3) | 2: { /* uuid */
+                ProtobufCBinaryData v;
+                if (!plcrash_proto_read_bytes(&pos, end, allocator, &v))
+                    goto error;
+                if (msg->uuid.data != NULL)
+                    allocator->free(allocator->allocator_data, msg->uuid.data);
+                msg->uuid = v;
+                msg->has_uuid = 1;
+                break;
+            }
+
+            case (5 << 3) | 2: { /* code_type */
+                size_t sublen;
+                Plcrash__CrashReport__Processor *sub;
+                if (!plcrash_proto_read_length(&pos, end, &sublen))
+                    goto error;
+                sub = plcrash_proto_processor_decode(allocator, pos, sublen);
+                if (sub == NULL)
+                    goto error;
+                pos += sublen;
+                if (msg->code_type != NULL)
+                    protobuf_c_message_free_unpacked(&msg->code_type->base, allocator);
+                msg->code_type = sub;
+                break;
+            }
+
+            default:
+                /* Known fields with an unexpected wire type are rejected, as by protobuf_c_message_unpack() */
+                switch (tag >> 3) {
+                    case 1:
+                    case 2:
+                    case 3:
+                    case 4:
+                    case 5:
+                        goto error;
+                }
+
+                if (!plcrash_proto_skip(&pos, end, (unsigned) (tag & 7)))
+                    goto error;
+                break;
+        }
+    }
+
+    return msg;
+
+error:
+    protobuf_c_message_free_unpacked(&msg->base, allocator);
+    return NULL;
+}
+
+/* Decode CrashReport.Exception */
+static Plcrash__CrashReport__Exception *plcrash_proto_exception_decode (ProtobufCAllocator *allocator, const uint8_t *pos, size_t length) {
+    const uint8_t *end = pos + length;
+    Plcrash__CrashReport__Exception *msg;
+    size_t frames_capacity = 0;
+
+    msg = allocator->alloc(allocator->allocator_data, sizeof(*msg));
+    if (msg == NULL)
+        return NULL;
+    memset(msg, 0, sizeof(*msg));
+    msg->base.descriptor = &plcrash__crash_report__exception__descriptor;
+
+    while (pos < end) {
+        uint64_t tag;
+        if (!plcrash_proto_read_varint(&pos, end, &tag))
+            goto error;
+
+        switch (tag) {
+            case (1 << 3) | 2: { /* name */
+                char *v;
+                if (!plcrash_proto_read_string(&pos, end, allocator, &v))
+                    goto error;
+                if (msg->name != NULL)
+                    allocator->free(allocator->allocator_data, msg->name);
+                msg->name = v;
+                break;
+            }
+
+            case (2 << 3) | 2: { /* reason */
+                char *v;
+                if (!plcrash_proto_read_string(&pos, end, allocator, &v))
+                    goto error;
+                if (msg->reason != NULL)
+                    allocator->free(allocator->allocator_data, msg->reason);
+                msg->reason = v;
+                break;
+            }
+
+            case (3 << 3) | 2: { /* frames */
+                size_t sublen;
+                Plcrash__CrashReport__Thread__StackFrame *sub;
+                if (!plcrash_proto_reserve(allocator, (void **) &msg->frames, msg->n_frames, &frames_capacity, sizeof(*msg->frames)))
+                    goto error;
+                if (!plcrash_proto_read_length(&pos, end, &sublen))
+                    goto error;
+                sub = plcrash_proto_thread_stack_frame_decode(allocator, pos, sublen);
+                if (sub == NULL)
+                    goto error;
+                pos += sublen;
+                msg->frames[msg->n_frames++] = sub;
+                break;
+            }
+
+            default:
+                /* Known fields with an unexpected wire type are rejected, as by protobuf_c_message_unpack() */
+                switch (tag >> 3) {
+                    case 1:
+                    case 2:
+                    case 3:
+                        goto error;
+                }
+
+                if (!plcrash_proto_skip(&pos, end, (unsigned) (tag & 7)))
+                    goto error;
+                break;
+        }
+    }
+
+    return msg;
+
+error:
+    protobuf_c_message_free_unpacked(&msg->base, allocator);
+    return NULL;
+}
+
+/* Decode CrashReport.Signal */
+static Plcrash__CrashReport__Signal *plcrash_proto_signal_decode (ProtobufCAllocator *allocator, const uint8_t *pos, size_t length) {
+    const uint8_t *end = pos + length;
+    Plcrash__CrashReport__Signal *msg;
+
+    msg = allocator->alloc(allocator->allocator_data, sizeof(*msg));
+    if (msg == NULL)
+        return NULL;
+    memset(msg, 0, sizeof(*msg));
+    msg->base.descriptor = &plcrash__crash_report__signal__descriptor;
+
+    while (pos < end) {
+        uint64_t tag;
+        if (!plcrash_proto_read_varint(&pos, end, &tag))
+            goto error;
+
+        switch (tag) {
+            case (1 << 3) | 2: { /* name */
+                char *v;
+                if (!plcrash_proto_read_string(&pos, end, allocator, &v))
+                    goto error;
+                if (msg->name != NULL)
+                    allocator->free(allocator->allocator_data, msg->name);
+                msg->name = v;
+                break;
+            }
+
+            case (2 << 3) | 2: { /* code */
+                char *v;
+                if (!plcrash_proto_read_string(&pos, end, allocator, &v))
+                    goto error;
+                if (msg->code != NULL)
+                    allocator->free(allocator->allocator_data, msg->code);
+                msg->code = v;
+                break;
+            }
+
+            case (3 << 3) | 0: { /* address */
+                uint64_t v;
+                if (!plcrash_proto_read_varint(&pos, end, &v))
+                    goto error;
+                msg->address = v;
+                break;
+            }
+
+            default:
+                /* Known fields with an unexpected wire type are rejected, as by protobuf_c_message_unpack() */
+                switch (tag >> 3) {
+                    case 1:
+                    case 2:
+                    case 3:
+                        goto error;
+                }
+
+                if (!plcrash_proto_skip(&pos, end, (unsigned) (tag & 7)))
+                    goto error;
+                break;
+        }
+    }
+
+    return msg;
+
+error:
+    protobuf_c_message_free_unpacked(&msg->base, allocator);
+    return NULL;
+}
+
+/* Decode CrashReport.ProcessInfo */
+static Plcrash__CrashReport__ProcessInfo *plcrash_proto_process_info_decode (ProtobufCAllocator *allocator, const uint8_t *pos, size_t length) {
+    const uint8_t *end = pos + length;
+    Plcrash__CrashReport__ProcessInfo *msg;
+
+    msg = allocator->alloc(allocator->allocator_data, sizeof(*msg));
+    if (msg == NULL)
+        return NULL;
+    memset(msg, 0, sizeof(*msg));
+    msg->base.descriptor = &plcrash__crash_report__process_info__descriptor;
+
+    while (pos < end) {
+        uint64_t tag;
+        if (!plcrash_proto_read_varint(&pos, end, &tag))
+            goto error;
+
+        switch (tag) {
+            case (1 << 3) | 2: { /* process_name */
+                char *v;
+                if (!plcrash_proto_read_string(&pos, end, allocator, &v))
+                    goto error;
+                if (msg->process_name != NULL)
+                    allocator->free(allocator->allocator_data, msg->process_name);
+                msg->process_name = v;
+                break;
+            }
+
+            case (2 << 3) | 0: { /* process_id */
+                uint64_t v;
+                if (!plcrash_proto_read_varint(&pos, end, &v))
+                    goto error;
+                msg->process_id = (uint32_t) v;
+                break;
+            }
+
+            case (3 << 3) | 2: { /* process_path */
+                char *v;
+                if (!plcrash_proto_read_string(&pos, end, allocator, &v))
+                    goto error;
+                if (msg->process_path != NULL)
+                    allocator->free(allocator->allocator_data, msg->process_path);
+                msg->process_path = v;
+                break;
+            }
+
+            case (4 << 3) | 2: { /* parent_process_name */
+                char *v;
+                if (!plcrash_proto_read_string(&pos, end, allocator, &v))
+                    goto error;
+                if (msg->parent_process_name != NULL)
+                    allocator->free(allocator->allocator_data, msg->parent_process_name);
+                msg->parent_process_name = v;
+                break;
+            }
+
+            case (5 << 3) | 0: { /* parent_process_id */
+                uint64_t v;
+                if (!plcrash_proto_read_varint(&pos, end, &v))
+                    goto error;
+                msg->parent_process_id = (uint32_t) v;
+                break;
+            }
+
+            case (6 << 3) | 0: { /* native */
+                uint64_t v;
+                if (!plcrash_proto_read_varint(&pos, end, &v))
+                    goto error;
+                msg->native = v != 0;
+                break;
+            }
+
+            default:
+                /* Known fields with an unexpected wire type are rejected, as by protobuf_c_message_unpack() */
+                switch (tag >> 3) {
+                    case 1:
+                    case 2:
+                    case 3:
+                    case 4:
+                    case 5:
+                    case 6:
+                        goto error;
+                }
+
+                if (!plcrash_proto_skip(&pos, end, (unsigned) (tag & 7)))
+                    goto error;
+                break;
+        }
+    }
+
+    return msg;
+
+error:
+    protobuf_c_message_free_unpacked(&msg->base, allocator);
+    return NULL;
+}
+
+/* Decode CrashReport.MachineInfo */
+static Plcrash__CrashReport__MachineInfo *plcrash_proto_machine_info_decode (ProtobufCAllocator *allocator, const uint8_t *pos, size_t length) {
+    const uint8_t *end = pos + length;
+    Plcrash__CrashReport__MachineInfo *msg;
+
+    msg = allocator->alloc(allocator->allocator_data, sizeof(*msg));
+    if (msg == NULL)
+        return NULL;
+    memset(msg, 0, sizeof(*msg));
+    msg->base.descriptor = &plcrash__crash_report__machine_info__descriptor;
+
+    while (pos < end) {
+        uint64_t tag;
+        if (!plcrash_proto_read_varint(&pos, end, &tag))
+            goto error;
+
+        switch (tag) {
+            case (1 << 3) | 2: { /* model */
+                char *v;
+                if (!plcrash_proto_read_string(&pos, end, allocator, &v))
+                    goto error;
+                if (msg->model != NULL)
+                    allocator->free(allocator->allocator_data, msg->model);
+                msg->model = v;
+                break;
+            }
+
+            case (2 << 3) | 2: { /* processor */
+                size_t sublen;
+                Plcrash__CrashReport__Processor *sub;
+                if (!plcrash_proto_read_length(&pos, end, &sublen))
+                    goto error;
+                sub = plcrash_proto_processor_decode(allocator, pos, sublen);
+                if (sub == NULL)
+                    goto error;
+                pos += sublen;
+                if (msg->processor != NULL)
+                    protobuf_c_message_free_unpacked(&msg->processor->base, allocator);
+                msg->processor = sub;
+                break;
+            }
+
+            case (3 << 3) | 0: { /* processor_count */
+                uint64_t v;
+                if (!plcrash_proto_read_varint(&pos, end, &v))
+                    goto error;
+                msg->processor_count = (uint32_t) v;
+                break;
+            }
+
+            case (4 << 3) | 0: { /* logical_processor_count */
+                uint64_t v;
+                if (!plcrash_proto_read_varint(&pos, end, &v))
+                    goto error;
+                msg->logical_processor_count = (uint32_t) v;
+                break;
+            }
+
+            default:
+                /* Known fields with an unexpected wire type are rejected, as by protobuf_c_message_unpack() */
+                switch (tag >> 3) {
+                    case 1:
+                    case 2:
+                    case 3:
+                    case 4:
+                        goto error;
+                }
+
+                if (!plcrash_proto_skip(&pos, end, (unsigned) (tag & 7)))
+                    goto error;
+                break;
+        }
+    }
+
+    return msg;
+
+error:
+    protobuf_c_message_free_unpacked(&msg->base, allocator);
+    return NULL;
+}
+
+/* Decode CrashReport.Truncation */
+static Plcrash__CrashReport__Truncation *plcrash_proto_truncation_decode (ProtobufCAllocator *allocator, const uint8_t *pos, size_t length) {
+    const uint8_t *end = pos + length;
+    Plcrash__CrashReport__Truncation *msg;
+
+    msg = allocator->alloc(allocator->allocator_data, sizeof(*msg));
+    if (msg == NULL)
+        return NULL;
+    memset(msg, 0, sizeof(*msg));
+    msg->base.descriptor = &plcrash__crash_report__truncation__descriptor;
+
+    while (pos < end) {
+        uint64_t tag;
+        if (!plcrash_proto_read_varint(&pos, end, &tag))
+            goto error;
+
+        switch (tag) {
+            case (1 << 3) | 0: { /* omitted_threads */
+                uint64_t v;
+                if (!plcrash_proto_read_varint(&pos, end, &v))
+                    goto error;
+                msg->omitted_threads = (uint32_t) v;
+                break;
+            }
+
+            case (2 << 3) | 0: { /* omitted_images */
+                uint64_t v;
+                if (!plcrash_proto_read_varint(&pos, end, &v))
+                    goto error;
+                msg->omitted_images = (uint32_t) v;
+                break;
+            }
+
+            case (3 << 3) | 0: { /* deadline_exceeded */
+                uint64_t v;
+                if (!plcrash_proto_read_varint(&pos, end, &v))
+                    goto error;
+                msg->deadline_exceeded = v != 0;
+                break;
+            }
+
+            case (4 << 3) | 0: { /* byte_budget_exceeded */
+                uint64_t v;
+                if (!plcrash_proto_read_varint(&pos, end, &v))
+                    goto error;
+                msg->byte_budget_exceeded = v != 0;
+                break;
+            }
+
+            default:
+                /* Known fields with an unexpected wire type are rejected, as by protobuf_c_message_unpack() */
+                switch (tag >> 3) {
+                    case 1:
+                    case 2:
+                    case 3:
+                    case 4:
+                        goto error;
+                }
+
+                if (!plcrash_proto_skip(&pos, end, (unsigned) (tag & 7)))
+                    goto error;
+                break;
+        }
+    }
+
+    return msg;
+
+error:
+    protobuf_c_message_free_unpacked(&msg->base, allocator);
+    return NULL;
+}
+
+/* Decode CrashReport.WriterStats */
+static Plcrash__CrashReport__WriterStats *plcrash_proto_writer_stats_decode (ProtobufCAllocator *allocator, const uint8_t *pos, size_t length) {
+    const uint8_t *end = pos + length;
+    Plcrash__CrashReport__WriterStats *msg;
+    size_t threads_capacity = 0;
+
+    msg = allocator->alloc(allocator->allocator_data, sizeof(*msg));
+    if (msg == NULL)
+        return NULL;
+    memset(msg, 0, sizeof(*msg));
+    msg->base.descriptor = &plcrash__crash_report__writer_stats__descriptor;
+
+    while (pos < end) {
+        uint64_t tag;
+        if (!plcrash_proto_read_varint(&pos, end, &tag))
+            goto error;
+
+        switch (tag) {
+            case (1 << 3) | 2: { /* threads */
+                size_t sublen;
+                Plcrash__CrashReport__WriterStats__ThreadStats *sub;
+                if (!plcrash_proto_reserve(allocator, (void **) &msg->threads, msg->n_threads, &threads_capacity, sizeof(*msg->threads)))
+                    goto error;
+                if (!plcrash_proto_read_length(&pos, end, &sublen))
+                    goto error;
+                sub = plcrash_proto_writer_stats_thread_stats_decode(allocator, pos, sublen);
+                if (sub == NULL)
+                    goto error;
+                pos += sublen;
+                msg->threads[msg->n_threads++] = sub;
+                break;
+            }
+
+            case (2 << 3) | 0: { /* total_time */
+                uint64_t v;
+                if (!plcrash_proto_read_varint(&pos, end, &v))
+                    goto error;
+                msg->total_time = v;
+                break;
+            }
+
+            case (3 << 3) | 0: { /* image_time */
+                uint64_t v;
+                if (!plcrash_proto_read_varint(&pos, end, &v))
+                    goto error;
+                msg->image_time = v;
+                break;
+            }
+
+            case (4 << 3) | 0: { /* read_failures */
+                uint64_t v;
+                if (!plcrash_proto_read_varint(&pos, end, &v))
+                    goto error;
+                msg->read_failures = (uint32_t) v;
+                break;
+            }
+
+            case (5 << 3) | 0: { /* truncated_threads */
+                uint64_t v;
+                if (!plcrash_proto_read_varint(&pos, end, &v))
+                    goto error;
+                msg->truncated_threads = (uint32_t) v;
+                break;
+            }
+
+            case (6 << 3) | 0: { /* system_info_bytes */
+                uint64_t v;
+                if (!plcrash_proto_read_varint(&pos, end, &v))
+                    goto error;
+                msg->system_info_bytes = (uint32_t) v;
+                break;
+            }
+
+            case (7 << 3) | 0: { /* machine_info_bytes */
+                uint64_t v;
+                if (!plcrash_proto_read_varint(&pos, end, &v))
+                    goto error;
+                msg->machine_info_bytes = (uint32_t) v;
+                break;
+            }
+
+            case (8 << 3) | 0: { /* application_info_bytes */
+                uint64_t v;
+                if (!plcrash_proto_read_varint(&pos, end, &v))
+                    goto error;
+                msg->application_info_bytes = (uint32_t) v;
+                break;
+            }
+
+            case (9 << 3) | 0: { /* process_info_bytes */
+                uint64_t v;
+                if (!plcrash_proto_read_varint(&pos, end, &v))
+                    goto error;
+                msg->process_info_bytes = (uint32_t) v;
+                break;
+            }
+
+            case (10 << 3) | 0: { /* threads_bytes */
+                uint64_t v;
+                if (!plcrash_proto_read_varint(&pos, end, &v))
+                    goto error;
+                msg->threads_bytes = (uint32_t) v;
+                break;
+            }
+
+            case (11 << 3) | 0: { /* binary_images_bytes */
+                uint64_t v;
+                if (!plcrash_proto_read_varint(&pos, end, &v))
+                    goto error;
+                msg->binary_images_bytes = (uint32_t) v;
+                break;
+            }
+
+            case (12 << 3) | 0: { /* exception_bytes */
+                uint64_t v;
+                if (!plcrash_proto_read_varint(&pos, end, &v))
+                    goto error;
+                msg->exception_bytes = (uint32_t) v;
+                break;
+            }
+
+            case (13 << 3) | 0: { /* signal_bytes */
+                uint64_t v;
+                if (!plcrash_proto_read_varint(&pos, end, &v))
+                    goto error;
+                msg->signal_bytes = (uint32_t) v;
+                break;
+            }
+
+            default:
+                /* Known fields with an unexpected wire type are rejected, as by protobuf_c_message_unpack() */
+                switch (tag >> 3) {
+                    case 1:
+                    case 2:
+                    case 3:
+                    case 4:
+                    case 5:
+                    case 6:
+                    case 7:
+                    case 8:
+                    case 9:
+                    case 10:
+                    case 11:
+                    case 12:
+                    case 13:
+                        goto error;
+                }
+
+                if (!plcrash_proto_skip(&pos, end, (unsigned) (tag & 7)))
+                    goto error;
+                break;
+        }
+    }
+
+    return msg;
+
+error:
+    protobuf_c_message_free_unpacked(&msg->base, allocator);
+    return NULL;
+}
+
+/* Decode CrashReport.WriterStats.ThreadStats */
+static Plcrash__CrashReport__WriterStats__ThreadStats *plcrash_proto_writer_stats_thread_stats_decode (ProtobufCAllocator *allocator, const uint8_t *pos, size_t length) {
+    const uint8_t *end = pos + length;
+    Plcrash__CrashReport__WriterStats__ThreadStats *msg;
+
+    msg = allocator->alloc(allocator->allocator_data, sizeof(*msg));
+    if (msg == NULL)
+        return NULL;
+    memset(msg, 0, sizeof(*msg));
+    msg->base.descriptor = &plcrash__crash_report__writer_stats__thread_stats__descriptor;
+
+    while (pos < end) {
+        uint64_t tag;
+        if (!plcrash_proto_read_varint(&pos, end, &tag))
+            goto error;
+
+        switch (tag) {
+            case (1 << 3) | 0: { /* thread_number */
+                uint64_t v;
+                if (!plcrash_proto_read_varint(&pos, end, &v))
+                    goto error;
+                msg->thread_number = (uint32_t) v;
+                break;
+            }
+
+            case (2 << 3) | 0: { /* suspend_time */
+                uint64_t v;
+                if (!plcrash_proto_read_varint(&pos, end, &v))
+                    goto error;
+                msg->suspend_time = v;
+                break;
+            }
+
+            case (3 << 3) | 0: { /* walk_time */
+                uint64_t v;
+                if (!plcrash_proto_read_varint(&pos, end, &v))
+                    goto error;
+                msg->walk_time = v;
+                break;
+            }
+
+            case (4 << 3) | 0: { /* write_time */
+                uint64_t v;
+                if (!plcrash_proto_read_varint(&pos, end, &v))
+                    goto error;
+                msg->write_time = v;
+                break;
+            }
+
+            case (5 << 3) | 0: { /* truncated */
+                uint64_t v;
+                if (!plcrash_proto_read_varint(&pos, end, &v))
+                    goto error;
+                msg->truncated = v != 0;
+                break;
+            }
+
+            default:
+                /* Known fields with an unexpected wire type are rejected, as by protobuf_c_message_unpack() */
+                switch (tag >> 3) {
+                    case 1:
+                    case 2:
+                    case 3:
+                    case 4:
+                    case 5:
+                        goto error;
+                }
+
+                if (!plcrash_proto_skip(&pos, end, (unsigned) (tag & 7)))
+                    goto error;
+                break;
+        }
+    }
+
+    return msg;
+
+error:
+    protobuf_c_message_free_unpacked(&msg->base, allocator);
+    return NULL;
+}
+
+Plcrash__CrashReport *plcrash_proto_crash_report_unpack (ProtobufCAllocator *allocator, size_t length, const uint8_t *data) {
+    if (allocator == NULL)
+        allocator = &protobuf_c_default_allocator;
+
+    return plcrash_proto_crash_report_decode(allocator, data, length);
+}
@@ -0,0 +1,61 @@
+/*
+ * Generated by Tools/plcrash-protogen.py from crash_report.proto. DO NOT EDIT.
+ *
+ * Copyright (c) 2008-2011 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef PLCRASH_REPORT_DECODER_H
+#define PLCRASH_REPORT_DECODER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "crash_report.pb-c.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @internal
+ *
+ * Decode an encoded CrashReport message. This is a schema-specialized replacement for
+ * protobuf_c_message_unpack(); unknown fields are skipped rather than preserved.
+ *
+ * @param allocator Allocator used for the returned message.
+ * @param length Length of @a data.
+ * @param data Encoded message.
+ *
+ * @return The decoded message, or NULL if the data is malformed. As with protobuf_c_message_unpack(),
+ * the presence of required fields is not verified. The message must be released with
+ * protobuf_c_message_free_unpacked().
+ */
+Plcrash__CrashReport *plcrash_proto_crash_report_unpack (ProtobufCAllocator *allocator, size_t length, const uint8_t *data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PLCRASH_REPORT_DECODER_H */
@@ -0,0 +1,685 @@
+/*
+ * Generated by Tools/plcrash-protogen.py from crash_report.proto. DO NOT EDIT.
+ *
+ * Copyright (c) 2008-2011 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef PLCRASH_REPORT_ENCODER_H
+#define PLCRASH_REPORT_ENCODER_H
+
+#include "PLCrashLogWriterEncoding.h"
+
+/**
+ * @internal
+ * @defgroup plcrash_log_writer_proto Crash Report Field Encoders
+ * @ingroup plcrash_log_writer
+ *
+ * Field identifiers and typed field encoders for crash_report.proto.
+ *
+ * Each encoder writes a single field via plcrash_writer_pack(), and returns the number of bytes written. If
+ * @a file is NULL, nothing is written, and the encoded size of the field is returned. Message fields write
+ * only the field header; @a size must be the encoded size of the sub-message that follows.
+ *
+ * All encoders are async-safe.
+ * @{
+ */
+
+/* CrashReport */
+enum {
+    /** CrashReport.system_info */
+    PLCRASH_PROTO_CRASH_REPORT_SYSTEM_INFO_ID = 1,
+
+    /** CrashReport.application_info */
+    PLCRASH_PROTO_CRASH_REPORT_APPLICATION_INFO_ID = 2,
+
+    /** CrashReport.threads */
+    PLCRASH_PROTO_CRASH_REPORT_THREADS_ID = 3,
+
+    /** CrashReport.binary_images */
+    PLCRASH_PROTO_CRASH_REPORT_BINARY_IMAGES_ID = 4,
+
+    /** CrashReport.exception */
+    PLCRASH_PROTO_CRASH_REPORT_EXCEPTION_ID = 5,
+
+    /** CrashReport.signal */
+    PLCRASH_PROTO_CRASH_REPORT_SIGNAL_ID = 6,
+
+    /** CrashReport.process_info */
+    PLCRASH_PROTO_CRASH_REPORT_PROCESS_INFO_ID = 7,
+
+    /** CrashReport.machine_info */
+    PLCRASH_PROTO_CRASH_REPORT_MACHINE_INFO_ID = 8,
+
+    /** CrashReport.truncation */
+    PLCRASH_PROTO_CRASH_REPORT_TRUNCATION_ID = 9,
+
+    /** CrashReport.writer_stats */
+    PLCRASH_PROTO_CRASH_REPORT_WRITER_STATS_ID = 10,
+};
+
+/** Encode CrashReport.system_info (required SystemInfo). */
+static inline size_t plcrash_proto_crash_report_system_info_pack (plcrash_async_file_t *file, const uint32_t *size) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_CRASH_REPORT_SYSTEM_INFO_ID, PLPROTOBUF_C_TYPE_MESSAGE, size);
+}
+
+/** Encode CrashReport.application_info (required ApplicationInfo). */
+static inline size_t plcrash_proto_crash_report_application_info_pack (plcrash_async_file_t *file, const uint32_t *size) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_CRASH_REPORT_APPLICATION_INFO_ID, PLPROTOBUF_C_TYPE_MESSAGE, size);
+}
+
+/** Encode CrashReport.threads (repeated Thread). */
+static inline size_t plcrash_proto_crash_report_threads_pack (plcrash_async_file_t *file, const uint32_t *size) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_CRASH_REPORT_THREADS_ID, PLPROTOBUF_C_TYPE_MESSAGE, size);
+}
+
+/** Encode CrashReport.binary_images (repeated BinaryImage). */
+static inline size_t plcrash_proto_crash_report_binary_images_pack (plcrash_async_file_t *file, const uint32_t *size) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_CRASH_REPORT_BINARY_IMAGES_ID, PLPROTOBUF_C_TYPE_MESSAGE, size);
+}
+
+/** Encode CrashReport.exception (optional Exception). */
+static inline size_t plcrash_proto_crash_report_exception_pack (plcrash_async_file_t *file, const uint32_t *size) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_CRASH_REPORT_EXCEPTION_ID, PLPROTOBUF_C_TYPE_MESSAGE, size);
+}
+
+/** Encode CrashReport.signal (required Signal). */
+static inline size_t plcrash_proto_crash_report_signal_pack (plcrash_async_file_t *file, const uint32_t *size) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_CRASH_REPORT_SIGNAL_ID, PLPROTOBUF_C_TYPE_MESSAGE, size);
+}
+
+/** Encode CrashReport.process_info (optional ProcessInfo). */
+static inline size_t plcrash_proto_crash_report_process_info_pack (plcrash_async_file_t *file, const uint32_t *size) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_CRASH_REPORT_PROCESS_INFO_ID, PLPROTOBUF_C_TYPE_MESSAGE, size);
+}
+
+/** Encode CrashReport.machine_info (optional MachineInfo). */
+static inline size_t plcrash_proto_crash_report_machine_info_pack (plcrash_async_file_t *file, const uint32_t *size) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_CRASH_REPORT_MACHINE_INFO_ID, PLPROTOBUF_C_TYPE_MESSAGE, size);
+}
+
+/** Encode CrashReport.truncation (optional Truncation). */
+static inline size_t plcrash_proto_crash_report_truncation_pack (plcrash_async_file_t *file, const uint32_t *size) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_CRASH_REPORT_TRUNCATION_ID, PLPROTOBUF_C_TYPE_MESSAGE, size);
+}
+
+/** Encode CrashReport.writer_stats (optional WriterStats). */
+static inline size_t plcrash_proto_crash_report_writer_stats_pack (plcrash_async_file_t *file, const uint32_t *size) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_CRASH_REPORT_WRITER_STATS_ID, PLPROTOBUF_C_TYPE_MESSAGE, size);
+}
+
+/* CrashReport.Processor */
+enum {
+    /** CrashReport.Processor.encoding */
+    PLCRASH_PROTO_PROCESSOR_ENCODING_ID = 1,
+
+    /** CrashReport.Processor.type */
+    PLCRASH_PROTO_PROCESSOR_TYPE_ID = 2,
+
+    /** CrashReport.Processor.subtype */
+    PLCRASH_PROTO_PROCESSOR_SUBTYPE_ID = 3,
+};
+
+/** Encode CrashReport.Processor.encoding (optional TypeEncoding). */
+static inline size_t plcrash_proto_processor_encoding_pack (plcrash_async_file_t *file, const uint32_t *value) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_PROCESSOR_ENCODING_ID, PLPROTOBUF_C_TYPE_ENUM, value);
+}
+
+/** Encode CrashReport.Processor.type (required uint64). */
+static inline size_t plcrash_proto_processor_type_pack (plcrash_async_file_t *file, const uint64_t *value) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_PROCESSOR_TYPE_ID, PLPROTOBUF_C_TYPE_UINT64, value);
+}
+
+/** Encode CrashReport.Processor.subtype (required uint64). */
+static inline size_t plcrash_proto_processor_subtype_pack (plcrash_async_file_t *file, const uint64_t *value) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_PROCESSOR_SUBTYPE_ID, PLPROTOBUF_C_TYPE_UINT64, value);
+}
+
+/* CrashReport.SystemInfo */
+enum {
+    /** CrashReport.SystemInfo.operating_system */
+    PLCRASH_PROTO_SYSTEM_INFO_OPERATING_SYSTEM_ID = 1,
+
+    /** CrashReport.SystemInfo.os_version */
+    PLCRASH_PROTO_SYSTEM_INFO_OS_VERSION_ID = 2,
+
+    /** CrashReport.SystemInfo.architecture */
+    PLCRASH_PROTO_SYSTEM_INFO_ARCHITECTURE_ID = 3,
+
+    /** CrashReport.SystemInfo.timestamp */
+    PLCRASH_PROTO_SYSTEM_INFO_TIMESTAMP_ID = 4,
+
+    /** CrashReport.SystemInfo.os_build */
+    PLCRASH_PROTO_SYSTEM_INFO_OS_BUILD_ID = 5,
+};
+
+/** Encode CrashReport.SystemInfo.operating_system (optional OperatingSystem). */
+static inline size_t plcrash_proto_system_info_operating_system_pack (plcrash_async_file_t *file, const uint32_t *value) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_SYSTEM_INFO_OPERATING_SYSTEM_ID, PLPROTOBUF_C_TYPE_ENUM, value);
+}
+
+/** Encode CrashReport.SystemInfo.os_version (required string). */
+static inline size_t plcrash_proto_system_info_os_version_pack (plcrash_async_file_t *file, const char *value) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_SYSTEM_INFO_OS_VERSION_ID, PLPROTOBUF_C_TYPE_STRING, value);
+}
+
+/** Encode CrashReport.SystemInfo.architecture (required Architecture). */
+static inline size_t plcrash_proto_system_info_architecture_pack (plcrash_async_file_t *file, const uint32_t *value) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_SYSTEM_INFO_ARCHITECTURE_ID, PLPROTOBUF_C_TYPE_ENUM, value);
+}
+
+/** Encode CrashReport.SystemInfo.timestamp (required int64). */
+static inline size_t plcrash_proto_system_info_timestamp_pack (plcrash_async_file_t *file, const int64_t *value) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_SYSTEM_INFO_TIMESTAMP_ID, PLPROTOBUF_C_TYPE_INT64, value);
+}
+
+/** Encode CrashReport.SystemInfo.os_build (optional string). */
+static inline size_t plcrash_proto_system_info_os_build_pack (plcrash_async_file_t *file, const char *value) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_SYSTEM_INFO_OS_BUILD_ID, PLPROTOBUF_C_TYPE_STRING, value);
+}
+
+/* CrashReport.ApplicationInfo */
+enum {
+    /** CrashReport.ApplicationInfo.identifier */
+    PLCRASH_PROTO_APPLICATION_INFO_IDENTIFIER_ID = 1,
+
+    /** CrashReport.ApplicationInfo.version */
+    PLCRASH_PROTO_APPLICATION_INFO_VERSION_ID = 2,
+};
+
+/** Encode CrashReport.ApplicationInfo.identifier (required string). */
+static inline size_t plcrash_proto_application_info_identifier_pack (plcrash_async_file_t *file, const char *value) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_APPLICATION_INFO_IDENTIFIER_ID, PLPROTOBUF_C_TYPE_STRING, value);
+}
+
+/** Encode CrashReport.ApplicationInfo.version (required string). */
+static inline size_t plcrash_proto_application_info_version_pack (plcrash_async_file_t *file, const char *value) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_APPLICATION_INFO_VERSION_ID, PLPROTOBUF_C_TYPE_STRING, value);
+}
+
+/* CrashReport.Thread */
+enum {
+    /** CrashReport.Thread.thread_number */
+    PLCRASH_PROTO_THREAD_THREAD_NUMBER_ID = 1,
+
+    /** CrashReport.Thread.frames */
+    PLCRASH_PROTO_THREAD_FRAMES_ID = 2,
+
+    /** CrashReport.Thread.crashed */
+    PLCRASH_PROTO_THREAD_CRASHED_ID = 3,
+
+    /** CrashReport.Thread.registers */
+    PLCRASH_PROTO_THREAD_REGISTERS_ID = 4,
+
+    /** CrashReport.Thread.stack_memory */
+    PLCRASH_PROTO_THREAD_STACK_MEMORY_ID = 5,
+};
+
+/** Encode CrashReport.Thread.thread_number (required uint32). */
+static inline size_t plcrash_proto_thread_thread_number_pack (plcrash_async_file_t *file, const uint32_t *value) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_THREAD_THREAD_NUMBER_ID, PLPROTOBUF_C_TYPE_UINT32, value);
+}
+
+/** Encode CrashReport.Thread.frames (repeated StackFrame). */
+static inline size_t plcrash_proto_thread_frames_pack (plcrash_async_file_t *file, const uint32_t *size) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_THREAD_FRAMES_ID, PLPROTOBUF_C_TYPE_MESSAGE, size);
+}
+
+/** Encode CrashReport.Thread.crashed (required bool). */
+static inline size_t plcrash_proto_thread_crashed_pack (plcrash_async_file_t *file, const bool *value) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_THREAD_CRASHED_ID, PLPROTOBUF_C_TYPE_BOOL, value);
+}
+
+/** Encode CrashReport.Thread.registers (repeated RegisterValue). */
+static inline size_t plcrash_proto_thread_registers_pack (plcrash_async_file_t *file, const uint32_t *size) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_THREAD_REGISTERS_ID, PLPROTOBUF_C_TYPE_MESSAGE, size);
+}
+
+/** Encode CrashReport.Thread.stack_memory (repeated StackMemory). */
+static inline size_t plcrash_proto_thread_stack_memory_pack (plcrash_async_file_t *file, const uint32_t *size) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_THREAD_STACK_MEMORY_ID, PLPROTOBUF_C_TYPE_MESSAGE, size);
+}
+
+/* CrashReport.Thread.StackFrame */
+enum {
+    /** CrashReport.Thread.StackFrame.pc */
+    PLCRASH_PROTO_THREAD_STACK_FRAME_PC_ID = 3,
+};
+
+/** Encode CrashReport.Thread.StackFrame.pc (required uint64). */
+static inline size_t plcrash_proto_thread_stack_frame_pc_pack (plcrash_async_file_t *file, const uint64_t *value) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_THREAD_STACK_FRAME_PC_ID, PLPROTOBUF_C_TYPE_UINT64, value);
+}
+
+/* CrashReport.Thread.RegisterValue */
+enum {
+    /** CrashReport.Thread.RegisterValue.name */
+    PLCRASH_PROTO_THREAD_REGISTER_VALUE_NAME_ID = 1,
+
+    /** CrashReport.Thread.RegisterValue.value */
+    PLCRASH_PROTO_THREAD_REGISTER_VALUE_VALUE_ID = 2,
+};
+
+/** Encode CrashReport.Thread.RegisterValue.name (required string). */
+static inline size_t plcrash_proto_thread_register_value_name_pack (plcrash_async_file_t *file, const char *value) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_THREAD_REGISTER_VALUE_NAME_ID, PLPROTOBUF_C_TYPE_STRING, value);
+}
+
+/** Encode CrashReport.Thread.RegisterValue.value (required uint64). */
+static inline size_t plcrash_proto_thread_register_value_value_pack (plcrash_async_file_t *file, const uint64_t *value) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_THREAD_REGISTER_VALUE_VALUE_ID, PLPROTOBUF_C_TYPE_UINT64, value);
+}
+
+/* CrashReport.Thread.StackMemory */
+enum {
+    /** CrashReport.Thread.StackMemory.base_address */
+    PLCRASH_PROTO_THREAD_STACK_MEMORY_BASE_ADDRESS_ID = 1,
+
+    /** CrashReport.Thread.StackMemory.contents */
+    PLCRASH_PROTO_THREAD_STACK_MEMORY_CONTENTS_ID = 2,
+};
+
+/** Encode CrashReport.Thread.StackMemory.base_address (required uint64). */
+static inline size_t plcrash_proto_thread_stack_memory_base_address_pack (plcrash_async_file_t *file, const uint64_t *value) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_THREAD_STACK_MEMORY_BASE_ADDRESS_ID, PLPROTOBUF_C_TYPE_UINT64, value);
+}
+
+/** Encode CrashReport.Thread.StackMemory.contents (required bytes). */
+static inline size_t plcrash_proto_thread_stack_memory_contents_pack (plcrash_async_file_t *file, const PLProtobufCBinaryData *value) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_THREAD_STACK_MEMORY_CONTENTS_ID, PLPROTOBUF_C_TYPE_BYTES, value);
+}
+
+/* CrashReport.BinaryImage */
+enum {
+    /** CrashReport.BinaryImage.base_address */
+    PLCRASH_PROTO_BINARY_IMAGE_BASE_ADDRESS_ID = 1,
+
+    /** CrashReport.BinaryImage.size */
+    PLCRASH_PROTO_BINARY_IMAGE_SIZE_ID = 2,
+
+    /** CrashReport.BinaryImage.name */
+    PLCRASH_PROTO_BINARY_IMAGE_NAME_ID = 3,
+
+    /** CrashReport.BinaryImage.uuid */
+    PLCRASH_PROTO_BINARY_IMAGE_UUID_ID = 4,
+
+    /** CrashReport.BinaryImage.code_type */
+    PLCRASH_PROTO_BINARY_IMAGE_CODE_TYPE_ID = 5,
+};
+
+/** Encode CrashReport.BinaryImage.base_address (required uint64). */
+static inline size_t plcrash_proto_binary_image_base_address_pack (plcrash_async_file_t *file, const uint64_t *value) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_BINARY_IMAGE_BASE_ADDRESS_ID, PLPROTOBUF_C_TYPE_UINT64, value);
+}
+
+/** Encode CrashReport.BinaryImage.size (required uint64). */
+static inline size_t plcrash_proto_binary_image_size_pack (plcrash_async_file_t *file, const uint64_t *value) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_BINARY_IMAGE_SIZE_ID, PLPROTOBUF_C_TYPE_UINT64, value);
+}
+
+/** Encode CrashReport.BinaryImage.name (required string). */
+static inline size_t plcrash_proto_binary_image_name_pack (plcrash_async_file_t *file, const char *value) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_BINARY_IMAGE_NAME_ID, PLPROTOBUF_C_TYPE_STRING, value);
+}
+
+/** Encode CrashReport.BinaryImage.uuid (optional bytes). */
+static inline size_t plcrash_proto_binary_image_uuid_pack (plcrash_async_file_t *file, const PLProtobufCBinaryData *value) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_BINARY_IMAGE_UUID_ID, PLPROTOBUF_C_TYPE_BYTES, value);
+}
+
+/** Encode CrashReport.BinaryImage.code_type (optional Processor). */
+static inline size_t plcrash_proto_binary_image_code_type_pack (plcrash_async_file_t *file, const uint32_t *size) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_BINARY_IMAGE_CODE_TYPE_ID, PLPROTOBUF_C_TYPE_MESSAGE, size);
+}
+
+/* CrashReport.Exception */
+enum {
+    /** CrashReport.Exception.name */
+    PLCRASH_PROTO_EXCEPTION_NAME_ID = 1,
+
+    /** CrashReport.Exception.reason */
+    PLCRASH_PROTO_EXCEPTION_REASON_ID = 2,
+
+    /** CrashReport.Exception.frames */
+    PLCRASH_PROTO_EXCEPTION_FRAMES_ID = 3,
+};
+
+/** Encode CrashReport.Exception.name (required string). */
+static inline size_t plcrash_proto_exception_name_pack (plcrash_async_file_t *file, const char *value) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_EXCEPTION_NAME_ID, PLPROTOBUF_C_TYPE_STRING, value);
+}
+
+/** Encode CrashReport.Exception.reason (required string). */
+static inline size_t plcrash_proto_exception_reason_pack (plcrash_async_file_t *file, const char *value) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_EXCEPTION_REASON_ID, PLPROTOBUF_C_TYPE_STRING, value);
+}
+
+/** Encode CrashReport.Exception.frames (repeated Thread.StackFrame). */
+static inline size_t plcrash_proto_exception_frames_pack (plcrash_async_file_t *file, const uint32_t *size) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_EXCEPTION_FRAMES_ID, PLPROTOBUF_C_TYPE_MESSAGE, size);
+}
+
+/* CrashReport.Signal */
+enum {
+    /** CrashReport.Signal.name */
+    PLCRASH_PROTO_SIGNAL_NAME_ID = 1,
+
+    /** CrashReport.Signal.code */
+    PLCRASH_PROTO_SIGNAL_CODE_ID = 2,
+
+    /** CrashReport.Signal.address */
+    PLCRASH_PROTO_SIGNAL_ADDRESS_ID = 3,
+};
+
+/** Encode CrashReport.Signal.name (required string). */
+static inline size_t plcrash_proto_signal_name_pack (plcrash_async_file_t *file, const char *value) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_SIGNAL_NAME_ID, PLPROTOBUF_C_TYPE_STRING, value);
+}
+
+/** Encode CrashReport.Signal.code (required string). */
+static inline size_t plcrash_proto_signal_code_pack (plcrash_async_file_t *file, const char *value) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_SIGNAL_CODE_ID, PLPROTOBUF_C_TYPE_STRING, value);
+}
+
+/** Encode CrashReport.Signal.address (required uint64). */
+static inline size_t plcrash_proto_signal_address_pack (plcrash_async_file_t *file, const uint64_t *value) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_SIGNAL_ADDRESS_ID, PLPROTOBUF_C_TYPE_UINT64, value);
+}
+
+/* CrashReport.ProcessInfo */
+enum {
+    /** CrashReport.ProcessInfo.process_name */
+    PLCRASH_PROTO_PROCESS_INFO_PROCESS_NAME_ID = 1,
+
+    /** CrashReport.ProcessInfo.process_id */
+    PLCRASH_PROTO_PROCESS_INFO_PROCESS_ID_ID = 2,
+
+    /** CrashReport.ProcessInfo.process_path */
+    PLCRASH_PROTO_PROCESS_INFO_PROCESS_PATH_ID = 3,
+
+    /** CrashReport.ProcessInfo.parent_process_name */
+    PLCRASH_PROTO_PROCESS_INFO_PARENT_PROCESS_NAME_ID = 4,
+
+    /** CrashReport.ProcessInfo.parent_process_id */
+    PLCRASH_PROTO_PROCESS_INFO_PARENT_PROCESS_ID_ID = 5,
+
+    /** CrashReport.ProcessInfo.native */
+    PLCRASH_PROTO_PROCESS_INFO_NATIVE_ID = 6,
+};
+
+/** Encode CrashReport.ProcessInfo.process_name (optional string). */
+static inline size_t plcrash_proto_process_info_process_name_pack (plcrash_async_file_t *file, const char *value) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_PROCESS_INFO_PROCESS_NAME_ID, PLPROTOBUF_C_TYPE_STRING, value);
+}
+
+/** Encode CrashReport.ProcessInfo.process_id (required uint32). */
+static inline size_t plcrash_proto_process_info_process_id_pack (plcrash_async_file_t *file, const uint32_t *value) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_PROCESS_INFO_PROCESS_ID_ID, PLPROTOBUF_C_TYPE_UINT32, value);
+}
+
+/** Encode CrashReport.ProcessInfo.process_path (optional string). */
+static inline size_t plcrash_proto_process_info_process_path_pack (plcrash_async_file_t *file, const char *value) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_PROCESS_INFO_PROCESS_PATH_ID, PLPROTOBUF_C_TYPE_STRING, value);
+}
+
+/** Encode CrashReport.ProcessInfo.parent_process_name (optional string). */
+static inline size_t plcrash_proto_process_info_parent_process_name_pack (plcrash_async_file_t *file, const char *value) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_PROCESS_INFO_PARENT_PROCESS_NAME_ID, PLPROTOBUF_C_TYPE_STRING, value);
+}
+
+/** Encode CrashReport.ProcessInfo.parent_process_id (required uint32). */
+static inline size_t plcrash_proto_process_info_parent_process_id_pack (plcrash_async_file_t *file, const uint32_t *value) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_PROCESS_INFO_PARENT_PROCESS_ID_ID, PLPROTOBUF_C_TYPE_UINT32, value);
+}
+
+/** Encode CrashReport.ProcessInfo.native (required bool). */
+static inline size_t plcrash_proto_process_info_native_pack (plcrash_async_file_t *file, const bool *value) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_PROCESS_INFO_NATIVE_ID, PLPROTOBUF_C_TYPE_BOOL, value);
+}
+
+/* CrashReport.MachineInfo */
+enum {
+    /** CrashReport.MachineInfo.model */
+    PLCRASH_PROTO_MACHINE_INFO_MODEL_ID = 1,
+
+    /** CrashReport.MachineInfo.processor */
+    PLCRASH_PROTO_MACHINE_INFO_PROCESSOR_ID = 2,
+
+    /** CrashReport.MachineInfo.processor_count */
+    PLCRASH_PROTO_MACHINE_INFO_PROCESSOR_COUNT_ID = 3,
+
+    /** CrashReport.MachineInfo.logical_processor_count */
+    PLCRASH_PROTO_MACHINE_INFO_LOGICAL_PROCESSOR_COUNT_ID = 4,
+};
+
+/** Encode CrashReport.MachineInfo.model (optional string). */
+static inline size_t plcrash_proto_machine_info_model_pack (plcrash_async_file_t *file, const char *value) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_MACHINE_INFO_MODEL_ID, PLPROTOBUF_C_TYPE_STRING, value);
+}
+
+/** Encode CrashReport.MachineInfo.processor (required Processor). */
+static inline size_t plcrash_proto_machine_info_processor_pack (plcrash_async_file_t *file, const uint32_t *size) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_MACHINE_INFO_PROCESSOR_ID, PLPROTOBUF_C_TYPE_MESSAGE, size);
+}
+
+/** Encode CrashReport.MachineInfo.processor_count (required uint32). */
+static inline size_t plcrash_proto_machine_info_processor_count_pack (plcrash_async_file_t *file, const uint32_t *value) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_MACHINE_INFO_PROCESSOR_COUNT_ID, PLPROTOBUF_C_TYPE_UINT32, value);
+}
+
+/** Encode CrashReport.MachineInfo.logical_processor_count (required uint32). */
+static inline size_t plcrash_proto_machine_info_logical_processor_count_pack (plcrash_async_file_t *file, const uint32_t *value) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_MACHINE_INFO_LOGICAL_PROCESSOR_COUNT_ID, PLPROTOBUF_C_TYPE_UINT32, value);
+}
+
+/* CrashReport.Truncation */
+enum {
+    /** CrashReport.Truncation.omitted_threads */
+    PLCRASH_PROTO_TRUNCATION_OMITTED_THREADS_ID = 1,
+
+    /** CrashReport.Truncation.omitted_images */
+    PLCRASH_PROTO_TRUNCATION_OMITTED_IMAGES_ID = 2,
+
+    /** CrashReport.Truncation.deadline_exceeded */
+    PLCRASH_PROTO_TRUNCATION_DEADLINE_EXCEEDED_ID = 3,
+
+    /** CrashReport.Truncation.byte_budget_exceeded */
+    PLCRASH_PROTO_TRUNCATION_BYTE_BUDGET_EXCEEDED_ID = 4,
+};
+
+/** Encode CrashReport.Truncation.omitted_threads (required uint32). */
+static inline size_t plcrash_proto_truncation_omitted_threads_pack (plcrash_async_file_t *file, const uint32_t *value) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_TRUNCATION_OMITTED_THREADS_ID, PLPROTOBUF_C_TYPE_UINT32, value);
+}
+
+/** Encode CrashReport.Truncation.omitted_images (required uint32). */
+static inline size_t plcrash_proto_truncation_omitted_images_pack (plcrash_async_file_t *file, const uint32_t *value) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_TRUNCATION_OMITTED_IMAGES_ID, PLPROTOBUF_C_TYPE_UINT32, value);
+}
+
+/** Encode CrashReport.Truncation.deadline_exceeded (required bool). */
+static inline size_t plcrash_proto_truncation_deadline_exceeded_pack (plcrash_async_file_t *file, const bool *value) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_TRUNCATION_DEADLINE_EXCEEDED_ID, PLPROTOBUF_C_TYPE_BOOL, value);
+}
+
+/** Encode CrashReport.Truncation.byte_budget_exceeded (required bool). */
+static inline size_t plcrash_proto_truncation_byte_budget_exceeded_pack (plcrash_async_file_t *file, const bool *value) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_TRUNCATION_BYTE_BUDGET_EXCEEDED_ID, PLPROTOBUF_C_TYPE_BOOL, value);
+}
+
+/* CrashReport.WriterStats */
+enum {
+    /** CrashReport.WriterStats.threads */
+    PLCRASH_PROTO_WRITER_STATS_THREADS_ID = 1,
+
+    /** CrashReport.WriterStats.total_time */
+    PLCRASH_PROTO_WRITER_STATS_TOTAL_TIME_ID = 2,
+
+    /** CrashReport.WriterStats.image_time */
+    PLCRASH_PROTO_WRITER_STATS_IMAGE_TIME_ID = 3,
+
+    /** CrashReport.WriterStats.read_failures */
+    PLCRASH_PROTO_WRITER_STATS_READ_FAILURES_ID = 4,
+
+    /** CrashReport.WriterStats.truncated_threads */
+    PLCRASH_PROTO_WRITER_STATS_TRUNCATED_THREADS_ID = 5,
+
+    /** CrashReport.WriterStats.system_info_bytes */
+    PLCRASH_PROTO_WRITER_STATS_SYSTEM_INFO_BYTES_ID = 6,
+
+    /** CrashReport.WriterStats.machine_info_bytes */
+    PLCRASH_PROTO_WRITER_STATS_MACHINE_INFO_BYTES_ID = 7,
+
+    /** CrashReport.WriterStats.application_info_bytes */
+    PLCRASH_PROTO_WRITER_STATS_APPLICATION_INFO_BYTES_ID = 8,
+
+    /** CrashReport.WriterStats.process_info_bytes */
+    PLCRASH_PROTO_WRITER_STATS_PROCESS_INFO_BYTES_ID = 9,
+
+    /** CrashReport.WriterStats.threads_bytes */
+    PLCRASH_PROTO_WRITER_STATS_THREADS_BYTES_ID = 10,
+
+    /** CrashReport.WriterStats.binary_images_bytes */
+    PLCRASH_PROTO_WRITER_STATS_BINARY_IMAGES_BYTES_ID = 11,
+
+    /** CrashReport.WriterStats.exception_bytes */
+    PLCRASH_PROTO_WRITER_STATS_EXCEPTION_BYTES_ID = 12,
+
+    /** CrashReport.WriterStats.signal_bytes */
+    PLCRASH_PROTO_WRITER_STATS_SIGNAL_BYTES_ID = 13,
+};
+
+/** Encode CrashReport.WriterStats.threads (repeated ThreadStats). */
+static inline size_t plcrash_proto_writer_stats_threads_pack (plcrash_async_file_t *file, const uint32_t *size) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_WRITER_STATS_THREADS_ID, PLPROTOBUF_C_TYPE_MESSAGE, size);
+}
+
+/** Encode CrashReport.WriterStats.total_time (required uint64). */
+static inline size_t plcrash_proto_writer_stats_total_time_pack (plcrash_async_file_t *file, const uint64_t *value) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_WRITER_STATS_TOTAL_TIME_ID, PLPROTOBUF_C_TYPE_UINT64, value);
+}
+
+/** Encode CrashReport.WriterStats.image_time (required uint64). */
+static inline size_t plcrash_proto_writer_stats_image_time_pack (plcrash_async_file_t *file, const uint64_t *value) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_WRITER_STATS_IMAGE_TIME_ID, PLPROTOBUF_C_TYPE_UINT64, value);
+}
+
+/** Encode CrashReport.WriterStats.read_failures (required uint32). */
+static inline size_t plcrash_proto_writer_stats_read_failures_pack (plcrash_async_file_t *file, const uint32_t *value) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_WRITER_STATS_READ_FAILURES_ID, PLPROTOBUF_C_TYPE_UINT32, value);
+}
+
+/** Encode CrashReport.WriterStats.truncated_threads (required uint32). */
+static inline size_t plcrash_proto_writer_stats_truncated_threads_pack (plcrash_async_file_t *file, const uint32_t *value) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_WRITER_STATS_TRUNCATED_THREADS_ID, PLPROTOBUF_C_TYPE_UINT32, value);
+}
+
+/** Encode CrashReport.WriterStats.system_info_bytes (required uint32). */
+static inline size_t plcrash_proto_writer_stats_system_info_bytes_pack (plcrash_async_file_t *file, const uint32_t *value) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_WRITER_STATS_SYSTEM_INFO_BYTES_ID, PLPROTOBUF_C_TYPE_UINT32, value);
+}
+
+/** Encode CrashReport.WriterStats.machine_info_bytes (required uint32). */
+static inline size_t plcrash_proto_writer_stats_machine_info_bytes_pack (plcrash_async_file_t *file, const uint32_t *value) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_WRITER_STATS_MACHINE_INFO_BYTES_ID, PLPROTOBUF_C_TYPE_UINT32, value);
+}
+
+/** Encode CrashReport.WriterStats.application_info_bytes (required uint32). */
+static inline size_t plcrash_proto_writer_stats_application_info_bytes_pack (plcrash_async_file_t *file, const uint32_t *value) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_WRITER_STATS_APPLICATION_INFO_BYTES_ID, PLPROTOBUF_C_TYPE_UINT32, value);
+}
+
+/** Encode CrashReport.WriterStats.process_info_bytes (required uint32). */
+static inline size_t plcrash_proto_writer_stats_process_info_bytes_pack (plcrash_async_file_t *file, const uint32_t *value) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_WRITER_STATS_PROCESS_INFO_BYTES_ID, PLPROTOBUF_C_TYPE_UINT32, value);
+}
+
+/** Encode CrashReport.WriterStats.threads_bytes (required uint32). */
+static inline size_t plcrash_proto_writer_stats_threads_bytes_pack (plcrash_async_file_t *file, const uint32_t *value) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_WRITER_STATS_THREADS_BYTES_ID, PLPROTOBUF_C_TYPE_UINT32, value);
+}
+
+/** Encode CrashReport.WriterStats.binary_images_bytes (required uint32). */
+static inline size_t plcrash_proto_writer_stats_binary_images_bytes_pack (plcrash_async_file_t *file, const uint32_t *value) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_WRITER_STATS_BINARY_IMAGES_BYTES_ID, PLPROTOBUF_C_TYPE_UINT32, value);
+}
+
+/** Encode CrashReport.WriterStats.exception_bytes (required uint32). */
+static inline size_t plcrash_proto_writer_stats_exception_bytes_pack (plcrash_async_file_t *file, const uint32_t *value) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_WRITER_STATS_EXCEPTION_BYTES_ID, PLPROTOBUF_C_TYPE_UINT32, value);
+}
+
+/** Encode CrashReport.WriterStats.signal_bytes (required uint32). */
+static inline size_t plcrash_proto_writer_stats_signal_bytes_pack (plcrash_async_file_t *file, const uint32_t *value) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_WRITER_STATS_SIGNAL_BYTES_ID, PLPROTOBUF_C_TYPE_UINT32, value);
+}
+
+/* CrashReport.WriterStats.ThreadStats */
+enum {
+    /** CrashReport.WriterStats.ThreadStats.thread_number */
+    PLCRASH_PROTO_WRITER_STATS_THREAD_STATS_THREAD_NUMBER_ID = 1,
+
+    /** CrashReport.WriterStats.ThreadStats.suspend_time */
+    PLCRASH_PROTO_WRITER_STATS_THREAD_STATS_SUSPEND_TIME_ID = 2,
+
+    /** CrashReport.WriterStats.ThreadStats.walk_time */
+    PLCRASH_PROTO_WRITER_STATS_THREAD_STATS_WALK_TIME_ID = 3,
+
+    /** CrashReport.WriterStats.ThreadStats.write_time */
+    PLCRASH_PROTO_WRITER_STATS_THREAD_STATS_WRITE_TIME_ID = 4,
+
+    /** CrashReport.WriterStats.ThreadStats.truncated */
+    PLCRASH_PROTO_WRITER_STATS_THREAD_STATS_TRUNCATED_ID = 5,
+};
+
+/** Encode CrashReport.WriterStats.ThreadStats.thread_number (required uint32). */
+static inline size_t plcrash_proto_writer_stats_thread_stats_thread_number_pack (plcrash_async_file_t *file, const uint32_t *value) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_WRITER_STATS_THREAD_STATS_THREAD_NUMBER_ID, PLPROTOBUF_C_TYPE_UINT32, value);
+}
+
+/** Encode CrashReport.WriterStats.ThreadStats.suspend_time (required uint64). */
+static inline size_t plcrash_proto_writer_stats_thread_stats_suspend_time_pack (plcrash_async_file_t *file, const uint64_t *value) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_WRITER_STATS_THREAD_STATS_SUSPEND_TIME_ID, PLPROTOBUF_C_TYPE_UINT64, value);
+}
+
+/** Encode CrashReport.WriterStats.ThreadStats.walk_time (required uint64). */
+static inline size_t plcrash_proto_writer_stats_thread_stats_walk_time_pack (plcrash_async_file_t *file, const uint64_t *value) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_WRITER_STATS_THREAD_STATS_WALK_TIME_ID, PLPROTOBUF_C_TYPE_UINT64, value);
+}
+
+/** Encode CrashReport.WriterStats.ThreadStats.write_time (required uint64). */
+static inline size_t plcrash_proto_writer_stats_thread_stats_write_time_pack (plcrash_async_file_t *file, const uint64_t *value) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_WRITER_STATS_THREAD_STATS_WRITE_TIME_ID, PLPROTOBUF_C_TYPE_UINT64, value);
+}
+
+/** Encode CrashReport.WriterStats.ThreadStats.truncated (required bool). */
+static inline size_t plcrash_proto_writer_stats_thread_stats_truncated_pack (plcrash_async_file_t *file, const bool *value) {
+    return plcrash_writer_pack(file, PLCRASH_PROTO_WRITER_STATS_THREAD_STATS_TRUNCATED_ID, PLPROTOBUF_C_TYPE_BOOL, value);
+}
+
+/**
+ * @} plcrash_log_writer_proto
+ */
+
+#endif /* PLCRASH_REPORT_ENCODER_H */
@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2008-2011 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "CrashReporter.h"
+
+#import "PLCrashReportJSONFormatter.h"
+#import "PLCrashReportCore.h"
+
+static NSData *format_json (const plcrash_report_t *report, NSError **outError);
+static BOOL write_json (const plcrash_report_t *report, int fd, NSError **outError);
+static void populate_nserror (NSError **error, PLCrashReporterError code, NSString *description, NSError *cause);
+
+/**
+ * Formats PLCrashReport data as newline-terminated, single-line JSON.
+ *
+ * The schema is documented by plcrash_report_write_json(). As each report is written on a single line, the
+ * output of successive reports forms a newline-delimited JSON (NDJSON) stream.
+ */
+@implementation PLCrashReportJSONFormatter
+
+// from PLCrashReportFormatter protocol
+- (NSData *) formatReport: (PLCrashReport *) report error: (NSError **) outError {
+    return format_json([report coreReport], outError);
+}
+
+/**
+ * Format @a report and write the result to the file descriptor @a fd.
+ *
+ * @param report The report to format.
+ * @param fd The file descriptor to write to. The descriptor is not closed.
+ * @param outError If an error occurs, this pointer will contain an NSError object indicating why the report
+ * could not be written. If no error occurs, this parameter will be left unmodified. You may specify NULL for
+ * this parameter, and no error information will be provided.
+ *
+ * @return Returns YES on success, or NO if the report could not be written.
+ */
+- (BOOL) writeReport: (PLCrashReport *) report toFileDescriptor: (int) fd error: (NSError **) outError {
+    return write_json([report coreReport], fd, outError);
+}
+
+/**
+ * Decode the encoded crash report @a data, and format it as JSON.
+ *
+ * The report is decoded directly into its flat C representation, without constructing a PLCrashReport; this is
+ * the preferred interface when converting large numbers of reports.
+ *
+ * @param data Encoded crash report data.
+ * @param outError If an error occurs, this pointer will contain an NSError object indicating why the report
+ * could not be formatted. If no error occurs, this parameter will be left unmodified. You may specify NULL for
+ * this parameter, and no error information will be provided.
+ *
+ * @return Returns the formatted report data on success, or nil if the report could not be decoded.
+ */
+- (NSData *) formatReportData: (NSData *) data error: (NSError **) outError {
+    const char *description = NULL;
+    plcrash_report_t report;
+    NSData *result;
+
+    if (plcrash_report_decode(&report, [data bytes], [data length], &description) != PLCRASH_ESUCCESS) {
+        populate_nserror(outError, PLCrashReporterErrorCrashReportInvalid, [NSString stringWithUTF8String: description], nil);
+        return nil;
+    }
+
+    result = format_json(&report, outError);
+    plcrash_report_free(&report);
+
+    return result;
+}
+
+@end
+
+/**
+ * @internal
+ *
+ * Format @a report as a single line of JSON.
+ */
+static NSData *format_json (const plcrash_report_t *report, NSError **outError) {
+    plcrash_report_output_t output;
+    size_t length;
+    char *buf;
+
+    plcrash_report_output_init_buffer(&output, 0);
+    plcrash_report_write_json(report, &output);
+    plcrash_report_output_write(&output, "\n", 1);
+
+    if (output.error != PLCRASH_ESUCCESS) {
+        plcrash_report_output_free(&output);
+        populate_nserror(outError, PLCrashReporterErrorUnknown, @"Could not allocate the crash report JSON buffer", nil);
+        return nil;
+    }
+
+    buf = plcrash_report_output_detach(&output, &length);
+    return [NSData dataWithBytesNoCopy: buf length: length freeWhenDone: YES];
+}
+
+/**
+ * @internal
+ *
+ * Write @a report to @a fd as a single line of JSON.
+ */
+static BOOL write_json (const plcrash_report_t *report, int fd, NSError **outError) {
+    plcrash_report_output_t output;
+    char buffer[16384];
+    plcrash_error_t err;
+
+    plcrash_report_output_init_fd(&output, fd, buffer, sizeof(buffer));
+    plcrash_report_write_json(report, &output);
+    plcrash_report_output_write(&output, "\n", 1);
+
+    err = plcrash_report_output_flush(&output);
+    if (err == PLCRASH_OUTPUT_ERR) {
+        NSError *cause = [NSError errorWithDomain: NSPOSIXErrorDomain code: output.errnum userInfo: nil];
+        populate_nserror(outError, PLCrashReporterErrorOperatingSystem, @"Could not write the crash report JSON", cause);
+        return NO;
+    } else if (err != PLCRASH_ESUCCESS) {
+        populate_nserror(outError, PLCrashReporterErrorUnknown, @"Could not format the crash report JSON", nil);
+        return NO;
+    }
+
+    return YES;
+}
+
+/**
+ * @internal
+ *
+ * Populate an NSError instance with the provided information.
+ *
+ * @param error Error instance to populate. If NULL, this method returns
+ * and nothing is modified.
+ * @param code The error code corresponding to this error.
+ * @param description A localized error description.
+ * @param cause The underlying cause, if any. May be nil.
+ */
+static void populate_nserror (NSError **error, PLCrashReporterError code, NSString *description, NSError *cause) {
+    NSMutableDictionary *userInfo;
+    
+    if (error == NULL)
+        return;
+    
+    /* Create the userInfo dictionary */
+    userInfo = [NSMutableDictionary dictionaryWithObjectsAndKeys:
+                description, NSLocalizedDescriptionKey,
+                nil
+                ];
+
+    /* Add the cause, if available */
+    if (cause != nil)
+        [userInfo setObject: cause forKey: NSUnderlyingErrorKey];
+    
+    *error = [NSError errorWithDomain: PLCrashReporterErrorDomain code: code userInfo: userInfo];
+}
@@ -0,0 +1,457 @@
+/*
+ * Copyright (c) 2008-2011 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PLCrashReportStore.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <zlib.h>
+
+/**
+ * @ingroup plcrash_report_store
+ * @{
+ */
+
+/* Store file magic ('PLRS') and version */
+#define STORE_MAGIC 0x534c5250
+#define STORE_VERSION 1
+
+/* Size reserved for the store header */
+#define STORE_HEADER_SIZE 64
+
+/* Slot states. Zero-filled slots are free. */
+#define SLOT_FREE 0
+#define SLOT_WRITING 0x57524c50
+#define SLOT_COMMITTED 0x43524c50
+
+/* Size reserved for each slot header */
+#define SLOT_HEADER_SIZE 32
+
+/* Size of the zero-filled buffer used to preallocate the store */
+#define STORE_FILL_CHUNK 16384
+
+/**
+ * @internal
+ * Store file header.
+ */
+typedef struct store_header {
+    /** STORE_MAGIC */
+    uint32_t magic;
+
+    /** STORE_VERSION */
+    uint32_t version;
+
+    /** Store geometry; a store opened with a different geometry is reinitialized */
+    uint32_t slot_count;
+    uint32_t slot_capacity;
+
+    /** Sequence number of the oldest unacknowledged report */
+    uint64_t head;
+
+    /** Sequence number of the next report to be written. Sequence numbers start at 1. */
+    uint64_t tail;
+} store_header_t;
+
+/**
+ * @internal
+ * Slot header.
+ */
+typedef struct slot_header {
+    /** One of SLOT_FREE, SLOT_WRITING or SLOT_COMMITTED */
+    uint32_t state;
+
+    /** Report length */
+    uint32_t length;
+
+    /** Report sequence number */
+    uint64_t seq;
+
+    /** CRC-32 of the report */
+    uint32_t crc;
+} slot_header_t;
+
+/**
+ * @internal
+ * Return the header of the store mapping.
+ */
+static volatile store_header_t *store_header (plcrash_report_store_t *store) {
+    return (volatile store_header_t *) store->map;
+}
+
+/**
+ * @internal
+ * Return the distance between consecutive slots.
+ */
+static size_t slot_stride (uint32_t slot_capacity) {
+    /* Keep slot headers 8 byte aligned */
+    return SLOT_HEADER_SIZE + (((size_t) slot_capacity + 7) & ~(size_t) 7);
+}
+
+/**
+ * @internal
+ * Return the offset within the store of the slot holding report @a seq.
+ */
+static size_t slot_offset (plcrash_report_store_t *store, uint64_t seq) {
+    return STORE_HEADER_SIZE + (size_t) (seq % store->slot_count) * slot_stride(store->slot_capacity);
+}
+
+/**
+ * @internal
+ * Return the header of the slot holding report @a seq.
+ */
+static volatile slot_header_t *slot_header (plcrash_report_store_t *store, uint64_t seq) {
+    return (volatile slot_header_t *) ((uint8_t *) store->map + slot_offset(store, seq));
+}
+
+/**
+ * @internal
+ * Return the contents of the slot holding report @a seq.
+ */
+static const uint8_t *slot_data (plcrash_report_store_t *store, uint64_t seq) {
+    return (const uint8_t *) store->map + slot_offset(store, seq) + SLOT_HEADER_SIZE;
+}
+
+/**
+ * @internal
+ * Return true if the slot for report @a seq holds that report, committed and intact.
+ */
+static bool slot_valid (plcrash_report_store_t *store, uint64_t seq) {
+    volatile slot_header_t *slot = slot_header(store, seq);
+
+    if (slot->state != SLOT_COMMITTED || slot->seq != seq || slot->length > store->slot_capacity)
+        return false;
+
+    return crc32(0, slot_data(store, seq), slot->length) == slot->crc;
+}
+
+/**
+ * @internal
+ * Write an empty store of @a length bytes to @a fd. Every block is written, so that reports written from the
+ * signal handler never require the file system to allocate space.
+ */
+static bool store_initialize (int fd, size_t length, uint32_t slot_count, uint32_t slot_capacity) {
+    static const uint8_t zeros[STORE_FILL_CHUNK];
+    store_header_t header;
+
+    if (ftruncate(fd, 0) != 0)
+        return false;
+
+    for (size_t offset = 0; offset < length;) {
+        size_t chunk = (length - offset < sizeof(zeros)) ? length - offset : sizeof(zeros);
+        ssize_t written = pwrite(fd, zeros, chunk, (off_t) offset);
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        offset += (size_t) written;
+    }
+
+    memset(&header, 0, sizeof(header));
+    header.magic = STORE_MAGIC;
+    header.version = STORE_VERSION;
+    header.slot_count = slot_count;
+    header.slot_capacity = slot_capacity;
+    header.head = 1;
+    header.tail = 1;
+    if (pwrite(fd, &header, sizeof(header), 0) != (ssize_t) sizeof(header))
+        return false;
+
+    return fsync(fd) == 0;
+}
+
+/**
+ * @internal
+ * Repair the ring indices after the store is opened. A report committed by the signal handler immediately
+ * before the process was killed may not yet be included in the ring.
+ */
+static void store_recover (plcrash_report_store_t *store) {
+    volatile store_header_t *header = store_header(store);
+
+    if (header->tail == 0)
+        header->tail = 1;
+    if (header->head == 0 || header->head > header->tail)
+        header->head = header->tail;
+    if (header->tail - header->head > store->slot_count)
+        header->head = header->tail - store->slot_count;
+
+    for (uint32_t i = 0; i < store->slot_count && slot_valid(store, header->tail); i++) {
+        header->tail++;
+        if (header->tail - header->head > store->slot_count)
+            header->head++;
+    }
+}
+
+/**
+ * Open the report store at @a path, creating it if necessary. An existing store that is unreadable, or that was
+ * created with a different geometry, is reinitialized, discarding its reports.
+ *
+ * @param store The store to initialize.
+ * @param path The store file path.
+ * @param slot_count The number of slots, and so the number of reports retained.
+ * @param slot_capacity The maximum length of a report.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, PLCRASH_EINVAL if the geometry is invalid, or PLCRASH_EINTERNAL if
+ * the store could not be opened, in which case errno is set.
+ */
+plcrash_error_t plcrash_report_store_open (plcrash_report_store_t *store, const char *path, uint32_t slot_count, uint32_t slot_capacity) {
+    store_header_t header;
+    struct stat sb;
+
+    memset(store, 0, sizeof(*store));
+    store->fd = -1;
+
+    if (slot_count == 0 || slot_capacity == 0 || slot_capacity > INT32_MAX)
+        return PLCRASH_EINVAL;
+
+    size_t stride = slot_stride(slot_capacity);
+    if (slot_count > (SIZE_MAX - STORE_HEADER_SIZE) / stride)
+        return PLCRASH_EINVAL;
+    size_t length = STORE_HEADER_SIZE + slot_count * stride;
+
+    if ((store->fd = open(path, O_RDWR | O_CREAT, 0644)) < 0)
+        return PLCRASH_EINTERNAL;
+
+    if (fstat(store->fd, &sb) != 0)
+        goto error;
+
+    bool valid = (uint64_t) sb.st_size == (uint64_t) length &&
+        pread(store->fd, &header, sizeof(header), 0) == (ssize_t) sizeof(header) &&
+        header.magic == STORE_MAGIC && header.version == STORE_VERSION &&
+        header.slot_count == slot_count && header.slot_capacity == slot_capacity;
+    if (!valid && !store_initialize(store->fd, length, slot_count, slot_capacity))
+        goto error;
+
+    store->map = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, store->fd, 0);
+    if (store->map == MAP_FAILED) {
+        store->map = NULL;
+        goto error;
+    }
+    store->map_length = length;
+    store->slot_count = slot_count;
+    store->slot_capacity = slot_capacity;
+
+    store_recover(store);
+    return PLCRASH_ESUCCESS;
+
+error:
+    {
+        int err = errno;
+        close(store->fd);
+        store->fd = -1;
+        errno = err;
+    }
+    return PLCRASH_EINTERNAL;
+}
+
+/**
+ * Begin writing a report to the next slot, evicting the oldest report if every slot is occupied. @a file is
+ * initialized to write to the slot, and is limited to the slot's capacity.
+ *
+ * This function is async-safe.
+ *
+ * @param store The store to write to.
+ * @param file The file to initialize. Once the report has been written, it must be passed to
+ * plcrash_report_store_commit(), and must not be closed.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, PLCRASH_EINVAL if the store is not open, or PLCRASH_EINTERNAL if
+ * the slot could not be prepared.
+ */
+plcrash_error_t plcrash_report_store_begin (plcrash_report_store_t *store, plcrash_async_file_t *file) {
+    if (store->map == NULL)
+        return PLCRASH_EINVAL;
+
+    volatile store_header_t *header = store_header(store);
+    uint64_t seq = header->tail;
+
+    /* Evict the oldest report before its slot is overwritten */
+    if (seq - header->head >= store->slot_count)
+        header->head = seq - store->slot_count + 1;
+
+    volatile slot_header_t *slot = slot_header(store, seq);
+    slot->state = SLOT_WRITING;
+    slot->seq = seq;
+    __sync_synchronize();
+
+    if (lseek(store->fd, (off_t) (slot_offset(store, seq) + SLOT_HEADER_SIZE), SEEK_SET) < 0)
+        return PLCRASH_EINTERNAL;
+
+    plcrash_async_file_init(file, store->fd, store->slot_capacity);
+    store->writing_seq = seq;
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * Complete the report begun by plcrash_report_store_begin(), flushing @a file and adding the report to the ring.
+ * If any write to @a file failed, including a write that would have exceeded the slot's capacity, or the flush
+ * fails, the slot is left uncommitted and the report is discarded.
+ *
+ * This function is async-safe.
+ *
+ * @param store The store being written.
+ * @param file The file initialized by plcrash_report_store_begin().
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, PLCRASH_EINVAL if no report is being written, or
+ * PLCRASH_OUTPUT_ERR if the report was not written in full.
+ */
+plcrash_error_t plcrash_report_store_commit (plcrash_report_store_t *store, plcrash_async_file_t *file) {
+    uint64_t seq = store->writing_seq;
+    if (seq == 0)
+        return PLCRASH_EINVAL;
+    store->writing_seq = 0;
+
+    if (!plcrash_async_file_flush(file) || file->write_failed)
+        return PLCRASH_OUTPUT_ERR;
+
+    /* The slot's contents were written through the file descriptor, and are visible through the mapping */
+    volatile slot_header_t *slot = slot_header(store, seq);
+    slot->length = (uint32_t) file->total_bytes;
+    slot->crc = (uint32_t) crc32(0, slot_data(store, seq), (uInt) file->total_bytes);
+    __sync_synchronize();
+    slot->state = SLOT_COMMITTED;
+    __sync_synchronize();
+
+    store_header(store)->tail = seq + 1;
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * Abandon the report begun by plcrash_report_store_begin(). The slot is left uncommitted, and the report is
+ * discarded.
+ *
+ * This function is async-safe.
+ *
+ * @param store The store being written.
+ */
+void plcrash_report_store_abort (plcrash_report_store_t *store) {
+    store->writing_seq = 0;
+}
+
+/**
+ * Append a report, evicting the oldest report if every slot is occupied.
+ *
+ * @param store The store to write to.
+ * @param data The report.
+ * @param length The length of @a data.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, PLCRASH_EINVAL if the store is not open or the report is larger
+ * than a slot, or PLCRASH_EINTERNAL if the report could not be written.
+ */
+plcrash_error_t plcrash_report_store_append (plcrash_report_store_t *store, const void *data, size_t length) {
+    plcrash_async_file_t file;
+    plcrash_error_t err;
+
+    if (length > store->slot_capacity)
+        return PLCRASH_EINVAL;
+
+    if ((err = plcrash_report_store_begin(store, &file)) != PLCRASH_ESUCCESS)
+        return err;
+
+    if (!plcrash_async_file_write(&file, data, length)) {
+        plcrash_report_store_abort(store);
+        return PLCRASH_EINTERNAL;
+    }
+
+    return plcrash_report_store_commit(store, &file);
+}
+
+/**
+ * Return the number of unacknowledged reports. Reports found to be corrupt by plcrash_report_store_peek() are
+ * included until they are skipped.
+ *
+ * @param store The store to query.
+ */
+size_t plcrash_report_store_count (plcrash_report_store_t *store) {
+    if (store->map == NULL)
+        return 0;
+
+    volatile store_header_t *header = store_header(store);
+    return (size_t) (header->tail - header->head);
+}
+
+/**
+ * Return the oldest unacknowledged report, skipping (and acknowledging) any that are corrupt.
+ *
+ * @param store The store to read.
+ * @param data On success, set to the report's contents within the store mapping. The contents remain valid
+ * until the report is acknowledged, or the store is written or closed.
+ * @param length On success, set to the report's length.
+ *
+ * @return Returns true if a report was found, or false if there are no unacknowledged reports.
+ */
+bool plcrash_report_store_peek (plcrash_report_store_t *store, const void **data, size_t *length) {
+    if (store->map == NULL)
+        return false;
+
+    volatile store_header_t *header = store_header(store);
+    for (; header->head < header->tail; header->head++) {
+        if (slot_valid(store, header->head)) {
+            *data = slot_data(store, header->head);
+            *length = slot_header(store, header->head)->length;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Acknowledge the oldest unacknowledged report, releasing its slot.
+ *
+ * @param store The store to update.
+ */
+void plcrash_report_store_acknowledge (plcrash_report_store_t *store) {
+    if (store->map == NULL)
+        return;
+
+    volatile store_header_t *header = store_header(store);
+    if (header->head < header->tail)
+        header->head++;
+}
+
+/**
+ * Close the store, unmapping it. Acknowledgements and reports written through the mapping are written back by
+ * the system.
+ *
+ * @param store The store to close.
+ */
+void plcrash_report_store_close (plcrash_report_store_t *store) {
+    if (store->map != NULL)
+        munmap(store->map, store->map_length);
+    if (store->fd >= 0)
+        close(store->fd);
+
+    store->map = NULL;
+    store->fd = -1;
+}
+
+/**
+ * @} plcrash_report_store
+ */
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2008-2011 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef PLCRASH_REPORT_STORE_H
+#define PLCRASH_REPORT_STORE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "PLCrashAsync.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @internal
+ * @defgroup plcrash_report_store Crash Report Store
+ *
+ * A fixed-size ring of crash reports, held in a single preallocated, memory-mapped file.
+ *
+ * The file is a header followed by a fixed number of equally sized slots. Reports are numbered by a sequence
+ * number that increases with every report written; a report occupies slot (sequence % slot count). The header
+ * records the sequence numbers of the oldest unacknowledged report and of the next report to be written, so that
+ * appending, reading the oldest report and acknowledging it are all constant time. When every slot is occupied,
+ * writing a report evicts the oldest.
+ *
+ * Each slot begins with a small header recording its sequence number, length, CRC-32 and state. A slot is marked
+ * as being written before its contents are touched, and only marked committed, and the ring's head advanced, once
+ * the report is complete; a report torn by a second crash or a power loss fails its CRC and is skipped. A report
+ * that failed to write, or that did not fit in its slot, is never committed.
+ *
+ * Reports are written by plcrash_report_store_begin() and plcrash_report_store_commit() (or abandoned with
+ * plcrash_report_store_abort()), which are async-safe
+ * and are used by the signal handler to write the crash report directly into its slot. The store must have been
+ * opened beforehand. All other functions are not async-safe.
+ *
+ * The store is local to the host, and stored in host byte order.
+ *
+ * @{
+ */
+
+/** Default number of slots */
+#define PLCRASH_REPORT_STORE_DEFAULT_SLOTS 8
+
+/**
+ * An open report store. All fields are private.
+ */
+typedef struct plcrash_report_store {
+    /** @internal Store file descriptor */
+    int fd;
+
+    /** @internal Mapping of the whole store file */
+    void *map;
+    size_t map_length;
+
+    /** @internal Number of slots, and the maximum length of a report */
+    uint32_t slot_count;
+    uint32_t slot_capacity;
+
+    /** @internal Sequence number of the report being written by plcrash_report_store_begin(), or 0 */
+    uint64_t writing_seq;
+} plcrash_report_store_t;
+
+plcrash_error_t plcrash_report_store_open (plcrash_report_store_t *store, const char *path, uint32_t slot_count, uint32_t slot_capacity);
+
+plcrash_error_t plcrash_report_store_begin (plcrash_report_store_t *store, plcrash_async_file_t *file);
+plcrash_error_t plcrash_report_store_commit (plcrash_report_store_t *store, plcrash_async_file_t *file);
+void plcrash_report_store_abort (plcrash_report_store_t *store);
+plcrash_error_t plcrash_report_store_append (plcrash_report_store_t *store, const void *data, size_t length);
+
+size_t plcrash_report_store_count (plcrash_report_store_t *store);
+bool plcrash_report_store_peek (plcrash_report_store_t *store, const void **data, size_t *length);
+void plcrash_report_store_acknowledge (plcrash_report_store_t *store);
+
+void plcrash_report_store_close (plcrash_report_store_t *store);
+
+/**
+ * @} plcrash_report_store
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PLCRASH_REPORT_STORE_H */
@@ -0,0 +1,187 @@
+/*
+ * Author: Landon Fuller <landonf@plausiblelabs.com>
+ *
+ * Copyright (c) 2008-2009 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "GTMSenTestCase.h"
+
+#import "PLCrashReportStore.h"
+
+#import <fcntl.h>
+
+@interface PLCrashReportStoreTests : SenTestCase {
+@private
+    /* Path to the store */
+    NSString *_storePath;
+
+    /* Store under test */
+    plcrash_report_store_t _store;
+}
+
+@end
+
+@implementation PLCrashReportStoreTests
+
+- (void) setUp {
+    _storePath = [[NSTemporaryDirectory() stringByAppendingPathComponent: [[NSProcessInfo processInfo] globallyUniqueString]] retain];
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_report_store_open(&_store, [_storePath fileSystemRepresentation], 4, 100), @"Could not open store");
+}
+
+- (void) tearDown {
+    plcrash_report_store_close(&_store);
+    [[NSFileManager defaultManager] removeItemAtPath: _storePath error: NULL];
+    [_storePath release];
+}
+
+/* Append a report containing the given number */
+- (void) appendReport: (int) number {
+    char report[32];
+    int length = snprintf(report, sizeof(report), "report-%d", number);
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_report_store_append(&_store, report, length), @"Could not append report");
+}
+
+/* Return the number of the oldest report, or -1 if there is none */
+- (int) peekReport {
+    const void *data;
+    size_t length;
+    char report[32];
+    int number;
+
+    if (!plcrash_report_store_peek(&_store, &data, &length))
+        return -1;
+
+    STAssertTrue(length < sizeof(report), @"Unexpected report length");
+    memcpy(report, data, length);
+    report[length] = '\0';
+    STAssertEquals(1, sscanf(report, "report-%d", &number), @"Unexpected report contents");
+    return number;
+}
+
+- (void) reopen {
+    plcrash_report_store_close(&_store);
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_report_store_open(&_store, [_storePath fileSystemRepresentation], 4, 100), @"Could not reopen store");
+}
+
+- (void) testAppendPeekAcknowledge {
+    STAssertEquals((size_t) 0, plcrash_report_store_count(&_store), @"New store is not empty");
+    STAssertEquals(-1, [self peekReport], @"Peeked a report in an empty store");
+
+    for (int i = 0; i < 3; i++)
+        [self appendReport: i];
+
+    STAssertEquals((size_t) 3, plcrash_report_store_count(&_store), @"Incorrect count");
+    STAssertEquals(0, [self peekReport], @"Incorrect oldest report");
+
+    plcrash_report_store_acknowledge(&_store);
+    STAssertEquals(1, [self peekReport], @"Acknowledged report not released");
+
+    [self reopen];
+    STAssertEquals((size_t) 2, plcrash_report_store_count(&_store), @"Count not persisted");
+    STAssertEquals(1, [self peekReport], @"Acknowledgement not persisted");
+}
+
+- (void) testEvictsOldest {
+    for (int i = 0; i < 7; i++)
+        [self appendReport: i];
+
+    STAssertEquals((size_t) 4, plcrash_report_store_count(&_store), @"Store exceeded its slot count");
+    STAssertEquals(3, [self peekReport], @"Oldest reports not evicted");
+}
+
+- (void) testRejectsOversizedReport {
+    char report[101];
+    memset(report, 'x', sizeof(report));
+    STAssertEquals(PLCRASH_EINVAL, plcrash_report_store_append(&_store, report, sizeof(report)), @"Accepted a report larger than a slot");
+}
+
+- (void) testDiscardsUncommittedReport {
+    plcrash_async_file_t file;
+
+    [self appendReport: 0];
+
+    /* Begin a report, but close the store before it is committed */
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_report_store_begin(&_store, &file), @"Could not begin report");
+    STAssertTrue(plcrash_async_file_write(&file, "report-1", 8), @"Could not write report");
+    STAssertTrue(plcrash_async_file_flush(&file), @"Could not flush report");
+
+    [self reopen];
+    STAssertEquals((size_t) 1, plcrash_report_store_count(&_store), @"Uncommitted report included");
+    STAssertEquals(0, [self peekReport], @"Incorrect oldest report");
+}
+
+- (void) testDiscardsOverflowingReport {
+    plcrash_async_file_t file;
+    char chunk[60];
+
+    [self appendReport: 0];
+
+    /* The second write exceeds the slot's capacity and is dropped; the third still fits */
+    memset(chunk, 'x', sizeof(chunk));
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_report_store_begin(&_store, &file), @"Could not begin report");
+    STAssertTrue(plcrash_async_file_write(&file, chunk, sizeof(chunk)), @"Could not write report");
+    STAssertFalse(plcrash_async_file_write(&file, chunk, sizeof(chunk)), @"Wrote past the slot's capacity");
+    STAssertTrue(plcrash_async_file_write(&file, chunk, 8), @"Could not write report");
+    STAssertEquals(PLCRASH_OUTPUT_ERR, plcrash_report_store_commit(&_store, &file), @"Committed a truncated report");
+
+    STAssertEquals((size_t) 1, plcrash_report_store_count(&_store), @"Truncated report included");
+    STAssertEquals(0, [self peekReport], @"Incorrect oldest report");
+
+    [self reopen];
+    STAssertEquals((size_t) 1, plcrash_report_store_count(&_store), @"Truncated report recovered");
+    STAssertEquals(0, [self peekReport], @"Incorrect oldest report");
+
+    /* The slot is reused by the next report */
+    [self appendReport: 1];
+    plcrash_report_store_acknowledge(&_store);
+    STAssertEquals(1, [self peekReport], @"Report following a truncated report not stored");
+}
+
+- (void) testSkipsCorruptReport {
+    [self appendReport: 0];
+    [self appendReport: 1];
+    plcrash_report_store_close(&_store);
+
+    /* Overwrite the first byte of the first report, in the second slot (sequence numbers start at 1) */
+    int fd = open([_storePath fileSystemRepresentation], O_RDWR);
+    STAssertTrue(fd >= 0, @"Could not open store file");
+    off_t offset = 64 + (32 + 104) + 32;
+    STAssertEquals((ssize_t) 1, pwrite(fd, "X", 1, offset), @"Could not corrupt report");
+    close(fd);
+
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_report_store_open(&_store, [_storePath fileSystemRepresentation], 4, 100), @"Could not reopen store");
+    STAssertEquals(1, [self peekReport], @"Corrupt report not skipped");
+    STAssertEquals((size_t) 1, plcrash_report_store_count(&_store), @"Corrupt report not acknowledged");
+}
+
+- (void) testReinitializesOnGeometryChange {
+    [self appendReport: 0];
+    plcrash_report_store_close(&_store);
+
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_report_store_open(&_store, [_storePath fileSystemRepresentation], 8, 100), @"Could not reopen store");
+    STAssertEquals((size_t) 0, plcrash_report_store_count(&_store), @"Store with a different geometry not reinitialized");
+}
+
+@end
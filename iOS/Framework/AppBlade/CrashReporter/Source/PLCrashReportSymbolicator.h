@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2008-2011 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+
+#import "PLCrashReport.h"
+
+@interface PLCrashReportSymbolicator : NSObject {
+@private
+    /** Underlying symbolicator (PLCrashSymbolicator.h) */
+    struct plcrash_symbolicator *_symbolicator;
+}
+
+- (id) initWithLineInfo: (BOOL) lineInfo;
+
+- (BOOL) addSymbolsAtPath: (NSString *) path error: (NSError **) outError;
+
+- (BOOL) symbolicateReport: (PLCrashReport *) report error: (NSError **) outError;
+
+- (BOOL) writeSymbolCachesToDirectory: (NSString *) directory error: (NSError **) outError;
+
+/** Number of distinct images indexed. */
+@property(nonatomic, readonly) NSUInteger imageCount;
+
+@end
@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2008-2011 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "CrashReporter.h"
+
+#import "PLCrashReportSymbolicator.h"
+#import "PLCrashSymbolicator.h"
+
+#import <errno.h>
+
+static void populate_nserror (NSError **error, PLCrashReporterError code, NSString *description, NSError *cause);
+
+/**
+ * Symbolicates crash reports offline, using local Mach-O binaries, dSYM bundles, and ELF files.
+ *
+ * Symbolicated reports include symbol names (and, optionally, source file and line numbers) when formatted
+ * with PLCrashReportTextFormatter or PLCrashReportJSONFormatter. Binaries are matched to report images by UUID
+ * (or ELF build-id); symbol tables are loaded on first use and cached by the receiver, so a single instance
+ * should be reused when symbolicating many reports.
+ *
+ * Symbol caches written by writeSymbolCachesToDirectory:error: may be added in place of the original files, and
+ * are used directly from disk, avoiding the cost of parsing large symbol tables and DWARF line tables.
+ */
+@implementation PLCrashReportSymbolicator
+
+/**
+ * Initialize a symbolicator that resolves symbol names and DWARF source locations.
+ */
+- (id) init {
+    return [self initWithLineInfo: YES];
+}
+
+/**
+ * Initialize a symbolicator.
+ *
+ * @param lineInfo If YES, DWARF line tables will be used to resolve source file names and line numbers.
+ */
+- (id) initWithLineInfo: (BOOL) lineInfo {
+    if ((self = [super init]) == nil)
+        return nil;
+
+    _symbolicator = malloc(sizeof(plcrash_symbolicator_t));
+    if (_symbolicator == NULL || plcrash_symbolicator_init(_symbolicator, lineInfo) != PLCRASH_ESUCCESS) {
+        free(_symbolicator);
+        _symbolicator = NULL;
+
+        [self release];
+        return nil;
+    }
+
+    return self;
+}
+
+- (void) dealloc {
+    if (_symbolicator != NULL) {
+        plcrash_symbolicator_free(_symbolicator);
+        free(_symbolicator);
+    }
+
+    [super dealloc];
+}
+
+/**
+ * Index the symbol files at @a path. If @a path is a directory, it is searched recursively (including within
+ * dSYM bundles), and files that are not Mach-O or ELF objects are ignored.
+ *
+ * @param path A Mach-O binary, universal binary, dSYM DWARF file, ELF file, or a directory.
+ * @param outError If an error occurs, this pointer will contain an NSError object indicating why the symbols
+ * could not be added. If no error occurs, this parameter will be left unmodified. You may specify NULL for
+ * this parameter, and no error information will be provided.
+ *
+ * @return Returns YES on success, or NO if @a path could not be read or is not a supported object file.
+ */
+- (BOOL) addSymbolsAtPath: (NSString *) path error: (NSError **) outError {
+    plcrash_error_t err = plcrash_symbolicator_add_path(_symbolicator, [path fileSystemRepresentation]);
+
+    switch (err) {
+        case PLCRASH_ESUCCESS:
+            return YES;
+
+        case PLCRASH_EINVAL:
+            populate_nserror(outError, PLCrashReporterErrorOperatingSystem,
+                             [NSString stringWithFormat: @"Could not read symbols at %@", path], nil);
+            return NO;
+
+        case PLCRASH_ENOTSUP:
+            populate_nserror(outError, PLCrashReporterErrorUnknown,
+                             [NSString stringWithFormat: @"%@ is not a Mach-O or ELF file with a UUID", path], nil);
+            return NO;
+
+        default:
+            populate_nserror(outError, PLCrashReporterErrorUnknown, @"Could not index symbols", nil);
+            return NO;
+    }
+}
+
+/**
+ * Resolve the stack frames of @a report. Frames within images whose symbols have not been added are left
+ * unresolved. Any previous symbolication of @a report is replaced.
+ *
+ * @param report The report to symbolicate.
+ * @param outError If an error occurs, this pointer will contain an NSError object indicating why the report
+ * could not be symbolicated. If no error occurs, this parameter will be left unmodified. You may specify NULL for
+ * this parameter, and no error information will be provided.
+ *
+ * @return Returns YES on success, or NO if memory could not be allocated.
+ */
+- (BOOL) symbolicateReport: (PLCrashReport *) report error: (NSError **) outError {
+    /* The symbols are owned by the report's core representation */
+    plcrash_report_t *coreReport = (plcrash_report_t *) [report coreReport];
+
+    if (plcrash_symbolicator_symbolicate(_symbolicator, coreReport) != PLCRASH_ESUCCESS) {
+        populate_nserror(outError, PLCrashReporterErrorUnknown, @"Could not allocate the symbolicated frames", nil);
+        return NO;
+    }
+
+    return YES;
+}
+
+/**
+ * Write a compact, memory-mappable symbol cache for each image indexed from a binary or debug file, replacing
+ * any existing caches for the same images. Adding @a directory to a symbolicator allows those images to be
+ * used without parsing their symbol tables or debug information.
+ *
+ * @param directory The directory to write to. The directory must exist.
+ * @param outError If an error occurs, this pointer will contain an NSError object indicating why the caches
+ * could not be written. If no error occurs, this parameter will be left unmodified. You may specify NULL for
+ * this parameter, and no error information will be provided.
+ *
+ * @return Returns YES on success, or NO if a cache could not be written.
+ */
+- (BOOL) writeSymbolCachesToDirectory: (NSString *) directory error: (NSError **) outError {
+    size_t count;
+
+    switch (plcrash_symbolicator_write_caches(_symbolicator, [directory fileSystemRepresentation], &count)) {
+        case PLCRASH_ESUCCESS:
+            return YES;
+
+        case PLCRASH_OUTPUT_ERR: {
+            NSError *cause = [NSError errorWithDomain: NSPOSIXErrorDomain code: errno userInfo: nil];
+            populate_nserror(outError, PLCrashReporterErrorOperatingSystem,
+                             [NSString stringWithFormat: @"Could not write symbol caches to %@", directory], cause);
+            return NO;
+        }
+
+        default:
+            populate_nserror(outError, PLCrashReporterErrorUnknown, @"Could not build symbol caches", nil);
+            return NO;
+    }
+}
+
+// property getter
+- (NSUInteger) imageCount {
+    return plcrash_symbolicator_image_count(_symbolicator);
+}
+
+@end
+
+/**
+ * @internal
+ *
+ * Populate an NSError instance with the provided information.
+ *
+ * @param error Error instance to populate. If NULL, this method returns
+ * and nothing is modified.
+ * @param code The error code corresponding to this error.
+ * @param description A localized error description.
+ * @param cause The underlying cause, if any. May be nil.
+ */
+static void populate_nserror (NSError **error, PLCrashReporterError code, NSString *description, NSError *cause) {
+    NSMutableDictionary *userInfo;
+    
+    if (error == NULL)
+        return;
+    
+    /* Create the userInfo dictionary */
+    userInfo = [NSMutableDictionary dictionaryWithObjectsAndKeys:
+                description, NSLocalizedDescriptionKey,
+                nil
+                ];
+
+    /* Add the cause, if available */
+    if (cause != nil)
+        [userInfo setObject: cause forKey: NSUnderlyingErrorKey];
+    
+    *error = [NSError errorWithDomain: PLCrashReporterErrorDomain code: code userInfo: userInfo];
+}
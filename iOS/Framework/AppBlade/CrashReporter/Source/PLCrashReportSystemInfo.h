@@ -48,6 +48,9 @@ typedef enum {
     
     /** Unknown operating system */
     PLCrashReportOperatingSystemUnknown = 3,
+
+    /** Linux */
+    PLCrashReportOperatingSystemLinux = 4,
 } PLCrashReportOperatingSystem;
 
 /**
@@ -32,18 +32,16 @@
 #import "CrashReporter.h"
 
 #import "PLCrashReportTextFormatter.h"
+#import "PLCrashReportCore.h"
 
 
-@interface PLCrashReportTextFormatter (PrivateAPI)
-NSInteger binaryImageSort(id binary1, id binary2, void *context);
-+ (NSString *) formatStackFrame: (PLCrashReportStackFrameInfo *) frameInfo 
-                     frameIndex: (NSUInteger) frameIndex
-                         report: (PLCrashReport *) report;
-@end
-
+static void populate_nserror (NSError **error, PLCrashReporterError code, NSString *description, NSError *cause);
 
 /**
  * Formats PLCrashReport data as human-readable text.
+ *
+ * Formatting is performed by the Foundation-free plcrash_report_write_text(), which writes directly into the
+ * buffer backing the returned string or data, or to a file descriptor.
  */
 @implementation PLCrashReportTextFormatter
 
@@ -58,341 +56,26 @@ NSInteger binaryImageSort(id binary1, id binary2, void *context);
  * @return Returns the formatted result on success, or nil if an error occurs.
  */
 + (NSString *) stringValueForCrashReport: (PLCrashReport *) report withTextFormat: (PLCrashReportTextFormat) textFormat {
-	NSMutableString* text = [NSMutableString string];
-	boolean_t lp64 = true; // quiesce GCC uninitialized value warning
-    
-	/* Header */
-	
-    /* Map to apple style OS nane */
-    NSString *osName;
-    switch (report.systemInfo.operatingSystem) {
-        case PLCrashReportOperatingSystemMacOSX:
-            osName = @"Mac OS X";
-            break;
-        case PLCrashReportOperatingSystemiPhoneOS:
-            osName = @"iPhone OS";
-            break;
-        case PLCrashReportOperatingSystemiPhoneSimulator:
-            osName = @"Mac OS X";
-            break;
-        default:
-            osName = [NSString stringWithFormat: @"Unknown (%d)", report.systemInfo.operatingSystem];
-            break;
-    }
-    
-    /* Map to Apple-style code type, and mark whether architecture is LP64 (64-bit) */
-    NSString *codeType = nil;
-    {
-        /* Attempt to derive the code type from the binary images */
-        for (PLCrashReportBinaryImageInfo *image in report.images) {
-            /* Skip images with no specified type */
-            if (image.codeType == nil)
-                continue;
-
-            /* Skip unknown encodings */
-            if (image.codeType.typeEncoding != PLCrashReportProcessorTypeEncodingMach)
-                continue;
-            
-            switch (image.codeType.type) {
-                case CPU_TYPE_ARM:
-                    codeType = @"ARM";
-                    lp64 = false;
-                    break;
-
-                case CPU_TYPE_X86:
-                    codeType = @"X86";
-                    lp64 = false;
-                    break;
-
-                case CPU_TYPE_X86_64:
-                    codeType = @"X86-64";
-                    lp64 = true;
-                    break;
-
-                case CPU_TYPE_POWERPC:
-                    codeType = @"PPC";
-                    lp64 = false;
-                    break;
-                    
-                default:
-                    // Do nothing, handled below.
-                    break;
-            }
-
-            /* Stop immediately if code type was discovered */
-            if (codeType != nil)
-                break;
-        }
-
-        /* If we were unable to determine the code type, fall back on the legacy architecture value. */
-        if (codeType == nil) {
-            switch (report.systemInfo.architecture) {
-                case PLCrashReportArchitectureARMv6:
-                case PLCrashReportArchitectureARMv7:
-                    codeType = @"ARM";
-                    lp64 = false;
-                    break;
-                case PLCrashReportArchitectureX86_32:
-                    codeType = @"X86";
-                    lp64 = false;
-                    break;
-                case PLCrashReportArchitectureX86_64:
-                    codeType = @"X86-64";
-                    lp64 = true;
-                    break;
-                case PLCrashReportArchitecturePPC:
-                    codeType = @"PPC";
-                    lp64 = false;
-                    break;
-                default:
-                    codeType = [NSString stringWithFormat: @"Unknown (%d)", report.systemInfo.architecture];
-                    lp64 = true;
-                    break;
-            }
-        }
-    }
-
-    {
-        NSString *hardwareModel = @"???";
-        if (report.hasMachineInfo && report.machineInfo.modelName != nil)
-            hardwareModel = report.machineInfo.modelName;
-
-        [text appendFormat: @"Incident Identifier: [TODO]\n"];
-        [text appendFormat: @"CrashReporter Key:   [TODO]\n"];
-        [text appendFormat: @"Hardware Model:      %@\n", hardwareModel];
-    }
-    
-    /* Application and process info */
-    {
-        NSString *unknownString = @"???";
-        
-        NSString *processName = unknownString;
-        NSString *processId = unknownString;
-        NSString *processPath = unknownString;
-        NSString *parentProcessName = unknownString;
-        NSString *parentProcessId = unknownString;
-        
-        /* Process information was not available in earlier crash report versions */
-        if (report.hasProcessInfo) {
-            /* Process Name */
-            if (report.processInfo.processName != nil)
-                processName = report.processInfo.processName;
-            
-            /* PID */
-            processId = [[NSNumber numberWithUnsignedInteger: report.processInfo.processID] stringValue];
-            
-            /* Process Path */
-            if (report.processInfo.processPath != nil)
-                processPath = report.processInfo.processPath;
-            
-            /* Parent Process Name */
-            if (report.processInfo.parentProcessName != nil)
-                parentProcessName = report.processInfo.parentProcessName;
-            
-            /* Parent Process ID */
-            parentProcessId = [[NSNumber numberWithUnsignedInteger: report.processInfo.parentProcessID] stringValue];
-        }
-        
-        [text appendFormat: @"Process:         %@ [%@]\n", processName, processId];
-        [text appendFormat: @"Path:            %@\n", processPath];
-        [text appendFormat: @"Identifier:      %@\n", report.applicationInfo.applicationIdentifier];
-        [text appendFormat: @"Version:         %@\n", report.applicationInfo.applicationVersion];
-        [text appendFormat: @"Code Type:       %@\n", codeType];
-        [text appendFormat: @"Parent Process:  %@ [%@]\n", parentProcessName, parentProcessId];
-    }
-    
-    [text appendString: @"\n"];
-    
-    /* System info */
-    {
-        NSString *osBuild = @"???";
-        if (report.systemInfo.operatingSystemBuild != nil)
-            osBuild = report.systemInfo.operatingSystemBuild;
-        
-        [text appendFormat: @"Date/Time:       %@\n", report.systemInfo.timestamp];
-        [text appendFormat: @"OS Version:      %@ %@ (%@)\n", osName, report.systemInfo.operatingSystemVersion, osBuild];
-        [text appendFormat: @"Report Version:  104\n"];        
-    }
-
-    [text appendString: @"\n"];
-
-    /* Exception code */
-    [text appendFormat: @"Exception Type:  %@\n", report.signalInfo.name];
-    [text appendFormat: @"Exception Codes: %@ at 0x%" PRIx64 "\n", report.signalInfo.code, report.signalInfo.address];
-    
-    for (PLCrashReportThreadInfo *thread in report.threads) {
-        if (thread.crashed) {
-            [text appendFormat: @"Crashed Thread:  %ld\n", (long) thread.threadNumber];
-            break;
-        }
-    }
-    
-    [text appendString: @"\n"];
-    
-    /* Uncaught Exception */
-    if (report.hasExceptionInfo) {
-        [text appendFormat: @"Application Specific Information:\n"];
-        [text appendFormat: @"*** Terminating app due to uncaught exception '%@', reason: '%@'\n",
-                report.exceptionInfo.exceptionName, report.exceptionInfo.exceptionReason];
-        
-        [text appendString: @"\n"];
-    }
-    
-    /* Threads */
-    PLCrashReportThreadInfo *crashed_thread = nil;
-    NSInteger maxThreadNum = 0;
-    for (PLCrashReportThreadInfo *thread in report.threads) {
-        if (thread.crashed) {
-            [text appendFormat: @"Thread %ld Crashed:\n", (long) thread.threadNumber];
-            crashed_thread = thread;
-        } else {
-            [text appendFormat: @"Thread %ld:\n", (long) thread.threadNumber];
-        }
-        for (NSUInteger frame_idx = 0; frame_idx < [thread.stackFrames count]; frame_idx++) {
-            PLCrashReportStackFrameInfo *frameInfo = [thread.stackFrames objectAtIndex: frame_idx];
-            [text appendString: [self formatStackFrame: frameInfo frameIndex: frame_idx report: report]];
-        }
-        [text appendString: @"\n"];
-
-        /* Track the highest thread number */
-        maxThreadNum = MAX(maxThreadNum, thread.threadNumber);
-    }
-    
-    /* If an exception stack trace is available, output a pseudo-thread to provide the frame info */
-    if (report.exceptionInfo != nil && report.exceptionInfo.stackFrames != nil && [report.exceptionInfo.stackFrames count] > 0) {
-        PLCrashReportExceptionInfo *exception = report.exceptionInfo;
-        NSInteger threadNum = maxThreadNum + 1;
-
-        /* Create the pseudo-thread header. We use the named thread format to mark this thread */
-        [text appendFormat: @"Thread %ld name:  Exception Backtrace\n", (long) threadNum];
-        [text appendFormat: @"Thread %ld:\n", (long) threadNum];
-
-        /* Write out the frames */
-        for (NSUInteger frame_idx = 0; frame_idx < [exception.stackFrames count]; frame_idx++) {
-            PLCrashReportStackFrameInfo *frameInfo = [exception.stackFrames objectAtIndex: frame_idx];
-            [text appendString: [self formatStackFrame: frameInfo frameIndex: frame_idx report: report]];
-        }
-        [text appendString: @"\n"];
-    }
-
-    /* Registers */
-    if (crashed_thread != nil) {
-        [text appendFormat: @"Thread %ld crashed with %@ Thread State:\n", (long) crashed_thread.threadNumber, codeType];
-        
-        int regColumn = 0;
-        for (PLCrashReportRegisterInfo *reg in crashed_thread.registers) {
-            NSString *reg_fmt;
-            
-            /* Use 32-bit or 64-bit fixed width format for the register values */
-            if (lp64)
-                reg_fmt = @"%6s: 0x%016" PRIx64 " ";
-            else
-                reg_fmt = @"%6s: 0x%08" PRIx64 " ";
-            
-            /* Remap register names to match Apple's crash reports */
-            NSString *regName = reg.registerName;
-            if (report.machineInfo != nil && report.machineInfo.processorInfo.typeEncoding == PLCrashReportProcessorTypeEncodingMach) {
-                PLCrashReportProcessorInfo *pinfo = report.machineInfo.processorInfo;
-                cpu_type_t arch_type = pinfo.type & ~CPU_ARCH_MASK;
-
-                /* Apple uses 'ip' rather than 'r12' on ARM */
-                if (arch_type == CPU_TYPE_ARM && [regName isEqual: @"r12"]) {
-                    regName = @"ip";
-                }
-            }
-            [text appendFormat: reg_fmt, [regName UTF8String], reg.registerValue];
-
-            regColumn++;
-            if (regColumn == 4) {
-                [text appendString: @"\n"];
-                regColumn = 0;
-            }
-        }
-        
-        if (regColumn != 0)
-            [text appendString: @"\n"];
-        
-        [text appendString: @"\n"];
+    plcrash_report_output_t output;
+    NSString *text;
+    size_t length;
+    char *buf;
+
+    /* Format in a single pass into a buffer owned by the returned string */
+    plcrash_report_output_init_buffer(&output, 0);
+    if (plcrash_report_write_text([report coreReport], (plcrash_report_text_format_t) textFormat, &output) != PLCRASH_ESUCCESS) {
+        plcrash_report_output_free(&output);
+        return nil;
     }
-    
-    /* Images. The iPhone crash report format sorts these in ascending order, by the base address */
-    [text appendString: @"Binary Images:\n"];
-    for (PLCrashReportBinaryImageInfo *imageInfo in [report.images sortedArrayUsingFunction: binaryImageSort context: nil]) {
-        NSString *uuid;
-        /* Fetch the UUID if it exists */
-        if (imageInfo.hasImageUUID)
-            uuid = imageInfo.imageUUID;
-        else
-            uuid = @"???";
-        
-        /* Determine the architecture string */
-        NSString *archName = @"???";
-        if (imageInfo.codeType != nil && imageInfo.codeType.typeEncoding == PLCrashReportProcessorTypeEncodingMach) {
-            switch (imageInfo.codeType.type) {
-                case CPU_TYPE_ARM:
-                    /* Apple includes subtype for ARM binaries. */
-                    switch (imageInfo.codeType.subtype) {
-                        case CPU_SUBTYPE_ARM_V6:
-                            archName = @"armv6";
-                            break;
-
-                        case CPU_SUBTYPE_ARM_V7:
-                            archName = @"armv7";
-                            break;
-                            
-                        case CPU_SUBTYPE_ARM_V7S:
-                            archName = @"armv7s";
-                            break;
-                            
-                        default:
-                            archName = @"arm-unknown";
-                            break;
-                    }
-                    break;
-                    
-                case CPU_TYPE_X86:
-                    archName = @"i386";
-                    break;
-                    
-                case CPU_TYPE_X86_64:
-                    archName = @"x86_64";
-                    break;
-
-                case CPU_TYPE_POWERPC:
-                    archName = @"powerpc";
-                    break;
 
-                default:
-                    // Use the default archName value (initialized above).
-                    break;
-            }
-        }
-
-        /* Determine if this is the main executable */
-        NSString *binaryDesignator = @" ";
-        if ([imageInfo.imageName isEqual: report.processInfo.processPath])
-            binaryDesignator = @"+";
-        
-        /* base_address - terminating_address [designator]file_name arch <uuid> file_path */
-        NSString *fmt = nil;
-        if (lp64) {
-            fmt = @"%18#" PRIx64 " - %18#" PRIx64 " %@%@ %@  <%@> %@\n";
-        } else {
-            fmt = @"%10#" PRIx64 " - %10#" PRIx64 " %@%@ %@  <%@> %@\n";
-        }
-
-        [text appendFormat: fmt,
-                            imageInfo.imageBaseAddress,
-                            imageInfo.imageBaseAddress + (MAX(1, imageInfo.imageSize) - 1), // The Apple format uses an inclusive range
-                            binaryDesignator,
-                            [imageInfo.imageName lastPathComponent],
-                            archName,
-                            uuid,
-                            imageInfo.imageName];
+    buf = plcrash_report_output_detach(&output, &length);
+    text = [[NSString alloc] initWithBytesNoCopy: buf length: length encoding: NSUTF8StringEncoding freeWhenDone: YES];
+    if (text == nil) {
+        free(buf);
+        return nil;
     }
-    
 
-    return text;
+    return [text autorelease];
 }
 
 /**
@@ -413,62 +96,93 @@ NSInteger binaryImageSort(id binary1, id binary2, void *context);
 
 // from PLCrashReportFormatter protocol
 - (NSData *) formatReport: (PLCrashReport *) report error: (NSError **) outError {
-    NSString *text = [PLCrashReportTextFormatter stringValueForCrashReport: report withTextFormat: _textFormat];
-    return [text dataUsingEncoding: _stringEncoding allowLossyConversion: YES];
-}
-		 
-@end
+    plcrash_report_output_t output;
+    plcrash_error_t err;
+    NSString *text;
+    size_t length;
+    char *buf;
+
+    /* Other encodings require transcoding through an NSString */
+    if (_stringEncoding != NSUTF8StringEncoding) {
+        text = [PLCrashReportTextFormatter stringValueForCrashReport: report withTextFormat: _textFormat];
+        return [text dataUsingEncoding: _stringEncoding allowLossyConversion: YES];
+    }
 
+    /* The formatter emits UTF-8; hand its buffer to the returned data without copying */
+    plcrash_report_output_init_buffer(&output, 0);
+    err = plcrash_report_write_text([report coreReport], (plcrash_report_text_format_t) _textFormat, &output);
+    if (err != PLCRASH_ESUCCESS) {
+        plcrash_report_output_free(&output);
+        if (err == PLCRASH_EINVAL)
+            populate_nserror(outError, PLCrashReporterErrorUnknown, @"Unsupported crash report text format", nil);
+        else
+            populate_nserror(outError, PLCrashReporterErrorUnknown, @"Could not allocate the crash report text buffer", nil);
+        return nil;
+    }
 
-@implementation PLCrashReportTextFormatter (PrivateMethods)
+    buf = plcrash_report_output_detach(&output, &length);
+    return [NSData dataWithBytesNoCopy: buf length: length freeWhenDone: YES];
+}
 
 /**
- * Format a stack frame for display in a thread backtrace.
+ * Format @a report and write the result to the file descriptor @a fd, without buffering the complete text
+ * in memory. The text is always UTF-8 encoded.
  *
- * @param frameInfo The stack frame to format
- * @param frameIndex The frame's index
- * @param report The report from which this frame was acquired.
+ * @param report The report to format.
+ * @param fd The file descriptor to write to. The descriptor is not closed.
+ * @param outError If an error occurs, this pointer will contain an NSError object indicating why the report
+ * could not be written. If no error occurs, this parameter will be left unmodified. You may specify NULL for
+ * this parameter, and no error information will be provided.
  *
- * @return Returns a formatted frame line.
+ * @return Returns YES on success, or NO if the report could not be written.
  */
-+ (NSString *) formatStackFrame: (PLCrashReportStackFrameInfo *) frameInfo 
-                     frameIndex: (NSUInteger) frameIndex
-                         report: (PLCrashReport *) report
-{
-    /* Base image address containing instrumention pointer, offset of the IP from that base
-     * address, and the associated image name */
-    uint64_t baseAddress = 0x0;
-    uint64_t pcOffset = 0x0;
-    NSString *imageName = @"\?\?\?";
-    
-    PLCrashReportBinaryImageInfo *imageInfo = [report imageForAddress: frameInfo.instructionPointer];
-    if (imageInfo != nil) {
-        imageName = [imageInfo.imageName lastPathComponent];
-        baseAddress = imageInfo.imageBaseAddress;
-        pcOffset = frameInfo.instructionPointer - imageInfo.imageBaseAddress;
+- (BOOL) writeReport: (PLCrashReport *) report toFileDescriptor: (int) fd error: (NSError **) outError {
+    plcrash_report_output_t output;
+    char buffer[16384];
+    plcrash_error_t err;
+
+    plcrash_report_output_init_fd(&output, fd, buffer, sizeof(buffer));
+    err = plcrash_report_write_text([report coreReport], (plcrash_report_text_format_t) _textFormat, &output);
+    if (err == PLCRASH_OUTPUT_ERR) {
+        NSError *cause = [NSError errorWithDomain: NSPOSIXErrorDomain code: output.errnum userInfo: nil];
+        populate_nserror(outError, PLCrashReporterErrorOperatingSystem, @"Could not write the crash report text", cause);
+        return NO;
+    } else if (err != PLCRASH_ESUCCESS) {
+        populate_nserror(outError, PLCrashReporterErrorUnknown, @"Could not format the crash report text", nil);
+        return NO;
     }
-    
-    return [NSString stringWithFormat: @"%-4ld%-36s0x%08" PRIx64 " 0x%" PRIx64 " + %" PRId64 "\n", 
-            (long) frameIndex,
-            [imageName UTF8String],
-            frameInfo.instructionPointer, 
-            baseAddress, 
-            pcOffset];
+
+    return YES;
 }
 
+@end
+
 /**
- * Sort PLCrashReportBinaryImageInfo instances by their starting address.
+ * @internal
+ *
+ * Populate an NSError instance with the provided information.
+ *
+ * @param error Error instance to populate. If NULL, this method returns
+ * and nothing is modified.
+ * @param code The error code corresponding to this error.
+ * @param description A localized error description.
+ * @param cause The underlying cause, if any. May be nil.
  */
-NSInteger binaryImageSort(id binary1, id binary2, void *context) {
-    uint64_t addr1 = [binary1 imageBaseAddress];
-    uint64_t addr2 = [binary2 imageBaseAddress];
+static void populate_nserror (NSError **error, PLCrashReporterError code, NSString *description, NSError *cause) {
+    NSMutableDictionary *userInfo;
     
-    if (addr1 < addr2)
-        return NSOrderedAscending;
-    else if (addr1 > addr2)
-        return NSOrderedDescending;
-    else
-        return NSOrderedSame;
-}
+    if (error == NULL)
+        return;
+    
+    /* Create the userInfo dictionary */
+    userInfo = [NSMutableDictionary dictionaryWithObjectsAndKeys:
+                description, NSLocalizedDescriptionKey,
+                nil
+                ];
 
-@end
+    /* Add the cause, if available */
+    if (cause != nil)
+        [userInfo setObject: cause forKey: NSUnderlyingErrorKey];
+    
+    *error = [NSError errorWithDomain: PLCrashReporterErrorDomain code: code userInfo: userInfo];
+}
@@ -68,6 +68,30 @@
 @end
 
 
+@interface PLCrashReportStackMemoryInfo : NSObject {
+@private
+    /** Address of the first captured byte */
+    uint64_t _baseAddress;
+
+    /** Captured bytes */
+    NSData *_contents;
+}
+
+- (id) initWithBaseAddress: (uint64_t) baseAddress contents: (NSData *) contents;
+
+/**
+ * Address of the first captured byte.
+ */
+@property(nonatomic, readonly) uint64_t baseAddress;
+
+/**
+ * Captured stack memory.
+ */
+@property(nonatomic, readonly) NSData *contents;
+
+@end
+
+
 @interface PLCrashReportThreadInfo : NSObject {
 @private
     /** The thread number. Should be unique within a given crash log. */
@@ -81,6 +105,9 @@
 
     /** List of PLCrashReportRegister instances. Will be empty if _crashed is NO. */
     NSArray *_registers;
+
+    /** List of PLCrashReportStackMemoryInfo instances. */
+    NSArray *_stackMemory;
 }
 
 - (id) initWithThreadNumber: (NSInteger) threadNumber
@@ -88,6 +115,12 @@
                     crashed: (BOOL) crashed
                   registers: (NSArray *) registers;
 
+- (id) initWithThreadNumber: (NSInteger) threadNumber
+                stackFrames: (NSArray *) stackFrames
+                    crashed: (BOOL) crashed
+                  registers: (NSArray *) registers
+                stackMemory: (NSArray *) stackMemory;
+
 /**
  * Application thread number.
  */
@@ -111,4 +144,11 @@
  */
 @property(nonatomic, readonly) NSArray *registers;
 
+/**
+ * Raw stack memory captured around the thread's stack pointer, as a list of
+ * PLCrashReportStackMemoryInfo instances, ordered by ascending address. This list will
+ * be empty if stack memory capture was not enabled for this thread.
+ */
+@property(nonatomic, readonly) NSArray *stackMemory;
+
 @end
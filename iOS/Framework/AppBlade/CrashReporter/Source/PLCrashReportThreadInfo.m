@@ -42,6 +42,18 @@
                 stackFrames: (NSArray *) stackFrames
                     crashed: (BOOL) crashed
                   registers: (NSArray *) registers
+{
+    return [self initWithThreadNumber: threadNumber stackFrames: stackFrames crashed: crashed registers: registers stackMemory: [NSArray array]];
+}
+
+/**
+ * Initialize the crash log thread information, including captured stack memory.
+ */
+- (id) initWithThreadNumber: (NSInteger) threadNumber
+                stackFrames: (NSArray *) stackFrames
+                    crashed: (BOOL) crashed
+                  registers: (NSArray *) registers
+                stackMemory: (NSArray *) stackMemory
 {
     if ((self = [super init]) == nil)
         return nil;
@@ -50,6 +62,7 @@
     _stackFrames = [stackFrames retain];
     _crashed = crashed;
     _registers = [registers retain];
+    _stackMemory = [stackMemory retain];
 
     return self;
 }
@@ -57,6 +70,7 @@
 - (void) dealloc {
     [_stackFrames release];
     [_registers release];
+    [_stackMemory release];
     [super dealloc];
 }
 
@@ -64,6 +78,7 @@
 @synthesize stackFrames = _stackFrames;
 @synthesize crashed = _crashed;
 @synthesize registers = _registers;
+@synthesize stackMemory = _stackMemory;
 
 
 @end
@@ -118,3 +133,32 @@
 @synthesize registerValue = _registerValue;
 
 @end
+
+
+/**
+ * Crash log raw stack memory.
+ */
+@implementation PLCrashReportStackMemoryInfo
+
+/**
+ * Initialize with the provided base address and contents.
+ */
+- (id) initWithBaseAddress: (uint64_t) baseAddress contents: (NSData *) contents {
+    if ((self = [super init]) == nil)
+        return nil;
+
+    _baseAddress = baseAddress;
+    _contents = [contents retain];
+
+    return self;
+}
+
+- (void) dealloc {
+    [_contents release];
+    [super dealloc];
+}
+
+@synthesize baseAddress = _baseAddress;
+@synthesize contents = _contents;
+
+@end
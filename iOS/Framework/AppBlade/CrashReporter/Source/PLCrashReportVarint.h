@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2008-2011 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef PLCRASH_REPORT_VARINT_H
+#define PLCRASH_REPORT_VARINT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * @internal
+ *
+ * @defgroup plcrash_varint Varint Decoding
+ * @ingroup plcrash_internal
+ *
+ * Base-128 varint decoding for the crash report decoder.
+ *
+ * Frame PCs, register values and image addresses are encoded as five to eight byte varints, and make
+ * up the bulk of a crash report. Rather than testing each byte's continuation bit in turn,
+ * plcrash_varint_decode() loads eight bytes as a single word, locates the terminating byte from the
+ * inverted continuation bits, and gathers the 7-bit groups with three mask-and-shift steps. Values of
+ * nine or ten bytes, and values within eight bytes of the end of the buffer, use the scalar decoder.
+ *
+ * @{
+ */
+
+/** The continuation bit of every byte in a 64-bit word */
+#define PLCRASH_VARINT_CONTINUATION_MASK 0x8080808080808080ULL
+
+/**
+ * Decode a varint one byte at a time.
+ *
+ * @param pos On input, the start of the varint. On success, updated to point past the varint.
+ * @param end The end of the readable buffer.
+ * @param value On success, the decoded value.
+ *
+ * @return Returns false if the varint is truncated or longer than ten bytes.
+ */
+static inline bool plcrash_varint_decode_scalar (const uint8_t **pos, const uint8_t *end, uint64_t *value) {
+    const uint8_t *p = *pos;
+    uint64_t result = 0;
+    unsigned shift;
+
+    for (shift = 0; shift < 64 && p < end; shift += 7) {
+        uint8_t b = *p++;
+        result |= ((uint64_t) (b & 0x7F)) << shift;
+        if ((b & 0x80) == 0) {
+            *value = result;
+            *pos = p;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Decode a varint, reading up to eight bytes per step where the buffer allows.
+ *
+ * @param pos On input, the start of the varint. On success, updated to point past the varint.
+ * @param end The end of the readable buffer.
+ * @param value On success, the decoded value.
+ *
+ * @return Returns false if the varint is truncated or longer than ten bytes.
+ */
+static inline bool plcrash_varint_decode (const uint8_t **pos, const uint8_t *end, uint64_t *value) {
+    const uint8_t *p = *pos;
+
+    /* Single byte values (tags, small integers, short lengths) are by far the most common */
+    if (p < end && (*p & 0x80) == 0) {
+        *value = *p;
+        *pos = p + 1;
+        return true;
+    }
+
+#if __LITTLE_ENDIAN__
+    if (end - p >= 8) {
+        uint64_t word;
+        uint64_t stop;
+
+        memcpy(&word, p, sizeof(word));
+
+        /* The first byte with its continuation bit clear terminates the value */
+        stop = ~word & PLCRASH_VARINT_CONTINUATION_MASK;
+        if (stop != 0) {
+            /* Bit index of the terminator's high bit, plus one; always a multiple of 8 */
+            unsigned bits = __builtin_ctzll(stop) + 1;
+
+            if (bits < 64)
+                word &= (1ULL << bits) - 1;
+            word &= ~PLCRASH_VARINT_CONTINUATION_MASK;
+
+            /* Gather the 7-bit groups: 8x7 -> 4x14 -> 2x28 -> 1x56 */
+            word = ((word & 0x7F007F007F007F00ULL) >> 1) | (word & 0x007F007F007F007FULL);
+            word = ((word & 0x3FFF00003FFF0000ULL) >> 2) | (word & 0x00003FFF00003FFFULL);
+            word = ((word & 0x0FFFFFFF00000000ULL) >> 4) | (word & 0x000000000FFFFFFFULL);
+
+            *value = word;
+            *pos = p + (bits / 8);
+            return true;
+        }
+    }
+#endif
+
+    return plcrash_varint_decode_scalar(pos, end, value);
+}
+
+/**
+ * @} plcrash_varint
+ */
+
+#endif /* PLCRASH_REPORT_VARINT_H */
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2008-2011 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#import "GTMSenTestCase.h"
+
+#import "PLCrashReportVarint.h"
+
+@interface PLCrashReportVarintTests : SenTestCase @end
+
+/* Encode a varint, returning the encoded length */
+static size_t encode_varint (uint64_t value, uint8_t *buf) {
+    size_t length = 0;
+    do {
+        buf[length++] = (value & 0x7F) | (value > 0x7F ? 0x80 : 0);
+        value >>= 7;
+    } while (value != 0);
+    return length;
+}
+
+@implementation PLCrashReportVarintTests
+
+/* Every encoded length must decode identically with both decoders, with and without trailing data */
+- (void) testDecodeLengths {
+    uint8_t buf[32];
+
+    for (unsigned bits = 0; bits <= 64; bits++) {
+        uint64_t value = bits == 0 ? 0 : (bits == 64 ? UINT64_MAX : ((1ULL << bits) - 1));
+        size_t length = encode_varint(value, buf);
+        memset(buf + length, 0x80, sizeof(buf) - length);
+
+        for (size_t available = length; available <= sizeof(buf); available += sizeof(buf) - length) {
+            const uint8_t *pos = buf;
+            const uint8_t *scalar_pos = buf;
+            uint64_t result = 0;
+            uint64_t scalar_result = 0;
+
+            STAssertTrue(plcrash_varint_decode(&pos, buf + available, &result), @"Failed to decode %u bit value", bits);
+            STAssertTrue(plcrash_varint_decode_scalar(&scalar_pos, buf + available, &scalar_result), @"Failed to decode %u bit value", bits);
+            STAssertEquals(value, result, @"Incorrect value for %u bit value", bits);
+            STAssertEquals(value, scalar_result, @"Incorrect scalar value for %u bit value", bits);
+            STAssertEquals((ptrdiff_t) length, pos - buf, @"Incorrect length for %u bit value", bits);
+            STAssertEquals(pos, scalar_pos, @"Decoders consumed different lengths");
+        }
+    }
+}
+
+/* Truncated and over-long values must be rejected */
+- (void) testDecodeInvalid {
+    uint8_t buf[16];
+    const uint8_t *pos;
+    uint64_t value;
+
+    /* Truncated five byte value, with and without following data */
+    size_t length = encode_varint(0x7fff5fbff8a0ULL, buf);
+    pos = buf;
+    STAssertFalse(plcrash_varint_decode(&pos, buf + length - 1, &value), @"Truncated value was decoded");
+    STAssertEquals((const uint8_t *) buf, pos, @"Position advanced on failure");
+
+    /* Eleven continuation bytes */
+    memset(buf, 0x80, sizeof(buf));
+    pos = buf;
+    STAssertFalse(plcrash_varint_decode(&pos, buf + sizeof(buf), &value), @"Over-long value was decoded");
+    STAssertEquals((const uint8_t *) buf, pos, @"Position advanced on failure");
+
+    /* Empty input */
+    pos = buf;
+    STAssertFalse(plcrash_varint_decode(&pos, buf, &value), @"Empty input was decoded");
+}
+
+@end
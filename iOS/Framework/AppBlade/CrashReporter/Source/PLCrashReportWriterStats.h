@@ -0,0 +1,168 @@
+/*
+ * Author: Landon Fuller <landonf@plausiblelabs.com>
+ *
+ * Copyright (c) 2008-2011 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+
+/** Writer statistics section key for CrashReport.system_info */
+extern NSString * const PLCrashReportWriterStatsSectionSystemInfo;
+
+/** Writer statistics section key for CrashReport.machine_info */
+extern NSString * const PLCrashReportWriterStatsSectionMachineInfo;
+
+/** Writer statistics section key for CrashReport.application_info */
+extern NSString * const PLCrashReportWriterStatsSectionApplicationInfo;
+
+/** Writer statistics section key for CrashReport.process_info */
+extern NSString * const PLCrashReportWriterStatsSectionProcessInfo;
+
+/** Writer statistics section key for CrashReport.threads */
+extern NSString * const PLCrashReportWriterStatsSectionThreads;
+
+/** Writer statistics section key for CrashReport.binary_images */
+extern NSString * const PLCrashReportWriterStatsSectionBinaryImages;
+
+/** Writer statistics section key for CrashReport.exception */
+extern NSString * const PLCrashReportWriterStatsSectionException;
+
+/** Writer statistics section key for CrashReport.signal */
+extern NSString * const PLCrashReportWriterStatsSectionSignal;
+
+
+@interface PLCrashReportWriterThreadStats : NSObject {
+@private
+    /** Thread number */
+    NSInteger _threadNumber;
+
+    /** Time spent suspending the thread, in nanoseconds */
+    uint64_t _suspendTime;
+
+    /** Time spent walking the thread's stack, in nanoseconds */
+    uint64_t _walkTime;
+
+    /** Time spent writing the thread, in nanoseconds */
+    uint64_t _writeTime;
+
+    /** True if the backtrace was truncated at the frame limit */
+    BOOL _truncated;
+}
+
+- (id) initWithThreadNumber: (NSInteger) threadNumber
+                suspendTime: (uint64_t) suspendTime
+                   walkTime: (uint64_t) walkTime
+                  writeTime: (uint64_t) writeTime
+                  truncated: (BOOL) truncated;
+
+/**
+ * The thread number. Matches PLCrashReportThreadInfo::threadNumber.
+ */
+@property(nonatomic, readonly) NSInteger threadNumber;
+
+/**
+ * Time spent suspending the thread, in nanoseconds.
+ */
+@property(nonatomic, readonly) uint64_t suspendTime;
+
+/**
+ * Time spent walking the thread's stack, in nanoseconds.
+ */
+@property(nonatomic, readonly) uint64_t walkTime;
+
+/**
+ * Time spent walking the thread's stack and writing the thread, in nanoseconds.
+ */
+@property(nonatomic, readonly) uint64_t writeTime;
+
+/**
+ * YES if the thread's backtrace was truncated at the per-thread frame limit.
+ */
+@property(nonatomic, readonly) BOOL truncated;
+
+@end
+
+
+@interface PLCrashReportWriterStats : NSObject {
+@private
+    /** Per-thread statistics (PLCrashReportWriterThreadStats instances) */
+    NSArray *_threadStats;
+
+    /** Total write time, in nanoseconds */
+    uint64_t _totalTime;
+
+    /** Binary image write time, in nanoseconds */
+    uint64_t _imageTime;
+
+    /** Number of failed memory reads */
+    uint32_t _readFailures;
+
+    /** Number of truncated backtraces */
+    uint32_t _truncatedThreads;
+
+    /** Bytes emitted per section */
+    NSDictionary *_sectionBytes;
+}
+
+- (id) initWithThreadStats: (NSArray *) threadStats
+                 totalTime: (uint64_t) totalTime
+                 imageTime: (uint64_t) imageTime
+              readFailures: (uint32_t) readFailures
+          truncatedThreads: (uint32_t) truncatedThreads
+              sectionBytes: (NSDictionary *) sectionBytes;
+
+/**
+ * Per-thread writer statistics. Returns a list of PLCrashReportWriterThreadStats instances. This list
+ * may be incomplete for processes with a large number of threads.
+ */
+@property(nonatomic, readonly) NSArray *threadStats;
+
+/**
+ * Total time spent writing the crash report, in nanoseconds.
+ */
+@property(nonatomic, readonly) uint64_t totalTime;
+
+/**
+ * Time spent writing binary images, in nanoseconds.
+ */
+@property(nonatomic, readonly) uint64_t imageTime;
+
+/**
+ * Number of failed memory reads while writing the crash report.
+ */
+@property(nonatomic, readonly) uint32_t readFailures;
+
+/**
+ * Number of threads whose backtrace was truncated at the per-thread frame limit.
+ */
+@property(nonatomic, readonly) uint32_t truncatedThreads;
+
+/**
+ * Bytes emitted per report section, as a dictionary of NSNumber values keyed by the
+ * PLCrashReportWriterStatsSection constants.
+ */
+@property(nonatomic, readonly) NSDictionary *sectionBytes;
+
+@end
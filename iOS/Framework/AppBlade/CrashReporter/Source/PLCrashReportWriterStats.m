@@ -0,0 +1,118 @@
+/*
+ * Author: Landon Fuller <landonf@plausiblelabs.com>
+ *
+ * Copyright (c) 2008-2011 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "PLCrashReportWriterStats.h"
+
+NSString * const PLCrashReportWriterStatsSectionSystemInfo = @"system_info";
+NSString * const PLCrashReportWriterStatsSectionMachineInfo = @"machine_info";
+NSString * const PLCrashReportWriterStatsSectionApplicationInfo = @"application_info";
+NSString * const PLCrashReportWriterStatsSectionProcessInfo = @"process_info";
+NSString * const PLCrashReportWriterStatsSectionThreads = @"threads";
+NSString * const PLCrashReportWriterStatsSectionBinaryImages = @"binary_images";
+NSString * const PLCrashReportWriterStatsSectionException = @"exception";
+NSString * const PLCrashReportWriterStatsSectionSignal = @"signal";
+
+
+/**
+ * Provides the crash log writer's per-thread statistics.
+ */
+@implementation PLCrashReportWriterThreadStats
+
+/**
+ * Initialize with the provided thread statistics.
+ */
+- (id) initWithThreadNumber: (NSInteger) threadNumber
+                suspendTime: (uint64_t) suspendTime
+                   walkTime: (uint64_t) walkTime
+                  writeTime: (uint64_t) writeTime
+                  truncated: (BOOL) truncated
+{
+    if ((self = [super init]) == nil)
+        return nil;
+
+    _threadNumber = threadNumber;
+    _suspendTime = suspendTime;
+    _walkTime = walkTime;
+    _writeTime = writeTime;
+    _truncated = truncated;
+
+    return self;
+}
+
+@synthesize threadNumber = _threadNumber;
+@synthesize suspendTime = _suspendTime;
+@synthesize walkTime = _walkTime;
+@synthesize writeTime = _writeTime;
+@synthesize truncated = _truncated;
+
+@end
+
+
+/**
+ * Provides the crash log writer's self-instrumentation, as recorded at the time the
+ * crash report was written.
+ */
+@implementation PLCrashReportWriterStats
+
+/**
+ * Initialize with the provided writer statistics.
+ */
+- (id) initWithThreadStats: (NSArray *) threadStats
+                 totalTime: (uint64_t) totalTime
+                 imageTime: (uint64_t) imageTime
+              readFailures: (uint32_t) readFailures
+          truncatedThreads: (uint32_t) truncatedThreads
+              sectionBytes: (NSDictionary *) sectionBytes
+{
+    if ((self = [super init]) == nil)
+        return nil;
+
+    _threadStats = [threadStats retain];
+    _totalTime = totalTime;
+    _imageTime = imageTime;
+    _readFailures = readFailures;
+    _truncatedThreads = truncatedThreads;
+    _sectionBytes = [sectionBytes retain];
+
+    return self;
+}
+
+- (void) dealloc {
+    [_threadStats release];
+    [_sectionBytes release];
+    [super dealloc];
+}
+
+@synthesize threadStats = _threadStats;
+@synthesize totalTime = _totalTime;
+@synthesize imageTime = _imageTime;
+@synthesize readFailures = _readFailures;
+@synthesize truncatedThreads = _truncatedThreads;
+@synthesize sectionBytes = _sectionBytes;
+
+@end
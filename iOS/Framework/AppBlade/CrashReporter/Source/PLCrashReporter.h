@@ -77,6 +77,24 @@ typedef struct PLCrashReporterCallbacks {
 
     /** Path to the crash reporter internal data directory */
     NSString *_crashReportDirectory;
+
+    /** Number of stack bytes to capture above the stack pointer, or 0 if stack capture is disabled */
+    uint32_t _stackMemoryWindow;
+
+    /** YES if stack memory should be captured for all threads */
+    BOOL _stackMemoryAllThreads;
+
+    /** YES if crash reports should be written in prioritized order */
+    BOOL _prioritizedWrite;
+
+    /** Prioritized write deadline, in seconds, or 0 if unlimited */
+    NSTimeInterval _prioritizedWriteDeadline;
+
+    /** YES if crash reports should include writer statistics */
+    BOOL _writerStatsEnabled;
+
+    /** YES once the crash report store has been opened */
+    BOOL _reportStoreOpen;
 }
 
 + (PLCrashReporter *) sharedReporter;
@@ -94,7 +112,9 @@ typedef struct PLCrashReporterCallbacks {
 - (BOOL) enableCrashReporterAndReturnError: (NSError **) outError;
 
 - (void) setCrashCallbacks: (PLCrashReporterCallbacks *) callbacks;
-- (NSString *) saveCrashReportInQueue:(NSString*)reportString;
-- (NSString *) getNextCrashReportPath;
+- (void) setStackMemoryCaptureWindow: (uint32_t) windowBytes allThreads: (BOOL) allThreads;
+- (void) enablePrioritizedWriteWithDeadline: (NSTimeInterval) deadline;
+- (void) setWriterStatsEnabled: (BOOL) enabled;
+- (NSArray *) queuedCrashReportPaths;
 
 @end
\ No newline at end of file
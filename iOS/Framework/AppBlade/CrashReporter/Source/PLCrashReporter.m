@@ -32,6 +32,7 @@
 
 #import "PLCrashAsync.h"
 #import "PLCrashLogWriter.h"
+#import "PLCrashReportStore.h"
 
 #import <fcntl.h>
 #import <mach-o/dyld.h>
@@ -40,21 +41,24 @@
     NSLog(@"[PLCrashReporter] " msg, ## args); \
 }
 
+static void populate_nserror (NSError **error, PLCrashReporterError code, NSString *description);
+
 /** @internal
  * CrashReporter cache directory name. */
 static NSString *PLCRASH_CACHE_DIR = @"com.plausiblelabs.crashreporter.data";
 
 /** @internal
- * Crash Report file name. */
+ * Crash report store file name. */
+static NSString *PLCRASH_REPORT_STORE = @"reports.store";
+
+/** @internal
+ * Crash Report file name used by earlier versions, imported into the report store. */
 static NSString *PLCRASH_LIVE_CRASHREPORT = @"live_report.plcrash";
 
 /** @internal
- * Directory containing crash reports queued for sending. */
+ * Directory containing crash reports queued for sending by earlier versions. */
 static NSString *PLCRASH_QUEUED_DIR = @"queued_reports";
 
-
-static NSString *s_letters = @"abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
-
 /** @internal
  * Maximum number of bytes that will be written to the crash report.
  * Used as a safety measure in case of implementation malfunction.
@@ -64,7 +68,23 @@ static NSString *s_letters = @"abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVW
  */
 #define MAX_REPORT_BYTES (64 * 1024)
 
-#define QUEUED_FILE_NAMELENGTH 13
+/** @internal
+ * Maximum number of raw stack bytes that will be written to the crash report when
+ * stack memory capture is enabled. Kept to a fraction of MAX_REPORT_BYTES so that
+ * the remainder of the report is never crowded out.
+ */
+#define MAX_STACK_MEMORY_BYTES (16 * 1024)
+
+/** @internal
+ * Number of bytes captured below the stack pointer. This covers the x86-64 ABI red zone.
+ */
+#define STACK_MEMORY_RED_ZONE_BYTES 128
+
+/** @internal
+ * Byte budget used for prioritized crash report output. The crashed thread and its images are always
+ * written; this leaves headroom for them (and the truncation record) below MAX_REPORT_BYTES.
+ */
+#define PRIORITIZED_REPORT_BYTES (MAX_REPORT_BYTES - (8 * 1024))
 
 /**
  * @internal
@@ -81,8 +101,8 @@ typedef struct signal_handler_ctx {
     /** PLCrashLogWriter instance */
     plcrash_log_writer_t writer;
 
-    /** Path to the output file */
-    const char *path;
+    /** Report store, to which the crash report is written */
+    plcrash_report_store_t store;
 } plcrashreporter_handler_ctx_t;
 
 
@@ -114,23 +134,23 @@ static void signal_handler_callback (int signal, siginfo_t *info, ucontext_t *ua
     plcrashreporter_handler_ctx_t *sigctx = context;
     plcrash_async_file_t file;
     
-    /* Open the output file */
-    int fd = open(sigctx->path, O_RDWR|O_CREAT|O_TRUNC, 0644);
-    if (fd < 0) {
-        PLCF_DEBUG("Could not open the crashlog output file: %s", strerror(errno));
+    /* Write directly to the next slot of the report store */
+    if (plcrash_report_store_begin(&sigctx->store, &file) != PLCRASH_ESUCCESS) {
+        PLCF_DEBUG("Could not open the crash report store slot: %s", strerror(errno));
         return;
     }
 
-    /* Initialize the output context */
-    plcrash_async_file_init(&file, fd, MAX_REPORT_BYTES);
-
     /* Write the crash log using the already-initialized writer */
-    plcrash_log_writer_write(&sigctx->writer, &file, info, uap);
+    plcrash_error_t err = plcrash_log_writer_write(&sigctx->writer, &file, info, uap);
     plcrash_log_writer_close(&sigctx->writer);
 
-    /* Finished */
-    plcrash_async_file_flush(&file);
-    plcrash_async_file_close(&file);
+    /* Finished; the store's file is left open. An incomplete report is never committed. */
+    if (err != PLCRASH_ESUCCESS) {
+        PLCF_DEBUG("Could not write the crash report: %s", plcrash_strerror(err));
+        plcrash_report_store_abort(&sigctx->store);
+    } else if (plcrash_report_store_commit(&sigctx->store, &file) != PLCRASH_ESUCCESS) {
+        PLCF_DEBUG("Could not commit the crash report: %s", strerror(errno));
+    }
 
     /* Call any post-crash callback */
     if (crashCallbacks.handleSignal != NULL)
@@ -184,13 +204,12 @@ static void uncaught_exception_handler (NSException *exception) {
 
 
 - (NSString *) crashReportPath;
+- (NSString *) reportStorePath;
+- (BOOL) openReportStoreAndReturnError: (NSError **) outError;
 
 - (NSString *) queuedCrashReportDirectory;
 - (NSArray *) queuedCrashReportFiles;
 
-- (NSString *) makeRandomFileName;
-- (NSString *) randomString: (int) len;
-
 @end
 
 
@@ -215,11 +234,11 @@ static void uncaught_exception_handler (NSException *exception) {
  * an pending crash report is available.
  */
 - (BOOL) hasPendingCrashReport {
-    /* Check for a live crash report file */
-    if(![[NSFileManager defaultManager] fileExistsAtPath: [self crashReportPath]]){
-        return ([self hasQueuedCrashReports]); //check queue
-    }
-    return YES;
+    /* Check the report store, and any reports queued by earlier versions */
+    if ([self openReportStoreAndReturnError: NULL] && plcrash_report_store_count(&signal_handler_context.store) > 0)
+        return YES;
+
+    return [self hasQueuedCrashReports];
 }
 
 
@@ -239,7 +258,8 @@ static void uncaught_exception_handler (NSException *exception) {
 
 /**
  * If an application has a pending crash report, this method returns the crash
- * report data.
+ * report data. If more than one report is pending, the oldest is returned; once
+ * it is purged, the next is returned.
  *
  * You may use this to submit the report to your own HTTP server, over e-mail, or even parse and
  * introspect the report locally using the PLCrashReport API.
@@ -252,8 +272,19 @@ static void uncaught_exception_handler (NSException *exception) {
  * @return Returns nil if the crash report data could not be loaded.
  */
 - (NSData *) loadPendingCrashReportDataAndReturnError: (NSError **) outError {
-    /* Load the (memory mapped) data */
-    return [NSData dataWithContentsOfFile: [self crashReportPath] options: NSMappedRead error: outError];
+    const void *data;
+    size_t length;
+
+    if (![self openReportStoreAndReturnError: outError])
+        return nil;
+
+    /* Copy the report out of the store mapping; its slot may be reused once it is purged */
+    if (!plcrash_report_store_peek(&signal_handler_context.store, &data, &length)) {
+        populate_nserror(outError, PLCrashReporterErrorUnknown, @"No pending crash report is available");
+        return nil;
+    }
+
+    return [NSData dataWithBytes: data length: length];
 }
 
 
@@ -268,12 +299,17 @@ static void uncaught_exception_handler (NSException *exception) {
 
 
 /**
- * Purge a pending crash report. Put the next queued crashreport in the pending crash report.
+ * Purge the pending crash report returned by PLCrashReporter::loadPendingCrashReportData, releasing its slot in
+ * the report store. The next pending crash report, if any, becomes available.
  *
  * @return Returns YES on success, or NO on error.
  */
 - (BOOL) purgePendingCrashReportAndReturnError: (NSError **) outError {
-    return  [[NSFileManager defaultManager] removeItemAtPath: [self crashReportPath] error: outError];
+    if (![self openReportStoreAndReturnError: outError])
+        return NO;
+
+    plcrash_report_store_acknowledge(&signal_handler_context.store);
+    return YES;
 }
 
 
@@ -310,15 +346,32 @@ static void uncaught_exception_handler (NSException *exception) {
     if (_enabled)
         [NSException raise: PLCrashReporterException format: @"The crash reporter has alread been enabled"];
 
-    /* Create the directory tree */
-    if (![self populateCrashReportDirectoryAndReturnError: outError])
+    /* Open the report store, creating the directory tree if necessary */
+    if (![self openReportStoreAndReturnError: outError])
         return NO;
 
     /* Set up the signal handler context */
-    signal_handler_context.path = strdup([[self crashReportPath] UTF8String]); // NOTE: would leak if this were not a singleton struct
     assert(_applicationIdentifier != nil);
     assert(_applicationVersion != nil);
     plcrash_log_writer_init(&signal_handler_context.writer, _applicationIdentifier, _applicationVersion);
+
+    /* Configure prioritized output */
+    if (_prioritizedWrite)
+        plcrash_log_writer_set_priority(&signal_handler_context.writer, (uint32_t) (_prioritizedWriteDeadline * 1000.0), PRIORITIZED_REPORT_BYTES);
+
+    /* Configure writer statistics */
+    if (_writerStatsEnabled)
+        plcrash_log_writer_set_stats_enabled(&signal_handler_context.writer, true);
+
+    /* Configure stack memory capture */
+    if (_stackMemoryWindow > 0) {
+        plcrash_error_t err;
+
+        err = plcrash_log_writer_set_stack_capture(&signal_handler_context.writer, STACK_MEMORY_RED_ZONE_BYTES, _stackMemoryWindow,
+                                                   _stackMemoryAllThreads, MAX_STACK_MEMORY_BYTES);
+        if (err != PLCRASH_ESUCCESS)
+            NSDEBUG(@"Could not enable stack memory capture: %s", plcrash_strerror(err));
+    }
     
     /* Enable dyld image monitoring */
     _dyld_register_func_for_add_image(image_add_callback);
@@ -362,6 +415,74 @@ static void uncaught_exception_handler (NSException *exception) {
     crashCallbacks.handleSignal = callbacks->handleSignal;
 }
 
+/**
+ * Enable capture of raw stack memory surrounding the crashed thread's stack pointer. The captured memory
+ * may be used to recover local variables, or to unwind code compiled without frame pointers.
+ *
+ * The total amount of stack memory written to a single report is capped, regardless of the window size
+ * or number of threads.
+ *
+ * @param windowBytes Number of bytes to capture at and above the stack pointer. Pass 0 to disable capture.
+ * @param allThreads If YES, stack memory will be captured for all threads, rather than just the crashed thread.
+ *
+ * @note This method must be called prior to PLCrashReporter::enableCrashReporter or
+ * PLCrashReporter::enableCrashReporterAndReturnError:
+ */
+- (void) setStackMemoryCaptureWindow: (uint32_t) windowBytes allThreads: (BOOL) allThreads {
+    /* Check for programmer error; the writer configuration must not change once the signal handler is enabled. */
+    if (_enabled)
+        [NSException raise: PLCrashReporterException format: @"The crash reporter has alread been enabled"];
+
+    _stackMemoryWindow = windowBytes;
+    _stackMemoryAllThreads = allThreads;
+}
+
+/**
+ * Write crash reports in priority order. The signal, exception, crashed thread, and the binary images
+ * referenced by the crashed thread are written first; the remaining threads and images are then written
+ * until either @a deadline elapses or the report approaches its size limit. Any omissions are recorded
+ * in the crash report.
+ *
+ * This allows a usable report to be produced even if the process is terminated (eg, by a watchdog)
+ * before crash handling completes.
+ *
+ * @param deadline Maximum time to spend writing the remaining threads and images, in seconds. Pass 0 for no
+ * time limit.
+ *
+ * @note This method must be called prior to PLCrashReporter::enableCrashReporter or
+ * PLCrashReporter::enableCrashReporterAndReturnError:
+ */
+- (void) enablePrioritizedWriteWithDeadline: (NSTimeInterval) deadline {
+    /* Check for programmer error; the writer configuration must not change once the signal handler is enabled. */
+    if (_enabled)
+        [NSException raise: PLCrashReporterException format: @"The crash reporter has alread been enabled"];
+
+    _prioritizedWrite = YES;
+    _prioritizedWriteDeadline = deadline;
+}
+
+/**
+ * Include crash log writer statistics in written crash reports. The statistics record the time spent
+ * suspending, walking and writing each thread, the time spent writing binary images, the number of failed
+ * memory reads and dropped frames, and the number of bytes emitted per report section. They are available
+ * via PLCrashReport::writerStats.
+ *
+ * @param enabled If YES, writer statistics will be written.
+ *
+ * @note This method must be called prior to PLCrashReporter::enableCrashReporter or
+ * PLCrashReporter::enableCrashReporterAndReturnError:
+ */
+- (void) setWriterStatsEnabled: (BOOL) enabled {
+    /* Check for programmer error; the writer configuration must not change once the signal handler is enabled. */
+    if (_enabled)
+        [NSException raise: PLCrashReporterException format: @"The crash reporter has alread been enabled"];
+
+    _writerStatsEnabled = enabled;
+}
+
+/**
+ * Returns YES if crash reports queued for sending by earlier versions remain in the queue directory.
+ */
 - (BOOL) hasQueuedCrashReports
 {
     BOOL toRet = NO;
@@ -372,31 +493,18 @@ static void uncaught_exception_handler (NSException *exception) {
     return toRet;
 }
 
-- (NSString*)getNextCrashReportPath
+/**
+ * Return the paths of all crash reports queued for sending by earlier versions, from a single listing of the
+ * queue directory. Crash reports are now held in the report store, and are read with
+ * PLCrashReporter::loadPendingCrashReportData.
+ */
+- (NSArray *) queuedCrashReportPaths
 {
-    NSString *crashReportPath = nil;
     NSArray *files = [self queuedCrashReportFiles];
-    if(files && files.count > 0){
-        NSString *fileName =  [[self queuedCrashReportFiles] objectAtIndex:0];
-        crashReportPath = [[self queuedCrashReportDirectory] stringByAppendingPathComponent:fileName];
-    }//none left, or dir dne
-    return crashReportPath;
-}
-
-- (NSString *) saveCrashReportInQueue:(NSString*)reportString
-{
-    NSString *filePath = [[self queuedCrashReportDirectory] stringByAppendingPathComponent:[self makeRandomFileName]];
-    NSError *error = nil;
-    [reportString writeToFile:filePath atomically:NO encoding:NSUTF8StringEncoding error:&error];
-    if(error == nil)
-    {
-        return filePath;
-    }
-    else
-    {
-        NSLog(@"Error writing new crash report to queue directory: %@", error );
-        return nil;
-    }
+    NSMutableArray *paths = [NSMutableArray arrayWithCapacity: [files count]];
+    for (NSString *fileName in files)
+        [paths addObject: [[self queuedCrashReportDirectory] stringByAppendingPathComponent: fileName]];
+    return paths;
 }
 
 
@@ -497,13 +605,6 @@ static void uncaught_exception_handler (NSException *exception) {
         return NO;
     }
 
-    /* Create the queued crash report directory */
-    if (![fm fileExistsAtPath: [self queuedCrashReportDirectory]] &&
-        ![fm createDirectoryAtPath: [self queuedCrashReportDirectory] withIntermediateDirectories: YES attributes: attributes error: outError])
-    {
-        return NO;
-    }
-
     return YES;
 }
 
@@ -528,27 +629,70 @@ static void uncaught_exception_handler (NSException *exception) {
 }
 
 
-- (NSString *) makeRandomFileName
-{
-    return [NSString stringWithFormat:@"%@.txt", [self randomString:QUEUED_FILE_NAMELENGTH]];
+/**
+ * Return the path to the live crash report written by earlier versions (which may not exist).
+ */
+- (NSString *) crashReportPath {
+    return [[self crashReportDirectory] stringByAppendingPathComponent: PLCRASH_LIVE_CRASHREPORT];
 }
 
-- (NSString *) randomString: (int) len {
-    NSMutableString *randomString = [NSMutableString stringWithCapacity: len];
-    for (int i=0; i<len; i++) {
-        [randomString appendFormat: @"%C", [s_letters characterAtIndex: arc4random()%[s_letters length]]];
-    }
-    return randomString;
+/**
+ * Return the path to the crash report store.
+ */
+- (NSString *) reportStorePath {
+    return [[self crashReportDirectory] stringByAppendingPathComponent: PLCRASH_REPORT_STORE];
 }
 
-
 /**
- * Return the path to live crash report (which may not yet, or ever, exist).
+ * Open the report store, if it is not already open, creating the directory tree if necessary. A live crash
+ * report left by an earlier version is moved into the store.
  */
-- (NSString *) crashReportPath {
-    return [[self crashReportDirectory] stringByAppendingPathComponent: PLCRASH_LIVE_CRASHREPORT];
+- (BOOL) openReportStoreAndReturnError: (NSError **) outError {
+    if (_reportStoreOpen)
+        return YES;
+
+    if (![self populateCrashReportDirectoryAndReturnError: outError])
+        return NO;
+
+    plcrash_error_t err = plcrash_report_store_open(&signal_handler_context.store, [[self reportStorePath] fileSystemRepresentation],
+                                                    PLCRASH_REPORT_STORE_DEFAULT_SLOTS, MAX_REPORT_BYTES);
+    if (err != PLCRASH_ESUCCESS) {
+        populate_nserror(outError, PLCrashReporterErrorOperatingSystem,
+                         [NSString stringWithFormat: @"Could not open the crash report store: %s", (err == PLCRASH_EINTERNAL) ? strerror(errno) : plcrash_strerror(err)]);
+        return NO;
+    }
+    _reportStoreOpen = YES;
+
+    /* Import the live report of an earlier version */
+    NSData *legacyReport = [NSData dataWithContentsOfFile: [self crashReportPath]];
+    if (legacyReport != nil) {
+        err = plcrash_report_store_append(&signal_handler_context.store, [legacyReport bytes], [legacyReport length]);
+        if (err != PLCRASH_ESUCCESS)
+            NSDEBUG(@"Could not import the live crash report: %s", plcrash_strerror(err));
+        [[NSFileManager defaultManager] removeItemAtPath: [self crashReportPath] error: NULL];
+    }
+
+    return YES;
 }
 
 
 
 @end
+
+/**
+ * @internal
+ *
+ * Populate an NSError instance with the provided information.
+ *
+ * @param error Error instance to populate. If NULL, this method returns
+ * and nothing is modified.
+ * @param code The error code corresponding to this error.
+ * @param description A localized error description.
+ */
+static void populate_nserror (NSError **error, PLCrashReporterError code, NSString *description) {
+    if (error == NULL)
+        return;
+
+    NSDictionary *userInfo = [NSDictionary dictionaryWithObject: description forKey: NSLocalizedDescriptionKey];
+    *error = [NSError errorWithDomain: PLCrashReporterErrorDomain code: code userInfo: userInfo];
+}
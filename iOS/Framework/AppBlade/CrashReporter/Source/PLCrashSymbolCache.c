@@ -0,0 +1,548 @@
+/*
+ * Copyright (c) 2008-2011 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PLCrashSymbolCache.h"
+#include "PLCrashReportCore.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @ingroup plcrash_symbolicator
+ * @{
+ */
+
+/* Symbol cache magic */
+static const uint8_t symcache_magic[8] = { 'p', 'l', 's', 'y', 'm', 'c', 'h', '\0' };
+
+/* Header field offsets */
+#define SYMCACHE_HDR_MAGIC 0
+#define SYMCACHE_HDR_VERSION 8
+#define SYMCACHE_HDR_UUID_LENGTH 12
+#define SYMCACHE_HDR_UUID 16
+#define SYMCACHE_HDR_LINK_BASE 48
+#define SYMCACHE_HDR_SYMBOL_COUNT 56
+#define SYMCACHE_HDR_SYMBOL_OFFSET 64
+#define SYMCACHE_HDR_LINE_COUNT 72
+#define SYMCACHE_HDR_LINE_OFFSET 80
+#define SYMCACHE_HDR_FILE_COUNT 88
+#define SYMCACHE_HDR_FILE_OFFSET 96
+#define SYMCACHE_HDR_STRING_OFFSET 104
+#define SYMCACHE_HDR_STRING_SIZE 112
+#define SYMCACHE_HDR_SIZE 120
+
+/* Maximum UUID length */
+#define SYMCACHE_UUID_MAX 32
+
+/* Record sizes */
+#define SYMCACHE_SYMBOL_SIZE 16
+#define SYMCACHE_LINE_SIZE 16
+#define SYMCACHE_FILE_SIZE 4
+
+/* File index of line runs without line information */
+#define SYMCACHE_NO_FILE UINT32_MAX
+
+/**
+ * @internal
+ * Read a little-endian 32-bit value.
+ */
+static uint32_t symcache_read32 (const uint8_t *p) {
+    return ((uint32_t) p[3] << 24) | ((uint32_t) p[2] << 16) | ((uint32_t) p[1] << 8) | p[0];
+}
+
+/**
+ * @internal
+ * Read a little-endian 64-bit value.
+ */
+static uint64_t symcache_read64 (const uint8_t *p) {
+    return ((uint64_t) symcache_read32(p + 4) << 32) | symcache_read32(p);
+}
+
+/**
+ * @internal
+ * Write a little-endian 32-bit value.
+ */
+static void symcache_write32 (uint8_t *p, uint32_t value) {
+    p[0] = (uint8_t) value;
+    p[1] = (uint8_t) (value >> 8);
+    p[2] = (uint8_t) (value >> 16);
+    p[3] = (uint8_t) (value >> 24);
+}
+
+/**
+ * @internal
+ * Write a little-endian 64-bit value.
+ */
+static void symcache_write64 (uint8_t *p, uint64_t value) {
+    symcache_write32(p, (uint32_t) value);
+    symcache_write32(p + 4, (uint32_t) (value >> 32));
+}
+
+/**
+ * @internal
+ * Locate the table of @a count records of @a record_size bytes described by the header fields at @a count_field
+ * and @a offset_field.
+ */
+static bool symcache_table (const uint8_t *data, size_t size, size_t count_field, size_t offset_field, size_t record_size,
+                            const uint8_t **table, size_t *count)
+{
+    uint64_t table_count = symcache_read64(data + count_field);
+    uint64_t table_offset = symcache_read64(data + offset_field);
+
+    if (table_offset > size || table_count > (size - table_offset) / record_size)
+        return false;
+
+    *table = data + table_offset;
+    *count = (size_t) table_count;
+    return true;
+}
+
+/**
+ * Initialize a view of the symbol cache @a data. The header and table bounds are validated; no other
+ * processing is performed.
+ *
+ * @param cache The view to initialize.
+ * @param data Symbol cache data. The data must remain valid for the lifetime of the view.
+ * @param size Size of @a data.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, PLCRASH_ENOTSUP if @a data is not a symbol cache (or is an
+ * unsupported version), or PLCRASH_EINVAL if the cache is corrupt.
+ */
+plcrash_error_t plcrash_symcache_init (plcrash_symcache_t *cache, const void *data, size_t size) {
+    const uint8_t *bytes = data;
+    const uint8_t *strings;
+    uint32_t uuid_length;
+
+    memset(cache, 0, sizeof(*cache));
+
+    if (size < SYMCACHE_HDR_SIZE || memcmp(bytes + SYMCACHE_HDR_MAGIC, symcache_magic, sizeof(symcache_magic)) != 0)
+        return PLCRASH_ENOTSUP;
+
+    if (symcache_read32(bytes + SYMCACHE_HDR_VERSION) != PLCRASH_SYMCACHE_VERSION)
+        return PLCRASH_ENOTSUP;
+
+    uuid_length = symcache_read32(bytes + SYMCACHE_HDR_UUID_LENGTH);
+    if (uuid_length == 0 || uuid_length > SYMCACHE_UUID_MAX)
+        return PLCRASH_EINVAL;
+
+    if (!symcache_table(bytes, size, SYMCACHE_HDR_SYMBOL_COUNT, SYMCACHE_HDR_SYMBOL_OFFSET, SYMCACHE_SYMBOL_SIZE, &cache->symbols, &cache->symbol_count) ||
+        !symcache_table(bytes, size, SYMCACHE_HDR_LINE_COUNT, SYMCACHE_HDR_LINE_OFFSET, SYMCACHE_LINE_SIZE, &cache->lines, &cache->line_count) ||
+        !symcache_table(bytes, size, SYMCACHE_HDR_FILE_COUNT, SYMCACHE_HDR_FILE_OFFSET, SYMCACHE_FILE_SIZE, &cache->files, &cache->file_count) ||
+        !symcache_table(bytes, size, SYMCACHE_HDR_STRING_SIZE, SYMCACHE_HDR_STRING_OFFSET, 1, &strings, &cache->string_size))
+    {
+        return PLCRASH_EINVAL;
+    }
+
+    /* A terminated string table guarantees that every in-bounds string offset refers to a terminated string */
+    if (cache->string_size == 0 || strings[cache->string_size - 1] != '\0')
+        return PLCRASH_EINVAL;
+
+    cache->strings = (const char *) strings;
+    cache->uuid = bytes + SYMCACHE_HDR_UUID;
+    cache->uuid_length = uuid_length;
+    cache->link_base = symcache_read64(bytes + SYMCACHE_HDR_LINK_BASE);
+
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * @internal
+ * Return the index of the last record in the address-sorted @a table with an address <= @a address, or -1.
+ */
+static ssize_t symcache_search (const uint8_t *table, size_t count, size_t record_size, uint64_t address) {
+    size_t lo = 0;
+    size_t hi = count;
+
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+
+        if (symcache_read64(table + mid * record_size) <= address)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return (ssize_t) lo - 1;
+}
+
+/**
+ * Look up the symbol containing the link-time @a address.
+ *
+ * @param cache The symbol cache.
+ * @param address The link-time address to look up.
+ * @param name On success, the symbol name. The name remains valid for the lifetime of the cache data.
+ * @param symbol_address On success, the symbol's link-time start address.
+ *
+ * @return Returns true if a symbol was found.
+ */
+bool plcrash_symcache_lookup_symbol (const plcrash_symcache_t *cache, uint64_t address, const char **name, uint64_t *symbol_address) {
+    ssize_t index = symcache_search(cache->symbols, cache->symbol_count, SYMCACHE_SYMBOL_SIZE, address);
+    const uint8_t *record;
+    uint64_t start;
+    uint32_t size;
+    uint32_t name_offset;
+
+    if (index < 0)
+        return false;
+
+    record = cache->symbols + (size_t) index * SYMCACHE_SYMBOL_SIZE;
+    start = symcache_read64(record);
+    size = symcache_read32(record + 8);
+    name_offset = symcache_read32(record + 12);
+
+    if ((size != 0 && address - start >= size) || name_offset >= cache->string_size)
+        return false;
+
+    *name = cache->strings + name_offset;
+    *symbol_address = start;
+    return true;
+}
+
+/**
+ * Look up the source location of the link-time @a address.
+ *
+ * @param cache The symbol cache.
+ * @param address The link-time address to look up.
+ * @param file On success, the source file name. The name remains valid for the lifetime of the cache data.
+ * @param line On success, the source line.
+ *
+ * @return Returns true if line information was found for @a address.
+ */
+bool plcrash_symcache_lookup_line (const plcrash_symcache_t *cache, uint64_t address, const char **file, uint32_t *line) {
+    ssize_t index = symcache_search(cache->lines, cache->line_count, SYMCACHE_LINE_SIZE, address);
+    const uint8_t *record;
+    uint32_t file_index;
+    uint32_t name_offset;
+
+    if (index < 0)
+        return false;
+
+    record = cache->lines + (size_t) index * SYMCACHE_LINE_SIZE;
+    file_index = symcache_read32(record + 8);
+    if (file_index == SYMCACHE_NO_FILE || file_index >= cache->file_count)
+        return false;
+
+    name_offset = symcache_read32(cache->files + (size_t) file_index * SYMCACHE_FILE_SIZE);
+    if (name_offset >= cache->string_size)
+        return false;
+
+    *file = cache->strings + name_offset;
+    *line = symcache_read32(record + 12);
+    return true;
+}
+
+/**
+ * @internal
+ * A string table entry: the string's offset + 1 (0 marks an empty bucket), and its file index.
+ */
+typedef struct symcache_string {
+    uint32_t offset;
+    uint32_t file_index;
+} symcache_string_t;
+
+/**
+ * @internal
+ * Deduplicating string table builder.
+ */
+typedef struct symcache_strings {
+    /** String data */
+    plcrash_report_output_t data;
+
+    /** Open-addressed hash table of the strings in @a data */
+    symcache_string_t *buckets;
+    size_t bucket_count;
+    size_t count;
+
+    /** Number of strings assigned a file index */
+    uint32_t file_count;
+} symcache_strings_t;
+
+/**
+ * @internal
+ * Hash a NUL-terminated string (FNV-1a).
+ */
+static size_t symcache_hash (const char *str) {
+    uint64_t hash = 14695981039346656037ULL;
+
+    for (; *str != '\0'; str++) {
+        hash ^= (uint8_t) *str;
+        hash *= 1099511628211ULL;
+    }
+
+    return (size_t) hash;
+}
+
+/**
+ * @internal
+ * Return the bucket holding @a str, or the empty bucket where it would be inserted.
+ */
+static symcache_string_t *symcache_strings_bucket (symcache_strings_t *strings, const char *str, size_t hash) {
+    size_t mask = strings->bucket_count - 1;
+    size_t i = hash & mask;
+
+    for (;;) {
+        symcache_string_t *bucket = &strings->buckets[i];
+
+        if (bucket->offset == 0 || strcmp(strings->data.buffer + bucket->offset - 1, str) == 0)
+            return bucket;
+
+        i = (i + 1) & mask;
+    }
+}
+
+/**
+ * @internal
+ * Add @a str to the string table, if not already present, and return its entry in @a entry.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, PLCRASH_EINVAL if the table would exceed 4GB, or PLCRASH_ENOMEM
+ * if memory could not be allocated.
+ */
+static plcrash_error_t symcache_strings_add (symcache_strings_t *strings, const char *str, symcache_string_t **entry) {
+    size_t length = strlen(str) + 1;
+    symcache_string_t *bucket;
+
+    /* Keep the load factor at or below 1/2 */
+    if ((strings->count + 1) * 2 > strings->bucket_count) {
+        symcache_string_t *old_buckets = strings->buckets;
+        size_t old_count = strings->bucket_count;
+
+        strings->bucket_count = old_count > 0 ? old_count * 2 : 1024;
+        strings->buckets = calloc(strings->bucket_count, sizeof(symcache_string_t));
+        if (strings->buckets == NULL) {
+            strings->buckets = old_buckets;
+            strings->bucket_count = old_count;
+            return PLCRASH_ENOMEM;
+        }
+
+        for (size_t i = 0; i < old_count; i++) {
+            if (old_buckets[i].offset != 0) {
+                const char *old_str = strings->data.buffer + old_buckets[i].offset - 1;
+                *symcache_strings_bucket(strings, old_str, symcache_hash(old_str)) = old_buckets[i];
+            }
+        }
+
+        free(old_buckets);
+    }
+
+    bucket = symcache_strings_bucket(strings, str, symcache_hash(str));
+    if (bucket->offset != 0) {
+        *entry = bucket;
+        return PLCRASH_ESUCCESS;
+    }
+
+    if (strings->data.length + length >= UINT32_MAX)
+        return PLCRASH_EINVAL;
+
+    bucket->offset = (uint32_t) strings->data.length + 1;
+    bucket->file_index = SYMCACHE_NO_FILE;
+
+    plcrash_report_output_write(&strings->data, str, length);
+    if (strings->data.error != PLCRASH_ESUCCESS)
+        return PLCRASH_ENOMEM;
+
+    strings->count++;
+    *entry = bucket;
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * @internal
+ * Write @a length bytes of zero padding.
+ */
+static void symcache_pad (plcrash_report_output_t *output, size_t length) {
+    static const uint8_t zero[8] = { 0 };
+
+    plcrash_report_output_write(output, zero, length);
+}
+
+/**
+ * @internal
+ * Round @a value up to a multiple of 8.
+ */
+static uint64_t symcache_align (uint64_t value) {
+    return (value + 7) & ~(uint64_t) 7;
+}
+
+/**
+ * Write a symbol cache to @a fd.
+ *
+ * Symbol names and file names are deduplicated, and consecutive line table rows with the same source location
+ * are merged into a single run.
+ *
+ * @param fd The file descriptor to write to. The descriptor is not closed.
+ * @param uuid Image UUID.
+ * @param uuid_length Length of @a uuid; at most 32 bytes.
+ * @param link_base Link-time base address of the image.
+ * @param symbols Symbols, in ascending address order.
+ * @param symbol_count Number of @a symbols.
+ * @param lines Line table, or NULL.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, PLCRASH_OUTPUT_ERR if writing failed, PLCRASH_EINVAL if the
+ * UUID length is invalid or the string table would exceed 4GB, or PLCRASH_ENOMEM if memory could not be
+ * allocated.
+ */
+plcrash_error_t plcrash_symcache_write (int fd, const uint8_t *uuid, size_t uuid_length, uint64_t link_base,
+                                        const plcrash_symcache_symbol_t *symbols, size_t symbol_count,
+                                        const plcrash_dwarf_line_table_t *lines)
+{
+    symcache_strings_t strings;
+    plcrash_report_output_t output;
+    uint8_t header[SYMCACHE_HDR_SIZE];
+    uint8_t *symbol_records = NULL;
+    uint8_t *line_records = NULL;
+    uint8_t *file_records = NULL;
+    size_t line_count = 0;
+    uint64_t offset;
+    char buffer[16384];
+    plcrash_error_t err = PLCRASH_ESUCCESS;
+
+    if (uuid_length == 0 || uuid_length > SYMCACHE_UUID_MAX)
+        return PLCRASH_EINVAL;
+
+    memset(&strings, 0, sizeof(strings));
+    plcrash_report_output_init_buffer(&strings.data, 0);
+
+    /* Symbols */
+    if (symbol_count > 0 && (symbol_records = malloc(symbol_count * SYMCACHE_SYMBOL_SIZE)) == NULL) {
+        err = PLCRASH_ENOMEM;
+        goto cleanup;
+    }
+
+    for (size_t i = 0; i < symbol_count; i++) {
+        uint8_t *record = symbol_records + i * SYMCACHE_SYMBOL_SIZE;
+        symcache_string_t *name;
+
+        if ((err = symcache_strings_add(&strings, symbols[i].name, &name)) != PLCRASH_ESUCCESS)
+            goto cleanup;
+
+        symcache_write64(record, symbols[i].address);
+        symcache_write32(record + 8, symbols[i].size <= UINT32_MAX ? (uint32_t) symbols[i].size : 0);
+        symcache_write32(record + 12, name->offset - 1);
+    }
+
+    /* Line runs */
+    if (lines != NULL && lines->row_count > 0) {
+        if ((line_records = malloc(lines->row_count * SYMCACHE_LINE_SIZE)) == NULL ||
+            (file_records = malloc(lines->row_count * SYMCACHE_FILE_SIZE)) == NULL)
+        {
+            err = PLCRASH_ENOMEM;
+            goto cleanup;
+        }
+
+        for (size_t i = 0; i < lines->row_count; i++) {
+            const plcrash_dwarf_line_row_t *row = &lines->rows[i];
+            uint32_t file_index = SYMCACHE_NO_FILE;
+            uint32_t line = 0;
+            uint8_t *record;
+
+            if (row->file != NULL) {
+                symcache_string_t *file;
+
+                if ((err = symcache_strings_add(&strings, row->file, &file)) != PLCRASH_ESUCCESS)
+                    goto cleanup;
+
+                if (file->file_index == SYMCACHE_NO_FILE) {
+                    file->file_index = strings.file_count++;
+                    symcache_write32(file_records + (size_t) file->file_index * SYMCACHE_FILE_SIZE, file->offset - 1);
+                }
+
+                file_index = file->file_index;
+                line = row->line;
+            }
+
+            /* Of several rows at the same address, the last applies */
+            if (line_count > 0 && symcache_read64(line_records + (line_count - 1) * SYMCACHE_LINE_SIZE) == row->address)
+                line_count--;
+
+            /* Extend the previous run if the location is unchanged */
+            if (line_count > 0) {
+                const uint8_t *previous = line_records + (line_count - 1) * SYMCACHE_LINE_SIZE;
+                if (symcache_read32(previous + 8) == file_index && symcache_read32(previous + 12) == line)
+                    continue;
+            }
+
+            record = line_records + line_count * SYMCACHE_LINE_SIZE;
+            symcache_write64(record, row->address);
+            symcache_write32(record + 8, file_index);
+            symcache_write32(record + 12, line);
+            line_count++;
+        }
+    }
+
+    /* The string table always includes a terminating NUL */
+    plcrash_report_output_write(&strings.data, "", 1);
+    if (strings.data.error != PLCRASH_ESUCCESS) {
+        err = PLCRASH_ENOMEM;
+        goto cleanup;
+    }
+
+    /* Header */
+    memset(header, 0, sizeof(header));
+    memcpy(header + SYMCACHE_HDR_MAGIC, symcache_magic, sizeof(symcache_magic));
+    symcache_write32(header + SYMCACHE_HDR_VERSION, PLCRASH_SYMCACHE_VERSION);
+    symcache_write32(header + SYMCACHE_HDR_UUID_LENGTH, (uint32_t) uuid_length);
+    memcpy(header + SYMCACHE_HDR_UUID, uuid, uuid_length);
+    symcache_write64(header + SYMCACHE_HDR_LINK_BASE, link_base);
+
+    offset = SYMCACHE_HDR_SIZE;
+    symcache_write64(header + SYMCACHE_HDR_SYMBOL_COUNT, symbol_count);
+    symcache_write64(header + SYMCACHE_HDR_SYMBOL_OFFSET, offset);
+    offset += (uint64_t) symbol_count * SYMCACHE_SYMBOL_SIZE;
+
+    symcache_write64(header + SYMCACHE_HDR_LINE_COUNT, line_count);
+    symcache_write64(header + SYMCACHE_HDR_LINE_OFFSET, offset);
+    offset += (uint64_t) line_count * SYMCACHE_LINE_SIZE;
+
+    symcache_write64(header + SYMCACHE_HDR_FILE_COUNT, strings.file_count);
+    symcache_write64(header + SYMCACHE_HDR_FILE_OFFSET, offset);
+    offset = symcache_align(offset + (uint64_t) strings.file_count * SYMCACHE_FILE_SIZE);
+
+    symcache_write64(header + SYMCACHE_HDR_STRING_OFFSET, offset);
+    symcache_write64(header + SYMCACHE_HDR_STRING_SIZE, strings.data.length);
+
+    /* Write the tables in order; only the file table may require padding */
+    plcrash_report_output_init_fd(&output, fd, buffer, sizeof(buffer));
+    plcrash_report_output_write(&output, header, sizeof(header));
+    plcrash_report_output_write(&output, symbol_records, symbol_count * SYMCACHE_SYMBOL_SIZE);
+    plcrash_report_output_write(&output, line_records, line_count * SYMCACHE_LINE_SIZE);
+    plcrash_report_output_write(&output, file_records, (size_t) strings.file_count * SYMCACHE_FILE_SIZE);
+    symcache_pad(&output, (size_t) ((strings.file_count * SYMCACHE_FILE_SIZE) % 8));
+    plcrash_report_output_write(&output, strings.data.buffer, strings.data.length);
+    err = plcrash_report_output_flush(&output);
+
+cleanup:
+    plcrash_report_output_free(&strings.data);
+    free(strings.buckets);
+    free(symbol_records);
+    free(line_records);
+    free(file_records);
+
+    return err;
+}
+
+/**
+ * @} plcrash_symbolicator
+ */
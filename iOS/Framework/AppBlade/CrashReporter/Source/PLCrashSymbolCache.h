@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2008-2011 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef PLCRASH_SYMBOL_CACHE_H
+#define PLCRASH_SYMBOL_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#import "PLCrashAsync.h"
+#include "PLCrashSymbolicatorDWARF.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @internal
+ * @ingroup plcrash_symbolicator
+ * @{
+ */
+
+/** Symbol cache file extension. Cache files are named by their image's upper-case hexadecimal UUID. */
+#define PLCRASH_SYMCACHE_EXTENSION "plsym"
+
+/** Current symbol cache format version */
+#define PLCRASH_SYMCACHE_VERSION 1
+
+/**
+ * A read-only view of a symbol cache.
+ *
+ * A symbol cache holds the symbol table and (optionally) the line table of a single image, in a form that is
+ * searched in place: the cache is validated when the view is initialized, and lookups binary search the
+ * underlying data directly. The cache data must remain valid (eg, mapped) for the lifetime of the view.
+ *
+ * The format is little-endian, with each table aligned to 8 bytes:
+ *
+ * - Header (120 bytes): the magic "plsymch\0", version, UUID length and UUID (32 bytes), link-time base
+ *   address, and the count and offset of each table, followed by the offset and size of the string table.
+ * - Symbols (16 bytes each, ascending address order): address (8), size (4; 0 if unbounded), name (4).
+ * - Line runs (16 bytes each, ascending address order): address (8), file (4; index into the file table, or
+ *   UINT32_MAX for addresses without line information), line (4). Each run covers the addresses up to the next.
+ * - Files (4 bytes each): name.
+ * - Strings: deduplicated NUL-terminated strings, referenced by offset. The table ends with a NUL.
+ */
+typedef struct plcrash_symcache {
+    /** Image UUID */
+    const uint8_t *uuid;
+    size_t uuid_length;
+
+    /** Link-time base address of the image */
+    uint64_t link_base;
+
+    /** Symbol records */
+    const uint8_t *symbols;
+    size_t symbol_count;
+
+    /** Line run records */
+    const uint8_t *lines;
+    size_t line_count;
+
+    /** File records */
+    const uint8_t *files;
+    size_t file_count;
+
+    /** String table */
+    const char *strings;
+    size_t string_size;
+} plcrash_symcache_t;
+
+/**
+ * A symbol to be written to a symbol cache.
+ */
+typedef struct plcrash_symcache_symbol {
+    /** Link-time start address */
+    uint64_t address;
+
+    /** Size in bytes, or 0 if the symbol extends to the next symbol */
+    uint64_t size;
+
+    /** NUL-terminated name */
+    const char *name;
+} plcrash_symcache_symbol_t;
+
+plcrash_error_t plcrash_symcache_init (plcrash_symcache_t *cache, const void *data, size_t size);
+bool plcrash_symcache_lookup_symbol (const plcrash_symcache_t *cache, uint64_t address, const char **name, uint64_t *symbol_address);
+bool plcrash_symcache_lookup_line (const plcrash_symcache_t *cache, uint64_t address, const char **file, uint32_t *line);
+
+plcrash_error_t plcrash_symcache_write (int fd, const uint8_t *uuid, size_t uuid_length, uint64_t link_base,
+                                        const plcrash_symcache_symbol_t *symbols, size_t symbol_count,
+                                        const plcrash_dwarf_line_table_t *lines);
+
+/**
+ * @} plcrash_symbolicator
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PLCRASH_SYMBOL_CACHE_H */
@@ -0,0 +1,138 @@
+/*
+ * Author: Landon Fuller <landonf@plausiblelabs.com>
+ *
+ * Copyright (c) 2008-2009 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "GTMSenTestCase.h"
+
+#import "PLCrashSymbolCache.h"
+
+#import <fcntl.h>
+
+@interface PLCrashSymbolCacheTests : SenTestCase {
+@private
+    /* Path to the cache file */
+    NSString *_cachePath;
+}
+
+@end
+
+@implementation PLCrashSymbolCacheTests
+
+- (void) setUp {
+    _cachePath = [[NSTemporaryDirectory() stringByAppendingPathComponent: [[NSProcessInfo processInfo] globallyUniqueString]] retain];
+}
+
+- (void) tearDown {
+    [[NSFileManager defaultManager] removeItemAtPath: _cachePath error: NULL];
+    [_cachePath release];
+}
+
+/* Write a cache with three symbols and a line table, returning its contents */
+- (NSData *) writeCache {
+    static const uint8_t uuid[16] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f };
+    plcrash_symcache_symbol_t symbols[] = {
+        { 0x1000, 0x10, "alpha" },
+        { 0x1010, 0, "beta" },
+        { 0x2000, 0x20, "gamma" }
+    };
+    plcrash_dwarf_line_row_t rows[] = {
+        { 0x1000, "a.c", 1 },
+        { 0x1004, "a.c", 1 },
+        { 0x1008, "b.c", 7 },
+        { 0x1008, "a.c", 2 },
+        { 0x1010, NULL, 0 },
+        { 0x2000, "a.c", 9 },
+        { 0x2020, NULL, 0 }
+    };
+    plcrash_dwarf_line_table_t lines = { rows, sizeof(rows) / sizeof(rows[0]) };
+    int fd;
+
+    fd = open([_cachePath fileSystemRepresentation], O_RDWR|O_CREAT|O_TRUNC, 0644);
+    STAssertTrue(fd >= 0, @"Could not open the cache file");
+
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_symcache_write(fd, uuid, sizeof(uuid), 0x1000, symbols, 3, &lines), @"Could not write the cache");
+    close(fd);
+
+    return [NSData dataWithContentsOfFile: _cachePath];
+}
+
+- (void) testLookup {
+    NSData *data = [self writeCache];
+    plcrash_symcache_t cache;
+    const char *name;
+    const char *file;
+    uint64_t address;
+    uint32_t line;
+
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_symcache_init(&cache, [data bytes], [data length]), @"Could not read the cache");
+    STAssertEquals((size_t) 16, cache.uuid_length, @"Incorrect UUID length");
+    STAssertEquals((uint64_t) 0x1000, cache.link_base, @"Incorrect link base");
+    STAssertEquals((size_t) 3, cache.symbol_count, @"Incorrect symbol count");
+
+    /* Duplicate rows at the same address are resolved, and unchanged locations are merged into runs */
+    STAssertEquals((size_t) 5, cache.line_count, @"Line rows were not merged");
+
+    /* Symbols */
+    STAssertFalse(plcrash_symcache_lookup_symbol(&cache, 0xfff, &name, &address), @"Address before the first symbol was resolved");
+
+    STAssertTrue(plcrash_symcache_lookup_symbol(&cache, 0x1004, &name, &address), @"Symbol lookup failed");
+    STAssertEqualCStrings("alpha", name, @"Incorrect symbol");
+    STAssertEquals((uint64_t) 0x1000, address, @"Incorrect symbol address");
+
+    STAssertTrue(plcrash_symcache_lookup_symbol(&cache, 0x1fff, &name, &address), @"Unbounded symbol lookup failed");
+    STAssertEqualCStrings("beta", name, @"Incorrect symbol");
+
+    STAssertTrue(plcrash_symcache_lookup_symbol(&cache, 0x201f, &name, &address), @"Symbol lookup failed");
+    STAssertEqualCStrings("gamma", name, @"Incorrect symbol");
+    STAssertFalse(plcrash_symcache_lookup_symbol(&cache, 0x2020, &name, &address), @"Address past the end of a symbol was resolved");
+
+    /* Lines */
+    STAssertTrue(plcrash_symcache_lookup_line(&cache, 0x1007, &file, &line), @"Line lookup failed");
+    STAssertEqualCStrings("a.c", file, @"Incorrect file");
+    STAssertEquals((uint32_t) 1, line, @"Incorrect line");
+
+    STAssertTrue(plcrash_symcache_lookup_line(&cache, 0x1008, &file, &line), @"Line lookup failed");
+    STAssertEqualCStrings("a.c", file, @"The last row at an address was not used");
+    STAssertEquals((uint32_t) 2, line, @"Incorrect line");
+
+    STAssertFalse(plcrash_symcache_lookup_line(&cache, 0x1010, &file, &line), @"Address without line information was resolved");
+
+    STAssertTrue(plcrash_symcache_lookup_line(&cache, 0x2010, &file, &line), @"Line lookup failed");
+    STAssertEquals((uint32_t) 9, line, @"Incorrect line");
+    STAssertFalse(plcrash_symcache_lookup_line(&cache, 0x3000, &file, &line), @"Address past the end of the line table was resolved");
+}
+
+- (void) testInvalid {
+    NSData *data = [self writeCache];
+    plcrash_symcache_t cache;
+
+    STAssertEquals(PLCRASH_ENOTSUP, plcrash_symcache_init(&cache, "not a symbol cache", 18), @"Invalid data was accepted");
+    STAssertEquals(PLCRASH_EINVAL, plcrash_symcache_init(&cache, [data bytes], 120), @"Truncated cache was accepted");
+    STAssertEquals(PLCRASH_EINVAL, plcrash_symcache_init(&cache, [data bytes], [data length] - 1), @"Truncated string table was accepted");
+}
+
+@end
@@ -0,0 +1,1686 @@
+/*
+ * Copyright (c) 2008-2011 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PLCrashSymbolicator.h"
+#include "PLCrashSymbolicatorDWARF.h"
+#include "PLCrashSymbolCache.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/**
+ * @ingroup plcrash_symbolicator
+ * @{
+ */
+
+/* Mach-O and universal binary constants (mach-o/loader.h, mach-o/fat.h, mach-o/nlist.h) */
+#define SYM_MH_MAGIC 0xfeedface
+#define SYM_MH_CIGAM 0xcefaedfe
+#define SYM_MH_MAGIC_64 0xfeedfacf
+#define SYM_MH_CIGAM_64 0xcffaedfe
+#define SYM_FAT_MAGIC 0xcafebabe
+#define SYM_FAT_MAGIC_64 0xcafebabf
+#define SYM_LC_SEGMENT 0x1
+#define SYM_LC_SYMTAB 0x2
+#define SYM_LC_SEGMENT_64 0x19
+#define SYM_LC_UUID 0x1b
+#define SYM_N_STAB 0xe0
+#define SYM_N_TYPE 0x0e
+#define SYM_N_SECT 0x0e
+#define SYM_N_EXT 0x01
+
+/* ELF constants (elf.h) */
+#define SYM_ELFCLASS64 2
+#define SYM_ELFDATA2MSB 2
+#define SYM_EM_ARM 40
+#define SYM_PT_LOAD 1
+#define SYM_PT_NOTE 4
+#define SYM_SHT_SYMTAB 2
+#define SYM_SHT_NOTE 7
+#define SYM_SHT_NOBITS 8
+#define SYM_SHT_DYNSYM 11
+#define SYM_SHF_COMPRESSED 0x800
+#define SYM_STT_FUNC 2
+#define SYM_STB_GLOBAL 1
+#define SYM_STB_WEAK 2
+#define SYM_NT_GNU_BUILD_ID 3
+
+/* Maximum number of architectures accepted in a universal binary; guards against Java class files, which share
+ * the universal binary magic */
+#define SYM_FAT_MAX_ARCH 64
+
+/* Maximum directory depth searched by plcrash_symbolicator_add_path() */
+#define SYM_MAX_DEPTH 32
+
+/**
+ * @internal
+ * An indexed file.
+ */
+struct plcrash_symbolicator_file {
+    /** File path */
+    char *path;
+
+    /** Read-only mapping of the file, or NULL if not yet mapped */
+    const uint8_t *map;
+
+    /** Size of the mapping */
+    size_t size;
+};
+
+/**
+ * @internal
+ * A symbol table entry.
+ */
+typedef struct sym_symbol {
+    /** Link-time start address */
+    uint64_t address;
+
+    /** Size in bytes */
+    uint64_t size;
+
+    /** NUL-terminated name, within the file mapping */
+    const char *name;
+
+    /** Preference among symbols at the same address; lower is preferred */
+    uint8_t rank;
+} sym_symbol_t;
+
+/** Image load state */
+typedef enum {
+    /** The symbol table has not been built */
+    SYM_IMAGE_UNLOADED = 0,
+
+    /** The symbol table has been built */
+    SYM_IMAGE_LOADED,
+
+    /** The image could not be loaded; it will not be retried */
+    SYM_IMAGE_FAILED
+} sym_image_state_t;
+
+/**
+ * @internal
+ * An indexed image: a thin Mach-O file, a slice of a universal binary, or an ELF file.
+ */
+struct plcrash_symbolicator_image {
+    /** Image UUID or build-id */
+    uint8_t uuid[PLCRASH_SYMBOLICATOR_UUID_MAX];
+    size_t uuid_length;
+
+    /** Index of the containing file */
+    size_t file;
+
+    /** Offset and size of the image within the file */
+    uint64_t offset;
+    uint64_t size;
+
+    /** True if the image has a DWARF line table (or, for symbol caches, line runs) */
+    bool has_debug_line;
+
+    /** True if the image is backed by a symbol cache, rather than an object file */
+    bool is_cache;
+
+    /** Load state */
+    sym_image_state_t state;
+
+    /** Link-time base address */
+    uint64_t link_base;
+
+    /** Symbols, in ascending address order */
+    sym_symbol_t *symbols;
+    size_t symbol_count;
+
+    /** Line table (if line information was requested) */
+    plcrash_dwarf_line_table_t lines;
+
+    /** Symbol cache view, if @a is_cache; the symbol and line tables are then unused */
+    plcrash_symcache_t cache;
+};
+
+/** Object file formats */
+typedef enum {
+    SYM_FORMAT_MACHO,
+    SYM_FORMAT_ELF
+} sym_format_t;
+
+/**
+ * @internal
+ * Parsed object file headers, referencing the object's mapping.
+ */
+typedef struct sym_object {
+    /** Object file format */
+    sym_format_t format;
+
+    /** True for 64-bit objects */
+    bool is_64;
+
+    /** True for big-endian objects */
+    bool big_endian;
+
+    /** UUID or build-id */
+    uint8_t uuid[PLCRASH_SYMBOLICATOR_UUID_MAX];
+    size_t uuid_length;
+
+    /** Link-time base address */
+    uint64_t link_base;
+
+    /** End of the executable segment (Mach-O), or 0 */
+    uint64_t text_end;
+
+    /** Range of Mach-O section numbers within the __TEXT segment */
+    uint32_t text_sect_first;
+    uint32_t text_sect_last;
+
+    /** ELF machine type */
+    uint16_t machine;
+
+    /** Symbol table entries and entry size */
+    const uint8_t *symtab;
+    size_t symtab_count;
+    size_t symtab_entsize;
+
+    /** String table */
+    const uint8_t *strtab;
+    size_t strtab_size;
+
+    /** DWARF sections */
+    plcrash_dwarf_sections_t dwarf;
+} sym_object_t;
+
+/**
+ * @internal
+ * Read an unsigned 16-bit value.
+ */
+static uint16_t sym_read16 (const uint8_t *p, bool big_endian) {
+    return big_endian ? (uint16_t) ((p[0] << 8) | p[1]) : (uint16_t) ((p[1] << 8) | p[0]);
+}
+
+/**
+ * @internal
+ * Read an unsigned 32-bit value.
+ */
+static uint32_t sym_read32 (const uint8_t *p, bool big_endian) {
+    if (big_endian)
+        return ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) | ((uint32_t) p[2] << 8) | p[3];
+
+    return ((uint32_t) p[3] << 24) | ((uint32_t) p[2] << 16) | ((uint32_t) p[1] << 8) | p[0];
+}
+
+/**
+ * @internal
+ * Read an unsigned 64-bit value.
+ */
+static uint64_t sym_read64 (const uint8_t *p, bool big_endian) {
+    uint64_t hi = sym_read32(big_endian ? p : p + 4, big_endian);
+    uint64_t lo = sym_read32(big_endian ? p + 4 : p, big_endian);
+
+    return (hi << 32) | lo;
+}
+
+/**
+ * @internal
+ * Read a 32-bit or 64-bit word.
+ */
+static uint64_t sym_read_word (const uint8_t *p, bool is_64, bool big_endian) {
+    return is_64 ? sym_read64(p, big_endian) : sym_read32(p, big_endian);
+}
+
+/**
+ * @internal
+ * Return true if the range @a offset..@a offset + @a length lies within @a size bytes.
+ */
+static bool sym_in_bounds (uint64_t offset, uint64_t length, uint64_t size) {
+    return offset <= size && length <= size - offset;
+}
+
+/**
+ * @internal
+ * Compare a fixed-width Mach-O segment or section name.
+ */
+static bool sym_macho_name_equal (const uint8_t *name, const char *expected) {
+    return strncmp((const char *) name, expected, 16) == 0;
+}
+
+/**
+ * @internal
+ * Parse the headers of the thin Mach-O object at @a base.
+ */
+static bool sym_parse_macho (const uint8_t *base, size_t size, sym_object_t *obj) {
+    uint32_t magic;
+    size_t header_size;
+    uint32_t ncmds;
+    uint32_t sizeofcmds;
+    uint32_t sect_index = 1;
+    size_t offset;
+
+    if (size < 28)
+        return false;
+
+    memset(obj, 0, sizeof(*obj));
+    obj->format = SYM_FORMAT_MACHO;
+
+    magic = sym_read32(base, false);
+    switch (magic) {
+        case SYM_MH_MAGIC:    obj->is_64 = false; obj->big_endian = false; break;
+        case SYM_MH_CIGAM:    obj->is_64 = false; obj->big_endian = true;  break;
+        case SYM_MH_MAGIC_64: obj->is_64 = true;  obj->big_endian = false; break;
+        case SYM_MH_CIGAM_64: obj->is_64 = true;  obj->big_endian = true;  break;
+        default:
+            return false;
+    }
+
+    header_size = obj->is_64 ? 32 : 28;
+    ncmds = sym_read32(base + 16, obj->big_endian);
+    sizeofcmds = sym_read32(base + 20, obj->big_endian);
+    if (!sym_in_bounds(header_size, sizeofcmds, size))
+        return false;
+
+    offset = header_size;
+    for (uint32_t i = 0; i < ncmds; i++) {
+        const uint8_t *cmd = base + offset;
+        uint32_t cmd_type;
+        uint32_t cmd_size;
+
+        if (!sym_in_bounds(offset, 8, header_size + sizeofcmds))
+            return false;
+
+        cmd_type = sym_read32(cmd, obj->big_endian);
+        cmd_size = sym_read32(cmd + 4, obj->big_endian);
+        if (cmd_size < 8 || !sym_in_bounds(offset, cmd_size, header_size + sizeofcmds))
+            return false;
+
+        switch (cmd_type) {
+            case SYM_LC_UUID:
+                if (cmd_size >= 24) {
+                    memcpy(obj->uuid, cmd + 8, 16);
+                    obj->uuid_length = 16;
+                }
+                break;
+
+            case SYM_LC_SYMTAB: {
+                uint32_t symoff, nsyms, stroff, strsize;
+                size_t entsize = obj->is_64 ? 16 : 12;
+
+                if (cmd_size < 24)
+                    break;
+
+                symoff = sym_read32(cmd + 8, obj->big_endian);
+                nsyms = sym_read32(cmd + 12, obj->big_endian);
+                stroff = sym_read32(cmd + 16, obj->big_endian);
+                strsize = sym_read32(cmd + 20, obj->big_endian);
+
+                if (sym_in_bounds(symoff, (uint64_t) nsyms * entsize, size) && sym_in_bounds(stroff, strsize, size)) {
+                    obj->symtab = base + symoff;
+                    obj->symtab_count = nsyms;
+                    obj->symtab_entsize = entsize;
+                    obj->strtab = base + stroff;
+                    obj->strtab_size = strsize;
+                }
+                break;
+            }
+
+            case SYM_LC_SEGMENT:
+            case SYM_LC_SEGMENT_64: {
+                bool is_64 = (cmd_type == SYM_LC_SEGMENT_64);
+                size_t seg_size = is_64 ? 72 : 56;
+                size_t sect_size = is_64 ? 80 : 68;
+                uint64_t vmaddr, vmsize;
+                uint32_t nsects;
+
+                if (cmd_size < seg_size)
+                    break;
+
+                vmaddr = sym_read_word(cmd + 24, is_64, obj->big_endian);
+                vmsize = sym_read_word(cmd + (is_64 ? 32 : 28), is_64, obj->big_endian);
+                nsects = sym_read32(cmd + (is_64 ? 64 : 48), obj->big_endian);
+                if ((uint64_t) nsects * sect_size > cmd_size - seg_size)
+                    break;
+
+                if (sym_macho_name_equal(cmd + 8, "__TEXT")) {
+                    obj->link_base = vmaddr;
+                    obj->text_end = vmaddr + vmsize;
+                    obj->text_sect_first = sect_index;
+                    obj->text_sect_last = sect_index + nsects - 1;
+                }
+
+                /* DWARF sections of dSYM bundles and unlinked objects */
+                if (sym_macho_name_equal(cmd + 8, "__DWARF")) {
+                    for (uint32_t j = 0; j < nsects; j++) {
+                        const uint8_t *sect = cmd + seg_size + j * sect_size;
+                        uint64_t sect_length = sym_read_word(sect + 40 - (is_64 ? 0 : 4), is_64, obj->big_endian);
+                        uint32_t sect_offset = sym_read32(sect + (is_64 ? 48 : 40), obj->big_endian);
+                        const uint8_t **data = NULL;
+                        size_t *data_size = NULL;
+
+                        if (sym_macho_name_equal(sect, "__debug_line")) {
+                            data = &obj->dwarf.debug_line;
+                            data_size = &obj->dwarf.debug_line_size;
+                        } else if (sym_macho_name_equal(sect, "__debug_str")) {
+                            data = &obj->dwarf.debug_str;
+                            data_size = &obj->dwarf.debug_str_size;
+                        } else if (sym_macho_name_equal(sect, "__debug_line_str")) {
+                            data = &obj->dwarf.debug_line_str;
+                            data_size = &obj->dwarf.debug_line_str_size;
+                        }
+
+                        if (data != NULL && sym_in_bounds(sect_offset, sect_length, size)) {
+                            *data = base + sect_offset;
+                            *data_size = (size_t) sect_length;
+                        }
+                    }
+                }
+
+                sect_index += nsects;
+                break;
+            }
+
+            default:
+                break;
+        }
+
+        offset += cmd_size;
+    }
+
+    obj->dwarf.big_endian = obj->big_endian;
+    return true;
+}
+
+/**
+ * @internal
+ * Scan the ELF note data at @a notes for a GNU build-id.
+ */
+static void sym_parse_elf_notes (const uint8_t *notes, size_t size, sym_object_t *obj) {
+    size_t offset = 0;
+
+    while (sym_in_bounds(offset, 12, size)) {
+        uint32_t namesz = sym_read32(notes + offset, obj->big_endian);
+        uint32_t descsz = sym_read32(notes + offset + 4, obj->big_endian);
+        uint32_t type = sym_read32(notes + offset + 8, obj->big_endian);
+        uint64_t name_offset = offset + 12;
+        uint64_t desc_offset = name_offset + (((uint64_t) namesz + 3) & ~(uint64_t) 3);
+
+        if (!sym_in_bounds(desc_offset, descsz, size))
+            return;
+
+        if (type == SYM_NT_GNU_BUILD_ID && namesz == 4 && memcmp(notes + name_offset, "GNU", 4) == 0 &&
+            descsz > 0 && descsz <= PLCRASH_SYMBOLICATOR_UUID_MAX)
+        {
+            memcpy(obj->uuid, notes + desc_offset, descsz);
+            obj->uuid_length = descsz;
+            return;
+        }
+
+        offset = (size_t) (desc_offset + (((uint64_t) descsz + 3) & ~(uint64_t) 3));
+    }
+}
+
+/**
+ * @internal
+ * Parse the headers of the ELF object at @a base.
+ */
+static bool sym_parse_elf (const uint8_t *base, size_t size, sym_object_t *obj) {
+    uint64_t phoff, shoff;
+    uint16_t phentsize, phnum, shentsize, shnum, shstrndx;
+    const uint8_t *shstrtab = NULL;
+    uint64_t shstrtab_size = 0;
+    const uint8_t *dynsym = NULL;
+    size_t dynsym_count = 0;
+    size_t dynsym_entsize = 0;
+    uint32_t dynsym_link = 0;
+    uint32_t symtab_link = 0;
+    bool have_load = false;
+
+    if (size < 52 || memcmp(base, "\x7f" "ELF", 4) != 0)
+        return false;
+
+    memset(obj, 0, sizeof(*obj));
+    obj->format = SYM_FORMAT_ELF;
+    obj->is_64 = (base[4] == SYM_ELFCLASS64);
+    obj->big_endian = (base[5] == SYM_ELFDATA2MSB);
+
+    if (obj->is_64 && size < 64)
+        return false;
+
+    obj->machine = sym_read16(base + 18, obj->big_endian);
+    if (obj->is_64) {
+        phoff = sym_read64(base + 32, obj->big_endian);
+        shoff = sym_read64(base + 40, obj->big_endian);
+        phentsize = sym_read16(base + 54, obj->big_endian);
+        phnum = sym_read16(base + 56, obj->big_endian);
+        shentsize = sym_read16(base + 58, obj->big_endian);
+        shnum = sym_read16(base + 60, obj->big_endian);
+        shstrndx = sym_read16(base + 62, obj->big_endian);
+    } else {
+        phoff = sym_read32(base + 28, obj->big_endian);
+        shoff = sym_read32(base + 32, obj->big_endian);
+        phentsize = sym_read16(base + 42, obj->big_endian);
+        phnum = sym_read16(base + 44, obj->big_endian);
+        shentsize = sym_read16(base + 46, obj->big_endian);
+        shnum = sym_read16(base + 48, obj->big_endian);
+        shstrndx = sym_read16(base + 50, obj->big_endian);
+    }
+
+    /* The link-time base is the lowest PT_LOAD address */
+    if (phentsize >= (obj->is_64 ? 56 : 32) && sym_in_bounds(phoff, (uint64_t) phnum * phentsize, size)) {
+        for (uint16_t i = 0; i < phnum; i++) {
+            const uint8_t *ph = base + phoff + (uint64_t) i * phentsize;
+            uint32_t type = sym_read32(ph, obj->big_endian);
+            uint64_t offset = sym_read_word(ph + (obj->is_64 ? 8 : 4), obj->is_64, obj->big_endian);
+            uint64_t vaddr = sym_read_word(ph + (obj->is_64 ? 16 : 8), obj->is_64, obj->big_endian);
+            uint64_t filesz = sym_read_word(ph + (obj->is_64 ? 32 : 16), obj->is_64, obj->big_endian);
+            uint64_t align = sym_read_word(ph + (obj->is_64 ? 48 : 28), obj->is_64, obj->big_endian);
+
+            if (type == SYM_PT_LOAD) {
+                if (align > 1 && (align & (align - 1)) == 0)
+                    vaddr &= ~(align - 1);
+
+                if (!have_load || vaddr < obj->link_base)
+                    obj->link_base = vaddr;
+                have_load = true;
+            } else if (type == SYM_PT_NOTE && obj->uuid_length == 0 && sym_in_bounds(offset, filesz, size)) {
+                sym_parse_elf_notes(base + offset, (size_t) filesz, obj);
+            }
+        }
+    }
+
+    if (shentsize < (obj->is_64 ? 64 : 40) || !sym_in_bounds(shoff, (uint64_t) shnum * shentsize, size))
+        return true;
+
+    /* Section name table */
+    if (shstrndx < shnum) {
+        const uint8_t *sh = base + shoff + (uint64_t) shstrndx * shentsize;
+        uint64_t offset = sym_read_word(sh + (obj->is_64 ? 24 : 16), obj->is_64, obj->big_endian);
+        uint64_t length = sym_read_word(sh + (obj->is_64 ? 32 : 20), obj->is_64, obj->big_endian);
+
+        if (sym_in_bounds(offset, length, size)) {
+            shstrtab = base + offset;
+            shstrtab_size = length;
+        }
+    }
+
+    for (uint16_t i = 0; i < shnum; i++) {
+        const uint8_t *sh = base + shoff + (uint64_t) i * shentsize;
+        uint32_t name = sym_read32(sh, obj->big_endian);
+        uint32_t type = sym_read32(sh + 4, obj->big_endian);
+        uint64_t flags = sym_read_word(sh + 8, obj->is_64, obj->big_endian);
+        uint64_t offset = sym_read_word(sh + (obj->is_64 ? 24 : 16), obj->is_64, obj->big_endian);
+        uint64_t length = sym_read_word(sh + (obj->is_64 ? 32 : 20), obj->is_64, obj->big_endian);
+        uint32_t link = sym_read32(sh + (obj->is_64 ? 40 : 24), obj->big_endian);
+        uint64_t entsize = sym_read_word(sh + (obj->is_64 ? 56 : 36), obj->is_64, obj->big_endian);
+        const char *section_name = NULL;
+
+        if (type == SYM_SHT_NOBITS || !sym_in_bounds(offset, length, size))
+            continue;
+
+        if (shstrtab != NULL && name < shstrtab_size && memchr(shstrtab + name, '\0', (size_t) (shstrtab_size - name)) != NULL)
+            section_name = (const char *) shstrtab + name;
+
+        if (type == SYM_SHT_SYMTAB && entsize >= (obj->is_64 ? 24 : 16)) {
+            obj->symtab = base + offset;
+            obj->symtab_count = (size_t) (length / entsize);
+            obj->symtab_entsize = (size_t) entsize;
+            symtab_link = link;
+        } else if (type == SYM_SHT_DYNSYM && entsize >= (obj->is_64 ? 24 : 16)) {
+            dynsym = base + offset;
+            dynsym_count = (size_t) (length / entsize);
+            dynsym_entsize = (size_t) entsize;
+            dynsym_link = link;
+        } else if (type == SYM_SHT_NOTE) {
+            sym_parse_elf_notes(base + offset, (size_t) length, obj);
+        } else if (section_name != NULL && (flags & SYM_SHF_COMPRESSED) == 0) {
+            if (strcmp(section_name, ".debug_line") == 0) {
+                obj->dwarf.debug_line = base + offset;
+                obj->dwarf.debug_line_size = (size_t) length;
+            } else if (strcmp(section_name, ".debug_str") == 0) {
+                obj->dwarf.debug_str = base + offset;
+                obj->dwarf.debug_str_size = (size_t) length;
+            } else if (strcmp(section_name, ".debug_line_str") == 0) {
+                obj->dwarf.debug_line_str = base + offset;
+                obj->dwarf.debug_line_str_size = (size_t) length;
+            }
+        }
+    }
+
+    /* Fall back on the dynamic symbol table of stripped binaries */
+    if (obj->symtab == NULL && dynsym != NULL) {
+        obj->symtab = dynsym;
+        obj->symtab_count = dynsym_count;
+        obj->symtab_entsize = dynsym_entsize;
+        symtab_link = dynsym_link;
+    }
+
+    /* The linked string table */
+    if (obj->symtab != NULL) {
+        const uint8_t *sh;
+        uint64_t offset, length;
+
+        if (symtab_link >= shnum) {
+            obj->symtab = NULL;
+            return true;
+        }
+
+        sh = base + shoff + (uint64_t) symtab_link * shentsize;
+        offset = sym_read_word(sh + (obj->is_64 ? 24 : 16), obj->is_64, obj->big_endian);
+        length = sym_read_word(sh + (obj->is_64 ? 32 : 20), obj->is_64, obj->big_endian);
+        if (!sym_in_bounds(offset, length, size)) {
+            obj->symtab = NULL;
+            return true;
+        }
+
+        obj->strtab = base + offset;
+        obj->strtab_size = (size_t) length;
+    }
+
+    obj->dwarf.big_endian = obj->big_endian;
+    return true;
+}
+
+/**
+ * @internal
+ * Callback invoked for each object found in a file, with the object's offset and size within the file.
+ */
+typedef plcrash_error_t (*sym_object_callback_t) (const sym_object_t *obj, uint64_t offset, uint64_t size, void *ctx);
+
+/**
+ * @internal
+ * Parse each object within the file mapping @a base, invoking @a callback for each. Files that are not
+ * supported object files are ignored.
+ */
+static plcrash_error_t sym_parse_file (const uint8_t *base, size_t size, sym_object_callback_t callback, void *ctx) {
+    sym_object_t obj;
+    uint32_t magic;
+
+    if (size < 8)
+        return PLCRASH_ESUCCESS;
+
+    /* Universal binaries */
+    magic = sym_read32(base, true);
+    if (magic == SYM_FAT_MAGIC || magic == SYM_FAT_MAGIC_64) {
+        bool is_64 = (magic == SYM_FAT_MAGIC_64);
+        size_t arch_size = is_64 ? 32 : 20;
+        uint32_t nfat = sym_read32(base + 4, true);
+
+        if (nfat == 0 || nfat > SYM_FAT_MAX_ARCH || !sym_in_bounds(8, (uint64_t) nfat * arch_size, size))
+            return PLCRASH_ESUCCESS;
+
+        for (uint32_t i = 0; i < nfat; i++) {
+            const uint8_t *arch = base + 8 + i * arch_size;
+            uint64_t offset = is_64 ? sym_read64(arch + 8, true) : sym_read32(arch + 8, true);
+            uint64_t length = is_64 ? sym_read64(arch + 16, true) : sym_read32(arch + 12, true);
+            plcrash_error_t err;
+
+            if (!sym_in_bounds(offset, length, size) || !sym_parse_macho(base + offset, (size_t) length, &obj))
+                continue;
+
+            if ((err = callback(&obj, offset, length, ctx)) != PLCRASH_ESUCCESS)
+                return err;
+        }
+
+        return PLCRASH_ESUCCESS;
+    }
+
+    if (sym_parse_macho(base, size, &obj) || sym_parse_elf(base, size, &obj))
+        return callback(&obj, 0, size, ctx);
+
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * @internal
+ * Hash a UUID (FNV-1a).
+ */
+static size_t sym_uuid_hash (const uint8_t *uuid, size_t length) {
+    uint64_t hash = 14695981039346656037ULL;
+
+    for (size_t i = 0; i < length; i++) {
+        hash ^= uuid[i];
+        hash *= 1099511628211ULL;
+    }
+
+    return (size_t) hash;
+}
+
+/**
+ * @internal
+ * Return the bucket holding @a uuid, or the empty bucket where it would be inserted.
+ */
+static size_t *sym_find_bucket (const plcrash_symbolicator_t *symbolicator, const uint8_t *uuid, size_t length) {
+    size_t mask = symbolicator->bucket_count - 1;
+    size_t i = sym_uuid_hash(uuid, length) & mask;
+
+    for (;;) {
+        size_t *bucket = &symbolicator->buckets[i];
+        const struct plcrash_symbolicator_image *image;
+
+        if (*bucket == 0)
+            return bucket;
+
+        image = &symbolicator->images[*bucket - 1];
+        if (image->uuid_length == length && memcmp(image->uuid, uuid, length) == 0)
+            return bucket;
+
+        i = (i + 1) & mask;
+    }
+}
+
+/**
+ * @internal
+ * Double the size of the hash table.
+ */
+static bool sym_grow_buckets (plcrash_symbolicator_t *symbolicator) {
+    size_t *old_buckets = symbolicator->buckets;
+    size_t old_count = symbolicator->bucket_count;
+
+    symbolicator->bucket_count = old_count * 2;
+    symbolicator->buckets = calloc(symbolicator->bucket_count, sizeof(size_t));
+    if (symbolicator->buckets == NULL) {
+        symbolicator->buckets = old_buckets;
+        symbolicator->bucket_count = old_count;
+        return false;
+    }
+
+    for (size_t i = 0; i < old_count; i++) {
+        if (old_buckets[i] != 0) {
+            const struct plcrash_symbolicator_image *image = &symbolicator->images[old_buckets[i] - 1];
+            *sym_find_bucket(symbolicator, image->uuid, image->uuid_length) = old_buckets[i];
+        }
+    }
+
+    free(old_buckets);
+    return true;
+}
+
+/**
+ * @internal
+ * An image found while indexing a file.
+ */
+typedef struct sym_index_entry {
+    /** UUID or build-id */
+    const uint8_t *uuid;
+    size_t uuid_length;
+
+    /** Offset and size of the image within the file */
+    uint64_t offset;
+    uint64_t size;
+
+    /** True if line information is available */
+    bool has_debug_line;
+
+    /** True if the image is a symbol cache */
+    bool is_cache;
+} sym_index_entry_t;
+
+/**
+ * @internal
+ * Return true if @a entry should replace the unloaded @a image. Images with line information are preferred
+ * if it was requested, followed by symbol caches, which load without any parsing.
+ */
+static bool sym_index_prefer (const plcrash_symbolicator_t *symbolicator, const struct plcrash_symbolicator_image *image,
+                              const sym_index_entry_t *entry)
+{
+    if (image->state != SYM_IMAGE_UNLOADED)
+        return false;
+
+    if (symbolicator->line_info && entry->has_debug_line != image->has_debug_line)
+        return entry->has_debug_line;
+
+    return entry->is_cache && !image->is_cache;
+}
+
+/**
+ * @internal
+ * Add an image of the file at @a file to the index.
+ */
+static plcrash_error_t sym_index_image (plcrash_symbolicator_t *symbolicator, size_t file, const sym_index_entry_t *entry) {
+    struct plcrash_symbolicator_image *image;
+    size_t *bucket;
+
+    bucket = sym_find_bucket(symbolicator, entry->uuid, entry->uuid_length);
+    if (*bucket != 0) {
+        image = &symbolicator->images[*bucket - 1];
+        if (sym_index_prefer(symbolicator, image, entry)) {
+            image->file = file;
+            image->offset = entry->offset;
+            image->size = entry->size;
+            image->has_debug_line = entry->has_debug_line;
+            image->is_cache = entry->is_cache;
+        }
+
+        return PLCRASH_ESUCCESS;
+    }
+
+    if (symbolicator->image_count == symbolicator->image_capacity) {
+        size_t capacity = symbolicator->image_capacity > 0 ? symbolicator->image_capacity * 2 : 16;
+        struct plcrash_symbolicator_image *images = realloc(symbolicator->images, capacity * sizeof(*images));
+
+        if (images == NULL)
+            return PLCRASH_ENOMEM;
+
+        symbolicator->images = images;
+        symbolicator->image_capacity = capacity;
+    }
+
+    image = &symbolicator->images[symbolicator->image_count];
+    memset(image, 0, sizeof(*image));
+    memcpy(image->uuid, entry->uuid, entry->uuid_length);
+    image->uuid_length = entry->uuid_length;
+    image->file = file;
+    image->offset = entry->offset;
+    image->size = entry->size;
+    image->has_debug_line = entry->has_debug_line;
+    image->is_cache = entry->is_cache;
+
+    *bucket = ++symbolicator->image_count;
+
+    /* Keep the load factor at or below 1/2 */
+    if (symbolicator->image_count * 2 > symbolicator->bucket_count && !sym_grow_buckets(symbolicator))
+        return PLCRASH_ENOMEM;
+
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * @internal
+ * Index context for sym_index_object().
+ */
+typedef struct sym_index_ctx {
+    plcrash_symbolicator_t *symbolicator;
+
+    /** Index of the file being indexed */
+    size_t file;
+
+    /** Number of images found in the file */
+    size_t found;
+} sym_index_ctx_t;
+
+/**
+ * @internal
+ * Add an object to the index.
+ */
+static plcrash_error_t sym_index_object (const sym_object_t *obj, uint64_t offset, uint64_t size, void *ctx) {
+    sym_index_ctx_t *index = ctx;
+    sym_index_entry_t entry;
+
+    /* Images must be identified */
+    if (obj->uuid_length == 0)
+        return PLCRASH_ESUCCESS;
+
+    index->found++;
+
+    entry.uuid = obj->uuid;
+    entry.uuid_length = obj->uuid_length;
+    entry.offset = offset;
+    entry.size = size;
+    entry.has_debug_line = (obj->dwarf.debug_line != NULL);
+    entry.is_cache = false;
+
+    return sym_index_image(index->symbolicator, index->file, &entry);
+}
+
+/**
+ * @internal
+ * Map @a path read-only.
+ */
+static plcrash_error_t sym_map_file (const char *path, const uint8_t **map, size_t *size) {
+    struct stat sb;
+    void *addr;
+    int fd;
+
+    if ((fd = open(path, O_RDONLY)) == -1)
+        return PLCRASH_EINVAL;
+
+    if (fstat(fd, &sb) != 0 || !S_ISREG(sb.st_mode) || sb.st_size <= 0) {
+        close(fd);
+        return PLCRASH_EINVAL;
+    }
+
+    addr = mmap(NULL, (size_t) sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (addr == MAP_FAILED)
+        return PLCRASH_EINVAL;
+
+    *map = addr;
+    *size = (size_t) sb.st_size;
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * @internal
+ * Index the objects within the regular file at @a path.
+ *
+ * @return Returns PLCRASH_ENOTSUP if the file contains no identifiable objects.
+ */
+static plcrash_error_t sym_add_file (plcrash_symbolicator_t *symbolicator, const char *path) {
+    struct plcrash_symbolicator_file *file;
+    plcrash_symcache_t cache;
+    sym_index_ctx_t ctx;
+    const uint8_t *map;
+    plcrash_error_t err;
+    size_t size;
+
+    if (symbolicator->file_count == symbolicator->file_capacity) {
+        size_t capacity = symbolicator->file_capacity > 0 ? symbolicator->file_capacity * 2 : 16;
+        struct plcrash_symbolicator_file *files = realloc(symbolicator->files, capacity * sizeof(*files));
+
+        if (files == NULL)
+            return PLCRASH_ENOMEM;
+
+        symbolicator->files = files;
+        symbolicator->file_capacity = capacity;
+    }
+
+    if ((err = sym_map_file(path, &map, &size)) != PLCRASH_ESUCCESS)
+        return err;
+
+    /* Record the file before indexing, as its images refer to it; the file is mapped again when one of its
+     * images is first used */
+    file = &symbolicator->files[symbolicator->file_count];
+    file->map = NULL;
+    file->size = 0;
+    if ((file->path = strdup(path)) == NULL) {
+        munmap((void *) map, size);
+        return PLCRASH_ENOMEM;
+    }
+
+    ctx.symbolicator = symbolicator;
+    ctx.file = symbolicator->file_count++;
+    ctx.found = 0;
+
+    /* Symbol caches describe a single image */
+    err = plcrash_symcache_init(&cache, map, size);
+    if (err == PLCRASH_ESUCCESS) {
+        sym_index_entry_t entry = { cache.uuid, cache.uuid_length, 0, size, cache.line_count > 0, true };
+
+        ctx.found++;
+        err = sym_index_image(symbolicator, ctx.file, &entry);
+    } else if (err == PLCRASH_ENOTSUP) {
+        err = sym_parse_file(map, size, sym_index_object, &ctx);
+    }
+
+    munmap((void *) map, size);
+
+    if (err == PLCRASH_ESUCCESS && ctx.found == 0)
+        err = PLCRASH_ENOTSUP;
+
+    /* Forget files that provided no images */
+    if (err != PLCRASH_ESUCCESS && ctx.found == 0) {
+        free(file->path);
+        symbolicator->file_count--;
+    }
+
+    return err;
+}
+
+/**
+ * @internal
+ * Recursively index the files within the directory at @a path.
+ */
+static plcrash_error_t sym_add_directory (plcrash_symbolicator_t *symbolicator, const char *path, int depth) {
+    struct dirent *entry;
+    plcrash_error_t err = PLCRASH_ESUCCESS;
+    DIR *dir;
+
+    if (depth > SYM_MAX_DEPTH || (dir = opendir(path)) == NULL)
+        return PLCRASH_ESUCCESS;
+
+    while (err == PLCRASH_ESUCCESS && (entry = readdir(dir)) != NULL) {
+        size_t length = strlen(path) + strlen(entry->d_name) + 2;
+        struct stat sb;
+        char *child;
+
+        /* Skip hidden files, and the . and .. entries */
+        if (entry->d_name[0] == '.')
+            continue;
+
+        if ((child = malloc(length)) == NULL) {
+            err = PLCRASH_ENOMEM;
+            break;
+        }
+        snprintf(child, length, "%s/%s", path, entry->d_name);
+
+        /* Symbolic links are followed to files, but not to directories */
+        if (lstat(child, &sb) == 0) {
+            if (S_ISDIR(sb.st_mode)) {
+                err = sym_add_directory(symbolicator, child, depth + 1);
+            } else if (S_ISREG(sb.st_mode) || (S_ISLNK(sb.st_mode) && stat(child, &sb) == 0 && S_ISREG(sb.st_mode))) {
+                err = sym_add_file(symbolicator, child);
+
+                /* Unsupported and unreadable files within a directory are ignored */
+                if (err != PLCRASH_ENOMEM)
+                    err = PLCRASH_ESUCCESS;
+            }
+        }
+
+        free(child);
+    }
+
+    closedir(dir);
+    return err;
+}
+
+/**
+ * Initialize a symbolicator.
+ *
+ * @param symbolicator The symbolicator to initialize.
+ * @param line_info If true, DWARF line tables will be used to resolve source locations.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, or PLCRASH_ENOMEM if memory could not be allocated.
+ */
+plcrash_error_t plcrash_symbolicator_init (plcrash_symbolicator_t *symbolicator, bool line_info) {
+    memset(symbolicator, 0, sizeof(*symbolicator));
+    symbolicator->line_info = line_info;
+
+    symbolicator->bucket_count = 64;
+    symbolicator->buckets = calloc(symbolicator->bucket_count, sizeof(size_t));
+    if (symbolicator->buckets == NULL)
+        return PLCRASH_ENOMEM;
+
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * Index the symbol files at @a path. If @a path is a directory, it is searched recursively (including dSYM
+ * bundles), and any files that are not supported object files are ignored.
+ *
+ * If more than one file provides the same image UUID, the first is used, unless line information was requested
+ * and only a later file includes a line table.
+ *
+ * @param symbolicator The symbolicator.
+ * @param path A Mach-O, universal or ELF file, or a directory.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, PLCRASH_EINVAL if @a path could not be read, PLCRASH_ENOTSUP if
+ * @a path is a file that contains no identifiable objects, or PLCRASH_ENOMEM if memory could not be allocated.
+ */
+plcrash_error_t plcrash_symbolicator_add_path (plcrash_symbolicator_t *symbolicator, const char *path) {
+    struct stat sb;
+
+    if (stat(path, &sb) != 0)
+        return PLCRASH_EINVAL;
+
+    if (S_ISDIR(sb.st_mode))
+        return sym_add_directory(symbolicator, path, 0);
+
+    return sym_add_file(symbolicator, path);
+}
+
+/**
+ * Return the number of images that have been indexed.
+ *
+ * @param symbolicator The symbolicator.
+ */
+size_t plcrash_symbolicator_image_count (const plcrash_symbolicator_t *symbolicator) {
+    return symbolicator->image_count;
+}
+
+/**
+ * @internal
+ * Order symbols by address, then by preference.
+ */
+static int sym_symbol_compare (const void *a, const void *b) {
+    const sym_symbol_t *sym1 = a;
+    const sym_symbol_t *sym2 = b;
+
+    if (sym1->address != sym2->address)
+        return sym1->address < sym2->address ? -1 : 1;
+
+    if (sym1->rank != sym2->rank)
+        return sym1->rank < sym2->rank ? -1 : 1;
+
+    return strcmp(sym1->name, sym2->name);
+}
+
+/**
+ * @internal
+ * Return the symbol table string at @a offset, or NULL if it is empty or out of bounds.
+ */
+static const char *sym_string (const sym_object_t *obj, uint64_t offset) {
+    if (offset >= obj->strtab_size || obj->strtab[offset] == '\0')
+        return NULL;
+
+    if (memchr(obj->strtab + offset, '\0', obj->strtab_size - (size_t) offset) == NULL)
+        return NULL;
+
+    return (const char *) obj->strtab + offset;
+}
+
+/**
+ * @internal
+ * Build the sorted symbol table of @a image from @a obj.
+ */
+static plcrash_error_t sym_build_symbols (struct plcrash_symbolicator_image *image, const sym_object_t *obj) {
+    sym_symbol_t *symbols;
+    size_t count = 0;
+    size_t unique = 0;
+
+    if (obj->symtab == NULL || obj->symtab_count == 0)
+        return PLCRASH_ESUCCESS;
+
+    if ((symbols = malloc(obj->symtab_count * sizeof(sym_symbol_t))) == NULL)
+        return PLCRASH_ENOMEM;
+
+    for (size_t i = 0; i < obj->symtab_count; i++) {
+        const uint8_t *entry = obj->symtab + i * obj->symtab_entsize;
+        sym_symbol_t *symbol = &symbols[count];
+        const char *name;
+
+        if (obj->format == SYM_FORMAT_MACHO) {
+            uint32_t strx = sym_read32(entry, obj->big_endian);
+            uint8_t type = entry[4];
+            uint8_t sect = entry[5];
+
+            /* Defined symbols within the __TEXT segment */
+            if ((type & SYM_N_STAB) != 0 || (type & SYM_N_TYPE) != SYM_N_SECT)
+                continue;
+            if (sect < obj->text_sect_first || sect > obj->text_sect_last)
+                continue;
+
+            if ((name = sym_string(obj, strx)) == NULL)
+                continue;
+
+            /* C symbol names carry a leading underscore */
+            if (name[0] == '_' && name[1] != '\0')
+                name++;
+
+            symbol->address = sym_read_word(entry + 8, obj->is_64, obj->big_endian);
+            symbol->size = 0;
+            symbol->rank = (type & SYM_N_EXT) ? 0 : 1;
+        } else {
+            uint32_t strx = sym_read32(entry, obj->big_endian);
+            uint8_t info = entry[obj->is_64 ? 4 : 12];
+            uint16_t shndx = sym_read16(entry + (obj->is_64 ? 6 : 14), obj->big_endian);
+            uint8_t binding = info >> 4;
+
+            /* Defined functions */
+            if ((info & 0x0f) != SYM_STT_FUNC || shndx == 0)
+                continue;
+
+            if ((name = sym_string(obj, strx)) == NULL)
+                continue;
+
+            symbol->address = sym_read_word(entry + (obj->is_64 ? 8 : 4), obj->is_64, obj->big_endian);
+            symbol->size = sym_read_word(entry + (obj->is_64 ? 16 : 8), obj->is_64, obj->big_endian);
+            symbol->rank = (binding == SYM_STB_GLOBAL) ? 0 : (binding == SYM_STB_WEAK) ? 1 : 2;
+
+            /* The low bit of ARM function addresses marks Thumb code */
+            if (obj->machine == SYM_EM_ARM)
+                symbol->address &= ~(uint64_t) 1;
+        }
+
+        if (symbol->address == 0)
+            continue;
+
+        symbol->name = name;
+        count++;
+    }
+
+    qsort(symbols, count, sizeof(sym_symbol_t), sym_symbol_compare);
+
+    /* Keep the preferred symbol at each address, and bound symbols without a size by the next symbol */
+    for (size_t i = 0; i < count; i++) {
+        if (unique > 0 && symbols[unique - 1].address == symbols[i].address) {
+            if (symbols[unique - 1].size == 0)
+                symbols[unique - 1].size = symbols[i].size;
+            continue;
+        }
+
+        symbols[unique++] = symbols[i];
+    }
+
+    for (size_t i = 0; i < unique; i++) {
+        uint64_t end = (i + 1 < unique) ? symbols[i + 1].address : obj->text_end;
+
+        if (symbols[i].size == 0 && end > symbols[i].address)
+            symbols[i].size = end - symbols[i].address;
+    }
+
+    image->symbols = symbols;
+    image->symbol_count = unique;
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * @internal
+ * Load context for sym_load_object().
+ */
+typedef struct sym_load_ctx {
+    const plcrash_symbolicator_t *symbolicator;
+    struct plcrash_symbolicator_image *image;
+    plcrash_error_t err;
+    bool found;
+} sym_load_ctx_t;
+
+/**
+ * @internal
+ * Build the tables of the object matching the image being loaded.
+ */
+static plcrash_error_t sym_load_object (const sym_object_t *obj, uint64_t offset, uint64_t size, void *ctx) {
+    sym_load_ctx_t *load = ctx;
+    struct plcrash_symbolicator_image *image = load->image;
+    plcrash_error_t err;
+
+    /* Objects are matched by offset and UUID alone */
+    (void) size;
+
+    if (offset != image->offset || obj->uuid_length != image->uuid_length || memcmp(obj->uuid, image->uuid, obj->uuid_length) != 0)
+        return PLCRASH_ESUCCESS;
+
+    load->found = true;
+    image->link_base = obj->link_base;
+
+    if ((err = sym_build_symbols(image, obj)) != PLCRASH_ESUCCESS)
+        return err;
+
+    if (load->symbolicator->line_info && obj->dwarf.debug_line != NULL) {
+        if ((err = plcrash_dwarf_line_table_init(&image->lines, &obj->dwarf)) != PLCRASH_ESUCCESS)
+            return err;
+    }
+
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * @internal
+ * Build the symbol and line tables of @a image, mapping its file if required.
+ */
+static plcrash_error_t sym_load_image (plcrash_symbolicator_t *symbolicator, struct plcrash_symbolicator_image *image) {
+    struct plcrash_symbolicator_file *file = &symbolicator->files[image->file];
+    sym_load_ctx_t ctx = { symbolicator, image, PLCRASH_ESUCCESS, false };
+    plcrash_error_t err;
+
+    if (image->state != SYM_IMAGE_UNLOADED)
+        return PLCRASH_ESUCCESS;
+
+    /* Files are mapped for the lifetime of the symbolicator; symbol names and line tables refer to the mapping */
+    if (file->map == NULL && sym_map_file(file->path, &file->map, &file->size) != PLCRASH_ESUCCESS) {
+        image->state = SYM_IMAGE_FAILED;
+        return PLCRASH_ESUCCESS;
+    }
+
+    /* Symbol caches are used in place */
+    if (image->is_cache) {
+        image->state = SYM_IMAGE_FAILED;
+        if (plcrash_symcache_init(&image->cache, file->map, file->size) == PLCRASH_ESUCCESS &&
+            image->cache.uuid_length == image->uuid_length && memcmp(image->cache.uuid, image->uuid, image->uuid_length) == 0)
+        {
+            image->link_base = image->cache.link_base;
+            image->state = SYM_IMAGE_LOADED;
+        }
+
+        return PLCRASH_ESUCCESS;
+    }
+
+    err = sym_parse_file(file->map, file->size, sym_load_object, &ctx);
+    if (err == PLCRASH_ENOMEM)
+        return err;
+
+    image->state = (err == PLCRASH_ESUCCESS && ctx.found) ? SYM_IMAGE_LOADED : SYM_IMAGE_FAILED;
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * @internal
+ * Look up the symbol containing the link-time @a address in a symbol table built from an object file.
+ */
+static const sym_symbol_t *sym_lookup_symbol (const struct plcrash_symbolicator_image *image, uint64_t address) {
+    size_t lo = 0;
+    size_t hi = image->symbol_count;
+
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+
+        if (image->symbols[mid].address <= address)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    if (lo == 0)
+        return NULL;
+
+    /* Symbols of unknown size extend to the next symbol */
+    if (image->symbols[lo - 1].size != 0 && address - image->symbols[lo - 1].address >= image->symbols[lo - 1].size)
+        return NULL;
+
+    return &image->symbols[lo - 1];
+}
+
+/**
+ * @internal
+ * Look up the name and start address of the symbol containing the link-time @a address.
+ */
+static bool sym_image_lookup_symbol (const struct plcrash_symbolicator_image *image, uint64_t address, const char **name, uint64_t *symbol_address) {
+    const sym_symbol_t *symbol;
+
+    if (image->is_cache)
+        return plcrash_symcache_lookup_symbol(&image->cache, address, name, symbol_address);
+
+    if ((symbol = sym_lookup_symbol(image, address)) == NULL)
+        return false;
+
+    *name = symbol->name;
+    *symbol_address = symbol->address;
+    return true;
+}
+
+/**
+ * @internal
+ * Look up the source location of the link-time @a address.
+ */
+static bool sym_image_lookup_line (const plcrash_symbolicator_t *symbolicator, const struct plcrash_symbolicator_image *image,
+                                   uint64_t address, const char **file, uint32_t *line)
+{
+    if (!symbolicator->line_info)
+        return false;
+
+    if (image->is_cache)
+        return plcrash_symcache_lookup_line(&image->cache, address, file, line);
+
+    return plcrash_dwarf_line_table_lookup(&image->lines, address, file, line);
+}
+
+/**
+ * @internal
+ * Report image sort key.
+ */
+typedef struct sym_report_image {
+    /** Image base address */
+    uint64_t base_address;
+
+    /** Image end address (exclusive) */
+    uint64_t end_address;
+
+    /** Index in plcrash_report_t::images */
+    size_t index;
+} sym_report_image_t;
+
+/**
+ * @internal
+ * Order report images by base address, then by report order.
+ */
+static int sym_report_image_compare (const void *a, const void *b) {
+    const sym_report_image_t *img1 = a;
+    const sym_report_image_t *img2 = b;
+
+    if (img1->base_address != img2->base_address)
+        return img1->base_address < img2->base_address ? -1 : 1;
+
+    return img1->index < img2->index ? -1 : (img1->index > img2->index);
+}
+
+/**
+ * @internal
+ * Frame resolution state for a single report.
+ */
+typedef struct sym_report_ctx {
+    const plcrash_symbolicator_t *symbolicator;
+    const plcrash_report_t *report;
+
+    /** Report images, sorted by base address */
+    sym_report_image_t *sorted;
+
+    /** True if report images overlap; lookups then use plcrash_report_image_for_address() */
+    bool overlapping;
+
+    /** Symbolicator image for each report image, or NULL */
+    struct plcrash_symbolicator_image **matched;
+
+    /** Total length of the strings referenced by resolved symbols, including terminators */
+    size_t string_bytes;
+} sym_report_ctx_t;
+
+/**
+ * @internal
+ * Return the index of the report image containing @a address, or -1.
+ */
+static ssize_t sym_report_image_lookup (const sym_report_ctx_t *ctx, uint64_t address) {
+    const plcrash_report_t *report = ctx->report;
+    size_t lo = 0;
+    size_t hi = report->image_count;
+
+    if (ctx->overlapping) {
+        const plcrash_report_image_t *image = plcrash_report_image_for_address(report, address);
+        return image != NULL ? (ssize_t) (image - report->images) : -1;
+    }
+
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+
+        if (ctx->sorted[mid].base_address <= address)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    if (lo == 0 || address >= ctx->sorted[lo - 1].end_address)
+        return -1;
+
+    return (ssize_t) ctx->sorted[lo - 1].index;
+}
+
+/**
+ * @internal
+ * Resolve the frames @a frame_index..@a frame_index + @a frame_count of a single backtrace. All frames but the
+ * first hold return addresses, and are looked up at the preceding instruction.
+ */
+static void sym_resolve_frames (sym_report_ctx_t *ctx, plcrash_report_symbol_t *symbols, size_t frame_index, size_t frame_count) {
+    const plcrash_report_t *report = ctx->report;
+
+    for (size_t i = 0; i < frame_count; i++) {
+        uint64_t pc = report->frames[frame_index + i].pc;
+        plcrash_report_symbol_t *symbol = &symbols[frame_index + i];
+        const struct plcrash_symbolicator_image *image;
+        uint64_t symbol_address;
+        uint64_t address;
+        ssize_t image_index;
+
+        if ((image_index = sym_report_image_lookup(ctx, pc)) < 0 || (image = ctx->matched[image_index]) == NULL)
+            continue;
+
+        /* Translate to the image's link-time address space */
+        address = pc - report->images[image_index].base_address + image->link_base;
+        if (i > 0 && address > 0)
+            address--;
+
+        if (!sym_image_lookup_symbol(image, address, &symbol->name, &symbol_address))
+            continue;
+
+        symbol->offset = pc - report->images[image_index].base_address + image->link_base - symbol_address;
+        ctx->string_bytes += strlen(symbol->name) + 1;
+
+        if (sym_image_lookup_line(ctx->symbolicator, image, address, &symbol->file, &symbol->line))
+            ctx->string_bytes += strlen(symbol->file) + 1;
+    }
+}
+
+/**
+ * @internal
+ * Copy @a str to @a *strings, advancing @a *strings.
+ */
+static const char *sym_copy_string (char **strings, const char *str) {
+    size_t length = strlen(str) + 1;
+    char *copy = *strings;
+
+    memcpy(copy, str, length);
+    *strings += length;
+    return copy;
+}
+
+/**
+ * Resolve all stack frames of @a report, replacing any existing plcrash_report_t::symbols. Images are matched
+ * by UUID; frames in images that have not been indexed are left unresolved.
+ *
+ * The symbols are owned by the report, and remain valid after the symbolicator is freed.
+ *
+ * @param symbolicator The symbolicator.
+ * @param report The report to symbolicate.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, or PLCRASH_ENOMEM if memory could not be allocated.
+ */
+plcrash_error_t plcrash_symbolicator_symbolicate (plcrash_symbolicator_t *symbolicator, plcrash_report_t *report) {
+    sym_report_ctx_t ctx;
+    plcrash_report_symbol_t *resolved;
+    plcrash_report_symbol_t *symbols;
+    plcrash_error_t err = PLCRASH_ESUCCESS;
+    size_t image_slots = report->image_count > 0 ? report->image_count : 1;
+    uint64_t max_end = 0;
+    char *strings;
+
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.symbolicator = symbolicator;
+    ctx.report = report;
+    ctx.sorted = malloc(image_slots * sizeof(sym_report_image_t));
+    ctx.matched = calloc(image_slots, sizeof(struct plcrash_symbolicator_image *));
+    resolved = calloc(report->frame_count > 0 ? report->frame_count : 1, sizeof(plcrash_report_symbol_t));
+    if (ctx.sorted == NULL || ctx.matched == NULL || resolved == NULL) {
+        err = PLCRASH_ENOMEM;
+        goto cleanup;
+    }
+
+    /* Match and load the report's images */
+    for (size_t i = 0; i < report->image_count; i++) {
+        const plcrash_report_image_t *image = &report->images[i];
+        size_t *bucket;
+
+        ctx.sorted[i].base_address = image->base_address;
+        ctx.sorted[i].end_address = image->base_address + image->size;
+        ctx.sorted[i].index = i;
+
+        if (image->uuid == NULL || image->uuid_length == 0 || image->uuid_length > PLCRASH_SYMBOLICATOR_UUID_MAX)
+            continue;
+
+        bucket = sym_find_bucket(symbolicator, image->uuid, image->uuid_length);
+        if (*bucket == 0)
+            continue;
+
+        if ((err = sym_load_image(symbolicator, &symbolicator->images[*bucket - 1])) != PLCRASH_ESUCCESS)
+            goto cleanup;
+
+        if (symbolicator->images[*bucket - 1].state == SYM_IMAGE_LOADED)
+            ctx.matched[i] = &symbolicator->images[*bucket - 1];
+    }
+
+    qsort(ctx.sorted, report->image_count, sizeof(sym_report_image_t), sym_report_image_compare);
+    for (size_t i = 0; i < report->image_count; i++) {
+        if (i > 0 && ctx.sorted[i].base_address < max_end)
+            ctx.overlapping = true;
+
+        if (ctx.sorted[i].end_address > max_end)
+            max_end = ctx.sorted[i].end_address;
+    }
+
+    /* Resolve each backtrace */
+    for (size_t i = 0; i < report->thread_count; i++)
+        sym_resolve_frames(&ctx, resolved, report->threads[i].frame_index, report->threads[i].frame_count);
+
+    if (report->has_exception_info)
+        sym_resolve_frames(&ctx, resolved, report->exception_info.frame_index, report->exception_info.frame_count);
+
+    /* Copy the symbols and their strings into a single allocation owned by the report */
+    symbols = malloc(report->frame_count * sizeof(plcrash_report_symbol_t) + ctx.string_bytes + 1);
+    if (symbols == NULL) {
+        err = PLCRASH_ENOMEM;
+        goto cleanup;
+    }
+
+    strings = (char *) (symbols + report->frame_count);
+    for (size_t i = 0; i < report->frame_count; i++) {
+        symbols[i] = resolved[i];
+
+        if (resolved[i].name != NULL)
+            symbols[i].name = sym_copy_string(&strings, resolved[i].name);
+
+        if (resolved[i].file != NULL)
+            symbols[i].file = sym_copy_string(&strings, resolved[i].file);
+    }
+
+    free(report->symbols);
+    report->symbols = symbols;
+
+cleanup:
+    free(ctx.sorted);
+    free(ctx.matched);
+    free(resolved);
+
+    return err;
+}
+
+/**
+ * @internal
+ * Release the symbol and line tables of a loaded image.
+ */
+static void sym_unload_image (struct plcrash_symbolicator_image *image) {
+    free(image->symbols);
+    image->symbols = NULL;
+    image->symbol_count = 0;
+
+    plcrash_dwarf_line_table_free(&image->lines);
+    image->state = SYM_IMAGE_UNLOADED;
+}
+
+/**
+ * @internal
+ * Write the symbol cache of the loaded @a image to @a path, replacing any existing file atomically.
+ */
+static plcrash_error_t sym_write_cache (const plcrash_symbolicator_t *symbolicator, const struct plcrash_symbolicator_image *image, const char *path) {
+    plcrash_symcache_symbol_t *symbols;
+    plcrash_error_t err;
+    size_t length = strlen(path) + sizeof(".XXXXXX");
+    char *temp;
+    int fd;
+
+    symbols = malloc((image->symbol_count > 0 ? image->symbol_count : 1) * sizeof(plcrash_symcache_symbol_t));
+    temp = malloc(length);
+    if (symbols == NULL || temp == NULL) {
+        free(symbols);
+        free(temp);
+        return PLCRASH_ENOMEM;
+    }
+
+    for (size_t i = 0; i < image->symbol_count; i++) {
+        symbols[i].address = image->symbols[i].address;
+        symbols[i].size = image->symbols[i].size;
+        symbols[i].name = image->symbols[i].name;
+    }
+
+    snprintf(temp, length, "%s.XXXXXX", path);
+    if ((fd = mkstemp(temp)) == -1) {
+        free(symbols);
+        free(temp);
+        return PLCRASH_OUTPUT_ERR;
+    }
+
+    err = plcrash_symcache_write(fd, image->uuid, image->uuid_length, image->link_base, symbols, image->symbol_count,
+                                 symbolicator->line_info ? &image->lines : NULL);
+
+    if (err == PLCRASH_ESUCCESS && fchmod(fd, 0644) != 0)
+        err = PLCRASH_OUTPUT_ERR;
+
+    if (close(fd) != 0 && err == PLCRASH_ESUCCESS)
+        err = PLCRASH_OUTPUT_ERR;
+
+    if (err == PLCRASH_ESUCCESS && rename(temp, path) != 0)
+        err = PLCRASH_OUTPUT_ERR;
+
+    if (err != PLCRASH_ESUCCESS) {
+        int errnum = errno;
+        unlink(temp);
+        errno = errnum;
+    }
+
+    free(symbols);
+    free(temp);
+    return err;
+}
+
+/**
+ * Write a symbol cache for each indexed image that is backed by an object file. Each cache is written to
+ * @a directory, named by its image's upper-case hexadecimal UUID with the #PLCRASH_SYMCACHE_EXTENSION extension,
+ * replacing any existing cache for the image. Line runs are included if the symbolicator was initialized with
+ * line information enabled.
+ *
+ * Adding the resulting directory to a symbolicator allows the images to be used without parsing their object
+ * files or debug information.
+ *
+ * @param symbolicator The symbolicator.
+ * @param directory The directory to write to.
+ * @param count On return, the number of caches written.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, PLCRASH_OUTPUT_ERR if a cache could not be written (the error is
+ * available via errno), or PLCRASH_ENOMEM if memory could not be allocated.
+ */
+plcrash_error_t plcrash_symbolicator_write_caches (plcrash_symbolicator_t *symbolicator, const char *directory, size_t *count) {
+    size_t length = strlen(directory) + 2 * PLCRASH_SYMBOLICATOR_UUID_MAX + sizeof("/." PLCRASH_SYMCACHE_EXTENSION);
+    plcrash_error_t err = PLCRASH_ESUCCESS;
+    char *path;
+
+    *count = 0;
+    if ((path = malloc(length)) == NULL)
+        return PLCRASH_ENOMEM;
+
+    for (size_t i = 0; i < symbolicator->image_count && err == PLCRASH_ESUCCESS; i++) {
+        struct plcrash_symbolicator_image *image = &symbolicator->images[i];
+        bool was_loaded = (image->state == SYM_IMAGE_LOADED);
+        size_t offset;
+
+        if (image->is_cache)
+            continue;
+
+        if ((err = sym_load_image(symbolicator, image)) != PLCRASH_ESUCCESS)
+            break;
+
+        if (image->state != SYM_IMAGE_LOADED)
+            continue;
+
+        offset = (size_t) snprintf(path, length, "%s/", directory);
+        for (size_t j = 0; j < image->uuid_length; j++)
+            offset += (size_t) snprintf(path + offset, length - offset, "%02X", image->uuid[j]);
+        snprintf(path + offset, length - offset, "." PLCRASH_SYMCACHE_EXTENSION);
+
+        if ((err = sym_write_cache(symbolicator, image, path)) == PLCRASH_ESUCCESS)
+            (*count)++;
+
+        /* Images loaded only to be written are released, bounding memory use to a single image */
+        if (!was_loaded)
+            sym_unload_image(image);
+    }
+
+    free(path);
+    return err;
+}
+
+/**
+ * Free all storage associated with @a symbolicator, and unmap all files.
+ *
+ * @param symbolicator The symbolicator to free.
+ */
+void plcrash_symbolicator_free (plcrash_symbolicator_t *symbolicator) {
+    for (size_t i = 0; i < symbolicator->image_count; i++) {
+        free(symbolicator->images[i].symbols);
+        plcrash_dwarf_line_table_free(&symbolicator->images[i].lines);
+    }
+
+    for (size_t i = 0; i < symbolicator->file_count; i++) {
+        if (symbolicator->files[i].map != NULL)
+            munmap((void *) symbolicator->files[i].map, symbolicator->files[i].size);
+        free(symbolicator->files[i].path);
+    }
+
+    free(symbolicator->images);
+    free(symbolicator->files);
+    free(symbolicator->buckets);
+    memset(symbolicator, 0, sizeof(*symbolicator));
+}
+
+/**
+ * @} plcrash_symbolicator
+ */
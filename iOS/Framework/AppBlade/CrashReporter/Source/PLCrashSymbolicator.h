@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2008-2011 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef PLCRASH_SYMBOLICATOR_H
+#define PLCRASH_SYMBOLICATOR_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#import "PLCrashAsync.h"
+#include "PLCrashReportCore.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @internal
+ * @defgroup plcrash_symbolicator Offline Symbolication
+ *
+ * Resolves the stack frames of decoded reports to symbol names and, optionally, DWARF source locations, using
+ * local Mach-O (including universal binaries and dSYM bundles) and ELF files.
+ *
+ * Files are indexed by their Mach-O UUID or ELF build-id when added, reading only their headers. An image's
+ * symbol table and line table are built on first use and then retained, so that any number of reports may be
+ * symbolicated against the same binaries without reparsing them. Symbol names refer directly to the
+ * memory-mapped files.
+ *
+ * Symbol caches (PLCrashSymbolCache.h), written by plcrash_symbolicator_write_caches(), may be added in place
+ * of object files. Caches are searched in place, without parsing, and are preferred over object files with the
+ * same UUID unless only the object file provides requested line information.
+ *
+ * The base address of an ELF image is the virtual address of its lowest PT_LOAD segment.
+ *
+ * @{
+ */
+
+/** Maximum supported image UUID / build-id length, in bytes */
+#define PLCRASH_SYMBOLICATOR_UUID_MAX 32
+
+/**
+ * Offline symbolicator. All fields are private.
+ */
+typedef struct plcrash_symbolicator {
+    /** @internal True if DWARF line tables should be used */
+    bool line_info;
+
+    /** @internal Indexed files */
+    struct plcrash_symbolicator_file *files;
+    size_t file_count;
+    size_t file_capacity;
+
+    /** @internal Indexed images */
+    struct plcrash_symbolicator_image *images;
+    size_t image_count;
+    size_t image_capacity;
+
+    /** @internal Open-addressed hash table mapping UUIDs to image index + 1 (0 marks an empty bucket) */
+    size_t *buckets;
+    size_t bucket_count;
+} plcrash_symbolicator_t;
+
+plcrash_error_t plcrash_symbolicator_init (plcrash_symbolicator_t *symbolicator, bool line_info);
+plcrash_error_t plcrash_symbolicator_add_path (plcrash_symbolicator_t *symbolicator, const char *path);
+size_t plcrash_symbolicator_image_count (const plcrash_symbolicator_t *symbolicator);
+plcrash_error_t plcrash_symbolicator_symbolicate (plcrash_symbolicator_t *symbolicator, plcrash_report_t *report);
+plcrash_error_t plcrash_symbolicator_write_caches (plcrash_symbolicator_t *symbolicator, const char *directory, size_t *count);
+void plcrash_symbolicator_free (plcrash_symbolicator_t *symbolicator);
+
+/**
+ * @} plcrash_symbolicator
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PLCRASH_SYMBOLICATOR_H */
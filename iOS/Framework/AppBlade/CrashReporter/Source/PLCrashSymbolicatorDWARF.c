@@ -0,0 +1,738 @@
+/*
+ * Copyright (c) 2008-2011 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PLCrashSymbolicatorDWARF.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @internal
+ * @ingroup plcrash_symbolicator
+ * @{
+ */
+
+/* Standard opcodes (DWARF 5, section 6.2.5.2) */
+enum {
+    DW_LNS_copy = 1,
+    DW_LNS_advance_pc = 2,
+    DW_LNS_advance_line = 3,
+    DW_LNS_set_file = 4,
+    DW_LNS_const_add_pc = 8,
+    DW_LNS_fixed_advance_pc = 9
+};
+
+/* Extended opcodes (DWARF 5, section 6.2.5.3) */
+enum {
+    DW_LNE_end_sequence = 1,
+    DW_LNE_set_address = 2,
+    DW_LNE_define_file = 3
+};
+
+/* Line number header entry content types (DWARF 5, section 6.2.4.1) */
+enum {
+    DW_LNCT_path = 1
+};
+
+/* Attribute forms used by DWARF 5 line number headers */
+enum {
+    DW_FORM_block2 = 0x03,
+    DW_FORM_block4 = 0x04,
+    DW_FORM_data2 = 0x05,
+    DW_FORM_data4 = 0x06,
+    DW_FORM_data8 = 0x07,
+    DW_FORM_string = 0x08,
+    DW_FORM_block = 0x09,
+    DW_FORM_block1 = 0x0a,
+    DW_FORM_data1 = 0x0b,
+    DW_FORM_sdata = 0x0d,
+    DW_FORM_strp = 0x0e,
+    DW_FORM_udata = 0x0f,
+    DW_FORM_data16 = 0x1e,
+    DW_FORM_line_strp = 0x1f
+};
+
+/**
+ * @internal
+ * Bounds-checked section reader. Reads past the end of the section return 0 and clear @a ok.
+ */
+typedef struct dwarf_reader {
+    /** Current position */
+    const uint8_t *p;
+
+    /** End of the readable range */
+    const uint8_t *end;
+
+    /** True if multi-byte values are big-endian */
+    bool big_endian;
+
+    /** False once a read has failed */
+    bool ok;
+} dwarf_reader_t;
+
+/**
+ * @internal
+ * Read an unsigned value of @a size (1-8) bytes.
+ */
+static uint64_t dwarf_read_uint (dwarf_reader_t *r, size_t size) {
+    uint64_t value = 0;
+
+    if (!r->ok || size > 8 || (size_t) (r->end - r->p) < size) {
+        r->ok = false;
+        return 0;
+    }
+
+    for (size_t i = 0; i < size; i++) {
+        size_t shift = r->big_endian ? (size - 1 - i) * 8 : i * 8;
+        value |= (uint64_t) r->p[i] << shift;
+    }
+
+    r->p += size;
+    return value;
+}
+
+/**
+ * @internal
+ * Read an unsigned LEB128 value.
+ */
+static uint64_t dwarf_read_uleb (dwarf_reader_t *r) {
+    uint64_t value = 0;
+    unsigned shift = 0;
+
+    while (r->ok && r->p < r->end) {
+        uint8_t byte = *r->p++;
+
+        if (shift < 64)
+            value |= (uint64_t) (byte & 0x7f) << shift;
+        shift += 7;
+
+        if ((byte & 0x80) == 0)
+            return value;
+    }
+
+    r->ok = false;
+    return 0;
+}
+
+/**
+ * @internal
+ * Read a signed LEB128 value.
+ */
+static int64_t dwarf_read_sleb (dwarf_reader_t *r) {
+    uint64_t value = 0;
+    unsigned shift = 0;
+
+    while (r->ok && r->p < r->end) {
+        uint8_t byte = *r->p++;
+
+        if (shift < 64)
+            value |= (uint64_t) (byte & 0x7f) << shift;
+        shift += 7;
+
+        if ((byte & 0x80) == 0) {
+            if (shift < 64 && (byte & 0x40))
+                value |= ~(uint64_t) 0 << shift;
+            return (int64_t) value;
+        }
+    }
+
+    r->ok = false;
+    return 0;
+}
+
+/**
+ * @internal
+ * Skip @a length bytes.
+ */
+static void dwarf_skip (dwarf_reader_t *r, uint64_t length) {
+    if (!r->ok || (uint64_t) (r->end - r->p) < length) {
+        r->ok = false;
+        return;
+    }
+
+    r->p += length;
+}
+
+/**
+ * @internal
+ * Return the NUL-terminated string at @a offset within @a section, or NULL if it is out of bounds.
+ */
+static const char *dwarf_section_string (const uint8_t *section, size_t size, uint64_t offset) {
+    if (section == NULL || offset >= size)
+        return NULL;
+
+    if (memchr(section + offset, '\0', size - offset) == NULL)
+        return NULL;
+
+    return (const char *) section + offset;
+}
+
+/**
+ * @internal
+ * Read an inline NUL-terminated string.
+ */
+static const char *dwarf_read_string (dwarf_reader_t *r) {
+    const uint8_t *nul;
+    const char *str;
+
+    if (!r->ok || (nul = memchr(r->p, '\0', (size_t) (r->end - r->p))) == NULL) {
+        r->ok = false;
+        return NULL;
+    }
+
+    str = (const char *) r->p;
+    r->p = nul + 1;
+    return str;
+}
+
+/**
+ * @internal
+ * Read a DWARF 5 header entry attribute of the given @a form. String forms are returned via @a str; all other
+ * forms are skipped.
+ */
+static void dwarf_read_form (dwarf_reader_t *r, const plcrash_dwarf_sections_t *sections, uint64_t form, size_t offset_size, const char **str) {
+    *str = NULL;
+
+    switch (form) {
+        case DW_FORM_string:
+            *str = dwarf_read_string(r);
+            break;
+
+        case DW_FORM_strp:
+            *str = dwarf_section_string(sections->debug_str, sections->debug_str_size, dwarf_read_uint(r, offset_size));
+            break;
+
+        case DW_FORM_line_strp:
+            *str = dwarf_section_string(sections->debug_line_str, sections->debug_line_str_size, dwarf_read_uint(r, offset_size));
+            break;
+
+        case DW_FORM_data1: dwarf_skip(r, 1); break;
+        case DW_FORM_data2: dwarf_skip(r, 2); break;
+        case DW_FORM_data4: dwarf_skip(r, 4); break;
+        case DW_FORM_data8: dwarf_skip(r, 8); break;
+        case DW_FORM_data16: dwarf_skip(r, 16); break;
+        case DW_FORM_udata: dwarf_read_uleb(r); break;
+        case DW_FORM_sdata: dwarf_read_sleb(r); break;
+        case DW_FORM_block: dwarf_skip(r, dwarf_read_uleb(r)); break;
+        case DW_FORM_block1: dwarf_skip(r, dwarf_read_uint(r, 1)); break;
+        case DW_FORM_block2: dwarf_skip(r, dwarf_read_uint(r, 2)); break;
+        case DW_FORM_block4: dwarf_skip(r, dwarf_read_uint(r, 4)); break;
+
+        default:
+            /* Forms requiring other sections (eg, DW_FORM_strx) are unsupported */
+            r->ok = false;
+            break;
+    }
+}
+
+/**
+ * @internal
+ * Growable array of file names.
+ */
+typedef struct dwarf_files {
+    const char **names;
+    size_t count;
+    size_t capacity;
+} dwarf_files_t;
+
+/**
+ * @internal
+ * Append @a name to @a files.
+ */
+static bool dwarf_files_append (dwarf_files_t *files, const char *name) {
+    if (files->count == files->capacity) {
+        size_t capacity = files->capacity > 0 ? files->capacity * 2 : 32;
+        const char **names = realloc(files->names, capacity * sizeof(*names));
+
+        if (names == NULL)
+            return false;
+
+        files->names = names;
+        files->capacity = capacity;
+    }
+
+    files->names[files->count++] = name;
+    return true;
+}
+
+/**
+ * @internal
+ * A line sequence: a contiguous range of rows with ascending addresses, ending in an end of sequence row.
+ */
+typedef struct dwarf_sequence {
+    /** Address of the first row */
+    uint64_t address;
+
+    /** Index of the first row in the unsorted row array */
+    size_t start;
+
+    /** Number of rows */
+    size_t count;
+} dwarf_sequence_t;
+
+/**
+ * @internal
+ * Line table under construction.
+ */
+typedef struct dwarf_builder {
+    /** Rows, in sequence order */
+    plcrash_dwarf_line_row_t *rows;
+    size_t row_count;
+    size_t row_capacity;
+
+    /** Completed sequences */
+    dwarf_sequence_t *sequences;
+    size_t sequence_count;
+    size_t sequence_capacity;
+
+    /** Index of the first row of the current sequence */
+    size_t sequence_start;
+} dwarf_builder_t;
+
+/**
+ * @internal
+ * Append a row to the current sequence.
+ */
+static bool dwarf_builder_row (dwarf_builder_t *builder, uint64_t address, const char *file, uint32_t line) {
+    if (builder->row_count == builder->row_capacity) {
+        size_t capacity = builder->row_capacity > 0 ? builder->row_capacity * 2 : 1024;
+        plcrash_dwarf_line_row_t *rows = realloc(builder->rows, capacity * sizeof(*rows));
+
+        if (rows == NULL)
+            return false;
+
+        builder->rows = rows;
+        builder->row_capacity = capacity;
+    }
+
+    builder->rows[builder->row_count].address = address;
+    builder->rows[builder->row_count].file = file;
+    builder->rows[builder->row_count].line = line;
+    builder->row_count++;
+
+    return true;
+}
+
+/**
+ * @internal
+ * Terminate the current sequence with an end of sequence row at @a address.
+ */
+static bool dwarf_builder_end_sequence (dwarf_builder_t *builder, uint64_t address) {
+    size_t start = builder->sequence_start;
+
+    if (!dwarf_builder_row(builder, address, NULL, 0))
+        return false;
+
+    /* Sequences at address 0 describe code that the linker discarded; they would otherwise shadow real code */
+    if (builder->rows[start].address == 0) {
+        builder->row_count = start;
+        return true;
+    }
+
+    if (builder->sequence_count == builder->sequence_capacity) {
+        size_t capacity = builder->sequence_capacity > 0 ? builder->sequence_capacity * 2 : 256;
+        dwarf_sequence_t *sequences = realloc(builder->sequences, capacity * sizeof(*sequences));
+
+        if (sequences == NULL)
+            return false;
+
+        builder->sequences = sequences;
+        builder->sequence_capacity = capacity;
+    }
+
+    builder->sequences[builder->sequence_count].address = builder->rows[start].address;
+    builder->sequences[builder->sequence_count].start = start;
+    builder->sequences[builder->sequence_count].count = builder->row_count - start;
+    builder->sequence_count++;
+
+    builder->sequence_start = builder->row_count;
+    return true;
+}
+
+/**
+ * @internal
+ * Decode the file name table of a line number program header. Malformed tables clear the reader's @a ok flag.
+ *
+ * @return Returns false if memory could not be allocated.
+ */
+static bool dwarf_read_file_names (dwarf_reader_t *r, const plcrash_dwarf_sections_t *sections, uint16_t version, size_t offset_size, dwarf_files_t *files) {
+    if (version < 5) {
+        /* Skip include_directories */
+        while (r->ok && r->p < r->end && *r->p != '\0')
+            dwarf_read_string(r);
+        dwarf_skip(r, 1);
+
+        /* File indices are 1-based */
+        if (!dwarf_files_append(files, NULL))
+            return false;
+
+        while (r->ok && r->p < r->end && *r->p != '\0') {
+            const char *name = dwarf_read_string(r);
+
+            /* Directory index, modification time, length */
+            dwarf_read_uleb(r);
+            dwarf_read_uleb(r);
+            dwarf_read_uleb(r);
+
+            if (!dwarf_files_append(files, name))
+                return false;
+        }
+        dwarf_skip(r, 1);
+
+        return true;
+    }
+
+    /* DWARF 5 self-describing directory and file tables. Directories are skipped. */
+    for (int table = 0; table < 2 && r->ok; table++) {
+        uint64_t formats[32][2];
+        uint64_t format_count = dwarf_read_uint(r, 1);
+        uint64_t entry_count;
+
+        if (format_count > sizeof(formats) / sizeof(formats[0])) {
+            r->ok = false;
+            break;
+        }
+
+        for (uint64_t i = 0; i < format_count; i++) {
+            formats[i][0] = dwarf_read_uleb(r);
+            formats[i][1] = dwarf_read_uleb(r);
+        }
+
+        entry_count = dwarf_read_uleb(r);
+        for (uint64_t i = 0; i < entry_count && r->ok; i++) {
+            const char *path = NULL;
+
+            for (uint64_t j = 0; j < format_count; j++) {
+                const char *str;
+
+                dwarf_read_form(r, sections, formats[j][1], offset_size, &str);
+                if (formats[j][0] == DW_LNCT_path)
+                    path = str;
+            }
+
+            if (table == 1 && !dwarf_files_append(files, path))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @internal
+ * Decode a single line number program, appending its sequences to @a builder.
+ *
+ * @return Returns false if memory could not be allocated. Malformed programs are ignored.
+ */
+static bool dwarf_read_unit (dwarf_reader_t *unit, const plcrash_dwarf_sections_t *sections, size_t offset_size, dwarf_builder_t *builder) {
+    dwarf_files_t files = { NULL, 0, 0 };
+    uint8_t standard_opcode_lengths[256];
+    dwarf_reader_t header;
+    uint64_t header_length;
+    uint8_t min_inst_length;
+    int8_t line_base;
+    uint8_t line_range;
+    uint8_t opcode_base;
+    uint16_t version;
+
+    /* Program state */
+    uint64_t address = 0;
+    uint64_t file = 1;
+    int64_t line = 1;
+
+    version = (uint16_t) dwarf_read_uint(unit, 2);
+    if (version < 2 || version > 5)
+        return true;
+
+    /* address_size and segment_selector_size */
+    if (version >= 5)
+        dwarf_skip(unit, 2);
+
+    header_length = dwarf_read_uint(unit, offset_size);
+    if (!unit->ok || header_length > (uint64_t) (unit->end - unit->p))
+        return true;
+
+    header = *unit;
+    header.end = unit->p + header_length;
+    unit->p += header_length;
+
+    min_inst_length = (uint8_t) dwarf_read_uint(&header, 1);
+    if (version >= 4)
+        dwarf_skip(&header, 1);
+    dwarf_skip(&header, 1);
+    line_base = (int8_t) dwarf_read_uint(&header, 1);
+    line_range = (uint8_t) dwarf_read_uint(&header, 1);
+    opcode_base = (uint8_t) dwarf_read_uint(&header, 1);
+
+    memset(standard_opcode_lengths, 0, sizeof(standard_opcode_lengths));
+    for (unsigned i = 1; i < opcode_base; i++)
+        standard_opcode_lengths[i] = (uint8_t) dwarf_read_uint(&header, 1);
+
+    if (!header.ok || line_range == 0 || opcode_base == 0)
+        return true;
+
+    if (!dwarf_read_file_names(&header, sections, version, offset_size, &files)) {
+        free(files.names);
+        return false;
+    } else if (!header.ok) {
+        free(files.names);
+        return true;
+    }
+
+    /* Run the line number program */
+    builder->sequence_start = builder->row_count;
+    while (unit->ok && unit->p < unit->end) {
+        uint8_t opcode = (uint8_t) dwarf_read_uint(unit, 1);
+        bool emit = false;
+
+        if (opcode >= opcode_base) {
+            /* Special opcode */
+            uint8_t adjusted = opcode - opcode_base;
+
+            address += (uint64_t) (adjusted / line_range) * min_inst_length;
+            line += line_base + (adjusted % line_range);
+            emit = true;
+        } else if (opcode == 0) {
+            /* Extended opcode */
+            uint64_t length = dwarf_read_uleb(unit);
+            const uint8_t *next;
+            uint8_t sub_opcode;
+
+            if (!unit->ok || length == 0 || length > (uint64_t) (unit->end - unit->p))
+                break;
+
+            next = unit->p + length;
+            sub_opcode = (uint8_t) dwarf_read_uint(unit, 1);
+            switch (sub_opcode) {
+                case DW_LNE_end_sequence:
+                    if (!dwarf_builder_end_sequence(builder, address)) {
+                        free(files.names);
+                        return false;
+                    }
+
+                    address = 0;
+                    file = 1;
+                    line = 1;
+                    break;
+
+                case DW_LNE_set_address:
+                    address = dwarf_read_uint(unit, (size_t) length - 1);
+                    break;
+
+                case DW_LNE_define_file: {
+                    const char *name = dwarf_read_string(unit);
+                    if (!dwarf_files_append(&files, name)) {
+                        free(files.names);
+                        return false;
+                    }
+                    break;
+                }
+
+                default:
+                    break;
+            }
+
+            unit->p = next;
+        } else {
+            switch (opcode) {
+                case DW_LNS_copy:
+                    emit = true;
+                    break;
+
+                case DW_LNS_advance_pc:
+                    address += dwarf_read_uleb(unit) * min_inst_length;
+                    break;
+
+                case DW_LNS_advance_line:
+                    line += dwarf_read_sleb(unit);
+                    break;
+
+                case DW_LNS_set_file:
+                    file = dwarf_read_uleb(unit);
+                    break;
+
+                case DW_LNS_const_add_pc:
+                    address += (uint64_t) ((255 - opcode_base) / line_range) * min_inst_length;
+                    break;
+
+                case DW_LNS_fixed_advance_pc:
+                    address += dwarf_read_uint(unit, 2);
+                    break;
+
+                default:
+                    /* Skip the opcode's ULEB128 operands */
+                    for (unsigned i = 0; i < standard_opcode_lengths[opcode]; i++)
+                        dwarf_read_uleb(unit);
+                    break;
+            }
+        }
+
+        if (emit) {
+            const char *file_name = file < files.count ? files.names[file] : NULL;
+            bool valid = (line > 0 && line <= UINT32_MAX && file_name != NULL);
+
+            if (!dwarf_builder_row(builder, address, valid ? file_name : NULL, valid ? (uint32_t) line : 0)) {
+                free(files.names);
+                return false;
+            }
+        }
+    }
+
+    /* Discard any unterminated sequence */
+    builder->row_count = builder->sequence_start;
+
+    free(files.names);
+    return true;
+}
+
+/**
+ * @internal
+ * Order sequences by their start address.
+ */
+static int dwarf_sequence_compare (const void *a, const void *b) {
+    const dwarf_sequence_t *seq1 = a;
+    const dwarf_sequence_t *seq2 = b;
+
+    if (seq1->address != seq2->address)
+        return seq1->address < seq2->address ? -1 : 1;
+
+    return seq1->start < seq2->start ? -1 : (seq1->start > seq2->start);
+}
+
+/**
+ * Decode all line number programs in @a sections into an address-sorted line table. Malformed or unsupported
+ * units are skipped.
+ *
+ * @param table The table to initialize.
+ * @param sections The debug sections to decode. The sections must remain mapped for the lifetime of @a table.
+ *
+ * @return Returns PLCRASH_ESUCCESS on success, or PLCRASH_ENOMEM if memory could not be allocated.
+ */
+plcrash_error_t plcrash_dwarf_line_table_init (plcrash_dwarf_line_table_t *table, const plcrash_dwarf_sections_t *sections) {
+    dwarf_builder_t builder;
+    dwarf_reader_t r;
+    size_t n = 0;
+
+    memset(table, 0, sizeof(*table));
+    memset(&builder, 0, sizeof(builder));
+
+    r.p = sections->debug_line;
+    r.end = sections->debug_line + sections->debug_line_size;
+    r.big_endian = sections->big_endian;
+    r.ok = (sections->debug_line != NULL);
+
+    while (r.ok && r.p < r.end) {
+        size_t offset_size = 4;
+        uint64_t unit_length = dwarf_read_uint(&r, 4);
+        dwarf_reader_t unit;
+
+        /* 64-bit DWARF */
+        if (unit_length == 0xffffffff) {
+            unit_length = dwarf_read_uint(&r, 8);
+            offset_size = 8;
+        }
+
+        if (!r.ok || unit_length > (uint64_t) (r.end - r.p))
+            break;
+
+        unit = r;
+        unit.end = r.p + unit_length;
+        r.p += unit_length;
+
+        if (!dwarf_read_unit(&unit, sections, offset_size, &builder)) {
+            free(builder.rows);
+            free(builder.sequences);
+            return PLCRASH_ENOMEM;
+        }
+    }
+
+    /* Concatenate the sequences in address order */
+    qsort(builder.sequences, builder.sequence_count, sizeof(dwarf_sequence_t), dwarf_sequence_compare);
+
+    table->rows = malloc((builder.row_count > 0 ? builder.row_count : 1) * sizeof(plcrash_dwarf_line_row_t));
+    if (table->rows == NULL) {
+        free(builder.rows);
+        free(builder.sequences);
+        return PLCRASH_ENOMEM;
+    }
+
+    for (size_t i = 0; i < builder.sequence_count; i++) {
+        memcpy(&table->rows[n], &builder.rows[builder.sequences[i].start], builder.sequences[i].count * sizeof(plcrash_dwarf_line_row_t));
+        n += builder.sequences[i].count;
+    }
+    table->row_count = n;
+
+    free(builder.rows);
+    free(builder.sequences);
+
+    return PLCRASH_ESUCCESS;
+}
+
+/**
+ * Look up the source location of @a address.
+ *
+ * @param table The line table to search.
+ * @param address The link-time address to look up.
+ * @param file On success, the source file name.
+ * @param line On success, the source line.
+ *
+ * @return Returns true if line information was found for @a address.
+ */
+bool plcrash_dwarf_line_table_lookup (const plcrash_dwarf_line_table_t *table, uint64_t address, const char **file, uint32_t *line) {
+    size_t lo = 0;
+    size_t hi = table->row_count;
+
+    /* Find the last row with an address <= address */
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+
+        if (table->rows[mid].address <= address)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    if (lo == 0 || table->rows[lo - 1].file == NULL)
+        return false;
+
+    *file = table->rows[lo - 1].file;
+    *line = table->rows[lo - 1].line;
+    return true;
+}
+
+/**
+ * Free all storage associated with @a table.
+ *
+ * @param table The table to free.
+ */
+void plcrash_dwarf_line_table_free (plcrash_dwarf_line_table_t *table) {
+    free(table->rows);
+    memset(table, 0, sizeof(*table));
+}
+
+/**
+ * @} plcrash_symbolicator
+ */
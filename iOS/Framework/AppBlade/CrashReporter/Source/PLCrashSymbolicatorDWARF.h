@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2008-2011 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef PLCRASH_SYMBOLICATOR_DWARF_H
+#define PLCRASH_SYMBOLICATOR_DWARF_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#import "PLCrashAsync.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @internal
+ * @ingroup plcrash_symbolicator
+ * @{
+ */
+
+/**
+ * DWARF debug sections required to decode line tables. All sections must remain mapped for the lifetime of
+ * any line table decoded from them.
+ */
+typedef struct plcrash_dwarf_sections {
+    /** .debug_line / __debug_line */
+    const uint8_t *debug_line;
+    size_t debug_line_size;
+
+    /** .debug_str / __debug_str, or NULL */
+    const uint8_t *debug_str;
+    size_t debug_str_size;
+
+    /** .debug_line_str / __debug_line_str (DWARF 5), or NULL */
+    const uint8_t *debug_line_str;
+    size_t debug_line_str_size;
+
+    /** True if the sections are big-endian */
+    bool big_endian;
+} plcrash_dwarf_sections_t;
+
+/**
+ * A line table row. Each row covers the addresses from @a address up to the address of the next row.
+ */
+typedef struct plcrash_dwarf_line_row {
+    /** First address covered by the row */
+    uint64_t address;
+
+    /** Source file name, or NULL for rows that carry no line information (including end of sequence rows) */
+    const char *file;
+
+    /** Source line, or 0 */
+    uint32_t line;
+} plcrash_dwarf_line_row_t;
+
+/**
+ * Address-sorted line table of all compilation units in a binary.
+ */
+typedef struct plcrash_dwarf_line_table {
+    /** Rows, in ascending address order */
+    plcrash_dwarf_line_row_t *rows;
+
+    /** Number of rows */
+    size_t row_count;
+} plcrash_dwarf_line_table_t;
+
+plcrash_error_t plcrash_dwarf_line_table_init (plcrash_dwarf_line_table_t *table, const plcrash_dwarf_sections_t *sections);
+bool plcrash_dwarf_line_table_lookup (const plcrash_dwarf_line_table_t *table, uint64_t address, const char **file, uint32_t *line);
+void plcrash_dwarf_line_table_free (plcrash_dwarf_line_table_t *table);
+
+/**
+ * @} plcrash_symbolicator
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PLCRASH_SYMBOLICATOR_DWARF_H */
@@ -0,0 +1,177 @@
+/*
+ * Author: Landon Fuller <landonf@plausiblelabs.com>
+ *
+ * Copyright (c) 2008-2009 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "GTMSenTestCase.h"
+
+#import "PLCrashSymbolicator.h"
+
+#import <dlfcn.h>
+#import <mach-o/loader.h>
+
+@interface PLCrashSymbolicatorTests : SenTestCase {
+@private
+    plcrash_symbolicator_t _symbolicator;
+}
+
+@end
+
+/* A function with a known symbol name, resolved from the test bundle's own symbol table */
+void plcrash_symbolicator_test_function (void) __attribute__((noinline));
+void plcrash_symbolicator_test_function (void) {
+    __asm__ __volatile__ ("");
+}
+
+/* Fetch the LC_UUID of the loaded image with the given header */
+static BOOL image_uuid (const struct mach_header *header, uint8_t uuid[16]) {
+    const uint8_t *cmd = (const uint8_t *) header;
+
+    if (header->magic == MH_MAGIC_64)
+        cmd += sizeof(struct mach_header_64);
+    else
+        cmd += sizeof(struct mach_header);
+
+    for (uint32_t i = 0; i < header->ncmds; i++) {
+        const struct load_command *lc = (const struct load_command *) cmd;
+        if (lc->cmd == LC_UUID) {
+            memcpy(uuid, ((const struct uuid_command *) lc)->uuid, 16);
+            return YES;
+        }
+        cmd += lc->cmdsize;
+    }
+
+    return NO;
+}
+
+@implementation PLCrashSymbolicatorTests
+
+- (void) setUp {
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_symbolicator_init(&_symbolicator, true), @"Failed to initialize the symbolicator");
+}
+
+- (void) tearDown {
+    plcrash_symbolicator_free(&_symbolicator);
+}
+
+/* Symbolicate a report with a frame in the test function, and a frame in no image, verifying the result */
+- (void) verifySymbolicationWithSymbolicator: (plcrash_symbolicator_t *) symbolicator image: (Dl_info *) info uuid: (uint8_t *) uuid {
+    plcrash_report_t report;
+    plcrash_report_image_t image;
+    plcrash_report_thread_t thread;
+    plcrash_report_frame_t frames[2];
+
+    memset(&report, 0, sizeof(report));
+    memset(&image, 0, sizeof(image));
+    memset(&thread, 0, sizeof(thread));
+
+    image.base_address = (uintptr_t) info->dli_fbase;
+    image.size = (uintptr_t) plcrash_symbolicator_test_function - (uintptr_t) info->dli_fbase + 4096;
+    image.name = info->dli_fname;
+    image.uuid = uuid;
+    image.uuid_length = 16;
+
+    frames[0].pc = (uintptr_t) plcrash_symbolicator_test_function;
+    frames[1].pc = 0x10;
+
+    thread.crashed = true;
+    thread.frame_count = 2;
+
+    report.images = &image;
+    report.image_count = 1;
+    report.threads = &thread;
+    report.thread_count = 1;
+    report.frames = frames;
+    report.frame_count = 2;
+
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_symbolicator_symbolicate(symbolicator, &report), @"Symbolication failed");
+    STAssertNotNULL(report.symbols, @"No symbols were attached to the report");
+
+    STAssertNotNULL(report.symbols[0].name, @"The test function was not resolved");
+    STAssertEqualCStrings("plcrash_symbolicator_test_function", report.symbols[0].name, @"Incorrect symbol name");
+    STAssertEquals((uint64_t) 0, report.symbols[0].offset, @"Incorrect symbol offset");
+
+    STAssertNULL(report.symbols[1].name, @"A frame outside of any image was resolved");
+
+    free(report.symbols);
+}
+
+- (void) testSymbolicate {
+    uint8_t uuid[16];
+    Dl_info info;
+
+    /* Locate the test image */
+    STAssertTrue(dladdr((void *) plcrash_symbolicator_test_function, &info) != 0, @"Could not find the test image");
+    STAssertTrue(image_uuid(info.dli_fbase, uuid), @"The test image has no UUID");
+
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_symbolicator_add_path(&_symbolicator, info.dli_fname), @"Could not index the test image");
+    STAssertTrue(plcrash_symbolicator_image_count(&_symbolicator) >= 1, @"No images were indexed");
+
+    [self verifySymbolicationWithSymbolicator: &_symbolicator image: &info uuid: uuid];
+}
+
+- (void) testSymbolicateWithCache {
+    NSString *directory = [NSTemporaryDirectory() stringByAppendingPathComponent: [[NSProcessInfo processInfo] globallyUniqueString]];
+    plcrash_symbolicator_t cached;
+    uint8_t uuid[16];
+    size_t count;
+    Dl_info info;
+
+    STAssertTrue(dladdr((void *) plcrash_symbolicator_test_function, &info) != 0, @"Could not find the test image");
+    STAssertTrue(image_uuid(info.dli_fbase, uuid), @"The test image has no UUID");
+
+    /* Write the test image's cache */
+    STAssertTrue([[NSFileManager defaultManager] createDirectoryAtPath: directory withIntermediateDirectories: YES attributes: nil error: NULL], @"Could not create cache directory");
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_symbolicator_add_path(&_symbolicator, info.dli_fname), @"Could not index the test image");
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_symbolicator_write_caches(&_symbolicator, [directory fileSystemRepresentation], &count), @"Could not write caches");
+    STAssertEquals(plcrash_symbolicator_image_count(&_symbolicator), count, @"Caches were not written for all images");
+
+    /* Symbolicate using only the cache */
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_symbolicator_init(&cached, true), @"Failed to initialize the symbolicator");
+    STAssertEquals(PLCRASH_ESUCCESS, plcrash_symbolicator_add_path(&cached, [directory fileSystemRepresentation]), @"Could not index the caches");
+    STAssertEquals(count, plcrash_symbolicator_image_count(&cached), @"Not all caches were indexed");
+
+    [self verifySymbolicationWithSymbolicator: &cached image: &info uuid: uuid];
+
+    plcrash_symbolicator_free(&cached);
+    [[NSFileManager defaultManager] removeItemAtPath: directory error: NULL];
+}
+
+- (void) testAddInvalidPath {
+    STAssertEquals(PLCRASH_EINVAL, plcrash_symbolicator_add_path(&_symbolicator, "/nonexistent/plcrash"), @"Missing path was accepted");
+}
+
+- (void) testAddUnsupportedFile {
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent: [[NSProcessInfo processInfo] globallyUniqueString]];
+    STAssertTrue([[@"not an object file" dataUsingEncoding: NSUTF8StringEncoding] writeToFile: path atomically: NO], @"Could not write test file");
+
+    STAssertEquals(PLCRASH_ENOTSUP, plcrash_symbolicator_add_path(&_symbolicator, [path fileSystemRepresentation]), @"Unsupported file was accepted");
+    STAssertEquals((size_t) 0, plcrash_symbolicator_image_count(&_symbolicator), @"Unsupported file was indexed");
+
+    [[NSFileManager defaultManager] removeItemAtPath: path error: NULL];
+}
+
+@end
@@ -32,6 +32,9 @@
 #import <stdlib.h>
 #import <stdio.h>
 #import <getopt.h>
+#import <unistd.h>
+#import <errno.h>
+#import <time.h>
 
 /*
  * Print command line usage.
@@ -39,34 +42,256 @@
 void print_usage () {
     fprintf(stderr, "Usage: plcrashutil <command> <options>\n"
                     "Commands:\n"
-                    "  convert --format=<format> <file>\n"
-                    "      Covert a plcrash file to the given format.\n\n"
+                    "  convert --format=<format> <file or directory>...\n"
+                    "      Covert plcrash files to the given format. Directories are expanded to the\n"
+                    "      plcrash files they contain. Gzip-compressed plcrash files are accepted by\n"
+                    "      all commands.\n\n"
                     "      Supported formats:\n"
                     "        ios - Standard Apple iOS-compatible text crash log\n"
-                    "        iphone - Synonym for 'iOS'.\n");
+                    "        iphone - Synonym for 'iOS'.\n"
+                    "        json - JSON; multiple reports are written as a JSON array.\n"
+                    "        ndjson - Newline-delimited JSON, one report per line.\n\n"
+                    "  symbolicate [--format=<format>] [--no-lines] --symbols=<path>... <file or directory>...\n"
+                    "      Convert plcrash files as above, resolving stack frames to symbol names and\n"
+                    "      source lines. Symbol paths may be Mach-O binaries, dSYM bundles, ELF files,\n"
+                    "      or directories containing them; images are matched by UUID or build-id.\n\n"
+                    "  symcache [--no-lines] --symbols=<path>... <output directory>\n"
+                    "      Write a memory-mappable symbol cache for each image found in the symbol\n"
+                    "      paths. Cache directories may be passed to symbolicate as symbol paths.\n\n"
+                    "  bucket [--frames=<count>] [--threads=<count>] <file, directory, or ->...\n"
+                    "      Group plcrash files by a fingerprint of the crashed thread's top frames\n"
+                    "      (default: 5), signal, and exception, writing one tab-separated line per\n"
+                    "      bucket, most frequent first. '-' reads newline-separated paths from\n"
+                    "      standard input. Threads default to one per processor.\n\n"
+                    "  export --columnar --output=<directory> [--threads=<count>] <file, directory, or ->...\n"
+                    "      Write the reports, threads, frames, and images of plcrash files as column\n"
+                    "      files (<table>.<column>.plcol) in the output directory, for analytics. '-'\n"
+                    "      reads newline-separated paths from standard input.\n\n"
+                    "  stats <directory>\n"
+                    "      Summarize the crash log writer statistics of all plcrash files in a directory.\n");
 }
 
 /*
- * Run a conversion.
+ * Conversion output formats.
  */
-int convert_command (int argc, char *argv[]) {
+typedef enum {
+    /* Text, in a PLCrashReportTextFormat */
+    CONVERT_FORMAT_TEXT,
+
+    /* A single JSON document */
+    CONVERT_FORMAT_JSON,
+
+    /* One JSON document per line */
+    CONVERT_FORMAT_NDJSON
+} convert_format_t;
+
+/*
+ * Write a buffer to the given file descriptor.
+ */
+static BOOL write_bytes (int fd, const void *bytes, size_t length) {
+    const char *p = bytes;
+
+    while (length > 0) {
+        ssize_t written = write(fd, p, length);
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            return NO;
+        }
+
+        p += written;
+        length -= written;
+    }
+
+    return YES;
+}
+
+/*
+ * Return the input paths named on the command line, with any directories replaced by their (sorted) contents.
+ */
+static NSArray *convert_input_paths (int argc, char *argv[]) {
+    NSFileManager *fileManager = [NSFileManager defaultManager];
+    NSMutableArray *paths = [NSMutableArray array];
+
+    for (int i = 0; i < argc; i++) {
+        NSString *path = [NSString stringWithUTF8String: argv[i]];
+        BOOL isDirectory = NO;
+
+        if (![fileManager fileExistsAtPath: path isDirectory: &isDirectory] || !isDirectory) {
+            [paths addObject: path];
+            continue;
+        }
+
+        NSError *error;
+        NSArray *files = [fileManager contentsOfDirectoryAtPath: path error: &error];
+        if (files == nil) {
+            fprintf(stderr, "Could not read input directory %s: %s\n", argv[i], [[error localizedDescription] UTF8String]);
+            continue;
+        }
+
+        for (NSString *file in [files sortedArrayUsingSelector: @selector(compare:)]) {
+            NSString *filePath = [path stringByAppendingPathComponent: file];
+
+            /* Skip hidden files and subdirectories */
+            if ([file hasPrefix: @"."])
+                continue;
+            if ([fileManager fileExistsAtPath: filePath isDirectory: &isDirectory] && isDirectory)
+                continue;
+
+            [paths addObject: filePath];
+        }
+    }
+
+    return paths;
+}
+
+/*
+ * Append the newline-separated paths read from standard input.
+ */
+static void read_stdin_paths (NSMutableArray *paths) {
+    char *line = NULL;
+    size_t capacity = 0;
+    ssize_t length;
+
+    while ((length = getline(&line, &capacity, stdin)) > 0) {
+        NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+
+        if (line[length - 1] == '\n')
+            line[--length] = '\0';
+
+        if (length > 0)
+            [paths addObject: [NSString stringWithUTF8String: line]];
+
+        [pool release];
+    }
+
+    free(line);
+}
+
+/*
+ * Return the input paths named on the command line as convert_input_paths() does, with '-' replaced by the
+ * paths listed on standard input.
+ */
+static NSArray *gather_input_paths (int argc, char *argv[]) {
+    NSMutableArray *paths = [NSMutableArray array];
+
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "-") == 0)
+            read_stdin_paths(paths);
+        else
+            [paths addObjectsFromArray: convert_input_paths(1, &argv[i])];
+    }
+
+    return paths;
+}
+
+/*
+ * Convert a single report, writing the result to the output preceded by the given separator. If a symbolicator
+ * is provided, the report is symbolicated before it is formatted.
+ */
+static BOOL convert_report (NSString *path, convert_format_t format, PLCrashReportTextFormat textFormat,
+                            PLCrashReportSymbolicator *symbolicator, const char *separator, int output)
+{
+    NSError *error;
+
+    /* Try reading the file in */
+    NSData *data = [NSData dataWithContentsOfFile: path options: NSMappedRead error: &error];
+    if (data == nil) {
+        fprintf(stderr, "Could not read input file %s: %s\n", [path UTF8String], [[error localizedDescription] UTF8String]);
+        return NO;
+    }
+
+    /* Unsymbolicated JSON is formatted directly from the encoded report */
+    if (format != CONVERT_FORMAT_TEXT && symbolicator == nil) {
+        PLCrashReportJSONFormatter *formatter = [[[PLCrashReportJSONFormatter alloc] init] autorelease];
+        NSData *json = [formatter formatReportData: data error: &error];
+        if (json == nil) {
+            fprintf(stderr, "Could not decode crash log %s: %s\n", [path UTF8String], [[error localizedDescription] UTF8String]);
+            return NO;
+        }
+
+        if (!write_bytes(output, separator, strlen(separator)) || !write_bytes(output, [json bytes], [json length])) {
+            fprintf(stderr, "Could not write crash log %s: %s\n", [path UTF8String], strerror(errno));
+            return NO;
+        }
+
+        return YES;
+    }
+
+    /* Decode it */
+    PLCrashReport *crashLog = [[[PLCrashReport alloc] initWithData: data error: &error] autorelease];
+    if (crashLog == nil) {
+        fprintf(stderr, "Could not decode crash log %s: %s\n", [path UTF8String], [[error localizedDescription] UTF8String]);
+        return NO;
+    }
+
+    if (symbolicator != nil && ![symbolicator symbolicateReport: crashLog error: &error]) {
+        fprintf(stderr, "Could not symbolicate crash log %s: %s\n", [path UTF8String], [[error localizedDescription] UTF8String]);
+        return NO;
+    }
+
+    if (format != CONVERT_FORMAT_TEXT) {
+        PLCrashReportJSONFormatter *formatter = [[[PLCrashReportJSONFormatter alloc] init] autorelease];
+        if (!write_bytes(output, separator, strlen(separator))) {
+            fprintf(stderr, "Could not write crash log %s: %s\n", [path UTF8String], strerror(errno));
+            return NO;
+        }
+
+        if (![formatter writeReport: crashLog toFileDescriptor: output error: &error]) {
+            fprintf(stderr, "Could not write crash log %s: %s\n", [path UTF8String], [[error localizedDescription] UTF8String]);
+            return NO;
+        }
+
+        return YES;
+    }
+
+    /* Format the report, streaming it directly to the output */
+    PLCrashReportTextFormatter *formatter = [[[PLCrashReportTextFormatter alloc] initWithTextFormat: textFormat
+                                                                                     stringEncoding: NSUTF8StringEncoding] autorelease];
+    if (!write_bytes(output, separator, strlen(separator))) {
+        fprintf(stderr, "Could not write crash log %s: %s\n", [path UTF8String], strerror(errno));
+        return NO;
+    }
+
+    if (![formatter writeReport: crashLog toFileDescriptor: output error: &error]) {
+        fprintf(stderr, "Could not write crash log %s: %s\n", [path UTF8String], [[error localizedDescription] UTF8String]);
+        return NO;
+    }
+
+    return YES;
+}
+
+/*
+ * Run a conversion. If symbolicate is YES, at least one symbol path must be supplied.
+ */
+int convert_command (int argc, char *argv[], BOOL symbolicate) {
     const char *format = "iphone";
-    const char *input_file;
-    FILE *output = stdout;
+    NSMutableArray *symbolPaths = [NSMutableArray array];
+    BOOL lineInfo = YES;
+    int output = STDOUT_FILENO;
+    int ret = 0;
 
     /* options descriptor */
     static struct option longopts[] = {
         { "format",     required_argument,      NULL,          'f' },
+        { "symbols",    required_argument,      NULL,          's' },
+        { "no-lines",   no_argument,            NULL,          'n' },
         { NULL,         0,                      NULL,           0 }
     };    
 
     /* Read the options */
-    char ch;
-    while ((ch = getopt_long(argc, argv, "f:", longopts, NULL)) != -1) {
+    int ch;
+    while ((ch = getopt_long(argc, argv, "f:s:n", longopts, NULL)) != -1) {
         switch (ch) {
             case 'f':
                 format = optarg;
                 break;
+            case 's':
+                [symbolPaths addObject: [NSString stringWithUTF8String: optarg]];
+                break;
+            case 'n':
+                lineInfo = NO;
+                break;
             default:
                 print_usage();
                 return 1;
@@ -80,39 +305,440 @@ int convert_command (int argc, char *argv[]) {
         fprintf(stderr, "No input file supplied\n");
         print_usage();
         return 1;
-    } else {
-        input_file = argv[0];
     }
     
-    /* Verify that the format is supported. Only one is actually supported currently */
-    PLCrashReportTextFormat textFormat;
-    if (strcasecmp(format, "iphone") == 0 || strcasecmp(format, "ios")) {
-        textFormat = PLCrashReportTextFormatiOS;
+    /* Verify that the format is supported */
+    convert_format_t convertFormat;
+    PLCrashReportTextFormat textFormat = PLCrashReportTextFormatiOS;
+    if (strcasecmp(format, "iphone") == 0 || strcasecmp(format, "ios") == 0) {
+        convertFormat = CONVERT_FORMAT_TEXT;
+    } else if (strcasecmp(format, "json") == 0) {
+        convertFormat = CONVERT_FORMAT_JSON;
+    } else if (strcasecmp(format, "ndjson") == 0) {
+        convertFormat = CONVERT_FORMAT_NDJSON;
     } else {
         fprintf(stderr, "Unsupported format requested\n");
         print_usage();
         return 1;
     }
 
-    /* Try reading the file in */
+    /* Index the symbol files */
+    if (symbolicate && [symbolPaths count] == 0) {
+        fprintf(stderr, "No symbol path supplied\n");
+        print_usage();
+        return 1;
+    }
+
+    PLCrashReportSymbolicator *symbolicator = nil;
+    if ([symbolPaths count] > 0) {
+        symbolicator = [[[PLCrashReportSymbolicator alloc] initWithLineInfo: lineInfo] autorelease];
+
+        for (NSString *symbolPath in symbolPaths) {
+            NSError *error;
+            if (![symbolicator addSymbolsAtPath: symbolPath error: &error]) {
+                fprintf(stderr, "%s\n", [[error localizedDescription] UTF8String]);
+                return 1;
+            }
+        }
+
+        if (symbolicator.imageCount == 0)
+            fprintf(stderr, "Warning: no images with a UUID were found in the symbol paths\n");
+    }
+
+    NSArray *paths = convert_input_paths(argc, argv);
+
+    /* Multiple JSON reports are wrapped in an array */
+    BOOL jsonArray = (convertFormat == CONVERT_FORMAT_JSON && [paths count] > 1);
+    if (jsonArray && !write_bytes(output, "[", 1))
+        return 1;
+
+    NSUInteger written = 0;
+    for (NSString *path in paths) {
+        NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+
+        /* Separate successive reports; NDJSON lines are self-delimiting */
+        const char *separator = "";
+        if (written > 0 && convertFormat != CONVERT_FORMAT_NDJSON)
+            separator = jsonArray ? "," : "\n";
+
+        if (convert_report(path, convertFormat, textFormat, symbolicator, separator, output))
+            written++;
+        else
+            ret = 1;
+
+        [pool release];
+    }
+
+    if (jsonArray && !write_bytes(output, "]\n", 2))
+        return 1;
+
+    return ret;
+}
+
+/*
+ * Build symbol caches.
+ */
+int symcache_command (int argc, char *argv[]) {
+    NSMutableArray *symbolPaths = [NSMutableArray array];
+    BOOL lineInfo = YES;
     NSError *error;
-    NSData *data = [NSData dataWithContentsOfFile: [NSString stringWithUTF8String: input_file] 
-                                          options: NSMappedRead error: &error];
-    if (data == nil) {
-        fprintf(stderr, "Could not read input file: %s\n", [[error localizedDescription] UTF8String]);
+
+    /* options descriptor */
+    static struct option longopts[] = {
+        { "symbols",    required_argument,      NULL,          's' },
+        { "no-lines",   no_argument,            NULL,          'n' },
+        { NULL,         0,                      NULL,           0 }
+    };
+
+    /* Read the options */
+    int ch;
+    while ((ch = getopt_long(argc, argv, "s:n", longopts, NULL)) != -1) {
+        switch (ch) {
+            case 's':
+                [symbolPaths addObject: [NSString stringWithUTF8String: optarg]];
+                break;
+            case 'n':
+                lineInfo = NO;
+                break;
+            default:
+                print_usage();
+                return 1;
+        }
+    }
+    argc -= optind;
+    argv += optind;
+
+    if (argc != 1 || [symbolPaths count] == 0) {
+        fprintf(stderr, "A symbol path and a single output directory are required\n");
+        print_usage();
         return 1;
     }
-    
-    /* Decode it */
-    PLCrashReport *crashLog = [[PLCrashReport alloc] initWithData: data error: &error];
-    if (crashLog == nil) {
-        fprintf(stderr, "Could not decode crash log: %s\n", [[error localizedDescription] UTF8String]);
+
+    PLCrashReportSymbolicator *symbolicator = [[[PLCrashReportSymbolicator alloc] initWithLineInfo: lineInfo] autorelease];
+    for (NSString *symbolPath in symbolPaths) {
+        if (![symbolicator addSymbolsAtPath: symbolPath error: &error]) {
+            fprintf(stderr, "%s\n", [[error localizedDescription] UTF8String]);
+            return 1;
+        }
+    }
+
+    NSString *directory = [NSString stringWithUTF8String: argv[0]];
+    if (![[NSFileManager defaultManager] createDirectoryAtPath: directory withIntermediateDirectories: YES attributes: nil error: &error]) {
+        fprintf(stderr, "Could not create output directory %s: %s\n", argv[0], [[error localizedDescription] UTF8String]);
         return 1;
     }
 
-    /* Format the report */
-    NSString* report = [PLCrashReportTextFormatter stringValueForCrashReport: crashLog withTextFormat: textFormat];
-    fprintf(output, "%s", [report UTF8String]);     
+    if (![symbolicator writeSymbolCachesToDirectory: directory error: &error]) {
+        NSError *cause = [[error userInfo] objectForKey: NSUnderlyingErrorKey];
+        if (cause != nil)
+            fprintf(stderr, "%s: %s\n", [[error localizedDescription] UTF8String], [[cause localizedDescription] UTF8String]);
+        else
+            fprintf(stderr, "%s\n", [[error localizedDescription] UTF8String]);
+        return 1;
+    }
+
+    printf("Indexed %lu images\n", (unsigned long) symbolicator.imageCount);
+    return 0;
+}
+
+/*
+ * Format a bucket timestamp as an ISO 8601 UTC date, or "-" if unavailable.
+ */
+static void bucket_format_date (NSDate *date, char *buffer, size_t size) {
+    time_t seconds;
+    struct tm tm;
+
+    if (date == nil) {
+        strlcpy(buffer, "-", size);
+        return;
+    }
+
+    seconds = (time_t) [date timeIntervalSince1970];
+    gmtime_r(&seconds, &tm);
+    strftime(buffer, size, "%Y-%m-%dT%H:%M:%SZ", &tm);
+}
+
+/*
+ * Bucket crash reports by fingerprint.
+ */
+int bucket_command (int argc, char *argv[]) {
+    NSUInteger frameCount = 0;
+    NSUInteger threadCount = 0;
+    NSError *error;
+
+    /* options descriptor */
+    static struct option longopts[] = {
+        { "frames",     required_argument,      NULL,          'f' },
+        { "threads",    required_argument,      NULL,          't' },
+        { NULL,         0,                      NULL,           0 }
+    };
+
+    /* Read the options */
+    int ch;
+    while ((ch = getopt_long(argc, argv, "f:t:", longopts, NULL)) != -1) {
+        switch (ch) {
+            case 'f':
+                frameCount = strtoul(optarg, NULL, 10);
+                break;
+            case 't':
+                threadCount = strtoul(optarg, NULL, 10);
+                break;
+            default:
+                print_usage();
+                return 1;
+        }
+    }
+    argc -= optind;
+    argv += optind;
+
+    if (argc < 1) {
+        fprintf(stderr, "No input file supplied\n");
+        print_usage();
+        return 1;
+    }
+
+    NSArray *paths = gather_input_paths(argc, argv);
+
+    PLCrashReportBucketer *bucketer = [[[PLCrashReportBucketer alloc] initWithFrameCount: frameCount] autorelease];
+    if (![bucketer addReportsAtPaths: paths threadCount: threadCount error: &error]) {
+        fprintf(stderr, "%s\n", [[error localizedDescription] UTF8String]);
+        return 1;
+    }
+
+    NSArray *buckets = bucketer.buckets;
+    printf("count\tfingerprint\tfirst_seen\tlast_seen\tsignal\texception\tframes\tsamples\n");
+    for (PLCrashReportBucket *bucket in buckets) {
+        char firstSeen[32];
+        char lastSeen[32];
+
+        bucket_format_date(bucket.firstSeen, firstSeen, sizeof(firstSeen));
+        bucket_format_date(bucket.lastSeen, lastSeen, sizeof(lastSeen));
+
+        printf("%llu\t%016llx\t%s\t%s\t%s\t%s\t%s\t%s\n", (unsigned long long) bucket.reportCount,
+               (unsigned long long) bucket.fingerprint, firstSeen, lastSeen, [bucket.signalName UTF8String],
+               bucket.exceptionName != nil ? [bucket.exceptionName UTF8String] : "-", [bucket.frames UTF8String],
+               [[bucket.sampleIdentifiers componentsJoinedByString: @","] UTF8String]);
+    }
+
+    fprintf(stderr, "Bucketed %llu reports into %lu buckets", (unsigned long long) bucketer.reportCount,
+            (unsigned long) [buckets count]);
+    if (bucketer.failedCount > 0)
+        fprintf(stderr, "; %llu files could not be read", (unsigned long long) bucketer.failedCount);
+    fprintf(stderr, "\n");
+
+    return 0;
+}
+
+/*
+ * Export crash reports for analytics.
+ */
+int export_command (int argc, char *argv[]) {
+    const char *output = NULL;
+    BOOL columnar = NO;
+    NSUInteger threadCount = 0;
+    NSError *error;
+
+    /* options descriptor */
+    static struct option longopts[] = {
+        { "columnar",   no_argument,            NULL,          'c' },
+        { "output",     required_argument,      NULL,          'o' },
+        { "threads",    required_argument,      NULL,          't' },
+        { NULL,         0,                      NULL,           0 }
+    };
+
+    /* Read the options */
+    int ch;
+    while ((ch = getopt_long(argc, argv, "co:t:", longopts, NULL)) != -1) {
+        switch (ch) {
+            case 'c':
+                columnar = YES;
+                break;
+            case 'o':
+                output = optarg;
+                break;
+            case 't':
+                threadCount = strtoul(optarg, NULL, 10);
+                break;
+            default:
+                print_usage();
+                return 1;
+        }
+    }
+    argc -= optind;
+    argv += optind;
+
+    /* Columnar output is currently the only export format */
+    if (!columnar) {
+        fprintf(stderr, "An export format must be specified\n");
+        print_usage();
+        return 1;
+    }
+
+    if (output == NULL) {
+        fprintf(stderr, "No output directory specified\n");
+        print_usage();
+        return 1;
+    }
+
+    if (argc < 1) {
+        fprintf(stderr, "No input file supplied\n");
+        print_usage();
+        return 1;
+    }
+
+    NSArray *paths = gather_input_paths(argc, argv);
+
+    NSString *directory = [NSString stringWithUTF8String: output];
+    if (![[NSFileManager defaultManager] createDirectoryAtPath: directory withIntermediateDirectories: YES attributes: nil error: &error]) {
+        fprintf(stderr, "Could not create output directory %s: %s\n", output, [[error localizedDescription] UTF8String]);
+        return 1;
+    }
+
+    PLCrashReportColumnarExporter *exporter = [[[PLCrashReportColumnarExporter alloc] init] autorelease];
+    if (![exporter exportReportsAtPaths: paths toDirectory: directory threadCount: threadCount error: &error]) {
+        NSError *cause = [[error userInfo] objectForKey: NSUnderlyingErrorKey];
+        if (cause != nil)
+            fprintf(stderr, "%s: %s\n", [[error localizedDescription] UTF8String], [[cause localizedDescription] UTF8String]);
+        else
+            fprintf(stderr, "%s\n", [[error localizedDescription] UTF8String]);
+        return 1;
+    }
+
+    fprintf(stderr, "Exported %llu reports (%llu threads, %llu frames, %llu images)",
+            (unsigned long long) exporter.reportCount, (unsigned long long) exporter.threadRowCount,
+            (unsigned long long) exporter.frameRowCount, (unsigned long long) exporter.imageRowCount);
+    if (exporter.failedCount > 0)
+        fprintf(stderr, "; %llu files could not be read", (unsigned long long) exporter.failedCount);
+    fprintf(stderr, "\n");
+
+    return 0;
+}
+
+/*
+ * Print a summary line for the given list of nanosecond NSNumber values.
+ */
+static void print_time_summary (const char *label, NSArray *values) {
+    if ([values count] == 0) {
+        printf("  %-20s n/a\n", label);
+        return;
+    }
+
+    NSArray *sorted = [values sortedArrayUsingSelector: @selector(compare:)];
+    NSUInteger count = [sorted count];
+    uint64_t total = 0;
+
+    for (NSNumber *value in sorted)
+        total += [value unsignedLongLongValue];
+
+    /* Nearest-rank percentiles */
+    uint64_t p50 = [[sorted objectAtIndex: (count - 1) / 2] unsignedLongLongValue];
+    uint64_t p95 = [[sorted objectAtIndex: ((count * 95) + 99) / 100 - 1] unsignedLongLongValue];
+    uint64_t max = [[sorted lastObject] unsignedLongLongValue];
+
+    printf("  %-20s mean %10.3f ms  p50 %10.3f ms  p95 %10.3f ms  max %10.3f ms\n", label,
+           (double) total / count / NSEC_PER_MSEC, (double) p50 / NSEC_PER_MSEC,
+           (double) p95 / NSEC_PER_MSEC, (double) max / NSEC_PER_MSEC);
+}
+
+/*
+ * Summarize writer statistics across a directory of crash reports.
+ */
+int stats_command (int argc, char *argv[]) {
+    NSFileManager *fileManager = [NSFileManager defaultManager];
+    NSError *error;
+
+    /* Ensure there's an input directory specified */
+    if (argc < 1) {
+        fprintf(stderr, "No input directory supplied\n");
+        print_usage();
+        return 1;
+    }
+
+    NSString *directory = [NSString stringWithUTF8String: argv[0]];
+    NSArray *files = [fileManager contentsOfDirectoryAtPath: directory error: &error];
+    if (files == nil) {
+        fprintf(stderr, "Could not read input directory: %s\n", [[error localizedDescription] UTF8String]);
+        return 1;
+    }
+
+    /* Aggregates */
+    NSUInteger reportCount = 0;
+    NSUInteger statsCount = 0;
+    NSMutableArray *totalTimes = [NSMutableArray array];
+    NSMutableArray *imageTimes = [NSMutableArray array];
+    NSMutableArray *suspendTimes = [NSMutableArray array];
+    NSMutableArray *walkTimes = [NSMutableArray array];
+    NSMutableArray *writeTimes = [NSMutableArray array];
+    NSMutableDictionary *sectionBytes = [NSMutableDictionary dictionary];
+    uint64_t readFailures = 0;
+    uint64_t truncatedThreads = 0;
+
+    for (NSString *file in files) {
+        NSString *path = [directory stringByAppendingPathComponent: file];
+        NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+
+        /* Try reading and decoding the file; anything that isn't a crash log is skipped */
+        NSData *data = [NSData dataWithContentsOfFile: path options: NSMappedRead error: NULL];
+        PLCrashReport *crashLog = nil;
+        if (data != nil)
+            crashLog = [[[PLCrashReport alloc] initWithData: data error: NULL] autorelease];
+
+        if (crashLog == nil) {
+            [pool release];
+            continue;
+        }
+
+        reportCount++;
+        if (!crashLog.hasWriterStats) {
+            [pool release];
+            continue;
+        }
+
+        PLCrashReportWriterStats *stats = crashLog.writerStats;
+        statsCount++;
+
+        [totalTimes addObject: [NSNumber numberWithUnsignedLongLong: stats.totalTime]];
+        [imageTimes addObject: [NSNumber numberWithUnsignedLongLong: stats.imageTime]];
+        readFailures += stats.readFailures;
+        truncatedThreads += stats.truncatedThreads;
+
+        for (PLCrashReportWriterThreadStats *thread in stats.threadStats) {
+            [suspendTimes addObject: [NSNumber numberWithUnsignedLongLong: thread.suspendTime]];
+            [walkTimes addObject: [NSNumber numberWithUnsignedLongLong: thread.walkTime]];
+            [writeTimes addObject: [NSNumber numberWithUnsignedLongLong: thread.writeTime]];
+        }
+
+        for (NSString *section in stats.sectionBytes) {
+            uint64_t bytes = [[sectionBytes objectForKey: section] unsignedLongLongValue];
+            bytes += [[stats.sectionBytes objectForKey: section] unsignedLongLongValue];
+            [sectionBytes setObject: [NSNumber numberWithUnsignedLongLong: bytes] forKey: section];
+        }
+
+        [pool release];
+    }
+
+    /* Print the summary */
+    printf("Reports: %lu (%lu with writer statistics)\n", (unsigned long) reportCount, (unsigned long) statsCount);
+    if (statsCount == 0)
+        return 0;
+
+    printf("\nReport:\n");
+    print_time_summary("total", totalTimes);
+    print_time_summary("binary images", imageTimes);
+
+    printf("\nPer thread:\n");
+    print_time_summary("suspend", suspendTimes);
+    print_time_summary("walk", walkTimes);
+    print_time_summary("write", writeTimes);
+
+    printf("\nRead failures: %llu (%.2f per report)\n", readFailures, (double) readFailures / statsCount);
+    printf("Truncated backtraces: %llu (%.2f per report)\n", truncatedThreads, (double) truncatedThreads / statsCount);
+
+    printf("\nMean bytes per section:\n");
+    for (NSString *section in [[sectionBytes allKeys] sortedArrayUsingSelector: @selector(compare:)]) {
+        printf("  %-20s %10.1f\n", [section UTF8String], [[sectionBytes objectForKey: section] doubleValue] / statsCount);
+    }
+
     return 0;
 }
 
@@ -127,7 +753,18 @@ int main (int argc, char *argv[]) {
 
     /* Convert command */
     if (strcmp(argv[1], "convert") == 0) {
-        ret = convert_command(argc - 2, argv + 2);
+        /* Pass the command name as argv[0], as expected by getopt_long() */
+        ret = convert_command(argc - 1, argv + 1, NO);
+    } else if (strcmp(argv[1], "symbolicate") == 0) {
+        ret = convert_command(argc - 1, argv + 1, YES);
+    } else if (strcmp(argv[1], "symcache") == 0) {
+        ret = symcache_command(argc - 1, argv + 1);
+    } else if (strcmp(argv[1], "bucket") == 0) {
+        ret = bucket_command(argc - 1, argv + 1);
+    } else if (strcmp(argv[1], "export") == 0) {
+        ret = export_command(argc - 1, argv + 1);
+    } else if (strcmp(argv[1], "stats") == 0) {
+        ret = stats_command(argc - 2, argv + 2);
     } else {
         print_usage();
         ret = 1;
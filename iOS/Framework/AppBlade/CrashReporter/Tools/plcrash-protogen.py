@@ -0,0 +1,924 @@
+#!/usr/bin/env python
+#
+# Author: Landon Fuller <landonf@plausiblelabs.com>
+#
+# Copyright (c) 2008-2011 Plausible Labs Cooperative, Inc.
+# All rights reserved.
+#
+# Permission is hereby granted, free of charge, to any person
+# obtaining a copy of this software and associated documentation
+# files (the "Software"), to deal in the Software without
+# restriction, including without limitation the rights to use,
+# copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the
+# Software is furnished to do so, subject to the following
+# conditions:
+#
+# The above copyright notice and this permission notice shall be
+# included in all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+# OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+# NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+# HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+# WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+# FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+# OTHER DEALINGS IN THE SOFTWARE.
+#
+
+"""
+Generates schema-specialized crash report encoders and decoders from crash_report.proto.
+
+Two outputs are written to the output directory:
+
+  PLCrashReportEncoder.h      Field identifiers and typed, async-safe field encoders for PLCrashLogWriter.
+                              Each encoder is a thin inline wrapper around plcrash_writer_pack(), with the
+                              field id and wire type fixed by the schema.
+
+  PLCrashReportDecoder.h/.c   Straight-line decoders that switch directly on the wire tag, populating the
+                              protoc-c generated message structures. Decoded messages are released with
+                              protobuf_c_message_free_unpacked(), exactly as if they had been decoded by
+                              protobuf_c_message_unpack().
+
+Only the subset of the protobuf language used by crash_report.proto is supported: a package declaration,
+options, enums, and (nested) messages containing required, optional and repeated fields of scalar, enum,
+string, bytes and message types.
+
+Usage:
+    plcrash-protogen.py <crash_report.proto> <output directory>
+    plcrash-protogen.py --check <crash_report.proto> <output directory>
+
+With --check, nothing is written; the exit status is non-zero if any output is out of date.
+"""
+
+import os
+import re
+import sys
+
+# Scalar types: proto name -> (PLProtobufCType suffix, encoder C value type, wire type, decoder kind)
+SCALAR_TYPES = {
+    'int32':    ('INT32',    'int32_t',  0, 'int32'),
+    'sint32':   ('SINT32',   'int32_t',  0, 'sint32'),
+    'sfixed32': ('SFIXED32', 'int32_t',  5, 'fixed32'),
+    'int64':    ('INT64',    'int64_t',  0, 'int64'),
+    'sint64':   ('SINT64',   'int64_t',  0, 'sint64'),
+    'sfixed64': ('SFIXED64', 'int64_t',  1, 'fixed64'),
+    'uint32':   ('UINT32',   'uint32_t', 0, 'uint32'),
+    'fixed32':  ('FIXED32',  'uint32_t', 5, 'fixed32'),
+    'uint64':   ('UINT64',   'uint64_t', 0, 'uint64'),
+    'fixed64':  ('FIXED64',  'uint64_t', 1, 'fixed64'),
+    'float':    ('FLOAT',    'float',    5, 'fixed32'),
+    'double':   ('DOUBLE',   'double',   1, 'fixed64'),
+    'bool':     ('BOOL',     'bool',     0, 'bool'),
+    'string':   ('STRING',   'char',     2, 'string'),
+    'bytes':    ('BYTES',    'PLProtobufCBinaryData', 2, 'bytes'),
+}
+
+WIRE_VARINT = 0
+WIRE_LENGTH_PREFIXED = 2
+
+LICENSE = """/*
+ * Generated by Tools/plcrash-protogen.py from %s. DO NOT EDIT.
+ *
+ * Copyright (c) 2008-2011 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+"""
+
+
+class ProtoError(Exception):
+    pass
+
+
+# --- Schema model ---
+
+class Enum(object):
+    def __init__(self, name, parent):
+        self.name = name
+        self.parent = parent
+        self.values = []  # (name, number)
+
+    def value(self, name):
+        for vname, number in self.values:
+            if vname == name:
+                return number
+        raise ProtoError("enum %s has no value %s" % (self.name, name))
+
+
+class Field(object):
+    def __init__(self, label, type_name, name, number, default):
+        self.label = label
+        self.type_name = type_name
+        self.name = name
+        self.number = number
+        self.default = default
+        self.scalar = SCALAR_TYPES.get(type_name)
+        self.enum = None
+        self.message = None
+
+    @property
+    def wire_type(self):
+        if self.scalar is not None:
+            return self.scalar[2]
+        if self.enum is not None:
+            return WIRE_VARINT
+        return WIRE_LENGTH_PREFIXED
+
+    @property
+    def pl_type(self):
+        if self.scalar is not None:
+            return 'PLPROTOBUF_C_TYPE_' + self.scalar[0]
+        if self.enum is not None:
+            return 'PLPROTOBUF_C_TYPE_ENUM'
+        return 'PLPROTOBUF_C_TYPE_MESSAGE'
+
+    @property
+    def kind(self):
+        if self.scalar is not None:
+            return self.scalar[3]
+        if self.enum is not None:
+            return 'enum'
+        return 'message'
+
+    @property
+    def is_pointer(self):
+        """True if the protoc-c member is a pointer, and so has no has_ flag when optional."""
+        return self.kind in ('string', 'message')
+
+
+class Message(object):
+    def __init__(self, name, parent):
+        self.name = name
+        self.parent = parent
+        self.fields = []
+        self.messages = []
+        self.enums = []
+
+    @property
+    def path(self):
+        if self.parent is None:
+            return [self.name]
+        return self.parent.path + [self.name]
+
+
+class Schema(object):
+    def __init__(self):
+        self.package = None
+        self.messages = []
+        self.enums = []
+
+
+# --- Parsing ---
+
+TOKEN_RE = re.compile(r'\s*(?:([A-Za-z_][A-Za-z0-9_.]*)|(-?[0-9]+)|("(?:[^"\\]|\\.)*")|(\S))')
+
+
+def strip_comments(text):
+    text = re.sub(r'/\*.*?\*/', lambda m: ' ' + '\n' * m.group(0).count('\n'), text, flags=re.S)
+    text = re.sub(r'//[^\n]*', '', text)
+    return text
+
+
+def tokenize(text):
+    tokens = []
+    pos = 0
+    text = strip_comments(text)
+    while True:
+        m = TOKEN_RE.match(text, pos)
+        if m is None or m.end() == pos:
+            break
+        pos = m.end()
+        tokens.append(m.group(m.lastindex))
+    if text[pos:].strip():
+        raise ProtoError("unexpected input near '%s'" % text[pos:pos + 20])
+    return tokens
+
+
+class Parser(object):
+    def __init__(self, tokens):
+        self.tokens = tokens
+        self.pos = 0
+
+    def peek(self):
+        if self.pos < len(self.tokens):
+            return self.tokens[self.pos]
+        return None
+
+    def next(self):
+        tok = self.peek()
+        if tok is None:
+            raise ProtoError("unexpected end of input")
+        self.pos += 1
+        return tok
+
+    def expect(self, value):
+        tok = self.next()
+        if tok != value:
+            raise ProtoError("expected '%s', found '%s'" % (value, tok))
+
+    def parse(self):
+        schema = Schema()
+        while self.peek() is not None:
+            tok = self.next()
+            if tok == 'package':
+                schema.package = self.next()
+                self.expect(';')
+            elif tok == 'option':
+                self.skip_statement()
+            elif tok == 'enum':
+                schema.enums.append(self.parse_enum(None))
+            elif tok == 'message':
+                schema.messages.append(self.parse_message(None))
+            else:
+                raise ProtoError("unsupported top-level statement '%s'" % tok)
+        return schema
+
+    def skip_statement(self):
+        while self.next() != ';':
+            pass
+
+    def parse_enum(self, parent):
+        enum = Enum(self.next(), parent)
+        self.expect('{')
+        while self.peek() != '}':
+            name = self.next()
+            self.expect('=')
+            enum.values.append((name, int(self.next())))
+            self.expect(';')
+        self.expect('}')
+        return enum
+
+    def parse_message(self, parent):
+        message = Message(self.next(), parent)
+        self.expect('{')
+        while self.peek() != '}':
+            tok = self.next()
+            if tok == 'message':
+                message.messages.append(self.parse_message(message))
+            elif tok == 'enum':
+                message.enums.append(self.parse_enum(message))
+            elif tok in ('required', 'optional', 'repeated'):
+                message.fields.append(self.parse_field(tok))
+            elif tok == 'option':
+                self.skip_statement()
+            else:
+                raise ProtoError("unsupported statement '%s' in message %s" % (tok, message.name))
+        self.expect('}')
+        return message
+
+    def parse_field(self, label):
+        type_name = self.next()
+        name = self.next()
+        self.expect('=')
+        number = int(self.next())
+        default = None
+        if self.peek() == '[':
+            self.next()
+            while True:
+                option = self.next()
+                self.expect('=')
+                value = self.next()
+                if option == 'default':
+                    default = value
+                tok = self.next()
+                if tok == ']':
+                    break
+                if tok != ',':
+                    raise ProtoError("expected ',' or ']' in options for field %s" % name)
+        self.expect(';')
+        return Field(label, type_name, name, number, default)
+
+
+def resolve(schema):
+    """Resolve field type names to enums and messages, searching from the innermost scope outwards."""
+
+    def lookup(scope, parts):
+        candidates = scope.messages + scope.enums
+        for candidate in candidates:
+            if candidate.name == parts[0]:
+                if len(parts) == 1:
+                    return candidate
+                if isinstance(candidate, Message):
+                    return lookup(candidate, parts[1:])
+        return None
+
+    def visit(message):
+        for field in message.fields:
+            if field.scalar is not None:
+                continue
+            parts = field.type_name.split('.')
+            scope = message
+            target = None
+            while scope is not None and target is None:
+                target = lookup(scope, parts)
+                scope = scope.parent
+            if target is None:
+                target = lookup(schema, parts)
+            if target is None:
+                raise ProtoError("unknown type '%s' for field %s.%s" % (field.type_name, message.name, field.name))
+            if isinstance(target, Enum):
+                field.enum = target
+            else:
+                field.message = target
+            if field.default is not None and field.kind == 'string':
+                raise ProtoError("string defaults are not supported (field %s.%s)" % (message.name, field.name))
+        seen = set()
+        for field in message.fields:
+            if field.number in seen:
+                raise ProtoError("duplicate field number %d in message %s" % (field.number, message.name))
+            seen.add(field.number)
+        for child in message.messages:
+            visit(child)
+
+    for message in schema.messages:
+        visit(message)
+
+
+# --- Naming ---
+
+def snake(name):
+    """CamelCase to lower_snake, matching protoc-c."""
+    out = ''
+    for i, c in enumerate(name):
+        if c.isupper():
+            if i > 0 and not name[i - 1].isupper() and name[i - 1] != '_':
+                out += '_'
+            out += c.lower()
+        else:
+            out += c
+    return out
+
+
+def c_type(schema, message):
+    """protoc-c structure name, eg Plcrash__CrashReport__Thread."""
+    return '__'.join([schema.package.capitalize()] + message.path)
+
+
+def c_descriptor(schema, message):
+    """protoc-c descriptor name, eg plcrash__crash_report__thread__descriptor."""
+    return '__'.join([schema.package.lower()] + [snake(p) for p in message.path]) + '__descriptor'
+
+
+def local_name(message):
+    """Short name used for generated identifiers. The root message keeps its name; nested messages drop it."""
+    path = message.path
+    if len(path) > 1:
+        path = path[1:]
+    return '_'.join(snake(p) for p in path)
+
+
+def all_messages(schema):
+    result = []
+
+    def visit(message):
+        result.append(message)
+        for child in message.messages:
+            visit(child)
+
+    for message in schema.messages:
+        visit(message)
+    return result
+
+
+def field_id_name(message, field):
+    return 'PLCRASH_PROTO_%s_%s_ID' % (local_name(message).upper(), field.name.upper())
+
+
+def encoder_name(message, field):
+    return 'plcrash_proto_%s_%s_pack' % (local_name(message), field.name)
+
+
+def decoder_name(message):
+    return 'plcrash_proto_%s_decode' % local_name(message)
+
+
+def field_path(message, field):
+    return '.'.join(message.path + [field.name])
+
+
+# --- Encoder output ---
+
+def generate_encoder(schema, source_name):
+    out = [LICENSE % source_name]
+    out.append('#ifndef PLCRASH_REPORT_ENCODER_H')
+    out.append('#define PLCRASH_REPORT_ENCODER_H')
+    out.append('')
+    out.append('#include "PLCrashLogWriterEncoding.h"')
+    out.append('')
+    out.append('/**')
+    out.append(' * @internal')
+    out.append(' * @defgroup plcrash_log_writer_proto Crash Report Field Encoders')
+    out.append(' * @ingroup plcrash_log_writer')
+    out.append(' *')
+    out.append(' * Field identifiers and typed field encoders for %s.' % source_name)
+    out.append(' *')
+    out.append(' * Each encoder writes a single field via plcrash_writer_pack(), and returns the number of bytes written. If')
+    out.append(' * @a file is NULL, nothing is written, and the encoded size of the field is returned. Message fields write')
+    out.append(' * only the field header; @a size must be the encoded size of the sub-message that follows.')
+    out.append(' *')
+    out.append(' * All encoders are async-safe.')
+    out.append(' * @{')
+    out.append(' */')
+    out.append('')
+
+    for message in all_messages(schema):
+        out.append('/* %s */' % '.'.join(message.path))
+        out.append('enum {')
+        for field in message.fields:
+            out.append('    /** %s */' % field_path(message, field))
+            out.append('    %s = %d,' % (field_id_name(message, field), field.number))
+            out.append('')
+        if message.fields:
+            out.pop()
+        out.append('};')
+        out.append('')
+
+        for field in message.fields:
+            if field.kind == 'message':
+                param = 'const uint32_t *size'
+                value = 'size'
+            elif field.kind == 'enum':
+                param = 'const uint32_t *value'
+                value = 'value'
+            elif field.kind == 'string':
+                param = 'const char *value'
+                value = 'value'
+            else:
+                param = 'const %s *value' % field.scalar[1]
+                value = 'value'
+            out.append('/** Encode %s (%s %s). */' % (field_path(message, field), field.label, field.type_name))
+            out.append('static inline size_t %s (plcrash_async_file_t *file, %s) {' % (encoder_name(message, field), param))
+            out.append('    return plcrash_writer_pack(file, %s, %s, %s);' % (field_id_name(message, field), field.pl_type, value))
+            out.append('}')
+            out.append('')
+
+    out.append('/**')
+    out.append(' * @} plcrash_log_writer_proto')
+    out.append(' */')
+    out.append('')
+    out.append('#endif /* PLCRASH_REPORT_ENCODER_H */')
+    return '\n'.join(out) + '\n'
+
+
+# --- Decoder output ---
+
+DECODER_RUNTIME = r'''
+/*
+ * Decoding support. All readers advance *pos past the consumed bytes, and return false if the input is truncated
+ * or malformed.
+ */
+
+static inline bool plcrash_proto_read_varint (const uint8_t **pos, const uint8_t *end, uint64_t *value) {
+    return plcrash_varint_decode(pos, end, value);
+}
+
+static inline bool plcrash_proto_read_fixed32 (const uint8_t **pos, const uint8_t *end, uint32_t *value) {
+    const uint8_t *p = *pos;
+    if (end - p < 4)
+        return false;
+
+    *value = ((uint32_t) p[0]) | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+    *pos = p + 4;
+    return true;
+}
+
+static inline bool plcrash_proto_read_fixed64 (const uint8_t **pos, const uint8_t *end, uint64_t *value) {
+    uint32_t lo, hi;
+    if (!plcrash_proto_read_fixed32(pos, end, &lo) || !plcrash_proto_read_fixed32(pos, end, &hi))
+        return false;
+
+    *value = ((uint64_t) hi << 32) | lo;
+    return true;
+}
+
+/* Read a length prefix, verifying that the prefixed data is available */
+static inline bool plcrash_proto_read_length (const uint8_t **pos, const uint8_t *end, size_t *length) {
+    uint64_t value;
+    if (!plcrash_proto_read_varint(pos, end, &value))
+        return false;
+
+    if (value > (uint64_t) (end - *pos))
+        return false;
+
+    *length = (size_t) value;
+    return true;
+}
+
+/* Skip a field of the given wire type. Groups are not supported. */
+static bool plcrash_proto_skip (const uint8_t **pos, const uint8_t *end, unsigned wire_type) {
+    uint64_t ignored;
+    size_t length;
+
+    switch (wire_type) {
+        case 0:
+            return plcrash_proto_read_varint(pos, end, &ignored);
+        case 1:
+            if (end - *pos < 8)
+                return false;
+            *pos += 8;
+            return true;
+        case 2:
+            if (!plcrash_proto_read_length(pos, end, &length))
+                return false;
+            *pos += length;
+            return true;
+        case 5:
+            if (end - *pos < 4)
+                return false;
+            *pos += 4;
+            return true;
+        default:
+            return false;
+    }
+}
+
+/* Read a length-prefixed string into a newly allocated, NUL-terminated buffer */
+static bool plcrash_proto_read_string (const uint8_t **pos, const uint8_t *end, ProtobufCAllocator *allocator, char **value) {
+    size_t length;
+    char *str;
+
+    if (!plcrash_proto_read_length(pos, end, &length))
+        return false;
+
+    str = allocator->alloc(allocator->allocator_data, length + 1);
+    if (str == NULL)
+        return false;
+
+    memcpy(str, *pos, length);
+    str[length] = '\0';
+    *pos += length;
+
+    *value = str;
+    return true;
+}
+
+/* Read length-prefixed bytes into a newly allocated buffer */
+static bool plcrash_proto_read_bytes (const uint8_t **pos, const uint8_t *end, ProtobufCAllocator *allocator, ProtobufCBinaryData *value) {
+    size_t length;
+    uint8_t *data = NULL;
+
+    if (!plcrash_proto_read_length(pos, end, &length))
+        return false;
+
+    if (length > 0) {
+        data = allocator->alloc(allocator->allocator_data, length);
+        if (data == NULL)
+            return false;
+        memcpy(data, *pos, length);
+        *pos += length;
+    }
+
+    value->len = length;
+    value->data = data;
+    return true;
+}
+
+/* Ensure that a repeated field's array has room for one more element, doubling its capacity as required */
+static bool plcrash_proto_reserve (ProtobufCAllocator *allocator, void **array, size_t count, size_t *capacity, size_t element_size) {
+    void *new_array;
+    size_t new_capacity;
+
+    if (count < *capacity)
+        return true;
+
+    new_capacity = (*capacity == 0) ? 4 : *capacity * 2;
+    new_array = allocator->alloc(allocator->allocator_data, new_capacity * element_size);
+    if (new_array == NULL)
+        return false;
+
+    if (*array != NULL) {
+        memcpy(new_array, *array, count * element_size);
+        allocator->free(allocator->allocator_data, *array);
+    }
+
+    *array = new_array;
+    *capacity = new_capacity;
+    return true;
+}
+
+static inline int32_t plcrash_proto_unzigzag32 (uint32_t v) {
+    return (v & 1) ? -(int32_t) (v >> 1) - 1 : (int32_t) (v >> 1);
+}
+
+static inline int64_t plcrash_proto_unzigzag64 (uint64_t v) {
+    return (v & 1) ? -(int64_t) (v >> 1) - 1 : (int64_t) (v >> 1);
+}
+'''
+
+
+def decode_value_lines(field, target, replace=False):
+    """
+    Return C statements decoding one value of a non-message field into the lvalue 'target'. If replace is true,
+    any previously decoded string or bytes value is released first.
+    """
+    kind = field.kind
+    if kind in ('int32', 'uint32', 'enum', 'int64', 'uint64', 'bool', 'sint32', 'sint64'):
+        conv = {
+            'int32': '(int32_t) v',
+            'uint32': '(uint32_t) v',
+            'enum': '(int) v',
+            'int64': '(int64_t) v',
+            'uint64': 'v',
+            'bool': 'v != 0',
+            'sint32': 'plcrash_proto_unzigzag32((uint32_t) v)',
+            'sint64': 'plcrash_proto_unzigzag64(v)',
+        }[kind]
+        return ['uint64_t v;',
+                'if (!plcrash_proto_read_varint(&pos, end, &v))',
+                '    goto error;',
+                '%s = %s;' % (target, conv)]
+    if kind == 'fixed32':
+        if field.type_name == 'float':
+            store = 'memcpy(&%s, &v, sizeof(v));' % target
+        else:
+            store = '%s = v;' % target
+        return ['uint32_t v;',
+                'if (!plcrash_proto_read_fixed32(&pos, end, &v))',
+                '    goto error;',
+                store]
+    if kind == 'fixed64':
+        if field.type_name == 'double':
+            store = 'memcpy(&%s, &v, sizeof(v));' % target
+        else:
+            store = '%s = v;' % target
+        return ['uint64_t v;',
+                'if (!plcrash_proto_read_fixed64(&pos, end, &v))',
+                '    goto error;',
+                store]
+    if kind == 'string':
+        lines = ['char *v;',
+                 'if (!plcrash_proto_read_string(&pos, end, allocator, &v))',
+                 '    goto error;']
+        if replace:
+            lines += ['if (%s != NULL)' % target,
+                      '    allocator->free(allocator->allocator_data, %s);' % target]
+        return lines + ['%s = v;' % target]
+    if kind == 'bytes':
+        lines = ['ProtobufCBinaryData v;',
+                 'if (!plcrash_proto_read_bytes(&pos, end, allocator, &v))',
+                 '    goto error;']
+        if replace:
+            lines += ['if (%s.data != NULL)' % target,
+                      '    allocator->free(allocator->allocator_data, %s.data);' % target]
+        return lines + ['%s = v;' % target]
+    raise ProtoError("unsupported field kind %s" % kind)
+
+
+def default_literal(field):
+    if field.default is None:
+        return None
+    if field.enum is not None:
+        return str(field.enum.value(field.default))
+    if field.kind == 'bool':
+        return '1' if field.default == 'true' else '0'
+    return field.default
+
+
+def generate_decoder_function(schema, message):
+    ctype = c_type(schema, message)
+    out = []
+    out.append('/* Decode %s */' % '.'.join(message.path))
+    out.append('static %s *%s (ProtobufCAllocator *allocator, const uint8_t *pos, size_t length) {' % (ctype, decoder_name(message)))
+    out.append('    const uint8_t *end = pos + length;')
+    out.append('    %s *msg;' % ctype)
+
+    repeated = [f for f in message.fields if f.label == 'repeated']
+    for field in repeated:
+        out.append('    size_t %s_capacity = 0;' % field.name)
+    out.append('')
+
+    out.append('    msg = allocator->alloc(allocator->allocator_data, sizeof(*msg));')
+    out.append('    if (msg == NULL)')
+    out.append('        return NULL;')
+    out.append('    memset(msg, 0, sizeof(*msg));')
+    out.append('    msg->base.descriptor = &%s;' % c_descriptor(schema, message))
+    for field in message.fields:
+        literal = default_literal(field)
+        if literal is not None:
+            out.append('    msg->%s = %s;' % (field.name, literal))
+    out.append('')
+
+    out.append('    while (pos < end) {')
+    out.append('        uint64_t tag;')
+    out.append('        if (!plcrash_proto_read_varint(&pos, end, &tag))')
+    out.append('            goto error;')
+    out.append('')
+    out.append('        switch (tag) {')
+
+    for field in message.fields:
+        tag = (field.number << 3) | field.wire_type
+        body = []
+        if field.kind == 'message':
+            child = field.message
+            child_type = c_type(schema, child)
+            body.append('size_t sublen;')
+            body.append('%s *sub;' % child_type)
+            if field.label == 'repeated':
+                body.append('if (!plcrash_proto_reserve(allocator, (void **) &msg->%s, msg->n_%s, &%s_capacity, sizeof(*msg->%s)))'
+                            % (field.name, field.name, field.name, field.name))
+                body.append('    goto error;')
+            body.append('if (!plcrash_proto_read_length(&pos, end, &sublen))')
+            body.append('    goto error;')
+            body.append('sub = %s(allocator, pos, sublen);' % decoder_name(child))
+            body.append('if (sub == NULL)')
+            body.append('    goto error;')
+            body.append('pos += sublen;')
+            if field.label == 'repeated':
+                body.append('msg->%s[msg->n_%s++] = sub;' % (field.name, field.name))
+            else:
+                body.append('if (msg->%s != NULL)' % field.name)
+                body.append('    protobuf_c_message_free_unpacked(&msg->%s->base, allocator);' % field.name)
+                body.append('msg->%s = sub;' % field.name)
+        elif field.label == 'repeated':
+            body.append('if (!plcrash_proto_reserve(allocator, (void **) &msg->%s, msg->n_%s, &%s_capacity, sizeof(*msg->%s)))'
+                        % (field.name, field.name, field.name, field.name))
+            body.append('    goto error;')
+            body.extend(decode_value_lines(field, 'msg->%s[msg->n_%s]' % (field.name, field.name)))
+            body.append('msg->n_%s++;' % field.name)
+        else:
+            body.extend(decode_value_lines(field, 'msg->%s' % field.name, replace=True))
+            if field.label == 'optional' and not field.is_pointer:
+                body.append('msg->has_%s = 1;' % field.name)
+
+
+        out.append('            case (%d << 3) | %d: { /* %s */' % (field.number, field.wire_type, field.name))
+        out.extend('                ' + l for l in body)
+        out.append('                break;')
+        out.append('            }')
+        out.append('')
+
+    out.append('            default:')
+    if message.fields:
+        out.append('                /* Known fields with an unexpected wire type are rejected, as by protobuf_c_message_unpack() */')
+        out.append('                switch (tag >> 3) {')
+        for field in sorted(message.fields, key=lambda f: f.number):
+            out.append('                    case %d:' % field.number)
+        out.append('                        goto error;')
+        out.append('                }')
+        out.append('')
+    out.append('                if (!plcrash_proto_skip(&pos, end, (unsigned) (tag & 7)))')
+    out.append('                    goto error;')
+    out.append('                break;')
+    out.append('        }')
+    out.append('    }')
+    out.append('')
+
+    out.append('    return msg;')
+    out.append('')
+    out.append('error:')
+    out.append('    protobuf_c_message_free_unpacked(&msg->base, allocator);')
+    out.append('    return NULL;')
+    out.append('}')
+    out.append('')
+    return out
+
+
+def generate_decoder_header(schema, source_name, pbc_header):
+    out = [LICENSE % source_name]
+    out.append('#ifndef PLCRASH_REPORT_DECODER_H')
+    out.append('#define PLCRASH_REPORT_DECODER_H')
+    out.append('')
+    out.append('#include <stddef.h>')
+    out.append('#include <stdint.h>')
+    out.append('')
+    out.append('#include "%s"' % pbc_header)
+    out.append('')
+    out.append('#ifdef __cplusplus')
+    out.append('extern "C" {')
+    out.append('#endif')
+    out.append('')
+    for message in schema.messages:
+        out.append('/**')
+        out.append(' * @internal')
+        out.append(' *')
+        out.append(' * Decode an encoded %s message. This is a schema-specialized replacement for' % message.name)
+        out.append(' * protobuf_c_message_unpack(); unknown fields are skipped rather than preserved.')
+        out.append(' *')
+        out.append(' * @param allocator Allocator used for the returned message.')
+        out.append(' * @param length Length of @a data.')
+        out.append(' * @param data Encoded message.')
+        out.append(' *')
+        out.append(' * @return The decoded message, or NULL if the data is malformed. As with protobuf_c_message_unpack(),')
+        out.append(' * the presence of required fields is not verified. The message must be released with')
+        out.append(' * protobuf_c_message_free_unpacked().')
+        out.append(' */')
+        out.append('%s *plcrash_proto_%s_unpack (ProtobufCAllocator *allocator, size_t length, const uint8_t *data);'
+                   % (c_type(schema, message), snake(message.name)))
+        out.append('')
+    out.append('#ifdef __cplusplus')
+    out.append('}')
+    out.append('#endif')
+    out.append('')
+    out.append('#endif /* PLCRASH_REPORT_DECODER_H */')
+    return '\n'.join(out) + '\n'
+
+
+def generate_decoder_source(schema, source_name):
+    out = [LICENSE % source_name]
+    out.append('#include <stdbool.h>')
+    out.append('#include <string.h>')
+    out.append('')
+    out.append('#include "PLCrashReportDecoder.h"')
+    out.append('#include "PLCrashReportVarint.h"')
+    out.append(DECODER_RUNTIME)
+
+    messages = all_messages(schema)
+    for message in messages:
+        out.append('static %s *%s (ProtobufCAllocator *allocator, const uint8_t *pos, size_t length);'
+                   % (c_type(schema, message), decoder_name(message)))
+    out.append('')
+
+    for message in messages:
+        out.extend(generate_decoder_function(schema, message))
+
+    for message in schema.messages:
+        out.append('%s *plcrash_proto_%s_unpack (ProtobufCAllocator *allocator, size_t length, const uint8_t *data) {'
+                   % (c_type(schema, message), snake(message.name)))
+        out.append('    if (allocator == NULL)')
+        out.append('        allocator = &protobuf_c_default_allocator;')
+        out.append('')
+        out.append('    return %s(allocator, data, length);' % decoder_name(message))
+        out.append('}')
+        out.append('')
+
+    return '\n'.join(out)
+
+
+# --- Driver ---
+
+def main(argv):
+    check = False
+    args = argv[1:]
+    if args and args[0] == '--check':
+        check = True
+        args = args[1:]
+    if len(args) != 2:
+        sys.stderr.write(__doc__)
+        return 2
+
+    proto_path, output_dir = args
+    source_name = os.path.basename(proto_path)
+    with open(proto_path) as f:
+        text = f.read()
+
+    try:
+        schema = Parser(tokenize(text)).parse()
+        if schema.package is None:
+            raise ProtoError("missing package declaration")
+        resolve(schema)
+    except ProtoError as e:
+        sys.stderr.write("%s: %s\n" % (proto_path, e))
+        return 1
+
+    pbc_header = os.path.splitext(source_name)[0] + '.pb-c.h'
+    outputs = {
+        'PLCrashReportEncoder.h': generate_encoder(schema, source_name),
+        'PLCrashReportDecoder.h': generate_decoder_header(schema, source_name, pbc_header),
+        'PLCrashReportDecoder.c': generate_decoder_source(schema, source_name),
+    }
+
+    stale = []
+    for name in sorted(outputs):
+        path = os.path.join(output_dir, name)
+        existing = None
+        if os.path.exists(path):
+            with open(path) as f:
+                existing = f.read()
+        if existing == outputs[name]:
+            continue
+        stale.append(path)
+        if not check:
+            with open(path, 'w') as f:
+                f.write(outputs[name])
+
+    if check and stale:
+        for path in stale:
+            sys.stderr.write("%s is out of date; re-run %s\n" % (path, os.path.basename(argv[0])))
+        return 1
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))